@@ -43,6 +43,12 @@ android {
     buildFeatures {
         viewBinding = true
     }
+    packaging {
+        // 特权辅助进程需要以普通文件形式解压到 nativeLibraryDir 才能被 su 执行
+        jniLibs {
+            useLegacyPackaging = true
+        }
+    }
 }
 
 dependencies {
@@ -1,6 +1,8 @@
 #include "jni_bridge.h"
+#include "../common/trace_log.h"
 #include <android/log.h>
 #include <mutex>
+#include <pthread.h>
 #include <string>
 
 #define TAG "JniBridge" // 定义此模块在日志中的标识
@@ -12,6 +14,53 @@ jobject g_serviceInstance = nullptr;
 jmethodID g_onInputDataReceivedMethodID_Service = nullptr;
 std::mutex g_jniMutex; // 用于在 JNI 回调操作时保证线程安全
 
+// --------------- 每线程 JNIEnv 缓存 ---------------
+// 线程第一次需要 JNIEnv 时附加到 JVM 并缓存；pthread key 的析构函数在线程退出时分离
+static pthread_key_t g_jniEnvKey;
+static pthread_once_t g_jniEnvKeyOnce = PTHREAD_ONCE_INIT;
+static thread_local JNIEnv* t_jniEnv = nullptr;
+
+static void detachThreadAtExit(void* /* env */) {
+    if (g_jvm) {
+        g_jvm->DetachCurrentThread();
+    }
+}
+
+static void createJniEnvKey() {
+    pthread_key_create(&g_jniEnvKey, detachThreadAtExit);
+}
+
+JNIEnv* getThreadJniEnv(const char* threadName) {
+    if (t_jniEnv) {
+        return t_jniEnv;
+    }
+    if (!g_jvm) {
+        return nullptr;
+    }
+
+    JNIEnv* env = nullptr;
+    // Java 创建的线程本身已附加，由 JVM 管理其生命周期，只缓存不登记分离
+    if (g_jvm->GetEnv(reinterpret_cast<void**>(&env), JNI_VERSION_1_6) == JNI_OK && env) {
+        t_jniEnv = env;
+        return env;
+    }
+
+    JavaVMAttachArgs args;
+    args.version = JNI_VERSION_1_6;
+    args.name = threadName;
+    args.group = nullptr;
+    jint attachResult = g_jvm->AttachCurrentThread(&env, &args);
+    if (attachResult != JNI_OK || !env) {
+        __android_log_print(ANDROID_LOG_ERROR, TAG,
+            "getThreadJniEnv: AttachCurrentThread failed, error code: %d", attachResult);
+        return nullptr;
+    }
+    pthread_once(&g_jniEnvKeyOnce, createJniEnvKey);
+    pthread_setspecific(g_jniEnvKey, env); // 非空值才会触发析构
+    t_jniEnv = env;
+    return env;
+}
+
 // --------------- JNI_OnLoad ---------------
 // 当系统加载此动态库时，会调用 JNI_OnLoad 来获取当前 JNI 版本并保存全局的 JVM 引用
 extern "C" JNIEXPORT jint JNI_OnLoad(JavaVM* vm, void* reserved) {
@@ -23,6 +72,9 @@ extern "C" JNIEXPORT jint JNI_OnLoad(JavaVM* vm, void* reserved) {
     
     g_jvm = vm;
     __android_log_print(ANDROID_LOG_INFO, TAG, "JNI_OnLoad: JVM saved successfully");
+
+    // 热路径日志由后台线程排空，随库加载启动
+    traceLogStart();
     
     return JNI_VERSION_1_6;
 }
@@ -40,12 +92,9 @@ void sendDataToJavaService(const std::string& data) {
         return;
     }
 
-    JNIEnv* env = nullptr;
-    // 将当前线程附着到 JVM，获取 JNIEnv 以调用 Java 方法
-    jint attachResult = g_jvm->AttachCurrentThread(&env, nullptr);
-    if (attachResult != JNI_OK || !env) {
-        __android_log_print(ANDROID_LOG_ERROR, TAG,
-            "Failed to attach JNI thread in sendDataToJavaService. Error code: %d", attachResult);
+    // 使用按线程缓存的 JNIEnv，只有第一次调用会附着到 JVM
+    JNIEnv* env = getThreadJniEnv();
+    if (!env) {
         // 无法附着线程时直接返回
         return;
     }
@@ -55,8 +104,9 @@ void sendDataToJavaService(const std::string& data) {
     if (!javaString) {
         __android_log_print(ANDROID_LOG_ERROR, TAG,
             "Failed to create Java string for data.");
-        // 创建 jstring 失败后，需要分离线程并返回
-        g_jvm->DetachCurrentThread();
+        if (env->ExceptionCheck()) {
+            env->ExceptionClear();
+        }
         return;
     }
 
@@ -27,6 +27,17 @@ void nativeInitJNIService(JNIEnv* env, jobject serviceInstance);
  */
 void nativeReleaseJNIService(JNIEnv* env, jobject serviceInstance);
 
+/**
+ * @brief 获取当前线程的 JNIEnv，必要时附加到 JVM。
+ *
+ * 结果按线程缓存，之后的调用不再进入 JVM。由本函数附加的 native 线程会在线程退出时
+ * 自动分离（pthread key 析构），调用方无需也不应手动 DetachCurrentThread。
+ *
+ * @param threadName 附加时在 JVM 中显示的线程名，可为 nullptr。
+ * @return 失败时返回 nullptr。
+ */
+JNIEnv* getThreadJniEnv(const char* threadName = nullptr);
+
 /**
  * @brief 将数据发送到 Java Service 层。
  * 
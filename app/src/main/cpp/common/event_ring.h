@@ -0,0 +1,254 @@
+#ifndef EVENT_RING_H
+#define EVENT_RING_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+/**
+ * 单生产者/单消费者事件环，内存可由 Java 通过 direct ByteBuffer 直接读取。
+ *
+ * 布局（本机字节序）：
+ *   EventRingHeader (192 字节；写索引与读索引各占一条缓存行)
+ *   EventRingRecord[capacity] (每条 64 字节，capacity 为 2 的幂)
+ *
+ * 生产者写完一批记录后以 release 语义发布 writeIndex；消费者读完后发布 readIndex。
+ * 发布与检查对方索引都使用 seq_cst，保证"生产者发现环原本为空才唤醒"与
+ * "消费者确认环为空才睡眠"不会同时错过对方（Dekker 式配对）。
+ * 环满时生产者丢弃整帧并计入 overflowCount，不覆盖消费者可能正在读的记录。
+ *
+ * 本文件不依赖 Android，Linux 主机上的测试消费者使用同一份布局。
+ */
+
+static constexpr uint32_t EVENT_RING_MAGIC = 0x474E5252; // "RRNG"
+static constexpr uint32_t EVENT_RING_VERSION = 1;
+
+// 记录类型，与 JNI 批量缓冲区的记录类型编号一致
+static constexpr uint8_t EVENT_RING_RECORD_TOUCH_CONTACT = 1;
+static constexpr uint8_t EVENT_RING_RECORD_UI_TAP = 2;
+static constexpr uint8_t EVENT_RING_RECORD_UI_PRESS_DOWN = 3;
+static constexpr uint8_t EVENT_RING_RECORD_UI_LONG_PRESS_END = 4;
+static constexpr uint8_t EVENT_RING_RECORD_UI_GESTURE = 5;
+static constexpr uint8_t EVENT_RING_RECORD_PEN = 6;
+static constexpr uint8_t EVENT_RING_RECORD_HID = 7;
+
+// 触摸点 / 外接设备记录的 flags：该记录是本帧最后一个
+static constexpr uint8_t EVENT_RING_FLAG_FRAME_END = 0x01;
+// 触摸点记录的 flags：EventRingTouchTail 有效
+static constexpr uint8_t EVENT_RING_FLAG_EXTENDED = 0x02;
+
+static constexpr size_t EVENT_RING_NAME_BYTES = 40;
+static constexpr size_t EVENT_RING_GESTURE_NAME_BYTES = 32;
+static constexpr size_t EVENT_RING_HID_CHANGES = 4;
+
+/**
+ * @brief 手势记录复用 name 区域：前 32 字节为区域标识，其后为相对按下位置的位移
+ */
+struct EventRingGestureTail {
+    char name[EVENT_RING_GESTURE_NAME_BYTES];
+    int32_t dx;
+    int32_t dy;
+};
+
+/**
+ * @brief 触摸点记录复用 name 区域：压力与接触长轴（轴范围的千分比）
+ */
+struct EventRingTouchTail {
+    uint16_t pressure;
+    uint16_t touchMajor;
+};
+
+/**
+ * @brief 笔采样记录复用 name 区域：压力（万分比）、悬停距离（千分比）、倾角（0.01°）与微秒时间戳
+ */
+struct EventRingPenTail {
+    uint16_t pressure;
+    uint16_t distance;
+    int16_t tiltX;
+    int16_t tiltY;
+    int64_t timestampUs;
+};
+
+/**
+ * @brief 外接设备的一个状态变化：type 为 EV_KEY / EV_ABS / EV_REL
+ */
+struct EventRingHidChange {
+    uint8_t type;
+    uint8_t reserved;
+    uint16_t code;
+    int32_t value;
+};
+
+/**
+ * @brief 外接设备记录复用 name 区域：微秒时间戳与最多 4 个状态变化
+ */
+struct EventRingHidTail {
+    int64_t timestampUs;
+    EventRingHidChange changes[EVENT_RING_HID_CHANGES];
+};
+
+/**
+ * @brief 一条事件（一个缓存行）
+ *
+ * 手势记录 (kind=5)：flags 为 GestureKind，id 低 8 位为手指数、次 8 位为滑动方向，
+ * 时间戳为识别时刻，区域标识与位移见 EventRingGestureTail。
+ * 触摸点记录 (kind=1) 的 flags 含 EVENT_RING_FLAG_EXTENDED 时，压力与接触尺寸见 EventRingTouchTail。
+ * 笔采样记录 (kind=6)：flags 为 PEN_FLAG_*（input/pen_decoder.h），其余字段见 EventRingPenTail。
+ * 外接设备记录 (kind=7)：一帧拆成若干条，最后一条带 EVENT_RING_FLAG_FRAME_END；nameLength 为本条的变化数，
+ * id 低 8 位为设备编号、次 8 位为设备类别、再 8 位为帧标志（input/hid_decoder.h），变化见 EventRingHidTail。
+ */
+struct EventRingRecord {
+    uint8_t kind;
+    uint8_t flags;
+    uint16_t nameLength;       // 区域事件: name 中有效字节数
+    int32_t id;                // 触摸点: tracking id
+    int32_t x;
+    int32_t y;
+    int64_t timestampMs;       // 触摸点: 帧时间戳；区域事件: 按下时间戳
+    union {
+        char name[EVENT_RING_NAME_BYTES]; // 区域标识 (UTF-8，超长截断，不以 0 结尾)
+        EventRingGestureTail gesture;
+        EventRingTouchTail touch;
+        EventRingPenTail pen;
+        EventRingHidTail hid;
+    };
+};
+static_assert(sizeof(EventRingRecord) == 64, "EventRingRecord 必须为 64 字节");
+static_assert(offsetof(EventRingRecord, gesture.dx) == 56, "手势位移偏移");
+static_assert(offsetof(EventRingRecord, touch.pressure) == 24, "触摸点压力偏移");
+static_assert(offsetof(EventRingRecord, pen.tiltX) == 28 && offsetof(EventRingRecord, pen.timestampUs) == 32, "笔采样偏移");
+static_assert(sizeof(EventRingHidChange) == 8 && offsetof(EventRingRecord, hid.changes) == 32, "外接设备记录偏移");
+
+struct EventRingHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t headerSize;
+    uint32_t recordSize;
+    uint32_t capacity;
+    uint32_t closed;           // 非 0 表示生产者已关闭，消费者应退出
+    uint8_t reserved0[40];
+
+    // ---- 生产者缓存行 ----
+    uint64_t writeIndex;       // 已发布的记录总数
+    uint64_t overflowCount;    // 因环满丢弃的记录数
+    uint64_t wakeupCount;      // 由空变非空而唤醒消费者的次数
+    uint8_t reserved1[40];
+
+    // ---- 消费者缓存行 ----
+    uint64_t readIndex;        // 已消费的记录总数
+    uint8_t reserved2[56];
+};
+static_assert(sizeof(EventRingHeader) == 192, "EventRingHeader 必须为 192 字节");
+static_assert(offsetof(EventRingHeader, writeIndex) == 64, "writeIndex 偏移");
+static_assert(offsetof(EventRingHeader, readIndex) == 128, "readIndex 偏移");
+
+inline size_t eventRingBytes(uint32_t capacity) {
+    return sizeof(EventRingHeader) + static_cast<size_t>(capacity) * sizeof(EventRingRecord);
+}
+
+inline EventRingRecord* eventRingRecords(EventRingHeader* header) {
+    return reinterpret_cast<EventRingRecord*>(reinterpret_cast<uint8_t*>(header) + header->headerSize);
+}
+
+/**
+ * @brief 生产者端，只在一个线程上使用
+ */
+class EventRingProducer {
+public:
+    /**
+     * @brief 在 memory 上初始化环
+     * @param capacity 必须为 2 的幂
+     */
+    void init(void* memory, uint32_t capacity) {
+        header_ = static_cast<EventRingHeader*>(memory);
+        std::memset(header_, 0, sizeof(EventRingHeader));
+        header_->magic = EVENT_RING_MAGIC;
+        header_->version = EVENT_RING_VERSION;
+        header_->headerSize = sizeof(EventRingHeader);
+        header_->recordSize = sizeof(EventRingRecord);
+        header_->capacity = capacity;
+        records_ = eventRingRecords(header_);
+        mask_ = capacity - 1;
+        pending_ = 0;
+        published_ = 0;
+        cachedRead_ = 0;
+    }
+
+    /**
+     * @brief 为 count 条记录预留连续序号（可能跨越环尾），空间不足时整体放弃并计数
+     */
+    bool reserve(uint32_t count, uint64_t& first) {
+        if (pending_ + count - cachedRead_ > mask_ + 1) {
+            cachedRead_ = __atomic_load_n(&header_->readIndex, __ATOMIC_ACQUIRE);
+            if (pending_ + count - cachedRead_ > mask_ + 1) {
+                __atomic_store_n(&header_->overflowCount, header_->overflowCount + count, __ATOMIC_RELAXED);
+                return false;
+            }
+        }
+        first = pending_;
+        pending_ += count;
+        return true;
+    }
+
+    EventRingRecord& at(uint64_t index) { return records_[index & mask_]; }
+
+    /**
+     * @brief 发布已预留的记录
+     * @return true 表示发布前环为空（消费者可能在睡眠），调用方应唤醒消费者
+     */
+    bool publish() {
+        if (pending_ == published_) {
+            return false;
+        }
+        const uint64_t previous = published_;
+        published_ = pending_;
+        __atomic_store_n(&header_->writeIndex, published_, __ATOMIC_SEQ_CST);
+        const uint64_t read = __atomic_load_n(&header_->readIndex, __ATOMIC_SEQ_CST);
+        cachedRead_ = read;
+        if (read == previous) {
+            __atomic_store_n(&header_->wakeupCount, header_->wakeupCount + 1, __ATOMIC_RELAXED);
+            return true;
+        }
+        return false;
+    }
+
+    void close() {
+        __atomic_store_n(&header_->closed, 1u, __ATOMIC_SEQ_CST);
+    }
+
+    EventRingHeader* header() const { return header_; }
+
+private:
+    EventRingHeader* header_ = nullptr;
+    EventRingRecord* records_ = nullptr;
+    uint64_t mask_ = 0;
+    uint64_t pending_ = 0;    // 已预留（含未发布）
+    uint64_t published_ = 0;  // 已发布
+    uint64_t cachedRead_ = 0; // 最近一次看到的 readIndex
+};
+
+/**
+ * @brief 消费者端索引操作（C++ 测试消费者与 JNI 等待函数共用）
+ */
+namespace event_ring_consumer {
+
+inline uint64_t available(const EventRingHeader* header) {
+    return __atomic_load_n(&header->writeIndex, __ATOMIC_ACQUIRE);
+}
+
+inline bool isClosed(const EventRingHeader* header) {
+    return __atomic_load_n(&header->closed, __ATOMIC_ACQUIRE) != 0;
+}
+
+/**
+ * @brief 发布已消费到 readIndex，并检查是否还有新数据
+ * @return true 表示环已空，消费者可以睡眠等待唤醒
+ */
+inline bool releaseAndCheckEmpty(EventRingHeader* header, uint64_t readIndex) {
+    __atomic_store_n(&header->readIndex, readIndex, __ATOMIC_SEQ_CST);
+    return __atomic_load_n(&header->writeIndex, __ATOMIC_SEQ_CST) == readIndex;
+}
+
+} // namespace event_ring_consumer
+
+#endif // EVENT_RING_H
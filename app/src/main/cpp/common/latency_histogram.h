@@ -0,0 +1,71 @@
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief 固定桶宽的延迟直方图（微秒）
+ *
+ * 单写者（采样线程）使用 relaxed 原子递增，其他线程可随时读取近似百分位。
+ * 不分配内存，适合放在热路径上。
+ */
+class LatencyHistogram {
+public:
+    static constexpr uint32_t BUCKET_WIDTH_US = 20;
+    static constexpr size_t BUCKET_COUNT = 250;   // 覆盖 0-5ms，超出部分计入溢出桶
+
+    void record(int64_t latencyUs) {
+        if (latencyUs < 0) latencyUs = 0;
+        size_t index = static_cast<size_t>(latencyUs / BUCKET_WIDTH_US);
+        if (index >= BUCKET_COUNT) index = BUCKET_COUNT;
+        buckets_[index].fetch_add(1, std::memory_order_relaxed);
+        count_.fetch_add(1, std::memory_order_relaxed);
+        sumUs_.fetch_add(static_cast<uint64_t>(latencyUs), std::memory_order_relaxed);
+        if (static_cast<uint64_t>(latencyUs) > maxUs_.load(std::memory_order_relaxed)) {
+            maxUs_.store(static_cast<uint64_t>(latencyUs), std::memory_order_relaxed);
+        }
+    }
+
+    void reset() {
+        for (auto& bucket : buckets_) bucket.store(0, std::memory_order_relaxed);
+        count_.store(0, std::memory_order_relaxed);
+        sumUs_.store(0, std::memory_order_relaxed);
+        maxUs_.store(0, std::memory_order_relaxed);
+    }
+
+    uint64_t count() const { return count_.load(std::memory_order_relaxed); }
+    uint64_t maxUs() const { return maxUs_.load(std::memory_order_relaxed); }
+
+    uint64_t meanUs() const {
+        const uint64_t n = count();
+        return n > 0 ? sumUs_.load(std::memory_order_relaxed) / n : 0;
+    }
+
+    /**
+     * @brief 近似百分位：返回包含该百分位样本的桶上界
+     * @param percentile 0-100
+     */
+    uint64_t percentileUs(double percentile) const {
+        const uint64_t n = count();
+        if (n == 0) return 0;
+        const uint64_t target = static_cast<uint64_t>(percentile / 100.0 * static_cast<double>(n));
+        uint64_t seen = 0;
+        for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+            seen += buckets_[i].load(std::memory_order_relaxed);
+            if (seen > target) {
+                return (i + 1) * BUCKET_WIDTH_US;
+            }
+        }
+        return maxUs();
+    }
+
+private:
+    std::atomic<uint64_t> buckets_[BUCKET_COUNT + 1] = {};
+    std::atomic<uint64_t> count_{0};
+    std::atomic<uint64_t> sumUs_{0};
+    std::atomic<uint64_t> maxUs_{0};
+};
+
+#endif // LATENCY_HISTOGRAM_H
@@ -0,0 +1,35 @@
+#include "runtime_stats.h"
+
+#include <ctime>
+
+RuntimeStatsBlock g_runtimeStats = {};
+
+int64_t threadCpuTimeNs() {
+    struct timespec ts;
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) != 0) {
+        return 0;
+    }
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+void ThreadCpuSampler::sample(int64_t nowNs, int64_t intervalNs) {
+    if (nowNs - lastSampleNs_ < intervalNs) {
+        return;
+    }
+    lastSampleNs_ = nowNs;
+    flush();
+}
+
+void ThreadCpuSampler::flush() {
+    const int64_t cpuNs = threadCpuTimeNs();
+    if (cpuNs <= reportedCpuNs_) {
+        return;
+    }
+    const uint64_t delta = static_cast<uint64_t>(cpuNs - reportedCpuNs_);
+    reportedCpuNs_ = cpuNs;
+    if (shared_) {
+        runtimeStatsAddShared(field_, delta);
+    } else {
+        runtimeStatsAdd(field_, delta);
+    }
+}
@@ -0,0 +1,107 @@
+#ifndef RUNTIME_STATS_H
+#define RUNTIME_STATS_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Native 运行时统计块：进程内唯一，供悬浮窗与接收端查看
+ *
+ * 全部为 relaxed 原子的累计计数（activeSlots / queueDepth 为当前值），速率由读取方对两次快照求差得到。
+ * 每个 64 字节缓存行只由一类线程写：读取线程行为单写者，直接 load + store，不使用带锁的原子加；
+ * 发送线程行由多个订阅者的发送线程共同写，使用 fetch_add。Kotlin 经 nativeGetRuntimeStats 返回的
+ * direct ByteBuffer 直接读取（本机字节序，每个字段 8 字节，下标见 RuntimeStatsField），不需要逐次 JNI 调用。
+ */
+enum class RuntimeStatsField : uint32_t {
+    // ---- 读取线程 ----
+    InputEvents = 0,   // 读到的 input_event 数（触摸、笔、外接设备）
+    TouchFrames,       // 交给输出的触摸帧数
+    ActiveSlots,       // 当前按下的手指数
+    RegionHits,        // 手指按下时命中区域的次数
+    SinkFlushes,       // 输出批次数（JNI 批量上行或事件环发布）
+    SinkTimeNs,        // 输出批次耗时之和，除以 SinkFlushes 即每批 JNI / 事件环耗时
+    SyncDrops,         // 收到的 SYN_DROPPED 次数
+    ReaderCpuNs,       // 读取线程 CPU 时间（约每秒更新）
+    // ---- 发送线程（所有订阅者之和） ----
+    PacketsSent,       // 已写出的包数
+    BytesSent,         // 已写出的字节数
+    QueueDepth,        // 当前排队等待写出的包数
+    PacketsDropped,    // 队列满时丢弃的包数
+    PacketsSuperseded, // 写出前被同类型新包取代的状态包数
+    SendErrors,        // 写错误次数
+    SendTimeNs,        // send() 耗时之和
+    SenderCpuNs,       // 发送线程 CPU 时间（约每秒更新）
+    Count
+};
+
+static constexpr size_t RUNTIME_STATS_FIELD_COUNT = static_cast<size_t>(RuntimeStatsField::Count);
+static constexpr size_t RUNTIME_STATS_LINE_BYTES = 64;
+
+struct alignas(RUNTIME_STATS_LINE_BYTES) RuntimeStatsBlock {
+    std::atomic<uint64_t> values[RUNTIME_STATS_FIELD_COUNT];
+
+    std::atomic<uint64_t>& operator[](RuntimeStatsField field) {
+        return values[static_cast<size_t>(field)];
+    }
+    uint64_t load(RuntimeStatsField field) const {
+        return values[static_cast<size_t>(field)].load(std::memory_order_relaxed);
+    }
+};
+
+static_assert(sizeof(std::atomic<uint64_t>) == sizeof(uint64_t) && std::atomic<uint64_t>::is_always_lock_free,
+              "统计块需要与 Kotlin 共享的无锁 64 位原子");
+static_assert(static_cast<size_t>(RuntimeStatsField::PacketsSent) * sizeof(uint64_t) == RUNTIME_STATS_LINE_BYTES,
+              "读取线程字段应恰好占满第一个缓存行");
+static_assert(sizeof(RuntimeStatsBlock) == 2 * RUNTIME_STATS_LINE_BYTES, "RuntimeStatsBlock 布局");
+
+extern RuntimeStatsBlock g_runtimeStats;
+
+/**
+ * @brief 单写者字段累加：relaxed load + store，避免原子读改写
+ */
+inline void runtimeStatsAdd(RuntimeStatsField field, uint64_t delta) {
+    std::atomic<uint64_t>& value = g_runtimeStats[field];
+    value.store(value.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+}
+
+inline void runtimeStatsSet(RuntimeStatsField field, uint64_t value) {
+    g_runtimeStats[field].store(value, std::memory_order_relaxed);
+}
+
+/**
+ * @brief 多写者字段累加（发送线程、提交线程）
+ */
+inline void runtimeStatsAddShared(RuntimeStatsField field, uint64_t delta) {
+    g_runtimeStats[field].fetch_add(delta, std::memory_order_relaxed);
+}
+
+inline void runtimeStatsSubShared(RuntimeStatsField field, uint64_t delta) {
+    g_runtimeStats[field].fetch_sub(delta, std::memory_order_relaxed);
+}
+
+/**
+ * @brief 把调用线程的 CPU 时间增量计入统计块；每个线程一个，线程退出前应 flush 一次
+ *
+ * sample() 在距上次采样不足 intervalNs 时只比较一次单调时钟，热循环中每轮调用的开销可忽略。
+ */
+class ThreadCpuSampler {
+public:
+    ThreadCpuSampler(RuntimeStatsField field, bool shared) : field_(field), shared_(shared) {}
+
+    void sample(int64_t nowNs, int64_t intervalNs = 1000000000LL);
+    void flush();
+
+private:
+    RuntimeStatsField field_;
+    bool shared_;
+    int64_t lastSampleNs_ = 0;
+    int64_t reportedCpuNs_ = 0;
+};
+
+/**
+ * @brief 当前线程的 CPU 时间 (CLOCK_THREAD_CPUTIME_ID，纳秒)
+ */
+int64_t threadCpuTimeNs();
+
+#endif // RUNTIME_STATS_H
@@ -0,0 +1,266 @@
+#include "thread_config.h"
+
+#include <algorithm>
+#include <alloca.h>
+#include <android/log.h>
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+// 日志标签
+#define TAG "NativeThreadConfig"
+
+namespace {
+
+constexpr int ROLE_COUNT = static_cast<int>(ThreadRole::Count);
+
+struct RoleState {
+    ThreadConfig config;
+    ThreadConfigResult result;
+};
+
+std::mutex g_roleMutex;
+RoleState g_roles[ROLE_COUNT];
+// 每次 setThreadConfig 递增，线程据此判断是否需要重新应用（从 1 开始，0 表示尚未应用）
+std::atomic<uint32_t> g_roleGenerations[ROLE_COUNT] = {};
+
+const char* roleName(ThreadRole role) {
+    switch (role) {
+        case ThreadRole::InputReader: return "InputReader";
+        case ThreadRole::PacketSender: return "PacketSender";
+        default: return "Unknown";
+    }
+}
+
+const char* policyName(int policy) {
+    switch (policy) {
+        case SCHED_OTHER: return "SCHED_OTHER";
+        case SCHED_FIFO: return "SCHED_FIFO";
+        case SCHED_RR: return "SCHED_RR";
+#ifdef SCHED_BATCH
+        case SCHED_BATCH: return "SCHED_BATCH";
+#endif
+#ifdef SCHED_IDLE
+        case SCHED_IDLE: return "SCHED_IDLE";
+#endif
+        default: return "SCHED_?";
+    }
+}
+
+// 预触碰后仍留给线程自身调用链的栈空间
+constexpr size_t STACK_SAFETY_MARGIN_BYTES = 64 * 1024;
+
+/**
+ * @brief 当前栈帧下方还能安全预触碰的字节数（保护页与 STACK_SAFETY_MARGIN_BYTES 之上）；取不到栈信息时为 0
+ */
+__attribute__((noinline)) size_t usableStackBelowFrame() {
+    pthread_attr_t attr;
+    if (pthread_getattr_np(pthread_self(), &attr) != 0) {
+        return 0;
+    }
+    void* stackAddr = nullptr;
+    size_t stackSize = 0;
+    size_t guardSize = 0;
+    pthread_attr_getstack(&attr, &stackAddr, &stackSize);
+    pthread_attr_getguardsize(&attr, &guardSize);
+    pthread_attr_destroy(&attr);
+    if (!stackAddr || stackSize == 0) {
+        return 0;
+    }
+    volatile char marker = 0;
+    const uintptr_t frame = reinterpret_cast<uintptr_t>(&marker);
+    const uintptr_t bottom = reinterpret_cast<uintptr_t>(stackAddr) + guardSize + STACK_SAFETY_MARGIN_BYTES;
+    return frame > bottom ? frame - bottom : 0;
+}
+
+/**
+ * @brief 在当前栈帧下方逐页写入，使内核提前分配栈页；bytes 必须已按 usableStackBelowFrame 收紧
+ */
+__attribute__((noinline)) void prefaultStack(size_t bytes) {
+    const size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    volatile char* region = static_cast<volatile char*>(alloca(bytes));
+    for (size_t offset = 0; offset < bytes; offset += pageSize) {
+        region[offset] = 0;
+    }
+}
+
+/**
+ * @brief mlock 当前线程栈顶向下 bytes 字节的区域
+ */
+int lockCurrentStack(size_t bytes) {
+    pthread_attr_t attr;
+    if (pthread_getattr_np(pthread_self(), &attr) != 0) {
+        return EINVAL;
+    }
+    void* stackAddr = nullptr;
+    size_t stackSize = 0;
+    pthread_attr_getstack(&attr, &stackAddr, &stackSize);
+    pthread_attr_destroy(&attr);
+    if (!stackAddr || stackSize == 0) {
+        return EINVAL;
+    }
+    if (bytes > stackSize) bytes = stackSize;
+
+    const uintptr_t pageSize = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+    uintptr_t top = reinterpret_cast<uintptr_t>(stackAddr) + stackSize;
+    uintptr_t start = (top - bytes) & ~(pageSize - 1);
+    if (mlock(reinterpret_cast<void*>(start), top - start) != 0) {
+        return errno;
+    }
+    return 0;
+}
+
+} // namespace
+
+std::string ThreadConfigResult::describe() const {
+    if (!applied) {
+        return "未应用";
+    }
+    char buf[256];
+    snprintf(buf, sizeof(buf),
+        "tid=%d %s prio=%d nice=%d cpus=0x%llx stack=%zu/%zuB mlock=%d mlockall=%d "
+        "(errno sched=%d affinity=%d lock=%d)",
+        tid, policyName(policy), rtPriority, niceValue,
+        (unsigned long long)cpuMask, stackPrefaultedBytes, stackRequestedBytes,
+        memoryLocked ? 1 : 0, allMemoryLocked ? 1 : 0,
+        schedErrno, affinityErrno, lockErrno);
+    return buf;
+}
+
+ThreadConfigResult applyThreadConfigToCurrentThread(const ThreadConfig& config) {
+    ThreadConfigResult result;
+    result.applied = true;
+    result.tid = static_cast<int>(gettid());
+
+    // ---- 调度策略 ----
+    bool realtimeGranted = false;
+    if (config.policy == ThreadSchedPolicy::Fifo || config.policy == ThreadSchedPolicy::RoundRobin) {
+        const int policy = config.policy == ThreadSchedPolicy::Fifo ? SCHED_FIFO : SCHED_RR;
+        struct sched_param param;
+        std::memset(&param, 0, sizeof(param));
+        param.sched_priority = config.rtPriority;
+        if (sched_setscheduler(0, policy, &param) == 0) {
+            realtimeGranted = true;
+        } else {
+            result.schedErrno = errno;
+        }
+    } else {
+        // 显式请求普通调度时，把可能残留的实时策略改回 SCHED_OTHER
+        struct sched_param param;
+        std::memset(&param, 0, sizeof(param));
+        if (sched_getscheduler(0) != SCHED_OTHER && sched_setscheduler(0, SCHED_OTHER, &param) != 0) {
+            result.schedErrno = errno;
+        }
+    }
+    // 普通策略或实时策略被拒绝时，使用 nice 值（setpriority 对 tid 生效）
+    if (!realtimeGranted && setpriority(PRIO_PROCESS, static_cast<id_t>(result.tid), config.niceValue) != 0
+        && result.schedErrno == 0) {
+        result.schedErrno = errno;
+    }
+
+    // ---- CPU 绑定 ----
+    if (config.cpuMask != 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (int cpu = 0; cpu < 64; ++cpu) {
+            if (config.cpuMask & (uint64_t(1) << cpu)) {
+                CPU_SET(cpu, &set);
+            }
+        }
+        if (sched_setaffinity(0, sizeof(set), &set) != 0) {
+            result.affinityErrno = errno;
+        }
+    }
+
+    // ---- 栈预触碰与内存锁定 ----
+    // alloca 超出线程栈不会返回错误，而是直接越过保护页崩溃，因此先按实际剩余的栈收紧
+    result.stackRequestedBytes = config.prefaultStackBytes;
+    const size_t stackBytes = std::min(config.prefaultStackBytes, usableStackBelowFrame());
+    if (stackBytes < config.prefaultStackBytes) {
+        __android_log_print(ANDROID_LOG_WARN, TAG, "栈预触碰 %zuB 超出线程剩余栈，收紧为 %zuB",
+                            config.prefaultStackBytes, stackBytes);
+    }
+    if (stackBytes > 0) {
+        prefaultStack(stackBytes);
+        result.stackPrefaultedBytes = stackBytes;
+        if (config.lockMemory) {
+            result.lockErrno = lockCurrentStack(stackBytes);
+            result.memoryLocked = result.lockErrno == 0;
+        }
+    }
+    if (config.lockAllMemory) {
+        if (mlockall(MCL_CURRENT | MCL_FUTURE) == 0) {
+            result.allMemoryLocked = true;
+        } else if (result.lockErrno == 0) {
+            result.lockErrno = errno;
+        }
+    }
+
+    // ---- 读回实际状态 ----
+    result.policy = sched_getscheduler(0);
+    struct sched_param actual;
+    if (sched_getparam(0, &actual) == 0) {
+        result.rtPriority = actual.sched_priority;
+    }
+    errno = 0;
+    result.niceValue = getpriority(PRIO_PROCESS, static_cast<id_t>(result.tid));
+    cpu_set_t actualSet;
+    CPU_ZERO(&actualSet);
+    if (sched_getaffinity(0, sizeof(actualSet), &actualSet) == 0) {
+        for (int cpu = 0; cpu < 64; ++cpu) {
+            if (CPU_ISSET(cpu, &actualSet)) {
+                result.cpuMask |= uint64_t(1) << cpu;
+            }
+        }
+    }
+    return result;
+}
+
+void setThreadConfig(ThreadRole role, const ThreadConfig& config) {
+    const int index = static_cast<int>(role);
+    if (index < 0 || index >= ROLE_COUNT) return;
+    {
+        std::lock_guard<std::mutex> lock(g_roleMutex);
+        g_roles[index].config = config;
+    }
+    g_roleGenerations[index].fetch_add(1, std::memory_order_release);
+}
+
+bool applyThreadConfigIfChanged(ThreadRole role, uint32_t& appliedGeneration) {
+    const int index = static_cast<int>(role);
+    if (index < 0 || index >= ROLE_COUNT) return false;
+    const uint32_t generation = g_roleGenerations[index].load(std::memory_order_acquire);
+    if (generation == appliedGeneration) {
+        return false;
+    }
+
+    ThreadConfig config;
+    {
+        std::lock_guard<std::mutex> lock(g_roleMutex);
+        config = g_roles[index].config;
+    }
+    ThreadConfigResult result = applyThreadConfigToCurrentThread(config);
+    {
+        std::lock_guard<std::mutex> lock(g_roleMutex);
+        g_roles[index].result = result;
+    }
+    appliedGeneration = generation;
+
+    __android_log_print(ANDROID_LOG_INFO, TAG, "%s 线程配置已应用: %s",
+        roleName(role), result.describe().c_str());
+    return true;
+}
+
+ThreadConfigResult lastThreadConfigResult(ThreadRole role) {
+    const int index = static_cast<int>(role);
+    if (index < 0 || index >= ROLE_COUNT) return ThreadConfigResult();
+    std::lock_guard<std::mutex> lock(g_roleMutex);
+    return g_roles[index].result;
+}
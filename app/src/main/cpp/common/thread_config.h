@@ -0,0 +1,88 @@
+#ifndef THREAD_CONFIG_H
+#define THREAD_CONFIG_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief 调度策略
+ */
+enum class ThreadSchedPolicy : int {
+    Default = 0,     // SCHED_OTHER，可配合 nice 值
+    Fifo = 1,        // SCHED_FIFO 实时调度
+    RoundRobin = 2,  // SCHED_RR 实时调度
+};
+
+/**
+ * @brief 使用线程配置的 Native 线程角色
+ */
+enum class ThreadRole : int {
+    InputReader = 0,
+    PacketSender = 1,
+    Count
+};
+
+// prefaultStackBytes 的上限（Android 线程默认栈约 1 MiB）；应用时还会按调用线程实际剩余的栈再收紧
+constexpr size_t MAX_PREFAULT_STACK_BYTES = 1024 * 1024;
+
+/**
+ * @brief 请求的线程配置
+ */
+struct ThreadConfig {
+    ThreadSchedPolicy policy = ThreadSchedPolicy::Default;
+    int rtPriority = 0;            // 实时优先级 (1-99)，仅 Fifo/RoundRobin 使用
+    int niceValue = 0;             // Default 策略下的 nice 值；实时策略被拒绝时作为回退
+    uint64_t cpuMask = 0;          // 绑定的 CPU 位掩码，0 表示不绑定
+    size_t prefaultStackBytes = 0; // 预先触碰的栈大小，避免运行中缺页
+    bool lockMemory = false;       // mlock 预触碰的栈区域
+    bool lockAllMemory = false;    // mlockall(MCL_CURRENT | MCL_FUTURE)，代价很高，仅用于实验
+};
+
+/**
+ * @brief 实际生效的线程配置（读回内核中的状态）
+ */
+struct ThreadConfigResult {
+    bool applied = false;          // 是否已经对线程应用过配置
+    int tid = 0;
+    int policy = 0;                // 实际的 SCHED_* 值
+    int rtPriority = 0;
+    int niceValue = 0;
+    uint64_t cpuMask = 0;          // 实际允许运行的 CPU
+    size_t stackPrefaultedBytes = 0; // 实际预触碰的栈大小（已按剩余栈收紧）
+    size_t stackRequestedBytes = 0;  // 请求的大小；大于 stackPrefaultedBytes 时说明被收紧
+    bool memoryLocked = false;
+    bool allMemoryLocked = false;
+    int schedErrno = 0;            // 调度策略设置失败的 errno
+    int affinityErrno = 0;
+    int lockErrno = 0;
+
+    /**
+     * @brief 生成单行可读描述，用于日志与 JNI 报告
+     */
+    std::string describe() const;
+};
+
+/**
+ * @brief 立即对调用线程应用配置，并返回读回的实际状态
+ */
+ThreadConfigResult applyThreadConfigToCurrentThread(const ThreadConfig& config);
+
+/**
+ * @brief 设置某个角色的线程配置，对应线程会在下一次循环中自行应用
+ */
+void setThreadConfig(ThreadRole role, const ThreadConfig& config);
+
+/**
+ * @brief 线程在自己的循环中调用：配置有变化时应用，并记录结果
+ * @param appliedGeneration 线程本地保存的已应用配置代数
+ * @return 本次是否重新应用了配置
+ */
+bool applyThreadConfigIfChanged(ThreadRole role, uint32_t& appliedGeneration);
+
+/**
+ * @brief 获取某个角色最近一次应用配置的结果
+ */
+ThreadConfigResult lastThreadConfigResult(ThreadRole role);
+
+#endif // THREAD_CONFIG_H
@@ -0,0 +1,260 @@
+#include "trace_log.h"
+
+#include <android/log.h>
+#include <condition_variable>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <sys/prctl.h>
+#include <thread>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <vector>
+
+// 日志标签
+#define TAG "NativeTrace"
+
+namespace {
+
+/**
+ * @brief 事件表：输出标签与格式串（整数参数均为 %lld，字符串参数 %s 放在最后）
+ */
+struct TraceEventInfo {
+    const char* tag;
+    const char* format;
+};
+
+constexpr TraceEventInfo kTraceEvents[] = {
+    /* InvalidSlot */       {"NativeInputReader", "无效 slot %lld => 忽略至下一个 slot"},
+    /* RegionTap */         {"NativeInputReader", "[Slot=%lld] 按下命中区域 (X=%lld,Y=%lld): %s"},
+    /* LongPressStart */    {"NativeInputReader", "[Slot=%lld] 达到长按开始延迟 (%lld ms >= %lld ms), 发送按下事件: %s"},
+    /* LongPressEnd */      {"NativeInputReader", "[Slot=%lld] 长按结束: %s"},
+    /* RegionsUpdated */    {"NativeInputReader", "nativeUpdateClickableRegions: JSON %lld 字节, 更新后区域数=%lld"},
+    /* UiPacketRequest */   {"NativeInputReader", "nativeRequestSendUi*Packet (no-op in C++): kind=%lld (%lld,%lld) %s"},
+    /* JniBatchFailed */    {"NativeInputReader", "flush: onNativeInputBatch 调用失败, %lld 字节"},
+    /* PacketWriteFailed */ {"NativePacketSender", "写出 %lld 个包失败: errno=%lld，发送器标记为不可用。"},
+    /* RegionSlideIn */     {"NativeInputReader", "[Slot=%lld] 滑入区域 (X=%lld,Y=%lld): %s"},
+    /* RegionSlideOut */    {"NativeInputReader", "[Slot=%lld] 滑出区域 (X=%lld,Y=%lld): %s"},
+    /* ContactRejected */   {"NativeInputReader", "[Slot=%lld] 触摸被过滤 (原因=%lld, X=%lld,Y=%lld)"},
+    /* SynDropped */        {"NativeInputReader", "SYN_DROPPED: evdev 缓冲区溢出 (累计 %lld 次)，丢弃事件直到下一个 SYN_REPORT"},
+    /* TouchResync */       {"NativeInputReader", "多点触摸状态已重新同步: 补发抬起 %lld, 补发按下 %lld"},
+    /* TouchResyncFailed */ {"NativeInputReader", "多点触摸状态重新同步失败: errno=%lld，保留当前状态"},
+};
+static_assert(sizeof(kTraceEvents) / sizeof(kTraceEvents[0]) == static_cast<size_t>(TraceEvent::Count),
+              "事件表与 TraceEvent 不一致");
+
+/**
+ * @brief 全局状态。有意不析构：进程退出时排空线程可能仍在运行，静态析构会与其竞争。
+ */
+struct TraceState {
+    std::mutex registryMutex; // 保护缓冲区列表（只在线程首次记录时与排空时使用）
+    std::vector<std::unique_ptr<TraceThreadBuffer>> buffers;
+
+    std::mutex drainMutex;    // 串行化排空与输出文件
+    FILE* file = nullptr;
+    std::vector<uint64_t> reportedDrops; // 与 buffers 下标对应
+
+    std::mutex threadMutex;
+    std::condition_variable threadCv;
+    std::thread thread;
+    bool stopRequested = false;
+};
+
+TraceState& traceState() {
+    static TraceState* state = new TraceState();
+    return *state;
+}
+
+constexpr int TRACE_DRAIN_INTERVAL_MS = 50;
+
+/**
+ * @brief 线程退出时标记其缓冲区，排空后可被新线程复用
+ */
+struct TraceThreadExitGuard {
+    TraceThreadBuffer* buffer = nullptr;
+    ~TraceThreadExitGuard() {
+        if (buffer) {
+            buffer->threadExited.store(true, std::memory_order_release);
+        }
+    }
+};
+
+thread_local TraceThreadExitGuard t_traceExitGuard;
+
+void formatRecord(const TraceRecord& record, char* out, size_t outSize) {
+    const TraceEventInfo& info = kTraceEvents[record.event];
+    char text[TRACE_STRING_BYTES + 1];
+    std::memcpy(text, record.text, record.stringLength);
+    text[record.stringLength] = '\0';
+    const long long* a = reinterpret_cast<const long long*>(record.args);
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wformat-nonliteral"
+    // 整数参数在前，字符串紧随其后，按实际参数个数展开保证可变参数类型与格式串一致
+    switch (record.argCount) {
+        case 0: std::snprintf(out, outSize, info.format, text); break;
+        case 1: std::snprintf(out, outSize, info.format, a[0], text); break;
+        case 2: std::snprintf(out, outSize, info.format, a[0], a[1], text); break;
+        case 3: std::snprintf(out, outSize, info.format, a[0], a[1], a[2], text); break;
+        default: std::snprintf(out, outSize, info.format, a[0], a[1], a[2], a[3], text); break;
+    }
+#pragma GCC diagnostic pop
+}
+
+void emit(uint8_t level, const char* tag, int tid, uint64_t timestampNs, const char* line) {
+    TraceState& state = traceState();
+    __android_log_print(level, tag, "%s", line);
+    if (state.file) {
+        std::fprintf(state.file, "%llu.%06llu %d %s: %s\n",
+            (unsigned long long)(timestampNs / 1000000000ull),
+            (unsigned long long)(timestampNs % 1000000000ull / 1000),
+            tid, tag, line);
+    }
+}
+
+/**
+ * @brief 排空所有缓冲区。调用方持有 drainMutex。
+ */
+void drainLocked() {
+    TraceState& state = traceState();
+    std::vector<TraceThreadBuffer*> buffers;
+    {
+        std::lock_guard<std::mutex> lock(state.registryMutex);
+        buffers.reserve(state.buffers.size());
+        for (auto& buffer : state.buffers) {
+            buffers.push_back(buffer.get());
+        }
+    }
+    if (state.reportedDrops.size() < buffers.size()) {
+        state.reportedDrops.resize(buffers.size(), 0);
+    }
+
+    char line[256];
+    for (size_t i = 0; i < buffers.size(); ++i) {
+        TraceThreadBuffer* buffer = buffers[i];
+        uint32_t tail = buffer->tail.load(std::memory_order_relaxed);
+        const uint32_t head = buffer->head.load(std::memory_order_acquire);
+        while (tail != head) {
+            const TraceRecord& record = buffer->records[tail & (TraceThreadBuffer::CAPACITY - 1)];
+            if (record.event < static_cast<uint16_t>(TraceEvent::Count)) {
+                formatRecord(record, line, sizeof(line));
+                emit(record.level, kTraceEvents[record.event].tag, buffer->tid, record.timestampNs, line);
+            }
+            ++tail;
+        }
+        buffer->tail.store(tail, std::memory_order_release);
+
+        const uint64_t dropped = buffer->dropped.load(std::memory_order_relaxed);
+        if (dropped != state.reportedDrops[i]) {
+            std::snprintf(line, sizeof(line), "线程 %s(%d) 跟踪缓冲区已满，累计丢弃 %llu 条",
+                buffer->threadName, buffer->tid, (unsigned long long)dropped);
+            struct timespec now;
+            clock_gettime(CLOCK_MONOTONIC, &now);
+            emit(TRACE_LEVEL_WARN, TAG, buffer->tid,
+                 static_cast<uint64_t>(now.tv_sec) * 1000000000ull + static_cast<uint64_t>(now.tv_nsec), line);
+            state.reportedDrops[i] = dropped;
+        }
+    }
+    if (state.file) {
+        std::fflush(state.file);
+    }
+}
+
+void drainThreadMain() {
+    TraceState& state = traceState();
+    prctl(PR_SET_NAME, "NativeTraceDrain", 0, 0, 0);
+    std::unique_lock<std::mutex> lock(state.threadMutex);
+    while (!state.stopRequested) {
+        state.threadCv.wait_for(lock, std::chrono::milliseconds(TRACE_DRAIN_INTERVAL_MS));
+        lock.unlock();
+        {
+            std::lock_guard<std::mutex> drainLock(state.drainMutex);
+            drainLocked();
+        }
+        lock.lock();
+    }
+}
+
+} // namespace
+
+TraceThreadBuffer* traceThreadBufferSlow() {
+    TraceState& state = traceState();
+    std::lock_guard<std::mutex> lock(state.registryMutex);
+    TraceThreadBuffer* buffer = nullptr;
+    // 复用已退出且已排空的线程缓冲区，线程反复创建时内存不增长
+    for (auto& candidate : state.buffers) {
+        if (candidate->threadExited.load(std::memory_order_acquire) &&
+            candidate->tail.load(std::memory_order_acquire) == candidate->head.load(std::memory_order_relaxed)) {
+            buffer = candidate.get();
+            buffer->threadExited.store(false, std::memory_order_relaxed);
+            break;
+        }
+    }
+    if (!buffer) {
+        state.buffers.push_back(std::make_unique<TraceThreadBuffer>());
+        buffer = state.buffers.back().get();
+    }
+    buffer->tid = static_cast<int>(syscall(SYS_gettid));
+    prctl(PR_GET_NAME, buffer->threadName, 0, 0, 0);
+    buffer->threadName[sizeof(buffer->threadName) - 1] = '\0';
+    t_traceExitGuard.buffer = buffer;
+    return buffer;
+}
+
+void traceLogStart() {
+    TraceState& state = traceState();
+    std::lock_guard<std::mutex> lock(state.threadMutex);
+    if (state.thread.joinable()) {
+        return;
+    }
+    state.stopRequested = false;
+    state.thread = std::thread(drainThreadMain);
+}
+
+void traceLogStop() {
+    TraceState& state = traceState();
+    {
+        std::lock_guard<std::mutex> lock(state.threadMutex);
+        if (!state.thread.joinable()) {
+            return;
+        }
+        state.stopRequested = true;
+    }
+    state.threadCv.notify_all();
+    state.thread.join();
+    traceLogFlush();
+}
+
+void traceLogFlush() {
+    TraceState& state = traceState();
+    std::lock_guard<std::mutex> lock(state.drainMutex);
+    drainLocked();
+}
+
+bool traceLogSetOutputFile(const std::string& path) {
+    TraceState& state = traceState();
+    std::lock_guard<std::mutex> lock(state.drainMutex);
+    if (state.file) {
+        std::fclose(state.file);
+        state.file = nullptr;
+    }
+    if (path.empty()) {
+        return true;
+    }
+    state.file = std::fopen(path.c_str(), "ae");
+    if (!state.file) {
+        __android_log_print(ANDROID_LOG_ERROR, TAG, "无法打开跟踪日志文件: %s", path.c_str());
+        return false;
+    }
+    return true;
+}
+
+uint64_t traceLogDroppedCount() {
+    TraceState& state = traceState();
+    std::lock_guard<std::mutex> lock(state.registryMutex);
+    uint64_t total = 0;
+    for (auto& buffer : state.buffers) {
+        total += buffer->dropped.load(std::memory_order_relaxed);
+    }
+    return total;
+}
@@ -0,0 +1,192 @@
+#ifndef TRACE_LOG_H
+#define TRACE_LOG_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <time.h>
+#include <type_traits>
+
+/**
+ * 热路径二进制跟踪日志。
+ *
+ * 调用线程只把 (事件 ID, 最多 4 个整数参数, 一个短字符串, 单调时钟时间戳) 写入
+ * 自己的无锁环形缓冲区，不格式化、不做系统调用；后台排空线程按事件表中的格式串
+ * 格式化后写到 logcat 或文件。缓冲区满时丢弃并计数，不阻塞调用线程。
+ *
+ * 级别在编译期过滤：低于 TRACE_LOG_MIN_LEVEL 的 TRACE_* 调用整体被 if constexpr 去掉，
+ * 参数也不会求值。级别数值与 ANDROID_LOG_* 一致。
+ */
+
+static constexpr uint8_t TRACE_LEVEL_DEBUG = 3;
+static constexpr uint8_t TRACE_LEVEL_INFO = 4;
+static constexpr uint8_t TRACE_LEVEL_WARN = 5;
+static constexpr uint8_t TRACE_LEVEL_ERROR = 6;
+
+#ifndef TRACE_LOG_MIN_LEVEL
+#ifdef NDEBUG
+#define TRACE_LOG_MIN_LEVEL 4
+#else
+#define TRACE_LOG_MIN_LEVEL 3
+#endif
+#endif
+
+/**
+ * @brief 跟踪事件 ID。格式串见 trace_log.cpp 中的事件表，整数参数在前、字符串参数最后。
+ */
+enum class TraceEvent : uint16_t {
+    InvalidSlot = 0,        // slot
+    RegionTap,              // slot, x, y, region
+    LongPressStart,         // slot, durationMs, delayMs, region
+    LongPressEnd,           // slot, region
+    RegionsUpdated,         // jsonBytes, count
+    UiPacketRequest,        // kind (0 点击 / 1 长按), x, y, identifier
+    JniBatchFailed,         // batchBytes
+    PacketWriteFailed,      // packets, errno
+    RegionSlideIn,          // slot, x, y, region
+    RegionSlideOut,         // slot, x, y, region
+    ContactRejected,        // slot, reason (TOUCH_REJECT_*), x, y
+    SynDropped,             // dropCount
+    TouchResync,            // lifted, landed
+    TouchResyncFailed,      // errno
+    Count
+};
+
+static constexpr size_t TRACE_MAX_INT_ARGS = 4;
+static constexpr size_t TRACE_STRING_BYTES = 16;
+
+/**
+ * @brief 一条跟踪记录（一个缓存行）
+ */
+struct TraceRecord {
+    uint64_t timestampNs;
+    uint16_t event;
+    uint8_t level;
+    uint8_t argCount;
+    uint8_t stringLength;
+    uint8_t reserved[3];
+    int64_t args[TRACE_MAX_INT_ARGS];
+    char text[TRACE_STRING_BYTES];  // 超长截断，不以 0 结尾
+};
+static_assert(sizeof(TraceRecord) == 64, "TraceRecord 必须为 64 字节");
+
+/**
+ * @brief 单个线程的环形缓冲区：所属线程写，排空线程读
+ */
+struct TraceThreadBuffer {
+    static constexpr uint32_t CAPACITY = 256; // 2 的幂
+
+    TraceRecord records[CAPACITY];
+    alignas(64) std::atomic<uint32_t> head{0};   // 所属线程写
+    alignas(64) std::atomic<uint32_t> tail{0};   // 排空线程写
+    std::atomic<uint64_t> dropped{0};
+    std::atomic<bool> threadExited{false};
+    int tid = 0;
+    char threadName[16] = {};
+};
+
+/**
+ * @brief 调用线程的缓冲区，第一次调用时登记（唯一会加锁的路径）
+ */
+TraceThreadBuffer* traceThreadBufferSlow();
+
+inline TraceThreadBuffer* traceThreadBuffer() {
+    static thread_local TraceThreadBuffer* buffer = nullptr;
+    if (__builtin_expect(buffer == nullptr, 0)) {
+        buffer = traceThreadBufferSlow();
+    }
+    return buffer;
+}
+
+namespace trace_detail {
+
+template <typename T>
+inline void appendArg(TraceRecord& record, const T& value) {
+    if constexpr (std::is_integral_v<T> || std::is_enum_v<T>) {
+        if (record.argCount < TRACE_MAX_INT_ARGS) {
+            record.args[record.argCount++] = static_cast<int64_t>(value);
+        }
+    } else {
+        const char* data = nullptr;
+        size_t length = 0;
+        if constexpr (std::is_same_v<T, std::string>) {
+            data = value.data();
+            length = value.size();
+        } else {
+            data = value;
+            length = data ? std::strlen(data) : 0;
+        }
+        if (length > TRACE_STRING_BYTES) length = TRACE_STRING_BYTES;
+        std::memcpy(record.text, data, length);
+        record.stringLength = static_cast<uint8_t>(length);
+    }
+}
+
+} // namespace trace_detail
+
+/**
+ * @brief 记录一条跟踪事件（请使用 TRACE_* 宏，以便编译期过滤）
+ */
+template <typename... Args>
+inline void traceLog(uint8_t level, TraceEvent event, const Args&... args) {
+    TraceThreadBuffer* buffer = traceThreadBuffer();
+    if (!buffer) {
+        return;
+    }
+    const uint32_t head = buffer->head.load(std::memory_order_relaxed);
+    if (head - buffer->tail.load(std::memory_order_acquire) >= TraceThreadBuffer::CAPACITY) {
+        buffer->dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    TraceRecord& record = buffer->records[head & (TraceThreadBuffer::CAPACITY - 1)];
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    record.timestampNs = static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);
+    record.event = static_cast<uint16_t>(event);
+    record.level = level;
+    record.argCount = 0;
+    record.stringLength = 0;
+    (trace_detail::appendArg(record, args), ...);
+    buffer->head.store(head + 1, std::memory_order_release);
+}
+
+#define TRACE_LOG(level, event, ...)                          \
+    do {                                                      \
+        if constexpr ((level) >= TRACE_LOG_MIN_LEVEL) {       \
+            traceLog((level), (event), ##__VA_ARGS__);        \
+        }                                                     \
+    } while (0)
+
+#define TRACE_D(event, ...) TRACE_LOG(TRACE_LEVEL_DEBUG, event, ##__VA_ARGS__)
+#define TRACE_I(event, ...) TRACE_LOG(TRACE_LEVEL_INFO, event, ##__VA_ARGS__)
+#define TRACE_W(event, ...) TRACE_LOG(TRACE_LEVEL_WARN, event, ##__VA_ARGS__)
+#define TRACE_E(event, ...) TRACE_LOG(TRACE_LEVEL_ERROR, event, ##__VA_ARGS__)
+
+/**
+ * @brief 启动后台排空线程（重复调用无副作用）
+ */
+void traceLogStart();
+
+/**
+ * @brief 排空剩余记录并停止后台线程
+ */
+void traceLogStop();
+
+/**
+ * @brief 在调用线程上立即排空所有缓冲区
+ */
+void traceLogFlush();
+
+/**
+ * @brief 额外把格式化后的日志追加写入文件；path 为空则只写 logcat
+ */
+bool traceLogSetOutputFile(const std::string& path);
+
+/**
+ * @brief 所有线程累计丢弃的记录数
+ */
+uint64_t traceLogDroppedCount();
+
+#endif // TRACE_LOG_H
@@ -0,0 +1,168 @@
+#include "event_capture.h"
+
+#include <android/log.h>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// 日志标签
+#define TAG "NativeEventCapture"
+
+EventCaptureWriter::~EventCaptureWriter() {
+    close();
+}
+
+bool EventCaptureWriter::open(const std::string& path, size_t capacityRecords) {
+    close();
+    if (capacityRecords == 0) {
+        return false;
+    }
+
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        __android_log_print(ANDROID_LOG_ERROR, TAG,
+            "open: 无法创建 %s: %s", path.c_str(), strerror(errno));
+        return false;
+    }
+
+    const size_t bytes = sizeof(CaptureFileHeader) + capacityRecords * sizeof(CaptureRecord);
+    // 预分配磁盘块，避免写入映射页时因空间不足触发 SIGBUS
+    int err = posix_fallocate(fd, 0, static_cast<off_t>(bytes));
+    if (err != 0) {
+        __android_log_print(ANDROID_LOG_ERROR, TAG,
+            "open: 预分配 %zu 字节失败: %s", bytes, strerror(err));
+        ::close(fd);
+        unlink(path.c_str());
+        return false;
+    }
+
+    void* mapping = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (mapping == MAP_FAILED) {
+        __android_log_print(ANDROID_LOG_ERROR, TAG,
+            "open: mmap 失败: %s", strerror(errno));
+        ::close(fd);
+        unlink(path.c_str());
+        return false;
+    }
+    // 预先触碰所有页，热路径上不再产生缺页
+    madvise(mapping, bytes, MADV_WILLNEED);
+    const long pageSize = sysconf(_SC_PAGESIZE);
+    for (size_t offset = 0; offset < bytes; offset += static_cast<size_t>(pageSize)) {
+        static_cast<volatile uint8_t*>(mapping)[offset] = 0;
+    }
+
+    header_ = static_cast<CaptureFileHeader*>(mapping);
+    std::memset(header_, 0, sizeof(CaptureFileHeader));
+    std::memcpy(header_->magic, CAPTURE_FILE_MAGIC, sizeof(CAPTURE_FILE_MAGIC));
+    header_->version = CAPTURE_FILE_VERSION;
+    header_->headerSize = sizeof(CaptureFileHeader);
+    header_->recordSize = sizeof(CaptureRecord);
+    header_->capacityRecords = capacityRecords;
+
+    records_ = reinterpret_cast<CaptureRecord*>(static_cast<uint8_t*>(mapping) + sizeof(CaptureFileHeader));
+    fd_ = fd;
+    mappedBytes_ = bytes;
+    capacity_ = capacityRecords;
+    nextIndex_ = 0;
+    path_ = path;
+
+    __android_log_print(ANDROID_LOG_INFO, TAG,
+        "开始捕获: %s, 容量 %zu 条 (%zu 字节)", path.c_str(), capacityRecords, bytes);
+    return true;
+}
+
+uint64_t EventCaptureWriter::close() {
+    if (!header_) {
+        return 0;
+    }
+    const uint64_t count = nextIndex_;
+    const uint64_t dropped = header_->droppedRecords;
+    munmap(header_, mappedBytes_);
+    if (ftruncate(fd_, static_cast<off_t>(sizeof(CaptureFileHeader) + count * sizeof(CaptureRecord))) != 0) {
+        __android_log_print(ANDROID_LOG_WARN, TAG,
+            "close: 截断 %s 失败: %s", path_.c_str(), strerror(errno));
+    }
+    ::close(fd_);
+
+    __android_log_print(ANDROID_LOG_INFO, TAG,
+        "停止捕获: %s, 记录 %llu 条, 丢弃 %llu 条", path_.c_str(),
+        (unsigned long long)count, (unsigned long long)dropped);
+
+    fd_ = -1;
+    mappedBytes_ = 0;
+    header_ = nullptr;
+    records_ = nullptr;
+    capacity_ = 0;
+    nextIndex_ = 0;
+    path_.clear();
+    return count;
+}
+
+void EventCaptureWriter::setDeviceAxes(uint16_t deviceTag, const CaptureDeviceAxes& axes) {
+    if (header_ && deviceTag < CAPTURE_MAX_DEVICES) {
+        header_->devices[deviceTag] = axes;
+    }
+}
+
+EventCaptureReader::~EventCaptureReader() {
+    close();
+}
+
+bool EventCaptureReader::open(const std::string& path) {
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        __android_log_print(ANDROID_LOG_ERROR, TAG,
+            "open: 无法打开 %s: %s", path.c_str(), strerror(errno));
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(CaptureFileHeader)) {
+        __android_log_print(ANDROID_LOG_ERROR, TAG, "open: %s 不是有效的捕获文件", path.c_str());
+        ::close(fd);
+        return false;
+    }
+    const size_t bytes = static_cast<size_t>(st.st_size);
+    void* mapping = mmap(nullptr, bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        __android_log_print(ANDROID_LOG_ERROR, TAG, "open: mmap 失败: %s", strerror(errno));
+        return false;
+    }
+
+    const auto* header = static_cast<const CaptureFileHeader*>(mapping);
+    if (std::memcmp(header->magic, CAPTURE_FILE_MAGIC, sizeof(CAPTURE_FILE_MAGIC)) != 0
+        || header->version != CAPTURE_FILE_VERSION
+        || header->recordSize != sizeof(CaptureRecord)
+        || header->headerSize < sizeof(CaptureFileHeader)
+        || header->headerSize > bytes) {
+        __android_log_print(ANDROID_LOG_ERROR, TAG, "open: %s 头部无效", path.c_str());
+        munmap(mapping, bytes);
+        return false;
+    }
+
+    // 以文件实际大小为上限，兼容未正常关闭（未截断）的捕获文件
+    const uint64_t available = (bytes - header->headerSize) / sizeof(CaptureRecord);
+    const uint64_t published = __atomic_load_n(&header->recordCount, __ATOMIC_ACQUIRE);
+
+    mapping_ = mapping;
+    mappedBytes_ = bytes;
+    header_ = header;
+    records_ = reinterpret_cast<const CaptureRecord*>(static_cast<const uint8_t*>(mapping) + header->headerSize);
+    recordCount_ = published < available ? published : available;
+    return true;
+}
+
+void EventCaptureReader::close() {
+    if (mapping_) {
+        munmap(mapping_, mappedBytes_);
+    }
+    mapping_ = nullptr;
+    mappedBytes_ = 0;
+    header_ = nullptr;
+    records_ = nullptr;
+    recordCount_ = 0;
+}
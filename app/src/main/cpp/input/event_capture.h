@@ -0,0 +1,159 @@
+#ifndef EVENT_CAPTURE_H
+#define EVENT_CAPTURE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include <linux/input.h>
+
+/**
+ * 原始 evdev 捕获文件格式（小端，与 Android/x86 主机一致）：
+ *
+ *   CaptureFileHeader (128 字节)
+ *   CaptureRecord[capacityRecords] (每条 32 字节)
+ *
+ * 文件在开始捕获时按容量预分配并 mmap，写入路径只有 memcpy 与一次原子计数更新，
+ * 没有系统调用。停止时截断到实际记录数。
+ */
+
+static constexpr char CAPTURE_FILE_MAGIC[8] = {'L', 'L', 'I', 'C', 'A', 'P', '1', '\0'};
+static constexpr uint32_t CAPTURE_FILE_VERSION = 1;
+static constexpr int CAPTURE_MAX_DEVICES = 4;
+
+// 设备标签：区分同一捕获文件中来自不同设备的事件
+static constexpr uint16_t CAPTURE_DEVICE_TOUCH = 0;
+static constexpr uint16_t CAPTURE_DEVICE_PEN = 1;   // 独立的笔设备（触摸设备上的笔事件仍记为 TOUCH）
+static constexpr uint16_t CAPTURE_DEVICE_HID_BASE = 0x100; // 外接输入设备：0x100 + 设备编号（不记录坐标范围）
+
+/**
+ * @brief 设备坐标范围（回放时用于坐标转换）
+ */
+struct CaptureDeviceAxes {
+    int32_t maxX;
+    int32_t maxY;
+};
+
+struct CaptureFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t headerSize;
+    uint32_t recordSize;
+    uint32_t reserved0;
+    uint64_t capacityRecords;
+    uint64_t recordCount;      // 写入方以 release 语义发布
+    uint64_t droppedRecords;   // 容量用尽后丢弃的事件数
+    CaptureDeviceAxes devices[CAPTURE_MAX_DEVICES];
+    uint8_t reserved1[128 - 48 - 8 * CAPTURE_MAX_DEVICES];
+};
+static_assert(sizeof(CaptureFileHeader) == 128, "CaptureFileHeader 必须为 128 字节");
+
+/**
+ * @brief 一条原始事件
+ */
+struct CaptureRecord {
+    int64_t readTimeNs;     // read() 完成时的 CLOCK_MONOTONIC 时间
+    int64_t eventTimeUs;    // input_event.time（内核时钟，通常为 CLOCK_REALTIME）
+    uint16_t deviceTag;
+    uint16_t type;
+    uint16_t code;
+    uint16_t reserved;
+    int32_t value;
+    uint32_t reserved2;
+};
+static_assert(sizeof(CaptureRecord) == 32, "CaptureRecord 必须为 32 字节");
+
+/**
+ * @brief 捕获写入端。open 在控制线程调用，append 只在读取线程调用；
+ *        交给引擎后由最后一个持有者析构时关闭（引擎不再引用它之后）。
+ */
+class EventCaptureWriter {
+public:
+    EventCaptureWriter() = default;
+    ~EventCaptureWriter();
+
+    EventCaptureWriter(const EventCaptureWriter&) = delete;
+    EventCaptureWriter& operator=(const EventCaptureWriter&) = delete;
+
+    /**
+     * @brief 创建并预分配捕获文件
+     * @param capacityRecords 最多记录的事件数
+     */
+    bool open(const std::string& path, size_t capacityRecords);
+
+    /**
+     * @brief 截断到实际大小并解除映射
+     * @return 写入的记录数
+     */
+    uint64_t close();
+
+    bool isOpen() const { return header_ != nullptr; }
+
+    uint64_t recordCount() const {
+        return header_ ? __atomic_load_n(&header_->recordCount, __ATOMIC_ACQUIRE) : 0;
+    }
+
+    /**
+     * @brief 记录设备坐标范围（设备打开后调用）
+     */
+    void setDeviceAxes(uint16_t deviceTag, const CaptureDeviceAxes& axes);
+
+    /**
+     * @brief 追加一条事件，容量用尽时只计数丢弃
+     */
+    inline void append(uint16_t deviceTag, int64_t readTimeNs, const struct input_event& ev) {
+        const uint64_t index = nextIndex_;
+        if (index >= capacity_) {
+            __atomic_store_n(&header_->droppedRecords, header_->droppedRecords + 1, __ATOMIC_RELAXED);
+            return;
+        }
+        CaptureRecord& record = records_[index];
+        record.readTimeNs = readTimeNs;
+        record.eventTimeUs = static_cast<int64_t>(ev.time.tv_sec) * 1000000 + ev.time.tv_usec;
+        record.deviceTag = deviceTag;
+        record.type = ev.type;
+        record.code = ev.code;
+        record.reserved = 0;
+        record.value = ev.value;
+        record.reserved2 = 0;
+        nextIndex_ = index + 1;
+        __atomic_store_n(&header_->recordCount, nextIndex_, __ATOMIC_RELEASE);
+    }
+
+private:
+    int fd_ = -1;
+    size_t mappedBytes_ = 0;
+    CaptureFileHeader* header_ = nullptr;
+    CaptureRecord* records_ = nullptr;
+    uint64_t capacity_ = 0;
+    uint64_t nextIndex_ = 0;
+    std::string path_;
+};
+
+/**
+ * @brief 只读打开捕获文件
+ */
+class EventCaptureReader {
+public:
+    EventCaptureReader() = default;
+    ~EventCaptureReader();
+
+    EventCaptureReader(const EventCaptureReader&) = delete;
+    EventCaptureReader& operator=(const EventCaptureReader&) = delete;
+
+    bool open(const std::string& path);
+    void close();
+
+    const CaptureFileHeader* header() const { return header_; }
+    const CaptureRecord* records() const { return records_; }
+    uint64_t recordCount() const { return recordCount_; }
+
+private:
+    void* mapping_ = nullptr;
+    size_t mappedBytes_ = 0;
+    const CaptureFileHeader* header_ = nullptr;
+    const CaptureRecord* records_ = nullptr;
+    uint64_t recordCount_ = 0;
+};
+
+#endif // EVENT_CAPTURE_H
@@ -0,0 +1,185 @@
+#include "event_replay.h"
+#include "input_engine.h"
+
+#include <android/log.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <unistd.h>
+
+// 日志标签
+#define TAG "NativeEventReplay"
+
+namespace {
+
+constexpr size_t REPLAY_BATCH_EVENTS = 64;
+// stop() 最长等待时间：睡眠与阻塞写入都按此粒度检查停止标志
+constexpr int64_t STOP_POLL_NS = 50LL * 1000 * 1000;
+
+int64_t clockNowNs(clockid_t clock) {
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+} // namespace
+
+EventReplayer::~EventReplayer() {
+    stop();
+}
+
+bool EventReplayer::start(const std::string& capturePath, InputEngine& engine, const ReplayOptions& options) {
+    stop();
+    if (!reader_.open(capturePath)) {
+        return false;
+    }
+
+    int fds[2];
+    if (pipe2(fds, O_CLOEXEC) != 0) {
+        __android_log_print(ANDROID_LOG_ERROR, TAG, "start: pipe2 失败: %s", strerror(errno));
+        reader_.close();
+        return false;
+    }
+    // 读端与真实设备一样非阻塞；写端同样非阻塞，由 poll 等待可写以便响应 stop()
+    fcntl(fds[0], F_SETFL, fcntl(fds[0], F_GETFL) | O_NONBLOCK);
+    fcntl(fds[1], F_SETFL, fcntl(fds[1], F_GETFL) | O_NONBLOCK);
+    writeFd_ = fds[1];
+    options_ = options;
+    replayedEvents_.store(0, std::memory_order_relaxed);
+
+    const CaptureDeviceAxes& axes = reader_.header()->devices[CAPTURE_DEVICE_TOUCH];
+    engine.setDeviceFd(fds[0], axes.maxX, axes.maxY);
+
+    running_.store(true, std::memory_order_release);
+    thread_ = std::thread(&EventReplayer::replayLoop, this);
+
+    __android_log_print(ANDROID_LOG_INFO, TAG,
+        "开始回放: %s, %llu 条记录, %s", capturePath.c_str(),
+        (unsigned long long)reader_.recordCount(),
+        options.originalTiming ? "原始节奏" : "尽快");
+    return true;
+}
+
+void EventReplayer::stop() {
+    running_.store(false, std::memory_order_release);
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    if (writeFd_ >= 0) {
+        close(writeFd_);
+        writeFd_ = -1;
+    }
+    reader_.close();
+}
+
+/**
+ * @brief 回放线程：按 readTimeNs 分组，组内事件一次写出
+ */
+void EventReplayer::replayLoop() {
+    // 引擎停止后读端被关闭，写入应返回 EPIPE 而不是以 SIGPIPE 终止进程
+    sigset_t pipeMask;
+    sigemptyset(&pipeMask);
+    sigaddset(&pipeMask, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &pipeMask, nullptr);
+
+    const CaptureRecord* records = reader_.records();
+    const uint64_t count = reader_.recordCount();
+
+    int64_t firstReadNs = 0;
+    int64_t eventTimeShiftUs = 0;
+    bool haveFirst = false;
+    const int64_t startNs = clockNowNs(CLOCK_MONOTONIC);
+
+    struct input_event batch[REPLAY_BATCH_EVENTS];
+    uint64_t index = 0;
+    while (index < count && running_.load(std::memory_order_acquire)) {
+        if (records[index].deviceTag != CAPTURE_DEVICE_TOUCH) {
+            ++index;
+            continue;
+        }
+        const int64_t groupReadNs = records[index].readTimeNs;
+        if (!haveFirst) {
+            haveFirst = true;
+            firstReadNs = groupReadNs;
+            if (options_.rebaseEventTime) {
+                eventTimeShiftUs = clockNowNs(CLOCK_REALTIME) / 1000 - records[index].eventTimeUs;
+            }
+        }
+
+        size_t batchCount = 0;
+        while (index < count && batchCount < REPLAY_BATCH_EVENTS
+               && records[index].readTimeNs == groupReadNs) {
+            const CaptureRecord& record = records[index++];
+            if (record.deviceTag != CAPTURE_DEVICE_TOUCH) {
+                continue;
+            }
+            struct input_event& ev = batch[batchCount++];
+            std::memset(&ev, 0, sizeof(ev));
+            const int64_t eventUs = record.eventTimeUs + eventTimeShiftUs;
+            ev.time.tv_sec = static_cast<decltype(ev.time.tv_sec)>(eventUs / 1000000);
+            ev.time.tv_usec = static_cast<decltype(ev.time.tv_usec)>(eventUs % 1000000);
+            ev.type = record.type;
+            ev.code = record.code;
+            ev.value = record.value;
+        }
+
+        if (options_.originalTiming) {
+            const int64_t targetNs = startNs + (groupReadNs - firstReadNs);
+            int64_t nowNs = clockNowNs(CLOCK_MONOTONIC);
+            while (nowNs < targetNs && running_.load(std::memory_order_acquire)) {
+                const int64_t wakeNs = std::min(targetNs, nowNs + STOP_POLL_NS);
+                struct timespec ts;
+                ts.tv_sec = static_cast<time_t>(wakeNs / 1000000000LL);
+                ts.tv_nsec = static_cast<long>(wakeNs % 1000000000LL);
+                clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr);
+                nowNs = clockNowNs(CLOCK_MONOTONIC);
+            }
+        }
+
+        if (!writeBatch(reinterpret_cast<const uint8_t*>(batch), batchCount * sizeof(struct input_event))) {
+            break;
+        }
+        replayedEvents_.fetch_add(batchCount, std::memory_order_relaxed);
+    }
+
+    __android_log_print(ANDROID_LOG_INFO, TAG,
+        "回放结束: 已写入 %llu 个事件", (unsigned long long)replayedEvents_.load());
+
+    // 关闭写端，引擎读到 EOF 后回到真实设备
+    close(writeFd_);
+    writeFd_ = -1;
+    running_.store(false, std::memory_order_release);
+}
+
+bool EventReplayer::writeBatch(const uint8_t* data, size_t length) {
+    size_t written = 0;
+    while (written < length) {
+        ssize_t n = write(writeFd_, data + written, length - written);
+        if (n >= 0) {
+            written += static_cast<size_t>(n);
+            continue;
+        }
+        if (errno == EINTR) {
+            continue;
+        }
+        if (errno != EAGAIN) {
+            __android_log_print(ANDROID_LOG_WARN, TAG, "写入管道失败: %s", strerror(errno));
+            return false;
+        }
+        // 管道已满：引擎处理跟不上（尽快模式），等待可写或停止
+        if (!running_.load(std::memory_order_acquire)) {
+            return false;
+        }
+        struct pollfd pfd;
+        pfd.fd = writeFd_;
+        pfd.events = POLLOUT;
+        pfd.revents = 0;
+        poll(&pfd, 1, static_cast<int>(STOP_POLL_NS / 1000000));
+    }
+    return true;
+}
@@ -0,0 +1,54 @@
+#ifndef EVENT_REPLAY_H
+#define EVENT_REPLAY_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+
+#include "event_capture.h"
+
+class InputEngine;
+
+/**
+ * @brief 回放参数
+ */
+struct ReplayOptions {
+    bool originalTiming = true;   // true: 按捕获时 read() 的间隔回放；false: 尽快回放
+    bool rebaseEventTime = true;  // 把 input_event.time 平移到当前时间，下游看到的时间戳连续
+};
+
+/**
+ * @brief 把捕获文件中的触摸事件经管道喂回输入引擎
+ *
+ * 引擎通过 setDeviceFd 读取管道读端，处理路径与真实设备完全相同；
+ * 同一次 read() 捕获到的事件作为一次 write() 写入，保留批次边界。
+ * 回放结束或 stop() 时关闭写端，引擎读到 EOF 后自动回到真实设备。
+ */
+class EventReplayer {
+public:
+    EventReplayer() = default;
+    ~EventReplayer();
+
+    EventReplayer(const EventReplayer&) = delete;
+    EventReplayer& operator=(const EventReplayer&) = delete;
+
+    bool start(const std::string& capturePath, InputEngine& engine, const ReplayOptions& options);
+    void stop();
+
+    bool isRunning() const { return running_.load(std::memory_order_acquire); }
+    uint64_t replayedEvents() const { return replayedEvents_.load(std::memory_order_relaxed); }
+
+private:
+    void replayLoop();
+    bool writeBatch(const uint8_t* data, size_t length);
+
+    EventCaptureReader reader_;
+    ReplayOptions options_;
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+    std::atomic<uint64_t> replayedEvents_{0};
+    int writeFd_ = -1;
+};
+
+#endif // EVENT_REPLAY_H
@@ -0,0 +1,304 @@
+#include "gesture_recognizer.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace {
+
+/**
+ * @brief 区域 JSON 中的手势名称表
+ */
+struct GestureName {
+    const char* name;
+    uint32_t mask;
+};
+
+constexpr GestureName kGestureNames[] = {
+    {"doubleTap", GESTURE_MASK_DOUBLE_TAP},
+    {"swipe", GESTURE_MASK_SWIPE},
+    {"chord2", GESTURE_MASK_CHORD_2},
+    {"chord3", GESTURE_MASK_CHORD_3},
+    {"holdDrag", GESTURE_MASK_HOLD_DRAG},
+};
+
+inline long long distanceSquared(int x0, int y0, int x1, int y1) {
+    const long long dx = x1 - x0;
+    const long long dy = y1 - y0;
+    return dx * dx + dy * dy;
+}
+
+inline bool within(int x0, int y0, int x1, int y1, int radius) {
+    return distanceSquared(x0, y0, x1, y1) <= static_cast<long long>(radius) * radius;
+}
+
+SwipeDirection directionOf(int dx, int dy) {
+    if (std::abs(dx) >= std::abs(dy)) {
+        return dx < 0 ? SwipeDirection::Left : SwipeDirection::Right;
+    }
+    // 屏幕坐标 y 向下增长
+    return dy < 0 ? SwipeDirection::Up : SwipeDirection::Down;
+}
+
+} // namespace
+
+uint32_t gestureMaskFromName(const std::string& name) {
+    for (const auto& entry : kGestureNames) {
+        if (name == entry.name) {
+            return entry.mask;
+        }
+    }
+    return 0;
+}
+
+void GestureRecognizer::setRegions(std::vector<GestureRegion> regions) {
+    regions_ = std::move(regions);
+    anyGestures_ = std::any_of(regions_.begin(), regions_.end(),
+        [](const GestureRegion& region) { return region.gestureMask != 0; });
+    reset();
+}
+
+void GestureRecognizer::reset() {
+    regionStates_.assign(regions_.size(), RegionState());
+    for (auto& contact : contacts_) {
+        contact = ContactState();
+    }
+}
+
+bool GestureRecognizer::inside(const GestureRegion& region, int x, int y) {
+    return x >= region.left && x < region.left + region.width
+        && y >= region.top && y < region.top + region.height;
+}
+
+void GestureRecognizer::emitChord(int regionIndex, int fingers, long long nowMs,
+                                  std::vector<RegionGesture>& out) {
+    RegionState& state = regionStates_[regionIndex];
+    state.chordPending = false;
+    state.chordEmitted = true;
+
+    // 位置取参与和弦的手指的中心
+    int sumX = 0;
+    int sumY = 0;
+    int count = 0;
+    for (const auto& contact : contacts_) {
+        if (contact.active && contact.regionIndex == regionIndex && contact.partOfChord) {
+            sumX += contact.lastX;
+            sumY += contact.lastY;
+            ++count;
+        }
+    }
+    GestureEvent event;
+    event.kind = GestureKind::Chord;
+    event.fingers = static_cast<uint8_t>(fingers);
+    event.x = count > 0 ? sumX / count : 0;
+    event.y = count > 0 ? sumY / count : 0;
+    event.timestampMs = nowMs;
+    out.push_back(RegionGesture{regionIndex, event});
+}
+
+void GestureRecognizer::onContactDown(int contactIndex, int regionIndex, int x, int y, long long nowMs,
+                                      std::vector<RegionGesture>& out) {
+    if (contactIndex < 0 || contactIndex >= MAX_CONTACTS) {
+        return;
+    }
+    ContactState& contact = contacts_[contactIndex];
+    contact = ContactState();
+    if (regionIndex < 0 || regionIndex >= static_cast<int>(regions_.size())) {
+        return;
+    }
+    const uint32_t mask = regions_[regionIndex].gestureMask;
+    if (mask == 0) {
+        return;
+    }
+    contact.active = true;
+    contact.regionIndex = regionIndex;
+    contact.downX = contact.lastX = x;
+    contact.downY = contact.lastY = y;
+    contact.downMs = nowMs;
+
+    RegionState& state = regionStates_[regionIndex];
+
+    if (mask & GESTURE_MASK_DOUBLE_TAP) {
+        if (state.lastTapUpMs >= 0 && nowMs - state.lastTapUpMs <= thresholds_.doubleTapWindowMs
+            && within(state.lastTapX, state.lastTapY, x, y, thresholds_.doubleTapSlopPx)) {
+            GestureEvent event;
+            event.kind = GestureKind::DoubleTap;
+            event.x = x;
+            event.y = y;
+            event.dx = x - state.lastTapX;
+            event.dy = y - state.lastTapY;
+            event.timestampMs = nowMs;
+            out.push_back(RegionGesture{regionIndex, event});
+            state.lastTapUpMs = -1;
+            contact.swiped = true; // 本次按下已被双击消费，不再参与其他单指手势
+            return;
+        }
+    }
+
+    if (mask & (GESTURE_MASK_CHORD_2 | GESTURE_MASK_CHORD_3)) {
+        if (state.chordFingers == 0 || nowMs - state.chordStartMs > thresholds_.chordWindowMs) {
+            state.chordStartMs = nowMs;
+            state.chordFingers = 1;
+            state.chordPending = false;
+            state.chordEmitted = false;
+            return;
+        }
+        ++state.chordFingers;
+        // 窗口内落下的所有手指都属于和弦，不再作为点击 / 滑出 / 拖动
+        for (auto& other : contacts_) {
+            if (other.active && other.regionIndex == regionIndex) {
+                other.partOfChord = true;
+            }
+        }
+        if (state.chordEmitted) {
+            return;
+        }
+        if (state.chordFingers == 2) {
+            if (mask & GESTURE_MASK_CHORD_3) {
+                // 可能还有第三根手指，等窗口结束或有手指抬起再结算
+                state.chordPending = (mask & GESTURE_MASK_CHORD_2) != 0;
+            } else {
+                emitChord(regionIndex, 2, nowMs, out);
+            }
+        } else if (state.chordFingers == 3 && (mask & GESTURE_MASK_CHORD_3)) {
+            emitChord(regionIndex, 3, nowMs, out);
+        }
+    }
+}
+
+void GestureRecognizer::onContactMove(int contactIndex, int x, int y, long long nowMs,
+                                      std::vector<RegionGesture>& out) {
+    if (contactIndex < 0 || contactIndex >= MAX_CONTACTS) {
+        return;
+    }
+    ContactState& contact = contacts_[contactIndex];
+    if (!contact.active || (x == contact.lastX && y == contact.lastY)) {
+        return;
+    }
+    contact.lastX = x;
+    contact.lastY = y;
+    if (contact.partOfChord || contact.swiped) {
+        return;
+    }
+
+    const GestureRegion& region = regions_[contact.regionIndex];
+    const long long elapsedMs = nowMs - contact.downMs;
+    const int dx = x - contact.downX;
+    const int dy = y - contact.downY;
+
+    if (region.gestureMask & GESTURE_MASK_HOLD_DRAG) {
+        if (contact.dragging) {
+            GestureEvent event;
+            event.kind = GestureKind::HoldDragMove;
+            event.x = x;
+            event.y = y;
+            event.dx = dx;
+            event.dy = dy;
+            event.timestampMs = nowMs;
+            out.push_back(RegionGesture{contact.regionIndex, event});
+            return;
+        }
+        if (elapsedMs < thresholds_.holdDelayMs) {
+            if (!within(contact.downX, contact.downY, x, y, thresholds_.holdSlopPx)) {
+                contact.movedBeforeHold = true;
+            }
+        } else if (!contact.movedBeforeHold) {
+            if (!within(contact.downX, contact.downY, x, y, thresholds_.dragStartPx)) {
+                contact.dragging = true;
+                GestureEvent event;
+                event.kind = GestureKind::HoldDragStart;
+                event.x = x;
+                event.y = y;
+                event.dx = dx;
+                event.dy = dy;
+                event.timestampMs = nowMs;
+                out.push_back(RegionGesture{contact.regionIndex, event});
+            }
+            // 已静止按住：属于拖动而非滑出
+            return;
+        }
+    }
+
+    if ((region.gestureMask & GESTURE_MASK_SWIPE) && elapsedMs <= thresholds_.swipeMaxDurationMs
+        && !inside(region, x, y)
+        && !within(contact.downX, contact.downY, x, y, thresholds_.swipeMinDistancePx)) {
+        contact.swiped = true;
+        GestureEvent event;
+        event.kind = GestureKind::Swipe;
+        event.direction = directionOf(dx, dy);
+        event.x = x;
+        event.y = y;
+        event.dx = dx;
+        event.dy = dy;
+        event.timestampMs = nowMs;
+        out.push_back(RegionGesture{contact.regionIndex, event});
+    }
+}
+
+void GestureRecognizer::onContactUp(int contactIndex, long long nowMs, std::vector<RegionGesture>& out) {
+    if (contactIndex < 0 || contactIndex >= MAX_CONTACTS) {
+        return;
+    }
+    ContactState& contact = contacts_[contactIndex];
+    if (!contact.active) {
+        return;
+    }
+    RegionState& state = regionStates_[contact.regionIndex];
+    const uint32_t mask = regions_[contact.regionIndex].gestureMask;
+
+    if (state.chordPending) {
+        // 有手指抬起，不会再出现第三根手指
+        emitChord(contact.regionIndex, 2, nowMs, out);
+    }
+
+    if (contact.dragging) {
+        GestureEvent event;
+        event.kind = GestureKind::HoldDragEnd;
+        event.x = contact.lastX;
+        event.y = contact.lastY;
+        event.dx = contact.lastX - contact.downX;
+        event.dy = contact.lastY - contact.downY;
+        event.timestampMs = nowMs;
+        out.push_back(RegionGesture{contact.regionIndex, event});
+    } else if ((mask & GESTURE_MASK_DOUBLE_TAP) && !contact.partOfChord && !contact.swiped
+               && nowMs - contact.downMs <= thresholds_.tapMaxDurationMs
+               && within(contact.downX, contact.downY, contact.lastX, contact.lastY, thresholds_.holdSlopPx)) {
+        state.lastTapUpMs = nowMs;
+        state.lastTapX = contact.downX;
+        state.lastTapY = contact.downY;
+    }
+
+    contact.active = false;
+    bool anyInRegion = false;
+    for (const auto& other : contacts_) {
+        if (other.active && other.regionIndex == contact.regionIndex) {
+            anyInRegion = true;
+            break;
+        }
+    }
+    if (!anyInRegion) {
+        state.chordFingers = 0;
+        state.chordPending = false;
+    }
+}
+
+void GestureRecognizer::onTimer(long long nowMs, std::vector<RegionGesture>& out) {
+    for (size_t i = 0; i < regionStates_.size(); ++i) {
+        RegionState& state = regionStates_[i];
+        if (state.chordPending && nowMs - state.chordStartMs >= thresholds_.chordWindowMs) {
+            emitChord(static_cast<int>(i), 2, nowMs, out);
+        }
+    }
+}
+
+long long GestureRecognizer::nextDeadlineMs() const {
+    long long nearest = -1;
+    for (const auto& state : regionStates_) {
+        if (state.chordPending) {
+            const long long deadline = state.chordStartMs + thresholds_.chordWindowMs;
+            if (nearest < 0 || deadline < nearest) {
+                nearest = deadline;
+            }
+        }
+    }
+    return nearest;
+}
@@ -0,0 +1,171 @@
+#ifndef GESTURE_RECOGNIZER_H
+#define GESTURE_RECOGNIZER_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * 区域手势识别。
+ *
+ * 每个区域在表中登记启用的手势（位掩码）与矩形；识别器只接收屏幕坐标下的
+ * 按下 / 移动 / 抬起与定时器回调，在手势变得无歧义的那一刻输出紧凑的手势事件：
+ *   - 双击：第二次按下落在上次点击的时间窗与距离内时立即输出
+ *   - 滑出：从区域内按下、在限定时间内移出区域且位移足够时输出，附带方向
+ *   - 多指和弦：时间窗内第 N 根手指落在同一区域；若同时启用三指，二指要等窗口结束
+ *   - 按住拖动：静止按住超过延迟后移动超过阈值开始，之后每帧输出移动，抬起时结束
+ *
+ * 本模块不依赖 Android 与 evdev，可在 Linux 主机上用记录的轨迹测试。
+ */
+
+// 区域启用的手势（ClickableRegion::gestureMask）
+static constexpr uint32_t GESTURE_MASK_DOUBLE_TAP = 1u << 0;
+static constexpr uint32_t GESTURE_MASK_SWIPE = 1u << 1;
+static constexpr uint32_t GESTURE_MASK_CHORD_2 = 1u << 2;
+static constexpr uint32_t GESTURE_MASK_CHORD_3 = 1u << 3;
+static constexpr uint32_t GESTURE_MASK_HOLD_DRAG = 1u << 4;
+
+/**
+ * @brief 把区域 JSON 中的手势名（"doubleTap", "swipe", "chord2", "chord3", "holdDrag"）转换为掩码位
+ * @return 未知名称返回 0
+ */
+uint32_t gestureMaskFromName(const std::string& name);
+
+enum class GestureKind : uint8_t {
+    DoubleTap = 1,
+    Swipe = 2,
+    Chord = 3,
+    HoldDragStart = 4,
+    HoldDragMove = 5,
+    HoldDragEnd = 6,
+};
+
+enum class SwipeDirection : uint8_t {
+    None = 0,
+    Left = 1,
+    Right = 2,
+    Up = 3,
+    Down = 4,
+};
+
+/**
+ * @brief 一个手势事件
+ */
+struct GestureEvent {
+    GestureKind kind = GestureKind::DoubleTap;
+    uint8_t fingers = 1;                      // 和弦手指数，其他手势为 1
+    SwipeDirection direction = SwipeDirection::None;
+    int x = 0;                                // 当前（或触发时）位置
+    int y = 0;
+    int dx = 0;                               // 相对按下位置的位移
+    int dy = 0;
+    long long timestampMs = 0;
+};
+
+/**
+ * @brief 识别阈值（所有区域共用）
+ */
+struct GestureThresholds {
+    long long doubleTapWindowMs = 250;   // 上次抬起到再次按下
+    int doubleTapSlopPx = 48;            // 两次按下位置的最大距离
+    long long tapMaxDurationMs = 200;    // 被视为"点击"的最长按住时间
+    int swipeMinDistancePx = 80;
+    long long swipeMaxDurationMs = 400;
+    long long chordWindowMs = 80;        // 第一根到最后一根手指落下的最长间隔
+    long long holdDelayMs = 150;         // 与长按开始延迟一致
+    int holdSlopPx = 16;                 // 按住期间允许的抖动
+    int dragStartPx = 24;                // 按住后开始拖动所需位移
+};
+
+/**
+ * @brief 识别器看到的区域
+ */
+struct GestureRegion {
+    int left = 0;
+    int top = 0;
+    int width = 0;
+    int height = 0;
+    uint32_t gestureMask = 0;
+};
+
+/**
+ * @brief 识别出的手势及其所属区域（GestureRecognizer::setRegions 时的下标）
+ */
+struct RegionGesture {
+    int regionIndex;
+    GestureEvent event;
+};
+
+class GestureRecognizer {
+public:
+    static constexpr int MAX_CONTACTS = 64;
+
+    void setThresholds(const GestureThresholds& thresholds) { thresholds_ = thresholds; }
+    const GestureThresholds& thresholds() const { return thresholds_; }
+
+    /**
+     * @brief 替换区域表并清空所有状态
+     */
+    void setRegions(std::vector<GestureRegion> regions);
+
+    bool hasGestureRegions() const { return anyGestures_; }
+
+    /**
+     * @brief 清空所有接触点与区域状态（设备切换、同步丢失等）
+     */
+    void reset();
+
+    /**
+     * @brief 一个接触点在区域 regionIndex 内按下；regionIndex < 0 表示未命中区域（忽略）
+     */
+    void onContactDown(int contact, int regionIndex, int x, int y, long long nowMs,
+                       std::vector<RegionGesture>& out);
+    void onContactMove(int contact, int x, int y, long long nowMs, std::vector<RegionGesture>& out);
+    void onContactUp(int contact, long long nowMs, std::vector<RegionGesture>& out);
+
+    /**
+     * @brief 到达 nextDeadlineMs() 时调用，结算等待中的二指和弦
+     */
+    void onTimer(long long nowMs, std::vector<RegionGesture>& out);
+
+    /**
+     * @brief 最近一个需要 onTimer 的时间点，没有时返回 -1
+     */
+    long long nextDeadlineMs() const;
+
+private:
+    struct ContactState {
+        bool active = false;
+        int regionIndex = -1;
+        int downX = 0;
+        int downY = 0;
+        int lastX = 0;
+        int lastY = 0;
+        long long downMs = 0;
+        bool movedBeforeHold = false; // 按住延迟内移动超过 holdSlopPx
+        bool swiped = false;
+        bool dragging = false;
+        bool partOfChord = false;
+    };
+
+    struct RegionState {
+        long long lastTapUpMs = -1;
+        int lastTapX = 0;
+        int lastTapY = 0;
+        long long chordStartMs = 0;
+        int chordFingers = 0;         // 当前和弦窗口内落下的手指数
+        bool chordPending = false;    // 二指和弦等待窗口结束
+        bool chordEmitted = false;
+    };
+
+    static bool inside(const GestureRegion& region, int x, int y);
+    void emitChord(int regionIndex, int fingers, long long nowMs, std::vector<RegionGesture>& out);
+
+    GestureThresholds thresholds_;
+    std::vector<GestureRegion> regions_;
+    std::vector<RegionState> regionStates_;
+    ContactState contacts_[MAX_CONTACTS];
+    bool anyGestures_ = false;
+};
+
+#endif // GESTURE_RECOGNIZER_H
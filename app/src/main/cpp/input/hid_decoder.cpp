@@ -0,0 +1,258 @@
+#include "hid_decoder.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <sys/ioctl.h>
+
+namespace {
+
+constexpr int BITS_PER_WORD = sizeof(unsigned long) * 8;
+
+constexpr size_t bitWords(int bits) {
+    return (bits + BITS_PER_WORD - 1) / BITS_PER_WORD;
+}
+
+inline bool testBit(const unsigned long* bits, int bit) {
+    return (bits[bit / BITS_PER_WORD] >> (bit % BITS_PER_WORD)) & 1UL;
+}
+
+} // namespace
+
+HidDecoder::HidDecoder() {
+    pendingKeys_.reserve(HID_FRAME_MAX_CHANGES);
+}
+
+uint8_t HidDecoder::classify(int fd) {
+    unsigned long keyBits[bitWords(KEY_CNT)] = {};
+    unsigned long absBits[bitWords(ABS_CNT)] = {};
+    unsigned long relBits[bitWords(REL_CNT)] = {};
+    // 不支持的类型查询失败时保持全 0
+    ioctl(fd, EVIOCGBIT(EV_KEY, sizeof(keyBits)), keyBits);
+    ioctl(fd, EVIOCGBIT(EV_ABS, sizeof(absBits)), absBits);
+    ioctl(fd, EVIOCGBIT(EV_REL, sizeof(relBits)), relBits);
+
+    if (testBit(absBits, ABS_MT_POSITION_X) || testBit(keyBits, BTN_TOUCH) || testBit(keyBits, BTN_TOOL_PEN)) {
+        return 0;
+    }
+    uint8_t deviceClass = 0;
+    if (testBit(keyBits, BTN_GAMEPAD) || testBit(keyBits, BTN_JOYSTICK)) {
+        deviceClass |= HID_CLASS_GAMEPAD;
+    }
+    // 电源 / 音量等系统按键设备也报告 EV_KEY，以字母键是否齐全区分真正的键盘
+    if (testBit(keyBits, KEY_Q) && testBit(keyBits, KEY_A) && testBit(keyBits, KEY_Z)
+        && testBit(keyBits, KEY_SPACE) && testBit(keyBits, KEY_ENTER)) {
+        deviceClass |= HID_CLASS_KEYBOARD;
+    }
+    if (testBit(relBits, REL_X) && testBit(relBits, REL_Y) && testBit(keyBits, BTN_LEFT)) {
+        deviceClass |= HID_CLASS_MOUSE;
+    }
+    return deviceClass;
+}
+
+void HidDecoder::open(int fd, uint8_t deviceId, uint8_t deviceClass) {
+    configure(deviceId, deviceClass);
+    unsigned long absBits[bitWords(ABS_CNT)] = {};
+    ioctl(fd, EVIOCGBIT(EV_ABS, sizeof(absBits)), absBits);
+    // ABS_RX / ABS_RY 是右摇杆时 ABS_Z / ABS_RZ 为扳机 (xpad、hid-playstation)；
+    // 否则 (多数 DirectInput 手柄) ABS_Z / ABS_RZ 是右摇杆
+    const bool zIsTrigger = testBit(absBits, ABS_RX) && testBit(absBits, ABS_RY);
+    for (int code = 0; code < AXIS_COUNT; ++code) {
+        struct input_absinfo absinfo;
+        if (!testBit(absBits, code) || ioctl(fd, EVIOCGABS(code), &absinfo) != 0) {
+            continue;
+        }
+        const bool trigger = code == ABS_GAS || code == ABS_BRAKE || code == ABS_THROTTLE
+            || (zIsTrigger && (code == ABS_Z || code == ABS_RZ));
+        setAxisRange(code, absinfo.minimum, absinfo.maximum, absinfo.flat, trigger && absinfo.minimum >= 0);
+    }
+    resync(fd, HID_FRAME_ATTACHED);
+}
+
+void HidDecoder::configure(uint8_t deviceId, uint8_t deviceClass) {
+    deviceId_ = deviceId;
+    deviceClass_ = deviceClass;
+    for (auto& axis : axes_) {
+        axis = Axis();
+    }
+    reset();
+}
+
+void HidDecoder::setAxisRange(int code, int minimum, int maximum, int flat, bool unipolar) {
+    if (code < 0 || code >= AXIS_COUNT) {
+        return;
+    }
+    Axis& axis = axes_[code];
+    axis.present = true;
+    axis.unipolar = unipolar;
+    axis.minimum = minimum;
+    axis.maximum = maximum;
+    axis.flat = flat;
+}
+
+void HidDecoder::reset() {
+    keys_.reset();
+    pendingKeys_.clear();
+    for (auto& axis : axes_) {
+        axis.reported = axis.pending = 0;
+    }
+    dirtyAxes_ = 0;
+    std::fill(std::begin(relAccum_), std::end(relAccum_), 0);
+    dirtyRel_ = 0;
+    pendingFlags_ = 0;
+    syncDropped_ = false;
+}
+
+void HidDecoder::handleEvent(const struct input_event& ev) {
+    switch (ev.type) {
+    case EV_KEY:
+        // value=2 为内核自动重复，状态不变
+        if (ev.code < KEY_CNT && ev.value != 2) {
+            setKey(ev.code, ev.value != 0);
+        }
+        break;
+    case EV_ABS:
+        if (ev.code < AXIS_COUNT) {
+            setAxis(ev.code, normalize(axes_[ev.code], ev.value));
+        }
+        break;
+    case EV_REL:
+        if (ev.code < REL_CNT) {
+            relAccum_[ev.code] += ev.value;
+            dirtyRel_ |= 1u << ev.code;
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+void HidDecoder::setKey(int code, bool down) {
+    if (keys_.test(code) == down) {
+        return;
+    }
+    keys_.set(code, down);
+    HidChange change;
+    change.type = EV_KEY;
+    change.code = static_cast<uint16_t>(code);
+    change.value = down ? 1 : 0;
+    pendingKeys_.push_back(change);
+}
+
+void HidDecoder::setAxis(int code, int32_t normalized) {
+    axes_[code].pending = normalized;
+    dirtyAxes_ |= uint64_t(1) << code;
+}
+
+/**
+ * @brief 原始轴值 -> 归一化值。双向轴以范围中点为 0，单向轴以最小值为 0；
+ *        距静止位置不超过 flat 的值视为静止。范围未知时原样输出
+ */
+int32_t HidDecoder::normalize(const Axis& axis, int value) const {
+    if (!axis.present || axis.maximum <= axis.minimum) {
+        return value;
+    }
+    const long long span = static_cast<long long>(axis.maximum) - axis.minimum;
+    long long scaled;
+    if (axis.unipolar) {
+        const long long offset = static_cast<long long>(value) - axis.minimum;
+        if (offset <= axis.flat) {
+            return 0;
+        }
+        scaled = offset * HID_AXIS_MAX / span;
+        return static_cast<int32_t>(std::min<long long>(HID_AXIS_MAX, scaled));
+    }
+    // 以 2 倍值计算，避免奇数跨度的中点取整
+    const long long doubled = 2LL * value - axis.minimum - axis.maximum;
+    if (std::llabs(doubled) <= 2LL * axis.flat) {
+        return 0;
+    }
+    scaled = doubled * HID_AXIS_MAX / span;
+    return static_cast<int32_t>(std::max<long long>(-HID_AXIS_MAX, std::min<long long>(HID_AXIS_MAX, scaled)));
+}
+
+bool HidDecoder::resync(int fd, uint8_t flags) {
+    syncDropped_ = false;
+    unsigned long keyState[bitWords(KEY_CNT)] = {};
+    if (fd < 0 || ioctl(fd, EVIOCGKEY(sizeof(keyState)), keyState) < 0) {
+        return false;
+    }
+    for (int code = 0; code < KEY_CNT; ++code) {
+        setKey(code, testBit(keyState, code));
+    }
+    for (int code = 0; code < AXIS_COUNT; ++code) {
+        struct input_absinfo absinfo;
+        if (axes_[code].present && ioctl(fd, EVIOCGABS(code), &absinfo) == 0) {
+            setAxis(code, normalize(axes_[code], absinfo.value));
+        }
+    }
+    // 丢弃期间的相对位移无法恢复
+    std::fill(std::begin(relAccum_), std::end(relAccum_), 0);
+    dirtyRel_ = 0;
+    pendingFlags_ |= flags;
+    return true;
+}
+
+void HidDecoder::release() {
+    for (int code = 0; code < KEY_CNT; ++code) {
+        if (keys_.test(code)) {
+            setKey(code, false);
+        }
+    }
+    for (int code = 0; code < AXIS_COUNT; ++code) {
+        if (axes_[code].present) {
+            setAxis(code, 0);
+        }
+    }
+    std::fill(std::begin(relAccum_), std::end(relAccum_), 0);
+    dirtyRel_ = 0;
+    pendingFlags_ |= HID_FRAME_DETACHED;
+}
+
+bool HidDecoder::takeFrame(long long timestampUs, HidFrame& out) {
+    out.timestampUs = timestampUs;
+    out.deviceId = deviceId_;
+    out.deviceClass = deviceClass_;
+    out.count = 0;
+    // ATTACHED / RESYNC 随第一帧输出，DETACHED 随最后一帧输出
+    out.flags = pendingFlags_ & ~HID_FRAME_DETACHED;
+    pendingFlags_ &= HID_FRAME_DETACHED;
+
+    size_t keysTaken = 0;
+    while (keysTaken < pendingKeys_.size() && out.count < HID_FRAME_MAX_CHANGES) {
+        out.changes[out.count++] = pendingKeys_[keysTaken++];
+    }
+    pendingKeys_.erase(pendingKeys_.begin(), pendingKeys_.begin() + keysTaken);
+
+    while (dirtyAxes_ != 0 && out.count < HID_FRAME_MAX_CHANGES) {
+        const int code = __builtin_ctzll(dirtyAxes_);
+        dirtyAxes_ &= dirtyAxes_ - 1;
+        Axis& axis = axes_[code];
+        if (axis.pending == axis.reported) {
+            continue;
+        }
+        axis.reported = axis.pending;
+        HidChange& change = out.changes[out.count++];
+        change.type = EV_ABS;
+        change.code = static_cast<uint16_t>(code);
+        change.value = axis.pending;
+    }
+
+    while (dirtyRel_ != 0 && out.count < HID_FRAME_MAX_CHANGES) {
+        const int code = __builtin_ctz(dirtyRel_);
+        dirtyRel_ &= dirtyRel_ - 1;
+        if (relAccum_[code] == 0) {
+            continue;
+        }
+        HidChange& change = out.changes[out.count++];
+        change.type = EV_REL;
+        change.code = static_cast<uint16_t>(code);
+        change.value = relAccum_[code];
+        relAccum_[code] = 0;
+    }
+
+    if (pendingKeys_.empty() && dirtyAxes_ == 0 && dirtyRel_ == 0) {
+        out.flags |= pendingFlags_;
+        pendingFlags_ = 0;
+    }
+    return out.count > 0 || out.flags != 0;
+}
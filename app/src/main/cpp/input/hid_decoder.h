@@ -0,0 +1,150 @@
+#ifndef HID_DECODER_H
+#define HID_DECODER_H
+
+#include <bitset>
+#include <cstdint>
+#include <vector>
+
+#include <linux/input.h>
+
+/**
+ * 外接输入设备（手柄、键盘、鼠标）的 evdev 解码。
+ *
+ * 每个设备节点一个解码器。解码器记录按键 / 绝对轴 / 相对轴的变化，在 SYN_REPORT 时输出一帧
+ * 状态增量：按键只在按下 / 抬起时输出（内核自动重复 value=2 不输出，重复由接收端自己生成），
+ * 绝对轴按 input_absinfo 归一化并扣除 flat 死区后只在归一化值变化时输出，相对轴在帧内累加。
+ * 接收端从 ATTACHED 帧的完整状态开始叠加增量即可得到设备当前状态；设备移除时输出 DETACHED 帧，
+ * 抬起仍按下的键并让轴回到静止位置，避免接收端卡键。
+ *
+ * 本模块不依赖 Android，可在 Linux 主机上测试。
+ */
+
+// 设备类别（HidFrame::deviceClass，可组合）
+static constexpr uint8_t HID_CLASS_GAMEPAD = 0x01;  // BTN_GAMEPAD / BTN_JOYSTICK
+static constexpr uint8_t HID_CLASS_KEYBOARD = 0x02; // 字母键齐全
+static constexpr uint8_t HID_CLASS_MOUSE = 0x04;    // REL_X / REL_Y + BTN_LEFT
+
+// HidFrame::flags
+static constexpr uint8_t HID_FRAME_ATTACHED = 0x01; // 设备刚打开：changes 为完整的非静止状态
+static constexpr uint8_t HID_FRAME_DETACHED = 0x02; // 设备已移除：抬起所有键、轴回到静止位置
+static constexpr uint8_t HID_FRAME_RESYNC = 0x04;   // SYN_DROPPED 后按内核状态补齐，期间的相对位移已丢失
+
+static constexpr int HID_AXIS_MAX = 32767;          // 归一化轴：双向 [-32767, 32767]，单向（扳机）[0, 32767]
+static constexpr int HID_FRAME_MAX_CHANGES = 64;    // 单帧最多携带的变化，超出部分在同一时间戳的后续帧中输出
+
+/**
+ * @brief 一个状态变化
+ *
+ * type 为 EV_KEY / EV_ABS / EV_REL，code 为内核事件码；
+ * value: 按键 1 按下 / 0 抬起，绝对轴为归一化值，相对轴为本帧累加的位移。
+ */
+struct HidChange {
+    uint8_t type = 0;
+    uint16_t code = 0;
+    int32_t value = 0;
+};
+
+/**
+ * @brief 一个设备一帧 (SYN_REPORT) 的状态增量
+ */
+struct HidFrame {
+    long long timestampUs = 0; // 帧的内核时间戳
+    uint8_t deviceId = 0;      // 读取线程分配的设备编号，设备移除前不变
+    uint8_t deviceClass = 0;   // HID_CLASS_*
+    uint8_t flags = 0;         // HID_FRAME_*
+    int count = 0;
+    HidChange changes[HID_FRAME_MAX_CHANGES];
+};
+
+class HidDecoder {
+public:
+    HidDecoder();
+
+    /**
+     * @brief 按能力位判断设备类别；多点触控 / 笔设备（触摸屏、触摸板、数位板）返回 0
+     */
+    static uint8_t classify(int fd);
+
+    /**
+     * @brief 读取绝对轴范围（EVIOCGABS）与当前状态，下一帧为带完整状态的 ATTACHED 帧
+     */
+    void open(int fd, uint8_t deviceId, uint8_t deviceClass);
+
+    /**
+     * @brief 不经 fd 配置设备（测试 / 回放），之后用 setAxisRange 设置轴
+     */
+    void configure(uint8_t deviceId, uint8_t deviceClass);
+
+    /**
+     * @brief 手动设置一个绝对轴的范围；unipolar 为 true 时归一化到 [0, 32767]
+     */
+    void setAxisRange(int code, int minimum, int maximum, int flat = 0, bool unipolar = false);
+
+    /**
+     * @brief 清空状态（不清空轴范围）
+     */
+    void reset();
+
+    /**
+     * @brief 处理一个 EV_KEY / EV_ABS / EV_REL 事件，其余类型忽略
+     */
+    void handleEvent(const struct input_event& ev);
+
+    /**
+     * @brief 收到 SYN_DROPPED：丢弃到下一个 SYN_REPORT 为止的事件
+     */
+    void onSyncDropped() { syncDropped_ = true; }
+    bool syncDropped() const { return syncDropped_; }
+
+    /**
+     * @brief 用 EVIOCGKEY / EVIOCGABS 读回内核中的状态，与已输出的状态比较后记为待输出的变化
+     * @param flags 下一帧附带的标志（打开时 ATTACHED，SYN_DROPPED 后 RESYNC）
+     * @return 查询失败时为 false，保留当前状态
+     */
+    bool resync(int fd, uint8_t flags);
+
+    /**
+     * @brief 一帧结束：有待输出的变化时填充 out。变化超过 HID_FRAME_MAX_CHANGES 时
+     *        剩余部分留待下一次调用，调用方应循环直到返回 false
+     */
+    bool takeFrame(long long timestampUs, HidFrame& out);
+
+    /**
+     * @brief 设备移除：把所有仍按下的键与偏离静止位置的轴记为待输出的变化（DETACHED）
+     */
+    void release();
+
+    uint8_t deviceId() const { return deviceId_; }
+    uint8_t deviceClass() const { return deviceClass_; }
+
+private:
+    struct Axis {
+        bool present = false;
+        bool unipolar = false;
+        int minimum = 0;
+        int maximum = 0;
+        int flat = 0;
+        int32_t reported = 0;  // 已输出的归一化值
+        int32_t pending = 0;   // 本帧的归一化值
+    };
+
+    static constexpr int AXIS_COUNT = ABS_MT_SLOT; // ABS_MT_* 属于多点触控，不在此处理
+
+    void setKey(int code, bool down);
+    void setAxis(int code, int32_t normalized);
+    int32_t normalize(const Axis& axis, int value) const;
+
+    uint8_t deviceId_ = 0;
+    uint8_t deviceClass_ = 0;
+    Axis axes_[AXIS_COUNT];
+
+    std::bitset<KEY_CNT> keys_;           // 按键状态（含本帧待输出的变化）
+    std::vector<HidChange> pendingKeys_;  // 本帧按发生顺序的按键变化
+    uint64_t dirtyAxes_ = 0;              // 本帧变化过的绝对轴
+    int32_t relAccum_[REL_CNT] = {};
+    uint32_t dirtyRel_ = 0;
+    uint8_t pendingFlags_ = 0;
+    bool syncDropped_ = false;
+};
+
+#endif // HID_DECODER_H
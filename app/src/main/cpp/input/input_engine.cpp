@@ -0,0 +1,204 @@
+#include "input_engine.h"
+
+#include <android/log.h>
+#include <cerrno>
+#include <cstring>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+// 日志标签
+#define TAG "NativeInputReader"
+
+InputEngine::InputEngine() {
+    wakeFd_ = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (wakeFd_ < 0) {
+        __android_log_print(ANDROID_LOG_ERROR, TAG,
+            "InputEngine: 创建 eventfd 失败: %s", strerror(errno));
+    }
+}
+
+InputEngine::~InputEngine() {
+    stop();
+    if (pendingDeviceFd_ >= 0) {
+        close(pendingDeviceFd_);
+        pendingDeviceFd_ = -1;
+    }
+    if (wakeFd_ >= 0) {
+        close(wakeFd_);
+        wakeFd_ = -1;
+    }
+}
+
+bool InputEngine::start(const std::string& devicePath, std::shared_ptr<InputEventSink> sink, int64_t requestedAtNs) {
+    if (wakeFd_ < 0) {
+        return false;
+    }
+    {
+        std::lock_guard<std::mutex> lock(configMutex_);
+        config_.devicePath = devicePath;
+        config_.sink = std::move(sink);
+    }
+    bumpConfig();
+
+    if (running_.load(std::memory_order_acquire)) {
+        __android_log_print(ANDROID_LOG_INFO, TAG,
+            "InputEngine::start: 线程已在运行，仅更新设备与输出: %s", devicePath.c_str());
+        return true;
+    }
+
+    // 上一个线程可能因设备错误自行退出，先回收
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+
+    startRequestedNs_.store(requestedAtNs, std::memory_order_relaxed);
+    startupOpenUs_.store(-1, std::memory_order_relaxed);
+    startupFirstEventUs_.store(-1, std::memory_order_relaxed);
+    running_.store(true, std::memory_order_release);
+    thread_ = std::thread(&InputEngine::readerThreadMain, this);
+    __android_log_print(ANDROID_LOG_INFO, TAG,
+        "InputEngine::start: 已创建读取线程，监听设备: %s", devicePath.c_str());
+    return true;
+}
+
+void InputEngine::stop() {
+    running_.store(false, std::memory_order_release);
+    wake();
+    if (thread_.joinable()) {
+        thread_.join();
+        __android_log_print(ANDROID_LOG_INFO, TAG, "InputEngine::stop: 读取线程已退出。");
+    }
+}
+
+void InputEngine::setDevicePath(const std::string& devicePath) {
+    {
+        std::lock_guard<std::mutex> lock(configMutex_);
+        config_.devicePath = devicePath;
+    }
+    bumpConfig();
+}
+
+void InputEngine::setClickableRegions(std::vector<ClickableRegion> regions) {
+    {
+        std::lock_guard<std::mutex> lock(configMutex_);
+        // 读取线程只比较整数 ID；同一 identifier 在多次更新间保持同一个 ID
+        for (auto& region : regions) {
+            auto inserted = regionIds_.emplace(region.identifier, static_cast<int32_t>(regionIds_.size()));
+            region.id = inserted.first->second;
+        }
+        config_.regions = std::move(regions);
+    }
+    bumpConfig();
+}
+
+void InputEngine::setScreenDimensions(int widthPx, int heightPx) {
+    {
+        std::lock_guard<std::mutex> lock(configMutex_);
+        config_.transform.screenWidthPx = widthPx;
+        config_.transform.screenHeightPx = heightPx;
+    }
+    bumpConfig();
+}
+
+void InputEngine::setScreenOffsets(int topOffsetPx, int leftOffsetPx) {
+    {
+        std::lock_guard<std::mutex> lock(configMutex_);
+        config_.transform.topOffsetPx = topOffsetPx;
+        config_.transform.leftOffsetPx = leftOffsetPx;
+    }
+    bumpConfig();
+}
+
+void InputEngine::setEventSink(std::shared_ptr<InputEventSink> sink) {
+    {
+        std::lock_guard<std::mutex> lock(configMutex_);
+        config_.sink = std::move(sink);
+    }
+    bumpConfig();
+}
+
+void InputEngine::setTouchFilter(const TouchFilterConfig& filter) {
+    {
+        std::lock_guard<std::mutex> lock(configMutex_);
+        config_.touchFilter = filter;
+    }
+    bumpConfig();
+}
+
+void InputEngine::setTouchSmoothing(const TouchSmoothingConfig& smoothing) {
+    {
+        std::lock_guard<std::mutex> lock(configMutex_);
+        config_.touchSmoothing = smoothing;
+    }
+    bumpConfig();
+}
+
+void InputEngine::setPenInput(const PenInputConfig& pen) {
+    {
+        std::lock_guard<std::mutex> lock(configMutex_);
+        config_.pen = pen;
+    }
+    bumpConfig();
+}
+
+void InputEngine::setHidInput(const HidInputConfig& hid) {
+    {
+        std::lock_guard<std::mutex> lock(configMutex_);
+        config_.hid = hid;
+    }
+    bumpConfig();
+}
+
+void InputEngine::setExclusiveGrab(bool enabled) {
+    {
+        std::lock_guard<std::mutex> lock(configMutex_);
+        config_.exclusiveGrab = enabled;
+    }
+    bumpConfig();
+}
+
+void InputEngine::setDeviceFd(int fd, int nativeMaxX, int nativeMaxY) {
+    {
+        std::lock_guard<std::mutex> lock(configMutex_);
+        if (pendingDeviceFd_ >= 0) {
+            close(pendingDeviceFd_);
+        }
+        pendingDeviceFd_ = fd;
+        pendingMaxX_ = nativeMaxX;
+        pendingMaxY_ = nativeMaxY;
+    }
+    bumpConfig();
+}
+
+void InputEngine::setCaptureWriter(std::shared_ptr<EventCaptureWriter> capture) {
+    {
+        std::lock_guard<std::mutex> lock(configMutex_);
+        config_.capture = std::move(capture);
+    }
+    bumpConfig();
+}
+
+size_t InputEngine::clickableRegionCount() const {
+    std::lock_guard<std::mutex> lock(configMutex_);
+    return config_.regions.size();
+}
+
+void InputEngine::setJitterMeasurement(bool enabled) {
+    if (enabled) {
+        wakeupLatency_.reset();
+    }
+    jitterEnabled_.store(enabled, std::memory_order_relaxed);
+}
+
+void InputEngine::bumpConfig() {
+    configGeneration_.fetch_add(1, std::memory_order_release);
+    wake();
+}
+
+void InputEngine::wake() {
+    if (wakeFd_ >= 0) {
+        const uint64_t one = 1;
+        ssize_t ret = write(wakeFd_, &one, sizeof(one));
+        (void)ret; // 计数器溢出 (EAGAIN) 时线程本就处于待唤醒状态
+    }
+}
@@ -0,0 +1,369 @@
+#ifndef INPUT_ENGINE_H
+#define INPUT_ENGINE_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <linux/input.h>
+
+#include "input_types.h"
+#include "event_capture.h"
+#include "gesture_recognizer.h"
+#include "hid_decoder.h"
+#include "pen_decoder.h"
+#include "region_hit_table.h"
+#include "uinput_passthrough.h"
+#include "../common/latency_histogram.h"
+
+/**
+ * @brief 区域事件类型
+ */
+enum class UiEventKind {
+    Tap,           // 按下命中区域，立即发送点击
+    PressDown,     // 按住超过长按开始延迟
+    LongPressEnd,  // 已发送 PressDown 后抬起
+};
+
+/**
+ * @brief 一个普通触摸点（未被区域消费）在屏幕坐标系下的位置
+ */
+struct TouchContact {
+    int id;
+    int x;
+    int y;
+    uint16_t pressure;    // 压力，轴范围的千分比；设备不支持时为 0
+    uint16_t touchMajor;  // 接触长轴，轴范围的千分比；设备不支持时为 0
+};
+
+/**
+ * @brief 触摸质量过滤（防手掌 / 握持误触）。阈值为 0 的规则不生效。
+ *
+ * 规则在区域命中测试之前应用；被拒绝的手指直到抬起前都不参与区域、也不输出。
+ * 尺寸与工具类型在整个按下期间持续检查（手掌往往是逐渐压下的），压力与边缘区只在按下时检查。
+ */
+struct TouchFilterConfig {
+    bool enabled = false;
+    int maxTouchSizePermille = 0;  // 接触长轴 / 短轴超过轴范围的该千分比视为手掌
+    int minPressurePermille = 0;   // 按下时压力低于轴范围的该千分比视为误触
+    int edgeLeftPx = 0;            // 屏幕边缘区宽度：在其中按下的手指被拒绝
+    int edgeTopPx = 0;
+    int edgeRightPx = 0;
+    int edgeBottomPx = 0;
+    bool rejectPalmTool = true;    // ABS_MT_TOOL_TYPE 报告为 MT_TOOL_PALM
+    bool extendedContacts = false; // 触摸帧中附带压力与接触尺寸
+};
+
+/**
+ * @brief 屏幕坐标变换参数（面板原生坐标 -> 悬浮窗坐标）
+ */
+struct ScreenTransform {
+    int screenWidthPx = 0;
+    int screenHeightPx = 0;
+    int topOffsetPx = 0;
+    int leftOffsetPx = 0;
+};
+
+/**
+ * @brief 输出坐标的抖动过滤配置。区域可用自己的参数覆盖 params。
+ */
+struct TouchSmoothingConfig {
+    bool enabled = false;
+    OneEuroParams params;
+};
+
+/**
+ * @brief 主动笔输入配置
+ *
+ * 开启后触摸设备上的笔事件（集成数位板）被解码为笔采样；devicePath 非空时另外打开
+ * 独立的笔设备节点，与触摸设备一起轮询。笔采样按数位板原生频率逐帧输出，不参与区域命中测试。
+ */
+struct PenInputConfig {
+    bool enabled = false;
+    std::string devicePath;
+};
+
+/**
+ * @brief 外接输入设备（手柄、键盘、鼠标）转发配置
+ *
+ * devicePaths 为空时扫描 /dev/input/event* 并按能力位识别设备，inotify 监视新接入的设备；
+ * 非空时只打开列出的节点。每个设备的状态增量按帧输出，与触摸在同一个读取线程上轮询。
+ */
+struct HidInputConfig {
+    bool enabled = false;
+    std::vector<std::string> devicePaths;
+};
+
+/**
+ * @brief 引擎输出接口。所有回调都在读取线程上执行。
+ */
+class InputEventSink {
+public:
+    virtual ~InputEventSink() = default;
+
+    /**
+     * @brief 读取线程开始使用该输出（例如附加到 JVM）
+     * @return false 时引擎不会向该输出投递事件
+     */
+    virtual bool onReaderThreadStart() { return true; }
+
+    /**
+     * @brief 读取线程停止使用该输出（退出或切换到其他输出）
+     */
+    virtual void onReaderThreadStop() {}
+
+    /**
+     * @brief 一帧 (SYN_REPORT) 中所有未被区域消费的触摸点
+     * @param extended 是否输出 TouchContact 中的压力与接触尺寸
+     */
+    virtual void onTouchFrame(const TouchContact* contacts, int count, long long timestampMs,
+                              bool extended) = 0;
+
+    /**
+     * @brief 区域点击 / 按下 / 长按结束
+     */
+    virtual void onUiEvent(UiEventKind kind, const ClickableRegion& region,
+                           int x, int y, long long downTimestampMs) = 0;
+
+    /**
+     * @brief 区域手势（双击 / 滑出 / 和弦 / 按住拖动），在变得无歧义时立即投递
+     */
+    virtual void onGesture(const ClickableRegion& /* region */, const GestureEvent& /* gesture */) {}
+
+    /**
+     * @brief 一帧 (SYN_REPORT) 的笔状态，x / y 已换算为悬浮窗坐标
+     */
+    virtual void onPenSample(const PenSample& /* sample */) {}
+
+    /**
+     * @brief 外接输入设备一帧 (SYN_REPORT) 的状态增量，以及设备接入 / 移除
+     */
+    virtual void onHidFrame(const HidFrame& /* frame */) {}
+
+    /**
+     * @brief 一次 read() 的所有事件处理完毕
+     */
+    virtual void flush() {}
+};
+
+/**
+ * @brief Native 输入引擎：拥有读取线程、设备 fd、区域表与坐标变换
+ *
+ * 读取线程通过 poll 同时等待设备与 eventfd。配置（设备、区域、屏幕变换、输出）
+ * 修改后递增代数并写 eventfd，读取线程在下一轮循环中取走新配置，无需重启线程。
+ * stop() 写 eventfd 唤醒线程后 join，保证同一时刻只有一个循环在读设备。
+ */
+class InputEngine {
+public:
+    InputEngine();
+    ~InputEngine();
+
+    InputEngine(const InputEngine&) = delete;
+    InputEngine& operator=(const InputEngine&) = delete;
+
+    /**
+     * @brief 启动读取线程。若已在运行则只更新设备与输出。
+     * @param requestedAtNs 调用方收到启动请求的时刻（steady_clock），用于统计启动耗时；0 表示不统计
+     */
+    bool start(const std::string& devicePath, std::shared_ptr<InputEventSink> sink, int64_t requestedAtNs = 0);
+
+    /**
+     * @brief 唤醒读取线程并等待其退出
+     */
+    void stop();
+
+    bool isRunning() const { return running_.load(std::memory_order_acquire); }
+
+    // ---------------- 运行时重配置（任意线程调用） ----------------
+    void setDevicePath(const std::string& devicePath);
+    void setClickableRegions(std::vector<ClickableRegion> regions);
+    void setScreenDimensions(int widthPx, int heightPx);
+    void setScreenOffsets(int topOffsetPx, int leftOffsetPx);
+    void setEventSink(std::shared_ptr<InputEventSink> sink);
+    void setTouchFilter(const TouchFilterConfig& filter);
+    void setTouchSmoothing(const TouchSmoothingConfig& smoothing);
+    void setPenInput(const PenInputConfig& pen);
+    void setHidInput(const HidInputConfig& hid);
+
+    /**
+     * @brief 独占模式：EVIOCGRAB 触摸屏，未被区域消费的手指经 uinput 虚拟触摸屏转发给系统。
+     *        创建虚拟设备或独占失败时保持共享读取。
+     */
+    void setExclusiveGrab(bool enabled);
+
+    /**
+     * @brief 临时改为从给定 fd 读取事件（例如回放管道），引擎接管 fd 所有权。
+     *        该 fd 读到 EOF 或出错后自动回到 devicePath 对应的设备。
+     */
+    void setDeviceFd(int fd, int nativeMaxX, int nativeMaxY);
+
+    /**
+     * @brief 把每个原始 input_event 追加到捕获文件，nullptr 表示停止捕获
+     */
+    void setCaptureWriter(std::shared_ptr<EventCaptureWriter> capture);
+
+    size_t clickableRegionCount() const;
+
+    // ---------------- 抖动测量 ----------------
+    void setJitterMeasurement(bool enabled);
+    const LatencyHistogram& wakeupLatency() const { return wakeupLatency_; }
+    // 独占模式转发延迟：内核事件时间 -> 写入 uinput 完成
+    const LatencyHistogram& passthroughLatency() const { return passthroughLatency_; }
+    bool isDeviceGrabbed() const { return grabbedFlag_.load(std::memory_order_relaxed); }
+
+    // ---------------- SYN_DROPPED 统计 ----------------
+    uint64_t syncDropCount() const { return syncDrops_.load(std::memory_order_relaxed); }
+    uint64_t resyncFailureCount() const { return resyncFailures_.load(std::memory_order_relaxed); }
+
+    // ---------------- 启动耗时 ----------------
+    // 从 start() 的 requestedAtNs 到设备打开 / 第一批事件交给输出，尚未发生为 -1
+    int64_t startupOpenUs() const { return startupOpenUs_.load(std::memory_order_relaxed); }
+    int64_t startupFirstEventUs() const { return startupFirstEventUs_.load(std::memory_order_relaxed); }
+
+private:
+    static_assert(TOUCH_SLOT_LIMIT <= OneEuroFilterBank::MAX_SLOTS, "抖动过滤 slot 数不足");
+    static_assert(TOUCH_SLOT_LIMIT <= GestureRecognizer::MAX_CONTACTS, "手势识别 slot 数不足");
+
+    /**
+     * @brief 设备报告的一个 ABS_MT_* 轴的范围（EVIOCGABS），present=false 表示设备不支持
+     */
+    struct AxisRange {
+        bool present = false;
+        int minimum = 0;
+        int maximum = 0;
+    };
+
+    /**
+     * @brief 由读取线程持有的配置快照
+     */
+    struct ConfigSnapshot {
+        std::string devicePath;
+        std::vector<ClickableRegion> regions;
+        ScreenTransform transform;
+        TouchFilterConfig touchFilter;
+        TouchSmoothingConfig touchSmoothing;
+        bool exclusiveGrab = false;
+        PenInputConfig pen;
+        HidInputConfig hid;
+        std::shared_ptr<InputEventSink> sink;
+        std::shared_ptr<EventCaptureWriter> capture;
+    };
+
+    void wake();
+    void bumpConfig();
+
+    // ---- 以下仅在读取线程中使用 (实现在 input_reader_loop.cpp) ----
+    void readerThreadMain();
+    void reloadConfig(ConfigSnapshot& active);
+    int openInputNode(const std::string& devicePath);
+    bool openDevice(const std::string& devicePath);
+    void updatePenDevice(const ConfigSnapshot& active, const std::string& previousPath);
+    void readPenDevice(const ConfigSnapshot& active);
+    void closePenDevice();
+    void updateHidDevices(const ConfigSnapshot& active, const HidInputConfig& previous, bool sinkChanged);
+    void scanHidDevices(const ConfigSnapshot& active);
+    void openHidDevice(const std::string& path, bool explicitPath, const ConfigSnapshot& active);
+    void readHidDevice(int index, const ConfigSnapshot& active);
+    void closeHidDevice(int index, const ConfigSnapshot& active);
+    void closeHidDevices(const ConfigSnapshot& active);
+    void readHidWatch(const ConfigSnapshot& active);
+    void deliverHidFrames(HidDecoder& decoder, long long timestampUs, const ConfigSnapshot& active);
+    void recordStartupMilestone(std::atomic<int64_t>& milestone, const char* what);
+    void flushSink(const ConfigSnapshot& active);
+    void adoptDevice(int fd, int nativeMaxX, int nativeMaxY);
+    void closeDevice();
+    void queryTouchAxes(int fd);
+    void applyEventMask(const ConfigSnapshot& active);
+    void applyExclusiveGrab(bool enabled);
+    int rejectContact(int slot, int x, int y, bool landing, const ConfigSnapshot& active) const;
+    int axisPermille(int value, const AxisRange& axis) const;
+    void resetTouchState();
+    void processEvent(const struct input_event& ev, const ConfigSnapshot& active);
+    void handleSynReport(const struct input_event& ev, const ConfigSnapshot& active);
+    void deliverPenSample(PenDecoder& pen, const struct input_event& report, const ConfigSnapshot& active);
+    void resyncTouchState(const struct input_event& report, const ConfigSnapshot& active);
+    void checkLongPressStart(const ConfigSnapshot& active);
+    void updateGestureRegions(const std::vector<ClickableRegion>& regions);
+    void updateRegionPolicies(const std::vector<ClickableRegion>& regions);
+    int resolveRegionHit(int point, bool slideInOnly, const ConfigSnapshot& active) const;
+    void bindRegion(int slot, int regionIndex, int x, int y, const ConfigSnapshot& active);
+    void releaseRegion(int slot, int x, int y, const ConfigSnapshot& active);
+    void deliverGestures(const ConfigSnapshot& active);
+    int nextPollTimeoutMs() const;
+    void screenPoint(int rawX, int rawY, const ScreenTransform& transform, int& x, int& y) const;
+    const ClickableRegion& slotRegion(int slot, const ConfigSnapshot& active, ClickableRegion& scratch) const;
+
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+    int wakeFd_ = -1;
+
+    // 共享配置：写者持 configMutex_ 修改后递增 configGeneration_
+    mutable std::mutex configMutex_;
+    ConfigSnapshot config_;
+    std::atomic<uint32_t> configGeneration_{0};
+    // setDeviceFd 交来、尚未被读取线程取走的 fd (受 configMutex_ 保护)
+    int pendingDeviceFd_ = -1;
+    int pendingMaxX_ = 0;
+    int pendingMaxY_ = 0;
+    // 区域 identifier -> 整数 ID（只增不减，受 configMutex_ 保护）
+    std::unordered_map<std::string, int32_t> regionIds_;
+
+    std::atomic<bool> jitterEnabled_{false};
+    LatencyHistogram wakeupLatency_;
+    LatencyHistogram passthroughLatency_;
+    std::atomic<bool> grabbedFlag_{false};
+    std::atomic<uint64_t> syncDrops_{0};       // 收到的 SYN_DROPPED 次数
+    std::atomic<uint64_t> resyncFailures_{0};  // EVIOCGMTSLOTS 查询失败次数（如回放管道）
+    std::atomic<int64_t> startRequestedNs_{0};
+    std::atomic<int64_t> startupOpenUs_{-1};
+    std::atomic<int64_t> startupFirstEventUs_{-1};
+
+    // 读取线程私有状态
+    int deviceFd_ = -1;
+    bool usingAdoptedFd_ = false;
+    int nativeMaxX_ = 0;
+    int nativeMaxY_ = 0;
+    AxisRange touchMajorAxis_;
+    AxisRange touchMinorAxis_;
+    AxisRange pressureAxis_;
+    AxisRange toolTypeAxis_;
+    bool grabbed_ = false;        // 已 EVIOCGRAB，passthrough_ 负责把未消费的手指交还系统
+    UinputPassthrough passthrough_;
+    TouchSlots slots_;
+    int currentSlot_ = 0;         // -1 表示设备报告了超出范围的 slot，忽略其后的 ABS_MT_* 直到下一个有效 slot
+    bool touchDataUpdated_ = false;
+    bool syncDropped_ = false;    // 收到 SYN_DROPPED，丢弃事件直到下一个 SYN_REPORT 后重新同步
+    std::vector<TouchContact> frameContacts_;
+    std::vector<int> frameSlots_;           // frameContacts_ 中每个触摸点的 slot
+    OneEuroFilterBank smoothing_;
+    GestureRecognizer gestures_;
+    std::vector<GestureRegion> gestureRegions_;
+    std::vector<RegionGesture> gestureOut_;
+    // 区域策略：编译后的命中表（含 slideIn 区域的外接矩形），以及每个区域当前绑定的手指数
+    RegionHitTable regionTable_;
+    std::vector<int> regionOwners_;
+    std::vector<int16_t> regionIndexById_;  // 区域 ID -> 当前区域表下标，-1 表示已移除
+    std::vector<std::string> regionNames_;  // 区域 ID -> identifier（区域移除后仍用于补发长按结束）
+    // 主动笔：触摸设备上的笔事件，以及独立的笔设备
+    PenDecoder panelPen_;
+    PenDecoder penDevice_;
+    int penFd_ = -1;
+    // 外接输入设备：固定槽位与 poll 数组一一对应，fd=-1 为空槽
+    static constexpr int HID_DEVICE_LIMIT = 8;
+    struct HidDevice {
+        int fd = -1;
+        std::string path;
+        HidDecoder decoder;
+    };
+    HidDevice hidDevices_[HID_DEVICE_LIMIT];
+    int hidWatchFd_ = -1;          // inotify(/dev/input)，只在自动扫描时打开
+    uint8_t nextHidDeviceId_ = 1;  // 设备编号循环分配，0 保留
+    HidFrame hidFrame_;
+};
+
+#endif // INPUT_ENGINE_H
@@ -1,118 +1,152 @@
 #include "input_reader.h"
-#include "input_reader_loop.h"
+#include "input_engine.h"
+#include "event_capture.h"
+#include "event_replay.h"
+#include "ring_event_sink.h"
 #include "input_reader_jni_utils.h"
 #include "input_reader_permissions.h"
+#include "privileged_helper.h"
+#include "region_hit_table.h"
 
-#include "../bridge/jni_bridge.h"  // g_jvm, g_serviceInstance, g_onInputDataReceivedMethodID_Service
 #include <android/log.h>
+#include <fcntl.h>
 #include <unistd.h>
 #include <cerrno>
+#include <chrono>
 #include <string>
 #include <stdexcept>
-#include <sys/poll.h>
 #include <cstring>
-#include <system_error>
-#include <thread>
-#include <vector>
+#include <memory>
 #include <mutex>
-#include <atomic>
-#include <condition_variable>
-#include <chrono>
+#include <vector>
 #include <cstdio>
 #include <nlohmann/json.hpp>
-/** 
- * 这里定义 input_reader.h 中的 extern 全局变量 
+#include "../common/runtime_stats.h"
+#include "../common/thread_config.h"
+#include "../common/trace_log.h"
+
+// 日志标签
+#define TAG "NativeInputReader"
+
+namespace {
+
+/**
+ * @brief 进程内唯一的输入引擎及其 JNI 输出
  */
-std::atomic<bool> g_isRunning(false);
-std::vector<std::thread> g_readerThreads;
-std::mutex g_threadMutex;
+InputEngine& inputEngine() {
+    static InputEngine engine;
+    return engine;
+}
 
-std::vector<ClickableRegion> g_clickableRegions;
-std::mutex g_regionMutex;
+std::mutex g_serviceMutex; // 串行化 start / stop
+std::shared_ptr<JniInputEventSink> g_jniSink;
 
-int g_screenWidthPx = 0;
-int g_screenHeightPx = 0;
-int g_screenTopOffsetPx = 0;
-int g_screenLeftOffsetPx = 0;
+std::mutex g_captureMutex; // 保护捕获与回放
+std::shared_ptr<EventCaptureWriter> g_captureWriter;
+EventReplayer g_replayer;
 
-// 日志标签
-#define TAG "NativeInputReader"
+// 共享内存事件环：消费线程通过 atomic_load 取得，等待期间不持锁
+std::shared_ptr<RingInputEventSink> g_ringSink;
+
+} // namespace
 
 // ---------------- JNI 导出函数的实现 ----------------
 
 /**
  * @brief JNI 接口：启动输入设备读取线程
  */
-void nativeStartInputReaderService(JNIEnv* env, jobject /* instance */) {
+void nativeStartInputReaderService(JNIEnv* env, jobject instance) {
+    const int64_t requestedAtNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
     __android_log_print(ANDROID_LOG_INFO, TAG, "nativeStartInputReaderService: 开始初始化");
 
     static constexpr const char* TOUCH_DEVICE_PATH = "/dev/input/event4"; // 示例
 
+    std::lock_guard<std::mutex> lock(g_serviceMutex);
+    if (inputEngine().isRunning()) {
+        __android_log_print(ANDROID_LOG_WARN, TAG, "输入读取线程已在运行中");
+        return;
+    }
+
+    auto sink = std::make_shared<JniInputEventSink>();
     try {
         // 在启动线程前，尝试初始化 JNI 引用
-        if (!initializeJniReferences(env)) {
+        if (!sink->initialize(env, instance)) {
             throw std::runtime_error("JNI 引用初始化失败");
         }
 
-        {
-            std::lock_guard<std::mutex> lock(g_threadMutex);
-            if (g_isRunning.load()) {
-                __android_log_print(ANDROID_LOG_WARN, TAG, "输入读取线程已在运行中");
-                return;
-            }
-
-            // 检查设备文件是否可访问
-            if (access(TOUCH_DEVICE_PATH, R_OK) != 0) {
-                if (errno == EACCES || errno == EPERM) {
-                    __android_log_print(ANDROID_LOG_WARN, TAG, 
+        // 检查设备文件是否可访问；权限不足时在这里启动特权辅助进程（每个应用进程只启动一次），
+        // 读取线程随后经它打开设备
+        if (access(TOUCH_DEVICE_PATH, R_OK) != 0) {
+            if (errno == EACCES || errno == EPERM) {
+                if (privilegedHelper().ensureRunning()) {
+                    // 先试开一次：SELinux 拒收传回的 fd 时在这里报错，而不是让读取线程悄悄失败
+                    const int probeFd = privilegedHelper().openDevice(TOUCH_DEVICE_PATH, O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+                    if (probeFd < 0 && errno == EPROTO) {
+                        throw std::runtime_error("SELinux 拒收了特权辅助进程传回的设备 fd（无法经 magiskpolicy / supolicy 加入规则）");
+                    }
+                    if (probeFd >= 0) {
+                        close(probeFd);
+                    }
+                    __android_log_print(ANDROID_LOG_INFO, TAG,
+                        "设备文件权限不足，改由特权辅助进程打开: %s", TOUCH_DEVICE_PATH);
+                } else if (errno != ENOENT) {
+                    throw std::runtime_error("特权辅助进程启动失败（su 被拒绝或超时）");
+                } else {
+                    // 仅在未配置辅助进程时退回 su + chmod
+                    __android_log_print(ANDROID_LOG_WARN, TAG,
                         "设备文件权限不足，尝试修复: %s", TOUCH_DEVICE_PATH);
                     if (!tryFixPermissions(TOUCH_DEVICE_PATH)) {
                         throw std::runtime_error("无法获取设备文件访问权限");
                     }
-                } else {
-                    throw std::runtime_error("设备文件不存在或无法访问");
                 }
+            } else {
+                throw std::runtime_error("设备文件不存在或无法访问");
             }
+        }
 
-            g_isRunning.store(true);
-            __android_log_print(ANDROID_LOG_INFO, TAG, 
-                "准备创建输入读取线程，监听设备: %s", TOUCH_DEVICE_PATH);
-
-            std::thread readerThread(inputReaderLoop, TOUCH_DEVICE_PATH);
-            auto threadId = readerThread.get_id();
-            __android_log_print(ANDROID_LOG_INFO, TAG, 
-                "已创建并启动线程: %llu", 
-                static_cast<unsigned long long>(std::hash<std::thread::id>{}(threadId)));
-            
-            readerThread.detach();
+        __android_log_print(ANDROID_LOG_INFO, TAG,
+            "准备创建输入读取线程，监听设备: %s", TOUCH_DEVICE_PATH);
+        if (!inputEngine().start(TOUCH_DEVICE_PATH, sink, requestedAtNs)) {
+            throw std::runtime_error("输入引擎启动失败");
         }
+        g_jniSink = std::move(sink);
     } catch (const std::exception& e) {
-        __android_log_print(ANDROID_LOG_ERROR, TAG, 
+        __android_log_print(ANDROID_LOG_ERROR, TAG,
             "启动服务失败: %s", e.what());
-        g_isRunning.store(false);
-        cleanupJniReferences(env);
+        inputEngine().stop();
+        sink->releaseReferences(env);
         throw; // 重新抛出异常，让 Java 层处理
     }
 }
 
 /**
  * @brief JNI 接口：停止输入设备读取线程
+ *
+ * 等待读取线程退出（join）后再释放 JNI 全局引用，保证不会有回调使用已释放的引用。
  */
 void nativeStopInputReaderService(JNIEnv* env, jobject /* instance */) {
-    std::lock_guard<std::mutex> lock(g_threadMutex);
-    if (!g_isRunning.load()) {
+    std::lock_guard<std::mutex> lock(g_serviceMutex);
+    if (!inputEngine().isRunning() && !g_jniSink) {
         __android_log_print(ANDROID_LOG_WARN, TAG,
             "读取线程未运行，忽略停止请求。");
         return;
     }
 
-    g_isRunning.store(false);
+    inputEngine().stop();
     __android_log_print(ANDROID_LOG_INFO, TAG,
-        "nativeStopInputReaderService: 已设置 g_isRunning=false。");
-    g_readerThreads.clear(); // 已经detach的线程无法join，清空vector
+        "nativeStopInputReaderService: 读取线程已停止。");
 
-    // 停止时清理 JNI 引用
-    cleanupJniReferences(env);
+    // 读取线程已退出，唤醒可能仍在等待的环消费者
+    if (auto ring = std::atomic_load(&g_ringSink)) {
+        ring->close();
+    }
+
+    if (g_jniSink) {
+        g_jniSink->releaseReferences(env);
+        g_jniSink.reset();
+    }
+    traceLogFlush();
 }
 
 /**
@@ -133,9 +167,6 @@ Java_com_luoxiaohei_lowlatencyinput_service_GyroscopeService_nativeUpdateClickab
     std::string jsonStr(nativeJsonString);
     env->ReleaseStringUTFChars(jsonData, nativeJsonString);
 
-    __android_log_print(ANDROID_LOG_INFO, TAG,
-        "nativeUpdateClickableRegions: 收到 JSON: %s", jsonStr.c_str());
-
     try {
         // 使用 nlohmann::json
         nlohmann::json parsed = nlohmann::json::parse(jsonStr);
@@ -152,17 +183,68 @@ Java_com_luoxiaohei_lowlatencyinput_service_GyroscopeService_nativeUpdateClickab
                 r.top       = item.value("topPx", 0);
                 r.width     = item.value("widthPx", 0);
                 r.height    = item.value("heightPx", 0);
+                auto gestures = item.find("gestures");
+                if (gestures != item.end() && gestures->is_array()) {
+                    for (auto& name : *gestures) {
+                        if (name.is_string()) {
+                            r.gestureMask |= gestureMaskFromName(name.get<std::string>());
+                        }
+                    }
+                }
+                auto policies = item.find("policies");
+                if (policies != item.end() && policies->is_array()) {
+                    for (auto& name : *policies) {
+                        if (!name.is_string()) {
+                            continue;
+                        }
+                        const std::string policy = name.get<std::string>();
+                        if (policy == "slideIn") r.slideIn = true;
+                        else if (policy == "slideOut") r.slideOut = true;
+                        else if (policy == "capture") r.capture = true;
+                        else if (policy == "exclusive") r.exclusive = true;
+                        else if (policy == "passThrough") r.passThrough = true;
+                    }
+                }
+                const std::string shape = item.value("shape", "rect");
+                if (shape == "circle") r.shape = RegionShape::Circle;
+                else if (shape == "roundRect") r.shape = RegionShape::RoundedRect;
+                else if (shape == "polygon") r.shape = RegionShape::Polygon;
+                r.cornerRadius = item.value("cornerRadiusPx", 0);
+                r.padding = item.value("paddingPx", 0);
+                r.priority = item.value("priority", 0);
+                auto points = item.find("points");
+                if (points != item.end() && points->is_array()) {
+                    // 扁平数组 [x0, y0, x1, y1, ...]，相对于 leftPx / topPx
+                    for (size_t i = 0; i + 1 < points->size(); i += 2) {
+                        const auto& px = (*points)[i];
+                        const auto& py = (*points)[i + 1];
+                        if (px.is_number() && py.is_number()) {
+                            r.polygon.push_back(RegionPoint{px.get<float>(), py.get<float>()});
+                        }
+                    }
+                }
+                if (r.shape == RegionShape::Polygon && !RegionHitTable::isConvexPolygon(r.polygon)) {
+                    __android_log_print(ANDROID_LOG_WARN, TAG,
+                        "区域 %s 的 points 不是凸多边形，按外接矩形处理。", r.identifier.c_str());
+                    r.shape = RegionShape::Rect;
+                    r.polygon.clear();
+                }
+                auto smoothing = item.find("smoothing");
+                if (smoothing != item.end() && smoothing->is_object()) {
+                    r.customSmoothing = true;
+                    r.smoothing.minCutoffHz = smoothing->value("minCutoffHz", r.smoothing.minCutoffHz);
+                    r.smoothing.beta = smoothing->value("beta", r.smoothing.beta);
+                    r.smoothing.derivativeCutoffHz =
+                        smoothing->value("derivativeCutoffHz", r.smoothing.derivativeCutoffHz);
+                }
                 if (!r.identifier.empty() && r.width > 0 && r.height > 0) {
                     tmpRegions.push_back(r);
                 }
             }
         }
-        {
-            std::lock_guard<std::mutex> lk(g_regionMutex);
-            g_clickableRegions = std::move(tmpRegions);
-        }
-        __android_log_print(ANDROID_LOG_INFO, TAG,
-            "nativeUpdateClickableRegions: 更新成功, count=%zu", g_clickableRegions.size());
+        const size_t regionCount = tmpRegions.size();
+        inputEngine().setClickableRegions(std::move(tmpRegions));
+        TRACE_I(TraceEvent::RegionsUpdated, jsonStr.size(), regionCount);
     } catch (nlohmann::json::parse_error& e) {
         __android_log_print(ANDROID_LOG_ERROR, TAG,
             "JSON parse error: %s", e.what());
@@ -182,11 +264,9 @@ Java_com_luoxiaohei_lowlatencyinput_service_GyroscopeService_nativeSetScreenDime
     jint width,
     jint height)
 {
-    g_screenWidthPx = width;
-    g_screenHeightPx = height;
+    inputEngine().setScreenDimensions(width, height);
     __android_log_print(ANDROID_LOG_INFO, TAG,
-        "nativeSetScreenDimensions: 屏幕大小 %d x %d",
-        g_screenWidthPx, g_screenHeightPx);
+        "nativeSetScreenDimensions: 屏幕大小 %d x %d", width, height);
 }
 
 /**
@@ -199,11 +279,9 @@ Java_com_luoxiaohei_lowlatencyinput_service_GyroscopeService_nativeSetScreenOffs
     jint topOffset,
     jint leftOffset)
 {
-    g_screenTopOffsetPx = topOffset;
-    g_screenLeftOffsetPx = leftOffset;
+    inputEngine().setScreenOffsets(topOffset, leftOffset);
     __android_log_print(ANDROID_LOG_INFO, TAG,
-        "nativeSetScreenOffsets: Top=%d, Left=%d",
-        g_screenTopOffsetPx, g_screenLeftOffsetPx);
+        "nativeSetScreenOffsets: Top=%d, Left=%d", topOffset, leftOffset);
 }
 
 /**
@@ -217,8 +295,7 @@ Java_com_luoxiaohei_lowlatencyinput_service_GyroscopeService_nativeRequestSendUi
     jint x,
     jint y)
 {
-    __android_log_print(ANDROID_LOG_DEBUG, TAG,
-        "nativeRequestSendUiEventPacket (no-op in C++)");
+    TRACE_D(TraceEvent::UiPacketRequest, 0, x, y);
 }
 
 /**
@@ -232,6 +309,482 @@ Java_com_luoxiaohei_lowlatencyinput_service_GyroscopeService_nativeRequestSendUi
     jint x,
     jint y)
 {
-    __android_log_print(ANDROID_LOG_DEBUG, TAG,
-        "nativeRequestSendUiLongPressPacket (no-op in C++)");
+    TRACE_D(TraceEvent::UiPacketRequest, 1, x, y);
+}
+
+/**
+ * @brief JNI: 配置 Native 线程，对应线程会在下一次循环时自行应用
+ */
+extern "C" JNIEXPORT void JNICALL
+Java_com_luoxiaohei_lowlatencyinput_service_GyroscopeService_nativeConfigureThread(
+    JNIEnv *env,
+    jclass /* clazz */,
+    jint role,
+    jint policy,
+    jint rtPriority,
+    jint niceValue,
+    jlong cpuMask,
+    jint prefaultStackKb,
+    jboolean lockMemory,
+    jboolean lockAllMemory)
+{
+    if (role < 0 || role >= static_cast<jint>(ThreadRole::Count)) {
+        __android_log_print(ANDROID_LOG_ERROR, TAG, "nativeConfigureThread: 无效角色 %d", role);
+        return;
+    }
+    ThreadConfig config;
+    config.policy = (policy == 1) ? ThreadSchedPolicy::Fifo
+                  : (policy == 2) ? ThreadSchedPolicy::RoundRobin
+                  : ThreadSchedPolicy::Default;
+    config.rtPriority = rtPriority;
+    config.niceValue = niceValue;
+    config.cpuMask = static_cast<uint64_t>(cpuMask);
+    config.prefaultStackBytes = prefaultStackKb > 0 ? static_cast<size_t>(prefaultStackKb) * 1024 : 0;
+    if (config.prefaultStackBytes > MAX_PREFAULT_STACK_BYTES) {
+        __android_log_print(ANDROID_LOG_WARN, TAG, "nativeConfigureThread: 栈预触碰 %dKB 过大，收紧为 %zuKB",
+                            prefaultStackKb, MAX_PREFAULT_STACK_BYTES / 1024);
+        config.prefaultStackBytes = MAX_PREFAULT_STACK_BYTES;
+    }
+    config.lockMemory = lockMemory == JNI_TRUE;
+    config.lockAllMemory = lockAllMemory == JNI_TRUE;
+    setThreadConfig(static_cast<ThreadRole>(role), config);
+
+    __android_log_print(ANDROID_LOG_INFO, TAG,
+        "nativeConfigureThread: role=%d policy=%d prio=%d nice=%d cpus=0x%llx stack=%zuKB lock=%d/%d",
+        role, policy, rtPriority, niceValue, (unsigned long long)cpuMask,
+        config.prefaultStackBytes / 1024, lockMemory ? 1 : 0, lockAllMemory ? 1 : 0);
+}
+
+/**
+ * @brief JNI: 开启/关闭抖动测量模式
+ */
+extern "C" JNIEXPORT void JNICALL
+Java_com_luoxiaohei_lowlatencyinput_service_GyroscopeService_nativeSetJitterMeasurement(
+    JNIEnv *env,
+    jclass /* clazz */,
+    jboolean enabled)
+{
+    inputEngine().setJitterMeasurement(enabled == JNI_TRUE);
+    __android_log_print(ANDROID_LOG_INFO, TAG,
+        "nativeSetJitterMeasurement: %s", enabled ? "开启" : "关闭");
+}
+
+/**
+ * @brief JNI: 配置触摸质量过滤（防手掌 / 边缘误触）与扩展触摸点输出
+ */
+extern "C" JNIEXPORT void JNICALL
+Java_com_luoxiaohei_lowlatencyinput_service_GyroscopeService_nativeSetTouchFilter(
+    JNIEnv *env,
+    jclass /* clazz */,
+    jboolean enabled,
+    jint maxTouchSizePermille,
+    jint minPressurePermille,
+    jint edgeLeftPx,
+    jint edgeTopPx,
+    jint edgeRightPx,
+    jint edgeBottomPx,
+    jboolean rejectPalmTool,
+    jboolean extendedContacts)
+{
+    TouchFilterConfig filter;
+    filter.enabled = enabled == JNI_TRUE;
+    filter.maxTouchSizePermille = maxTouchSizePermille;
+    filter.minPressurePermille = minPressurePermille;
+    filter.edgeLeftPx = edgeLeftPx;
+    filter.edgeTopPx = edgeTopPx;
+    filter.edgeRightPx = edgeRightPx;
+    filter.edgeBottomPx = edgeBottomPx;
+    filter.rejectPalmTool = rejectPalmTool == JNI_TRUE;
+    filter.extendedContacts = extendedContacts == JNI_TRUE;
+    inputEngine().setTouchFilter(filter);
+    __android_log_print(ANDROID_LOG_INFO, TAG,
+        "nativeSetTouchFilter: %s, 尺寸<=%d‰, 压力>=%d‰, 边缘=(%d,%d,%d,%d), 手掌工具=%d, 扩展触摸点=%d",
+        filter.enabled ? "开启" : "关闭", maxTouchSizePermille, minPressurePermille,
+        edgeLeftPx, edgeTopPx, edgeRightPx, edgeBottomPx, filter.rejectPalmTool, filter.extendedContacts);
+}
+
+/**
+ * @brief JNI: 配置输出坐标的抖动过滤（One Euro），区域 JSON 中的 "smoothing" 可覆盖参数
+ */
+extern "C" JNIEXPORT void JNICALL
+Java_com_luoxiaohei_lowlatencyinput_service_GyroscopeService_nativeSetTouchSmoothing(
+    JNIEnv *env,
+    jclass /* clazz */,
+    jboolean enabled,
+    jfloat minCutoffHz,
+    jfloat beta,
+    jfloat derivativeCutoffHz)
+{
+    TouchSmoothingConfig smoothing;
+    smoothing.enabled = enabled == JNI_TRUE;
+    smoothing.params.minCutoffHz = minCutoffHz;
+    smoothing.params.beta = beta;
+    smoothing.params.derivativeCutoffHz = derivativeCutoffHz;
+    inputEngine().setTouchSmoothing(smoothing);
+    __android_log_print(ANDROID_LOG_INFO, TAG,
+        "nativeSetTouchSmoothing: %s, minCutoff=%.2fHz, beta=%.4f, dCutoff=%.2fHz",
+        smoothing.enabled ? "开启" : "关闭", minCutoffHz, beta, derivativeCutoffHz);
+}
+
+/**
+ * @brief JNI: 开关独占模式（EVIOCGRAB + uinput 转发未被区域消费的触摸）
+ */
+extern "C" JNIEXPORT void JNICALL
+Java_com_luoxiaohei_lowlatencyinput_service_GyroscopeService_nativeSetExclusiveGrab(
+    JNIEnv *env,
+    jclass /* clazz */,
+    jboolean enabled)
+{
+    inputEngine().setExclusiveGrab(enabled == JNI_TRUE);
+    __android_log_print(ANDROID_LOG_INFO, TAG,
+        "nativeSetExclusiveGrab: %s", enabled == JNI_TRUE ? "开启" : "关闭");
+}
+
+/**
+ * @brief JNI: 开关主动笔输入；penDevicePath 为独立笔设备节点，空串表示只解码触摸设备上的笔事件
+ */
+extern "C" JNIEXPORT void JNICALL
+Java_com_luoxiaohei_lowlatencyinput_service_GyroscopeService_nativeSetPenInput(
+    JNIEnv *env,
+    jclass /* clazz */,
+    jboolean enabled,
+    jstring penDevicePath)
+{
+    PenInputConfig pen;
+    pen.enabled = enabled == JNI_TRUE;
+    if (penDevicePath) {
+        const char* nativePath = env->GetStringUTFChars(penDevicePath, nullptr);
+        if (nativePath) {
+            pen.devicePath = nativePath;
+            env->ReleaseStringUTFChars(penDevicePath, nativePath);
+        }
+    }
+    inputEngine().setPenInput(pen);
+    __android_log_print(ANDROID_LOG_INFO, TAG,
+        "nativeSetPenInput: %s, 笔设备=%s", pen.enabled ? "开启" : "关闭",
+        pen.devicePath.empty() ? "(触摸设备)" : pen.devicePath.c_str());
+}
+
+/**
+ * @brief JNI: 开关外接输入设备（手柄、键盘、鼠标）转发；devicePaths 为空时自动识别并监视新接入的设备
+ */
+extern "C" JNIEXPORT void JNICALL
+Java_com_luoxiaohei_lowlatencyinput_service_GyroscopeService_nativeSetHidInput(
+    JNIEnv *env,
+    jclass /* clazz */,
+    jboolean enabled,
+    jobjectArray devicePaths)
+{
+    HidInputConfig hid;
+    hid.enabled = enabled == JNI_TRUE;
+    const jsize count = devicePaths ? env->GetArrayLength(devicePaths) : 0;
+    for (jsize i = 0; i < count; ++i) {
+        auto path = static_cast<jstring>(env->GetObjectArrayElement(devicePaths, i));
+        if (!path) {
+            continue;
+        }
+        const char* nativePath = env->GetStringUTFChars(path, nullptr);
+        if (nativePath) {
+            if (nativePath[0] != '\0') {
+                hid.devicePaths.emplace_back(nativePath);
+            }
+            env->ReleaseStringUTFChars(path, nativePath);
+        }
+        env->DeleteLocalRef(path);
+    }
+    inputEngine().setHidInput(hid);
+    __android_log_print(ANDROID_LOG_INFO, TAG,
+        "nativeSetHidInput: %s, %s", hid.enabled ? "开启" : "关闭",
+        hid.devicePaths.empty() ? "自动识别" : "指定设备");
+}
+
+/**
+ * @brief JNI: 设置特权辅助进程可执行文件路径（nativeLibraryDir 下的 liblowlatencyinput_helper.so）
+ */
+extern "C" JNIEXPORT void JNICALL
+Java_com_luoxiaohei_lowlatencyinput_service_GyroscopeService_nativeSetPrivilegedHelperPath(
+    JNIEnv *env,
+    jclass /* clazz */,
+    jstring path)
+{
+    const char* nativePath = env->GetStringUTFChars(path, nullptr);
+    if (!nativePath) {
+        return;
+    }
+    privilegedHelper().configure(nativePath, true);
+    __android_log_print(ANDROID_LOG_INFO, TAG, "nativeSetPrivilegedHelperPath: %s", nativePath);
+    env->ReleaseStringUTFChars(path, nativePath);
+}
+
+/**
+ * @brief JNI: 获取线程配置实际生效情况、唤醒延迟、SYN_DROPPED 统计与启动耗时
+ */
+extern "C" JNIEXPORT jstring JNICALL
+Java_com_luoxiaohei_lowlatencyinput_service_GyroscopeService_nativeGetThreadReport(
+    JNIEnv *env,
+    jclass /* clazz */)
+{
+    const LatencyHistogram& wakeupLatency = inputEngine().wakeupLatency();
+    char jitter[192];
+    snprintf(jitter, sizeof(jitter),
+        "wakeup latency: n=%llu mean=%lluus p50=%lluus p90=%lluus p99=%lluus max=%lluus",
+        (unsigned long long)wakeupLatency.count(),
+        (unsigned long long)wakeupLatency.meanUs(),
+        (unsigned long long)wakeupLatency.percentileUs(50),
+        (unsigned long long)wakeupLatency.percentileUs(90),
+        (unsigned long long)wakeupLatency.percentileUs(99),
+        (unsigned long long)wakeupLatency.maxUs());
+
+    const LatencyHistogram& passthroughLatency = inputEngine().passthroughLatency();
+    char passthrough[192];
+    snprintf(passthrough, sizeof(passthrough),
+        "passthrough: grabbed=%d n=%llu mean=%lluus p50=%lluus p99=%lluus max=%lluus",
+        inputEngine().isDeviceGrabbed() ? 1 : 0,
+        (unsigned long long)passthroughLatency.count(),
+        (unsigned long long)passthroughLatency.meanUs(),
+        (unsigned long long)passthroughLatency.percentileUs(50),
+        (unsigned long long)passthroughLatency.percentileUs(99),
+        (unsigned long long)passthroughLatency.maxUs());
+
+    char drops[96];
+    snprintf(drops, sizeof(drops), "evdev: SYN_DROPPED=%llu resyncFailures=%llu",
+        (unsigned long long)inputEngine().syncDropCount(),
+        (unsigned long long)inputEngine().resyncFailureCount());
+
+    char startup[128];
+    snprintf(startup, sizeof(startup), "startup: helper=%lldus open=%lldus firstEvent=%lldus",
+        (long long)privilegedHelper().lastStartUs(),
+        (long long)inputEngine().startupOpenUs(),
+        (long long)inputEngine().startupFirstEventUs());
+
+    std::string report = "reader: " + lastThreadConfigResult(ThreadRole::InputReader).describe()
+        + "\nsender: " + lastThreadConfigResult(ThreadRole::PacketSender).describe()
+        + "\n" + jitter + "\n" + drops + "\n" + passthrough + "\n" + startup;
+    return env->NewStringUTF(report.c_str());
+}
+
+/**
+ * @brief JNI: 开始把原始 input_event 捕获到预分配的 mmap 文件
+ * @param maxEvents 文件容量（事件数），用尽后丢弃并计数
+ */
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_luoxiaohei_lowlatencyinput_service_GyroscopeService_nativeStartInputCapture(
+    JNIEnv *env,
+    jclass /* clazz */,
+    jstring path,
+    jint maxEvents)
+{
+    const char* nativePath = env->GetStringUTFChars(path, nullptr);
+    if (!nativePath) {
+        return JNI_FALSE;
+    }
+    std::string capturePath(nativePath);
+    env->ReleaseStringUTFChars(path, nativePath);
+
+    std::lock_guard<std::mutex> lock(g_captureMutex);
+    if (g_captureWriter) {
+        inputEngine().setCaptureWriter(nullptr);
+        g_captureWriter.reset();
+    }
+    auto writer = std::make_shared<EventCaptureWriter>();
+    if (maxEvents <= 0 || !writer->open(capturePath, static_cast<size_t>(maxEvents))) {
+        __android_log_print(ANDROID_LOG_ERROR, TAG,
+            "nativeStartInputCapture: 无法创建捕获文件 %s", capturePath.c_str());
+        return JNI_FALSE;
+    }
+    g_captureWriter = writer;
+    inputEngine().setCaptureWriter(std::move(writer));
+    return JNI_TRUE;
+}
+
+/**
+ * @brief JNI: 停止捕获。文件在读取线程释放引用后截断并关闭。
+ * @return 已记录的事件数
+ */
+extern "C" JNIEXPORT jlong JNICALL
+Java_com_luoxiaohei_lowlatencyinput_service_GyroscopeService_nativeStopInputCapture(
+    JNIEnv *env,
+    jclass /* clazz */)
+{
+    std::lock_guard<std::mutex> lock(g_captureMutex);
+    if (!g_captureWriter) {
+        return 0;
+    }
+    inputEngine().setCaptureWriter(nullptr);
+    const uint64_t recorded = g_captureWriter->recordCount();
+    g_captureWriter.reset();
+    __android_log_print(ANDROID_LOG_INFO, TAG,
+        "nativeStopInputCapture: 已记录 %llu 个事件", (unsigned long long)recorded);
+    return static_cast<jlong>(recorded);
+}
+
+/**
+ * @brief JNI: 把捕获文件经输入引擎回放（替代真实设备，结束后自动恢复）
+ * @param originalTiming true 按原始节奏，false 尽快回放
+ */
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_luoxiaohei_lowlatencyinput_service_GyroscopeService_nativeStartInputReplay(
+    JNIEnv *env,
+    jclass /* clazz */,
+    jstring path,
+    jboolean originalTiming)
+{
+    const char* nativePath = env->GetStringUTFChars(path, nullptr);
+    if (!nativePath) {
+        return JNI_FALSE;
+    }
+    std::string capturePath(nativePath);
+    env->ReleaseStringUTFChars(path, nativePath);
+
+    if (!inputEngine().isRunning()) {
+        __android_log_print(ANDROID_LOG_WARN, TAG, "nativeStartInputReplay: 输入读取线程未运行");
+        return JNI_FALSE;
+    }
+    ReplayOptions options;
+    options.originalTiming = originalTiming == JNI_TRUE;
+    std::lock_guard<std::mutex> lock(g_captureMutex);
+    return g_replayer.start(capturePath, inputEngine(), options) ? JNI_TRUE : JNI_FALSE;
+}
+
+/**
+ * @brief JNI: 停止回放，引擎回到真实设备
+ */
+extern "C" JNIEXPORT void JNICALL
+Java_com_luoxiaohei_lowlatencyinput_service_GyroscopeService_nativeStopInputReplay(
+    JNIEnv *env,
+    jclass /* clazz */)
+{
+    std::lock_guard<std::mutex> lock(g_captureMutex);
+    g_replayer.stop();
+}
+
+/**
+ * @brief JNI: 跟踪日志额外写入文件（追加）；path 为 null 时只写 logcat
+ */
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_luoxiaohei_lowlatencyinput_service_GyroscopeService_nativeSetTraceLogFile(
+    JNIEnv *env,
+    jclass /* clazz */,
+    jstring path)
+{
+    std::string tracePath;
+    if (path != nullptr) {
+        const char* nativePath = env->GetStringUTFChars(path, nullptr);
+        if (!nativePath) {
+            return JNI_FALSE;
+        }
+        tracePath = nativePath;
+        env->ReleaseStringUTFChars(path, nativePath);
+    }
+    return traceLogSetOutputFile(tracePath) ? JNI_TRUE : JNI_FALSE;
+}
+
+/**
+ * @brief JNI: 创建共享内存事件环并把引擎输出切换到该环
+ * @param capacity 记录条数，向上取整为 2 的幂
+ * @return 覆盖整个环（头部 + 记录）的 direct ByteBuffer；失败返回 null
+ */
+extern "C" JNIEXPORT jobject JNICALL
+Java_com_luoxiaohei_lowlatencyinput_service_GyroscopeService_nativeCreateInputRing(
+    JNIEnv *env,
+    jclass /* clazz */,
+    jint capacity)
+{
+    std::lock_guard<std::mutex> lock(g_serviceMutex);
+    if (!inputEngine().isRunning()) {
+        __android_log_print(ANDROID_LOG_WARN, TAG, "nativeCreateInputRing: 输入读取线程未运行");
+        return nullptr;
+    }
+    if (std::atomic_load(&g_ringSink)) {
+        __android_log_print(ANDROID_LOG_WARN, TAG, "nativeCreateInputRing: 事件环已存在");
+        return nullptr;
+    }
+    auto ring = std::make_shared<RingInputEventSink>();
+    if (capacity <= 0 || !ring->create(static_cast<uint32_t>(capacity))) {
+        return nullptr;
+    }
+    jobject buffer = env->NewDirectByteBuffer(ring->memory(), static_cast<jlong>(ring->memoryBytes()));
+    if (buffer == nullptr) {
+        __android_log_print(ANDROID_LOG_ERROR, TAG, "nativeCreateInputRing: 创建 direct ByteBuffer 失败");
+        return nullptr;
+    }
+    std::atomic_store(&g_ringSink, ring);
+    inputEngine().setEventSink(std::move(ring));
+    return buffer;
+}
+
+/**
+ * @brief JNI: 消费线程发布已消费位置，环为空时阻塞等待生产者唤醒
+ * @param consumedIndex 已处理完的记录总数
+ * @return 当前已发布的记录总数；环已关闭且读空时返回 -1
+ */
+extern "C" JNIEXPORT jlong JNICALL
+Java_com_luoxiaohei_lowlatencyinput_service_GyroscopeService_nativeAwaitInputRing(
+    JNIEnv *env,
+    jclass /* clazz */,
+    jlong consumedIndex,
+    jint timeoutMs)
+{
+    auto ring = std::atomic_load(&g_ringSink);
+    if (!ring) {
+        return -1;
+    }
+    return static_cast<jlong>(ring->await(static_cast<uint64_t>(consumedIndex), timeoutMs));
+}
+
+/**
+ * @brief JNI: 引擎输出切回 JNI 批量上行并关闭事件环，消费线程读空后退出
+ */
+extern "C" JNIEXPORT void JNICALL
+Java_com_luoxiaohei_lowlatencyinput_service_GyroscopeService_nativeCloseInputRing(
+    JNIEnv *env,
+    jclass /* clazz */)
+{
+    std::lock_guard<std::mutex> lock(g_serviceMutex);
+    auto ring = std::atomic_load(&g_ringSink);
+    if (!ring) {
+        return;
+    }
+    if (g_jniSink) {
+        inputEngine().setEventSink(g_jniSink);
+    }
+    ring->close();
+}
+
+/**
+ * @brief JNI: 消费线程退出后释放事件环。读取线程若仍持有旧输出，内存在其切换后回收。
+ */
+extern "C" JNIEXPORT void JNICALL
+Java_com_luoxiaohei_lowlatencyinput_service_GyroscopeService_nativeReleaseInputRing(
+    JNIEnv *env,
+    jclass /* clazz */)
+{
+    std::lock_guard<std::mutex> lock(g_serviceMutex);
+    auto ring = std::atomic_exchange(&g_ringSink, std::shared_ptr<RingInputEventSink>());
+    if (ring) {
+        const EventRingHeader* header = ring->header();
+        __android_log_print(ANDROID_LOG_INFO, TAG,
+            "事件环已释放: 写入 %llu 条, 溢出丢弃 %llu 条, 唤醒 %llu 次",
+            (unsigned long long)header->writeIndex,
+            (unsigned long long)header->overflowCount,
+            (unsigned long long)header->wakeupCount);
+    }
+}
+
+/**
+ * @brief JNI: 包装进程内运行时统计块的 direct ByteBuffer（本机字节序，字段见 RuntimeStatsField）
+ *
+ * 统计块是静态存储，Kotlin 可长期持有该 ByteBuffer 直接读取，之后不再需要 JNI 调用。
+ * @return 失败返回 null
+ */
+extern "C" JNIEXPORT jobject JNICALL
+Java_com_luoxiaohei_lowlatencyinput_service_GyroscopeService_nativeGetRuntimeStats(
+    JNIEnv *env,
+    jclass /* clazz */)
+{
+    jobject buffer = env->NewDirectByteBuffer(&g_runtimeStats, static_cast<jlong>(sizeof(g_runtimeStats)));
+    if (buffer == nullptr) {
+        __android_log_print(ANDROID_LOG_ERROR, TAG, "nativeGetRuntimeStats: 创建 direct ByteBuffer 失败");
+    }
+    return buffer;
 }
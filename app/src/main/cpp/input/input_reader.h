@@ -1,57 +1,10 @@
 #ifndef INPUT_READER_H
 #define INPUT_READER_H
 
-#include <thread>
 #include <jni.h>
-#include <atomic>
-#include <mutex>
 #include <string>
-#include <vector>
 
-/**
- * @brief 可点击区域信息结构体
- */
-struct ClickableRegion {
-    std::string identifier;
-    int left = 0;
-    int top = 0;
-    int width = 0;
-    int height = 0;
-};
-
-/**
- * @brief 单个触摸点 (slot) 的状态信息
- */
-struct TouchPoint {
-    int id = -1;              // tracking ID, -1 表示抬起
-    int x = 0;
-    int y = 0;
-
-    bool isDown = false;      // 当前手指是否按下
-    bool maybeUiTap = false;  // 是否命中了 UI 区域
-    bool uiTapHandled = false;// 是否已处理（用于阻止回传普通触摸数据）
-    long long downTimestampMs = 0; // 按下时的时间戳 (毫秒)
-    std::string downRegionIdentifier; // 命中的区域标识
-    int downX = 0;
-    int downY = 0;
-
-    // --- 新增：长按延迟判断状态 ---
-    bool isCheckingForLongPressStart = false; // 是否正在检查长按开始
-    bool longPressStartSent = false;         // 是否已发送 0x08 包
-};
-
-// ----------------- 全局变量 -----------------
-extern std::atomic<bool> g_isRunning;                 // 控制线程是否继续运行
-extern std::vector<std::thread> g_readerThreads;
-extern std::mutex g_threadMutex;
-
-extern std::vector<ClickableRegion> g_clickableRegions;
-extern std::mutex g_regionMutex;
-
-extern int g_screenWidthPx;
-extern int g_screenHeightPx;
-extern int g_screenTopOffsetPx;
-extern int g_screenLeftOffsetPx;
+#include "input_types.h"
 
 /**
  * @brief JNI 接口：启动输入设备读取线程
@@ -119,6 +72,142 @@ Java_com_luoxiaohei_lowlatencyinput_service_GyroscopeService_nativeRequestSendUi
     jint y
 );
 
+/**
+ * @brief JNI: 配置 Native 线程 (调度策略/优先级、nice、CPU 绑定、栈预触碰与内存锁定)
+ * @param role 0 = 输入读取线程, 1 = 发送线程
+ * @param policy 0 = SCHED_OTHER, 1 = SCHED_FIFO, 2 = SCHED_RR
+ */
+extern "C" JNIEXPORT void JNICALL
+Java_com_luoxiaohei_lowlatencyinput_service_GyroscopeService_nativeConfigureThread(
+    JNIEnv *env,
+    jclass /* clazz */,
+    jint role,
+    jint policy,
+    jint rtPriority,
+    jint niceValue,
+    jlong cpuMask,
+    jint prefaultStackKb,
+    jboolean lockMemory,
+    jboolean lockAllMemory
+);
+
+/**
+ * @brief JNI: 开启/关闭抖动测量模式，开启时清空之前的统计
+ */
+extern "C" JNIEXPORT void JNICALL
+Java_com_luoxiaohei_lowlatencyinput_service_GyroscopeService_nativeSetJitterMeasurement(
+    JNIEnv *env,
+    jclass /* clazz */,
+    jboolean enabled
+);
+
+/**
+ * @brief JNI: 获取线程配置实际生效情况与唤醒延迟统计
+ */
+extern "C" JNIEXPORT jstring JNICALL
+Java_com_luoxiaohei_lowlatencyinput_service_GyroscopeService_nativeGetThreadReport(
+    JNIEnv *env,
+    jclass /* clazz */
+);
+
+/**
+ * @brief JNI: 开始把原始 input_event 捕获到 mmap 文件
+ */
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_luoxiaohei_lowlatencyinput_service_GyroscopeService_nativeStartInputCapture(
+    JNIEnv *env,
+    jclass /* clazz */,
+    jstring path,
+    jint maxEvents
+);
+
+/**
+ * @brief JNI: 停止捕获，返回已记录的事件数
+ */
+extern "C" JNIEXPORT jlong JNICALL
+Java_com_luoxiaohei_lowlatencyinput_service_GyroscopeService_nativeStopInputCapture(
+    JNIEnv *env,
+    jclass /* clazz */
+);
+
+/**
+ * @brief JNI: 经输入引擎回放捕获文件
+ */
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_luoxiaohei_lowlatencyinput_service_GyroscopeService_nativeStartInputReplay(
+    JNIEnv *env,
+    jclass /* clazz */,
+    jstring path,
+    jboolean originalTiming
+);
+
+/**
+ * @brief JNI: 停止回放
+ */
+extern "C" JNIEXPORT void JNICALL
+Java_com_luoxiaohei_lowlatencyinput_service_GyroscopeService_nativeStopInputReplay(
+    JNIEnv *env,
+    jclass /* clazz */
+);
+
+/**
+ * @brief JNI: 跟踪日志额外写入文件
+ */
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_luoxiaohei_lowlatencyinput_service_GyroscopeService_nativeSetTraceLogFile(
+    JNIEnv *env,
+    jclass /* clazz */,
+    jstring path
+);
+
+/**
+ * @brief JNI: 创建共享内存事件环，引擎输出切换到该环
+ */
+extern "C" JNIEXPORT jobject JNICALL
+Java_com_luoxiaohei_lowlatencyinput_service_GyroscopeService_nativeCreateInputRing(
+    JNIEnv *env,
+    jclass /* clazz */,
+    jint capacity
+);
+
+/**
+ * @brief JNI: 发布已消费位置并等待新事件
+ */
+extern "C" JNIEXPORT jlong JNICALL
+Java_com_luoxiaohei_lowlatencyinput_service_GyroscopeService_nativeAwaitInputRing(
+    JNIEnv *env,
+    jclass /* clazz */,
+    jlong consumedIndex,
+    jint timeoutMs
+);
+
+/**
+ * @brief JNI: 关闭事件环，引擎输出切回 JNI 批量上行
+ */
+extern "C" JNIEXPORT void JNICALL
+Java_com_luoxiaohei_lowlatencyinput_service_GyroscopeService_nativeCloseInputRing(
+    JNIEnv *env,
+    jclass /* clazz */
+);
+
+/**
+ * @brief JNI: 释放事件环
+ */
+extern "C" JNIEXPORT void JNICALL
+Java_com_luoxiaohei_lowlatencyinput_service_GyroscopeService_nativeReleaseInputRing(
+    JNIEnv *env,
+    jclass /* clazz */
+);
+
+/**
+ * @brief JNI: 运行时统计块（事件数、帧数、输出耗时、发送队列等）
+ */
+extern "C" JNIEXPORT jobject JNICALL
+Java_com_luoxiaohei_lowlatencyinput_service_GyroscopeService_nativeGetRuntimeStats(
+    JNIEnv *env,
+    jclass /* clazz */
+);
+
 /**
  * @brief 向 Java 层发送数据的方法 (定义在 jni_bridge.h/.cpp)，用于普通触摸流。
  *        注意在原工程中，这个函数通常由 jni_bridge 提供，以下仅声明。
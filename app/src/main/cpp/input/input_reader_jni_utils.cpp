@@ -1,286 +1,266 @@
 #include "input_reader_jni_utils.h"
-#include "../bridge/jni_bridge.h"   // 提供 g_jvm, g_serviceInstance 等 extern 声明
+#include "../bridge/jni_bridge.h"   // 提供 g_jvm, getThreadJniEnv
+#include "../common/trace_log.h"
 #include <android/log.h>
+#include <cstring>
 #include <string>
-#include <system_error>
-#include <nlohmann/json.hpp>
 
 // 日志标签
 #define TAG "NativeInputReader"
 
-// 使用 json 命名空间简化代码
-using json = nlohmann::json;
+namespace {
 
-// 这些全局引用在此文件内定义（与 .h 对应）
-jclass g_gyroServiceClass = nullptr;
-jmethodID g_sendUiEventMethod = nullptr;
-jmethodID g_sendUiLongPressMethod = nullptr;
-jmethodID g_sendUiPressDownMethod = nullptr;
+void clearPendingException(JNIEnv* env) {
+    if (env->ExceptionCheck()) {
+        env->ExceptionDescribe();
+        env->ExceptionClear();
+    }
+}
+
+template <typename T>
+inline uint8_t* putValue(uint8_t* out, T value) {
+    std::memcpy(out, &value, sizeof(T));
+    return out + sizeof(T);
+}
+
+} // namespace
+
+JniInputEventSink::~JniInputEventSink() {
+    // 全局引用需要 JNIEnv，应已由 releaseReferences 释放；这里只回收本地内存
+    delete[] batchData_;
+}
 
 /**
- * @brief JNI 初始化时调用，缓存 Class 和 Method ID
+ * @brief 缓存 Service 实例与方法 ID，创建批量缓冲区
  */
-bool initializeJniReferences(JNIEnv* env) {
+bool JniInputEventSink::initialize(JNIEnv* env, jobject serviceInstance) {
     __android_log_print(ANDROID_LOG_INFO, TAG, "开始初始化 JNI 引用...");
+    releaseReferences(env);
 
-    // 查找 GyroscopeService 类
-    jclass localClassRef = env->FindClass("com/luoxiaohei/lowlatencyinput/service/GyroscopeService");
-    if (localClassRef == nullptr) {
-        __android_log_print(ANDROID_LOG_ERROR, TAG, "初始化 JNI 失败: 找不到 GyroscopeService 类");
-        if (env->ExceptionCheck()) {
-            env->ExceptionDescribe();
-            env->ExceptionClear();
-        }
-        return false;
-    }
-
-    // 创建全局引用
-    g_gyroServiceClass = (jclass)env->NewGlobalRef(localClassRef);
-    env->DeleteLocalRef(localClassRef);
-    if (g_gyroServiceClass == nullptr) {
+    serviceInstance_ = env->NewGlobalRef(serviceInstance);
+    if (serviceInstance_ == nullptr) {
         __android_log_print(ANDROID_LOG_ERROR, TAG, "初始化 JNI 失败: 创建 GyroscopeService 全局引用失败");
-        if (env->ExceptionCheck()) { 
-            env->ExceptionDescribe(); 
-            env->ExceptionClear(); 
-        }
+        clearPendingException(env);
         return false;
     }
-    __android_log_print(ANDROID_LOG_DEBUG, TAG, "GyroscopeService 类全局引用创建成功: %p", g_gyroServiceClass);
 
-    // 获取 sendUiEventPacket 实例方法 ID
-    g_sendUiEventMethod = env->GetMethodID(
-        g_gyroServiceClass,
-        "sendUiEventPacket",
-        "(Ljava/lang/String;II)V"
-    );
-    if (g_sendUiEventMethod == nullptr) {
-        __android_log_print(ANDROID_LOG_ERROR, TAG, "初始化 JNI 失败: 找不到 sendUiEventPacket 方法");
-        if (env->ExceptionCheck()) { 
-            env->ExceptionDescribe(); 
-            env->ExceptionClear(); 
-        }
-        env->DeleteGlobalRef(g_gyroServiceClass);
-        g_gyroServiceClass = nullptr;
+    jclass serviceClass = env->GetObjectClass(serviceInstance_);
+    if (serviceClass == nullptr) {
+        __android_log_print(ANDROID_LOG_ERROR, TAG, "初始化 JNI 失败: 找不到 GyroscopeService 类");
+        clearPendingException(env);
+        releaseReferences(env);
         return false;
     }
-    __android_log_print(ANDROID_LOG_DEBUG, TAG, "sendUiEventPacket 方法 ID 获取成功: %p", g_sendUiEventMethod);
-
-    // 获取 sendUiLongPressPacket 实例方法 ID
-    g_sendUiLongPressMethod = env->GetMethodID(
-        g_gyroServiceClass,
-        "sendUiLongPressPacket",
-        "(Ljava/lang/String;II)V"
-    );
-    if (g_sendUiLongPressMethod == nullptr) {
-        __android_log_print(ANDROID_LOG_ERROR, TAG, "初始化 JNI 失败: 找不到 sendUiLongPressPacket 方法");
-        if (env->ExceptionCheck()) { 
-            env->ExceptionDescribe(); 
-            env->ExceptionClear(); 
-        }
-        env->DeleteGlobalRef(g_gyroServiceClass);
-        g_gyroServiceClass = nullptr;
-        g_sendUiEventMethod = nullptr;
+    onInputBatchMethod_ = env->GetMethodID(serviceClass, "onNativeInputBatch", "(Ljava/nio/ByteBuffer;I)V");
+    env->DeleteLocalRef(serviceClass);
+    if (onInputBatchMethod_ == nullptr) {
+        __android_log_print(ANDROID_LOG_ERROR, TAG, "初始化 JNI 失败: 找不到 onNativeInputBatch 方法");
+        clearPendingException(env);
+        releaseReferences(env);
         return false;
     }
-    __android_log_print(ANDROID_LOG_DEBUG, TAG, "sendUiLongPressPacket 方法 ID 获取成功: %p", g_sendUiLongPressMethod);
 
-    // 获取 sendUiPressDownPacket 实例方法 ID (用于按下事件)
-    g_sendUiPressDownMethod = env->GetMethodID(
-        g_gyroServiceClass,
-        "sendUiPressDownPacket",
-        "(Ljava/lang/String;IIJ)V" // 参数: String, int, int, long
-    );
-    if (g_sendUiPressDownMethod == nullptr) {
-        __android_log_print(ANDROID_LOG_ERROR, TAG, "初始化 JNI 失败: 找不到 sendUiPressDownPacket 方法");
-        if (env->ExceptionCheck()) { 
-            env->ExceptionDescribe(); 
-            env->ExceptionClear(); 
-        }
-        env->DeleteGlobalRef(g_gyroServiceClass);
-        g_gyroServiceClass = nullptr;
-        g_sendUiEventMethod = nullptr;
-        g_sendUiLongPressMethod = nullptr;
+    batchData_ = new uint8_t[INPUT_BATCH_BUFFER_BYTES];
+    jobject localBuffer = env->NewDirectByteBuffer(batchData_, static_cast<jlong>(INPUT_BATCH_BUFFER_BYTES));
+    if (localBuffer != nullptr) {
+        batchBufferRef_ = env->NewGlobalRef(localBuffer);
+        env->DeleteLocalRef(localBuffer);
+    }
+    if (batchBufferRef_ == nullptr) {
+        __android_log_print(ANDROID_LOG_ERROR, TAG, "初始化 JNI 失败: 创建 direct ByteBuffer 失败");
+        clearPendingException(env);
+        releaseReferences(env);
         return false;
     }
-    __android_log_print(ANDROID_LOG_DEBUG, TAG, "sendUiPressDownPacket 方法 ID 获取成功: %p", g_sendUiPressDownMethod);
+    batchLength_ = 0;
 
     __android_log_print(ANDROID_LOG_INFO, TAG, "JNI 引用初始化成功完成。");
     return true;
 }
 
 /**
- * @brief JNI 卸载时调用，清理全局引用
+ * @brief 清理全局引用与缓冲区
  */
-void cleanupJniReferences(JNIEnv* env) {
-    if (g_gyroServiceClass != nullptr) {
+void JniInputEventSink::releaseReferences(JNIEnv* env) {
+    if (serviceInstance_ != nullptr) {
         __android_log_print(ANDROID_LOG_INFO, TAG, "开始清理 JNI 全局引用...");
-        env->DeleteGlobalRef(g_gyroServiceClass);
-        g_gyroServiceClass = nullptr;
-        g_sendUiEventMethod = nullptr;
-        g_sendUiLongPressMethod = nullptr;
-        g_sendUiPressDownMethod = nullptr;
+        env->DeleteGlobalRef(serviceInstance_);
+        serviceInstance_ = nullptr;
         __android_log_print(ANDROID_LOG_INFO, TAG, "JNI 全局引用已清理。");
     }
+    if (batchBufferRef_ != nullptr) {
+        env->DeleteGlobalRef(batchBufferRef_);
+        batchBufferRef_ = nullptr;
+    }
+    delete[] batchData_;
+    batchData_ = nullptr;
+    batchLength_ = 0;
+    onInputBatchMethod_ = nullptr;
 }
 
 /**
- * @brief 调用 Java 实例方法 sendUiEventPacket(identifier, x, y)
+ * @brief 读取线程获取（并缓存）自己的 JNIEnv
  */
-void callSendUiEventPacketJNI(JNIEnv* env, const std::string& identifier, int x, int y) {
-    __android_log_print(ANDROID_LOG_INFO, TAG, 
-        "准备调用 sendUiEventPacket: identifier=%s, x=%d, y=%d", 
-        identifier.c_str(), x, y);
-
-    // 使用缓存的实例引用和方法ID
-    if (!g_serviceInstance || !g_sendUiEventMethod) {
-        __android_log_print(ANDROID_LOG_ERROR, TAG, 
-            "callSendUiEventPacketJNI: Service实例或方法ID未初始化!");
-        return;
-    }
-
-    jstring jIdentifier = env->NewStringUTF(identifier.c_str());
-    if (env->ExceptionCheck()) {
-        __android_log_print(ANDROID_LOG_ERROR, TAG, 
-            "callSendUiEventPacketJNI: NewStringUTF 失败");
-        env->ExceptionDescribe();
-        env->ExceptionClear();
-        return;
-    }
-    if (jIdentifier == nullptr) {
-        __android_log_print(ANDROID_LOG_ERROR, TAG, 
-            "callSendUiEventPacketJNI: NewStringUTF 返回 null");
-        return;
+bool JniInputEventSink::onReaderThreadStart() {
+    if (!serviceInstance_ || !batchBufferRef_) {
+        __android_log_print(ANDROID_LOG_ERROR, TAG, "onReaderThreadStart: Service 实例未初始化");
+        return false;
     }
-
-    env->CallVoidMethod(g_serviceInstance, g_sendUiEventMethod, jIdentifier, (jint)x, (jint)y);
-    if (env->ExceptionCheck()) {
-        __android_log_print(ANDROID_LOG_ERROR, TAG, 
-            "callSendUiEventPacketJNI: CallVoidMethod 失败");
-        env->ExceptionDescribe();
-        env->ExceptionClear();
-    } else {
-        __android_log_print(ANDROID_LOG_INFO, TAG, 
-            "Java sendUiEventPacket 方法调用成功");
+    threadEnv_ = getThreadJniEnv("NativeInputReader");
+    if (!threadEnv_) {
+        __android_log_print(ANDROID_LOG_ERROR, TAG, "onReaderThreadStart: 附加到 JVM 失败");
+        return false;
     }
-
-    env->DeleteLocalRef(jIdentifier); // 释放局部引用
+    batchLength_ = 0;
+    return true;
 }
 
 /**
- * @brief 调用 Java 实例方法 sendUiLongPressPacket(identifier, x, y)
+ * @brief 读取线程不再使用该输出：送出剩余数据。线程退出时由 jni_bridge 自动分离。
  */
-void callSendUiLongPressPacketJNI(JNIEnv* env, const std::string& identifier, int x, int y) {
-    __android_log_print(ANDROID_LOG_INFO, TAG, 
-        "准备调用 sendUiLongPressPacket: identifier=%s, x=%d, y=%d", 
-        identifier.c_str(), x, y);
+void JniInputEventSink::onReaderThreadStop() {
+    flush();
+    threadEnv_ = nullptr;
+}
 
-    if (!g_serviceInstance || !g_sendUiLongPressMethod) {
-        __android_log_print(ANDROID_LOG_ERROR, TAG, 
-            "callSendUiLongPressPacketJNI: Service实例或方法ID未初始化!");
-        return;
+/**
+ * @brief 在缓冲区中预留空间，不足时先把已有内容送出
+ */
+uint8_t* JniInputEventSink::reserve(size_t bytes) {
+    if (!threadEnv_ || bytes > INPUT_BATCH_BUFFER_BYTES) {
+        return nullptr;
+    }
+    if (batchLength_ + bytes > INPUT_BATCH_BUFFER_BYTES) {
+        flush();
     }
+    uint8_t* out = batchData_ + batchLength_;
+    batchLength_ += bytes;
+    return out;
+}
 
-    jstring jIdentifier = env->NewStringUTF(identifier.c_str());
-    if (env->ExceptionCheck()) {
-        __android_log_print(ANDROID_LOG_ERROR, TAG, 
-            "callSendUiLongPressPacketJNI: NewStringUTF 失败");
-        env->ExceptionDescribe();
-        env->ExceptionClear();
+void JniInputEventSink::onTouchFrame(const TouchContact* contacts, int count, long long timestampMs,
+                                     bool extended) {
+    if (count <= 0) {
         return;
     }
-    if (jIdentifier == nullptr) {
-        __android_log_print(ANDROID_LOG_ERROR, TAG, 
-            "callSendUiLongPressPacketJNI: NewStringUTF 返回 null");
+    if (count > 255) count = 255;
+    const size_t contactBytes = extended ? 16 : 12;
+    uint8_t* out = reserve(4 + 8 + static_cast<size_t>(count) * contactBytes);
+    if (!out) {
         return;
     }
-
-    env->CallVoidMethod(g_serviceInstance, g_sendUiLongPressMethod, jIdentifier, (jint)x, (jint)y);
-    if (env->ExceptionCheck()) {
-        __android_log_print(ANDROID_LOG_ERROR, TAG, 
-            "callSendUiLongPressPacketJNI: CallVoidMethod 失败");
-        env->ExceptionDescribe();
-        env->ExceptionClear();
-    } else {
-        __android_log_print(ANDROID_LOG_INFO, TAG, 
-            "Java sendUiLongPressPacket 方法调用成功");
+    out = putValue<uint8_t>(out, INPUT_BATCH_RECORD_TOUCH_FRAME);
+    out = putValue<uint8_t>(out, static_cast<uint8_t>(count));
+    out = putValue<uint16_t>(out, extended ? INPUT_BATCH_TOUCH_FLAG_EXTENDED : 0);
+    out = putValue<int64_t>(out, timestampMs);
+    for (int i = 0; i < count; ++i) {
+        out = putValue<int32_t>(out, contacts[i].id);
+        out = putValue<int32_t>(out, contacts[i].x);
+        out = putValue<int32_t>(out, contacts[i].y);
+        if (extended) {
+            out = putValue<uint16_t>(out, contacts[i].pressure);
+            out = putValue<uint16_t>(out, contacts[i].touchMajor);
+        }
     }
-
-    env->DeleteLocalRef(jIdentifier); 
 }
 
-/**
- * @brief 调用 Java 实例方法 sendUiPressDownPacket(identifier, x, y, downTimestampMs)
- */
-void callSendUiPressDownPacketJNI(JNIEnv* env, const std::string& identifier, int x, int y, long long downTimestampMs) {
-    __android_log_print(ANDROID_LOG_INFO, TAG, 
-        "准备调用 sendUiPressDownPacket: identifier=%s, x=%d, y=%d, downTs=%lld",
-        identifier.c_str(), x, y, downTimestampMs);
-
-    if (!g_serviceInstance || !g_sendUiPressDownMethod) {
-        __android_log_print(ANDROID_LOG_ERROR, TAG, 
-            "callSendUiPressDownPacketJNI: Service实例或方法ID未初始化!");
+void JniInputEventSink::onUiEvent(UiEventKind kind, const ClickableRegion& region,
+                                  int x, int y, long long downTimestampMs) {
+    uint8_t recordKind = INPUT_BATCH_RECORD_UI_TAP;
+    switch (kind) {
+        case UiEventKind::Tap: recordKind = INPUT_BATCH_RECORD_UI_TAP; break;
+        case UiEventKind::PressDown: recordKind = INPUT_BATCH_RECORD_UI_PRESS_DOWN; break;
+        case UiEventKind::LongPressEnd: recordKind = INPUT_BATCH_RECORD_UI_LONG_PRESS_END; break;
+    }
+    const size_t identifierLength = region.identifier.size() > 0xFFFF ? 0xFFFF : region.identifier.size();
+    const size_t paddedLength = (identifierLength + 3) & ~static_cast<size_t>(3);
+    uint8_t* out = reserve(4 + 4 + 4 + 8 + paddedLength);
+    if (!out) {
         return;
     }
+    out = putValue<uint8_t>(out, recordKind);
+    out = putValue<uint8_t>(out, 0);
+    out = putValue<uint16_t>(out, static_cast<uint16_t>(identifierLength));
+    out = putValue<int32_t>(out, x);
+    out = putValue<int32_t>(out, y);
+    out = putValue<int64_t>(out, downTimestampMs);
+    std::memcpy(out, region.identifier.data(), identifierLength);
+    std::memset(out + identifierLength, 0, paddedLength - identifierLength);
+}
 
-    jstring jIdentifier = env->NewStringUTF(identifier.c_str());
-    if (env->ExceptionCheck()) {
-        __android_log_print(ANDROID_LOG_ERROR, TAG, 
-            "callSendUiPressDownPacketJNI: NewStringUTF 失败");
-        env->ExceptionDescribe();
-        env->ExceptionClear();
+void JniInputEventSink::onGesture(const ClickableRegion& region, const GestureEvent& gesture) {
+    const size_t identifierLength = region.identifier.size() > 0xFFFF ? 0xFFFF : region.identifier.size();
+    const size_t paddedLength = (identifierLength + 3) & ~static_cast<size_t>(3);
+    uint8_t* out = reserve(4 + 4 + 16 + 8 + paddedLength);
+    if (!out) {
         return;
     }
-    if (jIdentifier == nullptr) {
-        __android_log_print(ANDROID_LOG_ERROR, TAG, 
-            "callSendUiPressDownPacketJNI: NewStringUTF 返回 null");
+    out = putValue<uint8_t>(out, INPUT_BATCH_RECORD_UI_GESTURE);
+    out = putValue<uint8_t>(out, static_cast<uint8_t>(gesture.kind));
+    out = putValue<uint16_t>(out, static_cast<uint16_t>(identifierLength));
+    out = putValue<uint8_t>(out, gesture.fingers);
+    out = putValue<uint8_t>(out, static_cast<uint8_t>(gesture.direction));
+    out = putValue<uint16_t>(out, 0);
+    out = putValue<int32_t>(out, gesture.x);
+    out = putValue<int32_t>(out, gesture.y);
+    out = putValue<int32_t>(out, gesture.dx);
+    out = putValue<int32_t>(out, gesture.dy);
+    out = putValue<int64_t>(out, gesture.timestampMs);
+    std::memcpy(out, region.identifier.data(), identifierLength);
+    std::memset(out + identifierLength, 0, paddedLength - identifierLength);
+}
+
+void JniInputEventSink::onPenSample(const PenSample& sample) {
+    uint8_t* out = reserve(4 + 8 + 8 + 8);
+    if (!out) {
         return;
     }
+    out = putValue<uint8_t>(out, INPUT_BATCH_RECORD_PEN);
+    out = putValue<uint8_t>(out, sample.flags);
+    out = putValue<uint16_t>(out, sample.pressure);
+    out = putValue<int32_t>(out, sample.x);
+    out = putValue<int32_t>(out, sample.y);
+    out = putValue<uint16_t>(out, sample.distance);
+    out = putValue<int16_t>(out, sample.tiltX);
+    out = putValue<int16_t>(out, sample.tiltY);
+    out = putValue<uint16_t>(out, 0);
+    out = putValue<int64_t>(out, sample.timestampUs);
+}
 
-    env->CallVoidMethod(g_serviceInstance, g_sendUiPressDownMethod, jIdentifier, (jint)x, (jint)y, (jlong)downTimestampMs);
-    if (env->ExceptionCheck()) {
-        __android_log_print(ANDROID_LOG_ERROR, TAG, 
-            "callSendUiPressDownPacketJNI: CallVoidMethod 失败");
-        env->ExceptionDescribe();
-        env->ExceptionClear();
-    } else {
-        __android_log_print(ANDROID_LOG_INFO, TAG, 
-            "Java sendUiPressDownPacket 方法调用成功");
+void JniInputEventSink::onHidFrame(const HidFrame& frame) {
+    uint8_t* out = reserve(4 + 4 + 8 + static_cast<size_t>(frame.count) * 8);
+    if (!out) {
+        return;
+    }
+    out = putValue<uint8_t>(out, INPUT_BATCH_RECORD_HID);
+    out = putValue<uint8_t>(out, static_cast<uint8_t>(frame.count));
+    out = putValue<uint8_t>(out, frame.deviceId);
+    out = putValue<uint8_t>(out, frame.deviceClass);
+    out = putValue<uint8_t>(out, frame.flags);
+    out = putValue<uint8_t>(out, 0);
+    out = putValue<uint16_t>(out, 0);
+    out = putValue<int64_t>(out, frame.timestampUs);
+    for (int i = 0; i < frame.count; ++i) {
+        out = putValue<uint8_t>(out, frame.changes[i].type);
+        out = putValue<uint8_t>(out, 0);
+        out = putValue<uint16_t>(out, frame.changes[i].code);
+        out = putValue<int32_t>(out, frame.changes[i].value);
     }
-
-    env->DeleteLocalRef(jIdentifier); 
 }
 
 /**
- * @brief 直接调用 Java 的 onInputDataReceivedFromNative 发送普通触摸数据
+ * @brief 一次 JNI 调用送出本批次的所有记录
  */
-void sendTouchEventToJava(JNIEnv* env, const std::string& data) {
-    if (!g_serviceInstance || !g_onInputDataReceivedMethodID_Service) {
-        __android_log_print(ANDROID_LOG_ERROR, TAG, 
-            "sendTouchEventToJava: Service 实例或 MethodID 为空");
+void JniInputEventSink::flush() {
+    JNIEnv* env = threadEnv_;
+    if (!env || batchLength_ == 0) {
         return;
     }
-
-    jstring jData = env->NewStringUTF(data.c_str());
+    const jint length = static_cast<jint>(batchLength_);
+    batchLength_ = 0;
+    env->CallVoidMethod(serviceInstance_, onInputBatchMethod_, batchBufferRef_, length);
     if (env->ExceptionCheck()) {
-        __android_log_print(ANDROID_LOG_ERROR, TAG, 
-            "sendTouchEventToJava: NewStringUTF 失败");
-        env->ExceptionDescribe();
-        env->ExceptionClear();
-        return;
-    }
-    if (jData == nullptr) {
-        __android_log_print(ANDROID_LOG_ERROR, TAG, 
-            "sendTouchEventToJava: NewStringUTF 返回 null");
-        return;
-    }
-
-    env->CallVoidMethod(g_serviceInstance, g_onInputDataReceivedMethodID_Service, jData);
-    if (env->ExceptionCheck()) {
-        __android_log_print(ANDROID_LOG_ERROR, TAG, 
-            "sendTouchEventToJava: CallVoidMethod 失败");
-        env->ExceptionDescribe();
-        env->ExceptionClear();
+        TRACE_E(TraceEvent::JniBatchFailed, length);
+        clearPendingException(env);
     }
-
-    env->DeleteLocalRef(jData);
 }
@@ -2,119 +2,89 @@
 #define INPUT_READER_JNI_UTILS_H
 
 #include <jni.h>
-#include "input_reader.h" // 包含定义了 ClickableRegion 和 TouchPoint 的头文件
+#include "input_engine.h"
 
-#include <thread>
-#include <atomic>
-#include <mutex>
+#include <cstddef>
+#include <cstdint>
 #include <string>
-#include <vector>
-
-
-/**
- * @brief JNI 接口：启动输入设备读取线程
- */
-void nativeStartInputReaderService(JNIEnv* env, jobject instance);
-
-/**
- * @brief JNI 接口：停止输入设备读取线程
- */
-void nativeStopInputReaderService(JNIEnv* env, jobject instance);
-
-/**
- * @brief JNI: 更新可点击区域
- */
-extern "C" JNIEXPORT void JNICALL
-Java_com_luoxiaohei_lowlatencyinput_service_GyroscopeService_nativeUpdateClickableRegions(
-    JNIEnv* env,
-    jclass /* clazz */,
-    jstring jsonData
-);
-
-/**
- * @brief JNI: 设置屏幕尺寸
- */
-extern "C" JNIEXPORT void JNICALL
-Java_com_luoxiaohei_lowlatencyinput_service_GyroscopeService_nativeSetScreenDimensions(
-    JNIEnv* env,
-    jclass /* clazz */,
-    jint width,
-    jint height
-);
-
-/**
- * @brief JNI: 设置屏幕偏移 (如状态栏高度)
- */
-extern "C" JNIEXPORT void JNICALL
-Java_com_luoxiaohei_lowlatencyinput_service_GyroscopeService_nativeSetScreenOffsets(
-    JNIEnv* env,
-    jclass /* clazz */,
-    jint topOffset,
-    jint leftOffset
-);
-
-/**
- * @brief JNI: Native 请求发送 UI 点击事件包（在 C++ 中仅做空实现，逻辑在 Java 层）
- */
-extern "C" JNIEXPORT void JNICALL
-Java_com_luoxiaohei_lowlatencyinput_service_GyroscopeService_nativeRequestSendUiEventPacket(
-    JNIEnv* env,
-    jclass /* clazz */,
-    jstring identifier,
-    jint x,
-    jint y
-);
 
 /**
- * @brief JNI: Native 请求发送 UI 长按事件包（在 C++ 中仅做空实现，逻辑在 Java 层）
- */
-extern "C" JNIEXPORT void JNICALL
-Java_com_luoxiaohei_lowlatencyinput_service_GyroscopeService_nativeRequestSendUiLongPressPacket(
-    JNIEnv* env,
-    jclass /* clazz */,
-    jstring identifier,
-    jint x,
-    jint y
-);
-
-/**
- * @brief 向 Java 层发送数据的方法 (定义在 jni_bridge.h/.cpp)，用于普通触摸流。
+ * 批量上行缓冲区中的记录格式（本机字节序，Java 侧用 ByteOrder.nativeOrder() 读取）：
  *
- * 注意在原工程中，这个函数通常由 jni_bridge 提供，以下仅声明。
- */
-extern void sendDataToJavaService(const std::string& data);
-
-/**
- * @brief 初始化 JNI 引用 (缓存类和方法 ID)
- * @param env JNI 环境指针
- * @return true 如果成功，false 如果失败
- */
-bool initializeJniReferences(JNIEnv* env);
-
-/**
- * @brief 清理 JNI 全局引用
- * @param env JNI 环境指针
+ *   触摸帧:   u8 kind=1, u8 count, u16 flags, i64 timestampMs, count × (i32 id, i32 x, i32 y)
+ *             flags 含 INPUT_BATCH_TOUCH_FLAG_EXTENDED 时每个触摸点后附 u16 pressure, u16 touchMajor（千分比）
+ *   区域事件: u8 kind=2/3/4, u8 0, u16 identifierLength, i32 x, i32 y, i64 downTimestampMs,
+ *             identifier (UTF-8)，按 4 字节补齐
+ *   区域手势: u8 kind=5, u8 gestureKind, u16 identifierLength, u8 fingers, u8 direction, u16 0,
+ *             i32 x, i32 y, i32 dx, i32 dy, i64 timestampMs, identifier (UTF-8)，按 4 字节补齐
+ *   笔采样:   u8 kind=6, u8 flags (PEN_FLAG_*), u16 pressure, i32 x, i32 y, u16 distance,
+ *             i16 tiltX, i16 tiltY, u16 0, i64 timestampUs
+ *   外接设备: u8 kind=7, u8 count, u8 deviceId, u8 deviceClass, u8 flags (HID_FRAME_*), u8 0, u16 0,
+ *             i64 timestampUs, count × (u8 type, u8 0, u16 code, i32 value)
+ *
+ * 与 GyroscopeService.onNativeInputBatch 中的解析保持一致。
  */
-void cleanupJniReferences(JNIEnv* env);
+static constexpr uint8_t INPUT_BATCH_RECORD_TOUCH_FRAME = 1;
+static constexpr uint8_t INPUT_BATCH_RECORD_UI_TAP = 2;
+static constexpr uint8_t INPUT_BATCH_RECORD_UI_PRESS_DOWN = 3;
+static constexpr uint8_t INPUT_BATCH_RECORD_UI_LONG_PRESS_END = 4;
+static constexpr uint8_t INPUT_BATCH_RECORD_UI_GESTURE = 5;
+static constexpr uint8_t INPUT_BATCH_RECORD_PEN = 6;
+static constexpr uint8_t INPUT_BATCH_RECORD_HID = 7;
 
-/**
- * @brief 调用 Java 层的 sendUiEventPacket 方法
- */
-void callSendUiEventPacketJNI(JNIEnv* env, const std::string& identifier, int x, int y);
+static constexpr uint16_t INPUT_BATCH_TOUCH_FLAG_EXTENDED = 0x0001;
 
-/**
- * @brief 调用 Java 层的 sendUiLongPressPacket 方法
- */
-void callSendUiLongPressPacketJNI(JNIEnv* env, const std::string& identifier, int x, int y);
+static constexpr size_t INPUT_BATCH_BUFFER_BYTES = 64 * 1024;
 
 /**
- * @brief 调用 Java 层的 sendUiPressDownPacket 方法
- */
-void callSendUiPressDownPacketJNI(JNIEnv* env, const std::string& identifier, int x, int y, long long downTimestampMs);
-
-/**
- * @brief 发送普通触摸事件数据到 Java 层
+ * @brief 把引擎输出转发给 GyroscopeService 的 JNI 输出
+ *
+ * 一次 read() 产生的所有触摸帧与区域事件先写入一块复用的 direct ByteBuffer，
+ * 在 flush() 时通过一次 onNativeInputBatch(ByteBuffer, int) 上行，
+ * 不再为每帧创建 jstring。读取线程的 JNIEnv 由 getThreadJniEnv 缓存，线程退出时自动分离。
+ * 全局引用与缓冲区由创建者在引擎停止后通过 releaseReferences 释放。
  */
-void sendTouchEventToJava(JNIEnv* env, const std::string& data);
+class JniInputEventSink : public InputEventSink {
+public:
+    JniInputEventSink() = default;
+    ~JniInputEventSink() override;
+
+    JniInputEventSink(const JniInputEventSink&) = delete;
+    JniInputEventSink& operator=(const JniInputEventSink&) = delete;
+
+    /**
+     * @brief 缓存 Service 实例全局引用、方法 ID，并创建批量缓冲区
+     * @return true 如果成功，false 如果失败（已清理部分创建的引用）
+     */
+    bool initialize(JNIEnv* env, jobject serviceInstance);
+
+    /**
+     * @brief 释放全局引用与缓冲区。调用前读取线程必须已停止使用该输出。
+     */
+    void releaseReferences(JNIEnv* env);
+
+    bool onReaderThreadStart() override;
+    void onReaderThreadStop() override;
+    void onTouchFrame(const TouchContact* contacts, int count, long long timestampMs,
+                      bool extended) override;
+    void onUiEvent(UiEventKind kind, const ClickableRegion& region,
+                   int x, int y, long long downTimestampMs) override;
+    void onGesture(const ClickableRegion& region, const GestureEvent& gesture) override;
+    void onPenSample(const PenSample& sample) override;
+    void onHidFrame(const HidFrame& frame) override;
+    void flush() override;
+
+private:
+    uint8_t* reserve(size_t bytes);
+
+    jobject serviceInstance_ = nullptr;
+    jmethodID onInputBatchMethod_ = nullptr;
+    jobject batchBufferRef_ = nullptr;   // 包装 batchData_ 的 direct ByteBuffer 全局引用
+    uint8_t* batchData_ = nullptr;
+
+    // 读取线程私有
+    JNIEnv* threadEnv_ = nullptr;
+    size_t batchLength_ = 0;
+};
 
 #endif // INPUT_READER_JNI_UTILS_H
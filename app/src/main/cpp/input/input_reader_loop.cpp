@@ -1,470 +1,273 @@
-#include "input_reader_loop.h"
-#include "input_reader_jni_utils.h"
+#include "input_engine.h"
 #include "input_reader_permissions.h"
+#include "privileged_helper.h"
 
-#include "input_reader.h"
-#include <nlohmann/json.hpp>
 #include <thread>
 #include <atomic>
 #include <mutex>
-#include <condition_variable>
 #include <sstream>
 #include <chrono>
+#include <ctime>
 #include <algorithm>
-#include <functional>
+#include <climits>
+#include <cmath>
+#include <cstring>
 #include <fcntl.h>
 #include <unistd.h>
 #include <linux/input.h>
 #include <linux/input-event-codes.h>
 #include <android/log.h>
+#include <sys/ioctl.h>
 #include <sys/poll.h>
+#include <sys/inotify.h>
+#include <dirent.h>
 #include <cerrno>
-#include <system_error>
-#include "../bridge/jni_bridge.h"
-
-// 使用 json 命名空间简化代码
-using json = nlohmann::json;
+#include "../common/runtime_stats.h"
+#include "../common/thread_config.h"
+#include "../common/trace_log.h"
 
 // 日志标签
 #define TAG "NativeInputReader"
 
 // 长按开始检测的延迟常量（毫秒）
 static constexpr long long LONG_PRESS_START_DELAY_MS = 150;
-// 目标触摸设备路径 (示例)，如果需要自定义，这里可以改成可配置
-static constexpr const char* TOUCH_DEVICE_PATH_DEFAULT = "/dev/input/event4";
-static constexpr int MAX_SLOTS = 10;
+
+// 触摸质量过滤的拒绝原因（跟踪日志中输出）
+static constexpr int TOUCH_REJECT_NONE = 0;
+static constexpr int TOUCH_REJECT_SIZE = 1;
+static constexpr int TOUCH_REJECT_PRESSURE = 2;
+static constexpr int TOUCH_REJECT_EDGE = 3;
+static constexpr int TOUCH_REJECT_PALM_TOOL = 4;
+
+#ifndef MT_TOOL_PALM
+#define MT_TOOL_PALM 0x02
+#endif
+
+static long long realtimeNowUs() {
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    return static_cast<long long>(now.tv_sec) * 1000000 + now.tv_nsec / 1000;
+}
+
+static int64_t steadyNowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static long long steadyNowMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
 
 /**
- * @brief 输入读取线程主循环
+ * @brief 读取线程主循环
  */
-void inputReaderLoop(const char* devicePath) {
+void InputEngine::readerThreadMain() {
     static constexpr size_t EVENT_SIZE = sizeof(struct input_event);
 
-    __android_log_print(ANDROID_LOG_INFO, TAG,
-        "inputReaderLoop: 线程已启动，准备处理设备 %s", devicePath);
-
     std::thread::id this_id = std::this_thread::get_id();
     std::stringstream ss_id;
     ss_id << this_id;
     const std::string threadTag = ss_id.str();
 
-    int fd = open(devicePath, O_RDONLY | O_NONBLOCK);
-    if (fd < 0) {
-        __android_log_print(ANDROID_LOG_WARN, TAG,
-            "触摸线程 %s: 初次打开 %s 失败: %s (%d)，尝试修复权限...",
-            threadTag.c_str(), devicePath, strerror(errno), errno);
-        if (errno == EACCES || errno == EPERM) {
-            if (tryFixPermissions(devicePath)) {
-                std::this_thread::sleep_for(std::chrono::milliseconds(200));
-                fd = open(devicePath, O_RDONLY | O_NONBLOCK);
-                if (fd >= 0) {
-                    __android_log_print(ANDROID_LOG_INFO, TAG,
-                        "触摸线程 %s: 修复后成功打开 %s", threadTag.c_str(), devicePath);
-                }
-            }
-        }
-    }
-    if (fd < 0) {
-        __android_log_print(ANDROID_LOG_ERROR, TAG,
-            "inputReaderLoop: 无法打开 %s，线程退出。", devicePath);
-        return;
-    }
-
-    __android_log_print(ANDROID_LOG_INFO, TAG,
-        "inputReaderLoop: 成功打开设备 %s (fd=%d)", devicePath, fd);
-
-    // 附加到 JVM
-    JNIEnv* env = nullptr;
-    if (g_jvm->AttachCurrentThread(&env, nullptr) != JNI_OK || !env) {
-        __android_log_print(ANDROID_LOG_ERROR, TAG,
-            "触摸线程 %s: 附加到 JVM 失败，退出。", threadTag.c_str());
-        close(fd);
-        return;
-    }
     __android_log_print(ANDROID_LOG_INFO, TAG,
-        "触摸线程 %s: 已附加到 JVM。", threadTag.c_str());
-
-    // 读取 ABS 范围，用于坐标转换
-    int nativeMaxX = 0;
-    int nativeMaxY = 0;
-    {
-        struct input_absinfo absinfo_x;
-        if (ioctl(fd, EVIOCGABS(ABS_MT_POSITION_X), &absinfo_x) == 0) {
-            nativeMaxX = absinfo_x.maximum;
-            __android_log_print(ANDROID_LOG_INFO, TAG,
-                "Native X-axis range: min=%d, max=%d", absinfo_x.minimum, absinfo_x.maximum);
-        } else {
-            __android_log_print(ANDROID_LOG_WARN, TAG,
-                "无法获取 ABS_MT_POSITION_X info: %s", strerror(errno));
-        }
-        struct input_absinfo absinfo_y;
-        if (ioctl(fd, EVIOCGABS(ABS_MT_POSITION_Y), &absinfo_y) == 0) {
-            nativeMaxY = absinfo_y.maximum;
-            __android_log_print(ANDROID_LOG_INFO, TAG,
-                "Native Y-axis range: min=%d, max=%d", absinfo_y.minimum, absinfo_y.maximum);
-        } else {
-            __android_log_print(ANDROID_LOG_WARN, TAG,
-                "无法获取 ABS_MT_POSITION_Y info: %s", strerror(errno));
-        }
-    }
+        "触摸线程 %s: 已启动。", threadTag.c_str());
 
-    struct pollfd pfd;
-    pfd.fd = fd;
-    pfd.events = POLLIN;
-    pfd.revents = 0;
+    // 应用调度/绑核/内存锁定配置（若 Java 层已设置）
+    uint32_t threadConfigGeneration = 0;
+    applyThreadConfigIfChanged(ThreadRole::InputReader, threadConfigGeneration);
 
-    // 本地维护的触摸点信息
-    TouchPoint localTouches[MAX_SLOTS];
-    for (int i = 0; i < MAX_SLOTS; i++) {
-        localTouches[i].id = -1;
-    }
+    // 提前登记本线程的跟踪缓冲区，热路径上第一次 TRACE_* 不再加锁分配
+    traceThreadBuffer();
 
-    int currentSlot = 0;
-    bool touchDataUpdated = false;
+    ConfigSnapshot active;
+    uint32_t seenConfigGeneration = 0;
+    resetTouchState();
 
     static constexpr size_t READ_BUF_SIZE = sizeof(input_event) * 64;
     unsigned char readBuffer[READ_BUF_SIZE];
-    unsigned char leftoverBuf[READ_BUF_SIZE];
+    unsigned char leftoverBuf[EVENT_SIZE];
     size_t leftoverCount = 0;
 
     size_t totalBytesRead = 0;
     auto lastLogTime = std::chrono::steady_clock::now();
+    ThreadCpuSampler cpuSampler(RuntimeStatsField::ReaderCpuNs, false);
+
+    while (running_.load(std::memory_order_acquire)) {
+        // 配置变更后重新应用；抖动统计按配置分段，切换时清空
+        if (applyThreadConfigIfChanged(ThreadRole::InputReader, threadConfigGeneration)
+            && jitterEnabled_.load(std::memory_order_relaxed)) {
+            wakeupLatency_.reset();
+        }
+
+        // 取走新的设备/区域/变换/输出配置
+        const uint32_t generation = configGeneration_.load(std::memory_order_acquire);
+        if (generation != seenConfigGeneration) {
+            seenConfigGeneration = generation;
+            const int previousFd = deviceFd_;
+            reloadConfig(active);
+            if (deviceFd_ != previousFd) {
+                leftoverCount = 0;
+            }
+        }
+
+        // 外部 fd 结束后回到真实设备
+        if (usingAdoptedFd_ && deviceFd_ < 0) {
+            usingAdoptedFd_ = false;
+            leftoverCount = 0;
+            if (!active.devicePath.empty() && openDevice(active.devicePath)) {
+                applyEventMask(active);
+                applyExclusiveGrab(active.exclusiveGrab);
+                if (active.capture) {
+                    active.capture->setDeviceAxes(CAPTURE_DEVICE_TOUCH, CaptureDeviceAxes{nativeMaxX_, nativeMaxY_});
+                }
+            }
+        }
 
-    static constexpr int POLL_TIMEOUT_MS = 1;
-    // 下列常量目前并未在本循环中使用
-    static constexpr long long TAP_TIMEOUT_MS = 200;
-    static constexpr long long LONG_PRESS_THRESHOLD_MS = 500;
+        // 唤醒 fd、触摸设备、独立的笔设备、/dev/input 监视、外接输入设备；
+        // 设备未打开时用 -1 占位，poll 忽略负 fd
+        static constexpr int POLL_HID_FIRST = 4;
+        struct pollfd pfds[POLL_HID_FIRST + HID_DEVICE_LIMIT];
+        pfds[0].fd = wakeFd_;
+        pfds[1].fd = deviceFd_;
+        pfds[2].fd = penFd_;
+        pfds[3].fd = hidWatchFd_;
+        nfds_t nfds = deviceFd_ >= 0 ? 2 : 1;
+        if (penFd_ >= 0) nfds = 3;
+        if (hidWatchFd_ >= 0) nfds = POLL_HID_FIRST;
+        for (int i = 0; i < HID_DEVICE_LIMIT; ++i) {
+            pfds[POLL_HID_FIRST + i].fd = hidDevices_[i].fd;
+            if (hidDevices_[i].fd >= 0) nfds = POLL_HID_FIRST + i + 1;
+        }
+        for (auto& pfd : pfds) {
+            pfd.events = POLLIN;
+            pfd.revents = 0;
+        }
 
-    while (g_isRunning.load(std::memory_order_relaxed)) {
-        int pollRet = poll(&pfd, 1, POLL_TIMEOUT_MS);
+        int pollRet = poll(pfds, nfds, nextPollTimeoutMs());
         if (pollRet < 0) {
             if (errno == EINTR) continue;
             __android_log_print(ANDROID_LOG_ERROR, TAG,
                 "触摸线程 %s: poll 错误: %s (%d)，停止。",
                 threadTag.c_str(), strerror(errno), errno);
             break;
-        } else if (pollRet == 0) {
-            // 超时，无事件
-            continue;
-        }
-        if (pfd.revents & (POLLERR | POLLHUP | POLLNVAL)) {
-            __android_log_print(ANDROID_LOG_ERROR, TAG,
-                "触摸线程 %s: poll revents=%d，停止。",
-                threadTag.c_str(), pfd.revents);
-            break;
-        }
-        // 可读
-        if (!(pfd.revents & POLLIN)) {
-            continue;
         }
 
-        // 读取数据（可能一次性读到多个 struct input_event）
-        ssize_t bytesRead = read(fd, readBuffer, READ_BUF_SIZE);
-        if (bytesRead < 0) {
-            if (errno == EAGAIN || errno == EWOULDBLOCK) {
-                continue;
-            }
-            __android_log_print(ANDROID_LOG_ERROR, TAG,
-                "触摸线程 %s: read 错误: %s (%d), 停止。",
-                threadTag.c_str(), strerror(errno), errno);
-            break;
-        } else if (bytesRead == 0) {
-            __android_log_print(ANDROID_LOG_INFO, TAG,
-                "触摸线程 %s: read=0(EOF)，设备被移除？停止。",
-                threadTag.c_str());
-            break;
+        if (pfds[0].revents & POLLIN) {
+            uint64_t counter = 0;
+            ssize_t ret = read(wakeFd_, &counter, sizeof(counter));
+            (void)ret;
         }
 
-        totalBytesRead += bytesRead;
-        size_t bufferOffset = 0;
+        if (deviceFd_ >= 0 && (pfds[1].revents & (POLLERR | POLLHUP | POLLNVAL))) {
+            __android_log_print(ANDROID_LOG_ERROR, TAG,
+                "触摸线程 %s: poll revents=%d，关闭设备并等待重新配置。",
+                threadTag.c_str(), pfds[1].revents);
+            closeDevice();
+        } else if (deviceFd_ >= 0 && (pfds[1].revents & POLLIN)) {
+            // 读取数据（可能一次性读到多个 struct input_event）
+            ssize_t bytesRead = read(deviceFd_, readBuffer, READ_BUF_SIZE);
+            if (bytesRead < 0) {
+                if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                    __android_log_print(ANDROID_LOG_ERROR, TAG,
+                        "触摸线程 %s: read 错误: %s (%d)，关闭设备并等待重新配置。",
+                        threadTag.c_str(), strerror(errno), errno);
+                    closeDevice();
+                }
+            } else if (bytesRead == 0) {
+                __android_log_print(ANDROID_LOG_INFO, TAG,
+                    "触摸线程 %s: read=0(EOF)，设备被移除？关闭设备并等待重新配置。",
+                    threadTag.c_str());
+                closeDevice();
+            } else {
+                totalBytesRead += bytesRead;
+                runtimeStatsAdd(RuntimeStatsField::InputEvents, static_cast<uint64_t>(bytesRead) / EVENT_SIZE);
+                size_t bufferOffset = 0;
 
-        // -------------------- 先处理 leftoverBuf 里的半包 --------------------
-        if (leftoverCount > 0) {
-            size_t copyLen = std::min(static_cast<size_t>(bytesRead), (size_t)(EVENT_SIZE - leftoverCount));
-            std::memcpy(leftoverBuf + leftoverCount, readBuffer, copyLen);
-            leftoverCount += copyLen;
-            if (leftoverCount == EVENT_SIZE) {
-                struct input_event ev;
-                std::memcpy(&ev, leftoverBuf, EVENT_SIZE);
-                leftoverCount = 0;
+                // 捕获模式：记录 read 完成时间（CLOCK_MONOTONIC），用于按原始节奏回放
+                int64_t readTimeNs = 0;
+                if (active.capture) {
+                    struct timespec readDone;
+                    clock_gettime(CLOCK_MONOTONIC, &readDone);
+                    readTimeNs = static_cast<int64_t>(readDone.tv_sec) * 1000000000LL + readDone.tv_nsec;
+                }
 
-                // 按事件类型处理
-                if (ev.type == EV_ABS) {
-                    if (ev.code == ABS_MT_SLOT) {
-                        currentSlot = ev.value;
-                        if (currentSlot < 0 || currentSlot >= MAX_SLOTS) {
-                            __android_log_print(ANDROID_LOG_WARN, TAG,
-                                "无效 slot %d，重置为0", currentSlot);
-                            currentSlot = 0;
-                        }
-                    } else if (ev.code == ABS_MT_TRACKING_ID) {
-                        TouchPoint& tp = localTouches[currentSlot];
-                        if (ev.value == -1) {
-                            // 手指抬起
-                            if (tp.isDown && tp.maybeUiTap) {
-                                int rotatedX = (nativeMaxY > 0) 
-                                    ? (tp.y * g_screenWidthPx / nativeMaxY) : tp.y;
-                                int rotatedY = (nativeMaxX > 0) 
-                                    ? ((nativeMaxX - tp.x) * g_screenHeightPx / nativeMaxX)
-                                    : (nativeMaxX - tp.x);
-                                int adjustedX = rotatedX - g_screenLeftOffsetPx;
-                                int adjustedY = rotatedY - g_screenTopOffsetPx;
-
-                                if (tp.longPressStartSent) {
-                                    __android_log_print(ANDROID_LOG_INFO, TAG,
-                                        "[Slot=%d] 长按结束 (已发送0x08): %s",
-                                        currentSlot, tp.downRegionIdentifier.c_str());
-                                    callSendUiLongPressPacketJNI(env, tp.downRegionIdentifier, adjustedX, adjustedY);
-                                }
-                                tp.uiTapHandled = true;
-                            }
-                            tp.id = -1;
-                            tp.isDown = false;
-                            tp.maybeUiTap = false;
-                            tp.uiTapHandled = false;
-                            tp.downRegionIdentifier.clear();
-                            tp.isCheckingForLongPressStart = false;
-                            tp.longPressStartSent = false;
-                        } else {
-                            // 手指按下
-                            tp.id = ev.value;
-                            tp.isDown = true;
-                            tp.uiTapHandled = false;
-                            tp.isCheckingForLongPressStart = false;
-                            tp.longPressStartSent = false;
-                            long long nowMs = std::chrono::duration_cast<std::chrono::milliseconds>(
-                                std::chrono::steady_clock::now().time_since_epoch()).count();
-                            tp.downTimestampMs = nowMs;
-                            tp.downRegionIdentifier.clear();
-                        }
-                        touchDataUpdated = true;
-                    } else if (ev.code == ABS_MT_POSITION_X) {
-                        localTouches[currentSlot].x = ev.value;
-                        touchDataUpdated = true;
-                    } else if (ev.code == ABS_MT_POSITION_Y) {
-                        localTouches[currentSlot].y = ev.value;
-                        touchDataUpdated = true;
-                    }
-                } else if (ev.type == EV_SYN && ev.code == SYN_REPORT) {
-                    if (touchDataUpdated) {
-                        long long currentTimestampMs =
-                            (long long)ev.time.tv_sec * 1000 + (long long)ev.time.tv_usec / 1000;
-                        if (currentTimestampMs == 0) {
-                            currentTimestampMs = std::chrono::duration_cast<std::chrono::milliseconds>(
-                                std::chrono::steady_clock::now().time_since_epoch()).count();
-                        }
-                        std::string dataToSend = "T";
-                        int activePoints = 0;
-
-                        {
-                            std::lock_guard<std::mutex> lock(g_regionMutex);
-                            for (int i = 0; i < MAX_SLOTS; i++) {
-                                TouchPoint& tp = localTouches[i];
-                                if (tp.id != -1) {
-                                    int rotatedX = (nativeMaxY > 0)
-                                        ? (tp.y * g_screenWidthPx / nativeMaxY) : tp.y;
-                                    int rotatedY = (nativeMaxX > 0)
-                                        ? ((nativeMaxX - tp.x) * g_screenHeightPx / nativeMaxX)
-                                        : (nativeMaxX - tp.x);
-                                    int adjustedX = rotatedX - g_screenLeftOffsetPx;
-                                    int adjustedY = rotatedY - g_screenTopOffsetPx;
-
-                                    if (tp.isDown && !tp.maybeUiTap) {
-                                        tp.downX = adjustedX;
-                                        tp.downY = adjustedY;
-                                        for (auto & region : g_clickableRegions) {
-                                            if (adjustedX >= region.left && 
-                                                adjustedX < (region.left + region.width) &&
-                                                adjustedY >= region.top && 
-                                                adjustedY < (region.top + region.height)) {
-                                                tp.maybeUiTap = true;
-                                                tp.downRegionIdentifier = region.identifier;
-                                                tp.isCheckingForLongPressStart = true;
-                                                tp.longPressStartSent = false;
-                                                __android_log_print(ANDROID_LOG_INFO, TAG,
-                                                    "[Slot=%d] 按下命中区域: %s (X=%d,Y=%d), 立即发送点击事件并准备检查长按...",
-                                                    i, region.identifier.c_str(), adjustedX, adjustedY);
-                                                callSendUiEventPacketJNI(env, region.identifier, adjustedX, adjustedY);
-                                                break;
-                                            }
-                                        }
-                                    }
-
-                                    if (!tp.uiTapHandled) {
-                                        dataToSend += "|" + std::to_string(tp.id)
-                                            + "," + std::to_string(adjustedX)
-                                            + "," + std::to_string(adjustedY);
-                                        activePoints++;
-                                    }
-                                }
-                            }
+                // -------------------- 抖动测量：内核事件时间 -> read 完成 --------------------
+                if (jitterEnabled_.load(std::memory_order_relaxed)) {
+                    // evdev 默认使用 CLOCK_REALTIME 打时间戳，这里用同一时钟取 read 完成时间
+                    struct timespec readDone;
+                    clock_gettime(CLOCK_REALTIME, &readDone);
+                    const long long readDoneUs = (long long)readDone.tv_sec * 1000000 + readDone.tv_nsec / 1000;
+                    for (size_t off = (leftoverCount > 0 ? EVENT_SIZE - leftoverCount : 0);
+                         off + EVENT_SIZE <= (size_t)bytesRead; off += EVENT_SIZE) {
+                        struct input_event jev;
+                        std::memcpy(&jev, readBuffer + off, EVENT_SIZE);
+                        if (jev.type == EV_SYN && jev.code == SYN_REPORT) {
+                            const long long evUs = (long long)jev.time.tv_sec * 1000000 + jev.time.tv_usec;
+                            wakeupLatency_.record(readDoneUs - evUs);
                         }
-                        if (activePoints > 0) {
-                            dataToSend += ";" + std::to_string(currentTimestampMs);
-                            sendTouchEventToJava(env, dataToSend);
-                        }
-                        touchDataUpdated = false;
                     }
                 }
-            }
-            bufferOffset = copyLen;
-        }
-
-        // -------------------- 处理本次新读取的数据 --------------------
-        while (bufferOffset + EVENT_SIZE <= (size_t)bytesRead) {
-            struct input_event ev;
-            std::memcpy(&ev, readBuffer + bufferOffset, EVENT_SIZE);
-            bufferOffset += EVENT_SIZE;
-
-            if (ev.type == EV_ABS) {
-                if (ev.code == ABS_MT_SLOT) {
-                    currentSlot = ev.value;
-                    if (currentSlot < 0 || currentSlot >= MAX_SLOTS) {
-                        __android_log_print(ANDROID_LOG_WARN, TAG,
-                            "无效 slot %d => 置0", currentSlot);
-                        currentSlot = 0;
-                    }
-                } else if (ev.code == ABS_MT_TRACKING_ID) {
-                    TouchPoint& tp = localTouches[currentSlot];
-                    if (ev.value == -1) {
-                        // 手指抬起
-                        if (tp.isDown && tp.maybeUiTap) {
-                            int rotatedX = (nativeMaxY > 0) 
-                                ? (tp.y * g_screenWidthPx / nativeMaxY) : tp.y;
-                            int rotatedY = (nativeMaxX > 0)
-                                ? ((nativeMaxX - tp.x) * g_screenHeightPx / nativeMaxX)
-                                : (nativeMaxX - tp.x);
-                            int adjustedX = rotatedX - g_screenLeftOffsetPx;
-                            int adjustedY = rotatedY - g_screenTopOffsetPx;
-
-                            if (tp.longPressStartSent) {
-                                __android_log_print(ANDROID_LOG_INFO, TAG,
-                                    "[Slot=%d] 长按结束 (已发送0x08): %s",
-                                    currentSlot, tp.downRegionIdentifier.c_str());
-                                callSendUiLongPressPacketJNI(env, tp.downRegionIdentifier, adjustedX, adjustedY);
-                            }
-                            tp.uiTapHandled = true;
+
+                // -------------------- 先处理 leftoverBuf 里的半包 --------------------
+                if (leftoverCount > 0) {
+                    size_t copyLen = std::min(static_cast<size_t>(bytesRead), EVENT_SIZE - leftoverCount);
+                    std::memcpy(leftoverBuf + leftoverCount, readBuffer, copyLen);
+                    leftoverCount += copyLen;
+                    bufferOffset = copyLen;
+                    if (leftoverCount == EVENT_SIZE) {
+                        struct input_event ev;
+                        std::memcpy(&ev, leftoverBuf, EVENT_SIZE);
+                        leftoverCount = 0;
+                        if (active.capture) {
+                            active.capture->append(CAPTURE_DEVICE_TOUCH, readTimeNs, ev);
                         }
-                        tp.id = -1;
-                        tp.isDown = false;
-                        tp.maybeUiTap = false;
-                        tp.uiTapHandled = false;
-                        tp.downRegionIdentifier.clear();
-                        tp.isCheckingForLongPressStart = false;
-                        tp.longPressStartSent = false;
-                    } else {
-                        // 手指按下
-                        tp.id = ev.value;
-                        tp.isDown = true;
-                        tp.uiTapHandled = false;
-                        tp.isCheckingForLongPressStart = false;
-                        tp.longPressStartSent = false;
-                        long long nowMs = std::chrono::duration_cast<std::chrono::milliseconds>(
-                            std::chrono::steady_clock::now().time_since_epoch()).count();
-                        tp.downTimestampMs = nowMs;
-                        tp.downRegionIdentifier.clear();
+                        processEvent(ev, active);
                     }
-                    touchDataUpdated = true;
-                } else if (ev.code == ABS_MT_POSITION_X) {
-                    localTouches[currentSlot].x = ev.value;
-                    touchDataUpdated = true;
-                } else if (ev.code == ABS_MT_POSITION_Y) {
-                    localTouches[currentSlot].y = ev.value;
-                    touchDataUpdated = true;
                 }
-            } else if (ev.type == EV_SYN && ev.code == SYN_REPORT) {
-                if (touchDataUpdated) {
-                    long long currentTimestampMs =
-                        (long long)ev.time.tv_sec * 1000 + (long long)ev.time.tv_usec / 1000;
-                    if (currentTimestampMs == 0) {
-                        currentTimestampMs = std::chrono::duration_cast<std::chrono::milliseconds>(
-                            std::chrono::steady_clock::now().time_since_epoch()).count();
-                    }
-                    std::string dataToSend = "T";
-                    int activePoints = 0;
-
-                    {
-                        std::lock_guard<std::mutex> lock(g_regionMutex);
-                        for (int i = 0; i < MAX_SLOTS; i++) {
-                            TouchPoint& tp = localTouches[i];
-                            if (tp.id != -1) {
-                                int rotatedX = (nativeMaxY > 0)
-                                    ? (tp.y * g_screenWidthPx / nativeMaxY) : tp.y;
-                                int rotatedY = (nativeMaxX > 0)
-                                    ? ((nativeMaxX - tp.x) * g_screenHeightPx / nativeMaxX)
-                                    : (nativeMaxX - tp.x);
-                                int adjustedX = rotatedX - g_screenLeftOffsetPx;
-                                int adjustedY = rotatedY - g_screenTopOffsetPx;
-
-                                if (tp.isDown && !tp.maybeUiTap) {
-                                    tp.downX = adjustedX;
-                                    tp.downY = adjustedY;
-                                    for (auto & region : g_clickableRegions) {
-                                        if (adjustedX >= region.left && 
-                                            adjustedX < (region.left + region.width) &&
-                                            adjustedY >= region.top && 
-                                            adjustedY < (region.top + region.height)) {
-                                            tp.maybeUiTap = true;
-                                            tp.downRegionIdentifier = region.identifier;
-                                            tp.isCheckingForLongPressStart = true;
-                                            tp.longPressStartSent = false;
-                                            __android_log_print(ANDROID_LOG_INFO, TAG,
-                                                "[Slot=%d] 按下命中区域: %s (X=%d,Y=%d), 立即发送点击事件并准备检查长按...",
-                                                i, region.identifier.c_str(), adjustedX, adjustedY);
-                                            callSendUiEventPacketJNI(env, region.identifier, adjustedX, adjustedY);
-                                            break;
-                                        }
-                                    }
-                                }
-
-                                if (!tp.uiTapHandled) {
-                                    dataToSend += "|" + std::to_string(tp.id)
-                                        + "," + std::to_string(adjustedX)
-                                        + "," + std::to_string(adjustedY);
-                                    activePoints++;
-                                }
-                            }
-                        }
-                    }
 
-                    if (activePoints > 0) {
-                        dataToSend += ";" + std::to_string(currentTimestampMs);
-                        sendTouchEventToJava(env, dataToSend);
+                // -------------------- 处理本次新读取的数据 --------------------
+                while (bufferOffset + EVENT_SIZE <= (size_t)bytesRead) {
+                    struct input_event ev;
+                    std::memcpy(&ev, readBuffer + bufferOffset, EVENT_SIZE);
+                    bufferOffset += EVENT_SIZE;
+                    if (active.capture) {
+                        active.capture->append(CAPTURE_DEVICE_TOUCH, readTimeNs, ev);
                     }
-                    touchDataUpdated = false;
+                    processEvent(ev, active);
+                }
+
+                // 处理剩余不完整数据
+                size_t remainingBytes = bytesRead - bufferOffset;
+                if (remainingBytes > 0) {
+                    std::memcpy(leftoverBuf + leftoverCount, readBuffer + bufferOffset, remainingBytes);
+                    leftoverCount += remainingBytes;
+                }
+
+                if (active.sink) {
+                    flushSink(active);
+                    recordStartupMilestone(startupFirstEventUs_, "第一批事件交给输出");
                 }
             }
         }
 
-        // 处理剩余不完整数据
-        size_t remainingBytes = bytesRead - bufferOffset;
-        if (remainingBytes > 0) {
-            std::memcpy(leftoverBuf, readBuffer + bufferOffset, remainingBytes);
-            leftoverCount = remainingBytes;
-        } else {
-            leftoverCount = 0;
+        if (penFd_ >= 0 && pfds[2].revents != 0) {
+            readPenDevice(active);
         }
-
-        // -------------------- 长按开始检测 --------------------
-        long long checkTimeMs = std::chrono::duration_cast<std::chrono::milliseconds>(
-            std::chrono::steady_clock::now().time_since_epoch()).count();
-        for (int i = 0; i < MAX_SLOTS; ++i) {
-            TouchPoint& tp = localTouches[i];
-            if (tp.isDown && tp.maybeUiTap && tp.isCheckingForLongPressStart && !tp.longPressStartSent) {
-                long long duration = checkTimeMs - tp.downTimestampMs;
-                if (duration >= LONG_PRESS_START_DELAY_MS) {
-                    __android_log_print(ANDROID_LOG_INFO, TAG,
-                        "[Slot=%d] 达到长按开始延迟 (%lld ms >= %lld ms), 发送按下事件: %s",
-                        i, duration, LONG_PRESS_START_DELAY_MS, tp.downRegionIdentifier.c_str());
-                    callSendUiPressDownPacketJNI(env, tp.downRegionIdentifier, tp.downX, tp.downY, tp.downTimestampMs);
-                    tp.longPressStartSent = true;
-                    tp.isCheckingForLongPressStart = false;
-                }
+        for (int i = 0; i < HID_DEVICE_LIMIT; ++i) {
+            if (hidDevices_[i].fd >= 0 && pfds[POLL_HID_FIRST + i].revents != 0) {
+                readHidDevice(i, active);
             }
         }
-        // -------------------- 检测结束 --------------------
+        if (hidWatchFd_ >= 0 && pfds[3].revents != 0) {
+            readHidWatch(active);
+        }
+
+        // -------------------- 长按开始检测 --------------------
+        checkLongPressStart(active);
 
         auto now = std::chrono::steady_clock::now();
+        cpuSampler.sample(std::chrono::duration_cast<std::chrono::nanoseconds>(now.time_since_epoch()).count());
         if (std::chrono::duration_cast<std::chrono::seconds>(now - lastLogTime).count() >= 10) {
             __android_log_print(ANDROID_LOG_DEBUG, TAG,
                 "触摸线程 %s: 循环活跃。已读 %zu 字节, leftover=%zu",
@@ -474,21 +277,1380 @@ void inputReaderLoop(const char* devicePath) {
     }
 
     // 清理资源
-    if (fd >= 0) {
-        close(fd);
-        __android_log_print(ANDROID_LOG_INFO, TAG,
-            "触摸线程 %s: 关闭设备 fd=%d", threadTag.c_str(), fd);
+    closeDevice();
+    closePenDevice();
+    closeHidDevices(active);
+    usingAdoptedFd_ = false;
+    active.capture.reset();
+    if (active.sink) {
+        active.sink->onReaderThreadStop();
+        active.sink.reset();
+    }
+    runtimeStatsSet(RuntimeStatsField::ActiveSlots, 0);
+    cpuSampler.flush();
+
+    __android_log_print(ANDROID_LOG_INFO, TAG,
+        "触摸线程 %s: 退出。", threadTag.c_str());
+}
+
+/**
+ * @brief 从共享配置复制一份快照，并按差异切换输出或重新打开设备
+ */
+void InputEngine::reloadConfig(ConfigSnapshot& active) {
+    const std::string previousPath = active.devicePath;
+    const std::string previousPenPath = active.pen.enabled ? active.pen.devicePath : std::string();
+    const HidInputConfig previousHid = active.hid;
+    std::shared_ptr<InputEventSink> previousSink = active.sink;
+    std::shared_ptr<EventCaptureWriter> previousCapture = active.capture;
+    int handedFd = -1;
+    int handedMaxX = 0;
+    int handedMaxY = 0;
+    {
+        std::lock_guard<std::mutex> lock(configMutex_);
+        active = config_;
+        handedFd = pendingDeviceFd_;
+        handedMaxX = pendingMaxX_;
+        handedMaxY = pendingMaxY_;
+        pendingDeviceFd_ = -1;
+    }
+    // 旧的捕获文件在此处（最后一个引用释放时）关闭，读取线程之后不会再写入
+    previousCapture.reset();
+
+    if (active.sink != previousSink) {
+        if (previousSink) {
+            previousSink->onReaderThreadStop();
+        }
+        if (active.sink && !active.sink->onReaderThreadStart()) {
+            __android_log_print(ANDROID_LOG_ERROR, TAG,
+                "reloadConfig: 输出初始化失败，暂停投递事件。");
+            active.sink.reset();
+        }
+    }
+
+    if (handedFd >= 0) {
+        closeDevice();
+        adoptDevice(handedFd, handedMaxX, handedMaxY);
+    } else if (!active.devicePath.empty()
+               && ((active.devicePath != previousPath && !usingAdoptedFd_) || deviceFd_ < 0)) {
+        closeDevice();
+        usingAdoptedFd_ = false;
+        openDevice(active.devicePath);
+    }
+
+    updatePenDevice(active, previousPenPath);
+    updateHidDevices(active, previousHid, active.sink != previousSink);
+    updateGestureRegions(active.regions);
+    updateRegionPolicies(active.regions);
+    applyEventMask(active);
+    applyExclusiveGrab(active.exclusiveGrab);
+
+    if (active.capture) {
+        active.capture->setDeviceAxes(CAPTURE_DEVICE_TOUCH, CaptureDeviceAxes{nativeMaxX_, nativeMaxY_});
+        if (penFd_ >= 0) {
+            active.capture->setDeviceAxes(CAPTURE_DEVICE_PEN, CaptureDeviceAxes{penDevice_.maxX(), penDevice_.maxY()});
+        }
+    }
+
+    __android_log_print(ANDROID_LOG_INFO, TAG,
+        "reloadConfig: 设备=%s, 区域=%zu, 屏幕=%dx%d, 偏移=(%d,%d), 笔=%d(%s), 外接设备=%d(%zu 个路径)",
+        active.devicePath.c_str(), active.regions.size(),
+        active.transform.screenWidthPx, active.transform.screenHeightPx,
+        active.transform.leftOffsetPx, active.transform.topOffsetPx,
+        active.pen.enabled, active.pen.devicePath.c_str(),
+        active.hid.enabled, active.hid.devicePaths.size());
+}
+
+/**
+ * @brief 打开一个 evdev 节点，权限不足时经特权辅助进程打开；只有未配置辅助进程时才退回 su + chmod
+ * @return fd，失败时为 -1
+ */
+int InputEngine::openInputNode(const std::string& devicePath) {
+    const int flags = O_RDONLY | O_NONBLOCK | O_CLOEXEC;
+    int fd = open(devicePath.c_str(), flags);
+    if (fd < 0 && (errno == EACCES || errno == EPERM)) {
+        fd = privilegedHelper().openDevice(devicePath, flags);
+        if (fd >= 0) {
+            __android_log_print(ANDROID_LOG_INFO, TAG,
+                "经特权辅助进程打开 %s", devicePath.c_str());
+        } else if (errno == ENOENT && !privilegedHelper().isRunning()) {
+            // 未配置辅助进程：退回 su + chmod（chmod 同步完成，无需等待）
+            __android_log_print(ANDROID_LOG_WARN, TAG,
+                "未配置特权辅助进程，尝试修复 %s 的权限...", devicePath.c_str());
+            if (tryFixPermissions(devicePath.c_str())) {
+                fd = open(devicePath.c_str(), flags);
+            }
+        } else if (errno == EPROTO) {
+            // 不退回 setenforce 0：辅助进程的目的正是保持 SELinux 强制模式
+            __android_log_print(ANDROID_LOG_ERROR, TAG,
+                "SELinux 拒收了辅助进程传回的 %s fd（magiskpolicy / supolicy 规则未能加入）", devicePath.c_str());
+        } else {
+            __android_log_print(ANDROID_LOG_WARN, TAG,
+                "特权辅助进程打开 %s 失败: %s (%d)", devicePath.c_str(), strerror(errno), errno);
+        }
+    }
+    return fd;
+}
+
+/**
+ * @brief 打开触摸设备，并读取坐标范围
+ */
+bool InputEngine::openDevice(const std::string& devicePath) {
+    const int fd = openInputNode(devicePath);
+    if (fd < 0) {
+        __android_log_print(ANDROID_LOG_ERROR, TAG,
+            "openDevice: 无法打开 %s，等待重新配置。", devicePath.c_str());
+        return false;
     }
 
     __android_log_print(ANDROID_LOG_INFO, TAG,
-        "触摸线程 %s: 准备退出", threadTag.c_str());
+        "openDevice: 成功打开设备 %s (fd=%d)", devicePath.c_str(), fd);
 
-    // 从JVM分离当前线程
-    if (g_jvm->DetachCurrentThread() != JNI_OK) {
+    // 读取 ABS 范围，用于坐标转换
+    nativeMaxX_ = 0;
+    nativeMaxY_ = 0;
+    struct input_absinfo absinfo_x;
+    if (ioctl(fd, EVIOCGABS(ABS_MT_POSITION_X), &absinfo_x) == 0) {
+        nativeMaxX_ = absinfo_x.maximum;
+        __android_log_print(ANDROID_LOG_INFO, TAG,
+            "Native X-axis range: min=%d, max=%d", absinfo_x.minimum, absinfo_x.maximum);
+    } else {
+        __android_log_print(ANDROID_LOG_WARN, TAG,
+            "无法获取 ABS_MT_POSITION_X info: %s", strerror(errno));
+    }
+    struct input_absinfo absinfo_y;
+    if (ioctl(fd, EVIOCGABS(ABS_MT_POSITION_Y), &absinfo_y) == 0) {
+        nativeMaxY_ = absinfo_y.maximum;
+        __android_log_print(ANDROID_LOG_INFO, TAG,
+            "Native Y-axis range: min=%d, max=%d", absinfo_y.minimum, absinfo_y.maximum);
+    } else {
         __android_log_print(ANDROID_LOG_WARN, TAG,
-            "触摸线程 %s: 从 JVM 分离失败", threadTag.c_str());
+            "无法获取 ABS_MT_POSITION_Y info: %s", strerror(errno));
+    }
+
+    queryTouchAxes(fd);
+    deviceFd_ = fd;
+    resetTouchState();
+    recordStartupMilestone(startupOpenUs_, "打开设备");
+    return true;
+}
+
+/**
+ * @brief 把已交给输出的记录送出（JNI 批量上行或事件环发布），耗时计入运行时统计
+ */
+void InputEngine::flushSink(const ConfigSnapshot& active) {
+    if (!active.sink) {
+        return;
+    }
+    const int64_t startNs = steadyNowNs();
+    active.sink->flush();
+    runtimeStatsAdd(RuntimeStatsField::SinkFlushes, 1);
+    runtimeStatsAdd(RuntimeStatsField::SinkTimeNs, static_cast<uint64_t>(steadyNowNs() - startNs));
+}
+
+/**
+ * @brief 记录一次启动里程碑（只记录本次 start() 之后的第一次）
+ */
+void InputEngine::recordStartupMilestone(std::atomic<int64_t>& milestone, const char* what) {
+    const int64_t requestedNs = startRequestedNs_.load(std::memory_order_relaxed);
+    if (requestedNs <= 0 || milestone.load(std::memory_order_relaxed) >= 0) {
+        return;
     }
+    const int64_t nowNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+    const int64_t elapsedUs = (nowNs - requestedNs) / 1000;
+    milestone.store(elapsedUs, std::memory_order_relaxed);
+    __android_log_print(ANDROID_LOG_INFO, TAG, "启动耗时: %s %lld us", what, (long long)elapsedUs);
+}
 
+/**
+ * @brief 使用外部提供的 fd（如回放管道）代替真实设备
+ */
+void InputEngine::adoptDevice(int fd, int nativeMaxX, int nativeMaxY) {
+    deviceFd_ = fd;
+    usingAdoptedFd_ = true;
+    nativeMaxX_ = nativeMaxX;
+    nativeMaxY_ = nativeMaxY;
+    queryTouchAxes(fd); // 管道等非 evdev fd 上失败，各轴视为不支持，slot 数取上限
+    if (panelPen_.maxX() <= 0) {
+        panelPen_.setPositionRange(nativeMaxX, nativeMaxY);
+    }
+    resetTouchState();
     __android_log_print(ANDROID_LOG_INFO, TAG,
-        "触摸线程 %s: 退出。", threadTag.c_str());
+        "adoptDevice: 改为读取外部 fd=%d (maxX=%d, maxY=%d)", fd, nativeMaxX, nativeMaxY);
+}
+
+/**
+ * @brief 读取触摸质量相关的 ABS_MT_* 轴范围
+ */
+void InputEngine::queryTouchAxes(int fd) {
+    struct AxisQuery {
+        int code;
+        AxisRange* range;
+    };
+    const AxisQuery queries[] = {
+        {ABS_MT_TOUCH_MAJOR, &touchMajorAxis_},
+        {ABS_MT_TOUCH_MINOR, &touchMinorAxis_},
+        {ABS_MT_PRESSURE, &pressureAxis_},
+        {ABS_MT_TOOL_TYPE, &toolTypeAxis_},
+    };
+    // slot 数：超出 [0, capacity) 的 slot 视为无效
+    slots_.capacity = TOUCH_SLOT_LIMIT;
+    struct input_absinfo slotInfo;
+    if (ioctl(fd, EVIOCGABS(ABS_MT_SLOT), &slotInfo) == 0 && slotInfo.maximum >= 0) {
+        slots_.capacity = std::min(slotInfo.maximum + 1, TOUCH_SLOT_LIMIT);
+        if (slotInfo.maximum + 1 > TOUCH_SLOT_LIMIT) {
+            __android_log_print(ANDROID_LOG_WARN, TAG,
+                "设备报告 %d 个 slot，只跟踪前 %d 个", slotInfo.maximum + 1, TOUCH_SLOT_LIMIT);
+        }
+    }
+    for (const auto& query : queries) {
+        *query.range = AxisRange();
+        struct input_absinfo absinfo;
+        if (ioctl(fd, EVIOCGABS(query.code), &absinfo) == 0) {
+            query.range->present = true;
+            query.range->minimum = absinfo.minimum;
+            query.range->maximum = absinfo.maximum;
+        }
+    }
+    // 集成数位板的笔与手指共用设备节点，以单点 ABS 轴报告
+    panelPen_.queryAxes(fd);
+    __android_log_print(ANDROID_LOG_INFO, TAG,
+        "触摸轴: slots=%d major=%d(max=%d) minor=%d(max=%d) pressure=%d(max=%d) toolType=%d pen=%d",
+        slots_.capacity, touchMajorAxis_.present, touchMajorAxis_.maximum, touchMinorAxis_.present, touchMinorAxis_.maximum,
+        pressureAxis_.present, pressureAxis_.maximum, toolTypeAxis_.present, panelPen_.hasPenTool());
+}
+
+#ifdef EVIOCSMASK
+static constexpr size_t MASK_BITS_PER_WORD = sizeof(unsigned long) * 8;
+
+/**
+ * @brief 一个 fd 的事件码掩码，未置位的码不再投递（EV_MSC 始终全部屏蔽）
+ */
+struct EventMaskBits {
+    unsigned long abs[(ABS_CNT + MASK_BITS_PER_WORD - 1) / MASK_BITS_PER_WORD] = {};
+    unsigned long key[(KEY_CNT + MASK_BITS_PER_WORD - 1) / MASK_BITS_PER_WORD] = {};
+    unsigned long msc[(MSC_CNT + MASK_BITS_PER_WORD - 1) / MASK_BITS_PER_WORD] = {};
+
+    void setAbs(int code) { abs[code / MASK_BITS_PER_WORD] |= 1UL << (code % MASK_BITS_PER_WORD); }
+    void setKey(int code) { key[code / MASK_BITS_PER_WORD] |= 1UL << (code % MASK_BITS_PER_WORD); }
+
+    /**
+     * @brief 笔的工具位、接触、笔杆按键与单点轴
+     */
+    void setPen() {
+        setAbs(ABS_X);
+        setAbs(ABS_Y);
+        setAbs(ABS_PRESSURE);
+        setAbs(ABS_DISTANCE);
+        setAbs(ABS_TILT_X);
+        setAbs(ABS_TILT_Y);
+        setKey(BTN_TOOL_PEN);
+        setKey(BTN_TOOL_RUBBER);
+        setKey(BTN_TOUCH);
+        setKey(BTN_STYLUS);
+        setKey(BTN_STYLUS2);
+    }
+
+    /**
+     * @brief 外接输入设备：保留全部按键与绝对轴（EV_REL 不受掩码影响），只屏蔽 EV_MSC（键盘的 MSC_SCAN）
+     */
+    void setAllKeysAndAxes() {
+        std::fill(std::begin(abs), std::end(abs), ~0UL);
+        std::fill(std::begin(key), std::end(key), ~0UL);
+    }
+};
+
+static void writeEventMask(int fd, const EventMaskBits& bits) {
+    struct MaskEntry {
+        unsigned int type;
+        const unsigned long* bits;
+        size_t bytes;
+    };
+    const MaskEntry entries[] = {
+        {EV_ABS, bits.abs, sizeof(bits.abs)},
+        {EV_KEY, bits.key, sizeof(bits.key)},
+        {EV_MSC, bits.msc, sizeof(bits.msc)},
+    };
+    for (const auto& entry : entries) {
+        struct input_mask mask;
+        mask.type = entry.type;
+        mask.codes_size = static_cast<__u32>(entry.bytes);
+        mask.codes_ptr = reinterpret_cast<uintptr_t>(entry.bits);
+        if (ioctl(fd, EVIOCSMASK, &mask) != 0) {
+            __android_log_print(ANDROID_LOG_WARN, TAG,
+                "EVIOCSMASK(fd=%d, type=%u) 失败: %s (%d)，继续接收全部事件。",
+                fd, entry.type, strerror(errno), errno);
+            return;
+        }
+    }
+}
+#endif
+
+/**
+ * @brief 用 EVIOCSMASK 让内核只投递读取线程实际使用的事件码（只影响本 fd）
+ *
+ * 始终保留 EV_SYN 与 slot / tracking id / 坐标；尺寸、压力、工具类型只在过滤、扩展触摸点或
+ * 独占转发开启时保留；笔的按键与单点轴只在开启笔输入时保留。
+ * 其余 EV_KEY (手指的 BTN_TOUCH 等) 与 EV_MSC (MSC_TIMESTAMP) 不使用，全部屏蔽。内核早于 4.4 时忽略失败。
+ */
+void InputEngine::applyEventMask(const ConfigSnapshot& active) {
+#ifdef EVIOCSMASK
+    if (penFd_ >= 0) {
+        EventMaskBits penBits;
+        penBits.setPen();
+        writeEventMask(penFd_, penBits);
+    }
+    if (deviceFd_ < 0 || usingAdoptedFd_) {
+        return;
+    }
+    EventMaskBits bits;
+    bits.setAbs(ABS_MT_SLOT);
+    bits.setAbs(ABS_MT_TRACKING_ID);
+    bits.setAbs(ABS_MT_POSITION_X);
+    bits.setAbs(ABS_MT_POSITION_Y);
+    const TouchFilterConfig& filter = active.touchFilter;
+    if (filter.enabled || filter.extendedContacts || active.exclusiveGrab) {
+        bits.setAbs(ABS_MT_TOUCH_MAJOR);
+        bits.setAbs(ABS_MT_TOUCH_MINOR);
+        bits.setAbs(ABS_MT_PRESSURE);
+        bits.setAbs(ABS_MT_TOOL_TYPE);
+    }
+    if (active.pen.enabled) {
+        bits.setPen();
+    }
+    writeEventMask(deviceFd_, bits);
+#else
+    (void)active;
+#endif
+}
+
+/**
+ * @brief 按配置独占或释放触摸屏。先创建 uinput 虚拟触摸屏再独占，任何一步失败都保持共享读取，
+ *        避免系统收不到触摸。外部 fd（回放）不独占。
+ */
+void InputEngine::applyExclusiveGrab(bool enabled) {
+    const bool want = enabled && deviceFd_ >= 0 && !usingAdoptedFd_;
+    if (want == grabbed_) {
+        return;
+    }
+    if (want) {
+        bool opened = passthrough_.open(deviceFd_, slots_.capacity);
+        if (!opened && (errno == EACCES || errno == EPERM)) {
+            const int uinputFd = privilegedHelper().openDevice("/dev/uinput", O_WRONLY | O_NONBLOCK);
+            opened = uinputFd >= 0 && passthrough_.open(deviceFd_, slots_.capacity, uinputFd);
+        }
+        if (!opened) {
+            __android_log_print(ANDROID_LOG_WARN, TAG,
+                "独占模式: 创建 uinput 虚拟触摸屏失败: %s (%d)，保持共享读取。", strerror(errno), errno);
+            return;
+        }
+        if (ioctl(deviceFd_, EVIOCGRAB, 1) != 0) {
+            __android_log_print(ANDROID_LOG_WARN, TAG,
+                "独占模式: EVIOCGRAB 失败: %s (%d)，保持共享读取。", strerror(errno), errno);
+            passthrough_.close();
+            return;
+        }
+        grabbed_ = true;
+        passthroughLatency_.reset();
+        __android_log_print(ANDROID_LOG_INFO, TAG,
+            "独占模式: 已独占 fd=%d，未消费的触摸经 %s 转发", deviceFd_, passthrough_.sysName().c_str());
+    } else {
+        if (deviceFd_ >= 0) {
+            ioctl(deviceFd_, EVIOCGRAB, 0);
+        }
+        passthrough_.close();
+        grabbed_ = false;
+        __android_log_print(ANDROID_LOG_INFO, TAG, "独占模式: 已释放触摸屏");
+    }
+    grabbedFlag_.store(grabbed_, std::memory_order_relaxed);
+}
+
+void InputEngine::closeDevice() {
+    if (grabbed_) {
+        // 关闭 fd 即释放独占；虚拟设备上仍按下的手指在此补发抬起
+        passthrough_.close();
+        grabbed_ = false;
+        grabbedFlag_.store(false, std::memory_order_relaxed);
+    }
+    if (deviceFd_ >= 0) {
+        close(deviceFd_);
+        __android_log_print(ANDROID_LOG_INFO, TAG, "关闭设备 fd=%d", deviceFd_);
+        deviceFd_ = -1;
+    }
+}
+
+/**
+ * @brief 按配置打开、切换或关闭独立的笔设备
+ */
+void InputEngine::updatePenDevice(const ConfigSnapshot& active, const std::string& previousPath) {
+    const std::string path = active.pen.enabled ? active.pen.devicePath : std::string();
+    if (path == previousPath && (penFd_ >= 0 || path.empty())) {
+        return;
+    }
+    closePenDevice();
+    if (path.empty()) {
+        return;
+    }
+    const int fd = openInputNode(path);
+    if (fd < 0) {
+        __android_log_print(ANDROID_LOG_ERROR, TAG,
+            "笔设备: 无法打开 %s，只解码触摸设备上的笔事件。", path.c_str());
+        return;
+    }
+    penFd_ = fd;
+    penDevice_.queryAxes(fd);
+    __android_log_print(ANDROID_LOG_INFO, TAG,
+        "笔设备: 已打开 %s (fd=%d, maxX=%d, maxY=%d, pen=%d)",
+        path.c_str(), fd, penDevice_.maxX(), penDevice_.maxY(), penDevice_.hasPenTool());
+}
+
+/**
+ * @brief 读取独立笔设备的事件。evdev 每次 read 只返回完整的 input_event，无需拼接半包
+ */
+void InputEngine::readPenDevice(const ConfigSnapshot& active) {
+    struct input_event events[64];
+    const ssize_t bytesRead = read(penFd_, events, sizeof(events));
+    if (bytesRead < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+        return;
+    }
+    if (bytesRead <= 0) {
+        __android_log_print(ANDROID_LOG_ERROR, TAG,
+            "笔设备: read=%zd (%s)，关闭设备并等待重新配置。", bytesRead, bytesRead < 0 ? strerror(errno) : "EOF");
+        closePenDevice();
+        return;
+    }
+    int64_t readTimeNs = 0;
+    if (active.capture) {
+        struct timespec readDone;
+        clock_gettime(CLOCK_MONOTONIC, &readDone);
+        readTimeNs = static_cast<int64_t>(readDone.tv_sec) * 1000000000LL + readDone.tv_nsec;
+    }
+    const size_t count = static_cast<size_t>(bytesRead) / sizeof(struct input_event);
+    runtimeStatsAdd(RuntimeStatsField::InputEvents, count);
+    for (size_t i = 0; i < count; ++i) {
+        const struct input_event& ev = events[i];
+        if (active.capture) {
+            active.capture->append(CAPTURE_DEVICE_PEN, readTimeNs, ev);
+        }
+        if (ev.type == EV_SYN && ev.code == SYN_DROPPED) {
+            runtimeStatsAdd(RuntimeStatsField::SyncDrops, 1);
+            penDevice_.onSyncDropped();
+        } else if (ev.type == EV_SYN && ev.code == SYN_REPORT) {
+            if (penDevice_.syncDropped() && !penDevice_.resync(penFd_)) {
+                TRACE_W(TraceEvent::TouchResyncFailed, errno);
+            }
+            deliverPenSample(penDevice_, ev, active);
+        } else if (!penDevice_.syncDropped()) {
+            penDevice_.handleEvent(ev);
+        }
+    }
+    flushSink(active);
+}
+
+void InputEngine::closePenDevice() {
+    if (penFd_ >= 0) {
+        close(penFd_);
+        __android_log_print(ANDROID_LOG_INFO, TAG, "关闭笔设备 fd=%d", penFd_);
+        penFd_ = -1;
+    }
+    penDevice_.reset();
+}
+
+/**
+ * @brief 按配置打开或关闭外接输入设备。转发配置变化时全部重新打开；
+ *        输出切换后重新发送各设备的 ATTACHED 帧，让新输出从完整状态开始
+ */
+void InputEngine::updateHidDevices(const ConfigSnapshot& active, const HidInputConfig& previous, bool sinkChanged) {
+    const bool changed = active.hid.enabled != previous.enabled || active.hid.devicePaths != previous.devicePaths;
+    if (changed) {
+        closeHidDevices(active);
+    }
+    if (!active.hid.enabled) {
+        return;
+    }
+    if (changed) {
+        if (active.hid.devicePaths.empty()) {
+            hidWatchFd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+            if (hidWatchFd_ >= 0 && inotify_add_watch(hidWatchFd_, "/dev/input", IN_CREATE | IN_ATTRIB) < 0) {
+                close(hidWatchFd_);
+                hidWatchFd_ = -1;
+            }
+            if (hidWatchFd_ < 0) {
+                __android_log_print(ANDROID_LOG_WARN, TAG,
+                    "外接设备: 无法监视 /dev/input: %s (%d)，只转发当前已接入的设备。", strerror(errno), errno);
+            }
+            scanHidDevices(active);
+        } else {
+            for (const auto& path : active.hid.devicePaths) {
+                openHidDevice(path, true, active);
+            }
+        }
+        return;
+    }
+    if (sinkChanged) {
+        for (auto& device : hidDevices_) {
+            if (device.fd >= 0) {
+                device.decoder.open(device.fd, device.decoder.deviceId(), device.decoder.deviceClass());
+                deliverHidFrames(device.decoder, realtimeNowUs(), active);
+            }
+        }
+    }
+}
+
+/**
+ * @brief 扫描 /dev/input/event*，打开尚未打开且能识别为手柄 / 键盘 / 鼠标的节点
+ */
+void InputEngine::scanHidDevices(const ConfigSnapshot& active) {
+    DIR* dir = opendir("/dev/input");
+    if (!dir) {
+        __android_log_print(ANDROID_LOG_WARN, TAG,
+            "外接设备: 无法列出 /dev/input: %s (%d)", strerror(errno), errno);
+        return;
+    }
+    while (struct dirent* entry = readdir(dir)) {
+        if (std::strncmp(entry->d_name, "event", 5) != 0) {
+            continue;
+        }
+        const std::string path = std::string("/dev/input/") + entry->d_name;
+        if (path == active.devicePath || (active.pen.enabled && path == active.pen.devicePath)) {
+            continue;
+        }
+        bool opened = false;
+        for (const auto& device : hidDevices_) {
+            opened = opened || (device.fd >= 0 && device.path == path);
+        }
+        if (!opened) {
+            openHidDevice(path, false, active);
+        }
+    }
+    closedir(dir);
+}
+
+/**
+ * @brief 打开一个外接输入设备并发送 ATTACHED 帧
+ * @param explicitPath 配置中显式列出的路径：权限不足时允许 su 修复，无法识别类别时仍然转发
+ */
+void InputEngine::openHidDevice(const std::string& path, bool explicitPath, const ConfigSnapshot& active) {
+    int slot = -1;
+    for (int i = 0; i < HID_DEVICE_LIMIT && slot < 0; ++i) {
+        if (hidDevices_[i].fd < 0) slot = i;
+    }
+    if (slot < 0) {
+        __android_log_print(ANDROID_LOG_WARN, TAG,
+            "外接设备: 已打开 %d 个设备，忽略 %s", HID_DEVICE_LIMIT, path.c_str());
+        return;
+    }
+    int fd;
+    if (explicitPath) {
+        fd = openInputNode(path);
+    } else {
+        // 扫描时不为每个节点调用 su，只在辅助进程已运行时经它打开
+        const int flags = O_RDONLY | O_NONBLOCK | O_CLOEXEC;
+        fd = open(path.c_str(), flags);
+        if (fd < 0 && (errno == EACCES || errno == EPERM) && privilegedHelper().isRunning()) {
+            fd = privilegedHelper().openDevice(path, flags);
+        }
+    }
+    if (fd < 0) {
+        if (explicitPath) {
+            __android_log_print(ANDROID_LOG_ERROR, TAG,
+                "外接设备: 无法打开 %s: %s (%d)", path.c_str(), strerror(errno), errno);
+        }
+        return;
+    }
+    const uint8_t deviceClass = HidDecoder::classify(fd);
+    if (deviceClass == 0 && !explicitPath) {
+        close(fd);
+        return;
+    }
+    uint8_t deviceId = nextHidDeviceId_;
+    for (bool inUse = true; inUse;) {
+        deviceId = nextHidDeviceId_++;
+        if (nextHidDeviceId_ == 0) nextHidDeviceId_ = 1;
+        inUse = false;
+        for (const auto& device : hidDevices_) {
+            inUse = inUse || (device.fd >= 0 && device.decoder.deviceId() == deviceId);
+        }
+    }
+
+    char name[128] = {};
+    ioctl(fd, EVIOCGNAME(sizeof(name) - 1), name);
+#ifdef EVIOCSMASK
+    EventMaskBits bits;
+    bits.setAllKeysAndAxes();
+    writeEventMask(fd, bits);
+#endif
+    HidDevice& device = hidDevices_[slot];
+    device.fd = fd;
+    device.path = path;
+    device.decoder.open(fd, deviceId, deviceClass);
+    __android_log_print(ANDROID_LOG_INFO, TAG,
+        "外接设备: 已打开 %s \"%s\" (fd=%d, 编号=%u, 类别=0x%x)", path.c_str(), name, fd, deviceId, deviceClass);
+    deliverHidFrames(device.decoder, realtimeNowUs(), active);
+    flushSink(active);
+}
+
+/**
+ * @brief 读取一个外接输入设备的事件。read 失败（设备移除为 ENODEV）时关闭并发送 DETACHED 帧
+ */
+void InputEngine::readHidDevice(int index, const ConfigSnapshot& active) {
+    HidDevice& device = hidDevices_[index];
+    struct input_event events[64];
+    const ssize_t bytesRead = read(device.fd, events, sizeof(events));
+    if (bytesRead < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+        return;
+    }
+    if (bytesRead <= 0) {
+        __android_log_print(ANDROID_LOG_INFO, TAG,
+            "外接设备: %s read=%zd (%s)，设备已移除？", device.path.c_str(), bytesRead,
+            bytesRead < 0 ? strerror(errno) : "EOF");
+        closeHidDevice(index, active);
+        return;
+    }
+    int64_t readTimeNs = 0;
+    if (active.capture) {
+        struct timespec readDone;
+        clock_gettime(CLOCK_MONOTONIC, &readDone);
+        readTimeNs = static_cast<int64_t>(readDone.tv_sec) * 1000000000LL + readDone.tv_nsec;
+    }
+    const uint16_t captureTag = CAPTURE_DEVICE_HID_BASE + device.decoder.deviceId();
+    const size_t count = static_cast<size_t>(bytesRead) / sizeof(struct input_event);
+    runtimeStatsAdd(RuntimeStatsField::InputEvents, count);
+    for (size_t i = 0; i < count; ++i) {
+        const struct input_event& ev = events[i];
+        if (active.capture) {
+            active.capture->append(captureTag, readTimeNs, ev);
+        }
+        if (ev.type == EV_SYN && ev.code == SYN_DROPPED) {
+            runtimeStatsAdd(RuntimeStatsField::SyncDrops, 1);
+            device.decoder.onSyncDropped();
+        } else if (ev.type == EV_SYN && ev.code == SYN_REPORT) {
+            if (device.decoder.syncDropped() && !device.decoder.resync(device.fd, HID_FRAME_RESYNC)) {
+                TRACE_W(TraceEvent::TouchResyncFailed, errno);
+            }
+            long long timestampUs = (long long)ev.time.tv_sec * 1000000 + (long long)ev.time.tv_usec;
+            if (timestampUs == 0) {
+                timestampUs = realtimeNowUs();
+            }
+            deliverHidFrames(device.decoder, timestampUs, active);
+        } else if (!device.decoder.syncDropped()) {
+            device.decoder.handleEvent(ev);
+        }
+    }
+    flushSink(active);
+}
+
+/**
+ * @brief 关闭一个外接输入设备：先发送抬起所有键的 DETACHED 帧
+ */
+void InputEngine::closeHidDevice(int index, const ConfigSnapshot& active) {
+    HidDevice& device = hidDevices_[index];
+    if (device.fd < 0) {
+        return;
+    }
+    device.decoder.release();
+    deliverHidFrames(device.decoder, realtimeNowUs(), active);
+    flushSink(active);
+    close(device.fd);
+    __android_log_print(ANDROID_LOG_INFO, TAG,
+        "外接设备: 关闭 %s (fd=%d, 编号=%u)", device.path.c_str(), device.fd, device.decoder.deviceId());
+    device.fd = -1;
+    device.path.clear();
+}
+
+void InputEngine::closeHidDevices(const ConfigSnapshot& active) {
+    for (int i = 0; i < HID_DEVICE_LIMIT; ++i) {
+        closeHidDevice(i, active);
+    }
+    if (hidWatchFd_ >= 0) {
+        close(hidWatchFd_);
+        hidWatchFd_ = -1;
+    }
+}
+
+/**
+ * @brief /dev/input 有节点创建或权限变化（ueventd 创建节点后才 chmod）时重新扫描
+ */
+void InputEngine::readHidWatch(const ConfigSnapshot& active) {
+    alignas(struct inotify_event) char buffer[1024];
+    bool rescan = false;
+    ssize_t bytesRead;
+    while ((bytesRead = read(hidWatchFd_, buffer, sizeof(buffer))) > 0) {
+        for (ssize_t offset = 0; offset < bytesRead;) {
+            const auto* event = reinterpret_cast<const struct inotify_event*>(buffer + offset);
+            rescan = rescan || (event->len > 0 && std::strncmp(event->name, "event", 5) == 0);
+            offset += static_cast<ssize_t>(sizeof(struct inotify_event) + event->len);
+        }
+    }
+    if (rescan) {
+        scanHidDevices(active);
+    }
+}
+
+/**
+ * @brief 把解码器中待输出的变化按帧交给输出
+ */
+void InputEngine::deliverHidFrames(HidDecoder& decoder, long long timestampUs, const ConfigSnapshot& active) {
+    while (decoder.takeFrame(timestampUs, hidFrame_)) {
+        if (active.sink) {
+            active.sink->onHidFrame(hidFrame_);
+        }
+    }
+}
+
+void InputEngine::resetTouchState() {
+    slots_.reset();
+    panelPen_.reset();
+    currentSlot_ = 0;
+    touchDataUpdated_ = false;
+    syncDropped_ = false;
+    frameContacts_.reserve(TOUCH_SLOT_LIMIT);
+    frameSlots_.reserve(TOUCH_SLOT_LIMIT);
+    smoothing_.resetAll();
+    gestures_.reset();
+    gestureOut_.clear();
+    std::fill(regionOwners_.begin(), regionOwners_.end(), 0);
+}
+
+/**
+ * @brief 区域表变化时重建手势识别器的区域（其他配置变化不打断进行中的手势）
+ */
+void InputEngine::updateGestureRegions(const std::vector<ClickableRegion>& regions) {
+    bool changed = regions.size() != gestureRegions_.size();
+    for (size_t i = 0; !changed && i < regions.size(); ++i) {
+        const GestureRegion& g = gestureRegions_[i];
+        const ClickableRegion& r = regions[i];
+        changed = g.left != r.left || g.top != r.top || g.width != r.width || g.height != r.height
+            || g.gestureMask != r.gestureMask;
+    }
+    if (!changed) {
+        return;
+    }
+    gestureRegions_.clear();
+    for (const auto& region : regions) {
+        GestureRegion g;
+        g.left = region.left;
+        g.top = region.top;
+        g.width = region.width;
+        g.height = region.height;
+        g.gestureMask = region.gestureMask;
+        gestureRegions_.push_back(g);
+    }
+    gestures_.setRegions(gestureRegions_);
+    gestureOut_.reserve(TOUCH_SLOT_LIMIT * 2);
+}
+
+/**
+ * @brief 区域表更新后重新编译命中表、重建 ID -> 下标表，并把已绑定的手指映射到新表中的下标
+ */
+void InputEngine::updateRegionPolicies(const std::vector<ClickableRegion>& regions) {
+    regionTable_.build(regions);
+
+    std::fill(regionIndexById_.begin(), regionIndexById_.end(), static_cast<int16_t>(-1));
+    for (size_t r = 0; r < regions.size(); ++r) {
+        const int32_t id = regions[r].id;
+        if (id < 0) {
+            continue;
+        }
+        if (static_cast<size_t>(id) >= regionIndexById_.size()) {
+            regionIndexById_.resize(id + 1, -1);
+            regionNames_.resize(id + 1);
+        }
+        regionIndexById_[id] = static_cast<int16_t>(r);
+        regionNames_[id] = regions[r].identifier;
+    }
+
+    // 区域被移除时保留绑定（抬起时仍按 ID 补发长按结束），但不再应用策略
+    regionOwners_.assign(regions.size(), 0);
+    forEachSlot(slots_.bound, [&](int slot) {
+        const int32_t id = slots_.regionId[slot];
+        const int index = (id >= 0 && static_cast<size_t>(id) < regionIndexById_.size())
+            ? regionIndexById_[id] : -1;
+        slots_.regionIndex[slot] = static_cast<int16_t>(index);
+        if (index >= 0) {
+            ++regionOwners_[index];
+        }
+    });
+    // 屏幕参数可能已变化：下一帧重新换算所有按下手指的坐标
+    slots_.dirty |= slots_.active;
+}
+
+/**
+ * @brief 手指绑定的区域；区域已被移除时只填 identifier 到 scratch
+ */
+const ClickableRegion& InputEngine::slotRegion(int slot, const ConfigSnapshot& active,
+                                               ClickableRegion& scratch) const {
+    const int index = slots_.regionIndex[slot];
+    if (index >= 0) {
+        return active.regions[index];
+    }
+    const int32_t id = slots_.regionId[slot];
+    scratch = ClickableRegion();
+    scratch.id = id;
+    if (id >= 0 && static_cast<size_t>(id) < regionNames_.size()) {
+        scratch.identifier = regionNames_[id];
+    }
+    return scratch;
+}
+
+/**
+ * @brief 把识别出的手势交给输出
+ */
+void InputEngine::deliverGestures(const ConfigSnapshot& active) {
+    if (gestureOut_.empty()) {
+        return;
+    }
+    for (const auto& gesture : gestureOut_) {
+        if (active.sink && gesture.regionIndex < static_cast<int>(active.regions.size())) {
+            active.sink->onGesture(active.regions[gesture.regionIndex], gesture.event);
+        }
+    }
+    gestureOut_.clear();
+}
+
+/**
+ * @brief 原生坐标 -> 悬浮窗坐标（面板与屏幕相差 90° 旋转），maxX / maxY 为该设备的坐标范围
+ */
+static inline void mapToScreen(int rawX, int rawY, int maxX, int maxY, const ScreenTransform& transform,
+                               int& x, int& y) {
+    int rotatedX = (maxY > 0)
+        ? (rawY * transform.screenWidthPx / maxY) : rawY;
+    int rotatedY = (maxX > 0)
+        ? ((maxX - rawX) * transform.screenHeightPx / maxX)
+        : (maxX - rawX);
+    x = rotatedX - transform.leftOffsetPx;
+    y = rotatedY - transform.topOffsetPx;
+}
+
+/**
+ * @brief 触摸面板原生坐标 -> 悬浮窗坐标
+ */
+void InputEngine::screenPoint(int rawX, int rawY, const ScreenTransform& transform, int& x, int& y) const {
+    mapToScreen(rawX, rawY, nativeMaxX_, nativeMaxY_, transform, x, y);
+}
+
+/**
+ * @brief 一帧结束：把笔的状态换算到悬浮窗坐标后交给输出。笔采样不做抖动过滤，也不参与区域命中测试
+ */
+void InputEngine::deliverPenSample(PenDecoder& pen, const struct input_event& report, const ConfigSnapshot& active) {
+    long long timestampUs = (long long)report.time.tv_sec * 1000000 + (long long)report.time.tv_usec;
+    if (timestampUs == 0) {
+        timestampUs = realtimeNowUs();
+    }
+    PenSample sample;
+    if (!pen.takeSample(timestampUs, sample)) {
+        return;
+    }
+    mapToScreen(sample.x, sample.y, pen.maxX(), pen.maxY(), active.transform, sample.x, sample.y);
+    if (active.sink) {
+        active.sink->onPenSample(sample);
+    }
+}
+
+/**
+ * @brief 处理单个 input_event
+ *
+ * 只更新当前 slot 的原始值并置 dirty 位，换算与区域逻辑留给 SYN_REPORT。
+ */
+void InputEngine::processEvent(const struct input_event& ev, const ConfigSnapshot& active) {
+    if (syncDropped_) {
+        // 溢出后到下一个 SYN_REPORT 之间的事件不完整，全部丢弃，再从内核读回完整状态
+        if (ev.type == EV_SYN && ev.code == SYN_REPORT) {
+            syncDropped_ = false;
+            resyncTouchState(ev, active);
+            if (active.pen.enabled && panelPen_.resync(deviceFd_)) {
+                deliverPenSample(panelPen_, ev, active);
+            }
+        }
+        return;
+    }
+    if (ev.type == EV_SYN && ev.code == SYN_DROPPED) {
+        const uint64_t drops = syncDrops_.fetch_add(1, std::memory_order_relaxed) + 1;
+        runtimeStatsAdd(RuntimeStatsField::SyncDrops, 1);
+        TRACE_W(TraceEvent::SynDropped, drops);
+        syncDropped_ = true;
+        touchDataUpdated_ = false;
+        slots_.dirty = 0;
+        slots_.moved = 0;
+        return;
+    }
+    if (active.pen.enabled && (ev.type == EV_KEY || (ev.type == EV_ABS && ev.code < ABS_MT_SLOT))) {
+        // 单点轴与按键只属于笔（手指的单点模拟事件在笔不在范围内时不产生输出）
+        panelPen_.handleEvent(ev);
+        return;
+    }
+    if (ev.type == EV_ABS) {
+        if (ev.code == ABS_MT_SLOT) {
+            currentSlot_ = ev.value;
+            if (currentSlot_ < 0 || currentSlot_ >= slots_.capacity) {
+                TRACE_W(TraceEvent::InvalidSlot, currentSlot_);
+                currentSlot_ = -1;
+            }
+            return;
+        }
+        const int slot = currentSlot_;
+        if (slot < 0) {
+            return;
+        }
+        const SlotMask bit = slotBit(slot);
+        if (ev.code == ABS_MT_TRACKING_ID) {
+            if (ev.value == -1) {
+                // 手指抬起
+                if (slots_.bound & bit) {
+                    releaseRegion(slot, slots_.screenX[slot], slots_.screenY[slot], active);
+                }
+                slots_.id[slot] = -1;
+                slots_.active &= ~bit;
+                slots_.hitTested &= ~bit;
+            } else {
+                // 手指按下
+                slots_.id[slot] = ev.value;
+                slots_.active |= bit;
+                slots_.hitTested &= ~bit;
+                slots_.rejected &= ~bit;
+                slots_.downTimestampMs[slot] = steadyNowMs();
+                smoothing_.reset(slot);
+            }
+            slots_.moved &= ~bit;
+        } else if (ev.code == ABS_MT_POSITION_X) {
+            slots_.x[slot] = ev.value;
+            slots_.moved |= bit;
+        } else if (ev.code == ABS_MT_POSITION_Y) {
+            slots_.y[slot] = ev.value;
+            slots_.moved |= bit;
+        } else if (ev.code == ABS_MT_TOUCH_MAJOR) {
+            slots_.touchMajor[slot] = ev.value;
+        } else if (ev.code == ABS_MT_TOUCH_MINOR) {
+            slots_.touchMinor[slot] = ev.value;
+        } else if (ev.code == ABS_MT_PRESSURE) {
+            slots_.pressure[slot] = ev.value;
+        } else if (ev.code == ABS_MT_TOOL_TYPE) {
+            slots_.toolType[slot] = ev.value;
+        } else {
+            return;
+        }
+        slots_.dirty |= bit;
+        touchDataUpdated_ = true;
+    } else if (ev.type == EV_SYN && ev.code == SYN_REPORT) {
+        if (touchDataUpdated_) {
+            handleSynReport(ev, active);
+            touchDataUpdated_ = false;
+        }
+        if (active.pen.enabled) {
+            deliverPenSample(panelPen_, ev, active);
+        }
+    }
+}
+
+/**
+ * @brief 一帧结束：按区域策略更新每个触摸点的区域绑定，并输出未被消费的触摸点
+ *
+ * 只有本帧收到过事件的手指（dirty 位）才重新换算坐标、做质量检查与命中测试；
+ * 其余手指沿用上一帧的悬浮窗坐标直接输出。命中测试是增量的：按下后的第一帧测试全部区域；
+ * 之后只有移动过的手指才重新测试，已绑定的手指只检查自己的区域（slideOut），未绑定的手指
+ * 只在落入 slideIn 区域的外接矩形时才测试 slideIn 区域。本帧需要测试的点先全部登记到命中表，
+ * 一次批量算出各自命中的区域，再按 slot 顺序依次绑定（exclusive 的占用按绑定顺序生效）。
+ */
+void InputEngine::handleSynReport(const struct input_event& ev, const ConfigSnapshot& active) {
+    long long currentTimestampUs =
+        (long long)ev.time.tv_sec * 1000000 + (long long)ev.time.tv_usec;
+    if (currentTimestampUs == 0) {
+        currentTimestampUs = steadyNowMs() * 1000;
+    }
+    const long long currentTimestampMs = currentTimestampUs / 1000;
+    const bool smoothingEnabled = active.touchSmoothing.enabled;
+
+    SlotMask regionSlots = 0;           // 本帧要更新区域绑定的手指
+    int8_t hitPoint[TOUCH_SLOT_LIMIT];  // 手指在命中表中的测试点下标，-1 表示本帧未测试
+    const bool hasRegions = !regionTable_.empty();
+    bool hitStaged = false;
+    forEachSlot(slots_.dirty & slots_.active & ~slots_.rejected, [&](int i) {
+        const SlotMask bit = slotBit(i);
+        int adjustedX = 0;
+        int adjustedY = 0;
+        screenPoint(slots_.x[i], slots_.y[i], active.transform, adjustedX, adjustedY);
+        slots_.screenX[i] = adjustedX;
+        slots_.screenY[i] = adjustedY;
+
+        if (active.touchFilter.enabled) {
+            const int reason = rejectContact(i, adjustedX, adjustedY, !(slots_.hitTested & bit), active);
+            if (reason != TOUCH_REJECT_NONE) {
+                TRACE_I(TraceEvent::ContactRejected, i, reason, adjustedX, adjustedY);
+                slots_.rejected |= bit;
+                slots_.hitTested |= bit;
+                if (slots_.bound & bit) {
+                    releaseRegion(i, adjustedX, adjustedY, active);
+                }
+                return;
+            }
+        }
+
+        const bool landing = !(slots_.hitTested & bit);
+        if (!landing && !(slots_.moved & bit)) {
+            return;
+        }
+        regionSlots |= bit;
+        hitPoint[i] = -1;
+        if (hasRegions && (landing || (regionTable_.hasSlideIn() && regionTable_.inSlideInBounds(adjustedX, adjustedY)))) {
+            hitPoint[i] = static_cast<int8_t>(regionTable_.stage(adjustedX, adjustedY));
+            hitStaged = true;
+        }
+    });
+    if (hitStaged) {
+        regionTable_.run();
+    }
+
+    forEachSlot(regionSlots, [&](int i) {
+        const SlotMask bit = slotBit(i);
+        const int adjustedX = slots_.screenX[i];
+        const int adjustedY = slots_.screenY[i];
+        if (!(slots_.hitTested & bit)) {
+            slots_.hitTested |= bit;
+            slots_.downX[i] = adjustedX;
+            slots_.downY[i] = adjustedY;
+            const int hit = hitPoint[i] >= 0 ? resolveRegionHit(hitPoint[i], false, active) : -1;
+            if (hit >= 0) {
+                TRACE_I(TraceEvent::RegionTap, i, adjustedX, adjustedY, active.regions[hit].identifier);
+                bindRegion(i, hit, adjustedX, adjustedY, active);
+            }
+            return;
+        }
+        if (slots_.bound & bit) {
+            if (gestures_.hasGestureRegions()) {
+                gestures_.onContactMove(i, adjustedX, adjustedY, steadyNowMs(), gestureOut_);
+            }
+            const int index = slots_.regionIndex[i];
+            if (index >= 0) {
+                const ClickableRegion& region = active.regions[index];
+                if (region.slideOut && !regionTable_.contains(index, adjustedX, adjustedY)) {
+                    TRACE_I(TraceEvent::RegionSlideOut, i, adjustedX, adjustedY, region.identifier);
+                    releaseRegion(i, adjustedX, adjustedY, active);
+                }
+            }
+        }
+        if (!(slots_.bound & bit) && hitPoint[i] >= 0) {
+            const int hit = resolveRegionHit(hitPoint[i], true, active);
+            if (hit >= 0) {
+                TRACE_I(TraceEvent::RegionSlideIn, i, adjustedX, adjustedY, active.regions[hit].identifier);
+                slots_.downTimestampMs[i] = steadyNowMs();
+                slots_.downX[i] = adjustedX;
+                slots_.downY[i] = adjustedY;
+                bindRegion(i, hit, adjustedX, adjustedY, active);
+            }
+        }
+    });
+    slots_.dirty = 0;
+    slots_.moved = 0;
+
+    frameContacts_.clear();
+    frameSlots_.clear();
+    SlotMask consumed = 0;  // 被区域消费、独占模式下不转发给系统的手指
+    forEachSlot(slots_.active & ~slots_.rejected, [&](int i) {
+        const int index = (slots_.bound & slotBit(i)) ? slots_.regionIndex[i] : -1;
+        const ClickableRegion* boundRegion = index >= 0 ? &active.regions[index] : nullptr;
+        if ((slots_.bound & slotBit(i)) && !(boundRegion && boundRegion->passThrough)) {
+            consumed |= slotBit(i);
+        }
+        if (boundRegion && boundRegion->capture) {
+            return;
+        }
+        const int adjustedX = slots_.screenX[i];
+        const int adjustedY = slots_.screenY[i];
+        if (smoothingEnabled) {
+            const OneEuroParams& params = (boundRegion && boundRegion->customSmoothing)
+                ? boundRegion->smoothing : active.touchSmoothing.params;
+            smoothing_.stage(i, static_cast<float>(adjustedX), static_cast<float>(adjustedY), params);
+        }
+        TouchContact contact{slots_.id[i], adjustedX, adjustedY, 0, 0};
+        if (active.touchFilter.extendedContacts) {
+            contact.pressure = static_cast<uint16_t>(axisPermille(slots_.pressure[i], pressureAxis_));
+            contact.touchMajor = static_cast<uint16_t>(axisPermille(slots_.touchMajor[i], touchMajorAxis_));
+        }
+        frameContacts_.push_back(contact);
+        frameSlots_.push_back(i);
+    });
+
+    if (grabbed_) {
+        const int written = passthrough_.writeFrame(slots_, slots_.active & ~slots_.rejected & ~consumed);
+        if (written > 0) {
+            struct timespec writeDone;
+            clock_gettime(CLOCK_REALTIME, &writeDone);
+            passthroughLatency_.record(
+                (long long)writeDone.tv_sec * 1000000 + writeDone.tv_nsec / 1000 - currentTimestampUs);
+        } else if (written < 0) {
+            __android_log_print(ANDROID_LOG_ERROR, TAG,
+                "独占模式: 写 uinput 失败: %s (%d)，释放触摸屏。", strerror(errno), errno);
+            applyExclusiveGrab(false);
+        }
+    }
+
+    // 所有输出的触摸点一次过滤（区域命中测试始终使用原始坐标）
+    if (smoothingEnabled && !frameContacts_.empty()) {
+        smoothing_.run(currentTimestampUs);
+        for (size_t k = 0; k < frameContacts_.size(); ++k) {
+            frameContacts_[k].x = static_cast<int>(std::lround(smoothing_.x(frameSlots_[k])));
+            frameContacts_[k].y = static_cast<int>(std::lround(smoothing_.y(frameSlots_[k])));
+        }
+    }
+
+    deliverGestures(active);
+
+    runtimeStatsSet(RuntimeStatsField::ActiveSlots, frameContacts_.size());
+    if (!frameContacts_.empty() && active.sink) {
+        active.sink->onTouchFrame(frameContacts_.data(), static_cast<int>(frameContacts_.size()),
+                                  currentTimestampMs, active.touchFilter.extendedContacts);
+        runtimeStatsAdd(RuntimeStatsField::TouchFrames, 1);
+    }
+}
+
+/**
+ * @brief SYN_DROPPED 之后用 EVIOCGMTSLOTS 读回每个 slot 的完整状态，并与本地状态比对
+ *
+ * 差异以合成事件的形式走 processEvent：tracking ID 变化的 slot 先补发抬起（释放区域绑定、
+ * 补发长按结束），再补发按下；坐标与触摸质量轴只补发有变化的值。最后以 report 的时间戳
+ * 结束一帧，输出同步后的完整触摸状态。查询失败（回放管道等非 evdev fd）时保留当前状态。
+ */
+void InputEngine::resyncTouchState(const struct input_event& report, const ConfigSnapshot& active) {
+    struct input_absinfo slotInfo;
+    if (deviceFd_ < 0 || ioctl(deviceFd_, EVIOCGABS(ABS_MT_SLOT), &slotInfo) != 0) {
+        resyncFailures_.fetch_add(1, std::memory_order_relaxed);
+        TRACE_W(TraceEvent::TouchResyncFailed, deviceFd_ < 0 ? EBADF : errno);
+        return;
+    }
+
+    struct SlotQuery {
+        int code;
+        bool present;
+        int32_t* local;
+    };
+    const SlotQuery queries[] = {
+        {ABS_MT_TRACKING_ID, true, slots_.id},
+        {ABS_MT_POSITION_X, true, slots_.x},
+        {ABS_MT_POSITION_Y, true, slots_.y},
+        {ABS_MT_TOUCH_MAJOR, touchMajorAxis_.present, slots_.touchMajor},
+        {ABS_MT_TOUCH_MINOR, touchMinorAxis_.present, slots_.touchMinor},
+        {ABS_MT_PRESSURE, pressureAxis_.present, slots_.pressure},
+        {ABS_MT_TOOL_TYPE, toolTypeAxis_.present, slots_.toolType},
+    };
+    static constexpr size_t QUERY_COUNT = sizeof(queries) / sizeof(queries[0]);
+
+    // EVIOCGMTSLOTS 的参数：首个元素为轴代码，其后是每个 slot 的值
+    const int capacity = slots_.capacity;
+    const size_t requestBytes = sizeof(int32_t) * (1 + capacity);
+    int32_t kernelValues[QUERY_COUNT][1 + TOUCH_SLOT_LIMIT];
+    for (size_t q = 0; q < QUERY_COUNT; ++q) {
+        if (!queries[q].present) {
+            continue;
+        }
+        kernelValues[q][0] = queries[q].code;
+        if (ioctl(deviceFd_, EVIOCGMTSLOTS(requestBytes), kernelValues[q]) != 0) {
+            resyncFailures_.fetch_add(1, std::memory_order_relaxed);
+            TRACE_W(TraceEvent::TouchResyncFailed, errno);
+            return;
+        }
+    }
+
+    struct input_event synth = report;
+    synth.type = EV_ABS;
+    auto feed = [&](int code, int value) {
+        synth.code = static_cast<__u16>(code);
+        synth.value = value;
+        processEvent(synth, active);
+    };
+
+    int lifted = 0;
+    int landed = 0;
+    for (int slot = 0; slot < capacity; ++slot) {
+        const int32_t oldId = slots_.id[slot];
+        const int32_t newId = kernelValues[0][1 + slot];
+        bool changed = newId != oldId;
+        for (size_t q = 1; !changed && newId != -1 && q < QUERY_COUNT; ++q) {
+            changed = queries[q].present && queries[q].local[slot] != kernelValues[q][1 + slot];
+        }
+        if (!changed) {
+            continue;
+        }
+        feed(ABS_MT_SLOT, slot);
+        if (newId != oldId) {
+            if (oldId != -1) {
+                feed(ABS_MT_TRACKING_ID, -1);
+                ++lifted;
+            }
+            if (newId != -1) {
+                feed(ABS_MT_TRACKING_ID, newId);
+                ++landed;
+            }
+        }
+        if (newId == -1) {
+            continue;
+        }
+        for (size_t q = 1; q < QUERY_COUNT; ++q) {
+            if (queries[q].present && queries[q].local[slot] != kernelValues[q][1 + slot]) {
+                feed(queries[q].code, kernelValues[q][1 + slot]);
+            }
+        }
+    }
+    // 内核此后的事件相对它自己的当前 slot
+    feed(ABS_MT_SLOT, slotInfo.value);
+    TRACE_I(TraceEvent::TouchResync, lifted, landed);
+
+    synth.type = EV_SYN;
+    synth.code = SYN_REPORT;
+    synth.value = 0;
+    processEvent(synth, active);
+}
+
+/**
+ * @brief 原始轴值 -> 轴范围的千分比（0..1000），设备不支持该轴时为 0
+ */
+int InputEngine::axisPermille(int value, const AxisRange& axis) const {
+    if (!axis.present || axis.maximum <= axis.minimum) {
+        return 0;
+    }
+    const long long permille =
+        static_cast<long long>(value - axis.minimum) * 1000 / (axis.maximum - axis.minimum);
+    return static_cast<int>(std::max(0LL, std::min(1000LL, permille)));
+}
+
+/**
+ * @brief 按触摸质量规则检查一个手指
+ * @param landing 按下后的第一帧（压力与边缘区只在此时检查）
+ * @return TOUCH_REJECT_*，TOUCH_REJECT_NONE 表示接受
+ */
+int InputEngine::rejectContact(int slot, int x, int y, bool landing,
+                               const ConfigSnapshot& active) const {
+    const TouchFilterConfig& filter = active.touchFilter;
+    if (filter.rejectPalmTool && toolTypeAxis_.present && slots_.toolType[slot] == MT_TOOL_PALM) {
+        return TOUCH_REJECT_PALM_TOOL;
+    }
+    if (filter.maxTouchSizePermille > 0) {
+        const int size = std::max(axisPermille(slots_.touchMajor[slot], touchMajorAxis_),
+                                  axisPermille(slots_.touchMinor[slot], touchMinorAxis_));
+        if (size > filter.maxTouchSizePermille) {
+            return TOUCH_REJECT_SIZE;
+        }
+    }
+    if (!landing) {
+        return TOUCH_REJECT_NONE;
+    }
+    if (filter.minPressurePermille > 0 && pressureAxis_.present
+        && axisPermille(slots_.pressure[slot], pressureAxis_) < filter.minPressurePermille) {
+        return TOUCH_REJECT_PRESSURE;
+    }
+    // 边缘区按整块屏幕计算，悬浮窗坐标需加回偏移
+    const ScreenTransform& transform = active.transform;
+    const int screenX = x + transform.leftOffsetPx;
+    const int screenY = y + transform.topOffsetPx;
+    if (screenX < filter.edgeLeftPx || screenY < filter.edgeTopPx
+        || (transform.screenWidthPx > 0 && screenX >= transform.screenWidthPx - filter.edgeRightPx)
+        || (transform.screenHeightPx > 0 && screenY >= transform.screenHeightPx - filter.edgeBottomPx)) {
+        return TOUCH_REJECT_EDGE;
+    }
+    return TOUCH_REJECT_NONE;
+}
+
+/**
+ * @brief 命中表第 point 个测试点命中的区域中优先级最高的可绑定区域；exclusive 且已有手指绑定的区域跳过
+ */
+int InputEngine::resolveRegionHit(int point, bool slideInOnly, const ConfigSnapshot& active) const {
+    return regionTable_.firstHit(point, slideInOnly, [&](int r) {
+        return !(active.regions[r].exclusive && regionOwners_[r] > 0);
+    });
+}
+
+/**
+ * @brief 把手指绑定到区域：发送点击并开始长按检测（按下命中与滑入共用）
+ */
+void InputEngine::bindRegion(int slot, int regionIndex, int x, int y, const ConfigSnapshot& active) {
+    const ClickableRegion& region = active.regions[regionIndex];
+    const SlotMask bit = slotBit(slot);
+    slots_.regionIndex[slot] = static_cast<int16_t>(regionIndex);
+    slots_.regionId[slot] = region.id;
+    slots_.bound |= bit;
+    slots_.longPressPending |= bit;
+    slots_.longPressSent &= ~bit;
+    ++regionOwners_[regionIndex];
+    runtimeStatsAdd(RuntimeStatsField::RegionHits, 1);
+    if (active.sink) {
+        active.sink->onUiEvent(UiEventKind::Tap, region, x, y, slots_.downTimestampMs[slot]);
+    }
+    if (region.gestureMask != 0) {
+        gestures_.onContactDown(slot, regionIndex, x, y, steadyNowMs(), gestureOut_);
+    }
+}
+
+/**
+ * @brief 解除手指与区域的绑定：已发送按下时补发长按结束（抬起与滑出共用）
+ */
+void InputEngine::releaseRegion(int slot, int x, int y, const ConfigSnapshot& active) {
+    const SlotMask bit = slotBit(slot);
+    if ((slots_.longPressSent & bit) && active.sink) {
+        ClickableRegion scratch;
+        const ClickableRegion& region = slotRegion(slot, active, scratch);
+        TRACE_I(TraceEvent::LongPressEnd, slot, region.identifier);
+        active.sink->onUiEvent(UiEventKind::LongPressEnd, region, x, y, slots_.downTimestampMs[slot]);
+    }
+    if (gestures_.hasGestureRegions()) {
+        gestures_.onContactUp(slot, steadyNowMs(), gestureOut_);
+        deliverGestures(active);
+    }
+    const int index = slots_.regionIndex[slot];
+    if (index >= 0 && regionOwners_[index] > 0) {
+        --regionOwners_[index];
+    }
+    slots_.regionIndex[slot] = -1;
+    slots_.regionId[slot] = -1;
+    slots_.bound &= ~bit;
+    slots_.longPressPending &= ~bit;
+    slots_.longPressSent &= ~bit;
+}
+
+/**
+ * @brief 命中区域并按住超过 LONG_PRESS_START_DELAY_MS 时发送按下事件；同时结算到期的手势
+ */
+void InputEngine::checkLongPressStart(const ConfigSnapshot& active) {
+    long long checkTimeMs = steadyNowMs();
+    if (gestures_.hasGestureRegions()) {
+        const long long gestureDeadline = gestures_.nextDeadlineMs();
+        if (gestureDeadline >= 0 && checkTimeMs >= gestureDeadline) {
+            gestures_.onTimer(checkTimeMs, gestureOut_);
+            deliverGestures(active);
+            flushSink(active);
+        }
+    }
+    forEachSlot(slots_.longPressPending, [&](int i) {
+        long long duration = checkTimeMs - slots_.downTimestampMs[i];
+        if (duration < LONG_PRESS_START_DELAY_MS) {
+            return;
+        }
+        ClickableRegion scratch;
+        const ClickableRegion& region = slotRegion(i, active, scratch);
+        TRACE_I(TraceEvent::LongPressStart, i, duration, LONG_PRESS_START_DELAY_MS, region.identifier);
+        if (active.sink) {
+            active.sink->onUiEvent(UiEventKind::PressDown, region,
+                                   slots_.downX[i], slots_.downY[i], slots_.downTimestampMs[i]);
+            flushSink(active);
+        }
+        slots_.longPressSent |= slotBit(i);
+        slots_.longPressPending &= ~slotBit(i);
+    });
+}
+
+/**
+ * @brief poll 超时：距离最近一个长按开始或手势截止点的毫秒数，没有待检测的触摸点时无限等待
+ */
+int InputEngine::nextPollTimeoutMs() const {
+    long long nearestDeadline = LLONG_MAX;
+    forEachSlot(slots_.longPressPending, [&](int i) {
+        nearestDeadline = std::min(nearestDeadline, slots_.downTimestampMs[i] + LONG_PRESS_START_DELAY_MS);
+    });
+    const long long gestureDeadline = gestures_.nextDeadlineMs();
+    if (gestureDeadline >= 0) {
+        nearestDeadline = std::min(nearestDeadline, gestureDeadline);
+    }
+    if (nearestDeadline == LLONG_MAX) {
+        return -1;
+    }
+    const long long remaining = nearestDeadline - steadyNowMs();
+    return remaining > 0 ? static_cast<int>(remaining) : 0;
 }
@@ -0,0 +1,60 @@
+#ifndef INPUT_TYPES_H
+#define INPUT_TYPES_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "touch_smoothing.h"
+#include "touch_slots.h"
+
+/**
+ * @brief 区域命中形状（区域 JSON 的 "shape"），外接矩形始终是 left / top / width / height
+ */
+enum class RegionShape : uint8_t {
+    Rect = 0,     // "rect"
+    Circle,       // "circle": 以外接矩形中心为圆心、短边为直径；长宽不等时为两端半圆的胶囊形
+    RoundedRect,  // "roundRect": 圆角半径见 cornerRadius
+    Polygon,      // "polygon": 凸多边形，顶点见 polygon
+};
+
+/**
+ * @brief 多边形顶点，相对于区域的 left / top（像素）
+ */
+struct RegionPoint {
+    float x = 0.0f;
+    float y = 0.0f;
+};
+
+/**
+ * @brief 可点击区域信息结构体
+ */
+struct ClickableRegion {
+    std::string identifier;
+    int32_t id = -1;          // 整数区域 ID，由引擎按 identifier 分配，区域表更新后保持不变
+    int left = 0;
+    int top = 0;
+    int width = 0;
+    int height = 0;
+    uint32_t gestureMask = 0; // 启用的手势，见 gesture_recognizer.h 中的 GESTURE_MASK_*
+
+    // 命中形状，由 region_hit_table.h 在区域表更新时编译为批量测试用的形式
+    RegionShape shape = RegionShape::Rect;
+    int cornerRadius = 0;     // "cornerRadiusPx": roundRect 的圆角半径，超过短边一半时按一半处理
+    int padding = 0;          // "paddingPx": 命中范围沿形状轮廓向外扩展（负值向内收缩）
+    int priority = 0;         // "priority": 重叠区域中数值大的优先，相同时区域表中靠前的优先
+    std::vector<RegionPoint> polygon; // "points": polygon 的顶点（按顺序，顺 / 逆时针均可）
+
+    // 触摸策略（区域 JSON 的 "policies" 数组），默认保持"按下时绑定、抬起时释放、触摸数据照常输出"
+    bool slideIn = false;     // "slideIn": 在区域外按下的手指滑入时视为按下
+    bool slideOut = false;    // "slideOut": 绑定的手指滑出区域时视为抬起
+    bool capture = false;     // "capture": 绑定期间不再输出该手指的普通触摸数据
+    bool exclusive = false;   // "exclusive": 同一时刻只允许一根手指绑定，其余手指按未命中处理
+    bool passThrough = false; // "passThrough": 独占模式下绑定的手指仍转发给系统
+
+    // 绑定到本区域且仍输出的手指使用的抖动过滤参数（区域 JSON 的 "smoothing" 对象）
+    bool customSmoothing = false;
+    OneEuroParams smoothing;
+};
+
+#endif // INPUT_TYPES_H
@@ -0,0 +1,212 @@
+#include "pen_decoder.h"
+
+#include <algorithm>
+#include <cmath>
+#include <sys/ioctl.h>
+
+namespace {
+
+inline bool testBit(const unsigned long* bits, int bit) {
+    static constexpr int BITS_PER_WORD = sizeof(unsigned long) * 8;
+    return (bits[bit / BITS_PER_WORD] >> (bit % BITS_PER_WORD)) & 1UL;
+}
+
+} // namespace
+
+void PenDecoder::queryAxes(int fd) {
+    struct AxisQuery {
+        int code;
+        Axis* axis;
+    };
+    const AxisQuery queries[] = {
+        {ABS_X, &x_},
+        {ABS_Y, &y_},
+        {ABS_PRESSURE, &pressure_},
+        {ABS_DISTANCE, &distance_},
+        {ABS_TILT_X, &tiltX_},
+        {ABS_TILT_Y, &tiltY_},
+    };
+    for (const auto& query : queries) {
+        *query.axis = Axis();
+        struct input_absinfo absinfo;
+        if (ioctl(fd, EVIOCGABS(query.code), &absinfo) == 0) {
+            query.axis->present = true;
+            query.axis->minimum = absinfo.minimum;
+            query.axis->maximum = absinfo.maximum;
+            query.axis->resolution = absinfo.resolution;
+        }
+    }
+    static constexpr int BITS_PER_WORD = sizeof(unsigned long) * 8;
+    unsigned long keyBits[(KEY_CNT + BITS_PER_WORD - 1) / BITS_PER_WORD] = {};
+    hasPenTool_ = ioctl(fd, EVIOCGBIT(EV_KEY, sizeof(keyBits)), keyBits) >= 0
+        && (testBit(keyBits, BTN_TOOL_PEN) || testBit(keyBits, BTN_TOOL_RUBBER));
+    reset();
+}
+
+void PenDecoder::setPositionRange(int maxX, int maxY) {
+    if (maxX > 0) setAxisRange(ABS_X, 0, maxX);
+    if (maxY > 0) setAxisRange(ABS_Y, 0, maxY);
+}
+
+void PenDecoder::setAxisRange(int code, int minimum, int maximum, int resolution) {
+    Axis* axis = axisFor(code);
+    if (!axis) {
+        return;
+    }
+    axis->present = true;
+    axis->minimum = minimum;
+    axis->maximum = maximum;
+    axis->resolution = resolution;
+}
+
+PenDecoder::Axis* PenDecoder::axisFor(int code) {
+    switch (code) {
+    case ABS_X: return &x_;
+    case ABS_Y: return &y_;
+    case ABS_PRESSURE: return &pressure_;
+    case ABS_DISTANCE: return &distance_;
+    case ABS_TILT_X: return &tiltX_;
+    case ABS_TILT_Y: return &tiltY_;
+    default: return nullptr;
+    }
+}
+
+void PenDecoder::reset() {
+    rawX_ = rawY_ = 0;
+    rawPressure_ = rawDistance_ = 0;
+    rawTiltX_ = rawTiltY_ = 0;
+    toolPen_ = toolRubber_ = false;
+    touching_ = button1_ = button2_ = false;
+    dirty_ = false;
+    reportedInRange_ = false;
+    syncDropped_ = false;
+}
+
+bool PenDecoder::handleEvent(const struct input_event& ev) {
+    if (ev.type == EV_ABS) {
+        switch (ev.code) {
+        case ABS_X: rawX_ = ev.value; break;
+        case ABS_Y: rawY_ = ev.value; break;
+        case ABS_PRESSURE: rawPressure_ = ev.value; break;
+        case ABS_DISTANCE: rawDistance_ = ev.value; break;
+        case ABS_TILT_X: rawTiltX_ = ev.value; break;
+        case ABS_TILT_Y: rawTiltY_ = ev.value; break;
+        default: return false;
+        }
+    } else if (ev.type == EV_KEY) {
+        const bool down = ev.value != 0; // 1 按下，2 自动重复
+        switch (ev.code) {
+        case BTN_TOOL_PEN: toolPen_ = down; break;
+        case BTN_TOOL_RUBBER: toolRubber_ = down; break;
+        case BTN_TOUCH: touching_ = down; break;
+        case BTN_STYLUS: button1_ = down; break;
+        case BTN_STYLUS2: button2_ = down; break;
+        default: return false;
+        }
+    } else {
+        return false;
+    }
+    dirty_ = true;
+    return true;
+}
+
+bool PenDecoder::resync(int fd) {
+    syncDropped_ = false;
+    static constexpr int BITS_PER_WORD = sizeof(unsigned long) * 8;
+    unsigned long keyState[(KEY_CNT + BITS_PER_WORD - 1) / BITS_PER_WORD] = {};
+    if (fd < 0 || ioctl(fd, EVIOCGKEY(sizeof(keyState)), keyState) < 0) {
+        return false;
+    }
+    toolPen_ = testBit(keyState, BTN_TOOL_PEN);
+    toolRubber_ = testBit(keyState, BTN_TOOL_RUBBER);
+    touching_ = testBit(keyState, BTN_TOUCH);
+    button1_ = testBit(keyState, BTN_STYLUS);
+    button2_ = testBit(keyState, BTN_STYLUS2);
+
+    struct ValueQuery {
+        int code;
+        bool present;
+        int* value;
+    };
+    const ValueQuery queries[] = {
+        {ABS_X, x_.present, &rawX_},
+        {ABS_Y, y_.present, &rawY_},
+        {ABS_PRESSURE, pressure_.present, &rawPressure_},
+        {ABS_DISTANCE, distance_.present, &rawDistance_},
+        {ABS_TILT_X, tiltX_.present, &rawTiltX_},
+        {ABS_TILT_Y, tiltY_.present, &rawTiltY_},
+    };
+    for (const auto& query : queries) {
+        struct input_absinfo absinfo;
+        if (query.present && ioctl(fd, EVIOCGABS(query.code), &absinfo) == 0) {
+            *query.value = absinfo.value;
+        }
+    }
+    dirty_ = true;
+    return true;
+}
+
+bool PenDecoder::takeSample(long long timestampUs, PenSample& out) {
+    if (!dirty_) {
+        return false;
+    }
+    dirty_ = false;
+    const bool inRange = toolPen_ || toolRubber_;
+    if (!inRange && !reportedInRange_) {
+        return false;
+    }
+    reportedInRange_ = inRange;
+
+    out.timestampUs = timestampUs;
+    out.x = rawX_;
+    out.y = rawY_;
+    out.flags = 0;
+    out.pressure = 0;
+    out.distance = 0;
+    out.tiltX = 0;
+    out.tiltY = 0;
+    if (!inRange) {
+        return true;
+    }
+    // 部分笔不报告 BTN_TOUCH，以压力高于轴最小值判断接触
+    const bool contact = touching_ || (pressure_.present && rawPressure_ > pressure_.minimum);
+    out.flags = PEN_FLAG_IN_RANGE
+        | (contact ? PEN_FLAG_CONTACT : 0)
+        | (button1_ ? PEN_FLAG_BUTTON1 : 0)
+        | (button2_ ? PEN_FLAG_BUTTON2 : 0)
+        | (toolRubber_ ? PEN_FLAG_ERASER : 0);
+    if (contact) {
+        out.pressure = static_cast<uint16_t>(scaled(rawPressure_, pressure_, PEN_PRESSURE_SCALE));
+    } else {
+        out.distance = static_cast<uint16_t>(scaled(rawDistance_, distance_, 1000));
+    }
+    // 面板相对屏幕旋转 90°：屏幕 X 沿原生 Y，屏幕 Y 沿原生 -X（与触摸坐标换算一致）
+    out.tiltX = tiltCentiDegrees(rawTiltY_, tiltY_);
+    out.tiltY = static_cast<int16_t>(-tiltCentiDegrees(rawTiltX_, tiltX_));
+    return true;
+}
+
+/**
+ * @brief 原始轴值 -> 轴范围的 scale 分比，设备不支持该轴时为 0
+ */
+int PenDecoder::scaled(int value, const Axis& axis, int scale) {
+    if (!axis.present || axis.maximum <= axis.minimum) {
+        return 0;
+    }
+    const long long ratio = static_cast<long long>(value - axis.minimum) * scale / (axis.maximum - axis.minimum);
+    return static_cast<int>(std::max(0LL, std::min(static_cast<long long>(scale), ratio)));
+}
+
+/**
+ * @brief 倾角原始值 -> 0.01°。内核约定 0 为垂直于屏幕；resolution 为单位 / 弧度，未报告时按度处理
+ */
+int16_t PenDecoder::tiltCentiDegrees(int value, const Axis& axis) {
+    if (!axis.present) {
+        return 0;
+    }
+    const double degrees = axis.resolution > 0
+        ? value * (180.0 / M_PI) / axis.resolution
+        : static_cast<double>(value);
+    const long centi = std::lround(degrees * 100.0);
+    return static_cast<int16_t>(std::max<long>(-PEN_TILT_LIMIT, std::min<long>(PEN_TILT_LIMIT, centi)));
+}
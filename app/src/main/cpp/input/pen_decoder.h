@@ -0,0 +1,136 @@
+#ifndef PEN_DECODER_H
+#define PEN_DECODER_H
+
+#include <cstdint>
+
+#include <linux/input.h>
+
+/**
+ * 主动笔（单点 ABS 协议）解码。
+ *
+ * 笔通过 BTN_TOOL_PEN / BTN_TOOL_RUBBER 报告进入感应范围，ABS_X / ABS_Y 为位置，
+ * ABS_PRESSURE、ABS_DISTANCE、ABS_TILT_X / ABS_TILT_Y 为压力、悬停距离与倾角，
+ * BTN_TOUCH 为接触，BTN_STYLUS / BTN_STYLUS2 为笔杆按键。解码器只保存原始值并置 dirty，
+ * 在 SYN_REPORT 时生成一个完整状态的采样：笔在范围内时每帧一个，离开范围时再补一个
+ * 不带 IN_RANGE 的采样。工具位未按下时的 ABS_X / ABS_Y（多点触控面板为手指模拟的单点事件）
+ * 不产生输出。
+ *
+ * 笔可以与触摸在同一个设备节点上（集成数位板），也可以是独立的节点，每个节点一个解码器。
+ * 本模块不依赖 Android，可在 Linux 主机上测试。
+ */
+
+// PenSample::flags
+static constexpr uint8_t PEN_FLAG_IN_RANGE = 0x01; // 笔在感应范围内（悬停或接触）
+static constexpr uint8_t PEN_FLAG_CONTACT = 0x02;  // 笔尖接触屏幕
+static constexpr uint8_t PEN_FLAG_BUTTON1 = 0x04;  // BTN_STYLUS
+static constexpr uint8_t PEN_FLAG_BUTTON2 = 0x08;  // BTN_STYLUS2
+static constexpr uint8_t PEN_FLAG_ERASER = 0x10;   // 工具为橡皮擦端 (BTN_TOOL_RUBBER)
+
+static constexpr int PEN_PRESSURE_SCALE = 10000;   // 压力输出为轴范围的万分比
+static constexpr int PEN_TILT_LIMIT = 9000;        // 倾角输出单位 0.01°，范围 ±90°
+
+/**
+ * @brief 一个笔采样
+ *
+ * 解码器输出的 x / y 为设备原生坐标，由引擎换算到悬浮窗坐标后交给输出；
+ * 倾角已按面板与屏幕的 90° 旋转换算到屏幕坐标系（tiltX 为向屏幕 +X 倾斜）。
+ */
+struct PenSample {
+    long long timestampUs = 0; // 帧 (SYN_REPORT) 的内核时间戳
+    int x = 0;
+    int y = 0;
+    uint16_t pressure = 0;     // 轴范围的万分比；未接触或设备不支持时为 0
+    uint16_t distance = 0;     // 悬停距离，轴范围的千分比；接触或设备不支持时为 0
+    int16_t tiltX = 0;         // 0.01°
+    int16_t tiltY = 0;
+    uint8_t flags = 0;         // PEN_FLAG_*
+};
+
+class PenDecoder {
+public:
+    /**
+     * @brief 读取笔相关轴的范围（EVIOCGABS）与是否支持 BTN_TOOL_PEN；非 evdev fd 上各轴视为不支持
+     */
+    void queryAxes(int fd);
+
+    /**
+     * @brief 外部 fd（回放管道）无法查询轴时，使用给定的位置范围
+     */
+    void setPositionRange(int maxX, int maxY);
+
+    /**
+     * @brief 手动设置一个笔轴（ABS_X / ABS_Y / ABS_PRESSURE / ABS_DISTANCE / ABS_TILT_X / ABS_TILT_Y）的范围
+     * @param resolution 倾角轴为单位 / 弧度，0 表示按度处理
+     */
+    void setAxisRange(int code, int minimum, int maximum, int resolution = 0);
+
+    /**
+     * @brief 清空状态（设备切换、重新打开后调用）
+     */
+    void reset();
+
+    /**
+     * @brief 处理一个 EV_KEY / EV_ABS 事件
+     * @return 事件属于笔（已记录）时为 true
+     */
+    bool handleEvent(const struct input_event& ev);
+
+    /**
+     * @brief 收到 SYN_DROPPED：丢弃到下一个 SYN_REPORT 为止的事件
+     */
+    void onSyncDropped() { syncDropped_ = true; }
+    bool syncDropped() const { return syncDropped_; }
+
+    /**
+     * @brief SYN_DROPPED 之后用 EVIOCGKEY / EVIOCGABS 读回完整状态
+     * @return 查询失败（回放管道等）时为 false，保留当前状态
+     */
+    bool resync(int fd);
+
+    /**
+     * @brief 一帧结束：有需要输出的变化时生成采样（x / y 为原生坐标）
+     */
+    bool takeSample(long long timestampUs, PenSample& out);
+
+    bool hasPenTool() const { return hasPenTool_; }
+    int maxX() const { return x_.maximum; }
+    int maxY() const { return y_.maximum; }
+
+private:
+    struct Axis {
+        bool present = false;
+        int minimum = 0;
+        int maximum = 0;
+        int resolution = 0;   // 倾角轴：单位 / 弧度；0 表示按度处理
+    };
+
+    Axis* axisFor(int code);
+    static int scaled(int value, const Axis& axis, int scale);
+    static int16_t tiltCentiDegrees(int value, const Axis& axis);
+
+    Axis x_;
+    Axis y_;
+    Axis pressure_;
+    Axis distance_;
+    Axis tiltX_;
+    Axis tiltY_;
+    bool hasPenTool_ = false;
+
+    int rawX_ = 0;
+    int rawY_ = 0;
+    int rawPressure_ = 0;
+    int rawDistance_ = 0;
+    int rawTiltX_ = 0;
+    int rawTiltY_ = 0;
+    bool toolPen_ = false;
+    bool toolRubber_ = false;
+    bool touching_ = false;
+    bool button1_ = false;
+    bool button2_ = false;
+
+    bool dirty_ = false;
+    bool reportedInRange_ = false; // 上一个输出的采样在范围内，离开时需要补发
+    bool syncDropped_ = false;
+};
+
+#endif // PEN_DECODER_H
@@ -0,0 +1,506 @@
+#include "privileged_helper.h"
+
+#include <algorithm>
+#include <android/log.h>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+// 日志标签
+#define TAG "NativePrivilegedHelper"
+
+namespace {
+
+/**
+ * @brief 填充抽象命名空间地址（sun_path[0] 为 0，不在文件系统中创建节点）
+ */
+socklen_t abstractAddress(const char* name, sockaddr_un& addr) {
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    const size_t length = std::min(std::strlen(name), sizeof(addr.sun_path) - 1);
+    std::memcpy(addr.sun_path + 1, name, length);
+    return static_cast<socklen_t>(offsetof(sockaddr_un, sun_path) + 1 + length);
+}
+
+bool peerUid(int fd, uid_t& uid) {
+    struct ucred cred;
+    socklen_t length = sizeof(cred);
+    if (getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &length) != 0) {
+        return false;
+    }
+    uid = cred.uid;
+    return true;
+}
+
+/**
+ * @brief 辅助进程只打开触摸 / 输入设备与 uinput，拒绝其它一切路径
+ */
+bool isAllowedPath(const char* path) {
+    if (std::strcmp(path, "/dev/uinput") == 0) {
+        return true;
+    }
+    static constexpr char EVENT_PREFIX[] = "/dev/input/event";
+    const size_t prefixLength = sizeof(EVENT_PREFIX) - 1;
+    if (std::strncmp(path, EVENT_PREFIX, prefixLength) == 0) {
+        const char* digits = path + prefixLength;
+        const size_t count = std::strlen(digits);
+        if (count == 0 || count > 4) {
+            return false;
+        }
+        for (size_t i = 0; i < count; ++i) {
+            if (digits[i] < '0' || digits[i] > '9') {
+                return false;
+            }
+        }
+        return true;
+    }
+#ifdef PRIVILEGED_HELPER_EXTRA_PREFIX
+    // 仅主机测试构建定义：允许测试目录下的普通文件，验证 fd 传递
+    const size_t extraLength = std::strlen(PRIVILEGED_HELPER_EXTRA_PREFIX);
+    if (std::strncmp(path, PRIVILEGED_HELPER_EXTRA_PREFIX, extraLength) == 0 && !std::strstr(path, "..")) {
+        return true;
+    }
+#endif
+    return false;
+}
+
+/**
+ * @brief 安全上下文 "u:r:<type>:s0..." 中的类型字段
+ */
+std::string contextType(const std::string& context) {
+    const size_t first = context.find(':');
+    const size_t second = first == std::string::npos ? first : context.find(':', first + 1);
+    const size_t third = second == std::string::npos ? second : context.find(':', second + 1);
+    if (third == std::string::npos) {
+        return std::string();
+    }
+    return context.substr(second + 1, third - second - 1);
+}
+
+/**
+ * @brief 读取 /proc/<pid>/attr/current 一类文件中的安全上下文类型；失败时为空串
+ */
+std::string contextTypeFromFile(const std::string& path) {
+    char context[256] = {};
+    const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return std::string();
+    }
+    const ssize_t n = read(fd, context, sizeof(context) - 1);
+    close(fd);
+    if (n <= 0) {
+        return std::string();
+    }
+    return contextType(std::string(context, strnlen(context, static_cast<size_t>(n))));
+}
+
+bool selinuxEnforcing() {
+    const int fd = open("/sys/fs/selinux/enforce", O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    char value = '0';
+    const bool ok = read(fd, &value, 1) == 1;
+    close(fd);
+    return ok && value == '1';
+}
+
+/**
+ * @brief 以 argv 直接 exec（不经 shell），返回退出码；无法执行时为 127
+ */
+int runCommand(const std::vector<std::string>& args) {
+    std::vector<char*> argv;
+    for (const auto& arg : args) {
+        argv.push_back(const_cast<char*>(arg.c_str()));
+    }
+    argv.push_back(nullptr);
+    const pid_t pid = fork();
+    if (pid == 0) {
+        const int devNull = open("/dev/null", O_WRONLY);
+        if (devNull >= 0) {
+            dup2(devNull, STDOUT_FILENO);
+            dup2(devNull, STDERR_FILENO);
+        }
+        execvp(argv[0], argv.data());
+        _exit(127);
+    }
+    if (pid < 0) {
+        return 127;
+    }
+    int status = 0;
+    while (waitpid(pid, &status, 0) < 0 && errno == EINTR) {
+    }
+    return WIFEXITED(status) ? WEXITSTATUS(status) : 127;
+}
+
+/**
+ * @brief SELinux 强制模式下，为应用所在的域加入读写输入设备所需的最小规则（不关闭强制模式）
+ *
+ * 经 SCM_RIGHTS 收到的 fd 在接收时以及之后每次 read / ioctl 都按接收方（应用域，如 untrusted_app_32）
+ * 检查 input_device / uinput_device chr_file 权限，还要检查能否使用辅助进程域打开的 fd，
+ * 所以只传 fd 不够。应用域取自对端 socket 的 SO_PEERSEC，其次是对端进程（SO_PEERCRED）的
+ * /proc/<pid>/attr/current；都取不到时不加任何规则，而不是猜测一个会放开所有应用的域。
+ */
+void installSelinuxRules(int clientFd) {
+    if (!selinuxEnforcing()) {
+        return;
+    }
+    char peer[256] = {};
+    socklen_t peerLength = sizeof(peer) - 1;
+    std::string appType;
+    if (getsockopt(clientFd, SOL_SOCKET, SO_PEERSEC, peer, &peerLength) == 0) {
+        appType = contextType(std::string(peer, strnlen(peer, peerLength)));
+    }
+    if (appType.empty()) {
+        struct ucred cred;
+        socklen_t credLength = sizeof(cred);
+        if (getsockopt(clientFd, SOL_SOCKET, SO_PEERCRED, &cred, &credLength) == 0) {
+            appType = contextTypeFromFile("/proc/" + std::to_string(cred.pid) + "/attr/current");
+        }
+    }
+    if (appType.empty()) {
+        __android_log_print(ANDROID_LOG_ERROR, TAG, "辅助进程: 无法确定应用的 SELinux 域，不加入规则");
+        return;
+    }
+    const std::string selfType = contextTypeFromFile("/proc/self/attr/current");
+
+    std::vector<std::string> rules = {
+        "allow " + appType + " input_device chr_file { read write ioctl getattr }",
+        "allow " + appType + " uinput_device chr_file { read write ioctl getattr }",
+    };
+    if (!selfType.empty()) {
+        rules.push_back("allow " + appType + " " + selfType + " fd use");
+    }
+    // Magisk 的 magiskpolicy，其次是 SuperSU 的 supolicy
+    for (const char* tool : {"magiskpolicy", "supolicy"}) {
+        std::vector<std::string> args = {tool, "--live"};
+        args.insert(args.end(), rules.begin(), rules.end());
+        const int exitCode = runCommand(args);
+        if (exitCode == 0) {
+            __android_log_print(ANDROID_LOG_INFO, TAG, "辅助进程: 已经 %s 为 %s 加入输入设备规则", tool, appType.c_str());
+            return;
+        }
+        if (exitCode != 127) {
+            __android_log_print(ANDROID_LOG_WARN, TAG, "辅助进程: %s --live 退出码 %d", tool, exitCode);
+        }
+    }
+    __android_log_print(ANDROID_LOG_WARN, TAG,
+        "辅助进程: 无法加入 SELinux 规则，应用将无法接收设备 fd");
+}
+
+int64_t elapsedUs(std::chrono::steady_clock::time_point since) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - since).count();
+}
+
+} // namespace
+
+// ---------------- 辅助进程 ----------------
+
+int privilegedHelperMain(const char* socketName, uid_t clientUid) {
+    const int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    sockaddr_un addr;
+    const socklen_t addrLength = abstractAddress(socketName, addr);
+    if (fd < 0 || connect(fd, reinterpret_cast<sockaddr*>(&addr), addrLength) != 0) {
+        __android_log_print(ANDROID_LOG_ERROR, TAG, "辅助进程: 连接 %s 失败: %s", socketName, strerror(errno));
+        return 1;
+    }
+    uid_t uid = 0;
+    if (!peerUid(fd, uid) || uid != clientUid) {
+        __android_log_print(ANDROID_LOG_ERROR, TAG, "辅助进程: 对端 uid=%u 与预期 %u 不符，退出", uid, clientUid);
+        return 2;
+    }
+    __android_log_print(ANDROID_LOG_INFO, TAG, "辅助进程: 已连接 (pid=%d, euid=%u)", getpid(), geteuid());
+    installSelinuxRules(fd);
+
+    for (;;) {
+        HelperRequest request;
+        const ssize_t n = recv(fd, &request, sizeof(request), MSG_WAITALL);
+        if (n == 0) {
+            return 0; // 应用关闭了连接
+        }
+        if (n != static_cast<ssize_t>(sizeof(request))) {
+            return 1;
+        }
+        request.path[HELPER_PATH_BYTES - 1] = '\0';
+
+        HelperResponse response{0};
+        int deviceFd = -1;
+        if (request.op == HELPER_OP_PING) {
+            // 空响应
+        } else if (request.op == HELPER_OP_OPEN) {
+            if (!isAllowedPath(request.path)) {
+                response.error = EACCES;
+            } else {
+                deviceFd = open(request.path, (request.flags & (O_ACCMODE | O_NONBLOCK)) | O_CLOEXEC);
+                response.error = deviceFd < 0 ? errno : 0;
+            }
+        } else {
+            response.error = EINVAL;
+        }
+
+        iovec iov{&response, sizeof(response)};
+        msghdr msg{};
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))];
+        if (deviceFd >= 0) {
+            msg.msg_control = control;
+            msg.msg_controllen = sizeof(control);
+            cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+            cmsg->cmsg_level = SOL_SOCKET;
+            cmsg->cmsg_type = SCM_RIGHTS;
+            cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+            std::memcpy(CMSG_DATA(cmsg), &deviceFd, sizeof(int));
+        }
+        const ssize_t sent = sendmsg(fd, &msg, MSG_NOSIGNAL);
+        if (deviceFd >= 0) {
+            close(deviceFd);
+        }
+        if (sent != static_cast<ssize_t>(sizeof(response))) {
+            return 1;
+        }
+    }
+}
+
+// ---------------- 客户端 ----------------
+
+PrivilegedHelper& privilegedHelper() {
+    static PrivilegedHelper helper;
+    return helper;
+}
+
+PrivilegedHelper::~PrivilegedHelper() {
+    stop();
+}
+
+void PrivilegedHelper::configure(const std::string& helperPath, bool viaSu) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    helperPath_ = helperPath;
+    viaSu_ = viaSu;
+}
+
+bool PrivilegedHelper::ensureRunning() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return socketFd_ >= 0 || startLocked();
+}
+
+bool PrivilegedHelper::isRunning() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return socketFd_ >= 0;
+}
+
+int64_t PrivilegedHelper::lastStartUs() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return lastStartUs_;
+}
+
+void PrivilegedHelper::stop() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopLocked();
+}
+
+bool PrivilegedHelper::startLocked() {
+    if (helperPath_.empty()) {
+        errno = ENOENT;
+        return false;
+    }
+    const auto startTime = std::chrono::steady_clock::now();
+
+    // 名称带 pid 与时间戳，避免与上一次启动或其它进程冲突；对端身份另由 SO_PEERCRED 校验
+    char name[80];
+    snprintf(name, sizeof(name), "lowlatencyinput.helper.%d.%lld", getpid(),
+             (long long)startTime.time_since_epoch().count());
+    const int listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    sockaddr_un addr;
+    const socklen_t addrLength = abstractAddress(name, addr);
+    if (listenFd < 0 || bind(listenFd, reinterpret_cast<sockaddr*>(&addr), addrLength) != 0
+        || listen(listenFd, 1) != 0) {
+        const int savedErrno = errno;
+        if (listenFd >= 0) close(listenFd);
+        __android_log_print(ANDROID_LOG_ERROR, TAG, "创建辅助进程 socket 失败: %s", strerror(savedErrno));
+        errno = savedErrno;
+        return false;
+    }
+
+    // fork 之前准备好所有参数，子进程里只调用 exec
+    const std::string uidArg = std::to_string(getuid());
+    const std::string command = "exec '" + helperPath_ + "' " + name + " " + uidArg;
+    const uid_t expectedPeer = viaSu_ ? 0 : getuid();
+
+    const pid_t pid = fork();
+    if (pid == 0) {
+        if (viaSu_) {
+            execlp("su", "su", "-c", command.c_str(), static_cast<char*>(nullptr));
+        } else {
+            execl(helperPath_.c_str(), helperPath_.c_str(), name, uidArg.c_str(), static_cast<char*>(nullptr));
+        }
+        _exit(127);
+    }
+    if (pid < 0) {
+        const int savedErrno = errno;
+        close(listenFd);
+        errno = savedErrno;
+        return false;
+    }
+
+    // 等待辅助进程连回；su 被拒绝时子进程会先退出
+    int connected = -1;
+    int failure = ETIMEDOUT;
+    while (connected < 0 && elapsedUs(startTime) < START_TIMEOUT_MS * 1000LL) {
+        pollfd pfd{listenFd, POLLIN, 0};
+        if (poll(&pfd, 1, 50) > 0) {
+            const int fd = accept4(listenFd, nullptr, nullptr, SOCK_CLOEXEC);
+            uid_t uid = 0;
+            if (fd >= 0 && peerUid(fd, uid) && uid == expectedPeer) {
+                connected = fd;
+                break;
+            }
+            if (fd >= 0) {
+                __android_log_print(ANDROID_LOG_WARN, TAG, "拒绝 uid=%u 的连接", uid);
+                close(fd);
+            }
+        }
+        int status = 0;
+        if (waitpid(pid, &status, WNOHANG) == pid) {
+            __android_log_print(ANDROID_LOG_ERROR, TAG, "辅助进程在连接前退出 (status=0x%x)", status);
+            failure = EACCES;
+            close(listenFd);
+            errno = failure;
+            return false;
+        }
+    }
+    close(listenFd);
+    if (connected < 0) {
+        kill(pid, SIGKILL);
+        waitpid(pid, nullptr, 0);
+        __android_log_print(ANDROID_LOG_ERROR, TAG, "等待辅助进程连接超时 (%d ms)", START_TIMEOUT_MS);
+        errno = failure;
+        return false;
+    }
+
+    socketFd_ = connected;
+    childPid_ = pid;
+    lastStartUs_ = elapsedUs(startTime);
+    __android_log_print(ANDROID_LOG_INFO, TAG, "辅助进程已连接: pid=%d, 启动耗时 %lld us%s",
+        pid, (long long)lastStartUs_, viaSu_ ? " (su)" : "");
+    return true;
+}
+
+void PrivilegedHelper::stopLocked() {
+    if (socketFd_ >= 0) {
+        close(socketFd_); // 辅助进程读到 EOF 后退出
+        socketFd_ = -1;
+    }
+    if (childPid_ > 0) {
+        // su 客户端在辅助进程退出后返回；给它一点时间，否则强制结束
+        const auto since = std::chrono::steady_clock::now();
+        while (waitpid(childPid_, nullptr, WNOHANG) == 0) {
+            if (elapsedUs(since) > 1000 * 1000) {
+                kill(childPid_, SIGKILL);
+                waitpid(childPid_, nullptr, 0);
+                break;
+            }
+            usleep(2000);
+        }
+        childPid_ = -1;
+    }
+}
+
+bool PrivilegedHelper::roundTripLocked(const HelperRequest& request, HelperResponse& response, int* receivedFd) {
+    if (send(socketFd_, &request, sizeof(request), MSG_NOSIGNAL) != static_cast<ssize_t>(sizeof(request))) {
+        return false;
+    }
+    iovec iov{&response, sizeof(response)};
+    msghdr msg{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))];
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    ssize_t n;
+    do {
+        n = recvmsg(socketFd_, &msg, MSG_WAITALL | MSG_CMSG_CLOEXEC);
+    } while (n < 0 && errno == EINTR);
+    if (n != static_cast<ssize_t>(sizeof(response))) {
+        return false;
+    }
+    if ((msg.msg_flags & MSG_CTRUNC) && response.error == 0) {
+        // 内核在安装 fd 前做 SELinux 检查，被拒绝时丢弃控制消息并置 MSG_CTRUNC
+        __android_log_print(ANDROID_LOG_WARN, TAG, "接收辅助进程的 fd 被拒绝（SELinux 规则未生效？）");
+    }
+    for (cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+        if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS) {
+            int fd = -1;
+            std::memcpy(&fd, CMSG_DATA(cmsg), sizeof(int));
+            if (receivedFd && *receivedFd < 0) {
+                *receivedFd = fd;
+            } else {
+                close(fd);
+            }
+        }
+    }
+    return true;
+}
+
+int PrivilegedHelper::openDevice(const std::string& path, int flags) {
+    if (path.size() >= HELPER_PATH_BYTES) {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+    HelperRequest request{};
+    request.op = HELPER_OP_OPEN;
+    request.flags = flags;
+    std::memcpy(request.path, path.c_str(), path.size() + 1);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    // 辅助进程意外退出时重启一次
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        if (socketFd_ < 0 && !startLocked()) {
+            return -1;
+        }
+        HelperResponse response{0};
+        int fd = -1;
+        if (roundTripLocked(request, response, &fd)) {
+            if (response.error != 0) {
+                if (fd >= 0) close(fd);
+                errno = response.error;
+                return -1;
+            }
+            if (fd < 0) {
+                errno = EPROTO;
+            }
+            return fd;
+        }
+        __android_log_print(ANDROID_LOG_WARN, TAG, "辅助进程连接中断，重新启动");
+        stopLocked();
+    }
+    errno = EPIPE;
+    return -1;
+}
+
+bool PrivilegedHelper::ping() {
+    HelperRequest request{};
+    request.op = HELPER_OP_PING;
+    std::lock_guard<std::mutex> lock(mutex_);
+    HelperResponse response{0};
+    if (socketFd_ < 0) {
+        return false;
+    }
+    if (!roundTripLocked(request, response, nullptr)) {
+        stopLocked();
+        return false;
+    }
+    return response.error == 0;
+}
@@ -0,0 +1,123 @@
+#ifndef PRIVILEGED_HELPER_H
+#define PRIVILEGED_HELPER_H
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <sys/types.h>
+
+/**
+ * 常驻的特权辅助进程。
+ *
+ * 原来每次打不开 /dev/input/eventN 都要 system("su -c setenforce 0") + system("su -c chmod 666 ...")，
+ * 每次都是一整个 shell + su 往返（常见几百毫秒），还要全局关闭 SELinux。
+ * 现在只在第一次需要时经 su 启动一次辅助进程（与主库一起打包的 liblowlatencyinput_helper.so），
+ * 它以 root 身份连回应用监听的抽象 Unix socket，此后按请求打开输入设备，
+ * 用 SCM_RIGHTS 把 fd 传回；之后的打开 / 重新打开只是一次 socket 往返。
+ *
+ * 辅助进程只接受白名单内的路径（/dev/input/eventN 与 /dev/uinput），只服务启动它的 uid，
+ * 应用侧的 socket 关闭（包括应用进程退出）时自行退出。
+ *
+ * SELinux 对传过来的 fd 仍按应用的域检查（接收时与每次 read / ioctl），所以强制模式下辅助进程
+ * 在连接后经 magiskpolicy / supolicy --live 只为应用域加入 input_device / uinput_device 的读写规则，
+ * 不再 setenforce 0。规则没能加入、fd 被拒收时 openDevice 以 EPROTO 失败，调用方应报错，不应退回 setenforce 0。
+ *
+ * 客户端与辅助进程共用本文件中的协议定义；两者都不依赖 JNI，Linux 主机上的
+ * privileged_helper_test 直接运行同一份实现（不经 su）。
+ */
+
+// ---------------- 协议 ----------------
+
+static constexpr uint32_t HELPER_OP_OPEN = 1; // 打开 path，成功时响应附带 fd
+static constexpr uint32_t HELPER_OP_PING = 2;
+
+static constexpr size_t HELPER_PATH_BYTES = 120;
+
+/**
+ * @brief 请求：定长，一次 send
+ */
+struct HelperRequest {
+    uint32_t op;
+    int32_t flags;                // open() 的访问模式与 O_NONBLOCK，其余位被忽略
+    char path[HELPER_PATH_BYTES]; // 以 0 结尾
+};
+
+/**
+ * @brief 响应：error 为 0 时 HELPER_OP_OPEN 的 fd 随 SCM_RIGHTS 附带
+ */
+struct HelperResponse {
+    int32_t error; // errno
+};
+
+/**
+ * @brief 辅助进程入口：连接 socketName（抽象命名空间），校验对端 uid 后循环处理请求
+ * @return 进程退出码
+ */
+int privilegedHelperMain(const char* socketName, uid_t clientUid);
+
+// ---------------- 客户端 ----------------
+
+class PrivilegedHelper {
+public:
+    PrivilegedHelper() = default;
+    ~PrivilegedHelper();
+
+    PrivilegedHelper(const PrivilegedHelper&) = delete;
+    PrivilegedHelper& operator=(const PrivilegedHelper&) = delete;
+
+    /**
+     * @brief 设置辅助进程可执行文件路径（应用的 nativeLibraryDir 下）
+     * @param viaSu true 时经 su 以 root 启动并要求对端 uid 为 0；false 时直接以当前 uid 启动（主机测试）
+     */
+    void configure(const std::string& helperPath, bool viaSu);
+
+    /**
+     * @brief 确保辅助进程已连接；未运行时启动并等待其连回
+     * @return 失败时 errno 保留原因（ENOENT 表示未配置路径，ETIMEDOUT 表示 su 被拒绝或超时）
+     */
+    bool ensureRunning();
+
+    /**
+     * @brief 经辅助进程打开设备
+     * @return 新 fd（带 O_CLOEXEC），失败返回 -1 并设置 errno；EPROTO 表示辅助进程已打开但 fd 未能传回
+     */
+    int openDevice(const std::string& path, int flags);
+
+    /**
+     * @brief 往返一次空请求，用于检测连接
+     */
+    bool ping();
+
+    /**
+     * @brief 关闭连接，辅助进程随之退出；回收子进程
+     */
+    void stop();
+
+    bool isRunning() const;
+
+    /**
+     * @brief 最近一次启动辅助进程耗时（fork 到对端连回），未启动过为 -1
+     */
+    int64_t lastStartUs() const;
+
+private:
+    static constexpr int START_TIMEOUT_MS = 5000; // su 可能弹出授权对话框
+
+    bool startLocked();
+    void stopLocked();
+    bool roundTripLocked(const HelperRequest& request, HelperResponse& response, int* receivedFd);
+
+    mutable std::mutex mutex_; // 串行化请求；请求期间持有
+    std::string helperPath_;
+    bool viaSu_ = true;
+    int socketFd_ = -1;
+    pid_t childPid_ = -1;
+    int64_t lastStartUs_ = -1;
+};
+
+/**
+ * @brief 进程内唯一的辅助进程客户端
+ */
+PrivilegedHelper& privilegedHelper();
+
+#endif // PRIVILEGED_HELPER_H
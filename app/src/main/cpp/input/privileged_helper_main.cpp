@@ -0,0 +1,14 @@
+#include "privileged_helper.h"
+
+#include <cstdlib>
+
+/**
+ * 特权辅助进程的可执行入口，由 PrivilegedHelper 经 su 启动：
+ *   liblowlatencyinput_helper.so <抽象 socket 名> <应用 uid>
+ */
+int main(int argc, char** argv) {
+    if (argc != 3) {
+        return 64;
+    }
+    return privilegedHelperMain(argv[1], static_cast<uid_t>(std::strtoul(argv[2], nullptr, 10)));
+}
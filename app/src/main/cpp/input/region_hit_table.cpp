@@ -0,0 +1,272 @@
+#include "region_hit_table.h"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <numeric>
+
+namespace {
+
+// 长度小于此值的边视为重复顶点
+constexpr float kMinEdgeLength = 1e-3f;
+
+inline float cross(const RegionPoint& a, const RegionPoint& b, const RegionPoint& c) {
+    return (b.x - a.x) * (c.y - b.y) - (b.y - a.y) * (c.x - b.x);
+}
+
+/**
+ * @brief 去掉相邻（含首尾）重复的顶点
+ */
+std::vector<RegionPoint> distinctVertices(const std::vector<RegionPoint>& points) {
+    std::vector<RegionPoint> out;
+    out.reserve(points.size());
+    for (const auto& p : points) {
+        if (out.empty() || std::hypot(p.x - out.back().x, p.y - out.back().y) >= kMinEdgeLength) {
+            out.push_back(p);
+        }
+    }
+    while (out.size() > 1 && std::hypot(out.front().x - out.back().x, out.front().y - out.back().y) < kMinEdgeLength) {
+        out.pop_back();
+    }
+    return out;
+}
+
+} // namespace
+
+bool RegionHitTable::isConvexPolygon(const std::vector<RegionPoint>& points) {
+    const std::vector<RegionPoint> p = distinctVertices(points);
+    const size_t n = p.size();
+    if (n < 3) {
+        return false;
+    }
+    int sign = 0;
+    float area = 0.0f;
+    for (size_t i = 0; i < n; ++i) {
+        const RegionPoint& a = p[i];
+        const RegionPoint& b = p[(i + 1) % n];
+        area += a.x * b.y - b.x * a.y;
+        const float turn = cross(a, b, p[(i + 2) % n]);
+        if (turn == 0.0f) {
+            continue;
+        }
+        const int s = turn > 0.0f ? 1 : -1;
+        if (sign != 0 && s != sign) {
+            return false;
+        }
+        sign = s;
+    }
+    return std::fabs(area) > kMinEdgeLength;
+}
+
+void RegionHitTable::build(const std::vector<ClickableRegion>& regions) {
+    const size_t n = regions.size();
+    std::vector<int> order(n);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(),
+                     [&](int a, int b) { return regions[a].priority > regions[b].priority; });
+
+    shapes_.clear();
+    edges_.clear();
+    shapes_.reserve(n);
+    rankByRegion_.assign(n, -1);
+    words_ = (n + 63) / 64;
+    slideInMask_.assign(words_, 0);
+    masks_.assign(words_ * MAX_POINTS, 0);
+    staged_ = 0;
+    ran_ = false;
+
+    slideInLeft_ = INT_MAX;
+    slideInTop_ = INT_MAX;
+    slideInRight_ = INT_MIN;
+    slideInBottom_ = INT_MIN;
+    for (size_t rank = 0; rank < n; ++rank) {
+        const int index = order[rank];
+        const ClickableRegion& region = regions[index];
+        Shape shape;
+        int bounds[4] = {0, 0, 0, 0};
+        if (region.shape == RegionShape::Polygon && isConvexPolygon(region.polygon)) {
+            compilePolygon(region, shape, bounds);
+        } else {
+            compileRoundedRect(region, shape, bounds);
+        }
+        shape.region = index;
+        shapes_.push_back(shape);
+        rankByRegion_[index] = static_cast<int>(rank);
+        if (region.slideIn && bounds[2] > bounds[0] && bounds[3] > bounds[1]) {
+            slideInMask_[rank / 64] |= uint64_t(1) << (rank % 64);
+            slideInLeft_ = std::min(slideInLeft_, bounds[0]);
+            slideInTop_ = std::min(slideInTop_, bounds[1]);
+            slideInRight_ = std::max(slideInRight_, bounds[2]);
+            slideInBottom_ = std::max(slideInBottom_, bounds[3]);
+        }
+    }
+    if (slideInRight_ < slideInLeft_) {
+        slideInLeft_ = slideInTop_ = slideInRight_ = slideInBottom_ = 0;
+    }
+}
+
+/**
+ * @brief 矩形 / 圆 / 圆角矩形（以及不是凸多边形的 polygon，按外接矩形处理）
+ * @param bounds 输出含 padding 的外接矩形 [left, top, right, bottom)；形状被 padding 收缩为空时 right <= left
+ */
+void RegionHitTable::compileRoundedRect(const ClickableRegion& region, Shape& shape, int bounds[4]) const {
+    const float halfW = region.width * 0.5f;
+    const float halfH = region.height * 0.5f;
+    float cornerRadius = 0.0f;
+    if (region.shape == RegionShape::Circle) {
+        cornerRadius = std::min(halfW, halfH);
+    } else if (region.shape == RegionShape::RoundedRect) {
+        cornerRadius = std::min(std::max(static_cast<float>(region.cornerRadius), 0.0f), std::min(halfW, halfH));
+    }
+    float hx = halfW - cornerRadius;
+    float hy = halfH - cornerRadius;
+    float radius = cornerRadius + static_cast<float>(region.padding);
+    if (radius < 0.0f) {
+        // 收缩超过圆角：先吃掉圆角，再收缩内矩形
+        hx += radius;
+        hy += radius;
+        radius = 0.0f;
+    }
+    shape.cx = region.left + halfW;
+    shape.cy = region.top + halfH;
+    if (hx < 0.0f || hy < 0.0f) {
+        shape.hx = shape.hy = -1.0f;
+        shape.radiusSq = 0.0f;
+        bounds[0] = bounds[1] = bounds[2] = bounds[3] = 0;
+        return;
+    }
+    shape.hx = hx;
+    shape.hy = hy;
+    shape.radiusSq = radius * radius;
+    bounds[0] = static_cast<int>(std::floor(shape.cx - hx - radius));
+    bounds[1] = static_cast<int>(std::floor(shape.cy - hy - radius));
+    bounds[2] = static_cast<int>(std::ceil(shape.cx + hx + radius));
+    bounds[3] = static_cast<int>(std::ceil(shape.cy + hy + radius));
+}
+
+/**
+ * @brief 凸多边形：每条边一个外法向半平面，padding 平移各边（外扩时顶点为尖角）
+ */
+void RegionHitTable::compilePolygon(const ClickableRegion& region, Shape& shape, int bounds[4]) {
+    std::vector<RegionPoint> p = distinctVertices(region.polygon);
+    for (auto& v : p) {
+        v.x += region.left;
+        v.y += region.top;
+    }
+    const size_t n = p.size();
+    float area = 0.0f;
+    for (size_t i = 0; i < n; ++i) {
+        area += p[i].x * p[(i + 1) % n].y - p[(i + 1) % n].x * p[i].y;
+    }
+    // 面积为正（y 向下的屏幕坐标中为顺时针）时 (dy, -dx) 指向外侧
+    const float orientation = area > 0.0f ? 1.0f : -1.0f;
+    const float padding = static_cast<float>(region.padding);
+
+    shape.edgeBegin = static_cast<uint32_t>(edges_.size());
+    shape.edgeCount = static_cast<uint32_t>(n);
+    for (size_t i = 0; i < n; ++i) {
+        const RegionPoint& a = p[i];
+        const RegionPoint& b = p[(i + 1) % n];
+        const float length = std::hypot(b.x - a.x, b.y - a.y);
+        Edge edge;
+        edge.nx = orientation * (b.y - a.y) / length;
+        edge.ny = orientation * -(b.x - a.x) / length;
+        edge.d = edge.nx * a.x + edge.ny * a.y + padding;
+        edges_.push_back(edge);
+    }
+
+    // 外接矩形：外扩时用平移后的顶点（相邻两边偏移线的交点），收缩时原顶点的外接矩形已足够
+    float minX = INFINITY;
+    float minY = INFINITY;
+    float maxX = -INFINITY;
+    float maxY = -INFINITY;
+    for (size_t i = 0; i < n; ++i) {
+        float x = p[i].x;
+        float y = p[i].y;
+        if (padding > 0.0f) {
+            const Edge& in = edges_[shape.edgeBegin + (i + n - 1) % n];
+            const Edge& out = edges_[shape.edgeBegin + i];
+            const float scale = padding / std::max(1.0f + in.nx * out.nx + in.ny * out.ny, 1e-3f);
+            x += (in.nx + out.nx) * scale;
+            y += (in.ny + out.ny) * scale;
+        }
+        minX = std::min(minX, x);
+        minY = std::min(minY, y);
+        maxX = std::max(maxX, x);
+        maxY = std::max(maxY, y);
+    }
+    bounds[0] = static_cast<int>(std::floor(minX));
+    bounds[1] = static_cast<int>(std::floor(minY));
+    bounds[2] = static_cast<int>(std::ceil(maxX));
+    bounds[3] = static_cast<int>(std::ceil(maxY));
+}
+
+int RegionHitTable::stage(int x, int y) {
+    if (ran_) {
+        staged_ = 0;
+        ran_ = false;
+    }
+    if (staged_ >= MAX_POINTS) {
+        return -1;
+    }
+    px_[staged_] = static_cast<float>(x) + 0.5f;
+    py_[staged_] = static_cast<float>(y) + 0.5f;
+    return staged_++;
+}
+
+void RegionHitTable::run() {
+    ran_ = true;
+    const int count = staged_;
+    if (count == 0) {
+        return;
+    }
+    for (size_t w = 0; w < words_; ++w) {
+        std::fill(&masks_[w * MAX_POINTS], &masks_[w * MAX_POINTS] + count, 0);
+    }
+    for (size_t rank = 0; rank < shapes_.size(); ++rank) {
+        const Shape& s = shapes_[rank];
+        if (s.edgeCount == 0) {
+            for (int t = 0; t < count; ++t) {
+                float dx = std::fabs(px_[t] - s.cx) - s.hx;
+                float dy = std::fabs(py_[t] - s.cy) - s.hy;
+                dx = dx > 0.0f ? dx : 0.0f;
+                dy = dy > 0.0f ? dy : 0.0f;
+                inside_[t] = dx * dx + dy * dy <= s.radiusSq;
+            }
+        } else {
+            std::fill(inside_, inside_ + count, 1);
+            for (uint32_t e = s.edgeBegin; e < s.edgeBegin + s.edgeCount; ++e) {
+                const Edge edge = edges_[e];
+                for (int t = 0; t < count; ++t) {
+                    inside_[t] &= edge.nx * px_[t] + edge.ny * py_[t] <= edge.d;
+                }
+            }
+        }
+        uint64_t* out = &masks_[(rank / 64) * MAX_POINTS];
+        const uint64_t bit = uint64_t(1) << (rank % 64);
+        for (int t = 0; t < count; ++t) {
+            out[t] |= (uint64_t(0) - inside_[t]) & bit;
+        }
+    }
+}
+
+bool RegionHitTable::shapeContains(const Shape& s, float x, float y) const {
+    if (s.edgeCount == 0) {
+        const float dx = std::max(std::fabs(x - s.cx) - s.hx, 0.0f);
+        const float dy = std::max(std::fabs(y - s.cy) - s.hy, 0.0f);
+        return dx * dx + dy * dy <= s.radiusSq;
+    }
+    for (uint32_t e = s.edgeBegin; e < s.edgeBegin + s.edgeCount; ++e) {
+        if (edges_[e].nx * x + edges_[e].ny * y > edges_[e].d) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool RegionHitTable::contains(int region, int x, int y) const {
+    if (region < 0 || static_cast<size_t>(region) >= rankByRegion_.size()) {
+        return false;
+    }
+    return shapeContains(shapes_[rankByRegion_[region]], static_cast<float>(x) + 0.5f, static_cast<float>(y) + 0.5f);
+}
@@ -0,0 +1,125 @@
+#ifndef REGION_HIT_TABLE_H
+#define REGION_HIT_TABLE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "input_types.h"
+
+/**
+ * 区域命中表：区域表更新时把 ClickableRegion 的形状编译成统一的测试形式，一帧内所有待测试的
+ * 触摸点先 stage，再由 run() 一次算出每个点命中的全部区域。
+ *
+ * 矩形、圆、圆角矩形都编译为"圆角矩形"：中心 c、内矩形半宽高 h、半径 r（padding 直接加到 r 上），
+ * 点 p 在内当且仅当 |max(|p - c| - h, 0)|² <= r²，无分支、无开方。凸多边形编译为各边外法向的
+ * 半平面 n·p <= d（padding 加到 d 上）。run() 对每个区域在一个无分支的循环里处理所有触摸点，
+ * 编译器可以直接向量化；结果是按优先级排序的位集，ctz 即得到优先级最高的候选区域。
+ *
+ * 坐标按像素中心 (x + 0.5, y + 0.5) 测试，padding 为 0 的矩形与原先的半开区间 [left, left + width) 一致。
+ * 本模块不依赖 Android 与 evdev。
+ */
+class RegionHitTable {
+public:
+    static constexpr int MAX_POINTS = 64;
+
+    /**
+     * @brief 按区域表重建（区域表更新时在读取线程调用）；区域下标与 regions 一致
+     */
+    void build(const std::vector<ClickableRegion>& regions);
+
+    bool empty() const { return shapes_.empty(); }
+    bool hasSlideIn() const { return slideInRight_ > slideInLeft_; }
+
+    /**
+     * @brief (x, y) 是否落在所有 slideIn 区域（含 padding）的外接矩形内，用于跳过大多数移动帧
+     */
+    bool inSlideInBounds(int x, int y) const {
+        return x >= slideInLeft_ && x < slideInRight_ && y >= slideInTop_ && y < slideInBottom_;
+    }
+
+    /**
+     * @brief 登记本帧一个待测试的点，返回它在 firstHit() 中使用的下标；超过 MAX_POINTS 时返回 -1
+     */
+    int stage(int x, int y);
+
+    /**
+     * @brief 测试所有已登记的点；结果保留到下一次 stage() 之前的 run()
+     */
+    void run();
+
+    /**
+     * @brief 第 point 个登记点命中的区域中，优先级最高且 accept(区域下标) 为真的一个
+     * @return 区域下标，-1 表示没有
+     */
+    template <typename Accept>
+    int firstHit(int point, bool slideInOnly, Accept&& accept) const {
+        for (size_t w = 0; w < words_; ++w) {
+            uint64_t bits = masks_[w * MAX_POINTS + point];
+            if (slideInOnly) {
+                bits &= slideInMask_[w];
+            }
+            while (bits != 0) {
+                const int region = shapes_[w * 64 + __builtin_ctzll(bits)].region;
+                bits &= bits - 1;
+                if (accept(region)) {
+                    return region;
+                }
+            }
+        }
+        return -1;
+    }
+
+    /**
+     * @brief 单点测试（已绑定手指的 slideOut 检查）
+     */
+    bool contains(int region, int x, int y) const;
+
+    /**
+     * @brief 顶点数不少于 3、面积非零且各顶点转向一致
+     */
+    static bool isConvexPolygon(const std::vector<RegionPoint>& points);
+
+private:
+    // 按优先级排序后的一个区域；edgeCount > 0 时为多边形，只使用 edges_[edgeBegin, edgeBegin + edgeCount)
+    struct Shape {
+        float cx = 0.0f;
+        float cy = 0.0f;
+        float hx = -1.0f;
+        float hy = -1.0f;
+        float radiusSq = 0.0f;
+        uint32_t edgeBegin = 0;
+        uint32_t edgeCount = 0;
+        int region = -1;
+    };
+    // 半平面 nx * x + ny * y <= d，(nx, ny) 为单位外法向
+    struct Edge {
+        float nx;
+        float ny;
+        float d;
+    };
+
+    void compileRoundedRect(const ClickableRegion& region, Shape& shape, int bounds[4]) const;
+    void compilePolygon(const ClickableRegion& region, Shape& shape, int bounds[4]);
+    bool shapeContains(const Shape& shape, float x, float y) const;
+
+    std::vector<Shape> shapes_;          // 按优先级从高到低
+    std::vector<Edge> edges_;
+    std::vector<int> rankByRegion_;      // 区域下标 -> shapes_ 下标
+    std::vector<uint64_t> slideInMask_;  // 按 shapes_ 下标的位集
+    size_t words_ = 0;                   // 每个点的位集字数 = ceil(shapes_.size() / 64)
+    int slideInLeft_ = 0;
+    int slideInTop_ = 0;
+    int slideInRight_ = 0;
+    int slideInBottom_ = 0;
+
+    // 本帧登记的点（像素中心）与结果：masks_[字 * MAX_POINTS + 点]
+    alignas(64) float px_[MAX_POINTS] = {};
+    alignas(64) float py_[MAX_POINTS] = {};
+    alignas(64) uint8_t inside_[MAX_POINTS] = {};
+    std::vector<uint64_t> masks_;
+    int staged_ = 0;
+    bool ran_ = false;
+};
+
+#endif // REGION_HIT_TABLE_H
@@ -0,0 +1,235 @@
+#include "ring_event_sink.h"
+
+#include <android/log.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+// 日志标签
+#define TAG "NativeInputRing"
+
+RingInputEventSink::~RingInputEventSink() {
+    if (memory_) {
+        munmap(memory_, memoryBytes_);
+        memory_ = nullptr;
+    }
+    if (eventFd_ >= 0) {
+        ::close(eventFd_);
+        eventFd_ = -1;
+    }
+}
+
+bool RingInputEventSink::create(uint32_t capacityRecords) {
+    uint32_t capacity = 1;
+    while (capacity < capacityRecords && capacity < (1u << 20)) {
+        capacity <<= 1;
+    }
+
+    eventFd_ = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (eventFd_ < 0) {
+        __android_log_print(ANDROID_LOG_ERROR, TAG, "create: eventfd 失败: %s", strerror(errno));
+        return false;
+    }
+
+    const size_t bytes = eventRingBytes(capacity);
+    void* memory = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) {
+        __android_log_print(ANDROID_LOG_ERROR, TAG, "create: mmap %zu 字节失败: %s", bytes, strerror(errno));
+        return false;
+    }
+    // 预先触碰，读取线程写入时不产生缺页
+    std::memset(memory, 0, bytes);
+    memory_ = memory;
+    memoryBytes_ = bytes;
+    producer_.init(memory_, capacity);
+
+    __android_log_print(ANDROID_LOG_INFO, TAG, "事件环已创建: %u 条 × %zu 字节",
+        capacity, sizeof(EventRingRecord));
+    return true;
+}
+
+void RingInputEventSink::close() {
+    if (!memory_) {
+        return;
+    }
+    producer_.close();
+    wakeConsumer();
+}
+
+int64_t RingInputEventSink::await(uint64_t consumedIndex, int timeoutMs) {
+    EventRingHeader* header = producer_.header();
+    if (!header) {
+        return -1;
+    }
+    if (!event_ring_consumer::releaseAndCheckEmpty(header, consumedIndex)) {
+        return static_cast<int64_t>(event_ring_consumer::available(header));
+    }
+    if (event_ring_consumer::isClosed(header)) {
+        return -1;
+    }
+
+    struct pollfd pfd;
+    pfd.fd = eventFd_;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+    if (poll(&pfd, 1, timeoutMs) > 0 && (pfd.revents & POLLIN)) {
+        uint64_t counter = 0;
+        ssize_t ret = read(eventFd_, &counter, sizeof(counter));
+        (void)ret;
+    }
+    if (event_ring_consumer::isClosed(header)) {
+        return -1;
+    }
+    return static_cast<int64_t>(event_ring_consumer::available(header));
+}
+
+void RingInputEventSink::onTouchFrame(const TouchContact* contacts, int count, long long timestampMs,
+                                      bool extended) {
+    if (count <= 0 || !memory_) {
+        return;
+    }
+    uint64_t first = 0;
+    if (!producer_.reserve(static_cast<uint32_t>(count), first)) {
+        return; // 整帧丢弃，已计入 overflowCount
+    }
+    for (int i = 0; i < count; ++i) {
+        EventRingRecord& record = producer_.at(first + i);
+        record.kind = EVENT_RING_RECORD_TOUCH_CONTACT;
+        record.flags = (i == count - 1) ? EVENT_RING_FLAG_FRAME_END : 0;
+        record.nameLength = 0;
+        record.id = contacts[i].id;
+        record.x = contacts[i].x;
+        record.y = contacts[i].y;
+        record.timestampMs = timestampMs;
+        if (extended) {
+            record.flags |= EVENT_RING_FLAG_EXTENDED;
+            record.touch.pressure = contacts[i].pressure;
+            record.touch.touchMajor = contacts[i].touchMajor;
+        }
+    }
+}
+
+void RingInputEventSink::onUiEvent(UiEventKind kind, const ClickableRegion& region,
+                                   int x, int y, long long downTimestampMs) {
+    if (!memory_) {
+        return;
+    }
+    uint64_t index = 0;
+    if (!producer_.reserve(1, index)) {
+        return;
+    }
+    EventRingRecord& record = producer_.at(index);
+    switch (kind) {
+        case UiEventKind::Tap: record.kind = EVENT_RING_RECORD_UI_TAP; break;
+        case UiEventKind::PressDown: record.kind = EVENT_RING_RECORD_UI_PRESS_DOWN; break;
+        case UiEventKind::LongPressEnd: record.kind = EVENT_RING_RECORD_UI_LONG_PRESS_END; break;
+    }
+    record.flags = 0;
+    const size_t nameLength = region.identifier.size() < EVENT_RING_NAME_BYTES
+        ? region.identifier.size() : EVENT_RING_NAME_BYTES;
+    if (nameLength < region.identifier.size()) {
+        __android_log_print(ANDROID_LOG_WARN, TAG, "区域标识过长，截断为 %zu 字节: %s",
+            nameLength, region.identifier.c_str());
+    }
+    record.nameLength = static_cast<uint16_t>(nameLength);
+    record.id = -1;
+    record.x = x;
+    record.y = y;
+    record.timestampMs = downTimestampMs;
+    std::memcpy(record.name, region.identifier.data(), nameLength);
+}
+
+void RingInputEventSink::onGesture(const ClickableRegion& region, const GestureEvent& gesture) {
+    if (!memory_) {
+        return;
+    }
+    uint64_t index = 0;
+    if (!producer_.reserve(1, index)) {
+        return;
+    }
+    EventRingRecord& record = producer_.at(index);
+    record.kind = EVENT_RING_RECORD_UI_GESTURE;
+    record.flags = static_cast<uint8_t>(gesture.kind);
+    const size_t nameLength = region.identifier.size() < EVENT_RING_GESTURE_NAME_BYTES
+        ? region.identifier.size() : EVENT_RING_GESTURE_NAME_BYTES;
+    record.nameLength = static_cast<uint16_t>(nameLength);
+    record.id = gesture.fingers | (static_cast<int32_t>(gesture.direction) << 8);
+    record.x = gesture.x;
+    record.y = gesture.y;
+    record.timestampMs = gesture.timestampMs;
+    std::memcpy(record.gesture.name, region.identifier.data(), nameLength);
+    record.gesture.dx = gesture.dx;
+    record.gesture.dy = gesture.dy;
+}
+
+void RingInputEventSink::onPenSample(const PenSample& sample) {
+    if (!memory_) {
+        return;
+    }
+    uint64_t index = 0;
+    if (!producer_.reserve(1, index)) {
+        return;
+    }
+    EventRingRecord& record = producer_.at(index);
+    record.kind = EVENT_RING_RECORD_PEN;
+    record.flags = sample.flags;
+    record.nameLength = 0;
+    record.id = 0;
+    record.x = sample.x;
+    record.y = sample.y;
+    record.timestampMs = sample.timestampUs / 1000;
+    record.pen.pressure = sample.pressure;
+    record.pen.distance = sample.distance;
+    record.pen.tiltX = sample.tiltX;
+    record.pen.tiltY = sample.tiltY;
+    record.pen.timestampUs = sample.timestampUs;
+}
+
+void RingInputEventSink::onHidFrame(const HidFrame& frame) {
+    if (!memory_) {
+        return;
+    }
+    // 没有变化的帧（设备接入 / 移除）也占一条记录
+    const uint32_t records = frame.count > 0
+        ? static_cast<uint32_t>((frame.count + EVENT_RING_HID_CHANGES - 1) / EVENT_RING_HID_CHANGES) : 1;
+    uint64_t first = 0;
+    if (!producer_.reserve(records, first)) {
+        return; // 整帧丢弃，已计入 overflowCount
+    }
+    int next = 0;
+    for (uint32_t i = 0; i < records; ++i) {
+        EventRingRecord& record = producer_.at(first + i);
+        const int changes = std::min<int>(EVENT_RING_HID_CHANGES, frame.count - next);
+        record.kind = EVENT_RING_RECORD_HID;
+        record.flags = (i == records - 1) ? EVENT_RING_FLAG_FRAME_END : 0;
+        record.nameLength = static_cast<uint16_t>(changes);
+        record.id = frame.deviceId | (frame.deviceClass << 8) | (frame.flags << 16);
+        record.x = 0;
+        record.y = 0;
+        record.timestampMs = frame.timestampUs / 1000;
+        record.hid.timestampUs = frame.timestampUs;
+        for (int c = 0; c < changes; ++c, ++next) {
+            EventRingHidChange& change = record.hid.changes[c];
+            change.type = frame.changes[next].type;
+            change.reserved = 0;
+            change.code = frame.changes[next].code;
+            change.value = frame.changes[next].value;
+        }
+    }
+}
+
+void RingInputEventSink::flush() {
+    if (memory_ && producer_.publish()) {
+        wakeConsumer();
+    }
+}
+
+void RingInputEventSink::wakeConsumer() {
+    const uint64_t one = 1;
+    ssize_t ret = write(eventFd_, &one, sizeof(one));
+    (void)ret;
+}
@@ -0,0 +1,64 @@
+#ifndef RING_EVENT_SINK_H
+#define RING_EVENT_SINK_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "input_engine.h"
+#include "../common/event_ring.h"
+
+/**
+ * @brief 把引擎输出写入共享内存事件环的输出
+ *
+ * 读取线程只做 memcpy 与一次索引发布，环由空变非空时写 eventfd 唤醒消费者，
+ * 不再向 Java 发起任何上行调用。Java 侧通过 direct ByteBuffer 读取记录，
+ * 并用 await() 发布读索引、在环空时阻塞等待。
+ */
+class RingInputEventSink : public InputEventSink {
+public:
+    RingInputEventSink() = default;
+    ~RingInputEventSink() override;
+
+    RingInputEventSink(const RingInputEventSink&) = delete;
+    RingInputEventSink& operator=(const RingInputEventSink&) = delete;
+
+    /**
+     * @brief 分配环内存与 eventfd
+     * @param capacityRecords 向上取整为 2 的幂
+     */
+    bool create(uint32_t capacityRecords);
+
+    /**
+     * @brief 标记关闭并唤醒消费者，await() 之后返回 -1
+     */
+    void close();
+
+    /**
+     * @brief 消费者：发布已消费到 consumedIndex，环空时最多等待 timeoutMs
+     * @return 当前 writeIndex；环已关闭时返回 -1
+     */
+    int64_t await(uint64_t consumedIndex, int timeoutMs);
+
+    void* memory() const { return memory_; }
+    size_t memoryBytes() const { return memoryBytes_; }
+    const EventRingHeader* header() const { return producer_.header(); }
+
+    void onTouchFrame(const TouchContact* contacts, int count, long long timestampMs,
+                      bool extended) override;
+    void onUiEvent(UiEventKind kind, const ClickableRegion& region,
+                   int x, int y, long long downTimestampMs) override;
+    void onGesture(const ClickableRegion& region, const GestureEvent& gesture) override;
+    void onPenSample(const PenSample& sample) override;
+    void onHidFrame(const HidFrame& frame) override;
+    void flush() override;
+
+private:
+    void wakeConsumer();
+
+    void* memory_ = nullptr;
+    size_t memoryBytes_ = 0;
+    int eventFd_ = -1;
+    EventRingProducer producer_;
+};
+
+#endif // RING_EVENT_SINK_H
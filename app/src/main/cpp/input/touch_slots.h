@@ -0,0 +1,82 @@
+#ifndef TOUCH_SLOTS_H
+#define TOUCH_SLOTS_H
+
+#include <cstdint>
+
+/**
+ * 触摸 slot 状态，按结构体数组 (SoA) 存放。
+ *
+ * 每帧都会读的字段（id、坐标、区域下标）各自连续存放；布尔状态收进 64 位位集，
+ * 一次与 / 或运算即可挑出"本帧有变化且仍按下"等集合，再用 ctz 逐个访问，
+ * 不再每帧遍历所有 slot。slot 数由设备的 ABS_MT_SLOT 范围决定，不超过 TOUCH_SLOT_LIMIT。
+ */
+
+static constexpr int TOUCH_SLOT_LIMIT = 64;     // 位集宽度
+
+using SlotMask = uint64_t;
+
+inline SlotMask slotBit(int slot) {
+    return SlotMask(1) << slot;
+}
+
+/**
+ * @brief 依次访问 mask 中每个置位的 slot
+ */
+template <typename Fn>
+inline void forEachSlot(SlotMask mask, Fn&& fn) {
+    while (mask != 0) {
+        const int slot = __builtin_ctzll(mask);
+        mask &= mask - 1;
+        fn(slot);
+    }
+}
+
+struct TouchSlots {
+    int capacity = TOUCH_SLOT_LIMIT;   // 设备 ABS_MT_SLOT 最大值 + 1；无法查询时取上限
+
+    // ---- 热数据：每帧输出时读取 ----
+    int32_t id[TOUCH_SLOT_LIMIT];            // tracking ID，-1 表示抬起
+    int32_t x[TOUCH_SLOT_LIMIT];             // 面板原生坐标
+    int32_t y[TOUCH_SLOT_LIMIT];
+    int32_t screenX[TOUCH_SLOT_LIMIT];       // 最近一次换算的悬浮窗坐标
+    int32_t screenY[TOUCH_SLOT_LIMIT];
+    int16_t regionIndex[TOUCH_SLOT_LIMIT];   // 绑定区域在当前区域表中的下标，-1 表示未绑定或区域已移除
+    int32_t regionId[TOUCH_SLOT_LIMIT];      // 绑定区域的整数 ID (ClickableRegion::id)，-1 表示未绑定
+
+    // ---- 冷数据：区域与过滤逻辑 ----
+    long long downTimestampMs[TOUCH_SLOT_LIMIT]; // 按下（或滑入）时间
+    int32_t downX[TOUCH_SLOT_LIMIT];
+    int32_t downY[TOUCH_SLOT_LIMIT];
+    int32_t touchMajor[TOUCH_SLOT_LIMIT];    // ABS_MT_TOUCH_MAJOR / MINOR / PRESSURE / TOOL_TYPE 原始值
+    int32_t touchMinor[TOUCH_SLOT_LIMIT];    // (协议 B 中未变化的值不会重发，手指更替时保留)
+    int32_t pressure[TOUCH_SLOT_LIMIT];
+    int32_t toolType[TOUCH_SLOT_LIMIT];
+
+    // ---- 位集 ----
+    SlotMask active = 0;            // 手指按下
+    SlotMask dirty = 0;             // 自上一个 SYN_REPORT 以来收到过事件
+    SlotMask moved = 0;             // 自上一个 SYN_REPORT 以来坐标有变化
+    SlotMask hitTested = 0;         // 按下后的第一帧已做过命中测试
+    SlotMask rejected = 0;          // 被触摸质量过滤拒绝，直到抬起
+    SlotMask bound = 0;             // 绑定到区域
+    SlotMask longPressPending = 0;  // 已绑定、等待长按开始延迟
+    SlotMask longPressSent = 0;     // 已发送按下 (0x08) 事件
+
+    TouchSlots() { reset(); }
+
+    void reset() {
+        for (int i = 0; i < TOUCH_SLOT_LIMIT; ++i) {
+            id[i] = -1;
+            x[i] = y[i] = 0;
+            screenX[i] = screenY[i] = 0;
+            regionIndex[i] = -1;
+            regionId[i] = -1;
+            downTimestampMs[i] = 0;
+            downX[i] = downY[i] = 0;
+            touchMajor[i] = touchMinor[i] = pressure[i] = toolType[i] = 0;
+        }
+        active = dirty = moved = hitTested = rejected = bound = longPressPending = longPressSent = 0;
+    }
+};
+
+#endif // TOUCH_SLOTS_H
@@ -0,0 +1,104 @@
+#include "touch_smoothing.h"
+
+#include <cmath>
+
+namespace {
+
+constexpr float kTwoPi = 6.28318530718f;
+
+// 两帧时间戳相同（或倒退）时使用的最小步长，避免除零
+constexpr float kMinDtSeconds = 1e-4f;
+
+/**
+ * @brief 一阶低通的平滑系数：alpha = 1 / (1 + tau / dt)，tau = 1 / (2π fc)
+ */
+inline float smoothingAlpha(float cutoffHz, float dt) {
+    const float r = kTwoPi * cutoffHz * dt;
+    return r / (r + 1.0f);
+}
+
+} // namespace
+
+void OneEuroFilterBank::reset(int slot) {
+    if (slot < 0 || slot >= MAX_SLOTS) {
+        return;
+    }
+    initialized_[slot] = 0.0f;
+    dxPrev_[slot] = 0.0f;
+    dyPrev_[slot] = 0.0f;
+    lastTimestampUs_[slot] = 0;
+}
+
+void OneEuroFilterBank::resetAll() {
+    for (int i = 0; i < MAX_SLOTS; ++i) {
+        reset(i);
+        staged_[i] = 0.0f;
+    }
+    stagedEnd_ = 0;
+}
+
+void OneEuroFilterBank::stage(int slot, float x, float y, const OneEuroParams& params) {
+    if (slot < 0 || slot >= MAX_SLOTS) {
+        return;
+    }
+    inX_[slot] = x;
+    inY_[slot] = y;
+    minCutoff_[slot] = params.minCutoffHz;
+    beta_[slot] = params.beta;
+    dCutoff_[slot] = params.derivativeCutoffHz;
+    staged_[slot] = 1.0f;
+    if (slot >= stagedEnd_) {
+        stagedEnd_ = slot + 1;
+    }
+}
+
+void OneEuroFilterBank::run(int64_t timestampUs) {
+    const int count = stagedEnd_;
+    if (count == 0) {
+        return;
+    }
+
+    // 每个 slot 的步长；未登记或未初始化的 slot 取 1 秒，结果随后被掩码丢弃
+    alignas(64) float dt[MAX_SLOTS];
+    for (int i = 0; i < count; ++i) {
+        const bool valid = staged_[i] != 0.0f && initialized_[i] != 0.0f;
+        const float seconds = static_cast<float>(timestampUs - lastTimestampUs_[i]) * 1e-6f;
+        dt[i] = valid ? (seconds > kMinDtSeconds ? seconds : kMinDtSeconds) : 1.0f;
+    }
+
+    // 无分支主循环：staged_ / initialized_ 为 0/1 掩码，用乘法混合代替条件
+    for (int i = 0; i < count; ++i) {
+        const float staged = staged_[i];
+        const float initialized = initialized_[i];
+        const float step = dt[i];
+        const float rate = 1.0f / step;
+
+        const float dx = (inX_[i] - outX_[i]) * rate;
+        const float dy = (inY_[i] - outY_[i]) * rate;
+        const float aD = smoothingAlpha(dCutoff_[i], step);
+        const float edx = (dxPrev_[i] + aD * (dx - dxPrev_[i])) * initialized;
+        const float edy = (dyPrev_[i] + aD * (dy - dyPrev_[i])) * initialized;
+
+        const float ax = smoothingAlpha(minCutoff_[i] + beta_[i] * std::fabs(edx), step);
+        const float ay = smoothingAlpha(minCutoff_[i] + beta_[i] * std::fabs(edy), step);
+        float fx = outX_[i] + ax * (inX_[i] - outX_[i]);
+        float fy = outY_[i] + ay * (inY_[i] - outY_[i]);
+        // 第一帧原样输出
+        fx = inX_[i] + initialized * (fx - inX_[i]);
+        fy = inY_[i] + initialized * (fy - inY_[i]);
+
+        outX_[i] += staged * (fx - outX_[i]);
+        outY_[i] += staged * (fy - outY_[i]);
+        dxPrev_[i] += staged * (edx - dxPrev_[i]);
+        dyPrev_[i] += staged * (edy - dyPrev_[i]);
+        initialized_[i] = initialized > staged ? initialized : staged;
+    }
+
+    for (int i = 0; i < count; ++i) {
+        if (staged_[i] != 0.0f) {
+            lastTimestampUs_[i] = timestampUs;
+            staged_[i] = 0.0f;
+        }
+    }
+    stagedEnd_ = 0;
+}
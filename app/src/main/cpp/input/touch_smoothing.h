@@ -0,0 +1,67 @@
+#ifndef TOUCH_SMOOTHING_H
+#define TOUCH_SMOOTHING_H
+
+#include <cstdint>
+
+/**
+ * 触摸坐标抖动过滤（One Euro 滤波器）。
+ *
+ * 每个 slot 一个自适应低通：截止频率随估计速度升高（minCutoffHz + beta × |速度|），
+ * 静止时强力去抖，快速移动时几乎不增加延迟。时间步长取自内核事件时间戳。
+ *
+ * 状态按结构体数组 (SoA) 存放，一帧内所有待过滤的 slot 先 stage，再由 run() 在一个
+ * 无分支的循环里统一处理，编译器可以直接向量化。手指按下时 reset()，第一帧原样输出。
+ *
+ * 本模块不依赖 Android 与 evdev，离线工具 touch_smoothing_harness 用同一份实现。
+ */
+
+/**
+ * @brief 滤波参数（坐标单位 / 秒）
+ */
+struct OneEuroParams {
+    float minCutoffHz = 1.0f;        // 静止时的截止频率：越低越稳，越高越跟手
+    float beta = 0.007f;             // 速度系数：越大移动时延迟越小
+    float derivativeCutoffHz = 1.0f; // 速度估计本身的截止频率
+};
+
+class OneEuroFilterBank {
+public:
+    static constexpr int MAX_SLOTS = 64;
+
+    /**
+     * @brief 清空一个 slot 的状态（手指按下）；下一次 run() 原样输出该 slot 的坐标
+     */
+    void reset(int slot);
+    void resetAll();
+
+    /**
+     * @brief 登记本帧一个 slot 的原始坐标与参数
+     */
+    void stage(int slot, float x, float y, const OneEuroParams& params);
+
+    /**
+     * @brief 以 timestampUs 为本帧时间，过滤所有已登记的 slot，并清空登记
+     */
+    void run(int64_t timestampUs);
+
+    float x(int slot) const { return outX_[slot]; }
+    float y(int slot) const { return outY_[slot]; }
+
+private:
+    // 每个数组按 slot 下标存放；staged_ 为本帧是否参与计算 (0/1)
+    alignas(64) float inX_[MAX_SLOTS] = {};
+    alignas(64) float inY_[MAX_SLOTS] = {};
+    alignas(64) float outX_[MAX_SLOTS] = {};
+    alignas(64) float outY_[MAX_SLOTS] = {};
+    alignas(64) float dxPrev_[MAX_SLOTS] = {};
+    alignas(64) float dyPrev_[MAX_SLOTS] = {};
+    alignas(64) float minCutoff_[MAX_SLOTS] = {};
+    alignas(64) float beta_[MAX_SLOTS] = {};
+    alignas(64) float dCutoff_[MAX_SLOTS] = {};
+    alignas(64) float initialized_[MAX_SLOTS] = {};
+    alignas(64) float staged_[MAX_SLOTS] = {};
+    int64_t lastTimestampUs_[MAX_SLOTS] = {};
+    int stagedEnd_ = 0;   // 本帧登记的最大 slot + 1，run() 只处理 [0, stagedEnd_)
+};
+
+#endif // TOUCH_SMOOTHING_H
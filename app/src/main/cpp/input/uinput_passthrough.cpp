@@ -0,0 +1,206 @@
+#include "uinput_passthrough.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <linux/uinput.h>
+#include <sys/ioctl.h>
+
+namespace {
+
+// 转发的 ABS_MT_* 轴，顺序与 lastValues_ 的第一维一致
+constexpr int kAxisCodes[] = {
+    ABS_MT_POSITION_X,
+    ABS_MT_POSITION_Y,
+    ABS_MT_TOUCH_MAJOR,
+    ABS_MT_TOUCH_MINOR,
+    ABS_MT_PRESSURE,
+    ABS_MT_TOOL_TYPE,
+};
+
+const int32_t* slotAxisValues(const TouchSlots& slots, size_t axis) {
+    switch (axis) {
+        case 0: return slots.x;
+        case 1: return slots.y;
+        case 2: return slots.touchMajor;
+        case 3: return slots.touchMinor;
+        case 4: return slots.pressure;
+        default: return slots.toolType;
+    }
+}
+
+bool setupAbs(int fd, int code, const struct input_absinfo& info) {
+    struct uinput_abs_setup setup;
+    std::memset(&setup, 0, sizeof(setup));
+    setup.code = static_cast<__u16>(code);
+    setup.absinfo = info;
+    return ioctl(fd, UI_SET_ABSBIT, code) == 0 && ioctl(fd, UI_ABS_SETUP, &setup) == 0;
+}
+
+} // namespace
+
+UinputPassthrough::~UinputPassthrough() {
+    close();
+}
+
+bool UinputPassthrough::open(int sourceFd, int slotCount, int uinputFd) {
+    static_assert(sizeof(kAxisCodes) / sizeof(kAxisCodes[0]) == AXIS_COUNT, "轴表长度不一致");
+    close();
+
+    const int fd = uinputFd >= 0 ? uinputFd : ::open("/dev/uinput", O_WRONLY | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    auto fail = [fd]() {
+        const int savedErrno = errno;
+        ::close(fd);
+        errno = savedErrno;
+        return false;
+    };
+
+    if (ioctl(fd, UI_SET_EVBIT, EV_SYN) != 0 || ioctl(fd, UI_SET_EVBIT, EV_KEY) != 0
+        || ioctl(fd, UI_SET_EVBIT, EV_ABS) != 0 || ioctl(fd, UI_SET_KEYBIT, BTN_TOUCH) != 0) {
+        return fail();
+    }
+
+    // 输入属性（INPUT_PROP_DIRECT 等）决定系统把它当作触摸屏还是触摸板
+    unsigned char props[(INPUT_PROP_CNT + 7) / 8] = {};
+    if (ioctl(sourceFd, EVIOCGPROP(sizeof(props)), props) >= 0) {
+        for (int prop = 0; prop < INPUT_PROP_CNT; ++prop) {
+            if (props[prop / 8] & (1u << (prop % 8))) {
+                ioctl(fd, UI_SET_PROPBIT, prop);
+            }
+        }
+    } else {
+        ioctl(fd, UI_SET_PROPBIT, INPUT_PROP_DIRECT);
+    }
+
+    struct input_absinfo info;
+    std::memset(&info, 0, sizeof(info));
+    info.maximum = slotCount - 1;
+    if (!setupAbs(fd, ABS_MT_SLOT, info)) {
+        return fail();
+    }
+    info.maximum = 0xFFFF;
+    if (!setupAbs(fd, ABS_MT_TRACKING_ID, info)) {
+        return fail();
+    }
+    for (size_t axis = 0; axis < AXIS_COUNT; ++axis) {
+        axisPresent_[axis] = ioctl(sourceFd, EVIOCGABS(kAxisCodes[axis]), &info) == 0;
+        if (axisPresent_[axis] && !setupAbs(fd, kAxisCodes[axis], info)) {
+            return fail();
+        }
+    }
+    if (!axisPresent_[0] || !axisPresent_[1]) {
+        errno = EINVAL;
+        return fail();
+    }
+
+    // 名称加后缀，厂商 / 产品 ID 与源设备相同，系统按同一份 IDC 配置识别
+    struct uinput_setup setup;
+    std::memset(&setup, 0, sizeof(setup));
+    char sourceName[UINPUT_MAX_NAME_SIZE] = {};
+    if (ioctl(sourceFd, EVIOCGNAME(sizeof(sourceName) - 1), sourceName) < 0) {
+        std::strcpy(sourceName, "touchscreen");
+    }
+    std::snprintf(setup.name, sizeof(setup.name), "%.60s passthrough", sourceName);
+    if (ioctl(sourceFd, EVIOCGID, &setup.id) != 0) {
+        setup.id.bustype = BUS_VIRTUAL;
+    }
+    if (ioctl(fd, UI_DEV_SETUP, &setup) != 0 || ioctl(fd, UI_DEV_CREATE) != 0) {
+        return fail();
+    }
+
+    char sysName[64] = {};
+    if (ioctl(fd, UI_GET_SYSNAME(sizeof(sysName)), sysName) >= 0) {
+        sysName_ = sysName;
+    }
+
+    uinputFd_ = fd;
+    slotCount_ = slotCount;
+    down_ = 0;
+    lastSlot_ = -1;
+    std::memset(lastValues_, 0, sizeof(lastValues_));
+    return true;
+}
+
+void UinputPassthrough::close() {
+    if (uinputFd_ < 0) {
+        return;
+    }
+    if (down_ != 0) {
+        TouchSlots empty;
+        writeFrame(empty, 0);
+    }
+    ioctl(uinputFd_, UI_DEV_DESTROY);
+    ::close(uinputFd_);
+    uinputFd_ = -1;
+    sysName_.clear();
+    down_ = 0;
+}
+
+int UinputPassthrough::writeFrame(const TouchSlots& slots, SlotMask passMask) {
+    if (uinputFd_ < 0) {
+        return 0;
+    }
+    passMask &= slotCount_ >= TOUCH_SLOT_LIMIT ? ~SlotMask(0) : slotBit(slotCount_) - 1;
+
+    size_t count = 0;
+    auto emit = [&](int type, int code, int value) {
+        struct input_event& ev = frame_[count++];
+        ev.time.tv_sec = 0;
+        ev.time.tv_usec = 0;
+        ev.type = static_cast<__u16>(type);
+        ev.code = static_cast<__u16>(code);
+        ev.value = value;
+    };
+    auto selectSlot = [&](int slot) {
+        if (slot != lastSlot_) {
+            emit(EV_ABS, ABS_MT_SLOT, slot);
+            lastSlot_ = slot;
+        }
+    };
+
+    // 离开转发集合的手指：抬起
+    forEachSlot(down_ & ~passMask, [&](int slot) {
+        selectSlot(slot);
+        emit(EV_ABS, ABS_MT_TRACKING_ID, -1);
+    });
+    // 新进入的手指先分配 tracking ID，然后所有转发中的手指只写有变化的轴
+    forEachSlot(passMask, [&](int slot) {
+        const bool landing = !(down_ & slotBit(slot));
+        if (landing) {
+            selectSlot(slot);
+            emit(EV_ABS, ABS_MT_TRACKING_ID, nextTrackingId_);
+            nextTrackingId_ = (nextTrackingId_ % 0xFFFF) + 1;
+        }
+        for (size_t axis = 0; axis < AXIS_COUNT; ++axis) {
+            if (!axisPresent_[axis]) {
+                continue;
+            }
+            const int32_t value = slotAxisValues(slots, axis)[slot];
+            if (landing || value != lastValues_[axis][slot]) {
+                selectSlot(slot);
+                emit(EV_ABS, kAxisCodes[axis], value);
+                lastValues_[axis][slot] = value;
+            }
+        }
+    });
+    if ((down_ != 0) != (passMask != 0)) {
+        emit(EV_KEY, BTN_TOUCH, passMask != 0 ? 1 : 0);
+    }
+    down_ = passMask;
+    if (count == 0) {
+        return 0;
+    }
+    emit(EV_SYN, SYN_REPORT, 0);
+
+    const size_t bytes = count * sizeof(struct input_event);
+    ssize_t written;
+    do {
+        written = write(uinputFd_, frame_, bytes);
+    } while (written < 0 && errno == EINTR);
+    return written == static_cast<ssize_t>(bytes) ? static_cast<int>(count) : -1;
+}
@@ -0,0 +1,76 @@
+#ifndef UINPUT_PASSTHROUGH_H
+#define UINPUT_PASSTHROUGH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <linux/input.h>
+
+#include "touch_slots.h"
+
+/**
+ * 独占模式下的触摸转发。
+ *
+ * 读取线程用 EVIOCGRAB 独占真实触摸屏后，系统 (InputFlinger) 不再收到任何触摸。
+ * 本模块在 /dev/uinput 上创建一块轴范围、属性、厂商 ID 都与源设备相同的虚拟多点触摸屏，
+ * 只把未被悬浮窗区域消费的手指按 MT 协议 B 重新注入，坐标保持面板原生值。
+ *
+ * 虚拟设备上的 slot 号与源设备一致；手指在转发集合中进出（如滑入 / 滑出区域）时
+ * 分配新的 tracking ID，对系统而言就是一次新的按下 / 抬起。每帧的全部事件用一次 write() 写出。
+ *
+ * 本模块不依赖 Android，Linux 主机上的 uinput_passthrough_test 使用同一份实现。
+ */
+
+class UinputPassthrough {
+public:
+    UinputPassthrough() = default;
+    ~UinputPassthrough();
+
+    UinputPassthrough(const UinputPassthrough&) = delete;
+    UinputPassthrough& operator=(const UinputPassthrough&) = delete;
+
+    /**
+     * @brief 按源设备 sourceFd 的 ABS_MT_* 轴与属性创建虚拟触摸屏
+     * @param slotCount 转发的 slot 数（源设备 ABS_MT_SLOT 最大值 + 1）
+     * @param uinputFd 已打开的 /dev/uinput（如特权辅助进程传回的 fd，所有权转移）；-1 时自行打开
+     * @return 失败时返回 false，errno 保留失败原因
+     */
+    bool open(int sourceFd, int slotCount, int uinputFd = -1);
+
+    /**
+     * @brief 抬起所有转发中的手指并销毁虚拟设备
+     */
+    void close();
+
+    bool isOpen() const { return uinputFd_ >= 0; }
+
+    /**
+     * @brief 把 passMask 中的 slot 同步到虚拟设备，不在其中但仍按下的 slot 补发抬起
+     * @return 本帧写出的事件数（0 表示无变化，未写出），写失败时返回 -1
+     */
+    int writeFrame(const TouchSlots& slots, SlotMask passMask);
+
+    /**
+     * @brief 虚拟设备在 sysfs 中的名称（如 "input12"），用于定位对应的 /dev/input/eventN
+     */
+    const std::string& sysName() const { return sysName_; }
+
+private:
+    static constexpr size_t AXIS_COUNT = 6; // X, Y, TOUCH_MAJOR, TOUCH_MINOR, PRESSURE, TOOL_TYPE
+    static constexpr size_t MAX_FRAME_EVENTS = TOUCH_SLOT_LIMIT * (2 + AXIS_COUNT) + 2;
+
+    int uinputFd_ = -1;
+    int slotCount_ = 0;
+    bool axisPresent_[AXIS_COUNT] = {};
+    std::string sysName_;
+
+    // 虚拟设备上每个 slot 最近写出的状态
+    SlotMask down_ = 0;
+    int lastSlot_ = -1;
+    int32_t nextTrackingId_ = 1;
+    int32_t lastValues_[AXIS_COUNT][TOUCH_SLOT_LIMIT] = {};
+
+    struct input_event frame_[MAX_FRAME_EVENTS]; // 一帧的写缓冲区
+};
+
+#endif // UINPUT_PASSTHROUGH_H
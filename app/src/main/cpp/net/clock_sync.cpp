@@ -0,0 +1,143 @@
+#include "clock_sync.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+ClockSync::ClockSync()
+    : estimate_(std::make_shared<const ClockEstimate>()) {
+    window_.reserve(WINDOW);
+}
+
+bool ClockSync::addSample(int64_t t1, int64_t t2, int64_t t3, int64_t t4) {
+    const int64_t delayNs = (t4 - t1) - (t3 - t2);
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++total_;
+    if (t4 < t1 || t3 < t2 || delayNs < 0) {
+        ++invalid_;
+        return false;
+    }
+    const Sample sample{t1 + (t4 - t1) / 2, ((t2 - t1) + (t3 - t4)) / 2, delayNs};
+    if (window_.size() < WINDOW) {
+        window_.push_back(sample);
+    } else {
+        window_[next_] = sample;
+        next_ = (next_ + 1) % WINDOW;
+    }
+    std::atomic_store(&estimate_, fitLocked());
+    return true;
+}
+
+std::shared_ptr<const ClockEstimate> ClockSync::fitLocked() {
+    auto result = std::make_shared<ClockEstimate>();
+    result->samples = static_cast<uint32_t>(window_.size());
+
+    const Sample* best = &window_[0];
+    for (const Sample& s : window_) {
+        if (s.delayNs < best->delayNs) best = &s;
+    }
+    const int64_t minDelayNs = best->delayNs;
+    const int64_t thresholdNs = minDelayNs + std::max(minDelayNs, DELAY_SLACK_NS);
+
+    // 被接受样本：x 相对最新的被接受样本中点（纳秒），y 为偏移
+    int64_t referenceNs = INT64_MIN;
+    for (const Sample& s : window_) {
+        if (s.delayNs <= thresholdNs) referenceNs = std::max(referenceNs, s.midNs);
+    }
+    double sumX = 0, sumY = 0;
+    int64_t firstNs = referenceNs;
+    uint32_t accepted = 0;
+    for (const Sample& s : window_) {
+        if (s.delayNs > thresholdNs) continue;
+        sumX += static_cast<double>(s.midNs - referenceNs);
+        sumY += static_cast<double>(s.offsetNs);
+        firstNs = std::min(firstNs, s.midNs);
+        ++accepted;
+    }
+    const double meanX = sumX / accepted;
+    const double meanY = sumY / accepted;
+
+    // 跨度太短时斜率不可信，沿用上一次的漂移及其不确定度
+    double drift = lastDrift_;
+    double driftUncertainty = lastDriftUncertainty_;
+    static constexpr int64_t MIN_DRIFT_SPAN_NS = 50000000; // 50 ms
+    if (accepted >= 3 && referenceNs - firstNs >= MIN_DRIFT_SPAN_NS) {
+        double sxx = 0, sxy = 0;
+        for (const Sample& s : window_) {
+            if (s.delayNs > thresholdNs) continue;
+            const double dx = static_cast<double>(s.midNs - referenceNs) - meanX;
+            sxx += dx * dx;
+            sxy += dx * (static_cast<double>(s.offsetNs) - meanY);
+        }
+        if (sxx > 0) {
+            const double slope = sxy / sxx;
+            // 斜率的标准误差（残差即排队噪声），取 3 倍作为漂移不确定度
+            double residual = 0;
+            for (const Sample& s : window_) {
+                if (s.delayNs > thresholdNs) continue;
+                const double dx = static_cast<double>(s.midNs - referenceNs) - meanX;
+                const double r = static_cast<double>(s.offsetNs) - meanY - slope * dx;
+                residual += r * r;
+            }
+            drift = std::max(-MAX_DRIFT, std::min(MAX_DRIFT, slope));
+            driftUncertainty = std::min(MAX_DRIFT, 3.0 * std::sqrt(residual / (accepted - 2) / sxx));
+        }
+    }
+    lastDrift_ = drift;
+    lastDriftUncertainty_ = driftUncertainty;
+
+    // 每个样本说明参考时刻的真实偏移落在 [θ' - δ/2 - e, θ' + δ/2 + e]（θ' 为按漂移换算到参考时刻的偏移，
+    // e 为漂移不确定度在该样本到参考时刻跨度上的累积），取所有被接受样本区间的交集；
+    // 交集为空（接收端时间戳异常）时退回最小时延样本
+    double low = -1e300, high = 1e300;
+    for (const Sample& s : window_) {
+        if (s.delayNs > thresholdNs) continue;
+        const double span = static_cast<double>(s.midNs - referenceNs);
+        const double shifted = static_cast<double>(s.offsetNs) - drift * span;
+        const double halfWidth = s.delayNs / 2.0 + driftUncertainty * std::fabs(span);
+        low = std::max(low, shifted - halfWidth);
+        high = std::min(high, shifted + halfWidth);
+    }
+    double offsetAtReference;
+    double bound;
+    if (low <= high) {
+        offsetAtReference = (low + high) / 2;
+        bound = (high - low) / 2;
+    } else {
+        const double span = static_cast<double>(best->midNs - referenceNs);
+        offsetAtReference = static_cast<double>(best->offsetNs) - drift * span;
+        bound = best->delayNs / 2.0 + driftUncertainty * std::fabs(span) + (low - high);
+    }
+
+    result->valid = true;
+    result->referenceNs = referenceNs;
+    result->offsetNs = static_cast<int64_t>(std::llround(offsetAtReference));
+    result->drift = drift;
+    result->errorBoundNs = static_cast<int64_t>(std::ceil(bound));
+    result->minDelayNs = minDelayNs;
+    result->accepted = accepted;
+    return result;
+}
+
+std::shared_ptr<const ClockEstimate> ClockSync::estimate() const {
+    return std::atomic_load(&estimate_);
+}
+
+void ClockSync::reset() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    window_.clear();
+    next_ = 0;
+    lastDrift_ = 0.0;
+    lastDriftUncertainty_ = MAX_DRIFT;
+    std::atomic_store(&estimate_, std::make_shared<const ClockEstimate>());
+}
+
+uint64_t ClockSync::totalSamples() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return total_;
+}
+
+uint64_t ClockSync::invalidSamples() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return invalid_;
+}
@@ -0,0 +1,88 @@
+#ifndef CLOCK_SYNC_H
+#define CLOCK_SYNC_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/**
+ * @brief 本机 CLOCK_MONOTONIC 到接收端时钟的映射估计
+ *
+ * receiver(t) = t + offsetNs + drift * (t - referenceNs)
+ */
+struct ClockEstimate {
+    bool valid = false;
+    int64_t referenceNs = 0;   // 拟合的参考时刻（本机时间，最近一个被接受样本的中点）
+    int64_t offsetNs = 0;      // 参考时刻的 接收端 - 本机 偏移
+    double drift = 0.0;        // 偏移随本机时间的变化率（80e-6 即 80 ppm）
+    int64_t errorBoundNs = 0;  // 参考时刻偏移的误差上界（各样本可行区间交集的半宽）
+    int64_t minDelayNs = 0;    // 窗口内最小往返时延（扣除接收端处理时间）
+    uint32_t samples = 0;      // 窗口内样本数
+    uint32_t accepted = 0;     // 其中参与拟合的样本数
+
+    int64_t offsetAt(int64_t localNs) const {
+        return offsetNs + static_cast<int64_t>(drift * static_cast<double>(localNs - referenceNs));
+    }
+    int64_t toReceiverNs(int64_t localNs) const { return localNs + offsetAt(localNs); }
+};
+
+/**
+ * @brief NTP 式四时间戳交换的偏移 / 漂移估计
+ *
+ * 每次交换：本机发出请求 t1 -> 接收端收到 t2 -> 接收端回复 t3 -> 本机收到 t4。
+ * 单个样本的偏移 θ = ((t2 - t1) + (t3 - t4)) / 2，往返时延 δ = (t4 - t1) - (t3 - t2)，
+ * 真实偏移在 θ ± δ/2 之内。排队造成的时延越大，不对称越可能越大，所以只有时延接近
+ * 窗口最小值的样本参与估计（剔除离群）：最小二乘斜率给出漂移，各样本的 θ ± δ/2 区间
+ * 按漂移换算到同一参考时刻（并按斜率的不确定度放宽）后取交集，交集中点为偏移、半宽为误差上界。
+ *
+ * addSample 在接收线程调用；estimate() 在任意线程无锁读取（写时复制发布）。
+ */
+class ClockSync {
+public:
+    static constexpr size_t WINDOW = 64;             // 参与估计的最近样本数
+    static constexpr int64_t DELAY_SLACK_NS = 250000; // 被接受样本的时延最多比最小值大 max(最小值, 此值)
+    static constexpr double MAX_DRIFT = 1e-3;        // 漂移拟合结果的绝对值上限（1000 ppm）
+
+    ClockSync();
+
+    /**
+     * @brief 加入一次交换的四个时间戳（t1/t4 为本机时间，t2/t3 为接收端时间）
+     * @return false 表示样本自相矛盾（时延为负）被丢弃
+     */
+    bool addSample(int64_t t1, int64_t t2, int64_t t3, int64_t t4);
+
+    /**
+     * @brief 当前估计，尚无样本时 valid=false
+     */
+    std::shared_ptr<const ClockEstimate> estimate() const;
+
+    /**
+     * @brief 清空样本（连接到新的接收端时调用）
+     */
+    void reset();
+
+    uint64_t totalSamples() const;
+    uint64_t invalidSamples() const;
+
+private:
+    struct Sample {
+        int64_t midNs;    // (t1 + t4) / 2
+        int64_t offsetNs; // θ
+        int64_t delayNs;  // δ
+    };
+
+    std::shared_ptr<const ClockEstimate> fitLocked();
+
+    mutable std::mutex mutex_; // 保护样本窗口与计数
+    std::vector<Sample> window_;
+    size_t next_ = 0;
+    uint64_t total_ = 0;
+    uint64_t invalid_ = 0;
+    double lastDrift_ = 0.0;
+    double lastDriftUncertainty_ = MAX_DRIFT; // 尚未拟合出漂移时按上限计入误差上界
+    std::shared_ptr<const ClockEstimate> estimate_;
+};
+
+#endif // CLOCK_SYNC_H
@@ -0,0 +1,307 @@
+#include "native_transport.h"
+#include "clock_sync.h"
+#include "packet_fanout.h"
+
+#include <android/log.h>
+#include <atomic>
+#include <mutex>
+#include <unistd.h>
+
+// 日志标签
+#define TAG "NativeTransport"
+
+// 所有订阅者。提交路径无锁（PacketFanout 内部写时复制），绑定/解绑由 g_transportMutex 串行化
+static PacketFanout g_fanout;
+static std::mutex g_transportMutex;
+// nativeAttachSocket 绑定的主连接（TcpCommunicator），它出错时提交返回 false 以触发重连
+static std::atomic<int> g_primarySubscriber{-1};
+// 主连接对端（接收端）的时钟估计：样本由 Kotlin 层读取 CLOCK_SYNC_REPLY 后送入
+static const std::shared_ptr<ClockSync> g_clockSync = std::make_shared<ClockSync>();
+static std::atomic<bool> g_receiverTimestamps{false};
+// 下一次 nativeAttachSocket 使用的协商结果（由 nativeNegotiateProtocol 设置）
+static std::atomic<uint32_t> g_protocolVersion{PROTOCOL_VERSION_V1};
+static std::atomic<uint32_t> g_protocolCapabilities{0};
+
+// 单个包 payload 的上限，超过时直接拒绝（协议中最长的 UI 包也远小于此值）
+static constexpr jint MAX_SUBMIT_PAYLOAD = 4096;
+
+bool submitTransportPacket(uint8_t type, const uint8_t* payload, size_t payloadLength) {
+    const bool accepted = g_fanout.submit(type, payload, payloadLength);
+    const int primary = g_primarySubscriber.load(std::memory_order_acquire);
+    if (primary >= 0) {
+        return g_fanout.isHealthy(primary);
+    }
+    return accepted;
+}
+
+/**
+ * @brief PacketSenderStats -> long[]，顺序见 nativeGetStats 的说明
+ */
+static jlongArray statsToArray(JNIEnv* env, const PacketSenderStats& s) {
+    const jlong values[] = {
+        static_cast<jlong>(s.packets),
+        static_cast<jlong>(s.syscalls),
+        static_cast<jlong>(s.bytes),
+        static_cast<jlong>(s.packets > 0 ? s.queueDelaySumUs / s.packets : 0),
+        static_cast<jlong>(s.maxQueueDelayUs),
+        static_cast<jlong>(s.urgentFlushes),
+        static_cast<jlong>(s.errors),
+        static_cast<jlong>(s.dropped),
+        static_cast<jlong>(s.superseded),
+        static_cast<jlong>(s.statePackets > 0 ? s.stateQueueDelaySumUs / s.statePackets : 0),
+        static_cast<jlong>(s.maxStateQueueDelayUs),
+    };
+    const jsize count = static_cast<jsize>(sizeof(values) / sizeof(values[0]));
+    jlongArray result = env->NewLongArray(count);
+    if (result) {
+        env->SetLongArrayRegion(result, 0, count, values);
+    }
+    return result;
+}
+
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_luoxiaohei_lowlatencyinput_network_NativeTransport_nativeAttachSocket(
+    JNIEnv* /* env */,
+    jclass /* clazz */,
+    jint socketFd,
+    jint batchWindowUs,
+    jint maxBatchPackets)
+{
+    std::lock_guard<std::mutex> lock(g_transportMutex);
+
+    const int previous = g_primarySubscriber.exchange(-1, std::memory_order_acq_rel);
+    if (previous >= 0) {
+        __android_log_print(ANDROID_LOG_WARN, TAG, "nativeAttachSocket: 替换仍在运行的主连接。");
+        g_fanout.removeSubscriber(previous);
+    }
+
+    // 新连接的对端可能是另一台接收端，旧的时钟估计作废
+    g_clockSync->reset();
+
+    PacketSenderConfig config;
+    config.batchWindowUs = batchWindowUs;
+    config.maxBatchPackets = maxBatchPackets > 0 ? static_cast<size_t>(maxBatchPackets) : 1;
+    config.protocolVersion = static_cast<uint16_t>(g_protocolVersion.load(std::memory_order_relaxed));
+    config.protocolCapabilities = g_protocolCapabilities.load(std::memory_order_relaxed);
+    // v2 连接仅在接收端声明支持时才使用接收端时间戳；v1 无从得知，由调用方的开关决定
+    const bool receiverClockAllowed = config.protocolVersion < PROTOCOL_VERSION_V2
+        || (config.protocolCapabilities & PROTOCOL_CAP_RECEIVER_TIMESTAMPS) != 0;
+    if (g_receiverTimestamps.load(std::memory_order_relaxed) && receiverClockAllowed) {
+        config.receiverClock = g_clockSync;
+    }
+
+    const int id = g_fanout.addSubscriber(socketFd, FANOUT_ALL_TYPES, config);
+    if (id < 0) {
+        if (socketFd >= 0) {
+            close(socketFd);
+        }
+        return JNI_FALSE;
+    }
+    g_primarySubscriber.store(id, std::memory_order_release);
+    return JNI_TRUE;
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_luoxiaohei_lowlatencyinput_network_NativeTransport_nativeDetachSocket(
+    JNIEnv* /* env */,
+    jclass /* clazz */)
+{
+    std::lock_guard<std::mutex> lock(g_transportMutex);
+    const int primary = g_primarySubscriber.exchange(-1, std::memory_order_acq_rel);
+    if (primary >= 0 && g_fanout.removeSubscriber(primary)) {
+        __android_log_print(ANDROID_LOG_INFO, TAG, "nativeDetachSocket: 主连接已解绑。");
+    }
+}
+
+extern "C" JNIEXPORT jint JNICALL
+Java_com_luoxiaohei_lowlatencyinput_network_NativeTransport_nativeAddSubscriber(
+    JNIEnv* /* env */,
+    jclass /* clazz */,
+    jint socketFd,
+    jlong typeMask,
+    jint batchWindowUs,
+    jint maxBatchPackets,
+    jint maxPendingPackets)
+{
+    std::lock_guard<std::mutex> lock(g_transportMutex);
+
+    PacketSenderConfig config;
+    config.batchWindowUs = batchWindowUs;
+    config.maxBatchPackets = maxBatchPackets > 0 ? static_cast<size_t>(maxBatchPackets) : 1;
+    config.maxPendingPackets = maxPendingPackets > 0 ? static_cast<size_t>(maxPendingPackets) : 0;
+
+    const int id = g_fanout.addSubscriber(socketFd, static_cast<uint64_t>(typeMask), config);
+    if (id < 0 && socketFd >= 0) {
+        close(socketFd);
+    }
+    return id;
+}
+
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_luoxiaohei_lowlatencyinput_network_NativeTransport_nativeRemoveSubscriber(
+    JNIEnv* /* env */,
+    jclass /* clazz */,
+    jint subscriberId)
+{
+    std::lock_guard<std::mutex> lock(g_transportMutex);
+    if (subscriberId == g_primarySubscriber.load(std::memory_order_acquire)) {
+        g_primarySubscriber.store(-1, std::memory_order_release);
+    }
+    return g_fanout.removeSubscriber(subscriberId) ? JNI_TRUE : JNI_FALSE;
+}
+
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_luoxiaohei_lowlatencyinput_network_NativeTransport_nativeSubmitPacket(
+    JNIEnv* env,
+    jclass /* clazz */,
+    jbyte packetType,
+    jbyteArray payload,
+    jint offset,
+    jint length)
+{
+    if (length < 0 || length > MAX_SUBMIT_PAYLOAD || offset < 0) {
+        __android_log_print(ANDROID_LOG_ERROR, TAG,
+            "nativeSubmitPacket: 非法参数 offset=%d, length=%d", offset, length);
+        return JNI_TRUE; // 参数错误不是连接错误，不触发重连
+    }
+
+    jbyte buffer[MAX_SUBMIT_PAYLOAD];
+    if (length > 0) {
+        if (!payload) {
+            return JNI_TRUE;
+        }
+        env->GetByteArrayRegion(payload, offset, length, buffer);
+        if (env->ExceptionCheck()) {
+            env->ExceptionDescribe();
+            env->ExceptionClear();
+            return JNI_TRUE;
+        }
+    }
+
+    bool ok = submitTransportPacket(static_cast<uint8_t>(packetType),
+                                    reinterpret_cast<const uint8_t*>(buffer),
+                                    static_cast<size_t>(length));
+    return ok ? JNI_TRUE : JNI_FALSE;
+}
+
+extern "C" JNIEXPORT jlongArray JNICALL
+Java_com_luoxiaohei_lowlatencyinput_network_NativeTransport_nativeGetStats(
+    JNIEnv* env,
+    jclass /* clazz */)
+{
+    return statsToArray(env, g_fanout.totalStats());
+}
+
+extern "C" JNIEXPORT jlongArray JNICALL
+Java_com_luoxiaohei_lowlatencyinput_network_NativeTransport_nativeGetSubscriberStats(
+    JNIEnv* env,
+    jclass /* clazz */,
+    jint subscriberId)
+{
+    FanoutSubscriberStats stats;
+    if (!g_fanout.subscriberStats(subscriberId, stats)) {
+        return nullptr;
+    }
+    return statsToArray(env, stats.sender);
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_luoxiaohei_lowlatencyinput_network_NativeTransport_nativeSetReceiverTimestamps(
+    JNIEnv* /* env */,
+    jclass /* clazz */,
+    jboolean enabled)
+{
+    g_receiverTimestamps.store(enabled == JNI_TRUE, std::memory_order_relaxed);
+}
+
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_luoxiaohei_lowlatencyinput_network_NativeTransport_nativeAddClockSample(
+    JNIEnv* /* env */,
+    jclass /* clazz */,
+    jlong t1,
+    jlong t2,
+    jlong t3,
+    jlong t4)
+{
+    if (!g_clockSync->addSample(t1, t2, t3, t4)) {
+        __android_log_print(ANDROID_LOG_WARN, TAG,
+            "nativeAddClockSample: 丢弃无效样本 (t1=%lld, t2=%lld, t3=%lld, t4=%lld)",
+            (long long)t1, (long long)t2, (long long)t3, (long long)t4);
+        return JNI_FALSE;
+    }
+    return JNI_TRUE;
+}
+
+extern "C" JNIEXPORT jlongArray JNICALL
+Java_com_luoxiaohei_lowlatencyinput_network_NativeTransport_nativeGetClockSync(
+    JNIEnv* env,
+    jclass /* clazz */)
+{
+    const auto clock = g_clockSync->estimate();
+    if (!clock->valid) {
+        return nullptr;
+    }
+    const jlong values[] = {
+        static_cast<jlong>(clock->offsetAt(monotonicNowNs())),
+        static_cast<jlong>(clock->drift * 1e9),
+        static_cast<jlong>(clock->errorBoundNs),
+        static_cast<jlong>(clock->minDelayNs),
+        static_cast<jlong>(clock->samples),
+        static_cast<jlong>(clock->accepted),
+    };
+    const jsize count = static_cast<jsize>(sizeof(values) / sizeof(values[0]));
+    jlongArray result = env->NewLongArray(count);
+    if (result) {
+        env->SetLongArrayRegion(result, 0, count, values);
+    }
+    return result;
+}
+
+extern "C" JNIEXPORT jlong JNICALL
+Java_com_luoxiaohei_lowlatencyinput_network_NativeTransport_nativeToReceiverTime(
+    JNIEnv* /* env */,
+    jclass /* clazz */,
+    jlong localNs)
+{
+    const auto clock = g_clockSync->estimate();
+    return clock->valid ? static_cast<jlong>(clock->toReceiverNs(localNs)) : localNs;
+}
+
+extern "C" JNIEXPORT jint JNICALL
+Java_com_luoxiaohei_lowlatencyinput_network_NativeTransport_nativeNegotiateProtocol(
+    JNIEnv* env,
+    jclass /* clazz */,
+    jbyteArray serverHello,
+    jint localCapabilities)
+{
+    V2Hello server{};
+    bool valid = false;
+    if (serverHello) {
+        const jsize length = env->GetArrayLength(serverHello);
+        jbyte buffer[sizeof(V2Hello)];
+        if (length >= static_cast<jsize>(sizeof(V2Hello))) {
+            env->GetByteArrayRegion(serverHello, 0, sizeof(V2Hello), buffer);
+            valid = decodeV2Hello(reinterpret_cast<const uint8_t*>(buffer), sizeof(buffer), server);
+        }
+        if (!valid) {
+            __android_log_print(ANDROID_LOG_WARN, TAG, "nativeNegotiateProtocol: SERVER_HELLO 无效 (%d 字节)，使用 v1。", length);
+        }
+    }
+
+    const V2Hello result = valid ? negotiateProtocol(server, static_cast<uint32_t>(localCapabilities))
+                                 : V2Hello{PROTOCOL_HELLO_MAGIC, PROTOCOL_VERSION_V1, 0, 0, 0};
+    g_protocolVersion.store(result.version, std::memory_order_relaxed);
+    g_protocolCapabilities.store(result.capabilities, std::memory_order_relaxed);
+    __android_log_print(ANDROID_LOG_INFO, TAG, "协议协商: v%u, capabilities=0x%x (本机 0x%x, 接收端 0x%x)",
+                        (unsigned)result.version, result.capabilities, (unsigned)localCapabilities,
+                        valid ? server.capabilities : 0u);
+    return result.version;
+}
+
+extern "C" JNIEXPORT jint JNICALL
+Java_com_luoxiaohei_lowlatencyinput_network_NativeTransport_nativeGetProtocolCapabilities(
+    JNIEnv* /* env */,
+    jclass /* clazz */)
+{
+    return static_cast<jint>(g_protocolCapabilities.load(std::memory_order_relaxed));
+}
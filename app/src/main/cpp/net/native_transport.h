@@ -0,0 +1,164 @@
+#ifndef NATIVE_TRANSPORT_H
+#define NATIVE_TRANSPORT_H
+
+#include <jni.h>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief 向所有订阅了该类型的发送器提交一个数据包（供 Native 层内部使用）
+ * @return false 表示主连接已出错，或没有主连接时没有任何订阅者接收
+ */
+bool submitTransportPacket(uint8_t type, const uint8_t* payload, size_t payloadLength);
+
+/**
+ * @brief JNI: 绑定 Kotlin 层建立的 TCP 连接 (dup 后的 fd) 作为订阅全部类型的主连接，启动批量发送线程
+ */
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_luoxiaohei_lowlatencyinput_network_NativeTransport_nativeAttachSocket(
+    JNIEnv* env,
+    jclass /* clazz */,
+    jint socketFd,
+    jint batchWindowUs,
+    jint maxBatchPackets
+);
+
+/**
+ * @brief JNI: 冲刷并停止主连接的发送线程，关闭其 fd（其他订阅者不受影响）
+ */
+extern "C" JNIEXPORT void JNICALL
+Java_com_luoxiaohei_lowlatencyinput_network_NativeTransport_nativeDetachSocket(
+    JNIEnv* env,
+    jclass /* clazz */
+);
+
+/**
+ * @brief JNI: 添加一个只接收 typeMask 中包类型的订阅者，拥有独立的发送线程与有界队列
+ * @param typeMask 按包类型置位 (1 << type)，-1 表示全部类型
+ * @param maxPendingPackets 队列上限，超出时按 latest-wins 丢弃状态包；0 表示不限
+ * @return 订阅者 ID，失败返回 -1（fd 已关闭）
+ */
+extern "C" JNIEXPORT jint JNICALL
+Java_com_luoxiaohei_lowlatencyinput_network_NativeTransport_nativeAddSubscriber(
+    JNIEnv* env,
+    jclass /* clazz */,
+    jint socketFd,
+    jlong typeMask,
+    jint batchWindowUs,
+    jint maxBatchPackets,
+    jint maxPendingPackets
+);
+
+/**
+ * @brief JNI: 冲刷并移除一个订阅者，关闭其 fd
+ */
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_luoxiaohei_lowlatencyinput_network_NativeTransport_nativeRemoveSubscriber(
+    JNIEnv* env,
+    jclass /* clazz */,
+    jint subscriberId
+);
+
+/**
+ * @brief JNI: 提交一个数据包 (payload 为 byte[] 的一段)
+ * @return false 表示发送器未绑定或 socket 已出错
+ */
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_luoxiaohei_lowlatencyinput_network_NativeTransport_nativeSubmitPacket(
+    JNIEnv* env,
+    jclass /* clazz */,
+    jbyte packetType,
+    jbyteArray payload,
+    jint offset,
+    jint length
+);
+
+/**
+ * @brief JNI: 获取所有订阅者的发送统计之和（最大排队延迟取最大值）
+ * @return long[] { packets, syscalls, bytes, avgQueueDelayUs, maxQueueDelayUs, urgentFlushes, errors, dropped,
+ *                  superseded, avgStateQueueDelayUs, maxStateQueueDelayUs }
+ */
+extern "C" JNIEXPORT jlongArray JNICALL
+Java_com_luoxiaohei_lowlatencyinput_network_NativeTransport_nativeGetStats(
+    JNIEnv* env,
+    jclass /* clazz */
+);
+
+/**
+ * @brief JNI: 获取单个订阅者的发送统计，格式同 nativeGetStats；订阅者不存在时返回 null
+ */
+extern "C" JNIEXPORT jlongArray JNICALL
+Java_com_luoxiaohei_lowlatencyinput_network_NativeTransport_nativeGetSubscriberStats(
+    JNIEnv* env,
+    jclass /* clazz */,
+    jint subscriberId
+);
+
+/**
+ * @brief JNI: 之后绑定的主连接是否把包头时间戳换算为接收端时钟（PING 与时钟同步请求除外）
+ */
+extern "C" JNIEXPORT void JNICALL
+Java_com_luoxiaohei_lowlatencyinput_network_NativeTransport_nativeSetReceiverTimestamps(
+    JNIEnv* env,
+    jclass /* clazz */,
+    jboolean enabled
+);
+
+/**
+ * @brief JNI: 加入一次时钟同步交换的四个时间戳（t1/t4 本机 System.nanoTime()，t2/t3 接收端时间）
+ * @return false 表示样本自相矛盾被丢弃
+ */
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_luoxiaohei_lowlatencyinput_network_NativeTransport_nativeAddClockSample(
+    JNIEnv* env,
+    jclass /* clazz */,
+    jlong t1,
+    jlong t2,
+    jlong t3,
+    jlong t4
+);
+
+/**
+ * @brief JNI: 当前时钟同步估计，尚无样本时返回 null
+ * @return long[] { offsetNs (此刻), driftPpb, errorBoundNs, minRoundTripNs, samples, accepted }
+ */
+extern "C" JNIEXPORT jlongArray JNICALL
+Java_com_luoxiaohei_lowlatencyinput_network_NativeTransport_nativeGetClockSync(
+    JNIEnv* env,
+    jclass /* clazz */
+);
+
+/**
+ * @brief JNI: 把本机 System.nanoTime() 换算为接收端时间，尚无估计时原样返回
+ */
+extern "C" JNIEXPORT jlong JNICALL
+Java_com_luoxiaohei_lowlatencyinput_network_NativeTransport_nativeToReceiverTime(
+    JNIEnv* env,
+    jclass /* clazz */,
+    jlong localNs
+);
+
+/**
+ * @brief JNI: 根据接收端的 SERVER_HELLO Payload 协商协议版本与能力，结果用于之后的 nativeAttachSocket
+ * @param serverHello V2Hello (16 字节)；为 null（接收端未发送，即 v1 接收端）时回退到 v1
+ * @param localCapabilities 本机希望启用的能力 (PROTOCOL_CAP_*)
+ * @return 协商得到的版本 (1 或 2)
+ */
+extern "C" JNIEXPORT jint JNICALL
+Java_com_luoxiaohei_lowlatencyinput_network_NativeTransport_nativeNegotiateProtocol(
+    JNIEnv* env,
+    jclass /* clazz */,
+    jbyteArray serverHello,
+    jint localCapabilities
+);
+
+/**
+ * @brief JNI: 最近一次协商得到的能力位 (v1 时为 0)
+ */
+extern "C" JNIEXPORT jint JNICALL
+Java_com_luoxiaohei_lowlatencyinput_network_NativeTransport_nativeGetProtocolCapabilities(
+    JNIEnv* env,
+    jclass /* clazz */
+);
+
+#endif // NATIVE_TRANSPORT_H
@@ -0,0 +1,287 @@
+#ifndef PACKET_CODEC_H
+#define PACKET_CODEC_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "protocol_v2.h"
+
+/**
+ * @file packet_codec.h
+ * @brief 客户端 -> 服务器线协议的编码（与 Constants.kt / README 保持一致）
+ *
+ * v1 标准包头 (9 字节): 类型(1) + 时间戳(8, BigEndian)
+ * v1 UI 事件包头 (11 字节): 类型(1) + 时间戳(8, BigEndian) + Payload 长度(2, LittleEndian)
+ * v2 见 protocol_v2.h。各产生方仍按 v1 格式构造 Payload，协商到 v2 的连接在发送时转换为 v2 记录。
+ *
+ * 启用接收端时间戳后，除 PING 与时钟同步请求外的包头时间戳为接收端时钟（见 clock_sync.h）。
+ */
+
+// ---------------- 包类型 (与 Constants.kt 对应) ----------------
+static constexpr uint8_t PACKET_TYPE_TOUCH         = 0x01;
+static constexpr uint8_t PACKET_TYPE_GYRO          = 0x02;
+static constexpr uint8_t PACKET_TYPE_PING          = 0x03;
+static constexpr uint8_t PACKET_TYPE_ACCEL         = 0x04;
+static constexpr uint8_t PACKET_TYPE_UI_EVENT      = 0x05;
+static constexpr uint8_t PACKET_TYPE_DEVICE_INFO   = 0x06;
+static constexpr uint8_t PACKET_TYPE_UI_LONG_PRESS = 0x07;
+static constexpr uint8_t PACKET_TYPE_UI_PRESS_DOWN = 0x08;
+static constexpr uint8_t PACKET_TYPE_UI_GESTURE    = 0x09;
+static constexpr uint8_t PACKET_TYPE_TOUCH_EXTENDED = 0x0A;
+static constexpr uint8_t PACKET_TYPE_CLOCK_SYNC    = 0x0B; // 时钟同步请求：无 payload，包头时间戳即 t1
+static constexpr uint8_t PACKET_TYPE_PEN           = 0x0D; // 笔采样，Payload 见 V1_PEN_PAYLOAD_SIZE
+static constexpr uint8_t PACKET_TYPE_HID           = 0x0E; // 外接设备状态增量，Payload 见 V1_HID_HEADER_SIZE
+static constexpr uint8_t PACKET_TYPE_TELEMETRY     = 0x0F; // 运行时统计，Payload 见 V1_TELEMETRY_HEADER_SIZE
+static constexpr uint8_t PACKET_TYPE_ACK           = 0xFE;
+// 服务器 -> 客户端的时钟同步回复，包头同 ACK (类型 + 时间戳 + 长度)，
+// Payload (24 字节, LittleEndian): t1(8, 原样回显) + t2(8, 接收端收到请求) + t3(8, 接收端发出回复)
+static constexpr uint8_t PACKET_TYPE_CLOCK_SYNC_REPLY = 0xFD;
+static constexpr size_t CLOCK_SYNC_REPLY_PAYLOAD_SIZE = 24;
+
+static constexpr size_t V1_STANDARD_HEADER_SIZE = 9;
+static constexpr size_t V1_UI_HEADER_SIZE = 11;
+
+/**
+ * @brief 包类型对应的位掩码，用于按类型配置策略（仅支持 0x00-0x3F）
+ */
+constexpr uint64_t packetTypeBit(uint8_t type) {
+    return type < 64 ? (uint64_t(1) << type) : 0;
+}
+
+/**
+ * @brief 包头时间戳是否必须保持本机时间（被接收端回显后在本机计算 RTT / 时钟偏移）
+ */
+constexpr bool isLocalClockPacketType(uint8_t type) {
+    return type == PACKET_TYPE_PING || type == PACKET_TYPE_CLOCK_SYNC;
+}
+
+/**
+ * @brief 是否为带 2 字节长度字段的 UI 事件包
+ */
+constexpr bool isV1UiPacketType(uint8_t type) {
+    return type == PACKET_TYPE_UI_EVENT
+        || type == PACKET_TYPE_UI_LONG_PRESS
+        || type == PACKET_TYPE_UI_PRESS_DOWN;
+}
+
+/**
+ * @brief 返回指定类型的 v1 包头长度
+ */
+constexpr size_t v1HeaderSize(uint8_t type) {
+    return isV1UiPacketType(type) ? V1_UI_HEADER_SIZE : V1_STANDARD_HEADER_SIZE;
+}
+
+/**
+ * @brief 写入 v1 包头
+ * @param out 至少 v1HeaderSize(type) 字节的缓冲区
+ * @param timestampNs 发送时间戳 (CLOCK_MONOTONIC 纳秒，等价于 Java System.nanoTime())
+ * @param payloadLength Payload 长度，仅 UI 事件包写入
+ * @return 写入的字节数
+ */
+inline size_t encodeV1Header(uint8_t* out, uint8_t type, int64_t timestampNs, size_t payloadLength) {
+    out[0] = type;
+    const uint64_t ts = static_cast<uint64_t>(timestampNs);
+    for (int i = 0; i < 8; ++i) {
+        out[1 + i] = static_cast<uint8_t>(ts >> (56 - 8 * i));
+    }
+    if (!isV1UiPacketType(type)) {
+        return V1_STANDARD_HEADER_SIZE;
+    }
+    out[9] = static_cast<uint8_t>(payloadLength & 0xFF);
+    out[10] = static_cast<uint8_t>((payloadLength >> 8) & 0xFF);
+    return V1_UI_HEADER_SIZE;
+}
+
+// ---------------- v1 Payload -> v2 记录 ----------------
+
+inline uint32_t loadLe32(const uint8_t* in) {
+    return uint32_t(in[0]) | uint32_t(in[1]) << 8 | uint32_t(in[2]) << 16 | uint32_t(in[3]) << 24;
+}
+
+inline uint64_t loadLe64(const uint8_t* in) {
+    return uint64_t(loadLe32(in)) | uint64_t(loadLe32(in + 4)) << 32;
+}
+
+inline uint32_t loadBe32(const uint8_t* in) {
+    return uint32_t(in[0]) << 24 | uint32_t(in[1]) << 16 | uint32_t(in[2]) << 8 | uint32_t(in[3]);
+}
+
+inline uint64_t loadBe64(const uint8_t* in) {
+    return uint64_t(loadBe32(in)) << 32 | uint64_t(loadBe32(in + 4));
+}
+
+inline float loadBeFloat(const uint8_t* in) {
+    const uint32_t bits = loadBe32(in);
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+static constexpr size_t V1_MOTION_PAYLOAD_SIZE = 28; // 时间戳(8) + 保留(8) + 3 个 float，均为 BigEndian
+// 笔采样 (LittleEndian): 时间戳 us(8) + X(4) + Y(4) + 压力(2) + 距离(2) + TiltX(2) + TiltY(2) + Flags(1) + 保留(3)
+static constexpr size_t V1_PEN_PAYLOAD_SIZE = 28;
+// 外接设备 (LittleEndian): 时间戳 us(8) + 设备编号(1) + 类别(1) + Flags(1) + Count(1)，
+// 后跟 Count 个变化: Type(1) + 保留(1) + Code(2) + Value(4)
+static constexpr size_t V1_HID_HEADER_SIZE = 12;
+static constexpr size_t V1_HID_CHANGE_SIZE = 8;
+// 运行时统计 (LittleEndian): 字段数(2) + 保留(6)，后跟字段数个 i64，顺序同 runtime_stats.h 的 RuntimeStatsField；
+// v2 原样携带（已按 8 字节对齐）
+static constexpr size_t V1_TELEMETRY_HEADER_SIZE = 8;
+
+/**
+ * @brief v1 Payload 转换为 v2 记录后的长度（已补齐到 8 的倍数）
+ * @return -1 表示 v1 Payload 与该类型的格式不符；未知类型按不透明字节原样携带
+ */
+inline long v2PayloadSize(uint8_t type, const uint8_t* v1, size_t length) {
+    switch (type) {
+    case PACKET_TYPE_TOUCH:
+    case PACKET_TYPE_TOUCH_EXTENDED: {
+        const size_t stride = type == PACKET_TYPE_TOUCH ? 12 : 16;
+        if (length < 9 || length != 9 + v1[8] * stride) return -1;
+        return static_cast<long>(sizeof(V2TouchFrame) + v1[8] * sizeof(V2Contact));
+    }
+    case PACKET_TYPE_GYRO:
+    case PACKET_TYPE_ACCEL:
+        return length == V1_MOTION_PAYLOAD_SIZE ? static_cast<long>(sizeof(V2MotionSample)) : -1;
+    case PACKET_TYPE_DEVICE_INFO:
+        return length == 8 ? static_cast<long>(sizeof(V2DeviceInfo)) : -1;
+    case PACKET_TYPE_UI_EVENT:
+    case PACKET_TYPE_UI_LONG_PRESS:
+        return length >= 8 ? static_cast<long>(v2Padded(sizeof(V2UiEvent) + length - 8)) : -1;
+    case PACKET_TYPE_UI_PRESS_DOWN:
+        return length >= 16 ? static_cast<long>(v2Padded(sizeof(V2UiPressDown) + length - 16)) : -1;
+    case PACKET_TYPE_UI_GESTURE:
+        return length >= 28 ? static_cast<long>(v2Padded(sizeof(V2UiGesture) + length - 28)) : -1;
+    case PACKET_TYPE_PEN:
+        return length == V1_PEN_PAYLOAD_SIZE ? static_cast<long>(sizeof(V2PenSample)) : -1;
+    case PACKET_TYPE_HID:
+        if (length < V1_HID_HEADER_SIZE || length != V1_HID_HEADER_SIZE + v1[11] * V1_HID_CHANGE_SIZE) return -1;
+        return static_cast<long>(sizeof(V2HidFrame) + v1[11] * sizeof(V2HidChange));
+    case PACKET_TYPE_TELEMETRY:
+        if (length < V1_TELEMETRY_HEADER_SIZE
+            || length != V1_TELEMETRY_HEADER_SIZE + (v1[0] | v1[1] << 8) * sizeof(uint64_t)) return -1;
+        return static_cast<long>(length);
+    default:
+        return static_cast<long>(v2Padded(length));
+    }
+}
+
+/**
+ * @brief 把 v1 Payload 写成 v2 记录
+ * @param out v2PayloadSize() 返回的长度，调用方保证格式已通过 v2PayloadSize 检查；填充字节置 0
+ */
+inline void encodeV2Payload(uint8_t type, const uint8_t* v1, size_t length, uint8_t* out, size_t outLength) {
+    std::memset(out, 0, outLength);
+    switch (type) {
+    case PACKET_TYPE_TOUCH:
+    case PACKET_TYPE_TOUCH_EXTENDED: {
+        const bool extended = type == PACKET_TYPE_TOUCH_EXTENDED;
+        V2TouchFrame frame{};
+        frame.eventTimeMs = static_cast<int64_t>(loadLe64(v1));
+        frame.count = v1[8];
+        std::memcpy(out, &frame, sizeof(frame));
+        const uint8_t* in = v1 + 9;
+        for (uint8_t i = 0; i < frame.count; ++i) {
+            V2Contact contact{};
+            contact.id = static_cast<int32_t>(loadLe32(in));
+            contact.x = static_cast<int32_t>(loadLe32(in + 4));
+            contact.y = static_cast<int32_t>(loadLe32(in + 8));
+            if (extended) {
+                contact.pressure = static_cast<uint16_t>(in[12] | in[13] << 8);
+                contact.touchMajor = static_cast<uint16_t>(in[14] | in[15] << 8);
+            }
+            std::memcpy(out + sizeof(frame) + i * sizeof(V2Contact), &contact, sizeof(contact));
+            in += extended ? 16 : 12;
+        }
+        break;
+    }
+    case PACKET_TYPE_GYRO:
+    case PACKET_TYPE_ACCEL: {
+        V2MotionSample sample{};
+        sample.eventTimeMs = static_cast<int64_t>(loadBe64(v1));
+        sample.x = loadBeFloat(v1 + 16);
+        sample.y = loadBeFloat(v1 + 20);
+        sample.z = loadBeFloat(v1 + 24);
+        std::memcpy(out, &sample, sizeof(sample));
+        break;
+    }
+    case PACKET_TYPE_DEVICE_INFO: {
+        V2DeviceInfo info{static_cast<int32_t>(loadLe32(v1)), static_cast<int32_t>(loadLe32(v1 + 4))};
+        std::memcpy(out, &info, sizeof(info));
+        break;
+    }
+    case PACKET_TYPE_UI_EVENT:
+    case PACKET_TYPE_UI_LONG_PRESS: {
+        V2UiEvent event{};
+        event.x = static_cast<int32_t>(loadLe32(v1));
+        event.y = static_cast<int32_t>(loadLe32(v1 + 4));
+        event.nameLength = static_cast<uint16_t>(length - 8);
+        std::memcpy(out, &event, sizeof(event));
+        std::memcpy(out + sizeof(event), v1 + 8, event.nameLength);
+        break;
+    }
+    case PACKET_TYPE_UI_PRESS_DOWN: {
+        V2UiPressDown press{};
+        press.x = static_cast<int32_t>(loadLe32(v1));
+        press.y = static_cast<int32_t>(loadLe32(v1 + 4));
+        press.downTimeMs = static_cast<int64_t>(loadLe64(v1 + 8));
+        press.nameLength = static_cast<uint16_t>(length - 16);
+        std::memcpy(out, &press, sizeof(press));
+        std::memcpy(out + sizeof(press), v1 + 16, press.nameLength);
+        break;
+    }
+    case PACKET_TYPE_UI_GESTURE: {
+        V2UiGesture gesture{};
+        gesture.kind = v1[0];
+        gesture.fingers = v1[1];
+        gesture.direction = v1[2];
+        gesture.x = static_cast<int32_t>(loadLe32(v1 + 4));
+        gesture.y = static_cast<int32_t>(loadLe32(v1 + 8));
+        gesture.dx = static_cast<int32_t>(loadLe32(v1 + 12));
+        gesture.dy = static_cast<int32_t>(loadLe32(v1 + 16));
+        gesture.timeMs = static_cast<int64_t>(loadLe64(v1 + 20));
+        gesture.nameLength = static_cast<uint16_t>(length - 28);
+        std::memcpy(out, &gesture, sizeof(gesture));
+        std::memcpy(out + sizeof(gesture), v1 + 28, gesture.nameLength);
+        break;
+    }
+    case PACKET_TYPE_PEN: {
+        V2PenSample pen{};
+        pen.eventTimeUs = static_cast<int64_t>(loadLe64(v1));
+        pen.x = static_cast<int32_t>(loadLe32(v1 + 8));
+        pen.y = static_cast<int32_t>(loadLe32(v1 + 12));
+        pen.pressure = static_cast<uint16_t>(v1[16] | v1[17] << 8);
+        pen.distance = static_cast<uint16_t>(v1[18] | v1[19] << 8);
+        pen.tiltX = static_cast<int16_t>(v1[20] | v1[21] << 8);
+        pen.tiltY = static_cast<int16_t>(v1[22] | v1[23] << 8);
+        pen.flags = v1[24];
+        std::memcpy(out, &pen, sizeof(pen));
+        break;
+    }
+    case PACKET_TYPE_HID: {
+        V2HidFrame frame{};
+        frame.eventTimeUs = static_cast<int64_t>(loadLe64(v1));
+        frame.deviceId = v1[8];
+        frame.deviceClass = v1[9];
+        frame.flags = v1[10];
+        frame.count = v1[11];
+        std::memcpy(out, &frame, sizeof(frame));
+        const uint8_t* in = v1 + V1_HID_HEADER_SIZE;
+        for (uint8_t i = 0; i < frame.count; ++i) {
+            V2HidChange change{};
+            change.type = in[0];
+            change.code = static_cast<uint16_t>(in[2] | in[3] << 8);
+            change.value = static_cast<int32_t>(loadLe32(in + 4));
+            std::memcpy(out + sizeof(frame) + i * sizeof(V2HidChange), &change, sizeof(change));
+            in += V1_HID_CHANGE_SIZE;
+        }
+        break;
+    }
+    default:
+        if (length > 0) std::memcpy(out, v1, length);
+        break;
+    }
+}
+
+#endif // PACKET_CODEC_H
@@ -0,0 +1,128 @@
+#include "packet_fanout.h"
+
+#include <android/log.h>
+
+// 日志标签
+#define TAG "NativePacketFanout"
+
+PacketFanout::~PacketFanout() {
+    removeAll();
+}
+
+bool PacketFanout::wants(const Subscriber& subscriber, uint8_t type) {
+    if (subscriber.typeMask == FANOUT_ALL_TYPES) {
+        return true;
+    }
+    return (subscriber.typeMask & packetTypeBit(type)) != 0;
+}
+
+int PacketFanout::addSubscriber(int socketFd, uint64_t typeMask, const PacketSenderConfig& config) {
+    auto sender = std::make_shared<PacketSender>();
+    if (!sender->start(socketFd, config)) {
+        return -1;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto next = std::make_shared<SubscriberList>(*std::atomic_load(&subscribers_));
+    const int id = nextId_++;
+    next->push_back(Subscriber{id, typeMask, std::move(sender)});
+    std::atomic_store(&subscribers_, std::shared_ptr<const SubscriberList>(std::move(next)));
+    __android_log_print(ANDROID_LOG_INFO, TAG,
+        "添加订阅者 %d: fd=%d, types=0x%llx, maxPending=%zu",
+        id, socketFd, (unsigned long long)typeMask, config.maxPendingPackets);
+    return id;
+}
+
+bool PacketFanout::removeSubscriber(int id) {
+    std::shared_ptr<PacketSender> removed;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto next = std::make_shared<SubscriberList>(*std::atomic_load(&subscribers_));
+        for (auto it = next->begin(); it != next->end(); ++it) {
+            if (it->id == id) {
+                removed = std::move(it->sender);
+                next->erase(it);
+                break;
+            }
+        }
+        if (!removed) {
+            return false;
+        }
+        std::atomic_store(&subscribers_, std::shared_ptr<const SubscriberList>(std::move(next)));
+    }
+    // 在锁外冲刷并停止：提交线程可能仍持有旧表，对已停止的发送器 submit 只返回 false
+    removed->stop();
+    __android_log_print(ANDROID_LOG_INFO, TAG, "移除订阅者 %d", id);
+    return true;
+}
+
+void PacketFanout::removeAll() {
+    std::shared_ptr<const SubscriberList> previous;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        previous = std::atomic_exchange(&subscribers_, std::make_shared<const SubscriberList>());
+    }
+    for (const auto& subscriber : *previous) {
+        subscriber.sender->stop();
+    }
+}
+
+bool PacketFanout::submit(uint8_t type, const uint8_t* payload, size_t payloadLength) {
+    const std::shared_ptr<const SubscriberList> subscribers = std::atomic_load(&subscribers_);
+    bool accepted = false;
+    for (const auto& subscriber : *subscribers) {
+        if (wants(subscriber, type)) {
+            accepted = subscriber.sender->submit(type, payload, payloadLength) || accepted;
+        }
+    }
+    return accepted;
+}
+
+size_t PacketFanout::subscriberCount() const {
+    return std::atomic_load(&subscribers_)->size();
+}
+
+bool PacketFanout::isHealthy(int id) const {
+    const std::shared_ptr<const SubscriberList> subscribers = std::atomic_load(&subscribers_);
+    for (const auto& subscriber : *subscribers) {
+        if (subscriber.id == id) {
+            return subscriber.sender->isHealthy();
+        }
+    }
+    return false;
+}
+
+bool PacketFanout::subscriberStats(int id, FanoutSubscriberStats& out) const {
+    const std::shared_ptr<const SubscriberList> subscribers = std::atomic_load(&subscribers_);
+    for (const auto& subscriber : *subscribers) {
+        if (subscriber.id == id) {
+            out.id = id;
+            out.typeMask = subscriber.typeMask;
+            out.healthy = subscriber.sender->isHealthy();
+            out.sender = subscriber.sender->stats();
+            return true;
+        }
+    }
+    return false;
+}
+
+PacketSenderStats PacketFanout::totalStats() const {
+    PacketSenderStats total;
+    const std::shared_ptr<const SubscriberList> subscribers = std::atomic_load(&subscribers_);
+    for (const auto& subscriber : *subscribers) {
+        const PacketSenderStats s = subscriber.sender->stats();
+        total.packets += s.packets;
+        total.syscalls += s.syscalls;
+        total.bytes += s.bytes;
+        total.queueDelaySumUs += s.queueDelaySumUs;
+        if (s.maxQueueDelayUs > total.maxQueueDelayUs) total.maxQueueDelayUs = s.maxQueueDelayUs;
+        total.urgentFlushes += s.urgentFlushes;
+        total.errors += s.errors;
+        total.dropped += s.dropped;
+        total.superseded += s.superseded;
+        total.statePackets += s.statePackets;
+        total.stateQueueDelaySumUs += s.stateQueueDelaySumUs;
+        if (s.maxStateQueueDelayUs > total.maxStateQueueDelayUs) total.maxStateQueueDelayUs = s.maxStateQueueDelayUs;
+    }
+    return total;
+}
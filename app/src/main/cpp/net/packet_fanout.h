@@ -0,0 +1,100 @@
+#ifndef PACKET_FANOUT_H
+#define PACKET_FANOUT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "packet_sender.h"
+
+/**
+ * @brief 订阅全部包类型的掩码
+ */
+static constexpr uint64_t FANOUT_ALL_TYPES = ~uint64_t(0);
+
+/**
+ * @brief 一个订阅者的统计快照
+ */
+struct FanoutSubscriberStats {
+    int id = -1;
+    uint64_t typeMask = 0;
+    bool healthy = false;
+    PacketSenderStats sender;
+};
+
+/**
+ * @brief 把同一个包流分发给多个订阅者（例如触摸 / UI 给 Fastkey，运动数据给 gyroxinput）
+ *
+ * 每个订阅者拥有独立的 PacketSender：自己的发送线程、有界队列与批处理窗口。
+ * submit 只在各自队列上短暂加锁，从不等待 socket；对端读得慢时 send 只阻塞它自己的
+ * 发送线程，队列满后按 latest-wins 丢弃过时的状态包，不影响其他订阅者。
+ *
+ * 订阅者表按写时复制发布，提交路径只做一次 atomic_load。
+ */
+class PacketFanout {
+public:
+    PacketFanout() = default;
+    ~PacketFanout();
+
+    PacketFanout(const PacketFanout&) = delete;
+    PacketFanout& operator=(const PacketFanout&) = delete;
+
+    /**
+     * @brief 添加订阅者并启动其发送线程
+     * @param socketFd 已连接的 socket，所有权转移给订阅者（失败时由调用方关闭）
+     * @param typeMask 订阅的包类型，packetTypeBit() 的组合；0x3F 以上的类型只投递给 FANOUT_ALL_TYPES
+     * @return 订阅者 ID，失败返回 -1
+     */
+    int addSubscriber(int socketFd, uint64_t typeMask, const PacketSenderConfig& config);
+
+    /**
+     * @brief 冲刷并停止一个订阅者，关闭其 socket
+     */
+    bool removeSubscriber(int id);
+
+    /**
+     * @brief 移除所有订阅者
+     */
+    void removeAll();
+
+    /**
+     * @brief 把包提交给所有订阅了该类型的订阅者
+     * @return false 表示没有任何订阅者接收（无人订阅该类型，或订阅者的 socket 均已出错）
+     */
+    bool submit(uint8_t type, const uint8_t* payload, size_t payloadLength);
+
+    size_t subscriberCount() const;
+
+    /**
+     * @brief 订阅者存在且 socket 未出错
+     */
+    bool isHealthy(int id) const;
+
+    /**
+     * @brief 单个订阅者的统计，不存在时返回 false
+     */
+    bool subscriberStats(int id, FanoutSubscriberStats& out) const;
+
+    /**
+     * @brief 所有订阅者的统计之和
+     */
+    PacketSenderStats totalStats() const;
+
+private:
+    struct Subscriber {
+        int id;
+        uint64_t typeMask;
+        std::shared_ptr<PacketSender> sender;
+    };
+    using SubscriberList = std::vector<Subscriber>;
+
+    static bool wants(const Subscriber& subscriber, uint8_t type);
+
+    mutable std::mutex mutex_; // 串行化订阅者表的修改
+    std::shared_ptr<const SubscriberList> subscribers_ = std::make_shared<const SubscriberList>();
+    int nextId_ = 1;
+};
+
+#endif // PACKET_FANOUT_H
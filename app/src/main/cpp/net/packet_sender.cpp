@@ -0,0 +1,388 @@
+#include "packet_sender.h"
+
+#include <android/log.h>
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <ctime>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "../common/runtime_stats.h"
+#include "../common/thread_config.h"
+#include "../common/trace_log.h"
+
+// 日志标签
+#define TAG "NativePacketSender"
+
+int64_t monotonicNowNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+PacketSender::~PacketSender() {
+    stop();
+}
+
+bool PacketSender::start(int socketFd, const PacketSenderConfig& config) {
+    if (running_.load()) {
+        __android_log_print(ANDROID_LOG_WARN, TAG, "start: 发送器已在运行，忽略。");
+        return false;
+    }
+    if (socketFd < 0) {
+        __android_log_print(ANDROID_LOG_ERROR, TAG, "start: 无效的 socket fd=%d", socketFd);
+        return false;
+    }
+
+    socketFd_ = socketFd;
+    config_ = config;
+    if (config_.batchWindowUs < 0) config_.batchWindowUs = 0;
+    if (config_.latestWinsMinAgeUs < 0) config_.latestWinsMinAgeUs = 0;
+    if (config_.maxBatchPackets == 0) config_.maxBatchPackets = 1;
+    if (config_.notSentLowatBytes > 0
+        && setsockopt(socketFd_, IPPROTO_TCP, TCP_NOTSENT_LOWAT,
+                      &config_.notSentLowatBytes, sizeof(config_.notSentLowatBytes)) != 0) {
+        __android_log_print(ANDROID_LOG_INFO, TAG,
+            "start: 无法设置 TCP_NOTSENT_LOWAT (errno=%d)，积压将留在内核发送缓冲区。", errno);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pending_.clear();
+        pending_.reserve(4096);
+        pendingPackets_.clear();
+        pendingPackets_.reserve(config_.maxBatchPackets);
+        pendingUrgent_ = false;
+        senderExited_ = false;
+        sequence_ = 0;
+        if (config_.protocolVersion >= PROTOCOL_VERSION_V2) {
+            // v2 连接的第一个包总是 CLIENT_HELLO，接收端据此确认本连接使用 v2
+            V2Hello hello{};
+            hello.magic = PROTOCOL_HELLO_MAGIC;
+            hello.version = PROTOCOL_VERSION_V2;
+            hello.capabilities = config_.protocolCapabilities;
+            appendLocked(PACKET_TYPE_CLIENT_HELLO, reinterpret_cast<const uint8_t*>(&hello), sizeof(hello),
+                         sizeof(hello), monotonicNowNs());
+            pendingUrgent_ = true;
+        }
+    }
+
+    healthy_.store(true, std::memory_order_release);
+    running_.store(true, std::memory_order_release);
+    thread_ = std::thread(&PacketSender::senderLoop, this);
+
+    __android_log_print(ANDROID_LOG_INFO, TAG,
+        "发送器已启动: fd=%d, window=%dus, maxBatch=%zu, protocol=v%u",
+        socketFd_, config_.batchWindowUs, config_.maxBatchPackets, (unsigned)config_.protocolVersion);
+    return true;
+}
+
+void PacketSender::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_.load()) {
+            return;
+        }
+        running_.store(false, std::memory_order_release);
+    }
+    cv_.notify_all();
+    {
+        // 发送线程可能阻塞在 send() 中（对端停读、链路中断），关闭 Kotlin 侧的 socket 不会唤醒它
+        std::unique_lock<std::mutex> lock(mutex_);
+        const bool exited = cv_.wait_for(lock, std::chrono::milliseconds(std::max(config_.stopDrainTimeoutMs, 0)),
+                                         [this] { return senderExited_; });
+        if (!exited) {
+            __android_log_print(ANDROID_LOG_WARN, TAG,
+                "stop: %dms 内未能写完剩余数据，shutdown socket 后放弃。", config_.stopDrainTimeoutMs);
+            shutdown(socketFd_, SHUT_RDWR);
+        }
+    }
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    if (socketFd_ >= 0) {
+        close(socketFd_);
+        socketFd_ = -1;
+    }
+    healthy_.store(false, std::memory_order_release);
+
+    const PacketSenderStats s = stats();
+    __android_log_print(ANDROID_LOG_INFO, TAG,
+        "发送器已停止: packets=%llu, syscalls=%llu, superseded=%llu, dropped=%llu, errors=%llu",
+        (unsigned long long)s.packets, (unsigned long long)s.syscalls,
+        (unsigned long long)s.superseded, (unsigned long long)s.dropped, (unsigned long long)s.errors);
+}
+
+bool PacketSender::submit(uint8_t type, const uint8_t* payload, size_t payloadLength) {
+    if (!healthy_.load(std::memory_order_acquire)) {
+        return false;
+    }
+    const bool v2 = config_.protocolVersion >= PROTOCOL_VERSION_V2;
+    long encodedLength = 0;
+    if (v2) {
+        encodedLength = v2PayloadSize(type, payload, payloadLength);
+        if (encodedLength < 0 || static_cast<size_t>(encodedLength) > V2_MAX_PAYLOAD) {
+            __android_log_print(ANDROID_LOG_ERROR, TAG,
+                "submit: 类型 0x%02x 的 payload 无法编码为 v2 (%zu 字节)，丢弃。", type, payloadLength);
+            return true;
+        }
+    } else if (isV1UiPacketType(type) && payloadLength > 0xFFFF) {
+        __android_log_print(ANDROID_LOG_ERROR, TAG,
+            "submit: UI 包 payload 过长 (%zu)，丢弃。", payloadLength);
+        return true;
+    }
+
+    bool wake = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_.load(std::memory_order_relaxed)) {
+            return false;
+        }
+        const int64_t nowNs = monotonicNowNs();
+        if (config_.latestWinsSlots && (config_.latestWinsTypeMask & packetTypeBit(type)) != 0) {
+            supersedeLocked(type, nowNs);
+        }
+        if (config_.maxPendingPackets > 0 && pendingPackets_.size() >= config_.maxPendingPackets) {
+            dropForIncomingLocked(type);
+        }
+        appendLocked(type, payload, payloadLength, static_cast<size_t>(encodedLength), nowNs);
+
+        const bool urgent = (config_.urgentTypeMask & packetTypeBit(type)) != 0;
+        pendingUrgent_ = pendingUrgent_ || urgent;
+        // 仅在需要改变发送线程等待状态时唤醒：队列由空变非空、紧急包、或达到批量上限
+        wake = pendingPackets_.size() == 1 || urgent
+            || pendingPackets_.size() >= config_.maxBatchPackets;
+    }
+    if (wake) {
+        cv_.notify_one();
+    }
+    return true;
+}
+
+/**
+ * @brief 编码一个包并追加到 pending_
+ * @param encodedLength v2 时为转换后的 Payload 长度（v1 忽略）
+ */
+void PacketSender::appendLocked(uint8_t type, const uint8_t* payload, size_t payloadLength,
+                                size_t encodedLength, int64_t nowNs) {
+    int64_t stampNs = nowNs;
+    uint8_t flags = 0;
+    if (config_.receiverClock && !isLocalClockPacketType(type)) {
+        const auto clock = config_.receiverClock->estimate();
+        if (clock->valid) {
+            stampNs = clock->toReceiverNs(nowNs);
+            flags |= V2_FLAG_RECEIVER_CLOCK;
+        }
+    }
+    const size_t offset = pending_.size();
+    size_t packetLength;
+    if (config_.protocolVersion >= PROTOCOL_VERSION_V2) {
+        packetLength = V2_HEADER_SIZE + encodedLength;
+        pending_.resize(offset + packetLength);
+        encodeV2Header(pending_.data() + offset, type, flags, encodedLength, sequence_++, stampNs);
+        encodeV2Payload(type, payload, payloadLength, pending_.data() + offset + V2_HEADER_SIZE, encodedLength);
+    } else {
+        packetLength = v1HeaderSize(type) + payloadLength;
+        pending_.resize(offset + packetLength);
+        const size_t headerLength = encodeV1Header(pending_.data() + offset, type, stampNs, payloadLength);
+        if (payloadLength > 0) {
+            std::memcpy(pending_.data() + offset + headerLength, payload, payloadLength);
+        }
+    }
+    pendingPackets_.push_back(PendingPacket{static_cast<uint32_t>(offset),
+                                            static_cast<uint32_t>(packetLength), type, nowNs});
+    runtimeStatsAddShared(RuntimeStatsField::QueueDepth, 1);
+}
+
+PacketSenderStats PacketSender::stats() const {
+    PacketSenderStats s;
+    s.packets = packets_.load(std::memory_order_relaxed);
+    s.syscalls = syscalls_.load(std::memory_order_relaxed);
+    s.bytes = bytes_.load(std::memory_order_relaxed);
+    s.queueDelaySumUs = queueDelaySumUs_.load(std::memory_order_relaxed);
+    s.maxQueueDelayUs = maxQueueDelayUs_.load(std::memory_order_relaxed);
+    s.urgentFlushes = urgentFlushes_.load(std::memory_order_relaxed);
+    s.errors = errors_.load(std::memory_order_relaxed);
+    s.dropped = dropped_.load(std::memory_order_relaxed);
+    s.superseded = superseded_.load(std::memory_order_relaxed);
+    s.statePackets = statePackets_.load(std::memory_order_relaxed);
+    s.stateQueueDelaySumUs = stateQueueDelaySumUs_.load(std::memory_order_relaxed);
+    s.maxStateQueueDelayUs = maxStateQueueDelayUs_.load(std::memory_order_relaxed);
+    return s;
+}
+
+/**
+ * @brief 队列已满（对端读得慢、send 阻塞）：为新包腾出位置
+ *
+ * 新包是状态包时丢弃同类型中最旧的一个；否则丢弃最旧的任意状态包。
+ * 队列中没有状态包时不丢弃，UI 等事件包保持无损，队列暂时超出上限。
+ */
+void PacketSender::dropForIncomingLocked(uint8_t incomingType) {
+    const bool incomingLatestWins = (config_.latestWinsTypeMask & packetTypeBit(incomingType)) != 0;
+    size_t victim = pendingPackets_.size();
+    for (size_t i = 0; i < pendingPackets_.size(); ++i) {
+        const uint8_t type = pendingPackets_[i].type;
+        if (incomingLatestWins ? type == incomingType
+                               : (config_.latestWinsTypeMask & packetTypeBit(type)) != 0) {
+            victim = i;
+            break;
+        }
+    }
+    if (victim == pendingPackets_.size()) {
+        return;
+    }
+    removePendingLocked(victim);
+    dropped_.fetch_add(1, std::memory_order_relaxed);
+    runtimeStatsAddShared(RuntimeStatsField::PacketsDropped, 1);
+}
+
+/**
+ * @brief 状态包的槽位：移除同类型中已排队超过 latestWinsMinAgeUs 的旧包，新包随后追加到队尾
+ *
+ * 年轻的包说明发送线程跟得上（只是调用方一次提交了一串），保留；
+ * 已交给发送线程（正在 send）的批次不受影响。
+ */
+void PacketSender::supersedeLocked(uint8_t incomingType, int64_t nowNs) {
+    const int64_t staleBeforeNs = nowNs - static_cast<int64_t>(config_.latestWinsMinAgeUs) * 1000;
+    for (size_t i = pendingPackets_.size(); i-- > 0;) {
+        if (pendingPackets_[i].type == incomingType && pendingPackets_[i].enqueueNs <= staleBeforeNs) {
+            removePendingLocked(i);
+            superseded_.fetch_add(1, std::memory_order_relaxed);
+            runtimeStatsAddShared(RuntimeStatsField::PacketsSuperseded, 1);
+        }
+    }
+}
+
+/**
+ * @brief 从 pending_ 中删除第 index 个包并修正其后各包的偏移
+ */
+void PacketSender::removePendingLocked(size_t index) {
+    const PendingPacket removed = pendingPackets_[index];
+    pending_.erase(pending_.begin() + removed.offset, pending_.begin() + removed.offset + removed.length);
+    pendingPackets_.erase(pendingPackets_.begin() + index);
+    runtimeStatsSubShared(RuntimeStatsField::QueueDepth, 1);
+    for (size_t i = index; i < pendingPackets_.size(); ++i) {
+        pendingPackets_[i].offset -= removed.length;
+    }
+}
+
+/**
+ * @brief 发送线程主循环
+ *
+ * 第一个包入队后开始计时，直到窗口结束、批量达到上限、出现紧急包或停止时
+ * 交换缓冲区并在锁外写出。
+ */
+void PacketSender::senderLoop() {
+    std::vector<uint8_t> inflight;
+    std::vector<PendingPacket> inflightPackets;
+    inflight.reserve(4096);
+    inflightPackets.reserve(config_.maxBatchPackets);
+    uint32_t threadConfigGeneration = 0;
+    ThreadCpuSampler cpuSampler(RuntimeStatsField::SenderCpuNs, true);
+
+    while (true) {
+        applyThreadConfigIfChanged(ThreadRole::PacketSender, threadConfigGeneration);
+        bool urgent = false;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait(lock, [this] {
+                return !running_.load(std::memory_order_relaxed) || !pendingPackets_.empty();
+            });
+            if (pendingPackets_.empty()) {
+                break; // 已停止且没有剩余数据
+            }
+
+            // steady_clock 在 Android/Linux 上即 CLOCK_MONOTONIC，可直接用入队时间构造截止点
+            const std::chrono::steady_clock::time_point deadline(
+                std::chrono::nanoseconds(pendingPackets_.front().enqueueNs)
+                + std::chrono::microseconds(config_.batchWindowUs));
+            cv_.wait_until(lock, deadline, [this] {
+                return !running_.load(std::memory_order_relaxed) || pendingUrgent_
+                    || pendingPackets_.size() >= config_.maxBatchPackets;
+            });
+
+            urgent = pendingUrgent_;
+            inflight.swap(pending_);
+            inflightPackets.swap(pendingPackets_);
+            pending_.clear();
+            pendingPackets_.clear();
+            pendingUrgent_ = false;
+        }
+        runtimeStatsSubShared(RuntimeStatsField::QueueDepth, inflightPackets.size());
+
+        if (!healthy_.load(std::memory_order_acquire)) {
+            continue; // socket 已出错，丢弃数据直至被停止
+        }
+
+        const int64_t writeStartNs = monotonicNowNs();
+        const bool written = writeAll(inflight.data(), inflight.size());
+        const int64_t flushNs = monotonicNowNs();
+        runtimeStatsAddShared(RuntimeStatsField::SendTimeNs, static_cast<uint64_t>(flushNs - writeStartNs));
+        cpuSampler.sample(flushNs);
+        if (written) {
+            uint64_t delaySumUs = 0;
+            uint64_t delayMaxUs = 0;
+            uint64_t statePackets = 0;
+            uint64_t stateDelaySumUs = 0;
+            uint64_t stateDelayMaxUs = 0;
+            for (const PendingPacket& packet : inflightPackets) {
+                const uint64_t delayUs = static_cast<uint64_t>((flushNs - packet.enqueueNs) / 1000);
+                delaySumUs += delayUs;
+                if (delayUs > delayMaxUs) delayMaxUs = delayUs;
+                if ((config_.latestWinsTypeMask & packetTypeBit(packet.type)) != 0) {
+                    ++statePackets;
+                    stateDelaySumUs += delayUs;
+                    if (delayUs > stateDelayMaxUs) stateDelayMaxUs = delayUs;
+                }
+            }
+            packets_.fetch_add(inflightPackets.size(), std::memory_order_relaxed);
+            bytes_.fetch_add(inflight.size(), std::memory_order_relaxed);
+            runtimeStatsAddShared(RuntimeStatsField::PacketsSent, inflightPackets.size());
+            runtimeStatsAddShared(RuntimeStatsField::BytesSent, inflight.size());
+            queueDelaySumUs_.fetch_add(delaySumUs, std::memory_order_relaxed);
+            if (delayMaxUs > maxQueueDelayUs_.load(std::memory_order_relaxed)) {
+                maxQueueDelayUs_.store(delayMaxUs, std::memory_order_relaxed);
+            }
+            statePackets_.fetch_add(statePackets, std::memory_order_relaxed);
+            stateQueueDelaySumUs_.fetch_add(stateDelaySumUs, std::memory_order_relaxed);
+            if (stateDelayMaxUs > maxStateQueueDelayUs_.load(std::memory_order_relaxed)) {
+                maxStateQueueDelayUs_.store(stateDelayMaxUs, std::memory_order_relaxed);
+            }
+            if (urgent) {
+                urgentFlushes_.fetch_add(1, std::memory_order_relaxed);
+            }
+        } else {
+            errors_.fetch_add(1, std::memory_order_relaxed);
+            runtimeStatsAddShared(RuntimeStatsField::SendErrors, 1);
+            healthy_.store(false, std::memory_order_release);
+            TRACE_W(TraceEvent::PacketWriteFailed, inflightPackets.size(), errno);
+        }
+    }
+    cpuSampler.flush();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        senderExited_ = true;
+    }
+    cv_.notify_all();
+}
+
+/**
+ * @brief 把整个批次写入 socket，处理部分写与 EINTR
+ */
+bool PacketSender::writeAll(const uint8_t* data, size_t length) {
+    size_t written = 0;
+    while (written < length) {
+        ssize_t n = send(socketFd_, data + written, length - written, MSG_NOSIGNAL);
+        syscalls_.fetch_add(1, std::memory_order_relaxed);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        written += static_cast<size_t>(n);
+    }
+    return true;
+}
@@ -0,0 +1,164 @@
+#ifndef PACKET_SENDER_H
+#define PACKET_SENDER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "clock_sync.h"
+#include "packet_codec.h"
+
+/**
+ * @brief 发送阶段的批处理配置
+ */
+struct PacketSenderConfig {
+    int batchWindowUs = 250;          // 批处理窗口：第一个包入队后最多等待的时间 (微秒)
+    size_t maxBatchPackets = 16;      // 单次系统调用最多携带的包数量
+    // 延迟敏感的包类型，入队后立即冲刷整个批次
+    uint64_t urgentTypeMask = packetTypeBit(PACKET_TYPE_PING)
+                            | packetTypeBit(PACKET_TYPE_CLOCK_SYNC)
+                            | packetTypeBit(PACKET_TYPE_UI_EVENT)
+                            | packetTypeBit(PACKET_TYPE_DEVICE_INFO)
+                            | packetTypeBit(PACKET_TYPE_UI_LONG_PRESS)
+                            | packetTypeBit(PACKET_TYPE_UI_PRESS_DOWN);
+    // 待写包数上限，0 表示不限。超出时按 latest-wins 丢弃被新数据取代的状态包，UI 等其余类型从不丢弃
+    size_t maxPendingPackets = 1024;
+    // 只携带"当前状态"的包类型（每个包都是完整状态，新包可以取代旧包）
+    uint64_t latestWinsTypeMask = packetTypeBit(PACKET_TYPE_TOUCH)
+                                | packetTypeBit(PACKET_TYPE_GYRO)
+                                | packetTypeBit(PACKET_TYPE_ACCEL);
+    // 状态包的 latest-wins 槽位：新包入队时，同类型中已排队超过 latestWinsMinAgeUs 的旧包被取代（新包排到队尾）。
+    // 链路正常时包在批处理窗口内就会写出，消费端一次提交的一串帧全部保留；链路变慢时积压的只有 UI 事件，
+    // 每种状态最多积压 (latestWinsMinAgeUs × 提交频率 + 1) 个包。false 时状态包只在队列满时丢弃
+    bool latestWinsSlots = true;
+    int latestWinsMinAgeUs = 1000;
+    // TCP_NOTSENT_LOWAT：内核中尚未发出的字节超过此值时 send() 阻塞，数据留在本队列里被新状态取代，
+    // 而不是在内核发送缓冲区里排队。0 表示不设置（非 TCP socket 上设置失败会被忽略）
+    int notSentLowatBytes = 16 * 1024;
+    // stop() 等待剩余数据写出的上限 (毫秒)：对端停读时 send() 会一直阻塞，超时后 shutdown socket 使其返回
+    int stopDrainTimeoutMs = 200;
+    // 非空且估计有效时，包头时间戳换算为接收端时钟（PING 与时钟同步请求除外）
+    std::shared_ptr<const ClockSync> receiverClock;
+    // 线协议版本：v2 时启动后先发送 CLIENT_HELLO，之后的包使用 v2 包头并把 Payload 转换为 v2 记录
+    uint16_t protocolVersion = PROTOCOL_VERSION_V1;
+    uint32_t protocolCapabilities = 0; // 协商得到的能力，写入 CLIENT_HELLO
+};
+
+/**
+ * @brief 发送统计快照
+ */
+struct PacketSenderStats {
+    uint64_t packets = 0;             // 已写出的包数量
+    uint64_t syscalls = 0;            // 写出这些包使用的系统调用次数
+    uint64_t bytes = 0;               // 已写出的字节数
+    uint64_t queueDelaySumUs = 0;     // 所有包的排队延迟之和 (入队 -> 写出)
+    uint64_t maxQueueDelayUs = 0;     // 单包最大排队延迟
+    uint64_t urgentFlushes = 0;       // 因延迟敏感包而提前冲刷的批次数
+    uint64_t errors = 0;              // 写错误次数
+    uint64_t dropped = 0;             // 队列满时按 latest-wins 丢弃的包数
+    uint64_t superseded = 0;          // 写出前被同类型新包取代的状态包数
+    uint64_t statePackets = 0;        // 已写出的包中 latestWinsTypeMask 类型的数量
+    uint64_t stateQueueDelaySumUs = 0; // 这些状态包的排队延迟之和
+    uint64_t maxStateQueueDelayUs = 0; // 状态包的单包最大排队延迟
+};
+
+/**
+ * @brief 截止时间受限的批量发送器
+ *
+ * 调用方在任意线程提交 v1 格式的 Payload（按 protocolVersion 编码为 v1 或 v2），发送线程把同一微窗口内产生的包
+ * 合并到一个连续缓冲区中，用一次 send() 写出。遇到 urgentTypeMask 中的类型时
+ * 立即冲刷，不等待窗口结束。接收端看到的字节流与逐包写出完全一致。
+ *
+ * 队列按包类型分两种策略：latestWinsTypeMask 中的状态包（触摸帧、运动采样）按 latest-wins 槽位排队，
+ * 新包取代已过时的旧包；其余包（UI 事件等）按序无损排队。链路恢复后写出的状态包最多过时 latestWinsMinAgeUs。
+ */
+class PacketSender {
+public:
+    PacketSender() = default;
+    ~PacketSender();
+
+    PacketSender(const PacketSender&) = delete;
+    PacketSender& operator=(const PacketSender&) = delete;
+
+    /**
+     * @brief 绑定已连接的 socket 并启动发送线程
+     * @param socketFd 已连接的 TCP socket，所有权转移给发送器
+     * @return 是否启动成功
+     */
+    bool start(int socketFd, const PacketSenderConfig& config);
+
+    /**
+     * @brief 冲刷剩余数据、停止发送线程并关闭 socket
+     *
+     * 最多等待 stopDrainTimeoutMs；对端不再读取时放弃剩余数据并 shutdown socket，保证及时返回。
+     */
+    void stop();
+
+    /**
+     * @brief 提交一个数据包，时间戳在提交时打上（本机时间，或配置了 receiverClock 时的接收端时间）
+     * @return false 表示发送器未运行或 socket 已出错，调用方应处理断线
+     */
+    bool submit(uint8_t type, const uint8_t* payload, size_t payloadLength);
+
+    bool isRunning() const { return running_.load(std::memory_order_acquire); }
+    bool isHealthy() const { return healthy_.load(std::memory_order_acquire); }
+
+    PacketSenderStats stats() const;
+
+private:
+    void senderLoop();
+    bool writeAll(const uint8_t* data, size_t length);
+    void dropForIncomingLocked(uint8_t incomingType);
+    void supersedeLocked(uint8_t incomingType, int64_t nowNs);
+    void removePendingLocked(size_t index);
+    void appendLocked(uint8_t type, const uint8_t* payload, size_t payloadLength, size_t encodedLength, int64_t nowNs);
+
+    /**
+     * @brief pending_ 中一个已编码包的位置
+     */
+    struct PendingPacket {
+        uint32_t offset;
+        uint32_t length;
+        uint8_t type;
+        int64_t enqueueNs;
+    };
+
+    int socketFd_ = -1;
+    PacketSenderConfig config_;
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+    std::atomic<bool> healthy_{false};
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::vector<uint8_t> pending_;           // 已编码、等待写出的字节
+    std::vector<PendingPacket> pendingPackets_; // 每个待写包的位置、类型与入队时间
+    bool pendingUrgent_ = false;
+    bool senderExited_ = false; // 发送线程已退出主循环（由 mutex_ 保护）
+    uint32_t sequence_ = 0; // v2 包头序号，被丢弃的包也占用序号
+
+    std::atomic<uint64_t> packets_{0};
+    std::atomic<uint64_t> syscalls_{0};
+    std::atomic<uint64_t> bytes_{0};
+    std::atomic<uint64_t> queueDelaySumUs_{0};
+    std::atomic<uint64_t> maxQueueDelayUs_{0};
+    std::atomic<uint64_t> urgentFlushes_{0};
+    std::atomic<uint64_t> errors_{0};
+    std::atomic<uint64_t> dropped_{0};
+    std::atomic<uint64_t> superseded_{0};
+    std::atomic<uint64_t> statePackets_{0};
+    std::atomic<uint64_t> stateQueueDelaySumUs_{0};
+    std::atomic<uint64_t> maxStateQueueDelayUs_{0};
+};
+
+/**
+ * @brief 当前 CLOCK_MONOTONIC 时间 (纳秒)，与 Java System.nanoTime() 同源
+ */
+int64_t monotonicNowNs();
+
+#endif // PACKET_SENDER_H
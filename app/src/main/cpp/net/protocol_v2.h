@@ -0,0 +1,322 @@
+#ifndef PROTOCOL_V2_H
+#define PROTOCOL_V2_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+/**
+ * @file protocol_v2.h
+ * @brief v2 线协议：统一的小端包头 + 自然对齐的定长记录（仅头文件，接收端可直接包含）
+ *
+ * 每个包 = V2Header (16 字节) + Payload (length 字节，length 总是 8 的倍数)。
+ * 只要接收缓冲区按 8 字节对齐，流中每个包头与 Payload 都按 8 字节对齐，
+ * 可以直接把 Payload 指针转换为下面的记录结构读取（小端主机）。
+ *
+ * 协商（兼容 v1 接收端）：
+ *   1. 支持 v2 的接收端在 accept 后立即发送 SERVER_HELLO，使用 v1 的 ACK 式包头
+ *      (类型 0xFC + 时间戳(8, BigEndian) + 长度(2, LittleEndian)) + V2Hello。
+ *   2. 客户端在超时内收到 SERVER_HELLO 时，以 v2 包头发送 CLIENT_HELLO (V2Hello，
+ *      version 为协商结果，capabilities 为双方交集)，此后两个方向都使用 v2。
+ *   3. 客户端没收到 SERVER_HELLO（v1 接收端不会主动发送数据），或不支持 v2 时，继续使用 v1；
+ *      接收端发现客户端的第一个包不是 CLIENT_HELLO 时同样回退到 v1。
+ */
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "protocol_v2.h 的记录按小端主机直接读写"
+#endif
+
+static constexpr uint16_t PROTOCOL_VERSION_V1 = 1;
+static constexpr uint16_t PROTOCOL_VERSION_V2 = 2;
+static constexpr uint32_t PROTOCOL_HELLO_MAGIC = 0x32494C4Cu; // 小端字节为 "LLI2"
+
+// ---------------- 能力位 (双方取交集) ----------------
+static constexpr uint32_t PROTOCOL_CAP_CLOCK_SYNC         = 1u << 0; // 接收端回复 CLOCK_SYNC (0x0B -> 0xFD)
+static constexpr uint32_t PROTOCOL_CAP_RECEIVER_TIMESTAMPS = 1u << 1; // 包头时间戳可以是接收端时钟（见 V2_FLAG_RECEIVER_CLOCK）
+static constexpr uint32_t PROTOCOL_CAP_TOUCH_EXTENDED     = 1u << 2; // 接收端理解 TOUCH_EXTENDED 的压力 / 接触尺寸
+static constexpr uint32_t PROTOCOL_CAP_PEN                = 1u << 3; // 接收端理解 PEN (0x0D) 笔采样
+static constexpr uint32_t PROTOCOL_CAP_HID                = 1u << 4; // 接收端理解 HID (0x0E) 外接设备状态增量
+static constexpr uint32_t PROTOCOL_CAP_TELEMETRY          = 1u << 5; // 接收端理解 TELEMETRY (0x0F) 运行时统计
+
+// ---------------- 握手包类型 ----------------
+static constexpr uint8_t PACKET_TYPE_CLIENT_HELLO = 0x0C; // 客户端 -> 服务器，v2 包头
+static constexpr uint8_t PACKET_TYPE_SERVER_HELLO = 0xFC; // 服务器 -> 客户端，v1 ACK 式包头
+
+// ---------------- 包头标志 ----------------
+static constexpr uint8_t V2_FLAG_RECEIVER_CLOCK = 1u << 0; // 时间戳已换算为接收端时钟
+
+/**
+ * @brief v2 包头 (16 字节, LittleEndian)
+ *
+ * sequence 在每条连接上从 0 开始逐包递增，发送端按 latest-wins 丢弃的包也占用序号，
+ * 接收端可以从序号缺口得知丢弃数量。
+ */
+struct V2Header {
+    uint8_t type;
+    uint8_t flags;       // V2_FLAG_*
+    uint16_t length;     // Payload 字节数，8 的倍数
+    uint32_t sequence;
+    int64_t timestampNs; // 发送时间戳 (CLOCK_MONOTONIC 纳秒，或接收端时钟)
+};
+
+/**
+ * @brief 握手 Payload (16 字节)，SERVER_HELLO 与 CLIENT_HELLO 共用
+ */
+struct V2Hello {
+    uint32_t magic;        // PROTOCOL_HELLO_MAGIC
+    uint16_t version;      // SERVER_HELLO: 支持的最高版本；CLIENT_HELLO: 协商结果
+    uint16_t reserved;
+    uint32_t capabilities; // PROTOCOL_CAP_*
+    uint32_t reserved2;
+};
+
+/**
+ * @brief TOUCH (0x01) / TOUCH_EXTENDED (0x0A) 的帧头 (16 字节)，后跟 count 个 V2Contact
+ */
+struct V2TouchFrame {
+    int64_t eventTimeMs; // 输入事件时间 (毫秒)
+    uint8_t count;
+    uint8_t reserved[7];
+};
+
+/**
+ * @brief 单个触摸点 (16 字节)；TOUCH 包中 pressure/touchMajor 为 0
+ */
+struct V2Contact {
+    int32_t id;
+    int32_t x;
+    int32_t y;
+    uint16_t pressure;   // 设备轴范围的千分比
+    uint16_t touchMajor; // 设备轴范围的千分比
+};
+
+/**
+ * @brief GYRO (0x02) / ACCEL (0x04) 的一个采样 (24 字节)
+ */
+struct V2MotionSample {
+    int64_t eventTimeMs;
+    float x;
+    float y;
+    float z;
+    uint32_t reserved;
+};
+
+/**
+ * @brief UI_EVENT (0x05) / UI_LONG_PRESS (0x07) 的记录 (16 字节)，后跟 nameLength 字节 UTF-8 名称
+ */
+struct V2UiEvent {
+    int32_t x;
+    int32_t y;
+    uint16_t nameLength;
+    uint8_t reserved[6];
+};
+
+/**
+ * @brief UI_PRESS_DOWN (0x08) 的记录 (24 字节)，后跟名称
+ */
+struct V2UiPressDown {
+    int32_t x;
+    int32_t y;
+    int64_t downTimeMs;
+    uint16_t nameLength;
+    uint8_t reserved[6];
+};
+
+/**
+ * @brief UI_GESTURE (0x09) 的记录 (40 字节)，后跟名称；字段含义同 v1
+ */
+struct V2UiGesture {
+    uint8_t kind;
+    uint8_t fingers;
+    uint8_t direction;
+    uint8_t reserved;
+    int32_t x;
+    int32_t y;
+    int32_t dx;
+    int32_t dy;
+    uint32_t reserved2;
+    int64_t timeMs;
+    uint16_t nameLength;
+    uint8_t reserved3[6];
+};
+
+/**
+ * @brief PEN (0x0D) 的一个笔采样 (32 字节)
+ *
+ * x / y 为屏幕坐标；pressure 为轴范围的万分比（仅接触时），distance 为悬停距离的千分比（仅悬停时），
+ * tiltX / tiltY 为屏幕坐标系下的倾角 (0.01°)，flags: 0x01 在范围内 / 0x02 接触 / 0x04 笔杆键 1 /
+ * 0x08 笔杆键 2 / 0x10 橡皮擦端。笔离开范围时发送一个 flags 为 0 的采样。
+ */
+struct V2PenSample {
+    int64_t eventTimeUs; // 输入事件时间 (微秒)
+    int32_t x;
+    int32_t y;
+    uint16_t pressure;
+    uint16_t distance;
+    int16_t tiltX;
+    int16_t tiltY;
+    uint8_t flags;
+    uint8_t reserved[7];
+};
+
+/**
+ * @brief HID (0x0E) 的帧头 (16 字节)，后跟 count 个 V2HidChange
+ *
+ * deviceClass: 0x01 手柄 / 0x02 键盘 / 0x04 鼠标；flags: 0x01 设备接入（变化为完整的非静止状态）/
+ * 0x02 设备移除（抬起所有键、轴回到静止位置）/ 0x04 丢事件后按内核状态补齐。
+ */
+struct V2HidFrame {
+    int64_t eventTimeUs; // 输入事件时间 (微秒)
+    uint8_t deviceId;
+    uint8_t deviceClass;
+    uint8_t flags;
+    uint8_t count;
+    uint8_t reserved[4];
+};
+
+/**
+ * @brief 一个状态变化 (8 字节)。type 为 EV_KEY(1) / EV_ABS(3) / EV_REL(2)，code 为 Linux 事件码；
+ *        按键 value 为 1 / 0，绝对轴为归一化值（双向 ±32767，扳机 0..32767），相对轴为帧内位移
+ */
+struct V2HidChange {
+    uint8_t type;
+    uint8_t reserved;
+    uint16_t code;
+    int32_t value;
+};
+
+/**
+ * @brief DEVICE_INFO (0x06) 的记录 (8 字节)
+ */
+struct V2DeviceInfo {
+    int32_t width;
+    int32_t height;
+};
+
+/**
+ * @brief CLOCK_SYNC_REPLY (0xFD) 的记录 (24 字节)
+ */
+struct V2ClockSyncReply {
+    int64_t t1;
+    int64_t t2;
+    int64_t t3;
+};
+
+static_assert(sizeof(V2Header) == 16 && alignof(V2Header) == 8, "V2Header 布局");
+static_assert(sizeof(V2Hello) == 16, "V2Hello 布局");
+static_assert(sizeof(V2TouchFrame) == 16 && sizeof(V2Contact) == 16, "触摸记录布局");
+static_assert(sizeof(V2MotionSample) == 24, "V2MotionSample 布局");
+static_assert(sizeof(V2UiEvent) == 16 && sizeof(V2UiPressDown) == 24 && sizeof(V2UiGesture) == 40, "UI 记录布局");
+static_assert(sizeof(V2DeviceInfo) == 8 && sizeof(V2ClockSyncReply) == 24, "定长记录布局");
+static_assert(sizeof(V2PenSample) == 32, "V2PenSample 布局");
+static_assert(sizeof(V2HidFrame) == 16 && sizeof(V2HidChange) == 8, "HID 记录布局");
+
+static constexpr size_t V2_HEADER_SIZE = sizeof(V2Header);
+static constexpr size_t V2_ALIGNMENT = 8;
+static constexpr size_t V2_MAX_PAYLOAD = 0xFFF8; // length 字段能表示的最大 8 的倍数
+
+/**
+ * @brief 向上取整到 8 的倍数
+ */
+constexpr size_t v2Padded(size_t length) {
+    return (length + V2_ALIGNMENT - 1) & ~(V2_ALIGNMENT - 1);
+}
+
+/**
+ * @brief 解码得到的一个包，payload 指向调用方缓冲区内部
+ */
+struct V2PacketView {
+    V2Header header;
+    const uint8_t* payload;
+
+    /**
+     * @brief 把 Payload 开头解释为记录 T；长度不足或地址未对齐时返回 nullptr
+     */
+    template <typename T>
+    const T* record() const {
+        if (header.length < sizeof(T) || reinterpret_cast<uintptr_t>(payload) % alignof(T) != 0) {
+            return nullptr;
+        }
+        return reinterpret_cast<const T*>(payload);
+    }
+
+    /**
+     * @brief 第 index 个 T 类型的数组元素，数组从 Payload 的 offset 字节处开始
+     */
+    template <typename T>
+    const T* element(size_t offset, size_t index) const {
+        const size_t begin = offset + index * sizeof(T);
+        if (begin + sizeof(T) > header.length || reinterpret_cast<uintptr_t>(payload + begin) % alignof(T) != 0) {
+            return nullptr;
+        }
+        return reinterpret_cast<const T*>(payload + begin);
+    }
+};
+
+/**
+ * @brief 从字节流中解码一个完整的 v2 包（不拷贝 Payload）
+ * @param data 流中下一个包的起始位置
+ * @param available data 之后可用的字节数
+ * @return 包的总字节数；0 表示数据不足需要继续接收；-1 表示包头非法（length 不是 8 的倍数）
+ */
+inline long decodeV2Packet(const uint8_t* data, size_t available, V2PacketView& out) {
+    if (available < V2_HEADER_SIZE) {
+        return 0;
+    }
+    std::memcpy(&out.header, data, V2_HEADER_SIZE);
+    if (out.header.length % V2_ALIGNMENT != 0) {
+        return -1;
+    }
+    const size_t total = V2_HEADER_SIZE + out.header.length;
+    if (available < total) {
+        return 0;
+    }
+    out.payload = data + V2_HEADER_SIZE;
+    return static_cast<long>(total);
+}
+
+/**
+ * @brief 写入 v2 包头
+ * @param out 至少 V2_HEADER_SIZE 字节
+ */
+inline void encodeV2Header(uint8_t* out, uint8_t type, uint8_t flags, size_t paddedLength,
+                           uint32_t sequence, int64_t timestampNs) {
+    V2Header header;
+    header.type = type;
+    header.flags = flags;
+    header.length = static_cast<uint16_t>(paddedLength);
+    header.sequence = sequence;
+    header.timestampNs = timestampNs;
+    std::memcpy(out, &header, V2_HEADER_SIZE);
+}
+
+/**
+ * @brief 解析握手 Payload
+ * @return magic 不符或长度不足时返回 false
+ */
+inline bool decodeV2Hello(const uint8_t* payload, size_t length, V2Hello& out) {
+    if (length < sizeof(V2Hello)) {
+        return false;
+    }
+    std::memcpy(&out, payload, sizeof(V2Hello));
+    return out.magic == PROTOCOL_HELLO_MAGIC;
+}
+
+/**
+ * @brief 根据 SERVER_HELLO 协商版本与能力
+ * @param localCapabilities 本端支持（并希望启用）的能力
+ * @return 协商结果；version 为 PROTOCOL_VERSION_V1 表示回退到 v1
+ */
+inline V2Hello negotiateProtocol(const V2Hello& server, uint32_t localCapabilities) {
+    V2Hello result{};
+    result.magic = PROTOCOL_HELLO_MAGIC;
+    if (server.magic != PROTOCOL_HELLO_MAGIC || server.version < PROTOCOL_VERSION_V2) {
+        result.version = PROTOCOL_VERSION_V1;
+        return result;
+    }
+    result.version = PROTOCOL_VERSION_V2;
+    result.capabilities = server.capabilities & localCapabilities;
+    return result;
+}
+
+#endif // PROTOCOL_V2_H
@@ -0,0 +1,243 @@
+/**
+ * 时钟同步 (ClockSync) 的 Linux 回环测试。
+ *
+ * 本机 TCP 回环上的接收端替身使用人为偏斜的时钟：
+ *   receiver(t) = t + kOffsetNs + kDrift * (t - 启动时刻)
+ * 并对部分请求在 t2 之前或 t3 之后插入排队延迟，制造不对称的离群样本。
+ * 发送端走真实路径：PacketSender 发出 CLOCK_SYNC 请求，读线程收到 CLOCK_SYNC_REPLY 后打 t4 送入 ClockSync。
+ *
+ * 检查：估计的偏移与真实偏移之差不超过报告的误差上界（且上界足够小），漂移接近 kDrift，离群样本被剔除；
+ *       开启接收端时间戳后，接收端用自己的时钟算出的单向延迟落在 [-误差上界, 合理上限] 之内。
+ */
+#include "net/clock_sync.h"
+#include "net/packet_sender.h"
+#include "test_support.h"
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <random>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+constexpr int64_t kOffsetNs = -987654321012LL; // 接收端时钟与本机相差约 -16 分钟
+constexpr double kDrift = 150e-6;               // 接收端时钟快 150 ppm
+constexpr int kSyncRounds = 120;
+constexpr int kSyncIntervalMs = 15; // 64 个样本的窗口约跨 1 秒，足以估计漂移
+constexpr int kTouchPackets = 200;
+
+int64_t g_baseNs = 0;
+
+int64_t receiverNowNs() {
+    const int64_t localNs = monotonicNowNs();
+    return localNs + kOffsetNs + static_cast<int64_t>(kDrift * static_cast<double>(localNs - g_baseNs));
+}
+
+int64_t trueOffsetAt(int64_t localNs) {
+    return kOffsetNs + static_cast<int64_t>(kDrift * static_cast<double>(localNs - g_baseNs));
+}
+
+bool readExact(int fd, uint8_t* out, size_t length) {
+    size_t done = 0;
+    while (done < length) {
+        const ssize_t n = recv(fd, out + done, length - done, 0);
+        if (n <= 0) return false;
+        done += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+void putLe64(uint8_t* out, int64_t value) {
+    for (int i = 0; i < 8; ++i) out[i] = static_cast<uint8_t>(static_cast<uint64_t>(value) >> (8 * i));
+}
+
+int64_t getLe64(const uint8_t* in) {
+    uint64_t value = 0;
+    for (int i = 7; i >= 0; --i) value = (value << 8) | in[i];
+    return static_cast<int64_t>(value);
+}
+
+int64_t getBe64(const uint8_t* in) {
+    uint64_t value = 0;
+    for (int i = 0; i < 8; ++i) value = (value << 8) | in[i];
+    return static_cast<int64_t>(value);
+}
+
+/**
+ * @brief 接收端替身：回复时钟同步请求，记录触摸包的单向延迟（接收端时钟）
+ */
+struct Receiver {
+    int fd = -1;
+    std::mutex mutex;
+    std::vector<int64_t> oneWayNs;
+    int outliers = 0;
+
+    void run() {
+        std::mt19937 rng(42);
+        std::uniform_int_distribution<int> percent(0, 99);
+        std::uniform_int_distribution<int> queueUs(500, 4000);
+        uint8_t header[V1_STANDARD_HEADER_SIZE];
+        for (;;) {
+            if (!readExact(fd, header, sizeof(header))) break;
+            const uint8_t type = header[0];
+            const int64_t stampNs = getBe64(header + 1);
+            if (type == PACKET_TYPE_CLOCK_SYNC) {
+                const int roll = percent(rng);
+                if (roll < 15) { // 请求方向排队：t2 偏晚
+                    std::this_thread::sleep_for(std::chrono::microseconds(queueUs(rng)));
+                    ++outliers;
+                }
+                const int64_t t2 = receiverNowNs();
+                uint8_t reply[V1_UI_HEADER_SIZE + CLOCK_SYNC_REPLY_PAYLOAD_SIZE];
+                reply[0] = PACKET_TYPE_CLOCK_SYNC_REPLY;
+                std::memcpy(reply + 1, header + 1, 8);
+                reply[9] = CLOCK_SYNC_REPLY_PAYLOAD_SIZE;
+                reply[10] = 0;
+                putLe64(reply + 11, stampNs);
+                putLe64(reply + 19, t2);
+                putLe64(reply + 27, receiverNowNs());
+                if (roll >= 15 && roll < 30) { // 回复方向排队：t4 偏晚
+                    std::this_thread::sleep_for(std::chrono::microseconds(queueUs(rng)));
+                    ++outliers;
+                }
+                if (send(fd, reply, sizeof(reply), MSG_NOSIGNAL) != static_cast<ssize_t>(sizeof(reply))) break;
+            } else if (type == PACKET_TYPE_TOUCH) {
+                const int64_t receivedNs = receiverNowNs();
+                uint8_t payload[9];
+                if (!readExact(fd, payload, sizeof(payload))) break;
+                std::lock_guard<std::mutex> lock(mutex);
+                oneWayNs.push_back(receivedNs - stampNs);
+            }
+        }
+    }
+};
+
+} // namespace
+
+int main() {
+    g_baseNs = monotonicNowNs();
+
+    const int listenFd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t addrLength = sizeof(addr);
+    if (listenFd < 0 || bind(listenFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0
+        || listen(listenFd, 1) != 0 || getsockname(listenFd, reinterpret_cast<sockaddr*>(&addr), &addrLength) != 0) {
+        std::printf("clock sync: 无法监听回环地址，跳过\n");
+        return 77;
+    }
+    Receiver receiver;
+    receiver.fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (connect(receiver.fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        std::printf("clock sync: 无法连接回环地址，跳过\n");
+        return 77;
+    }
+    const int phoneFd = accept4(listenFd, nullptr, nullptr, SOCK_CLOEXEC);
+    close(listenFd);
+    const int one = 1;
+    setsockopt(phoneFd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    setsockopt(receiver.fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    // 样本一致性
+    {
+        ClockSync scratch;
+        EXPECT(!scratch.estimate()->valid, "空估计应无效");
+        EXPECT(!scratch.addSample(1000, 5000, 5100, 900), "t4 < t1 应被拒绝");
+        EXPECT(!scratch.addSample(1000, 5000, 5100, 1050), "负时延应被拒绝");
+        EXPECT(scratch.addSample(1000, 5000, 5100, 1200) && scratch.estimate()->valid, "有效样本");
+        EXPECT(scratch.estimate()->offsetNs == 3950, "单样本偏移: %lld", (long long)scratch.estimate()->offsetNs);
+    }
+
+    // 发送端：PacketSender 持有 phoneFd，读线程用 dup 的 fd 读回复（与 Kotlin 层 dup socket 一致）
+    auto clock = std::make_shared<ClockSync>();
+    const int phoneReadFd = dup(phoneFd);
+    PacketSenderConfig config;
+    config.receiverClock = clock;
+    PacketSender sender;
+    EXPECT(sender.start(phoneFd, config), "sender.start");
+
+    std::thread receiverThread(&Receiver::run, &receiver);
+    std::atomic<int> replies{0};
+    std::thread replyThread([&]() {
+        uint8_t reply[V1_UI_HEADER_SIZE + CLOCK_SYNC_REPLY_PAYLOAD_SIZE];
+        while (readExact(phoneReadFd, reply, sizeof(reply))) {
+            const int64_t t4 = monotonicNowNs();
+            if (reply[0] != PACKET_TYPE_CLOCK_SYNC_REPLY) continue;
+            clock->addSample(getLe64(reply + 11), getLe64(reply + 19), getLe64(reply + 27), t4);
+            replies.fetch_add(1, std::memory_order_relaxed);
+        }
+    });
+
+    for (int i = 0; i < kSyncRounds; ++i) {
+        sender.submit(PACKET_TYPE_CLOCK_SYNC, nullptr, 0);
+        std::this_thread::sleep_for(std::chrono::milliseconds(kSyncIntervalMs));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+    const auto estimate = clock->estimate();
+    const int64_t nowNs = monotonicNowNs();
+    const int64_t offsetErrorNs = estimate->offsetAt(nowNs) - trueOffsetAt(nowNs);
+    std::printf("clock sync: replies=%d outliers=%d window=%u accepted=%u minRtt=%lldus\n",
+                replies.load(), receiver.outliers, estimate->samples, estimate->accepted,
+                (long long)estimate->minDelayNs / 1000);
+    std::printf("clock sync: offset error=%lldns bound=%lldns drift=%.1fppm (true %.1fppm)\n",
+                (long long)offsetErrorNs, (long long)estimate->errorBoundNs, estimate->drift * 1e6, kDrift * 1e6);
+
+    EXPECT(estimate->valid && replies.load() == kSyncRounds, "应收到全部回复: %d", replies.load());
+    EXPECT(std::llabs(offsetErrorNs) <= estimate->errorBoundNs,
+           "偏移误差 %lldns 超出误差上界 %lldns", (long long)offsetErrorNs, (long long)estimate->errorBoundNs);
+    EXPECT(estimate->errorBoundNs < 1000000, "误差上界过大: %lldns", (long long)estimate->errorBoundNs);
+    EXPECT(std::fabs(estimate->drift - kDrift) < 50e-6, "漂移估计偏差过大: %.1fppm", estimate->drift * 1e6);
+    EXPECT(estimate->accepted < estimate->samples, "离群样本应被剔除");
+
+    // 接收端时间戳：单向延迟用接收端自己的时钟即可算出
+    for (int i = 0; i < kTouchPackets; ++i) {
+        uint8_t payload[9] = {};
+        sender.submit(PACKET_TYPE_TOUCH, payload, sizeof(payload));
+        std::this_thread::sleep_for(std::chrono::microseconds(500));
+    }
+
+    // 冲刷后关闭 phoneFd；dup 的读 fd 仍持有连接，shutdown 后接收端读到 EOF 退出
+    const uint64_t superseded = sender.stats().superseded;
+    sender.stop();
+    shutdown(phoneReadFd, SHUT_RDWR);
+    receiverThread.join();
+    replyThread.join();
+    close(phoneReadFd);
+    close(receiver.fd);
+
+    std::vector<int64_t> oneWay = receiver.oneWayNs;
+    std::sort(oneWay.begin(), oneWay.end());
+    // 发送线程偶尔被调度延迟时过时的触摸帧被 latest-wins 槽位取代
+    EXPECT(oneWay.size() + superseded == static_cast<size_t>(kTouchPackets), "触摸包数: %zu (取代 %llu)",
+           oneWay.size(), (unsigned long long)superseded);
+    if (!oneWay.empty()) {
+        std::printf("clock sync: one-way latency (receiver clock) min=%lldus p50=%lldus max=%lldus\n",
+                    (long long)oneWay.front() / 1000, (long long)oneWay[oneWay.size() / 2] / 1000,
+                    (long long)oneWay.back() / 1000);
+        EXPECT(oneWay.front() >= -estimate->errorBoundNs, "单向延迟为负: %lldns", (long long)oneWay.front());
+        EXPECT(oneWay.back() < 50000000, "单向延迟过大: %lldns", (long long)oneWay.back());
+    }
+
+    if (g_failures > 0) {
+        std::fprintf(stderr, "%d failure(s)\n", g_failures);
+        return 1;
+    }
+    std::printf("clock sync: OK\n");
+    return 0;
+}
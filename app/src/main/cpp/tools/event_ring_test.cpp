@@ -0,0 +1,222 @@
+/**
+ * 共享内存事件环的 Linux 测试消费者。
+ *
+ * 生产者线程按读取线程的方式写入（每帧若干触摸点 + 偶尔一条区域事件，
+ * 每批 publish 一次，由空变非空时写 eventfd）；消费者线程按 Kotlin
+ * InputEventRingConsumer 的方式读取：读空后发布 readIndex，确认仍为空才 poll eventfd。
+ *
+ * 检查：记录顺序与内容、帧完整性（丢弃只能以整帧为单位）、
+ *       写入数 + 溢出数 == 生产数、没有丢失唤醒（poll 超时即视为失败）。
+ */
+#include "common/event_ring.h"
+#include "test_support.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <thread>
+#include <unistd.h>
+
+namespace {
+
+struct Ring {
+    void* memory = nullptr;
+    size_t bytes = 0;
+    int eventFd = -1;
+    EventRingProducer producer;
+
+    explicit Ring(uint32_t capacity) {
+        bytes = eventRingBytes(capacity);
+        memory = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (memory == MAP_FAILED) {
+            std::perror("mmap");
+            std::exit(2);
+        }
+        eventFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        producer.init(memory, capacity);
+    }
+    ~Ring() {
+        munmap(memory, bytes);
+        close(eventFd);
+    }
+    void wake() {
+        const uint64_t one = 1;
+        ssize_t ret = write(eventFd, &one, sizeof(one));
+        (void)ret;
+    }
+};
+
+/**
+ * @brief 触摸点内容由 (帧号, 点序号) 决定，消费者据此校验
+ */
+int32_t contactX(uint64_t frame, int i) { return static_cast<int32_t>(frame * 7 + i); }
+int32_t contactY(uint64_t frame, int i) { return static_cast<int32_t>(frame * 13 + i * 3); }
+int contactsInFrame(uint64_t frame) { return 1 + static_cast<int>(frame % 5); }
+
+struct ProducerResult {
+    uint64_t produced = 0;
+    uint64_t framesWritten = 0;
+};
+
+void produce(Ring& ring, uint64_t frames, bool slow, ProducerResult& result) {
+    for (uint64_t frame = 0; frame < frames; ++frame) {
+        const int count = contactsInFrame(frame);
+        uint64_t first = 0;
+        result.produced += count;
+        if (ring.producer.reserve(count, first)) {
+            for (int i = 0; i < count; ++i) {
+                EventRingRecord& r = ring.producer.at(first + i);
+                r.kind = EVENT_RING_RECORD_TOUCH_CONTACT;
+                r.flags = (i == count - 1) ? EVENT_RING_FLAG_FRAME_END : 0;
+                r.nameLength = 0;
+                r.id = i;
+                r.x = contactX(frame, i);
+                r.y = contactY(frame, i);
+                r.timestampMs = static_cast<int64_t>(frame);
+            }
+            ++result.framesWritten;
+        }
+        if (frame % 97 == 0) {
+            uint64_t index = 0;
+            result.produced += 1;
+            if (ring.producer.reserve(1, index)) {
+                EventRingRecord& r = ring.producer.at(index);
+                r.kind = EVENT_RING_RECORD_UI_TAP;
+                r.flags = 0;
+                r.nameLength = 3;
+                r.id = -1;
+                r.x = 0;
+                r.y = 0;
+                r.timestampMs = static_cast<int64_t>(frame);
+                r.name[0] = 'b';
+                r.name[1] = 't';
+                r.name[2] = 'n';
+            }
+        }
+        // 每 4 帧发布一次，模拟一次 read() 含多帧
+        if (frame % 4 == 3 && ring.producer.publish()) {
+            ring.wake();
+        }
+        if (slow && frame % 64 == 0) {
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+    }
+    if (ring.producer.publish()) {
+        ring.wake();
+    }
+    ring.producer.close();
+    ring.wake();
+}
+
+struct ConsumerResult {
+    uint64_t consumed = 0;
+    uint64_t frames = 0;
+    uint64_t sleeps = 0;
+};
+
+void consume(Ring& ring, bool slow, ConsumerResult& result) {
+    EventRingHeader* header = static_cast<EventRingHeader*>(ring.memory);
+    EventRingRecord* records = eventRingRecords(header);
+    const uint64_t mask = header->capacity - 1;
+    uint64_t readIndex = 0;
+    int64_t lastFrame = -1;
+    int expectedContact = 0;
+
+    while (true) {
+        const uint64_t writeIndex = event_ring_consumer::available(header);
+        while (readIndex < writeIndex) {
+            const EventRingRecord& r = records[readIndex & mask];
+            if (r.kind == EVENT_RING_RECORD_TOUCH_CONTACT) {
+                const uint64_t frame = static_cast<uint64_t>(r.timestampMs);
+                if (expectedContact == 0) {
+                    EXPECT(static_cast<int64_t>(frame) > lastFrame,
+                        "frame order: %llu after %lld", (unsigned long long)frame, (long long)lastFrame);
+                    lastFrame = static_cast<int64_t>(frame);
+                }
+                EXPECT(static_cast<int64_t>(frame) == lastFrame, "contact from another frame mid-frame");
+                EXPECT(r.id == expectedContact, "contact index %d != %d", r.id, expectedContact);
+                EXPECT(r.x == contactX(frame, r.id) && r.y == contactY(frame, r.id), "contact payload");
+                const bool last = expectedContact == contactsInFrame(frame) - 1;
+                EXPECT(((r.flags & EVENT_RING_FLAG_FRAME_END) != 0) == last, "FRAME_END flag");
+                expectedContact = last ? 0 : expectedContact + 1;
+                if (last) {
+                    ++result.frames;
+                }
+            } else {
+                EXPECT(r.kind == EVENT_RING_RECORD_UI_TAP, "unknown kind %u", r.kind);
+                EXPECT(expectedContact == 0, "ui record inside a frame");
+                EXPECT(r.nameLength == 3 && r.name[0] == 'b' && r.name[2] == 'n', "ui name");
+            }
+            ++readIndex;
+            if (slow && readIndex % 256 == 0) {
+                std::this_thread::sleep_for(std::chrono::microseconds(500));
+            }
+        }
+        if (!event_ring_consumer::releaseAndCheckEmpty(header, readIndex)) {
+            continue;
+        }
+        if (event_ring_consumer::isClosed(header)) {
+            // 关闭前的最后一次发布可能与 isClosed 检查交错，再确认一次
+            if (event_ring_consumer::available(header) == readIndex) {
+                break;
+            }
+            continue;
+        }
+        struct pollfd pfd = {ring.eventFd, POLLIN, 0};
+        ++result.sleeps;
+        const int ready = poll(&pfd, 1, 2000);
+        EXPECT(ready == 1, "lost wakeup: poll timed out at readIndex %llu", (unsigned long long)readIndex);
+        if (ready != 1) {
+            break;
+        }
+        uint64_t counter = 0;
+        ssize_t ret = read(ring.eventFd, &counter, sizeof(counter));
+        (void)ret;
+    }
+    EXPECT(expectedContact == 0, "ring ended mid-frame");
+    result.consumed = readIndex;
+}
+
+void runCase(const char* name, uint32_t capacity, uint64_t frames, bool slowProducer, bool slowConsumer) {
+    Ring ring(capacity);
+    ProducerResult produced;
+    ConsumerResult consumed;
+    std::thread consumer(consume, std::ref(ring), slowConsumer, std::ref(consumed));
+    std::thread producer(produce, std::ref(ring), frames, slowProducer, std::ref(produced));
+    producer.join();
+    consumer.join();
+
+    const EventRingHeader* header = static_cast<const EventRingHeader*>(ring.memory);
+    EXPECT(consumed.consumed == header->writeIndex, "%s: consumed %llu != written %llu", name,
+        (unsigned long long)consumed.consumed, (unsigned long long)header->writeIndex);
+    EXPECT(header->writeIndex + header->overflowCount == produced.produced,
+        "%s: written %llu + overflow %llu != produced %llu", name,
+        (unsigned long long)header->writeIndex, (unsigned long long)header->overflowCount,
+        (unsigned long long)produced.produced);
+    EXPECT(consumed.frames == produced.framesWritten, "%s: frames %llu != %llu", name,
+        (unsigned long long)consumed.frames, (unsigned long long)produced.framesWritten);
+    std::printf("%-16s capacity=%-5u written=%-8llu overflow=%-7llu wakeups=%-6llu sleeps=%llu\n",
+        name, capacity, (unsigned long long)header->writeIndex,
+        (unsigned long long)header->overflowCount, (unsigned long long)header->wakeupCount,
+        (unsigned long long)consumed.sleeps);
+}
+
+} // namespace
+
+int main() {
+    // 消费者足够快：不应溢出，主要检验唤醒协议
+    runCase("fast-consumer", 1024, 20000, true, false);
+    // 消费者慢、环小：必然溢出，检验整帧丢弃与计数
+    runCase("slow-consumer", 64, 20000, true, true);
+    // 双方全速
+    runCase("full-speed", 256, 200000, false, false);
+
+    if (g_failures) {
+        std::fprintf(stderr, "%d failure(s)\n", g_failures);
+        return 1;
+    }
+    std::printf("event ring: OK\n");
+    return 0;
+}
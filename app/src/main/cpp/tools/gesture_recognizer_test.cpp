@@ -0,0 +1,296 @@
+/**
+ * 手势识别器的 Linux 轨迹测试。
+ *
+ * 轨迹为文本，每行一条（# 开头为注释）：
+ *   region <left> <top> <width> <height> <手势名>...   手势名同区域 JSON: doubleTap swipe chord2 chord3 holdDrag
+ *   <ms> down <contact> <x> <y>                       按区域表做命中测试，未命中则忽略
+ *   <ms> move <contact> <x> <y>
+ *   <ms> up <contact>
+ *   <ms> tick                                         只推进时间
+ *   expect <手势>...                                  本轨迹应依次产生的手势，如: doubleTap / swipe:right / chord:2 / dragStart
+ *
+ * 不带参数时运行内置轨迹；带参数时依次运行给定的轨迹文件（例如从设备日志整理出的记录），
+ * 打印识别结果，有 expect 行时同时校验。
+ */
+#include "input/gesture_recognizer.h"
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+const char* directionName(SwipeDirection direction) {
+    switch (direction) {
+        case SwipeDirection::Left: return "left";
+        case SwipeDirection::Right: return "right";
+        case SwipeDirection::Up: return "up";
+        case SwipeDirection::Down: return "down";
+        default: return "none";
+    }
+}
+
+std::string describe(const GestureEvent& event) {
+    switch (event.kind) {
+        case GestureKind::DoubleTap: return "doubleTap";
+        case GestureKind::Swipe: return std::string("swipe:") + directionName(event.direction);
+        case GestureKind::Chord: return "chord:" + std::to_string(event.fingers);
+        case GestureKind::HoldDragStart: return "dragStart";
+        case GestureKind::HoldDragMove: return "dragMove";
+        case GestureKind::HoldDragEnd: return "dragEnd";
+    }
+    return "?";
+}
+
+/**
+ * @brief 运行一条轨迹
+ * @return 与 expect 不一致时返回 false
+ */
+bool runTrace(const std::string& name, std::istream& input) {
+    GestureRecognizer recognizer;
+    std::vector<GestureRegion> regions;
+    std::vector<std::string> expected;
+    bool hasExpect = false;
+    std::vector<RegionGesture> out;
+    std::vector<std::string> produced;
+    bool regionsApplied = false;
+
+    auto collect = [&]() {
+        for (const auto& gesture : out) {
+            const std::string text = describe(gesture.event);
+            std::printf("  [%s] %6lld ms region=%d %-12s at (%d,%d) d=(%d,%d)\n", name.c_str(),
+                gesture.event.timestampMs, gesture.regionIndex, text.c_str(),
+                gesture.event.x, gesture.event.y, gesture.event.dx, gesture.event.dy);
+            produced.push_back(text);
+        }
+        out.clear();
+    };
+    auto advanceTo = [&](long long nowMs) {
+        long long deadline = recognizer.nextDeadlineMs();
+        while (deadline >= 0 && deadline <= nowMs) {
+            recognizer.onTimer(deadline, out);
+            collect();
+            deadline = recognizer.nextDeadlineMs();
+        }
+    };
+
+    std::string line;
+    while (std::getline(input, line)) {
+        std::istringstream fields(line);
+        std::string first;
+        if (!(fields >> first) || first[0] == '#') {
+            continue;
+        }
+        if (first == "region") {
+            GestureRegion region;
+            fields >> region.left >> region.top >> region.width >> region.height;
+            std::string gesture;
+            while (fields >> gesture) {
+                region.gestureMask |= gestureMaskFromName(gesture);
+            }
+            regions.push_back(region);
+            regionsApplied = false;
+            continue;
+        }
+        if (first == "expect") {
+            hasExpect = true;
+            std::string gesture;
+            while (fields >> gesture) {
+                expected.push_back(gesture);
+            }
+            continue;
+        }
+        if (!regionsApplied) {
+            recognizer.setRegions(regions);
+            regionsApplied = true;
+        }
+
+        const long long nowMs = std::stoll(first);
+        std::string op;
+        fields >> op;
+        advanceTo(nowMs);
+        int contact = 0;
+        int x = 0;
+        int y = 0;
+        if (op == "down") {
+            fields >> contact >> x >> y;
+            int hit = -1;
+            for (size_t i = 0; i < regions.size(); ++i) {
+                const GestureRegion& r = regions[i];
+                if (x >= r.left && x < r.left + r.width && y >= r.top && y < r.top + r.height) {
+                    hit = static_cast<int>(i);
+                    break;
+                }
+            }
+            recognizer.onContactDown(contact, hit, x, y, nowMs, out);
+        } else if (op == "move") {
+            fields >> contact >> x >> y;
+            recognizer.onContactMove(contact, x, y, nowMs, out);
+        } else if (op == "up") {
+            fields >> contact;
+            recognizer.onContactUp(contact, nowMs, out);
+        }
+        collect();
+    }
+    advanceTo(1LL << 40);
+
+    if (hasExpect && produced != expected) {
+        std::fprintf(stderr, "FAIL %s: expected", name.c_str());
+        for (const auto& e : expected) std::fprintf(stderr, " %s", e.c_str());
+        std::fprintf(stderr, ", got");
+        for (const auto& p : produced) std::fprintf(stderr, " %s", p.c_str());
+        std::fprintf(stderr, "\n");
+        return false;
+    }
+    return true;
+}
+
+struct BuiltinTrace {
+    const char* name;
+    const char* text;
+};
+
+// 区域 0: (100,100) 200x200
+const BuiltinTrace kBuiltinTraces[] = {
+    {"double-tap", R"(
+region 100 100 200 200 doubleTap
+0 down 0 150 150
+60 up 0
+180 down 0 155 152
+230 up 0
+expect doubleTap
+)"},
+    {"double-tap-too-slow", R"(
+region 100 100 200 200 doubleTap
+0 down 0 150 150
+60 up 0
+400 down 0 150 150
+450 up 0
+expect
+)"},
+    {"triple-tap-once", R"(
+region 100 100 200 200 doubleTap
+0 down 0 150 150
+50 up 0
+120 down 0 150 150
+170 up 0
+240 down 0 150 150
+290 up 0
+expect doubleTap
+)"},
+    {"swipe-right", R"(
+region 100 100 200 200 swipe holdDrag
+0 down 0 250 200
+16 move 0 280 202
+32 move 0 340 205
+48 up 0
+expect swipe:right
+)"},
+    {"swipe-up-once", R"(
+region 100 100 200 200 swipe
+0 down 0 200 120
+16 move 0 200 90
+32 move 0 200 10
+48 move 0 200 -40
+60 up 0
+expect swipe:up
+)"},
+    {"no-swipe-inside", R"(
+region 0 0 1000 1000 swipe
+0 down 0 100 100
+16 move 0 400 100
+32 up 0
+expect
+)"},
+    {"chord-2", R"(
+region 100 100 200 200 chord2
+0 down 0 150 150
+30 down 1 250 150
+200 up 0
+210 up 1
+expect chord:2
+)"},
+    {"chord-2-waits-for-3", R"(
+region 100 100 200 200 chord2 chord3
+0 down 0 150 150
+30 down 1 250 150
+300 up 0
+310 up 1
+expect chord:2
+)"},
+    {"chord-3", R"(
+region 100 100 200 200 chord2 chord3
+0 down 0 150 150
+30 down 1 250 150
+60 down 2 200 250
+300 up 0
+300 up 1
+300 up 2
+expect chord:3
+)"},
+    {"chord-too-slow", R"(
+region 100 100 200 200 chord2
+0 down 0 150 150
+200 down 1 250 150
+300 up 0
+300 up 1
+expect
+)"},
+    {"hold-drag", R"(
+region 100 100 200 200 holdDrag swipe
+0 down 0 200 200
+100 move 0 202 201
+200 move 0 240 200
+216 move 0 300 210
+232 move 0 360 220
+300 up 0
+expect dragStart dragMove dragMove dragEnd
+)"},
+    {"moved-before-hold-is-not-drag", R"(
+region 100 100 200 200 holdDrag
+0 down 0 200 200
+50 move 0 260 200
+200 move 0 290 200
+300 up 0
+expect
+)"},
+    {"no-gesture-region", R"(
+region 100 100 200 200
+0 down 0 150 150
+50 up 0
+100 down 0 150 150
+150 up 0
+expect
+)"},
+};
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int failures = 0;
+    if (argc > 1) {
+        for (int i = 1; i < argc; ++i) {
+            std::ifstream file(argv[i]);
+            if (!file) {
+                std::fprintf(stderr, "无法打开轨迹文件 %s\n", argv[i]);
+                ++failures;
+                continue;
+            }
+            if (!runTrace(argv[i], file)) ++failures;
+        }
+    } else {
+        for (const auto& trace : kBuiltinTraces) {
+            std::istringstream input(trace.text);
+            if (!runTrace(trace.name, input)) ++failures;
+        }
+    }
+    if (failures) {
+        std::fprintf(stderr, "%d trace(s) failed\n", failures);
+        return 1;
+    }
+    std::printf("gesture recognizer: OK\n");
+    return 0;
+}
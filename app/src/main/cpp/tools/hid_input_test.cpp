@@ -0,0 +1,269 @@
+/**
+ * 外接输入设备（手柄、键盘、鼠标）转发测试。
+ *
+ *   1. HidDecoder：手动设置轴范围后喂入事件，校验双向 / 单向轴与方向键的归一化和 flat 死区、
+ *      按键去重与自动重复过滤、相对位移累加、超过单帧上限时的拆帧与标志位、设备移除时的释放帧；
+ *   2. 线协议：按 Kotlin 的 v1 布局构造 HID Payload，经 encodeV2Payload 转换为 V2HidFrame + V2HidChange；
+ *   3. InputEngine：用 uinput 创建一个假手柄，经 setHidInput 打开后校验 ATTACHED 帧、按键 / 摇杆增量、
+ *      内核时间戳，以及销毁设备后的 DETACHED 帧。需要 /dev/uinput，不可用时只跳过这一部分。
+ */
+#include "input/input_engine.h"
+#include "net/packet_codec.h"
+#include "test_support.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <linux/uinput.h>
+#include <string>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+bool feedFrame(HidDecoder& decoder, const std::vector<struct input_event>& events, long long timeUs, HidFrame& out) {
+    for (const auto& ev : events) {
+        decoder.handleEvent(ev);
+    }
+    return decoder.takeFrame(timeUs, out);
+}
+
+bool hasChange(const HidFrame& frame, int index, uint8_t type, uint16_t code, int32_t value) {
+    return index < frame.count && frame.changes[index].type == type && frame.changes[index].code == code
+        && frame.changes[index].value == value;
+}
+
+void testGamepadAxes() {
+    HidDecoder pad;
+    pad.configure(3, HID_CLASS_GAMEPAD);
+    pad.setAxisRange(ABS_X, 0, 255, 15);
+    pad.setAxisRange(ABS_Z, 0, 1023, 0, true);
+    pad.setAxisRange(ABS_HAT0X, -1, 1);
+
+    HidFrame frame;
+    EXPECT(!pad.takeFrame(1000, frame), "空帧产生了输出");
+
+    // 按键在前，轴在后
+    EXPECT(feedFrame(pad, {makeEvent(EV_ABS, ABS_X, 255), makeEvent(EV_KEY, BTN_SOUTH, 1)}, 2000, frame), "没有输出");
+    EXPECT(frame.deviceId == 3 && frame.deviceClass == HID_CLASS_GAMEPAD && frame.flags == 0 && frame.timestampUs == 2000,
+           "帧头 id=%u class=%u flags=%u", frame.deviceId, frame.deviceClass, frame.flags);
+    EXPECT(frame.count == 2 && hasChange(frame, 0, EV_KEY, BTN_SOUTH, 1) && hasChange(frame, 1, EV_ABS, ABS_X, HID_AXIS_MAX),
+           "按键 + 摇杆满偏: count=%d", frame.count);
+
+    // flat 内视为静止：从满偏回到中心输出 0，之后在死区内移动不输出
+    EXPECT(feedFrame(pad, {makeEvent(EV_ABS, ABS_X, 130)}, 3000, frame) && hasChange(frame, 0, EV_ABS, ABS_X, 0),
+           "回到死区没有输出 0");
+    EXPECT(!feedFrame(pad, {makeEvent(EV_ABS, ABS_X, 125)}, 4000, frame), "死区内移动产生了输出");
+    EXPECT(feedFrame(pad, {makeEvent(EV_ABS, ABS_X, 0)}, 5000, frame) && hasChange(frame, 0, EV_ABS, ABS_X, -HID_AXIS_MAX),
+           "摇杆反向满偏 value=%d", frame.count > 0 ? frame.changes[0].value : 0);
+
+    // 扳机：单向 [0, 32767]
+    EXPECT(feedFrame(pad, {makeEvent(EV_ABS, ABS_Z, 1023)}, 6000, frame) && hasChange(frame, 0, EV_ABS, ABS_Z, HID_AXIS_MAX),
+           "扳机按到底");
+    EXPECT(feedFrame(pad, {makeEvent(EV_ABS, ABS_Z, 0)}, 7000, frame) && hasChange(frame, 0, EV_ABS, ABS_Z, 0),
+           "扳机松开");
+
+    // 方向键
+    EXPECT(feedFrame(pad, {makeEvent(EV_ABS, ABS_HAT0X, -1)}, 8000, frame)
+           && hasChange(frame, 0, EV_ABS, ABS_HAT0X, -HID_AXIS_MAX), "方向键左");
+
+    // 自动重复与重复按下不输出；同一帧内按下又抬起按顺序输出
+    EXPECT(!feedFrame(pad, {makeEvent(EV_KEY, BTN_SOUTH, 2)}, 9000, frame), "自动重复产生了输出");
+    EXPECT(!feedFrame(pad, {makeEvent(EV_KEY, BTN_SOUTH, 1)}, 9500, frame), "重复按下产生了输出");
+    EXPECT(feedFrame(pad, {makeEvent(EV_KEY, BTN_EAST, 1), makeEvent(EV_KEY, BTN_EAST, 0)}, 10000, frame)
+           && frame.count == 2 && hasChange(frame, 0, EV_KEY, BTN_EAST, 1) && hasChange(frame, 1, EV_KEY, BTN_EAST, 0),
+           "帧内按下又抬起 count=%d", frame.count);
+
+    // 移除：抬起仍按下的键，偏离静止位置的轴回到 0
+    pad.release();
+    EXPECT(pad.takeFrame(11000, frame), "移除没有输出");
+    EXPECT(frame.flags == HID_FRAME_DETACHED, "移除 flags=0x%x", frame.flags);
+    EXPECT(frame.count == 3 && hasChange(frame, 0, EV_KEY, BTN_SOUTH, 0) && hasChange(frame, 1, EV_ABS, ABS_X, 0)
+           && hasChange(frame, 2, EV_ABS, ABS_HAT0X, 0), "移除帧 count=%d", frame.count);
+    EXPECT(!pad.takeFrame(12000, frame), "移除后仍有输出");
+}
+
+void testMouseAndKeyboard() {
+    HidDecoder mouse;
+    mouse.configure(4, HID_CLASS_MOUSE);
+    HidFrame frame;
+    EXPECT(feedFrame(mouse, {makeEvent(EV_REL, REL_X, 3), makeEvent(EV_REL, REL_WHEEL, -1), makeEvent(EV_REL, REL_X, 4),
+                             makeEvent(EV_KEY, BTN_LEFT, 1)}, 1000, frame), "鼠标没有输出");
+    EXPECT(frame.count == 3 && hasChange(frame, 0, EV_KEY, BTN_LEFT, 1) && hasChange(frame, 1, EV_REL, REL_X, 7)
+           && hasChange(frame, 2, EV_REL, REL_WHEEL, -1), "鼠标帧 count=%d", frame.count);
+    // 相对位移不跨帧累计；互相抵消的位移不输出
+    EXPECT(!feedFrame(mouse, {makeEvent(EV_REL, REL_Y, 5), makeEvent(EV_REL, REL_Y, -5)}, 2000, frame), "抵消的位移产生了输出");
+
+    // 超过单帧上限时拆成多帧，ATTACHED 之类的标志只在第一帧
+    HidDecoder keyboard;
+    keyboard.configure(5, HID_CLASS_KEYBOARD);
+    std::vector<struct input_event> presses;
+    const int keyCount = HID_FRAME_MAX_CHANGES + 6;
+    for (int i = 0; i < keyCount; ++i) {
+        presses.push_back(makeEvent(EV_KEY, static_cast<uint16_t>(KEY_ESC + i), 1));
+    }
+    EXPECT(feedFrame(keyboard, presses, 3000, frame) && frame.count == HID_FRAME_MAX_CHANGES, "第一帧 count=%d", frame.count);
+    EXPECT(hasChange(frame, 0, EV_KEY, KEY_ESC, 1), "第一帧顺序");
+    EXPECT(keyboard.takeFrame(3000, frame) && frame.count == keyCount - HID_FRAME_MAX_CHANGES
+           && hasChange(frame, 0, EV_KEY, static_cast<uint16_t>(KEY_ESC + HID_FRAME_MAX_CHANGES), 1),
+           "第二帧 count=%d", frame.count);
+    EXPECT(!keyboard.takeFrame(3000, frame), "拆帧后仍有输出");
+
+    // 释放时 DETACHED 只在最后一帧
+    keyboard.release();
+    EXPECT(keyboard.takeFrame(4000, frame) && frame.count == HID_FRAME_MAX_CHANGES && frame.flags == 0,
+           "释放第一帧 flags=0x%x", frame.flags);
+    EXPECT(keyboard.takeFrame(4000, frame) && frame.count == keyCount - HID_FRAME_MAX_CHANGES
+           && frame.flags == HID_FRAME_DETACHED, "释放最后一帧 flags=0x%x", frame.flags);
+
+    // SYN_DROPPED：无法查询内核状态时保留当前状态
+    keyboard.onSyncDropped();
+    EXPECT(keyboard.syncDropped(), "SYN_DROPPED 未记录");
+    EXPECT(!keyboard.resync(-1, HID_FRAME_RESYNC) && !keyboard.syncDropped(), "无效 fd 的重新同步");
+}
+
+void testCodec() {
+    // Kotlin sendNativeHidFrame 的 v1 布局
+    std::vector<uint8_t> v1(V1_HID_HEADER_SIZE + 2 * V1_HID_CHANGE_SIZE, 0);
+    const int64_t timeUs = 987654321012LL;
+    std::memcpy(v1.data(), &timeUs, 8);
+    v1[8] = 7;
+    v1[9] = HID_CLASS_GAMEPAD;
+    v1[10] = HID_FRAME_ATTACHED;
+    v1[11] = 2;
+    const uint16_t codes[2] = {BTN_SOUTH, ABS_RY};
+    const int32_t values[2] = {1, -12345};
+    for (int i = 0; i < 2; ++i) {
+        uint8_t* change = v1.data() + V1_HID_HEADER_SIZE + i * V1_HID_CHANGE_SIZE;
+        change[0] = i == 0 ? EV_KEY : EV_ABS;
+        std::memcpy(change + 2, &codes[i], 2);
+        std::memcpy(change + 4, &values[i], 4);
+    }
+    const long size = v2PayloadSize(PACKET_TYPE_HID, v1.data(), v1.size());
+    EXPECT(size == static_cast<long>(sizeof(V2HidFrame) + 2 * sizeof(V2HidChange)), "v2 长度 %ld", size);
+    EXPECT(v2PayloadSize(PACKET_TYPE_HID, v1.data(), v1.size() - 1) == -1, "长度与 Count 不符未被拒绝");
+    if (size <= 0) {
+        return;
+    }
+    std::vector<uint8_t> out(static_cast<size_t>(size));
+    encodeV2Payload(PACKET_TYPE_HID, v1.data(), v1.size(), out.data(), out.size());
+    V2HidFrame frame;
+    std::memcpy(&frame, out.data(), sizeof(frame));
+    EXPECT(frame.eventTimeUs == timeUs && frame.deviceId == 7 && frame.deviceClass == HID_CLASS_GAMEPAD
+           && frame.flags == HID_FRAME_ATTACHED && frame.count == 2, "v2 帧头");
+    for (int i = 0; i < 2; ++i) {
+        V2HidChange change;
+        std::memcpy(&change, out.data() + sizeof(frame) + i * sizeof(change), sizeof(change));
+        EXPECT(change.type == (i == 0 ? EV_KEY : EV_ABS) && change.code == codes[i] && change.value == values[i],
+               "v2 变化 %d: type=%u code=%u value=%d", i, change.type, change.code, change.value);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// 经 uinput 假手柄驱动引擎
+// ---------------------------------------------------------------------------
+
+int createFakeGamepad(std::string& sysName) {
+    const int fd = open("/dev/uinput", O_WRONLY | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0) {
+        return -1;
+    }
+    ioctl(fd, UI_SET_EVBIT, EV_SYN);
+    ioctl(fd, UI_SET_EVBIT, EV_KEY);
+    ioctl(fd, UI_SET_EVBIT, EV_ABS);
+    ioctl(fd, UI_SET_KEYBIT, BTN_SOUTH);
+    ioctl(fd, UI_SET_KEYBIT, BTN_EAST);
+    struct uinput_abs_setup abs;
+    std::memset(&abs, 0, sizeof(abs));
+    abs.code = ABS_X;
+    abs.absinfo.minimum = -32768;
+    abs.absinfo.maximum = 32767;
+    abs.absinfo.flat = 128;
+    ioctl(fd, UI_SET_ABSBIT, ABS_X);
+    ioctl(fd, UI_ABS_SETUP, &abs);
+
+    struct uinput_setup setup;
+    std::memset(&setup, 0, sizeof(setup));
+    setup.id.bustype = BUS_VIRTUAL;
+    std::snprintf(setup.name, sizeof(setup.name), "hid_input_test gamepad");
+    char name[64] = {};
+    if (ioctl(fd, UI_DEV_SETUP, &setup) != 0 || ioctl(fd, UI_DEV_CREATE) != 0
+        || ioctl(fd, UI_GET_SYSNAME(sizeof(name)), name) < 0) {
+        close(fd);
+        return -1;
+    }
+    sysName = name;
+    return fd;
+}
+
+void emit(int fd, uint16_t type, uint16_t code, int32_t value) {
+    struct input_event ev = {};
+    ev.type = type;
+    ev.code = code;
+    ev.value = value;
+    ssize_t ret = write(fd, &ev, sizeof(ev));
+    (void)ret;
+}
+
+void testEngine() {
+    std::string sysName;
+    const int uinputFd = createFakeGamepad(sysName);
+    if (uinputFd < 0) {
+        std::printf("hid_input_test: /dev/uinput 不可用 (%s)，跳过引擎部分\n", std::strerror(errno));
+        return;
+    }
+    const std::string node = findEventNode(sysName);
+    if (node.empty()) {
+        std::printf("hid_input_test: 无法打开 %s 的 evdev 节点，跳过引擎部分\n", sysName.c_str());
+        ioctl(uinputFd, UI_DEV_DESTROY);
+        close(uinputFd);
+        return;
+    }
+
+    auto sink = std::make_shared<RecordingSink>();
+    InputEngine engine;
+    HidInputConfig hid;
+    hid.enabled = true;
+    hid.devicePaths.push_back(node);
+    engine.setHidInput(hid);
+    engine.start(std::string(), sink);
+    EXPECT(waitFor([&] { return !sink->hidFrames().empty(); }), "没有 ATTACHED 帧");
+
+    emit(uinputFd, EV_KEY, BTN_SOUTH, 1);
+    emit(uinputFd, EV_ABS, ABS_X, 32767);
+    emit(uinputFd, EV_SYN, SYN_REPORT, 0);
+    EXPECT(waitFor([&] { return sink->hidFrames().size() >= 2; }), "没有按键帧");
+
+    ioctl(uinputFd, UI_DEV_DESTROY);
+    close(uinputFd);
+    EXPECT(waitFor([&] { return sink->hidFrames().size() >= 3; }), "没有 DETACHED 帧");
+    engine.stop();
+
+    const auto frames = sink->hidFrames();
+    if (frames.size() < 3) {
+        return;
+    }
+    EXPECT(frames[0].flags == HID_FRAME_ATTACHED && frames[0].deviceClass == HID_CLASS_GAMEPAD && frames[0].count == 0,
+           "ATTACHED 帧 flags=0x%x class=0x%x count=%d", frames[0].flags, frames[0].deviceClass, frames[0].count);
+    EXPECT(frames[1].flags == 0 && frames[1].count == 2 && hasChange(frames[1], 0, EV_KEY, BTN_SOUTH, 1)
+           && hasChange(frames[1], 1, EV_ABS, ABS_X, HID_AXIS_MAX), "按键帧 count=%d", frames[1].count);
+    EXPECT(frames[1].timestampUs > 0 && frames[1].deviceId == frames[0].deviceId, "按键帧时间戳 / 编号");
+    EXPECT(frames[2].flags == HID_FRAME_DETACHED && frames[2].count == 2 && hasChange(frames[2], 0, EV_KEY, BTN_SOUTH, 0)
+           && hasChange(frames[2], 1, EV_ABS, ABS_X, 0), "DETACHED 帧 flags=0x%x count=%d", frames[2].flags, frames[2].count);
+}
+
+} // namespace
+
+int main() {
+    testGamepadAxes();
+    testMouseAndKeyboard();
+    testCodec();
+    testEngine();
+    if (g_failures != 0) {
+        std::fprintf(stderr, "%d failure(s)\n", g_failures);
+        return 1;
+    }
+    std::printf("hid_input_test: OK\n");
+    return 0;
+}
@@ -0,0 +1,42 @@
+#ifndef HOST_ANDROID_LOG_H
+#define HOST_ANDROID_LOG_H
+
+/**
+ * 主机构建用的 <android/log.h> 替身：WARN 及以上级别写到 stderr，其余丢弃。
+ * 只供 tools/ 下的测试编译设备端源文件使用，不参与 Android 构建。
+ */
+
+#include <cstdarg>
+#include <cstdio>
+
+enum {
+    ANDROID_LOG_UNKNOWN = 0,
+    ANDROID_LOG_DEFAULT,
+    ANDROID_LOG_VERBOSE,
+    ANDROID_LOG_DEBUG,
+    ANDROID_LOG_INFO,
+    ANDROID_LOG_WARN,
+    ANDROID_LOG_ERROR,
+    ANDROID_LOG_FATAL,
+    ANDROID_LOG_SILENT,
+};
+
+__attribute__((format(printf, 3, 4)))
+static inline int __android_log_print(int prio, const char* tag, const char* fmt, ...) {
+    if (prio < ANDROID_LOG_WARN) {
+        return 0;
+    }
+    std::fprintf(stderr, "[%s] ", tag);
+    va_list args;
+    va_start(args, fmt);
+    const int written = std::vfprintf(stderr, fmt, args);
+    va_end(args);
+    std::fputc('\n', stderr);
+    return written;
+}
+
+static inline int __android_log_write(int prio, const char* tag, const char* text) {
+    return __android_log_print(prio, tag, "%s", text);
+}
+
+#endif // HOST_ANDROID_LOG_H
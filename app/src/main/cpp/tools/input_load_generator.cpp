@@ -0,0 +1,666 @@
+/**
+ * 合成多点触控负载：按给定手指数、报告率与运动模式生成协议 B evdev 流，驱动 InputEngine 的读取循环，
+ * 同时可以按满速率提交陀螺仪包，测量最坏情况下的 CPU、内存分配与丢帧。
+ *
+ *   input_load_generator [--fingers N] [--rate Hz] [--seconds S] [--pattern circle|swipe|jitter]
+ *                        [--churn-ms MS] [--drop-every N] [--gyro-hz Hz] [--ring N] [--queue N]
+ *                        [--fifo PRIO] [--uinput]
+ *
+ * 输入源：默认经管道交给 setDeviceFd（进程内，与回放同一入口）；--uinput 写入 uinput 假触摸屏，
+ *        引擎按路径打开 evdev 节点（无 /dev/uinput 时返回 77）。
+ * 负载：
+ *   - 每根手指按模式移动（circle 绕圈 / swipe 横扫并回绕 / jitter 近乎静止的小幅抖动），附带压力与接触尺寸；
+ *   - 每根手指每 churn-ms 抬起一次并在下一帧以新的 tracking ID 按下，落到编号最小的空闲 slot（slot 复用）；
+ *   - 管道源每 drop-every 帧插入一次 SYN_DROPPED（该帧只含坐标，引擎丢弃后重新同步；
+ *     uinput 不转发 SYN_DROPPED，此时只有引擎读得太慢时才会由内核产生）；
+ *   - 输出：RingInputEventSink -> 消费线程按 v1 TOUCH 打包 -> PacketSender -> socketpair；
+ *     陀螺仪线程以 gyro-hz 向同一个发送器提交 GYRO 包，与触摸共享发送线程与队列。
+ * 报告（预热 200ms 之后的稳态区间）：
+ *   读取线程 CPU（每事件 / 每帧）、消费线程与整个进程的 CPU、读取线程上的 operator new 次数、
+ *   内核事件时间 -> read 完成的唤醒延迟，以及丢帧：SYN_DROPPED 丢弃的帧、事件环溢出、发送队列丢弃。
+ * --fifo 对读取与发送线程请求 SCHED_FIFO（需要权限），--ring / --queue 调整事件环与发送队列容量，
+ * 用于确定线程优先级与缓冲区大小。
+ *
+ * 不带参数时以 10 指 480Hz + 1kHz 陀螺仪运行 2 秒并校验：稳态下读取线程不分配内存、
+ * 引擎输出的帧数与写入帧数减去 SYN_DROPPED 丢弃的帧数一致、事件环与发送队列无丢弃。
+ */
+#include "common/event_ring.h"
+#include "common/thread_config.h"
+#include "input/input_engine.h"
+#include "input/ring_event_sink.h"
+#include "net/packet_sender.h"
+#include "test_support.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <linux/uinput.h>
+#include <memory>
+#include <new>
+#include <poll.h>
+#include <pthread.h>
+#include <string>
+#include <sys/ioctl.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+// 每个线程上的 operator new 次数；读取线程在 onReaderThreadStart 中标记自己
+std::atomic<uint64_t> g_allocations{0};
+std::atomic<uint64_t> g_readerAllocations{0};
+thread_local bool t_isReaderThread = false;
+
+} // namespace
+
+void* operator new(size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (t_isReaderThread) {
+        g_readerAllocations.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+
+namespace {
+
+constexpr int kSkip = 77;
+constexpr int kSlots = 10;
+constexpr int kMaxX = 1079;
+constexpr int kMaxY = 2399;
+constexpr int kMaxPressure = 255;
+constexpr int kMaxTouchMajor = 63;
+constexpr int64_t kWarmupNs = 200000000LL;
+constexpr size_t kGyroPayloadSize = 28;
+
+enum class MotionPattern {
+    Circle,
+    Swipe,
+    Jitter,
+};
+
+struct Options {
+    int fingers = 10;
+    double rateHz = 480.0;
+    double seconds = 2.0;
+    MotionPattern pattern = MotionPattern::Circle;
+    int churnMs = 300;         // 0 表示手指不抬起
+    int dropEvery = 500;       // 0 表示不插入 SYN_DROPPED
+    double gyroHz = 1000.0;    // 0 表示不提交陀螺仪包
+    uint32_t ringCapacity = 4096;
+    size_t queueCapacity = 0;  // 0 使用 PacketSenderConfig 默认值
+    int fifoPriority = 0;
+    bool uinput = false;
+};
+
+int64_t threadCpuNs(clockid_t clock) {
+    struct timespec ts;
+    if (clock_gettime(clock, &ts) != 0) {
+        return 0;
+    }
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+int64_t processCpuNs() {
+    return threadCpuNs(CLOCK_PROCESS_CPUTIME_ID);
+}
+
+// ---------------------------------------------------------------------------
+// 负载生成
+// ---------------------------------------------------------------------------
+
+/**
+ * @brief 协议 B 事件流生成器：每帧移动所有手指，按周期抬起 / 以新 tracking ID 重新按下
+ */
+class MultitouchGenerator {
+public:
+    explicit MultitouchGenerator(const Options& options) : options_(options), rng_(12345) {
+        for (int f = 0; f < options_.fingers; ++f) {
+            fingers_[f].phase = 2.0 * M_PI * f / options_.fingers;
+            // 错开各手指的抬起时刻，避免所有手指同一帧抬起
+            fingers_[f].nextChurnUs = options_.churnMs > 0
+                ? static_cast<int64_t>(options_.churnMs) * 1000 * (f + 1) / options_.fingers : INT64_MAX;
+        }
+    }
+
+    /**
+     * @brief 生成一帧
+     * @param dropFrame 本帧前插入 SYN_DROPPED；本帧不改变 tracking 状态，只含坐标
+     * @return 本帧结束时按下的手指数
+     */
+    int next(int64_t elapsedUs, bool dropFrame, std::vector<input_event>& out) {
+        out.clear();
+        if (dropFrame) {
+            push(out, EV_SYN, SYN_DROPPED, 0);
+        }
+        const double t = elapsedUs / 1e6;
+        int down = 0;
+        for (int f = 0; f < options_.fingers; ++f) {
+            Finger& finger = fingers_[f];
+            if (!dropFrame && finger.slot >= 0 && elapsedUs >= finger.nextChurnUs) {
+                push(out, EV_ABS, ABS_MT_SLOT, finger.slot);
+                push(out, EV_ABS, ABS_MT_TRACKING_ID, -1);
+                slotUsed_[finger.slot] = false;
+                finger.slot = -1;
+                finger.nextChurnUs += static_cast<int64_t>(options_.churnMs) * 1000;
+                continue; // 下一帧重新按下
+            }
+            if (finger.slot < 0) {
+                if (dropFrame) continue;
+                finger.slot = lowestFreeSlot();
+                slotUsed_[finger.slot] = true;
+                push(out, EV_ABS, ABS_MT_SLOT, finger.slot);
+                push(out, EV_ABS, ABS_MT_TRACKING_ID, nextTrackingId_);
+                nextTrackingId_ = (nextTrackingId_ + 1) & 0xFFFF;
+            } else {
+                push(out, EV_ABS, ABS_MT_SLOT, finger.slot);
+            }
+            int x = 0;
+            int y = 0;
+            position(f, t, x, y);
+            push(out, EV_ABS, ABS_MT_POSITION_X, x);
+            push(out, EV_ABS, ABS_MT_POSITION_Y, y);
+            push(out, EV_ABS, ABS_MT_PRESSURE, 80 + static_cast<int>(rng_() % 60));
+            push(out, EV_ABS, ABS_MT_TOUCH_MAJOR, 8 + static_cast<int>(rng_() % 6));
+            ++down;
+        }
+        push(out, EV_KEY, BTN_TOUCH, down > 0 ? 1 : 0);
+        push(out, EV_SYN, SYN_REPORT, 0);
+        return down;
+    }
+
+private:
+    struct Finger {
+        int slot = -1;
+        double phase = 0;
+        int64_t nextChurnUs = 0;
+    };
+
+    static void push(std::vector<input_event>& out, int type, int code, int value) {
+        input_event ev;
+        std::memset(&ev, 0, sizeof(ev));
+        ev.type = static_cast<__u16>(type);
+        ev.code = static_cast<__u16>(code);
+        ev.value = value;
+        out.push_back(ev);
+    }
+
+    int lowestFreeSlot() const {
+        for (int s = 0; s < kSlots; ++s) {
+            if (!slotUsed_[s]) return s;
+        }
+        return kSlots - 1;
+    }
+
+    void position(int f, double t, int& x, int& y) {
+        const double phase = fingers_[f].phase;
+        switch (options_.pattern) {
+            case MotionPattern::Circle: {
+                const double cx = kMaxX * (0.25 + 0.5 * (f % 2));
+                const double cy = kMaxY * (0.1 + 0.16 * (f / 2));
+                x = static_cast<int>(cx + 120 * std::cos(2 * M_PI * 1.5 * t + phase));
+                y = static_cast<int>(cy + 120 * std::sin(2 * M_PI * 1.5 * t + phase));
+                break;
+            }
+            case MotionPattern::Swipe: {
+                // 约 3000 单位 / 秒横扫，到边后回绕
+                const double span = kMaxY - 200;
+                x = kMaxX * (f + 1) / (options_.fingers + 1);
+                y = 100 + static_cast<int>(std::fmod(3000 * t + span * phase / (2 * M_PI), span));
+                break;
+            }
+            case MotionPattern::Jitter: {
+                x = kMaxX * (f + 1) / (options_.fingers + 1) + static_cast<int>(rng_() % 5) - 2;
+                y = kMaxY / 2 + static_cast<int>(rng_() % 5) - 2;
+                break;
+            }
+        }
+        x = std::max(0, std::min(kMaxX, x));
+        y = std::max(0, std::min(kMaxY, y));
+    }
+
+    Options options_;
+    struct XorShift {
+        explicit XorShift(uint32_t seed) : state(seed) {}
+        uint32_t operator()() {
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            return state;
+        }
+        uint32_t state;
+    } rng_;
+    Finger fingers_[kSlots];
+    bool slotUsed_[kSlots] = {};
+    int nextTrackingId_ = 1;
+};
+
+// ---------------------------------------------------------------------------
+// 输出侧
+// ---------------------------------------------------------------------------
+
+/**
+ * @brief 事件环输出，额外在读取线程启动时记下它的 CPU 时钟并标记分配计数
+ */
+class MeasuredRingSink : public RingInputEventSink {
+public:
+    bool onReaderThreadStart() override {
+        t_isReaderThread = true;
+        clockid_t clock;
+        if (pthread_getcpuclockid(pthread_self(), &clock) == 0) {
+            readerClock_.store(static_cast<int>(clock), std::memory_order_release);
+        }
+        return true;
+    }
+
+    void onReaderThreadStop() override {
+        t_isReaderThread = false;
+    }
+
+    /**
+     * @return 读取线程的 CPU 时钟，尚未启动时返回 false
+     */
+    bool readerClock(clockid_t& out) const {
+        const int clock = readerClock_.load(std::memory_order_acquire);
+        if (clock == kNoClock) return false;
+        out = static_cast<clockid_t>(clock);
+        return true;
+    }
+
+private:
+    static constexpr int kNoClock = 0x7FFFFFFF;
+    std::atomic<int> readerClock_{kNoClock};
+};
+
+/**
+ * @brief 消费事件环，把每帧按 v1 TOUCH Payload 交给发送器
+ */
+class RingDrain {
+public:
+    RingDrain(std::shared_ptr<MeasuredRingSink> ring, PacketSender& sender)
+        : ring_(std::move(ring)), sender_(sender) {}
+
+    void run() {
+        clockid_t clock;
+        pthread_getcpuclockid(pthread_self(), &clock);
+        cpuClock_.store(static_cast<int>(clock), std::memory_order_release);
+
+        EventRingHeader* header = const_cast<EventRingHeader*>(ring_->header());
+        EventRingRecord* records = eventRingRecords(header);
+        const uint64_t mask = header->capacity - 1;
+        uint64_t readIndex = 0;
+        uint8_t payload[9 + TOUCH_SLOT_LIMIT * 12];
+        size_t length = 9;
+        for (;;) {
+            const int64_t writeIndex = ring_->await(readIndex, 500);
+            if (writeIndex < 0) {
+                break;
+            }
+            while (readIndex < static_cast<uint64_t>(writeIndex)) {
+                const EventRingRecord& record = records[readIndex++ & mask];
+                if (record.kind != EVENT_RING_RECORD_TOUCH_CONTACT) {
+                    continue;
+                }
+                if (length + 12 <= sizeof(payload)) {
+                    std::memcpy(payload + length, &record.id, 4);
+                    std::memcpy(payload + length + 4, &record.x, 4);
+                    std::memcpy(payload + length + 8, &record.y, 4);
+                    length += 12;
+                }
+                if (record.flags & EVENT_RING_FLAG_FRAME_END) {
+                    std::memcpy(payload, &record.timestampMs, 8);
+                    payload[8] = static_cast<uint8_t>((length - 9) / 12);
+                    sender_.submit(PACKET_TYPE_TOUCH, payload, length);
+                    frames_.fetch_add(1, std::memory_order_relaxed);
+                    length = 9;
+                }
+            }
+        }
+    }
+
+    uint64_t frames() const { return frames_.load(std::memory_order_relaxed); }
+    int64_t cpuNs() const {
+        return threadCpuNs(static_cast<clockid_t>(cpuClock_.load(std::memory_order_acquire)));
+    }
+
+private:
+    std::shared_ptr<MeasuredRingSink> ring_;
+    PacketSender& sender_;
+    std::atomic<uint64_t> frames_{0};
+    std::atomic<int> cpuClock_{0};
+};
+
+/**
+ * @brief 按 gyroHz 提交 GYRO 包，Payload 与 Kotlin 层一致（BigEndian：时间戳 + 保留 + 3 个 float）
+ */
+void gyroLoop(PacketSender& sender, double gyroHz, const std::atomic<bool>& running, uint64_t& submitted) {
+    const int64_t periodNs = static_cast<int64_t>(1e9 / gyroHz);
+    const int64_t startNs = monotonicNowNs();
+    uint8_t payload[kGyroPayloadSize] = {};
+    for (int64_t i = 0; running.load(std::memory_order_acquire); ++i) {
+        sleepUntilMonotonicNs(startNs + i * periodNs);
+        const uint64_t timestampMs = static_cast<uint64_t>(realtimeNowUs() / 1000);
+        for (int b = 0; b < 8; ++b) payload[b] = static_cast<uint8_t>(timestampMs >> (56 - 8 * b));
+        for (int axis = 0; axis < 3; ++axis) {
+            const float value = 0.01f * std::sin(0.001f * i + axis);
+            uint32_t bits;
+            std::memcpy(&bits, &value, 4);
+            for (int b = 0; b < 4; ++b) payload[16 + axis * 4 + b] = static_cast<uint8_t>(bits >> (24 - 8 * b));
+        }
+        sender.submit(PACKET_TYPE_GYRO, payload, sizeof(payload));
+        ++submitted;
+    }
+}
+
+// ---------------------------------------------------------------------------
+
+struct Snapshot {
+    int64_t wallNs = 0;
+    int64_t readerCpuNs = 0;
+    int64_t drainCpuNs = 0;
+    int64_t processCpuNs = 0;
+    uint64_t readerAllocations = 0;
+    uint64_t allocations = 0;
+    uint64_t events = 0;
+    uint64_t frames = 0;
+};
+
+int run(const Options& options) {
+    if (options.fifoPriority > 0) {
+        ThreadConfig config;
+        config.policy = ThreadSchedPolicy::Fifo;
+        config.rtPriority = options.fifoPriority;
+        setThreadConfig(ThreadRole::InputReader, config);
+        setThreadConfig(ThreadRole::PacketSender, config);
+    }
+
+    std::string node;
+    int writeFd = -1;
+    int uinputFd = -1;
+    int pipeRead = -1;
+    if (options.uinput) {
+        std::string sysName;
+        uinputFd = createFakeTouchscreen(
+            {"load-generator touchscreen", 0x567A, kSlots, kMaxX, kMaxY, kMaxPressure, kMaxTouchMajor}, sysName);
+        node = uinputFd >= 0 ? findEventNode(sysName) : std::string();
+        if (node.empty() && uinputFd >= 0) {
+            ioctl(uinputFd, UI_DEV_DESTROY);
+            close(uinputFd);
+            uinputFd = -1;
+        }
+        if (uinputFd < 0) {
+            std::printf("load: 无法创建 uinput 假触摸屏，跳过\n");
+            return kSkip;
+        }
+        writeFd = uinputFd;
+    } else {
+        int fds[2];
+        if (pipe2(fds, O_CLOEXEC) != 0) {
+            std::fprintf(stderr, "pipe2: %s\n", strerror(errno));
+            return 1;
+        }
+        fcntl(fds[0], F_SETFL, fcntl(fds[0], F_GETFL) | O_NONBLOCK);
+        // 管道容量决定写端能领先读取线程多少，取与 evdev 客户端缓冲区相近的量级
+        fcntl(fds[1], F_SETPIPE_SZ, 64 * 1024);
+        pipeRead = fds[0];
+        writeFd = fds[1];
+    }
+
+    int socketFds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, socketFds) != 0) {
+        std::printf("load: socketpair 不可用，跳过\n");
+        return kSkip;
+    }
+    std::atomic<uint64_t> transportBytes{0};
+    std::thread transportReader([&]() {
+        static uint8_t buffer[64 * 1024];
+        ssize_t n;
+        while ((n = recv(socketFds[1], buffer, sizeof(buffer), 0)) > 0) {
+            transportBytes.fetch_add(static_cast<uint64_t>(n), std::memory_order_relaxed);
+        }
+    });
+
+    PacketSenderConfig config;
+    if (options.queueCapacity > 0) {
+        config.maxPendingPackets = options.queueCapacity;
+    }
+    PacketSender sender;
+    sender.start(socketFds[0], config);
+
+    auto ring = std::make_shared<MeasuredRingSink>();
+    if (!ring->create(options.ringCapacity)) {
+        std::fprintf(stderr, "事件环创建失败\n");
+        return 1;
+    }
+    RingDrain drain(ring, sender);
+    std::thread drainThread(&RingDrain::run, &drain);
+
+    InputEngine engine;
+    engine.setScreenDimensions(kMaxY, kMaxX);
+    engine.setJitterMeasurement(true);
+    if (options.uinput) {
+        engine.start(node, ring);
+        for (int i = 0; i < 200 && engine.startupOpenUs() < 0; ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    } else {
+        engine.start(std::string(), ring);
+        engine.setDeviceFd(pipeRead, kMaxX, kMaxY);
+    }
+    clockid_t readerClock;
+    for (int i = 0; i < 200 && !ring->readerClock(readerClock); ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    if (!ring->readerClock(readerClock)) {
+        std::fprintf(stderr, "读取线程未启动\n");
+        return 1;
+    }
+
+    std::atomic<bool> gyroRunning{true};
+    uint64_t gyroSubmitted = 0;
+    std::thread gyroThread;
+    if (options.gyroHz > 0) {
+        gyroThread = std::thread(gyroLoop, std::ref(sender), options.gyroHz, std::cref(gyroRunning),
+                                 std::ref(gyroSubmitted));
+    }
+
+    // ---- 写入负载 ----
+    MultitouchGenerator generator(options);
+    std::vector<input_event> frame;
+    frame.reserve(kSlots * 8 + 4);
+    const int64_t periodNs = static_cast<int64_t>(1e9 / options.rateHz);
+    const int64_t totalFrames = static_cast<int64_t>(options.seconds * options.rateHz);
+    const int64_t startNs = monotonicNowNs();
+    Snapshot begin;
+    bool haveBegin = false;
+    uint64_t events = 0;
+    uint64_t framesWritten = 0;    // 至少有一根手指按下的帧
+    uint64_t framesDropped = 0;    // 因 SYN_DROPPED 被引擎丢弃的帧
+    uint64_t framesBehind = 0;     // 写入时已落后于计划时刻一个周期以上的帧
+    auto snapshot = [&](Snapshot& s) {
+        s.wallNs = monotonicNowNs();
+        s.readerCpuNs = threadCpuNs(readerClock);
+        s.drainCpuNs = drain.cpuNs();
+        s.processCpuNs = processCpuNs();
+        s.readerAllocations = g_readerAllocations.load(std::memory_order_relaxed);
+        s.allocations = g_allocations.load(std::memory_order_relaxed);
+        s.events = events;
+        s.frames = framesWritten;
+    };
+    for (int64_t i = 0; i < totalFrames; ++i) {
+        const int64_t targetNs = startNs + i * periodNs;
+        const int64_t nowNs = monotonicNowNs();
+        if (nowNs < targetNs) {
+            sleepUntilMonotonicNs(targetNs);
+        } else if (nowNs - targetNs > periodNs) {
+            ++framesBehind;
+        }
+        if (!haveBegin && monotonicNowNs() - startNs >= kWarmupNs) {
+            snapshot(begin);
+            haveBegin = true;
+        }
+        const bool dropFrame = !options.uinput && options.dropEvery > 0 && i > 0 && i % options.dropEvery == 0;
+        const int down = generator.next((monotonicNowNs() - startNs) / 1000, dropFrame, frame);
+        if (!options.uinput) {
+            const int64_t eventUs = realtimeNowUs();
+            for (auto& ev : frame) {
+                ev.time.tv_sec = static_cast<decltype(ev.time.tv_sec)>(eventUs / 1000000);
+                ev.time.tv_usec = static_cast<decltype(ev.time.tv_usec)>(eventUs % 1000000);
+            }
+        }
+        if (!writeAll(writeFd, frame.data(), frame.size() * sizeof(input_event))) {
+            std::fprintf(stderr, "写入失败: %s\n", strerror(errno));
+            break;
+        }
+        events += frame.size();
+        if (down > 0) {
+            ++framesWritten;
+            if (dropFrame) ++framesDropped;
+        }
+    }
+
+    // 等读取线程与消费线程追上后取稳态区间的终点
+    for (int i = 0; i < 100 && drain.frames() + framesDropped < framesWritten; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    Snapshot end;
+    snapshot(end);
+
+    gyroRunning.store(false, std::memory_order_release);
+    if (gyroThread.joinable()) gyroThread.join();
+    engine.stop();
+    ring->close();
+    drainThread.join();
+    const PacketSenderStats senderStats = sender.stats();
+    sender.stop();
+    shutdown(socketFds[1], SHUT_RDWR);
+    transportReader.join();
+    close(socketFds[1]);
+    if (options.uinput) {
+        ioctl(uinputFd, UI_DEV_DESTROY);
+        close(uinputFd);
+    } else {
+        close(writeFd);
+    }
+
+    // ---- 报告 ----
+    if (!haveBegin) {
+        begin = Snapshot();
+    }
+    const double windowS = (end.wallNs - begin.wallNs) / 1e9;
+    const uint64_t windowEvents = end.events - begin.events;
+    const uint64_t windowFrames = end.frames - begin.frames;
+    const char* patterns[] = {"circle", "swipe", "jitter"};
+    std::printf("load [%s]: %d 指 %.0fHz %s, churn=%dms, SYN_DROPPED 每 %d 帧, 陀螺仪 %.0fHz, 环 %u, 队列 %zu\n",
+                options.uinput ? "uinput" : "pipe", options.fingers, options.rateHz,
+                patterns[static_cast<int>(options.pattern)], options.churnMs, options.dropEvery, options.gyroHz,
+                options.ringCapacity, options.queueCapacity ? options.queueCapacity : config.maxPendingPackets);
+    std::printf("  稳态 %.2fs: %llu 事件 / %llu 帧（%.0f 事件/s），写入落后计划 %llu 帧\n",
+                windowS, (unsigned long long)windowEvents, (unsigned long long)windowFrames,
+                windowS > 0 ? windowEvents / windowS : 0.0, (unsigned long long)framesBehind);
+    const double readerCpuUs = (end.readerCpuNs - begin.readerCpuNs) / 1e3;
+    std::printf("  CPU    读取线程 %.3fus/事件 %.2fus/帧 (%.1f%% 核), 消费线程 %.2fus/帧, 进程 %.1f%% 核\n",
+                windowEvents ? readerCpuUs / windowEvents : 0.0, windowFrames ? readerCpuUs / windowFrames : 0.0,
+                windowS > 0 ? readerCpuUs / 1e4 / windowS : 0.0,
+                windowFrames ? (end.drainCpuNs - begin.drainCpuNs) / 1e3 / windowFrames : 0.0,
+                windowS > 0 ? (end.processCpuNs - begin.processCpuNs) / 1e7 / windowS : 0.0);
+    std::printf("  分配   读取线程 %llu 次, 全进程 %llu 次（稳态区间）\n",
+                (unsigned long long)(end.readerAllocations - begin.readerAllocations),
+                (unsigned long long)(end.allocations - begin.allocations));
+    const LatencyHistogram& wakeup = engine.wakeupLatency();
+    std::printf("  唤醒   事件时间 -> read 完成 p50=%lluus p99=%lluus max=%lluus（%llu 次）\n",
+                (unsigned long long)wakeup.percentileUs(50), (unsigned long long)wakeup.percentileUs(99),
+                (unsigned long long)wakeup.maxUs(), (unsigned long long)wakeup.count());
+    const uint64_t ringOverflow = ring->header()->overflowCount;
+    std::printf("  丢帧   写入 %llu 帧, 输出 %llu 帧, SYN_DROPPED 丢弃 %llu 帧 (引擎计数 %llu, 重新同步失败 %llu), "
+                "事件环溢出 %llu 条记录, 发送队列取代 %llu 丢弃 %llu 包\n",
+                (unsigned long long)framesWritten, (unsigned long long)drain.frames(),
+                (unsigned long long)framesDropped, (unsigned long long)engine.syncDropCount(),
+                (unsigned long long)engine.resyncFailureCount(), (unsigned long long)ringOverflow,
+                (unsigned long long)senderStats.superseded, (unsigned long long)senderStats.dropped);
+    std::printf("  发送   %llu 包（陀螺仪 %llu）/ %llu 次 send, %.1f KiB, 最大排队 %lluus (状态包 %lluus)\n",
+                (unsigned long long)senderStats.packets, (unsigned long long)gyroSubmitted,
+                (unsigned long long)senderStats.syscalls, transportBytes.load() / 1024.0,
+                (unsigned long long)senderStats.maxQueueDelayUs, (unsigned long long)senderStats.maxStateQueueDelayUs);
+    if (options.fifoPriority > 0) {
+        std::printf("  线程   读取: %s\n", lastThreadConfigResult(ThreadRole::InputReader).describe().c_str());
+        std::printf("         发送: %s\n", lastThreadConfigResult(ThreadRole::PacketSender).describe().c_str());
+    }
+
+    EXPECT(haveBegin && windowFrames > 0, "稳态区间为空");
+    EXPECT(end.readerAllocations == begin.readerAllocations, "稳态下读取线程分配了 %llu 次",
+           (unsigned long long)(end.readerAllocations - begin.readerAllocations));
+    EXPECT(ringOverflow == 0 && senderStats.dropped == 0, "事件环溢出 %llu, 发送丢弃 %llu",
+           (unsigned long long)ringOverflow, (unsigned long long)senderStats.dropped);
+    EXPECT(drain.frames() + framesDropped == framesWritten, "输出帧 %llu + SYN_DROPPED 丢弃 %llu != 写入帧 %llu",
+           (unsigned long long)drain.frames(), (unsigned long long)framesDropped, (unsigned long long)framesWritten);
+    if (!options.uinput) {
+        EXPECT(engine.syncDropCount() == framesDropped, "引擎 SYN_DROPPED 计数 %llu",
+               (unsigned long long)engine.syncDropCount());
+    }
+    return g_failures == 0 ? 0 : 1;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (arg == "--fingers" && hasValue) {
+            options.fingers = std::max(1, std::min(kSlots, std::atoi(argv[++i])));
+        } else if (arg == "--rate" && hasValue) {
+            options.rateHz = std::max(1.0, std::strtod(argv[++i], nullptr));
+        } else if (arg == "--seconds" && hasValue) {
+            options.seconds = std::strtod(argv[++i], nullptr);
+        } else if (arg == "--pattern" && hasValue) {
+            const std::string pattern = argv[++i];
+            options.pattern = pattern == "swipe" ? MotionPattern::Swipe
+                : pattern == "jitter" ? MotionPattern::Jitter : MotionPattern::Circle;
+        } else if (arg == "--churn-ms" && hasValue) {
+            options.churnMs = std::atoi(argv[++i]);
+        } else if (arg == "--drop-every" && hasValue) {
+            options.dropEvery = std::atoi(argv[++i]);
+        } else if (arg == "--gyro-hz" && hasValue) {
+            options.gyroHz = std::strtod(argv[++i], nullptr);
+        } else if (arg == "--ring" && hasValue) {
+            options.ringCapacity = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--queue" && hasValue) {
+            options.queueCapacity = std::strtoul(argv[++i], nullptr, 10);
+        } else if (arg == "--fifo" && hasValue) {
+            options.fifoPriority = std::atoi(argv[++i]);
+        } else if (arg == "--uinput") {
+            options.uinput = true;
+        } else {
+            std::fprintf(stderr,
+                "usage: %s [--fingers N] [--rate Hz] [--seconds S] [--pattern circle|swipe|jitter] [--churn-ms MS]\n"
+                "          [--drop-every N] [--gyro-hz Hz] [--ring N] [--queue N] [--fifo PRIO] [--uinput]\n",
+                argv[0]);
+            return 2;
+        }
+    }
+
+    const int status = run(options);
+    if (status == 0) {
+        std::printf("load: OK\n");
+    } else if (status != kSkip) {
+        std::fprintf(stderr, "%d failure(s)\n", g_failures);
+    }
+    return status;
+}
@@ -0,0 +1,287 @@
+/**
+ * 多订阅者分发 (PacketFanout) 的 Linux 回环测试。
+ *
+ * 三个本机 TCP 客户端代替 PC 端消费者：
+ *   touch  - 订阅触摸 + UI 点击，持续读取（Fastkey 的角色）
+ *   motion - 订阅陀螺仪 + 加速度计，持续读取（gyroxinput 的角色）
+ *   slow   - 订阅全部类型，开头停读 kStallMs 且接收缓冲很小，模拟卡住的客户端
+ * 生产者按约 2 kHz 提交触摸与陀螺仪包，每 50 帧一个 UI 点击。
+ *
+ * 检查：touch / motion 收到全部订阅的包（除被 latest-wins 槽位取代的）且不受 slow 影响（最大延迟远小于停读时长）；
+ *       slow 的队列按 latest-wins 取代 / 丢弃了触摸 / 运动包，但 UI 包一个不少，最后收到的触摸是最新的。
+ * 报告：每个订阅者的收包数、取代与丢弃数、提交 -> 接收 延迟分位（包头时间戳与接收时间同为 CLOCK_MONOTONIC）。
+ *
+ * 另外一个从不读取的订阅者把发送线程堵在 send() 中，检查 removeSubscriber 在 stopDrainTimeoutMs 附近返回。
+ */
+#include "net/packet_fanout.h"
+#include "test_support.h"
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+constexpr int kFrames = 2000;
+constexpr int kUiEvery = 50;
+constexpr int kStallMs = 600;
+
+/**
+ * @brief 一个回环客户端：按 v1 协议解析收到的字节流
+ */
+struct Client {
+    std::string name;
+    int fd = -1;
+    int stallMs = 0;
+    std::thread thread;
+
+    int touches = 0;
+    int motion = 0;
+    int uiEvents = 0;
+    int64_t lastTouchSeq = -1;
+    bool touchOrdered = true;
+    bool uiOrdered = true;
+    std::vector<int64_t> latenciesUs;
+
+    void run() {
+        if (stallMs > 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(stallMs));
+        }
+        std::vector<uint8_t> buffer;
+        uint8_t chunk[4096];
+        int64_t lastUiSeq = -1;
+        for (;;) {
+            const ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+            if (n <= 0) {
+                break;
+            }
+            const int64_t receivedNs = monotonicNowNs();
+            buffer.insert(buffer.end(), chunk, chunk + n);
+            size_t offset = 0;
+            for (;;) {
+                const size_t available = buffer.size() - offset;
+                if (available < V1_STANDARD_HEADER_SIZE) break;
+                const uint8_t* p = buffer.data() + offset;
+                const uint8_t type = p[0];
+                size_t header = v1HeaderSize(type);
+                size_t payload = 0;
+                if (type == PACKET_TYPE_TOUCH) {
+                    if (available < header + 9) break;
+                    payload = 9 + 12 * static_cast<size_t>(p[header + 8]);
+                } else if (type == PACKET_TYPE_GYRO || type == PACKET_TYPE_ACCEL) {
+                    payload = 20;
+                } else if (isV1UiPacketType(type)) {
+                    if (available < header) break;
+                    payload = p[9] | (p[10] << 8);
+                }
+                if (available < header + payload) break;
+
+                uint64_t sentNs = 0;
+                for (int i = 0; i < 8; ++i) sentNs = (sentNs << 8) | p[1 + i];
+                latenciesUs.push_back((receivedNs - static_cast<int64_t>(sentNs)) / 1000);
+
+                int64_t seq = 0;
+                std::memcpy(&seq, p + header, sizeof(seq));
+                if (type == PACKET_TYPE_TOUCH) {
+                    ++touches;
+                    touchOrdered = touchOrdered && seq > lastTouchSeq;
+                    lastTouchSeq = seq;
+                } else if (type == PACKET_TYPE_GYRO || type == PACKET_TYPE_ACCEL) {
+                    ++motion;
+                } else if (type == PACKET_TYPE_UI_EVENT) {
+                    ++uiEvents;
+                    uiOrdered = uiOrdered && seq > lastUiSeq;
+                    lastUiSeq = seq;
+                }
+                offset += header + payload;
+            }
+            buffer.erase(buffer.begin(), buffer.begin() + offset);
+        }
+        close(fd);
+    }
+
+    void report(const FanoutSubscriberStats& stats) {
+        std::sort(latenciesUs.begin(), latenciesUs.end());
+        const auto pick = [&](double q) {
+            return latenciesUs.empty() ? 0LL
+                : static_cast<long long>(latenciesUs[static_cast<size_t>(q * (latenciesUs.size() - 1))]);
+        };
+        std::printf("%-7s touch=%-5d motion=%-5d ui=%-3d superseded=%-5llu dropped=%-5llu "
+                    "latency p50=%lldus p99=%lldus max=%lldus\n",
+                    name.c_str(), touches, motion, uiEvents, (unsigned long long)stats.sender.superseded,
+                    (unsigned long long)stats.sender.dropped,
+                    pick(0.5), pick(0.99), latenciesUs.empty() ? 0LL : (long long)latenciesUs.back());
+    }
+
+    long long maxLatencyUs() const {
+        return latenciesUs.empty() ? 0 : *std::max_element(latenciesUs.begin(), latenciesUs.end());
+    }
+};
+
+/**
+ * @brief 建立一条回环 TCP 连接，返回服务端（发送方）fd，客户端 fd 写入 clientFd
+ */
+int connectLoopback(int listenFd, int& clientFd, int bufferBytes) {
+    sockaddr_in addr;
+    socklen_t len = sizeof(addr);
+    getsockname(listenFd, reinterpret_cast<sockaddr*>(&addr), &len);
+    clientFd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (bufferBytes > 0) {
+        setsockopt(clientFd, SOL_SOCKET, SO_RCVBUF, &bufferBytes, sizeof(bufferBytes));
+    }
+    if (connect(clientFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        return -1;
+    }
+    const int serverFd = accept4(listenFd, nullptr, nullptr, SOCK_CLOEXEC);
+    const int one = 1;
+    setsockopt(serverFd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    if (bufferBytes > 0) {
+        setsockopt(serverFd, SOL_SOCKET, SO_SNDBUF, &bufferBytes, sizeof(bufferBytes));
+    }
+    return serverFd;
+}
+
+/**
+ * @brief 对端从不读取：发送线程阻塞在 send() 时移除订阅者不能无限等待
+ */
+void testStuckSubscriber(int listenFd) {
+    int clientFd = -1;
+    PacketSenderConfig config;
+    config.stopDrainTimeoutMs = 100;
+    PacketFanout fanout;
+    const int id = fanout.addSubscriber(connectLoopback(listenFd, clientFd, 4096), FANOUT_ALL_TYPES, config);
+    EXPECT(id > 0, "addSubscriber (stuck)");
+
+    // UI 包按序无损排队，不会被取代：写满两端的缓冲区后发送线程停在 send() 中
+    uint8_t uiPayload[64] = {};
+    for (int i = 0; i < 4000; ++i) {
+        fanout.submit(PACKET_TYPE_UI_EVENT, uiPayload, sizeof(uiPayload));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    const auto start = std::chrono::steady_clock::now();
+    EXPECT(fanout.removeSubscriber(id), "removeSubscriber (stuck)");
+    const long long elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    std::printf("stuck subscriber: removeSubscriber 用时 %lldms\n", elapsedMs);
+    EXPECT(elapsedMs < 1000, "removeSubscriber 被停读的对端阻塞 %lldms", elapsedMs);
+    close(clientFd);
+}
+
+} // namespace
+
+int main() {
+    const int listenFd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (listenFd < 0 || bind(listenFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0
+        || listen(listenFd, 4) != 0) {
+        std::printf("packet fanout: 无法监听回环地址，跳过\n");
+        return 77;
+    }
+
+    Client touch;
+    touch.name = "touch";
+    Client motion;
+    motion.name = "motion";
+    Client slow;
+    slow.name = "slow";
+    slow.stallMs = kStallMs;
+
+    PacketSenderConfig config;
+    config.batchWindowUs = 200;
+    config.maxBatchPackets = 16;
+    config.maxPendingPackets = 64;
+
+    PacketFanout fanout;
+    const int touchId = fanout.addSubscriber(connectLoopback(listenFd, touch.fd, 0),
+        packetTypeBit(PACKET_TYPE_TOUCH) | packetTypeBit(PACKET_TYPE_UI_EVENT), config);
+    const int motionId = fanout.addSubscriber(connectLoopback(listenFd, motion.fd, 0),
+        packetTypeBit(PACKET_TYPE_GYRO) | packetTypeBit(PACKET_TYPE_ACCEL), config);
+    const int slowId = fanout.addSubscriber(connectLoopback(listenFd, slow.fd, 4096), FANOUT_ALL_TYPES, config);
+    EXPECT(touchId > 0 && motionId > 0 && slowId > 0, "addSubscriber");
+    EXPECT(fanout.subscriberCount() == 3, "subscriberCount=%zu", fanout.subscriberCount());
+
+    for (Client* client : {&touch, &motion, &slow}) {
+        client->thread = std::thread(&Client::run, client);
+    }
+
+    // 触摸: 序号(8) + 触摸点数 0；陀螺仪: 序号写在保留字段；UI: 序号 + 标识
+    int uiSubmitted = 0;
+    for (int frame = 0; frame < kFrames; ++frame) {
+        uint8_t touchPayload[9] = {};
+        const int64_t seq = frame;
+        std::memcpy(touchPayload, &seq, sizeof(seq));
+        EXPECT(fanout.submit(PACKET_TYPE_TOUCH, touchPayload, sizeof(touchPayload)), "submit touch");
+
+        uint8_t gyroPayload[20] = {};
+        std::memcpy(gyroPayload, &seq, sizeof(seq));
+        fanout.submit(PACKET_TYPE_GYRO, gyroPayload, sizeof(gyroPayload));
+
+        if (frame % kUiEvery == 0) {
+            uint8_t uiPayload[11] = {};
+            std::memcpy(uiPayload, &seq, sizeof(seq));
+            std::memcpy(uiPayload + 8, "btn", 3);
+            fanout.submit(PACKET_TYPE_UI_EVENT, uiPayload, sizeof(uiPayload));
+            ++uiSubmitted;
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(500));
+    }
+
+    FanoutSubscriberStats touchStats, motionStats, slowStats;
+    fanout.subscriberStats(touchId, touchStats);
+    fanout.subscriberStats(motionId, motionStats);
+    fanout.subscriberStats(slowId, slowStats);
+
+    // 冲刷并关闭所有订阅者，客户端读到 EOF 后退出
+    fanout.removeAll();
+    for (Client* client : {&touch, &motion, &slow}) {
+        client->thread.join();
+    }
+    testStuckSubscriber(listenFd);
+    close(listenFd);
+
+    touch.report(touchStats);
+    motion.report(motionStats);
+    slow.report(slowStats);
+
+    // 快速订阅者只有在发送线程偶尔被调度延迟超过 latestWinsMinAgeUs 时才会有包被取代，收包数按取代数对账
+    EXPECT(touch.touches + static_cast<int>(touchStats.sender.superseded) == kFrames
+           && touch.uiEvents == uiSubmitted && touch.motion == 0,
+           "touch 订阅者收包不完整: touch=%d superseded=%llu ui=%d motion=%d", touch.touches,
+           (unsigned long long)touchStats.sender.superseded, touch.uiEvents, touch.motion);
+    EXPECT(motion.motion + static_cast<int>(motionStats.sender.superseded) == kFrames
+           && motion.touches == 0 && motion.uiEvents == 0,
+           "motion 订阅者收包不完整: motion=%d superseded=%llu", motion.motion,
+           (unsigned long long)motionStats.sender.superseded);
+    EXPECT(touch.touchOrdered && touch.uiOrdered, "touch 订阅者乱序");
+    EXPECT(touchStats.sender.dropped == 0 && motionStats.sender.dropped == 0, "快速订阅者不应丢包");
+    EXPECT(touch.maxLatencyUs() < kStallMs * 1000 / 4 && motion.maxLatencyUs() < kStallMs * 1000 / 4,
+           "快速订阅者被慢订阅者拖慢: touch max=%lldus motion max=%lldus",
+           touch.maxLatencyUs(), motion.maxLatencyUs());
+
+    EXPECT(slowStats.sender.superseded > 0, "慢订阅者的过时状态包应被取代");
+    EXPECT(slow.touches + slow.motion + static_cast<int>(slowStats.sender.superseded + slowStats.sender.dropped)
+           == 2 * kFrames, "慢订阅者的触摸 / 运动包应只因取代或丢弃缺失");
+    EXPECT(slow.uiEvents == uiSubmitted && slow.uiOrdered, "慢订阅者的 UI 包不应丢失: %d/%d", slow.uiEvents, uiSubmitted);
+    EXPECT(slow.touchOrdered && slow.lastTouchSeq == kFrames - 1,
+           "慢订阅者最后收到的触摸应是最新的: %lld", (long long)slow.lastTouchSeq);
+
+    if (g_failures > 0) {
+        std::fprintf(stderr, "%d failure(s)\n", g_failures);
+        return 1;
+    }
+    std::printf("packet fanout: OK\n");
+    return 0;
+}
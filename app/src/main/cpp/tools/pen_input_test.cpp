@@ -0,0 +1,219 @@
+/**
+ * 主动笔输入测试。
+ *
+ *   1. PenDecoder：手动设置轴范围后喂入悬停 -> 接触 -> 橡皮擦 -> 离开的事件序列，校验每帧的
+ *      标志位、压力 / 距离换算、倾角按 90° 旋转后的方向与单位，以及手指的单点模拟事件不产生采样；
+ *   2. InputEngine：经管道 (setDeviceFd) 交替写入笔与多点触控帧，校验笔采样按每帧输出、
+ *      坐标与触摸使用同一屏幕换算、触摸帧不受影响，关闭笔输入后笔事件被忽略；
+ *   3. 线协议：按 Kotlin 的 v1 布局构造 PEN Payload，经 encodeV2Payload 转换为 V2PenSample。
+ */
+#include "input/input_engine.h"
+#include "net/packet_codec.h"
+#include "test_support.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+constexpr int kMaxX = 20000;
+constexpr int kMaxY = 10000;
+constexpr int kScreenW = 1000;  // 悬浮窗 x = 原始 y
+constexpr int kScreenH = 2000;
+
+/**
+ * @brief 喂入一帧事件，返回 SYN_REPORT 时是否产生采样
+ */
+bool feedFrame(PenDecoder& pen, const std::vector<struct input_event>& events, long long timeUs, PenSample& out) {
+    for (const auto& ev : events) {
+        pen.handleEvent(ev);
+    }
+    return pen.takeSample(timeUs, out);
+}
+
+void testDecoder() {
+    PenDecoder pen;
+    pen.setPositionRange(kMaxX, kMaxY);
+    pen.setAxisRange(ABS_PRESSURE, 0, 4095);
+    pen.setAxisRange(ABS_DISTANCE, 0, 200);
+    pen.setAxisRange(ABS_TILT_X, -64, 63, 57); // 单位 / 弧度，约 1°
+    pen.setAxisRange(ABS_TILT_Y, -90, 90);     // 未报告分辨率：按度处理
+
+    PenSample sample;
+    // 手指的单点模拟事件：笔不在范围内，不输出
+    EXPECT(!feedFrame(pen, {makeEvent(EV_KEY, BTN_TOUCH, 1), makeEvent(EV_ABS, ABS_X, 100),
+                            makeEvent(EV_ABS, ABS_Y, 200)}, 1000, sample), "手指单点事件产生了笔采样");
+    pen.handleEvent(makeEvent(EV_KEY, BTN_TOUCH, 0));
+    EXPECT(!pen.takeSample(2000, sample), "手指抬起产生了笔采样");
+
+    // 悬停：距离 50/200，倾角 X=57 (1 弧度) / Y=-30°
+    EXPECT(feedFrame(pen, {makeEvent(EV_KEY, BTN_TOOL_PEN, 1), makeEvent(EV_ABS, ABS_X, 5000),
+                           makeEvent(EV_ABS, ABS_Y, 2500), makeEvent(EV_ABS, ABS_DISTANCE, 50),
+                           makeEvent(EV_ABS, ABS_TILT_X, 57), makeEvent(EV_ABS, ABS_TILT_Y, -30)}, 3000, sample),
+           "悬停没有输出采样");
+    EXPECT(sample.flags == PEN_FLAG_IN_RANGE, "悬停 flags=0x%x", sample.flags);
+    EXPECT(sample.x == 5000 && sample.y == 2500 && sample.timestampUs == 3000, "悬停位置 (%d,%d)", sample.x, sample.y);
+    EXPECT(sample.distance == 250 && sample.pressure == 0, "悬停距离 %u 压力 %u", sample.distance, sample.pressure);
+    // 屏幕 X 沿原生 Y，屏幕 Y 沿原生 -X
+    EXPECT(sample.tiltX == -3000, "tiltX=%d", sample.tiltX);
+    EXPECT(sample.tiltY <= -5700 && sample.tiltY >= -5740, "tiltY=%d", sample.tiltY);
+
+    // 同一帧没有新事件时不重复输出
+    EXPECT(!pen.takeSample(3500, sample), "无变化的帧输出了采样");
+
+    // 接触：满压力 + 笔杆键 1
+    EXPECT(feedFrame(pen, {makeEvent(EV_KEY, BTN_TOUCH, 1), makeEvent(EV_KEY, BTN_STYLUS, 1),
+                           makeEvent(EV_ABS, ABS_PRESSURE, 4095), makeEvent(EV_ABS, ABS_DISTANCE, 0)}, 4000, sample),
+           "接触没有输出采样");
+    EXPECT(sample.flags == (PEN_FLAG_IN_RANGE | PEN_FLAG_CONTACT | PEN_FLAG_BUTTON1), "接触 flags=0x%x", sample.flags);
+    EXPECT(sample.pressure == PEN_PRESSURE_SCALE && sample.distance == 0, "接触压力 %u", sample.pressure);
+
+    // 只靠压力判断接触（不报告 BTN_TOUCH 的笔）
+    EXPECT(feedFrame(pen, {makeEvent(EV_KEY, BTN_TOUCH, 0), makeEvent(EV_KEY, BTN_STYLUS, 0),
+                           makeEvent(EV_ABS, ABS_PRESSURE, 1024)}, 5000, sample), "压力变化没有输出采样");
+    EXPECT(sample.flags == (PEN_FLAG_IN_RANGE | PEN_FLAG_CONTACT), "压力接触 flags=0x%x", sample.flags);
+    EXPECT(sample.pressure == 2500, "压力 %u", sample.pressure);
+
+    // 离开范围：补发一个 flags=0 的采样，之后不再输出
+    EXPECT(feedFrame(pen, {makeEvent(EV_ABS, ABS_PRESSURE, 0), makeEvent(EV_KEY, BTN_TOOL_PEN, 0)}, 6000, sample),
+           "离开范围没有补发采样");
+    EXPECT(sample.flags == 0 && sample.pressure == 0, "离开 flags=0x%x", sample.flags);
+    EXPECT(!feedFrame(pen, {makeEvent(EV_ABS, ABS_X, 6000)}, 7000, sample), "离开后仍输出采样");
+
+    // 橡皮擦端
+    EXPECT(feedFrame(pen, {makeEvent(EV_KEY, BTN_TOOL_RUBBER, 1), makeEvent(EV_KEY, BTN_STYLUS2, 1)}, 8000, sample),
+           "橡皮擦没有输出采样");
+    EXPECT(sample.flags == (PEN_FLAG_IN_RANGE | PEN_FLAG_ERASER | PEN_FLAG_BUTTON2), "橡皮擦 flags=0x%x", sample.flags);
+}
+
+/**
+ * @brief 一帧：笔在 (penX, penY) 接触，手指 slot 0 在 (touchX, touchY)
+ */
+std::vector<struct input_event> mixedFrame(int frame, int penX, int penY, int touchX, int touchY, long long timeUs) {
+    std::vector<struct input_event> events;
+    if (frame == 0) {
+        events.push_back(makeEvent(EV_KEY, BTN_TOOL_PEN, 1, timeUs));
+        events.push_back(makeEvent(EV_KEY, BTN_TOUCH, 1, timeUs));
+        events.push_back(makeEvent(EV_ABS, ABS_MT_SLOT, 0, timeUs));
+        events.push_back(makeEvent(EV_ABS, ABS_MT_TRACKING_ID, 7, timeUs));
+    }
+    events.push_back(makeEvent(EV_ABS, ABS_X, penX, timeUs));
+    events.push_back(makeEvent(EV_ABS, ABS_Y, penY, timeUs));
+    events.push_back(makeEvent(EV_ABS, ABS_MT_POSITION_X, touchX, timeUs));
+    events.push_back(makeEvent(EV_ABS, ABS_MT_POSITION_Y, touchY, timeUs));
+    events.push_back(makeEvent(EV_SYN, SYN_REPORT, 0, timeUs));
+    return events;
+}
+
+void testEngine(bool penEnabled) {
+    int pipeFds[2];
+    if (pipe(pipeFds) != 0) {
+        EXPECT(false, "pipe 失败");
+        return;
+    }
+    auto sink = std::make_shared<RecordingSink>();
+    InputEngine engine;
+    engine.setScreenDimensions(kScreenW, kScreenH);
+    PenInputConfig pen;
+    pen.enabled = penEnabled;
+    engine.setPenInput(pen);
+    engine.start(std::string(), sink);
+    engine.setDeviceFd(pipeFds[0], kMaxX, kMaxY);
+
+    constexpr int kFrames = 20;
+    const long long baseUs = 1000000;
+    for (int frame = 0; frame < kFrames; ++frame) {
+        EXPECT(writeEvents(pipeFds[1], mixedFrame(frame, 4000 + frame * 100, 2000 + frame * 50,
+                                                  10000, 5000 + frame * 10, baseUs + frame * 2083)),
+               "写管道失败");
+    }
+    // 笔离开范围，手指抬起
+    const long long endUs = baseUs + kFrames * 2083;
+    EXPECT(writeEvents(pipeFds[1], {makeEvent(EV_KEY, BTN_TOUCH, 0, endUs), makeEvent(EV_KEY, BTN_TOOL_PEN, 0, endUs),
+                                    makeEvent(EV_ABS, ABS_MT_TRACKING_ID, -1, endUs),
+                                    makeEvent(EV_SYN, SYN_REPORT, 0, endUs)}), "写管道失败");
+
+    const size_t expectedPens = penEnabled ? kFrames + 1 : 0;
+    waitFor([&] { return sink->touches().size() >= kFrames && sink->pens().size() >= expectedPens; });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    engine.stop();
+    close(pipeFds[1]);
+
+    const auto touches = sink->touches();
+    const auto pens = sink->pens();
+    EXPECT(touches.size() == kFrames, "[pen=%d] 触摸点 %zu", penEnabled, touches.size());
+    for (size_t i = 0; i < touches.size() && i < kFrames; ++i) {
+        const int expectedX = (5000 + static_cast<int>(i) * 10) * kScreenW / kMaxY;
+        const int expectedY = (kMaxX - 10000) * kScreenH / kMaxX;
+        EXPECT(touches[i].id == 7 && touches[i].x == expectedX && touches[i].y == expectedY,
+               "[pen=%d] 触摸点 %zu: id=%d (%d,%d)", penEnabled, i, touches[i].id, touches[i].x, touches[i].y);
+    }
+    EXPECT(pens.size() == expectedPens, "[pen=%d] 笔采样 %zu，期望 %zu", penEnabled, pens.size(), expectedPens);
+    if (!penEnabled) {
+        return;
+    }
+    for (size_t i = 0; i < pens.size() && i < kFrames; ++i) {
+        const int rawX = 4000 + static_cast<int>(i) * 100;
+        const int rawY = 2000 + static_cast<int>(i) * 50;
+        const int expectedX = rawY * kScreenW / kMaxY;
+        const int expectedY = (kMaxX - rawX) * kScreenH / kMaxX;
+        EXPECT(pens[i].x == expectedX && pens[i].y == expectedY, "笔采样 %zu: (%d,%d) 期望 (%d,%d)",
+               i, pens[i].x, pens[i].y, expectedX, expectedY);
+        EXPECT(pens[i].flags == (PEN_FLAG_IN_RANGE | PEN_FLAG_CONTACT), "笔采样 %zu flags=0x%x", i, pens[i].flags);
+        EXPECT(pens[i].timestampUs == baseUs + static_cast<long long>(i) * 2083, "笔采样 %zu 时间戳 %lld",
+               i, pens[i].timestampUs);
+    }
+    if (pens.size() == expectedPens) {
+        EXPECT(pens.back().flags == 0 && pens.back().timestampUs == endUs, "离开范围采样 flags=0x%x", pens.back().flags);
+    }
+}
+
+void testCodec() {
+    // Kotlin sendNativePenSample 的 v1 布局
+    uint8_t v1[V1_PEN_PAYLOAD_SIZE] = {};
+    const int64_t timeUs = 123456789012LL;
+    const int32_t x = 812;
+    const int32_t y = -5;
+    const uint16_t pressure = 9876;
+    const uint16_t distance = 0;
+    const int16_t tiltX = -4512;
+    const int16_t tiltY = 1700;
+    std::memcpy(v1, &timeUs, 8);
+    std::memcpy(v1 + 8, &x, 4);
+    std::memcpy(v1 + 12, &y, 4);
+    std::memcpy(v1 + 16, &pressure, 2);
+    std::memcpy(v1 + 18, &distance, 2);
+    std::memcpy(v1 + 20, &tiltX, 2);
+    std::memcpy(v1 + 22, &tiltY, 2);
+    v1[24] = PEN_FLAG_IN_RANGE | PEN_FLAG_CONTACT | PEN_FLAG_BUTTON2;
+
+    EXPECT(v2PayloadSize(PACKET_TYPE_PEN, v1, sizeof(v1)) == static_cast<long>(sizeof(V2PenSample)), "v2 长度");
+    EXPECT(v2PayloadSize(PACKET_TYPE_PEN, v1, sizeof(v1) - 1) == -1, "截断的 Payload 未被拒绝");
+    alignas(8) uint8_t out[sizeof(V2PenSample)];
+    encodeV2Payload(PACKET_TYPE_PEN, v1, sizeof(v1), out, sizeof(out));
+    const V2PenSample* pen = reinterpret_cast<const V2PenSample*>(out);
+    EXPECT(pen->eventTimeUs == timeUs && pen->x == x && pen->y == y, "v2 时间 / 位置");
+    EXPECT(pen->pressure == pressure && pen->distance == distance, "v2 压力 / 距离");
+    EXPECT(pen->tiltX == tiltX && pen->tiltY == tiltY, "v2 倾角 (%d,%d)", pen->tiltX, pen->tiltY);
+    EXPECT(pen->flags == v1[24], "v2 flags=0x%x", pen->flags);
+}
+
+} // namespace
+
+int main() {
+    testDecoder();
+    testEngine(true);
+    testEngine(false);
+    testCodec();
+    if (g_failures != 0) {
+        std::fprintf(stderr, "%d failure(s)\n", g_failures);
+        return 1;
+    }
+    std::printf("pen_input_test: OK\n");
+    return 0;
+}
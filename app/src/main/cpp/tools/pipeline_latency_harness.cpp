@@ -0,0 +1,1018 @@
+/**
+ * 端到端管线延迟测量：evdev 源 -> InputEngine（解码、命中测试、长按计时）-> 事件环 ->
+ * 打包（与 InputEventRingConsumer.kt / GyroscopeService 的 Payload 逐字节一致）-> PacketFanout / PacketSender
+ * -> 本机 TCP 回环上的接收端替身。
+ *
+ *   pipeline_latency_harness [--v1|--v2] [--frames N] [--rate Hz] [--batch-us N]
+ *                            [--uinput] [--trace capture.bin] [--fast]
+ *
+ * 输入源：
+ *   默认        合成轨迹经管道交给 setDeviceFd（与运行时回放同一入口），写入时以 CLOCK_REALTIME 打事件时间；
+ *   --uinput    同一条轨迹写入 uinput 假触摸屏，引擎按设备路径打开真实 evdev 节点，
+ *               旁路读者从同一节点读回内核时间戳；无 /dev/uinput 时返回 77；
+ *   --trace     回放 nativeStartInputCapture 录下的捕获文件（默认按原始节奏，--fast 尽快），事件时间改写为写入时刻。
+ * 合成轨迹：一根手指持续移动（每帧横坐标不同，用于把收到的触摸包对应回源帧），
+ * 另外周期性点击 "tap" 区域、按住 "hold" 区域 250ms（触发长按计时器的按下与抬起时的长按结束）。
+ * 两个区域都是 capture，只有移动的手指出现在触摸包中。
+ *
+ * 报告：内核事件时间 -> 接收端收到（同为 CLOCK_REALTIME）的触摸包 / 区域点击 / 长按结束延迟百分位，
+ *       长按按下相对 150ms 计时器的滞后，吞吐，以及各环节的丢弃（事件环溢出、发送队列 latest-wins、
+ *       v2 序号缺口、未收到的源帧）。
+ * 不带参数时先后以 v1 与 v2 运行合成轨迹并做基本校验，供 ctest 使用。
+ *
+ * 坐标映射：屏幕尺寸设为 (maxY, maxX)，悬浮窗坐标 x 恰好等于面板原始 y，
+ * 因此接收端用 (事件毫秒, 第一个触摸点 x) 即可找回源帧；同一毫秒内坐标相同的帧按顺序对应。
+ */
+#include "common/event_ring.h"
+#include "input/event_capture.h"
+#include "input/input_engine.h"
+#include "input/ring_event_sink.h"
+#include "net/packet_fanout.h"
+#include "test_support.h"
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <deque>
+#include <fcntl.h>
+#include <linux/uinput.h>
+#include <memory>
+#include <mutex>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <string>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+constexpr int kSkip = 77;
+constexpr int kSlots = 10;
+constexpr int kMaxX = 1079;
+constexpr int kMaxY = 2399;
+constexpr uint32_t kRingCapacity = 4096;       // 与 Constants.INPUT_RING_CAPACITY 一致
+constexpr int64_t kLongPressDelayUs = 150000;  // 与 input_reader_loop.cpp 的 LONG_PRESS_START_DELAY_MS 一致
+constexpr int kHelloTimeoutMs = 300;           // 与 Constants.PROTOCOL_HELLO_TIMEOUT_MS 一致
+
+// 合成轨迹（悬浮窗坐标：x = 原始 y，y = kMaxX - 原始 x）
+constexpr int kTracerSlot = 0;
+constexpr int kTapSlot = 1;
+constexpr int kHoldSlot = 2;
+constexpr int kTracerScreenY = 900;
+constexpr int kTracerMinX = 100;
+constexpr int kTracerSpan = 1000;
+constexpr int kTapScreenX = 1600;
+constexpr int kHoldScreenX = 2000;
+constexpr int kRegionFingerScreenY = 200;
+constexpr int64_t kTapPeriodUs = 50000;
+constexpr int64_t kTapDurationUs = 5000;
+constexpr int64_t kHoldPeriodUs = 500000;
+constexpr int64_t kHoldDurationUs = 250000;
+
+enum class SourceKind {
+    Pipe,
+    Uinput,
+    Trace,
+};
+
+struct Options {
+    uint16_t protocolVersion = 0; // 0 表示 v1 与 v2 各跑一次
+    int frames = 2000;
+    double rateHz = 1000.0;       // 0 表示尽快写入
+    int batchWindowUs = -1;       // <0 使用 PacketSenderConfig 默认值
+    SourceKind source = SourceKind::Pipe;
+    std::string tracePath;
+    bool fast = false;
+};
+
+int64_t steadyNowUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void stampEvents(std::vector<input_event>& events, int64_t eventUs) {
+    for (auto& ev : events) {
+        ev.time.tv_sec = static_cast<decltype(ev.time.tv_sec)>(eventUs / 1000000);
+        ev.time.tv_usec = static_cast<decltype(ev.time.tv_usec)>(eventUs % 1000000);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// 源侧记账：按协议 B 跟踪写入（或内核报告）的原始事件，在每个 SYN_REPORT 登记帧的事件时间
+// ---------------------------------------------------------------------------
+
+struct SourceFrame {
+    int64_t eventUs;
+    int screenX; // 引擎输出的第一个触摸点的 x（= 最低活动 slot 的原始 y）
+};
+
+class SourceLedger {
+public:
+    /**
+     * @param regionSlots 合成轨迹中按在区域上的 slot（被区域 capture，不出现在触摸包中）
+     */
+    explicit SourceLedger(uint32_t regionSlots) : regionSlots_(regionSlots) {
+        std::fill(std::begin(ids_), std::end(ids_), -1);
+    }
+
+    void observe(const input_event* events, size_t count) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (size_t k = 0; k < count; ++k) {
+            const input_event& ev = events[k];
+            if (ev.type == EV_ABS) {
+                if (ev.code == ABS_MT_SLOT) {
+                    slot_ = (ev.value >= 0 && ev.value < kSlots) ? ev.value : -1;
+                    continue;
+                }
+                if (slot_ < 0) continue;
+                touched_ = true;
+                if (ev.code == ABS_MT_TRACKING_ID) {
+                    if (ev.value >= 0 && ids_[slot_] < 0) landed_ |= 1u << slot_;
+                    if (ev.value < 0 && ids_[slot_] >= 0) lifted_ |= 1u << slot_;
+                    ids_[slot_] = ev.value;
+                } else if (ev.code == ABS_MT_POSITION_Y) {
+                    rawY_[slot_] = ev.value;
+                }
+            } else if (ev.type == EV_SYN && ev.code == SYN_REPORT && touched_) {
+                const int64_t eventUs = static_cast<int64_t>(ev.time.tv_sec) * 1000000 + ev.time.tv_usec;
+                for (int s = 0; s < kSlots; ++s) {
+                    if (ids_[s] >= 0 && !(regionSlots_ & (1u << s))) {
+                        frames_.push_back({eventUs, rawY_[s]});
+                        break;
+                    }
+                }
+                for (int s = 0; s < kSlots; ++s) {
+                    if (landed_ & (1u << s)) lands_[s].push_back(eventUs);
+                    if (lifted_ & (1u << s)) lifts_[s].push_back(eventUs);
+                }
+                touched_ = false;
+                landed_ = 0;
+                lifted_ = 0;
+            }
+        }
+    }
+
+    // 以下在源与接收都结束后读取
+    const std::vector<SourceFrame>& frames() const { return frames_; }
+    const std::vector<int64_t>& lands(int slot) const { return lands_[slot]; }
+    const std::vector<int64_t>& lifts(int slot) const { return lifts_[slot]; }
+
+private:
+    std::mutex mutex_;
+    uint32_t regionSlots_;
+    int slot_ = 0;
+    int32_t ids_[kSlots];
+    int32_t rawY_[kSlots] = {};
+    bool touched_ = false;
+    uint32_t landed_ = 0;
+    uint32_t lifted_ = 0;
+    std::vector<SourceFrame> frames_;
+    std::vector<int64_t> lands_[kSlots];
+    std::vector<int64_t> lifts_[kSlots];
+};
+
+// ---------------------------------------------------------------------------
+// 合成轨迹
+// ---------------------------------------------------------------------------
+
+class SyntheticTrace {
+public:
+    /**
+     * @brief 生成第 index 帧（elapsedUs 为相对第一帧的时间），返回 false 表示轨迹已结束
+     * @param wantMore false 后不再开始新的点击 / 按住，待区域手指抬起后抬起所有手指结束
+     */
+    bool next(int index, int64_t elapsedUs, bool wantMore, std::vector<input_event>& out) {
+        out.clear();
+        if (finished_) {
+            return false;
+        }
+        const bool regionIdle = !tapDown_ && !holdDown_;
+        if (!wantMore && regionIdle) {
+            for (int s : {kTracerSlot, kTapSlot, kHoldSlot}) {
+                if (s == kTracerSlot || (s == kTapSlot && tapDown_) || (s == kHoldSlot && holdDown_)) {
+                    out.push_back(makeEvent(EV_ABS, ABS_MT_SLOT, s));
+                    out.push_back(makeEvent(EV_ABS, ABS_MT_TRACKING_ID, -1));
+                }
+            }
+            out.push_back(makeEvent(EV_KEY, BTN_TOUCH, 0));
+            out.push_back(makeEvent(EV_SYN, SYN_REPORT, 0));
+            finished_ = true;
+            return true;
+        }
+
+        out.push_back(makeEvent(EV_ABS, ABS_MT_SLOT, kTracerSlot));
+        if (index == 0) {
+            out.push_back(makeEvent(EV_ABS, ABS_MT_TRACKING_ID, nextTrackingId_++));
+            out.push_back(makeEvent(EV_ABS, ABS_MT_POSITION_X, kMaxX - kTracerScreenY));
+            out.push_back(makeEvent(EV_KEY, BTN_TOUCH, 1));
+        }
+        out.push_back(makeEvent(EV_ABS, ABS_MT_POSITION_Y, kTracerMinX + index % kTracerSpan));
+
+        if (tapDown_ && elapsedUs - tapDownUs_ >= kTapDurationUs) {
+            lift(kTapSlot, out);
+            tapDown_ = false;
+        } else if (!tapDown_ && wantMore && elapsedUs >= nextTapUs_) {
+            land(kTapSlot, kTapScreenX, out);
+            tapDown_ = true;
+            tapDownUs_ = elapsedUs;
+            nextTapUs_ += kTapPeriodUs;
+        }
+        if (holdDown_ && elapsedUs - holdDownUs_ >= kHoldDurationUs) {
+            lift(kHoldSlot, out);
+            holdDown_ = false;
+        } else if (!holdDown_ && wantMore && elapsedUs >= nextHoldUs_) {
+            land(kHoldSlot, kHoldScreenX, out);
+            holdDown_ = true;
+            holdDownUs_ = elapsedUs;
+            nextHoldUs_ += kHoldPeriodUs;
+        }
+        out.push_back(makeEvent(EV_SYN, SYN_REPORT, 0));
+        return true;
+    }
+
+private:
+    void land(int slot, int screenX, std::vector<input_event>& out) {
+        out.push_back(makeEvent(EV_ABS, ABS_MT_SLOT, slot));
+        out.push_back(makeEvent(EV_ABS, ABS_MT_TRACKING_ID, nextTrackingId_++));
+        out.push_back(makeEvent(EV_ABS, ABS_MT_POSITION_X, kMaxX - kRegionFingerScreenY));
+        out.push_back(makeEvent(EV_ABS, ABS_MT_POSITION_Y, screenX));
+    }
+
+    void lift(int slot, std::vector<input_event>& out) {
+        out.push_back(makeEvent(EV_ABS, ABS_MT_SLOT, slot));
+        out.push_back(makeEvent(EV_ABS, ABS_MT_TRACKING_ID, -1));
+    }
+
+    int nextTrackingId_ = 1;
+    bool finished_ = false;
+    bool tapDown_ = false;
+    int64_t tapDownUs_ = 0;
+    int64_t nextTapUs_ = kTapPeriodUs / 2;
+    bool holdDown_ = false;
+    int64_t holdDownUs_ = 0;
+    int64_t nextHoldUs_ = kHoldPeriodUs / 5;
+};
+
+std::vector<ClickableRegion> syntheticRegions() {
+    std::vector<ClickableRegion> regions(2);
+    regions[0].identifier = "tap";
+    regions[0].left = kTapScreenX - 100;
+    regions[0].top = kRegionFingerScreenY - 100;
+    regions[0].width = 200;
+    regions[0].height = 200;
+    regions[0].capture = true;
+    regions[1] = regions[0];
+    regions[1].identifier = "hold";
+    regions[1].left = kHoldScreenX - 100;
+    return regions;
+}
+
+// ---------------------------------------------------------------------------
+// 事件环消费者：与 InputEventRingConsumer.kt + GyroscopeService.send*Packet 相同的 v1 Payload
+// ---------------------------------------------------------------------------
+
+class PayloadWriter {
+public:
+    void clear() { bytes_.clear(); }
+    void u8(uint8_t value) { bytes_.push_back(value); }
+    void le16(uint16_t value) { le(value, 2); }
+    void le32(int32_t value) { le(static_cast<uint32_t>(value), 4); }
+    void le64(int64_t value) { le(static_cast<uint64_t>(value), 8); }
+    void raw(const char* data, size_t length) { bytes_.insert(bytes_.end(), data, data + length); }
+    const uint8_t* data() const { return bytes_.data(); }
+    size_t size() const { return bytes_.size(); }
+
+private:
+    void le(uint64_t value, int bytes) {
+        for (int i = 0; i < bytes; ++i) bytes_.push_back(static_cast<uint8_t>(value >> (8 * i)));
+    }
+    std::vector<uint8_t> bytes_;
+};
+
+class RingToTransport {
+public:
+    RingToTransport(std::shared_ptr<RingInputEventSink> ring, PacketFanout& fanout)
+        : ring_(std::move(ring)), fanout_(fanout) {}
+
+    void run() {
+        EventRingHeader* header = const_cast<EventRingHeader*>(ring_->header());
+        EventRingRecord* records = eventRingRecords(header);
+        const uint64_t mask = header->capacity - 1;
+        uint64_t readIndex = 0;
+        for (;;) {
+            const int64_t writeIndex = ring_->await(readIndex, 500);
+            if (writeIndex < 0) {
+                break;
+            }
+            while (readIndex < static_cast<uint64_t>(writeIndex)) {
+                dispatch(records[readIndex & mask]);
+                ++readIndex;
+            }
+        }
+    }
+
+private:
+    struct Contact {
+        int32_t id, x, y;
+        uint16_t pressure, touchMajor;
+    };
+
+    void dispatch(const EventRingRecord& record) {
+        switch (record.kind) {
+            case EVENT_RING_RECORD_TOUCH_CONTACT: {
+                const bool extended = (record.flags & EVENT_RING_FLAG_EXTENDED) != 0;
+                if (frameCount_ < TOUCH_SLOT_LIMIT) {
+                    frame_[frameCount_++] = {record.id, record.x, record.y,
+                                             extended ? record.touch.pressure : uint16_t(0),
+                                             extended ? record.touch.touchMajor : uint16_t(0)};
+                }
+                if (record.flags & EVENT_RING_FLAG_FRAME_END) {
+                    payload_.clear();
+                    payload_.le64(record.timestampMs);
+                    payload_.u8(static_cast<uint8_t>(frameCount_));
+                    for (int i = 0; i < frameCount_; ++i) {
+                        payload_.le32(frame_[i].id);
+                        payload_.le32(frame_[i].x);
+                        payload_.le32(frame_[i].y);
+                        if (extended) {
+                            payload_.le16(frame_[i].pressure);
+                            payload_.le16(frame_[i].touchMajor);
+                        }
+                    }
+                    fanout_.submit(extended ? PACKET_TYPE_TOUCH_EXTENDED : PACKET_TYPE_TOUCH,
+                                   payload_.data(), payload_.size());
+                    frameCount_ = 0;
+                }
+                break;
+            }
+            case EVENT_RING_RECORD_UI_TAP:
+            case EVENT_RING_RECORD_UI_PRESS_DOWN:
+            case EVENT_RING_RECORD_UI_LONG_PRESS_END: {
+                payload_.clear();
+                payload_.le32(record.x);
+                payload_.le32(record.y);
+                if (record.kind == EVENT_RING_RECORD_UI_PRESS_DOWN) {
+                    payload_.le64(record.timestampMs);
+                }
+                payload_.raw(record.name, std::min<size_t>(record.nameLength, EVENT_RING_NAME_BYTES));
+                const uint8_t type = record.kind == EVENT_RING_RECORD_UI_TAP ? PACKET_TYPE_UI_EVENT
+                    : record.kind == EVENT_RING_RECORD_UI_PRESS_DOWN ? PACKET_TYPE_UI_PRESS_DOWN
+                    : PACKET_TYPE_UI_LONG_PRESS;
+                fanout_.submit(type, payload_.data(), payload_.size());
+                break;
+            }
+            default:
+                break; // 合成轨迹不启用区域手势
+        }
+    }
+
+    std::shared_ptr<RingInputEventSink> ring_;
+    PacketFanout& fanout_;
+    Contact frame_[TOUCH_SLOT_LIMIT];
+    int frameCount_ = 0;
+    PayloadWriter payload_;
+};
+
+// ---------------------------------------------------------------------------
+// 接收端替身
+// ---------------------------------------------------------------------------
+
+struct Arrival {
+    uint8_t type;
+    int slot;             // 区域事件：按名称对应的合成 slot，-1 表示未知
+    int64_t eventMs;      // 触摸包：帧时间戳；长按按下：按下时间戳 (steady ms)
+    int x;                // 触摸包：第一个触摸点的 x
+    int64_t realUs;       // 收到时刻 (CLOCK_REALTIME)
+    int64_t steadyUs;     // 收到时刻 (steady_clock)
+};
+
+class StandInReceiver {
+public:
+    StandInReceiver(int fd, bool offerV2) : fd_(fd), offerV2_(offerV2) {
+        arrivals_.reserve(1 << 16);
+        storage_.resize(kBufferBytes / sizeof(uint64_t));
+    }
+
+    void run() {
+        if (offerV2_) {
+            uint8_t hello[V1_UI_HEADER_SIZE + sizeof(V2Hello)] = {};
+            V2Hello server{};
+            server.magic = PROTOCOL_HELLO_MAGIC;
+            server.version = PROTOCOL_VERSION_V2;
+            server.capabilities = PROTOCOL_CAP_CLOCK_SYNC | PROTOCOL_CAP_TOUCH_EXTENDED;
+            hello[0] = PACKET_TYPE_SERVER_HELLO;
+            hello[9] = static_cast<uint8_t>(sizeof(V2Hello));
+            std::memcpy(hello + V1_UI_HEADER_SIZE, &server, sizeof(server));
+            if (send(fd_, hello, sizeof(hello), MSG_NOSIGNAL) != static_cast<ssize_t>(sizeof(hello))) {
+                return;
+            }
+        }
+        uint8_t* buffer = reinterpret_cast<uint8_t*>(storage_.data());
+        size_t filled = 0;
+        for (;;) {
+            const ssize_t n = recv(fd_, buffer + filled, kBufferBytes - filled, 0);
+            if (n <= 0) {
+                break;
+            }
+            const int64_t realUs = realtimeNowUs();
+            const int64_t steadyUs = steadyNowUs();
+            filled += static_cast<size_t>(n);
+            bytes_ += static_cast<uint64_t>(n);
+            size_t consumed = 0;
+            while (consumed < filled) {
+                const long used = parse(buffer + consumed, filled - consumed, realUs, steadyUs);
+                if (used < 0) {
+                    ++malformed_;
+                    return;
+                }
+                if (used == 0) break;
+                consumed += static_cast<size_t>(used);
+            }
+            // 剩余的半个包移到缓冲区开头（包长都是 8 的倍数，v2 记录保持对齐）
+            std::memmove(buffer, buffer + consumed, filled - consumed);
+            filled -= consumed;
+        }
+    }
+
+    uint16_t version() const { return version_; }
+    size_t received() const { return received_.load(std::memory_order_relaxed); }
+    const std::vector<Arrival>& arrivals() const { return arrivals_; }
+    uint64_t bytes() const { return bytes_; }
+    uint64_t sequenceGaps() const { return sequenceGaps_; }
+    uint64_t malformed() const { return malformed_; }
+
+private:
+    static constexpr size_t kBufferBytes = 256 * 1024;
+
+    static int slotForName(const char* name, size_t length) {
+        const std::string region(name, length);
+        return region == "tap" ? kTapSlot : region == "hold" ? kHoldSlot : -1;
+    }
+
+    void record(uint8_t type, int slot, int64_t eventMs, int x, int64_t realUs, int64_t steadyUs) {
+        arrivals_.push_back({type, slot, eventMs, x, realUs, steadyUs});
+        received_.store(arrivals_.size(), std::memory_order_relaxed);
+    }
+
+    long parse(const uint8_t* data, size_t available, int64_t realUs, int64_t steadyUs) {
+        if (version_ == 0) {
+            // 第一个包是 CLIENT_HELLO 时客户端选择了 v2，否则为 v1
+            version_ = (offerV2_ && data[0] == PACKET_TYPE_CLIENT_HELLO) ? PROTOCOL_VERSION_V2 : PROTOCOL_VERSION_V1;
+        }
+        return version_ == PROTOCOL_VERSION_V2 ? parseV2(data, available, realUs, steadyUs)
+                                               : parseV1(data, available, realUs, steadyUs);
+    }
+
+    long parseV1(const uint8_t* data, size_t available, int64_t realUs, int64_t steadyUs) {
+        const uint8_t type = data[0];
+        if (type == PACKET_TYPE_TOUCH || type == PACKET_TYPE_TOUCH_EXTENDED) {
+            const size_t fixed = V1_STANDARD_HEADER_SIZE + 9;
+            if (available < fixed) return 0;
+            const size_t count = data[fixed - 1];
+            const size_t total = fixed + count * (type == PACKET_TYPE_TOUCH ? 12 : 16);
+            if (available < total) return 0;
+            const int x = count > 0 ? static_cast<int32_t>(loadLe32(data + fixed + 4)) : -1;
+            record(type, -1, static_cast<int64_t>(loadLe64(data + V1_STANDARD_HEADER_SIZE)), x, realUs, steadyUs);
+            return static_cast<long>(total);
+        }
+        if (isV1UiPacketType(type)) {
+            if (available < V1_UI_HEADER_SIZE) return 0;
+            const size_t length = data[9] | (static_cast<size_t>(data[10]) << 8);
+            if (available < V1_UI_HEADER_SIZE + length) return 0;
+            const uint8_t* payload = data + V1_UI_HEADER_SIZE;
+            const size_t nameOffset = type == PACKET_TYPE_UI_PRESS_DOWN ? 16 : 8;
+            if (length < nameOffset) return -1;
+            const int64_t downMs = type == PACKET_TYPE_UI_PRESS_DOWN ? static_cast<int64_t>(loadLe64(payload + 8)) : 0;
+            record(type, slotForName(reinterpret_cast<const char*>(payload + nameOffset), length - nameOffset),
+                   downMs, 0, realUs, steadyUs);
+            return static_cast<long>(V1_UI_HEADER_SIZE + length);
+        }
+        return -1;
+    }
+
+    long parseV2(const uint8_t* data, size_t available, int64_t realUs, int64_t steadyUs) {
+        V2PacketView packet;
+        const long total = decodeV2Packet(data, available, packet);
+        if (total <= 0) return total;
+        if (haveSequence_ && packet.header.sequence != nextSequence_) {
+            sequenceGaps_ += packet.header.sequence - nextSequence_;
+        }
+        haveSequence_ = true;
+        nextSequence_ = packet.header.sequence + 1;
+
+        switch (packet.header.type) {
+            case PACKET_TYPE_TOUCH:
+            case PACKET_TYPE_TOUCH_EXTENDED: {
+                const V2TouchFrame* frame = packet.record<V2TouchFrame>();
+                if (!frame) return -1;
+                const V2Contact* first = packet.element<V2Contact>(sizeof(V2TouchFrame), 0);
+                record(packet.header.type, -1, frame->eventTimeMs, first ? first->x : -1, realUs, steadyUs);
+                break;
+            }
+            case PACKET_TYPE_UI_EVENT:
+            case PACKET_TYPE_UI_LONG_PRESS: {
+                const V2UiEvent* event = packet.record<V2UiEvent>();
+                if (!event || sizeof(V2UiEvent) + event->nameLength > packet.header.length) return -1;
+                record(packet.header.type, slotForName(reinterpret_cast<const char*>(packet.payload + sizeof(V2UiEvent)),
+                                                       event->nameLength), 0, 0, realUs, steadyUs);
+                break;
+            }
+            case PACKET_TYPE_UI_PRESS_DOWN: {
+                const V2UiPressDown* event = packet.record<V2UiPressDown>();
+                if (!event || sizeof(V2UiPressDown) + event->nameLength > packet.header.length) return -1;
+                record(packet.header.type,
+                       slotForName(reinterpret_cast<const char*>(packet.payload + sizeof(V2UiPressDown)), event->nameLength),
+                       event->downTimeMs, 0, realUs, steadyUs);
+                break;
+            }
+            default:
+                break; // CLIENT_HELLO 等
+        }
+        return total;
+    }
+
+    int fd_;
+    bool offerV2_;
+    uint16_t version_ = 0;
+    std::vector<uint64_t> storage_; // 8 字节对齐的接收缓冲区
+    std::vector<Arrival> arrivals_;
+    std::atomic<size_t> received_{0}; // arrivals_ 的长度，供主线程判断管线是否排空
+    uint64_t bytes_ = 0;
+    uint64_t malformed_ = 0;
+    bool haveSequence_ = false;
+    uint32_t nextSequence_ = 0;
+    uint64_t sequenceGaps_ = 0;
+};
+
+// ---------------------------------------------------------------------------
+// 报告
+// ---------------------------------------------------------------------------
+
+struct Percentiles {
+    size_t count = 0;
+    int64_t p50 = 0, p90 = 0, p99 = 0, p999 = 0, max = 0, min = 0;
+};
+
+Percentiles percentiles(std::vector<int64_t> values) {
+    Percentiles out;
+    out.count = values.size();
+    if (values.empty()) {
+        return out;
+    }
+    std::sort(values.begin(), values.end());
+    auto at = [&](double q) { return values[std::min(values.size() - 1, static_cast<size_t>(q * values.size()))]; };
+    out.min = values.front();
+    out.p50 = at(0.50);
+    out.p90 = at(0.90);
+    out.p99 = at(0.99);
+    out.p999 = at(0.999);
+    out.max = values.back();
+    return out;
+}
+
+void printPercentiles(const char* label, const Percentiles& p, size_t expected) {
+    std::printf("  %-18s %zu/%zu  p50=%lldus p90=%lldus p99=%lldus p99.9=%lldus max=%lldus\n",
+                label, p.count, expected, (long long)p.p50, (long long)p.p90, (long long)p.p99,
+                (long long)p.p999, (long long)p.max);
+}
+
+/**
+ * @brief 按顺序把收到的区域事件对应到源帧时间
+ */
+std::vector<int64_t> matchInOrder(const std::vector<Arrival>& arrivals, uint8_t type, int slot,
+                                  const std::vector<int64_t>& sourceUs) {
+    std::vector<int64_t> latencies;
+    size_t next = 0;
+    for (const Arrival& arrival : arrivals) {
+        if (arrival.type == type && arrival.slot == slot && next < sourceUs.size()) {
+            latencies.push_back(arrival.realUs - sourceUs[next++]);
+        }
+    }
+    return latencies;
+}
+
+// ---------------------------------------------------------------------------
+// 一次运行
+// ---------------------------------------------------------------------------
+
+bool connectLoopback(int& phoneFd, int& receiverFd) {
+    const int listenFd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t addrLength = sizeof(addr);
+    if (listenFd < 0 || bind(listenFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0
+        || listen(listenFd, 1) != 0 || getsockname(listenFd, reinterpret_cast<sockaddr*>(&addr), &addrLength) != 0) {
+        if (listenFd >= 0) close(listenFd);
+        return false;
+    }
+    phoneFd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (connect(phoneFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        close(phoneFd);
+        close(listenFd);
+        return false;
+    }
+    receiverFd = accept4(listenFd, nullptr, nullptr, SOCK_CLOEXEC);
+    close(listenFd);
+    const int one = 1;
+    setsockopt(phoneFd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    setsockopt(receiverFd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    return receiverFd >= 0;
+}
+
+/**
+ * @brief 与 TcpCommunicator.readServerHello 相同：超时内读 SERVER_HELLO，否则视为 v1 接收端
+ */
+uint16_t negotiate(int phoneFd, bool wantV2, uint32_t& capabilities) {
+    capabilities = 0;
+    if (!wantV2) {
+        return PROTOCOL_VERSION_V1;
+    }
+    uint8_t packet[V1_UI_HEADER_SIZE + sizeof(V2Hello)];
+    size_t total = 0;
+    const int64_t deadlineUs = steadyNowUs() + kHelloTimeoutMs * 1000LL;
+    while (total < sizeof(packet)) {
+        struct pollfd pfd = {phoneFd, POLLIN, 0};
+        const int waitMs = static_cast<int>(std::max<int64_t>(0, (deadlineUs - steadyNowUs()) / 1000));
+        if (poll(&pfd, 1, waitMs) <= 0) {
+            return PROTOCOL_VERSION_V1;
+        }
+        const ssize_t n = recv(phoneFd, packet + total, sizeof(packet) - total, 0);
+        if (n <= 0) {
+            return PROTOCOL_VERSION_V1;
+        }
+        total += static_cast<size_t>(n);
+    }
+    V2Hello server;
+    if (packet[0] != PACKET_TYPE_SERVER_HELLO
+        || !decodeV2Hello(packet + V1_UI_HEADER_SIZE, sizeof(V2Hello), server)) {
+        return PROTOCOL_VERSION_V1;
+    }
+    const V2Hello result = negotiateProtocol(server, 0);
+    capabilities = result.capabilities;
+    return result.version;
+}
+
+const char* sourceName(SourceKind source) {
+    switch (source) {
+        case SourceKind::Pipe: return "pipe";
+        case SourceKind::Uinput: return "uinput";
+        case SourceKind::Trace: return "trace";
+    }
+    return "?";
+}
+
+/**
+ * @return 0 通过，1 失败，kSkip 环境不支持
+ */
+int runOnce(const Options& options, uint16_t protocolVersion) {
+    const bool synthetic = options.source != SourceKind::Trace;
+    int maxX = kMaxX;
+    int maxY = kMaxY;
+    EventCaptureReader trace;
+    if (!synthetic) {
+        if (!trace.open(options.tracePath)) {
+            std::fprintf(stderr, "无法打开捕获文件 %s\n", options.tracePath.c_str());
+            return 1;
+        }
+        maxX = trace.header()->devices[CAPTURE_DEVICE_TOUCH].maxX;
+        maxY = trace.header()->devices[CAPTURE_DEVICE_TOUCH].maxY;
+        if (maxX <= 0 || maxY <= 0) {
+            std::fprintf(stderr, "捕获文件缺少触摸设备坐标范围\n");
+            return 1;
+        }
+    }
+
+    // uinput 源：假触摸屏 + 旁路读者（与引擎同为默认的 CLOCK_REALTIME 时间戳）
+    int uinputFd = -1;
+    int sideFd = -1;
+    std::string node;
+    if (options.source == SourceKind::Uinput) {
+        std::string sysName;
+        uinputFd = createFakeTouchscreen({"pipeline-harness touchscreen", 0x5679, kSlots, kMaxX, kMaxY}, sysName);
+        node = uinputFd >= 0 ? findEventNode(sysName) : std::string();
+        sideFd = node.empty() ? -1 : open(node.c_str(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+        if (sideFd < 0) {
+            if (uinputFd >= 0) close(uinputFd);
+            std::printf("pipeline: 无法创建 / 打开 uinput 假触摸屏，跳过\n");
+            return kSkip;
+        }
+    }
+
+    auto ring = std::make_shared<RingInputEventSink>();
+    if (!ring->create(kRingCapacity)) {
+        std::fprintf(stderr, "事件环创建失败\n");
+        return 1;
+    }
+    int pipeFds[2] = {-1, -1};
+    if (options.source != SourceKind::Uinput) {
+        if (pipe2(pipeFds, O_CLOEXEC) != 0) {
+            std::fprintf(stderr, "pipe2: %s\n", strerror(errno));
+            return 1;
+        }
+        fcntl(pipeFds[0], F_SETFL, fcntl(pipeFds[0], F_GETFL) | O_NONBLOCK);
+    }
+    int writeFd = uinputFd;
+
+    int phoneFd = -1;
+    int receiverFd = -1;
+    if (!connectLoopback(phoneFd, receiverFd)) {
+        std::printf("pipeline: 无法建立回环连接，跳过\n");
+        if (uinputFd >= 0) close(uinputFd);
+        if (sideFd >= 0) close(sideFd);
+        if (pipeFds[0] >= 0) close(pipeFds[0]);
+        if (pipeFds[1] >= 0) close(pipeFds[1]);
+        return kSkip;
+    }
+
+    StandInReceiver receiver(receiverFd, protocolVersion == PROTOCOL_VERSION_V2);
+    std::thread receiverThread(&StandInReceiver::run, &receiver);
+
+    PacketSenderConfig config;
+    if (options.batchWindowUs >= 0) {
+        config.batchWindowUs = options.batchWindowUs;
+    }
+    config.protocolVersion = negotiate(phoneFd, protocolVersion == PROTOCOL_VERSION_V2, config.protocolCapabilities);
+    PacketFanout fanout;
+    if (fanout.addSubscriber(phoneFd, FANOUT_ALL_TYPES, config) < 0) {
+        close(phoneFd);
+    }
+
+    RingToTransport consumer(ring, fanout);
+    std::thread consumerThread(&RingToTransport::run, &consumer);
+
+    InputEngine engine;
+    engine.setScreenDimensions(maxY, maxX); // 悬浮窗 x = 原始 y，见文件头
+    if (synthetic) {
+        engine.setClickableRegions(syntheticRegions());
+    }
+
+    SourceLedger ledger(synthetic ? (1u << kTapSlot) | (1u << kHoldSlot) : 0u);
+    std::atomic<bool> sideRunning{true};
+    std::thread sideReader;
+    if (options.source == SourceKind::Uinput) {
+        engine.start(node, ring);
+        for (int i = 0; i < 200 && engine.startupOpenUs() < 0; ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        sideReader = std::thread([&]() {
+            input_event events[64];
+            while (sideRunning.load(std::memory_order_acquire)) {
+                struct pollfd pfd = {sideFd, POLLIN, 0};
+                if (poll(&pfd, 1, 20) <= 0) continue;
+                const ssize_t n = read(sideFd, events, sizeof(events));
+                if (n > 0) ledger.observe(events, static_cast<size_t>(n) / sizeof(input_event));
+            }
+        });
+    } else {
+        // 与 EventReplayer 相同：读端非阻塞交给引擎；设备路径为空，管道 EOF 后引擎等待重新配置
+        engine.start(std::string(), ring);
+        engine.setDeviceFd(pipeFds[0], maxX, maxY);
+        writeFd = pipeFds[1];
+        // 让读取线程先取走管道，第一帧不计入接管耗时
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+
+    // ---- 写入源事件 ----
+    const int64_t startNs = monotonicNowNs();
+    const int64_t periodNs = options.rateHz > 0 ? static_cast<int64_t>(1e9 / options.rateHz) : 0;
+    std::vector<input_event> frame;
+    int written = 0;
+    if (synthetic) {
+        SyntheticTrace generator;
+        for (int i = 0;; ++i) {
+            if (periodNs > 0) {
+                sleepUntilMonotonicNs(startNs + i * periodNs);
+            }
+            const int64_t elapsedUs = (monotonicNowNs() - startNs) / 1000;
+            if (!generator.next(i, elapsedUs, i < options.frames, frame)) {
+                break;
+            }
+            if (options.source == SourceKind::Pipe) {
+                stampEvents(frame, realtimeNowUs());
+                ledger.observe(frame.data(), frame.size());
+            }
+            if (!writeAll(writeFd, frame.data(), frame.size() * sizeof(input_event))) {
+                std::fprintf(stderr, "写入源事件失败: %s\n", strerror(errno));
+                break;
+            }
+            ++written;
+        }
+    } else {
+        // 按捕获时的 read() 分组写出；事件时间改写为写入时刻，模拟内核在此刻打的时间戳
+        const CaptureRecord* records = trace.records();
+        const uint64_t count = trace.recordCount();
+        int64_t firstReadNs = -1;
+        uint64_t index = 0;
+        while (index < count) {
+            if (records[index].deviceTag != CAPTURE_DEVICE_TOUCH) {
+                ++index;
+                continue;
+            }
+            const int64_t groupReadNs = records[index].readTimeNs;
+            if (firstReadNs < 0) firstReadNs = groupReadNs;
+            frame.clear();
+            while (index < count && records[index].readTimeNs == groupReadNs) {
+                const CaptureRecord& record = records[index++];
+                if (record.deviceTag == CAPTURE_DEVICE_TOUCH) {
+                    frame.push_back(makeEvent(record.type, record.code, record.value));
+                }
+            }
+            if (!options.fast) {
+                sleepUntilMonotonicNs(startNs + (groupReadNs - firstReadNs));
+            }
+            stampEvents(frame, realtimeNowUs());
+            ledger.observe(frame.data(), frame.size());
+            if (!writeAll(writeFd, frame.data(), frame.size() * sizeof(input_event))) {
+                break;
+            }
+            ++written;
+        }
+    }
+    const double sourceSeconds = (monotonicNowNs() - startNs) / 1e9;
+
+    // ---- 等待管线排空：接收端在 200ms 内不再收到新包 ----
+    size_t lastArrivals = 0;
+    for (int idle = 0, waited = 0; idle < 4 && waited < 60; ++waited) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        const size_t now = receiver.received();
+        idle = now == lastArrivals ? idle + 1 : 0;
+        lastArrivals = now;
+    }
+
+    if (options.source == SourceKind::Pipe || options.source == SourceKind::Trace) {
+        close(writeFd);
+    }
+    engine.stop();
+    ring->close();
+    consumerThread.join();
+    const uint64_t ringOverflow = ring->header()->overflowCount;
+    const PacketSenderStats senderStats = fanout.totalStats();
+    fanout.removeAll(); // 冲刷并关闭 phoneFd，接收端读到 EOF
+    receiverThread.join();
+    close(receiverFd);
+    if (sideReader.joinable()) {
+        sideRunning.store(false, std::memory_order_release);
+        sideReader.join();
+        close(sideFd);
+        ioctl(uinputFd, UI_DEV_DESTROY);
+        close(uinputFd);
+    }
+
+    // ---- 对应与统计 ----
+    const std::vector<Arrival>& arrivals = receiver.arrivals();
+    std::unordered_map<uint64_t, std::deque<size_t>> frameIndex;
+    for (size_t i = 0; i < ledger.frames().size(); ++i) {
+        const SourceFrame& source = ledger.frames()[i];
+        frameIndex[(static_cast<uint64_t>(source.eventUs / 1000) << 20) | (source.screenX & 0xFFFFF)].push_back(i);
+    }
+    std::vector<int64_t> touchLatency;
+    size_t touchPackets = 0;
+    size_t unmatched = 0;
+    int64_t firstTouchUs = 0;
+    int64_t lastTouchUs = 0;
+    std::vector<int64_t> pressDownLateness;
+    for (const Arrival& arrival : arrivals) {
+        if (arrival.type == PACKET_TYPE_TOUCH || arrival.type == PACKET_TYPE_TOUCH_EXTENDED) {
+            if (touchPackets++ == 0) firstTouchUs = arrival.realUs;
+            lastTouchUs = arrival.realUs;
+            auto it = frameIndex.find((static_cast<uint64_t>(arrival.eventMs) << 20) | (arrival.x & 0xFFFFF));
+            if (it == frameIndex.end() || it->second.empty()) {
+                ++unmatched;
+                continue;
+            }
+            touchLatency.push_back(arrival.realUs - ledger.frames()[it->second.front()].eventUs);
+            it->second.pop_front();
+        } else if (arrival.type == PACKET_TYPE_UI_PRESS_DOWN) {
+            pressDownLateness.push_back(arrival.steadyUs - (arrival.eventMs * 1000 + kLongPressDelayUs));
+        }
+    }
+
+    const Percentiles touch = percentiles(touchLatency);
+    std::printf("pipeline [%s, v%u, %s]: %d 次写入 / %.2fs, 接收 %zu 包 %.1f KiB\n",
+                sourceName(options.source), (unsigned)receiver.version(),
+                options.rateHz > 0 && synthetic ? "定速" : (options.fast || synthetic ? "尽快" : "原始节奏"),
+                written, sourceSeconds, arrivals.size(), receiver.bytes() / 1024.0);
+    printPercentiles("touch", touch, ledger.frames().size());
+    if (touchPackets > 1 && lastTouchUs > firstTouchUs) {
+        std::printf("  throughput         %.0f touch packets/s, %.1f KiB/s\n",
+                    (touchPackets - 1) * 1e6 / (lastTouchUs - firstTouchUs),
+                    receiver.bytes() / 1024.0 * 1e6 / (lastTouchUs - firstTouchUs));
+    }
+    Percentiles taps;
+    Percentiles holdTaps;
+    Percentiles longPressEnds;
+    Percentiles lateness;
+    if (synthetic) {
+        taps = percentiles(matchInOrder(arrivals, PACKET_TYPE_UI_EVENT, kTapSlot, ledger.lands(kTapSlot)));
+        holdTaps = percentiles(matchInOrder(arrivals, PACKET_TYPE_UI_EVENT, kHoldSlot, ledger.lands(kHoldSlot)));
+        longPressEnds = percentiles(matchInOrder(arrivals, PACKET_TYPE_UI_LONG_PRESS, kHoldSlot, ledger.lifts(kHoldSlot)));
+        lateness = percentiles(pressDownLateness);
+        printPercentiles("tap", taps, ledger.lands(kTapSlot).size());
+        printPercentiles("hold tap", holdTaps, ledger.lands(kHoldSlot).size());
+        printPercentiles("long press end", longPressEnds, ledger.lifts(kHoldSlot).size());
+        std::printf("  %-18s %zu/%zu  相对 150ms 计时器滞后 min=%lldus p50=%lldus max=%lldus（毫秒精度）\n",
+                    "press down", lateness.count, ledger.lands(kHoldSlot).size(),
+                    (long long)lateness.min, (long long)lateness.p50, (long long)lateness.max);
+    }
+    const size_t lostFrames = ledger.frames().size() - touchLatency.size();
+    std::printf("  drops              源帧未收到=%zu 无法对应=%zu 事件环溢出=%llu 发送取代=%llu 发送丢弃=%llu "
+                "v2 序号缺口=%llu SYN_DROPPED=%llu\n",
+                lostFrames, unmatched, (unsigned long long)ringOverflow, (unsigned long long)senderStats.superseded,
+                (unsigned long long)senderStats.dropped, (unsigned long long)receiver.sequenceGaps(),
+                (unsigned long long)engine.syncDropCount());
+    std::printf("  sender             %llu 包 / %llu 次 send, 平均排队 %.0fus, 最大 %lluus\n",
+                (unsigned long long)senderStats.packets, (unsigned long long)senderStats.syscalls,
+                senderStats.packets ? (double)senderStats.queueDelaySumUs / senderStats.packets : 0.0,
+                (unsigned long long)senderStats.maxQueueDelayUs);
+
+    // 只对定速的合成轨迹做校验；尽快模式与回放只报告
+    const int failuresBefore = g_failures;
+    EXPECT(receiver.malformed() == 0, "接收端解析失败");
+    EXPECT(receiver.version() == (protocolVersion == PROTOCOL_VERSION_V2 ? PROTOCOL_VERSION_V2 : PROTOCOL_VERSION_V1),
+           "协商结果 v%u", (unsigned)receiver.version());
+    if (synthetic && options.rateHz > 0) {
+        // 发送线程被调度延迟超过 latestWinsMinAgeUs 时过时的帧会被取代，只允许这一种缺失
+        EXPECT(lostFrames == senderStats.superseded && unmatched == 0, "触摸帧丢失 %zu (取代 %llu) / 无法对应 %zu",
+               lostFrames, (unsigned long long)senderStats.superseded, unmatched);
+        const uint64_t expectedGaps = protocolVersion == PROTOCOL_VERSION_V2 ? senderStats.superseded : 0;
+        EXPECT(ringOverflow == 0 && senderStats.dropped == 0 && receiver.sequenceGaps() == expectedGaps,
+               "定速轨迹不应丢弃");
+        EXPECT(taps.count == ledger.lands(kTapSlot).size() && taps.count > 0, "点击 %zu", taps.count);
+        EXPECT(holdTaps.count == ledger.lands(kHoldSlot).size() && lateness.count == holdTaps.count
+               && longPressEnds.count == ledger.lifts(kHoldSlot).size() && longPressEnds.count > 0,
+               "长按 按下=%zu 结束=%zu", lateness.count, longPressEnds.count);
+        EXPECT(touch.min >= 0, "延迟为负: %lldus", (long long)touch.min);
+        EXPECT(touch.p99 < 50000, "触摸包 p99 延迟过大: %lldus", (long long)touch.p99);
+        // downTimestamp 为毫秒，按下最多提前 1ms；上界很宽，只捕捉计时器失效
+        EXPECT(lateness.min >= -1000 && lateness.max < 50000, "长按计时器滞后异常: [%lld, %lld]us",
+               (long long)lateness.min, (long long)lateness.max);
+    }
+    return g_failures == failuresBefore ? 0 : 1;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--v1") {
+            options.protocolVersion = PROTOCOL_VERSION_V1;
+        } else if (arg == "--v2") {
+            options.protocolVersion = PROTOCOL_VERSION_V2;
+        } else if (arg == "--frames" && i + 1 < argc) {
+            options.frames = std::atoi(argv[++i]);
+        } else if (arg == "--rate" && i + 1 < argc) {
+            options.rateHz = std::strtod(argv[++i], nullptr);
+        } else if (arg == "--batch-us" && i + 1 < argc) {
+            options.batchWindowUs = std::atoi(argv[++i]);
+        } else if (arg == "--uinput") {
+            options.source = SourceKind::Uinput;
+        } else if (arg == "--trace" && i + 1 < argc) {
+            options.source = SourceKind::Trace;
+            options.tracePath = argv[++i];
+        } else if (arg == "--fast") {
+            options.fast = true;
+            options.rateHz = 0;
+        } else {
+            std::fprintf(stderr,
+                "usage: %s [--v1|--v2] [--frames N] [--rate Hz] [--batch-us N] [--uinput] [--trace capture.bin] [--fast]\n",
+                argv[0]);
+            return 2;
+        }
+    }
+
+    std::vector<uint16_t> versions;
+    if (options.protocolVersion != 0) {
+        versions.push_back(options.protocolVersion);
+    } else {
+        versions = {PROTOCOL_VERSION_V1, PROTOCOL_VERSION_V2};
+    }
+    int result = 0;
+    for (uint16_t version : versions) {
+        const int status = runOnce(options, version);
+        if (status == kSkip) {
+            return kSkip;
+        }
+        result |= status;
+    }
+    if (result != 0) {
+        std::fprintf(stderr, "%d failure(s)\n", g_failures);
+        return 1;
+    }
+    std::printf("pipeline: OK\n");
+    return 0;
+}
@@ -0,0 +1,117 @@
+/**
+ * 特权辅助进程 (PrivilegedHelper) 的 Linux 测试。
+ *
+ * 直接以当前用户运行主机构建的辅助进程（不经 su），验证：
+ *   - 启动、连回与 ping；
+ *   - SCM_RIGHTS 传回的 fd 可读且带 FD_CLOEXEC（主机构建额外允许 /tmp/ 下的文件）；
+ *   - 白名单外的路径被拒绝 (EACCES)，不存在的设备返回 ENOENT；
+ *   - 停止后可重新启动，可执行文件不存在时快速失败。
+ * 报告：一次辅助进程打开的往返耗时，与一次 system("true")（原 su -c 路径中 shell 部分的下限）对比。
+ *
+ * 用法: privileged_helper_test <辅助进程可执行文件>
+ */
+#include "input/privileged_helper.h"
+#include "test_support.h"
+
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <string>
+#include <unistd.h>
+
+namespace {
+
+double elapsedUs(std::chrono::steady_clock::time_point since) {
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - since).count();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc != 2) {
+        std::fprintf(stderr, "usage: %s <helper>\n", argv[0]);
+        return 2;
+    }
+
+    char filePath[] = "/tmp/privileged_helper_test_XXXXXX";
+    const int fileFd = mkstemp(filePath);
+    if (fileFd < 0) {
+        std::printf("privileged helper: 无法在 /tmp 创建文件，跳过\n");
+        return 77;
+    }
+    static constexpr char kContent[] = "helper";
+    EXPECT(write(fileFd, kContent, sizeof(kContent)) == static_cast<ssize_t>(sizeof(kContent)), "write");
+    close(fileFd);
+
+    PrivilegedHelper helper;
+    helper.configure(argv[1], false);
+
+    auto start = std::chrono::steady_clock::now();
+    EXPECT(helper.ensureRunning(), "启动失败: %s", strerror(errno));
+    const double startUs = elapsedUs(start);
+    EXPECT(helper.isRunning() && helper.ping(), "ping");
+
+    // fd 传递
+    const int fd = helper.openDevice(filePath, O_RDONLY | O_NONBLOCK);
+    EXPECT(fd >= 0, "openDevice(%s): %s", filePath, strerror(errno));
+    if (fd >= 0) {
+        char buffer[sizeof(kContent)] = {};
+        EXPECT(read(fd, buffer, sizeof(buffer)) == static_cast<ssize_t>(sizeof(kContent))
+               && std::memcmp(buffer, kContent, sizeof(kContent)) == 0, "传回的 fd 内容不符");
+        EXPECT((fcntl(fd, F_GETFD) & FD_CLOEXEC) != 0, "传回的 fd 未设置 FD_CLOEXEC");
+        EXPECT((fcntl(fd, F_GETFL) & O_NONBLOCK) != 0, "传回的 fd 未保留 O_NONBLOCK");
+        close(fd);
+    }
+
+    // 白名单
+    EXPECT(helper.openDevice("/etc/passwd", O_RDONLY) < 0 && errno == EACCES, "/etc/passwd 应被拒绝");
+    EXPECT(helper.openDevice("/dev/input/event1/../../../etc/passwd", O_RDONLY) < 0 && errno == EACCES,
+           "路径穿越应被拒绝");
+    EXPECT(helper.openDevice("/tmp/../etc/passwd", O_RDONLY) < 0 && errno == EACCES, "/tmp/.. 应被拒绝");
+    EXPECT(helper.openDevice("/dev/input/event9999", O_RDONLY) < 0 && errno == ENOENT,
+           "不存在的设备应返回 ENOENT: %s", strerror(errno));
+    EXPECT(helper.isRunning(), "拒绝请求后连接应保持");
+
+    // 往返耗时
+    constexpr int kOpens = 500;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < kOpens; ++i) {
+        const int opened = helper.openDevice(filePath, O_RDONLY);
+        if (opened >= 0) close(opened);
+    }
+    const double openUs = elapsedUs(start) / kOpens;
+
+    constexpr int kShells = 20;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < kShells; ++i) {
+        if (std::system("true") != 0) break;
+    }
+    const double shellUs = elapsedUs(start) / kShells;
+
+    // 停止与重启
+    helper.stop();
+    EXPECT(!helper.isRunning() && !helper.ping(), "stop 后仍在运行");
+    EXPECT(helper.ensureRunning() && helper.ping(), "重新启动失败");
+    helper.stop();
+
+    PrivilegedHelper missing;
+    missing.configure("/nonexistent/liblowlatencyinput_helper.so", false);
+    start = std::chrono::steady_clock::now();
+    EXPECT(!missing.ensureRunning() && errno == EACCES, "不存在的辅助进程应启动失败");
+    EXPECT(elapsedUs(start) < 1000 * 1000, "启动失败应快速返回");
+
+    unlink(filePath);
+
+    std::printf("privileged helper: start=%.0fus open round trip=%.1fus, system(\"true\")=%.0fus (%.0fx)\n",
+                startUs, openUs, shellUs, openUs > 0 ? shellUs / openUs : 0.0);
+
+    if (g_failures > 0) {
+        std::fprintf(stderr, "%d failure(s)\n", g_failures);
+        return 1;
+    }
+    std::printf("privileged helper: OK\n");
+    return 0;
+}
@@ -0,0 +1,327 @@
+/**
+ * v2 线协议的 Linux 测试。
+ *
+ * PacketSender 写入 socketpair，另一端读出全部字节后用 protocol_v2.h 的仅头文件解码器解析：
+ *   - 协商：版本回退与能力交集；
+ *   - v1 兼容：未协商时字节流与 v1 编码逐字节一致；
+ *   - v2：第一个包是 CLIENT_HELLO，之后各类型按 Kotlin 层的 v1 Payload 提交，
+ *         在 8 字节对齐的缓冲区中直接按记录结构读取，序号连续，接收端时钟标志正确，
+ *         格式不符的 Payload 被丢弃；
+ *   - latest-wins 丢弃与槽位取代在序号中留下与 dropped + superseded 统计一致的缺口，
+ *     槽位只保留最新的状态包，UI 包不受影响；
+ *   - 解码器对不完整与非法包头的处理。
+ */
+#include "net/clock_sync.h"
+#include "net/packet_sender.h"
+#include "test_support.h"
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+/**
+ * @brief 按 Kotlin 层的方式构造 v1 Payload
+ */
+struct V1Builder {
+    std::vector<uint8_t> bytes;
+
+    V1Builder& le32(uint32_t v) {
+        for (int i = 0; i < 4; ++i) bytes.push_back(static_cast<uint8_t>(v >> (8 * i)));
+        return *this;
+    }
+    V1Builder& le64(uint64_t v) {
+        for (int i = 0; i < 8; ++i) bytes.push_back(static_cast<uint8_t>(v >> (8 * i)));
+        return *this;
+    }
+    V1Builder& le16(uint16_t v) {
+        bytes.push_back(static_cast<uint8_t>(v));
+        bytes.push_back(static_cast<uint8_t>(v >> 8));
+        return *this;
+    }
+    V1Builder& be64(uint64_t v) {
+        for (int i = 7; i >= 0; --i) bytes.push_back(static_cast<uint8_t>(v >> (8 * i)));
+        return *this;
+    }
+    V1Builder& beFloat(float f) {
+        uint32_t bits;
+        std::memcpy(&bits, &f, sizeof(bits));
+        for (int i = 3; i >= 0; --i) bytes.push_back(static_cast<uint8_t>(bits >> (8 * i)));
+        return *this;
+    }
+    V1Builder& u8(uint8_t v) {
+        bytes.push_back(v);
+        return *this;
+    }
+    V1Builder& text(const char* s) {
+        bytes.insert(bytes.end(), s, s + std::strlen(s));
+        return *this;
+    }
+};
+
+/**
+ * @brief 启动发送器、执行 submit 回调、停止后读出对端收到的全部字节
+ * @return 按 8 字节对齐存放的字节流（uint64_t 数组）与其长度
+ */
+template <typename Submit>
+std::vector<uint64_t> runSender(const PacketSenderConfig& config, size_t& length, Submit submit,
+                                PacketSenderStats* statsOut = nullptr) {
+    int fds[2];
+    length = 0;
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) != 0) {
+        EXPECT(false, "socketpair");
+        return {};
+    }
+    PacketSender sender;
+    EXPECT(sender.start(fds[0], config), "sender.start");
+    submit(sender);
+    sender.stop();
+    if (statsOut) *statsOut = sender.stats();
+
+    std::vector<uint64_t> buffer(8192);
+    uint8_t* bytes = reinterpret_cast<uint8_t*>(buffer.data());
+    for (;;) {
+        const ssize_t n = read(fds[1], bytes + length, buffer.size() * 8 - length);
+        if (n <= 0) break;
+        length += static_cast<size_t>(n);
+    }
+    close(fds[1]);
+    return buffer;
+}
+
+/**
+ * @brief 把流解码为包列表，同时检查对齐与长度
+ */
+std::vector<V2PacketView> decodeAll(const uint8_t* data, size_t length) {
+    std::vector<V2PacketView> packets;
+    size_t offset = 0;
+    while (offset < length) {
+        V2PacketView view;
+        const long consumed = decodeV2Packet(data + offset, length - offset, view);
+        EXPECT(consumed > 0, "解码失败 offset=%zu consumed=%ld", offset, consumed);
+        if (consumed <= 0) break;
+        EXPECT(reinterpret_cast<uintptr_t>(view.payload) % 8 == 0, "Payload 未按 8 字节对齐");
+        packets.push_back(view);
+        offset += static_cast<size_t>(consumed);
+    }
+    return packets;
+}
+
+} // namespace
+
+int main() {
+    // 协商
+    {
+        V2Hello server{PROTOCOL_HELLO_MAGIC, PROTOCOL_VERSION_V2, 0,
+                       PROTOCOL_CAP_CLOCK_SYNC | PROTOCOL_CAP_RECEIVER_TIMESTAMPS, 0};
+        V2Hello result = negotiateProtocol(server, PROTOCOL_CAP_CLOCK_SYNC | PROTOCOL_CAP_TOUCH_EXTENDED);
+        EXPECT(result.version == PROTOCOL_VERSION_V2 && result.capabilities == PROTOCOL_CAP_CLOCK_SYNC,
+               "能力应取交集: v%u caps=0x%x", (unsigned)result.version, result.capabilities);
+        server.version = 3; // 更高版本的接收端仍可与本机协商到 v2
+        EXPECT(negotiateProtocol(server, 0).version == PROTOCOL_VERSION_V2, "高版本接收端");
+        server.magic = 0;
+        EXPECT(negotiateProtocol(server, ~0u).version == PROTOCOL_VERSION_V1, "magic 不符应回退 v1");
+        uint8_t bytes[sizeof(V2Hello)] = {};
+        EXPECT(!decodeV2Hello(bytes, sizeof(bytes), server), "全零 Hello 应无效");
+        EXPECT(!decodeV2Hello(bytes, sizeof(bytes) - 1, server), "过短 Hello 应无效");
+    }
+
+    const std::vector<uint8_t> touch = V1Builder().le64(123456).u8(2)
+        .le32(0).le32(100).le32(200).le32(1).le32(300).le32(400).bytes;
+
+    // v1 兼容：字节流与 v1 编码一致
+    {
+        size_t length = 0;
+        const auto stream = runSender(PacketSenderConfig(), length, [&](PacketSender& sender) {
+            sender.submit(PACKET_TYPE_TOUCH, touch.data(), touch.size());
+        });
+        const uint8_t* bytes = reinterpret_cast<const uint8_t*>(stream.data());
+        EXPECT(length == V1_STANDARD_HEADER_SIZE + touch.size(), "v1 长度: %zu", length);
+        EXPECT(length > 0 && bytes[0] == PACKET_TYPE_TOUCH
+               && std::memcmp(bytes + V1_STANDARD_HEADER_SIZE, touch.data(), touch.size()) == 0, "v1 字节流");
+    }
+
+    // v2：各类型记录
+    {
+        auto clock = std::make_shared<ClockSync>();
+        clock->addSample(1000, 5000, 5100, 1200);
+
+        PacketSenderConfig config;
+        config.protocolVersion = PROTOCOL_VERSION_V2;
+        config.protocolCapabilities = PROTOCOL_CAP_CLOCK_SYNC | PROTOCOL_CAP_RECEIVER_TIMESTAMPS;
+        config.receiverClock = clock;
+
+        const auto touchExtended = V1Builder().le64(777).u8(1).le32(5).le32(-10).le32(20).le16(512).le16(64).bytes;
+        const auto gyro = V1Builder().be64(4242).be64(0).beFloat(1.5f).beFloat(-2.25f).beFloat(3.0f).bytes;
+        const auto ui = V1Builder().le32(11).le32(22).text("fire").bytes;
+        const auto press = V1Builder().le32(33).le32(44).le64(99999).text("jump_button").bytes;
+        const auto gesture = V1Builder().u8(3).u8(2).u8(4).u8(0)
+            .le32(1).le32(2).le32(-3).le32(-4).le64(55555).text("aim").bytes;
+        const auto deviceInfo = V1Builder().le32(2400).le32(1080).bytes;
+        const uint8_t opaque[3] = {7, 8, 9};
+        const auto badTouch = V1Builder().le64(1).u8(3).le32(0).bytes; // 声明 3 个触摸点但只有 4 字节
+
+        size_t length = 0;
+        PacketSenderStats stats;
+        const auto stream = runSender(config, length, [&](PacketSender& sender) {
+            sender.submit(PACKET_TYPE_TOUCH, touch.data(), touch.size());
+            sender.submit(PACKET_TYPE_TOUCH_EXTENDED, touchExtended.data(), touchExtended.size());
+            sender.submit(PACKET_TYPE_GYRO, gyro.data(), gyro.size());
+            sender.submit(PACKET_TYPE_UI_EVENT, ui.data(), ui.size());
+            sender.submit(PACKET_TYPE_UI_PRESS_DOWN, press.data(), press.size());
+            sender.submit(PACKET_TYPE_UI_GESTURE, gesture.data(), gesture.size());
+            sender.submit(PACKET_TYPE_DEVICE_INFO, deviceInfo.data(), deviceInfo.size());
+            EXPECT(sender.submit(PACKET_TYPE_TOUCH, badTouch.data(), badTouch.size()), "格式错误不应视为断线");
+            sender.submit(PACKET_TYPE_PING, nullptr, 0);
+            sender.submit(0x30, opaque, sizeof(opaque));
+        }, &stats);
+
+        const auto packets = decodeAll(reinterpret_cast<const uint8_t*>(stream.data()), length);
+        EXPECT(packets.size() == 10, "包数: %zu", packets.size());
+        EXPECT(stats.packets == 10, "统计包数: %llu", (unsigned long long)stats.packets);
+        for (size_t i = 0; i < packets.size(); ++i) {
+            EXPECT(packets[i].header.sequence == i, "序号 %zu: %u", i, packets[i].header.sequence);
+        }
+        if (packets.size() == 10) {
+            const V2Hello* hello = packets[0].record<V2Hello>();
+            EXPECT(packets[0].header.type == PACKET_TYPE_CLIENT_HELLO && hello
+                   && hello->magic == PROTOCOL_HELLO_MAGIC && hello->version == PROTOCOL_VERSION_V2
+                   && hello->capabilities == config.protocolCapabilities, "CLIENT_HELLO");
+
+            const V2PacketView& t = packets[1];
+            const V2TouchFrame* frame = t.record<V2TouchFrame>();
+            const V2Contact* second = t.element<V2Contact>(sizeof(V2TouchFrame), 1);
+            EXPECT(frame && frame->eventTimeMs == 123456 && frame->count == 2 && second
+                   && second->id == 1 && second->x == 300 && second->y == 400 && second->pressure == 0,
+                   "TOUCH 记录");
+            EXPECT(t.header.flags & V2_FLAG_RECEIVER_CLOCK, "TOUCH 应使用接收端时钟");
+
+            const V2Contact* extended = packets[2].element<V2Contact>(sizeof(V2TouchFrame), 0);
+            EXPECT(extended && extended->id == 5 && extended->x == -10 && extended->pressure == 512
+                   && extended->touchMajor == 64, "TOUCH_EXTENDED 记录");
+
+            const V2MotionSample* motion = packets[3].record<V2MotionSample>();
+            EXPECT(packets[3].header.length == sizeof(V2MotionSample) && motion && motion->eventTimeMs == 4242
+                   && motion->x == 1.5f && motion->y == -2.25f && motion->z == 3.0f, "GYRO 记录");
+
+            const V2UiEvent* event = packets[4].record<V2UiEvent>();
+            EXPECT(event && event->x == 11 && event->y == 22 && event->nameLength == 4
+                   && std::memcmp(packets[4].payload + sizeof(V2UiEvent), "fire", 4) == 0
+                   && packets[4].header.length == 24, "UI_EVENT 记录");
+
+            const V2UiPressDown* down = packets[5].record<V2UiPressDown>();
+            EXPECT(down && down->downTimeMs == 99999 && down->nameLength == 11
+                   && std::memcmp(packets[5].payload + sizeof(V2UiPressDown), "jump_button", 11) == 0,
+                   "UI_PRESS_DOWN 记录");
+
+            const V2UiGesture* g = packets[6].record<V2UiGesture>();
+            EXPECT(g && g->kind == 3 && g->fingers == 2 && g->direction == 4 && g->dx == -3 && g->dy == -4
+                   && g->timeMs == 55555 && g->nameLength == 3, "UI_GESTURE 记录");
+
+            const V2DeviceInfo* info = packets[7].record<V2DeviceInfo>();
+            EXPECT(info && info->width == 2400 && info->height == 1080, "DEVICE_INFO 记录");
+
+            EXPECT(packets[8].header.type == PACKET_TYPE_PING && packets[8].header.length == 0
+                   && !(packets[8].header.flags & V2_FLAG_RECEIVER_CLOCK), "PING 保持本机时钟");
+
+            EXPECT(packets[9].header.type == 0x30 && packets[9].header.length == 8
+                   && std::memcmp(packets[9].payload, opaque, sizeof(opaque)) == 0
+                   && packets[9].payload[3] == 0, "未知类型按不透明字节携带并补 0");
+        }
+    }
+
+    // latest-wins 丢弃留下序号缺口
+    {
+        PacketSenderConfig config;
+        config.protocolVersion = PROTOCOL_VERSION_V2;
+        config.batchWindowUs = 200000; // 窗口足够长，提交期间全部积压在队列中
+        config.maxBatchPackets = 64;
+        config.maxPendingPackets = 4;
+        config.urgentTypeMask = 0;
+        constexpr int kSamples = 20;
+
+        size_t length = 0;
+        PacketSenderStats stats;
+        const auto stream = runSender(config, length, [&](PacketSender& sender) {
+            for (int i = 0; i < kSamples; ++i) {
+                const auto gyro = V1Builder().be64(i).be64(0).beFloat(i).beFloat(0).beFloat(0).bytes;
+                sender.submit(PACKET_TYPE_GYRO, gyro.data(), gyro.size());
+            }
+        }, &stats);
+
+        const auto packets = decodeAll(reinterpret_cast<const uint8_t*>(stream.data()), length);
+        uint64_t gaps = 0;
+        for (size_t i = 1; i < packets.size(); ++i) {
+            gaps += packets[i].header.sequence - packets[i - 1].header.sequence - 1;
+        }
+        EXPECT(stats.dropped > 0 && gaps == stats.dropped + stats.superseded, "序号缺口 %llu 应等于丢弃数 %llu + 取代数 %llu",
+               (unsigned long long)gaps, (unsigned long long)stats.dropped, (unsigned long long)stats.superseded);
+        EXPECT(!packets.empty() && packets.back().header.sequence == kSamples, "最后一个包应是最新采样");
+    }
+
+    // latest-wins 槽位：积压期间每种状态只保留最新的一个，UI 包按序全部保留
+    {
+        PacketSenderConfig config;
+        config.protocolVersion = PROTOCOL_VERSION_V2;
+        config.batchWindowUs = 200000;
+        config.maxBatchPackets = 64;
+        config.urgentTypeMask = 0;
+        config.latestWinsMinAgeUs = 0; // 任何排队中的旧状态都算过时
+        constexpr int kSamples = 20;
+
+        size_t length = 0;
+        PacketSenderStats stats;
+        const auto stream = runSender(config, length, [&](PacketSender& sender) {
+            for (int i = 0; i < kSamples; ++i) {
+                const auto gyro = V1Builder().be64(i).be64(0).beFloat(i).beFloat(0).beFloat(0).bytes;
+                sender.submit(PACKET_TYPE_GYRO, gyro.data(), gyro.size());
+                if (i % 5 == 0) {
+                    const auto ui = V1Builder().le32(i).le32(0).text("b").bytes;
+                    sender.submit(PACKET_TYPE_UI_EVENT, ui.data(), ui.size());
+                }
+            }
+        }, &stats);
+
+        const auto packets = decodeAll(reinterpret_cast<const uint8_t*>(stream.data()), length);
+        int gyros = 0;
+        int uiEvents = 0;
+        uint64_t gaps = 0;
+        for (size_t i = 0; i < packets.size(); ++i) {
+            if (packets[i].header.type == PACKET_TYPE_GYRO) ++gyros;
+            if (packets[i].header.type == PACKET_TYPE_UI_EVENT) ++uiEvents;
+            if (i > 0) gaps += packets[i].header.sequence - packets[i - 1].header.sequence - 1;
+        }
+        EXPECT(gyros == 1 && uiEvents == kSamples / 5, "槽位应只剩 1 个陀螺仪包 (%d)，UI 包 %d", gyros, uiEvents);
+        EXPECT(stats.superseded == kSamples - 1 && stats.dropped == 0 && gaps == stats.superseded,
+               "取代 %llu, 丢弃 %llu, 序号缺口 %llu", (unsigned long long)stats.superseded,
+               (unsigned long long)stats.dropped, (unsigned long long)gaps);
+        EXPECT(!packets.empty() && packets.back().header.type == PACKET_TYPE_GYRO
+               && packets.back().record<V2MotionSample>() != nullptr
+               && packets.back().record<V2MotionSample>()->x == kSamples - 1, "留下的应是最新采样并排在队尾");
+    }
+
+    // 解码器边界
+    {
+        alignas(8) uint8_t bytes[V2_HEADER_SIZE + 8] = {};
+        encodeV2Header(bytes, PACKET_TYPE_DEVICE_INFO, 0, 8, 1, 42);
+        V2PacketView view;
+        EXPECT(decodeV2Packet(bytes, V2_HEADER_SIZE - 1, view) == 0, "包头不完整");
+        EXPECT(decodeV2Packet(bytes, V2_HEADER_SIZE + 4, view) == 0, "Payload 不完整");
+        EXPECT(decodeV2Packet(bytes, sizeof(bytes), view) == static_cast<long>(sizeof(bytes))
+               && view.header.timestampNs == 42, "完整包");
+        EXPECT(view.record<V2MotionSample>() == nullptr, "长度不足的记录应返回 nullptr");
+        encodeV2Header(bytes, PACKET_TYPE_DEVICE_INFO, 0, 6, 1, 42);
+        EXPECT(decodeV2Packet(bytes, sizeof(bytes), view) == -1, "长度不是 8 的倍数应为非法");
+    }
+
+    if (g_failures > 0) {
+        std::fprintf(stderr, "%d failure(s)\n", g_failures);
+        return 1;
+    }
+    std::printf("protocol v2: OK\n");
+    return 0;
+}
@@ -0,0 +1,258 @@
+/**
+ * 区域命中表测试。
+ *
+ *   1. 形状：矩形半开边界、圆（外接矩形四角不命中）、圆角矩形、凸多边形、padding 外扩 / 收缩、
+ *      非凸多边形退化为外接矩形；
+ *   2. 优先级：重叠区域中 priority 大的优先，相同时区域表中靠前的优先；accept 拒绝时落到下一个候选；
+ *   3. 批量：70 个区域（跨两个位集字）与 64 个点，run() 的结果与逐点 contains() 一致；
+ *   4. InputEngine：经管道 (setDeviceFd) 按下，外接矩形角上的手指不命中圆形区域，中心的手指命中高优先级的圆。
+ */
+#include "input/input_engine.h"
+#include "input/region_hit_table.h"
+#include "test_support.h"
+
+#include <cstdio>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+ClickableRegion makeRegion(const char* identifier, int left, int top, int width, int height,
+                           RegionShape shape = RegionShape::Rect) {
+    ClickableRegion r;
+    r.identifier = identifier;
+    r.left = left;
+    r.top = top;
+    r.width = width;
+    r.height = height;
+    r.shape = shape;
+    return r;
+}
+
+/**
+ * @brief 单个点经 stage / run / firstHit 的结果（不限制 accept）
+ */
+int hitAt(RegionHitTable& table, int x, int y) {
+    const int point = table.stage(x, y);
+    table.run();
+    return table.firstHit(point, false, [](int) { return true; });
+}
+
+void testShapes() {
+    RegionHitTable table;
+
+    table.build({makeRegion("rect", 100, 100, 50, 20)});
+    EXPECT(table.contains(0, 100, 100) && table.contains(0, 149, 119), "矩形内边界");
+    EXPECT(!table.contains(0, 150, 110) && !table.contains(0, 120, 120) && !table.contains(0, 99, 110),
+           "矩形右 / 下边界应为开区间");
+
+    // 圆：直径 100，圆心 (150, 150)
+    table.build({makeRegion("circle", 100, 100, 100, 100, RegionShape::Circle)});
+    EXPECT(table.contains(0, 150, 150) && table.contains(0, 100, 150) && table.contains(0, 150, 199), "圆内");
+    EXPECT(!table.contains(0, 105, 105) && !table.contains(0, 194, 194), "外接矩形的角不应命中圆");
+    EXPECT(hitAt(table, 105, 105) == -1 && hitAt(table, 150, 150) == 0, "批量路径与单点一致");
+
+    // 长宽不等的 circle 为胶囊形：中段是矩形，两端半圆
+    table.build({makeRegion("capsule", 0, 0, 200, 100, RegionShape::Circle)});
+    EXPECT(table.contains(0, 100, 1) && table.contains(0, 1, 50), "胶囊中段 / 端点");
+    EXPECT(!table.contains(0, 3, 3) && !table.contains(0, 197, 97), "胶囊两端的角");
+
+    ClickableRegion rounded = makeRegion("rounded", 0, 0, 100, 100, RegionShape::RoundedRect);
+    rounded.cornerRadius = 20;
+    table.build({rounded});
+    EXPECT(!table.contains(0, 2, 2) && table.contains(0, 8, 8) && table.contains(0, 0, 50), "圆角矩形");
+
+    // padding：圆外扩 10 像素，收缩 10 像素
+    ClickableRegion padded = makeRegion("padded", 100, 100, 100, 100, RegionShape::Circle);
+    padded.padding = 10;
+    table.build({padded});
+    EXPECT(table.contains(0, 92, 150) && !table.contains(0, 88, 150), "圆外扩 10 像素");
+    padded.padding = -10;
+    table.build({padded});
+    EXPECT(!table.contains(0, 105, 150) && table.contains(0, 112, 150), "圆收缩 10 像素");
+    padded.padding = -60;
+    table.build({padded});
+    EXPECT(!table.contains(0, 150, 150), "收缩超过半径后应为空");
+
+    // 三角形 (0,0) (100,0) (0,100)，顶点相对于 left / top；顺逆时针结果相同
+    ClickableRegion triangle = makeRegion("triangle", 50, 50, 100, 100, RegionShape::Polygon);
+    triangle.polygon = {{0, 0}, {100, 0}, {0, 100}};
+    EXPECT(RegionHitTable::isConvexPolygon(triangle.polygon), "三角形应为凸多边形");
+    for (int reversed = 0; reversed < 2; ++reversed) {
+        table.build({triangle});
+        EXPECT(table.contains(0, 60, 60) && table.contains(0, 55, 140), "三角形内 (reversed=%d)", reversed);
+        EXPECT(!table.contains(0, 120, 120) && !table.contains(0, 149, 149), "三角形斜边外 (reversed=%d)", reversed);
+        triangle.polygon = {{0, 100}, {100, 0}, {0, 0}};
+    }
+    triangle.padding = 10;
+    table.build({triangle});
+    EXPECT(table.contains(0, 45, 100) && !table.contains(0, 35, 100), "多边形外扩 10 像素");
+
+    // 非凸（箭头形）按外接矩形处理
+    ClickableRegion concave = makeRegion("concave", 0, 0, 100, 100, RegionShape::Polygon);
+    concave.polygon = {{0, 0}, {100, 0}, {50, 50}, {100, 100}, {0, 100}};
+    EXPECT(!RegionHitTable::isConvexPolygon(concave.polygon), "箭头形不是凸多边形");
+    table.build({concave});
+    EXPECT(table.contains(0, 90, 50), "非凸多边形应退化为外接矩形");
+}
+
+void testPriority() {
+    RegionHitTable table;
+    ClickableRegion background = makeRegion("background", 0, 0, 500, 500);
+    ClickableRegion button = makeRegion("button", 100, 100, 100, 100, RegionShape::Circle);
+    ClickableRegion overlay = makeRegion("overlay", 0, 0, 500, 500);
+
+    // 优先级相同：区域表中靠前的优先
+    table.build({background, button, overlay});
+    EXPECT(hitAt(table, 150, 150) == 0, "相同优先级应取靠前的区域");
+
+    button.priority = 1;
+    table.build({background, button, overlay});
+    EXPECT(hitAt(table, 150, 150) == 1, "高优先级的圆应优先");
+    EXPECT(hitAt(table, 105, 105) == 0, "圆外的角落回到背景区域");
+
+    // accept 拒绝最高优先级时取下一个
+    const int point = table.stage(150, 150);
+    table.run();
+    EXPECT(table.firstHit(point, false, [](int r) { return r != 1; }) == 0, "拒绝后应取下一个候选");
+
+    // slideIn：只在 slideIn 区域中查找，外接矩形含 padding
+    button.slideIn = true;
+    button.padding = 20;
+    table.build({background, button, overlay});
+    EXPECT(table.hasSlideIn() && table.inSlideInBounds(80, 150) && !table.inSlideInBounds(79, 150),
+           "slideIn 外接矩形应包含 padding");
+    const int slidePoint = table.stage(85, 150);
+    table.run();
+    EXPECT(table.firstHit(slidePoint, true, [](int) { return true; }) == 1, "slideIn 查找");
+    table.build({background, overlay});
+    EXPECT(!table.hasSlideIn(), "没有 slideIn 区域");
+}
+
+void testBatch() {
+    std::vector<ClickableRegion> regions;
+    for (int i = 0; i < 70; ++i) {
+        const RegionShape shape = static_cast<RegionShape>(i % 4);
+        ClickableRegion r = makeRegion("r", (i % 10) * 90, (i / 10) * 90, 120, 100, shape);
+        r.cornerRadius = 25;
+        r.padding = (i % 3) * 4 - 4;
+        r.priority = i % 5;
+        if (shape == RegionShape::Polygon) {
+            r.polygon = {{60, 0}, {120, 50}, {60, 100}, {0, 50}};
+        }
+        regions.push_back(r);
+    }
+    RegionHitTable table;
+    table.build(regions);
+
+    std::vector<int> xs;
+    std::vector<int> ys;
+    uint32_t seed = 12345;
+    for (int t = 0; t < RegionHitTable::MAX_POINTS; ++t) {
+        seed = seed * 1103515245u + 12345u;
+        xs.push_back(static_cast<int>((seed >> 8) % 1000));
+        seed = seed * 1103515245u + 12345u;
+        ys.push_back(static_cast<int>((seed >> 8) % 700));
+        EXPECT(table.stage(xs.back(), ys.back()) == t, "测试点下标");
+    }
+    EXPECT(table.stage(0, 0) == -1, "超过 MAX_POINTS 应返回 -1");
+    table.run();
+
+    int mismatches = 0;
+    int hits = 0;
+    for (int t = 0; t < RegionHitTable::MAX_POINTS; ++t) {
+        // 收集批量结果（accept 恒为假，遍历全部候选）
+        std::vector<bool> batch(regions.size(), false);
+        table.firstHit(t, false, [&](int r) {
+            batch[r] = true;
+            return false;
+        });
+        int expected = -1;
+        for (size_t r = 0; r < regions.size(); ++r) {
+            const bool inside = table.contains(static_cast<int>(r), xs[t], ys[t]);
+            mismatches += inside != batch[r];
+            hits += inside;
+            if (inside && (expected < 0 || regions[r].priority > regions[expected].priority)) {
+                expected = static_cast<int>(r);
+            }
+        }
+        const int first = table.firstHit(t, false, [](int) { return true; });
+        EXPECT(first == expected, "点 %d 的最高优先级区域 %d，应为 %d", t, first, expected);
+    }
+    EXPECT(mismatches == 0, "批量与逐点结果不一致 %d 处", mismatches);
+    EXPECT(hits >= RegionHitTable::MAX_POINTS / 2, "测试点命中过少 (%d)", hits);
+}
+
+// ---------------------------------------------------------------------------
+// InputEngine
+// ---------------------------------------------------------------------------
+
+constexpr int kMaxX = 20000;
+constexpr int kMaxY = 10000;
+constexpr int kScreenW = 1000;
+constexpr int kScreenH = 2000;
+constexpr long long kEventUs = 1000000;
+
+/**
+ * @brief 悬浮窗坐标 (x, y) 对应的一根手指按下（屏幕 x = 原始 y / 10，y = (20000 - 原始 x) / 10）
+ */
+void appendDown(std::vector<struct input_event>& events, int slot, int x, int y) {
+    events.push_back(makeEvent(EV_ABS, ABS_MT_SLOT, slot, kEventUs));
+    events.push_back(makeEvent(EV_ABS, ABS_MT_TRACKING_ID, slot + 1, kEventUs));
+    events.push_back(makeEvent(EV_ABS, ABS_MT_POSITION_X, kMaxX - y * kMaxX / kScreenH, kEventUs));
+    events.push_back(makeEvent(EV_ABS, ABS_MT_POSITION_Y, x * kMaxY / kScreenW, kEventUs));
+}
+
+void testEngine() {
+    int pipeFds[2];
+    if (pipe(pipeFds) != 0) {
+        EXPECT(false, "pipe 失败");
+        return;
+    }
+    auto sink = std::make_shared<RecordingSink>();
+    InputEngine engine;
+    engine.setScreenDimensions(kScreenW, kScreenH);
+    ClickableRegion panel = makeRegion("panel", 0, 1000, 1000, 1000);
+    ClickableRegion fire = makeRegion("fire", 400, 400, 200, 200, RegionShape::Circle);
+    fire.priority = 1;
+    ClickableRegion backdrop = makeRegion("backdrop", 300, 300, 400, 400);
+    engine.setClickableRegions({panel, backdrop, fire});
+    engine.start(std::string(), sink);
+    engine.setDeviceFd(pipeFds[0], kMaxX, kMaxY);
+
+    // 同一帧三根手指：圆外接矩形的角（落到 backdrop）、圆心（fire 优先于 backdrop）、panel
+    std::vector<struct input_event> down;
+    appendDown(down, 0, 410, 410);
+    appendDown(down, 1, 500, 500);
+    appendDown(down, 2, 500, 1500);
+    down.push_back(makeEvent(EV_SYN, SYN_REPORT, 0, kEventUs));
+    EXPECT(writeEvents(pipeFds[1], down), "写管道失败");
+
+    waitFor([&] { return sink->touchFrames() > 0; });
+    engine.stop();
+    close(pipeFds[1]);
+
+    const auto taps = sink->taps();
+    EXPECT(taps.size() == 3, "点击数 %zu", taps.size());
+    if (taps.size() == 3) {
+        EXPECT(taps[0] == "backdrop", "角落的手指命中 %s", taps[0].c_str());
+        EXPECT(taps[1] == "fire", "圆心的手指命中 %s", taps[1].c_str());
+        EXPECT(taps[2] == "panel", "第三根手指命中 %s", taps[2].c_str());
+    }
+}
+
+} // namespace
+
+int main() {
+    testShapes();
+    testPriority();
+    testBatch();
+    testEngine();
+    if (g_failures != 0) {
+        std::fprintf(stderr, "%d failure(s)\n", g_failures);
+        return 1;
+    }
+    std::printf("region_hit_table_test: OK\n");
+    return 0;
+}
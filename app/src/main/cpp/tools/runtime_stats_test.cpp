@@ -0,0 +1,211 @@
+/**
+ * Native 运行时统计块测试。
+ *
+ *   1. 布局：与 Kotlin NativeRuntimeStats 约定的缓存行对齐与字段下标；
+ *   2. InputEngine：经管道 (setDeviceFd) 写入两指按下 -> 移动 -> 抬起，校验事件数、触摸帧数、当前手指数、
+ *      区域命中、输出批次与耗时、读取线程 CPU 时间；
+ *   3. PacketSender：写入 socketpair，校验已写出的包数 / 字节数、排队深度回到 0、send 耗时与 latest-wins 取代计数。
+ *
+ * 统计块是进程内全局的累计值，各部分按前后快照求差。
+ */
+#include "common/runtime_stats.h"
+#include "input/input_engine.h"
+#include "net/packet_codec.h"
+#include "net/packet_sender.h"
+#include "test_support.h"
+
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+constexpr int kMaxX = 20000;
+constexpr int kMaxY = 10000;
+constexpr int kScreenW = 1000;
+constexpr int kScreenH = 2000;
+
+struct Snapshot {
+    uint64_t values[RUNTIME_STATS_FIELD_COUNT];
+
+    static Snapshot take() {
+        Snapshot s;
+        for (size_t i = 0; i < RUNTIME_STATS_FIELD_COUNT; ++i) {
+            s.values[i] = g_runtimeStats.values[i].load(std::memory_order_relaxed);
+        }
+        return s;
+    }
+    uint64_t operator[](RuntimeStatsField field) const { return values[static_cast<size_t>(field)]; }
+};
+
+uint64_t delta(const Snapshot& before, const Snapshot& after, RuntimeStatsField field) {
+    return after[field] - before[field];
+}
+
+void testLayout() {
+    EXPECT(reinterpret_cast<uintptr_t>(&g_runtimeStats) % RUNTIME_STATS_LINE_BYTES == 0, "统计块未按缓存行对齐");
+    EXPECT(sizeof(g_runtimeStats) == RUNTIME_STATS_FIELD_COUNT * sizeof(uint64_t), "统计块大小 %zu", sizeof(g_runtimeStats));
+    // 读取线程与发送线程的字段各占一个缓存行
+    const uintptr_t base = reinterpret_cast<uintptr_t>(&g_runtimeStats);
+    const uintptr_t readerLine = (reinterpret_cast<uintptr_t>(&g_runtimeStats[RuntimeStatsField::ReaderCpuNs]) - base) / 64;
+    const uintptr_t senderLine = (reinterpret_cast<uintptr_t>(&g_runtimeStats[RuntimeStatsField::PacketsSent]) - base) / 64;
+    EXPECT(readerLine == 0 && senderLine == 1, "缓存行划分 reader=%zu sender=%zu", (size_t)readerLine, (size_t)senderLine);
+    EXPECT(static_cast<size_t>(RuntimeStatsField::SenderCpuNs) == 15, "字段下标与 Kotlin 不一致");
+}
+
+// ---------------------------------------------------------------------------
+// 读取线程
+// ---------------------------------------------------------------------------
+
+void testReader() {
+    int pipeFds[2];
+    if (pipe(pipeFds) != 0) {
+        EXPECT(false, "pipe 失败");
+        return;
+    }
+    const Snapshot before = Snapshot::take();
+
+    auto sink = std::make_shared<RecordingSink>();
+    InputEngine engine;
+    engine.setScreenDimensions(kScreenW, kScreenH);
+    // 左半屏一个区域：只有第一根手指落在区域内
+    ClickableRegion region;
+    region.identifier = "left";
+    region.width = kScreenW / 2;
+    region.height = kScreenH;
+    engine.setClickableRegions({region});
+    engine.start(std::string(), sink);
+    engine.setDeviceFd(pipeFds[0], kMaxX, kMaxY);
+
+    // 悬浮窗 x = 原始 y：原始 y=2000 -> x=200（区域内），原始 y=8000 -> x=800（区域外）
+    const long long baseUs = 1000000;
+    std::vector<struct input_event> down = {
+        makeEvent(EV_ABS, ABS_MT_SLOT, 0, baseUs), makeEvent(EV_ABS, ABS_MT_TRACKING_ID, 1, baseUs),
+        makeEvent(EV_ABS, ABS_MT_POSITION_X, 10000, baseUs), makeEvent(EV_ABS, ABS_MT_POSITION_Y, 2000, baseUs),
+        makeEvent(EV_ABS, ABS_MT_SLOT, 1, baseUs), makeEvent(EV_ABS, ABS_MT_TRACKING_ID, 2, baseUs),
+        makeEvent(EV_ABS, ABS_MT_POSITION_X, 10000, baseUs), makeEvent(EV_ABS, ABS_MT_POSITION_Y, 8000, baseUs),
+        makeEvent(EV_SYN, SYN_REPORT, 0, baseUs)};
+    size_t events = down.size();
+    EXPECT(writeEvents(pipeFds[1], down), "写管道失败");
+    EXPECT(waitFor([&] { return sink->touchFrames() >= 1; }), "没有按下帧");
+    EXPECT(g_runtimeStats.load(RuntimeStatsField::ActiveSlots) == 2, "两指按下后 ActiveSlots=%llu",
+           (unsigned long long)g_runtimeStats.load(RuntimeStatsField::ActiveSlots));
+
+    constexpr int kMoves = 10;
+    for (int i = 1; i <= kMoves; ++i) {
+        const long long t = baseUs + i * 2000;
+        std::vector<struct input_event> move = {
+            makeEvent(EV_ABS, ABS_MT_SLOT, 0, t), makeEvent(EV_ABS, ABS_MT_POSITION_X, 10000 + i * 10, t),
+            makeEvent(EV_SYN, SYN_REPORT, 0, t)};
+        events += move.size();
+        EXPECT(writeEvents(pipeFds[1], move), "写管道失败");
+    }
+    const long long upUs = baseUs + (kMoves + 1) * 2000;
+    std::vector<struct input_event> up = {
+        makeEvent(EV_ABS, ABS_MT_SLOT, 0, upUs), makeEvent(EV_ABS, ABS_MT_TRACKING_ID, -1, upUs),
+        makeEvent(EV_ABS, ABS_MT_SLOT, 1, upUs), makeEvent(EV_ABS, ABS_MT_TRACKING_ID, -1, upUs),
+        makeEvent(EV_SYN, SYN_REPORT, 0, upUs)};
+    events += up.size();
+    EXPECT(writeEvents(pipeFds[1], up), "写管道失败");
+
+    waitFor([&] {
+        return g_runtimeStats.load(RuntimeStatsField::InputEvents) - before[RuntimeStatsField::InputEvents] >= events
+            && g_runtimeStats.load(RuntimeStatsField::ActiveSlots) == 0;
+    });
+    engine.stop();
+    close(pipeFds[1]);
+    const Snapshot after = Snapshot::take();
+
+    EXPECT(delta(before, after, RuntimeStatsField::InputEvents) == events, "InputEvents=%llu，应为 %zu",
+           (unsigned long long)delta(before, after, RuntimeStatsField::InputEvents), events);
+    EXPECT(delta(before, after, RuntimeStatsField::TouchFrames) == static_cast<uint64_t>(sink->touchFrames()),
+           "TouchFrames=%llu，sink 收到 %d", (unsigned long long)delta(before, after, RuntimeStatsField::TouchFrames),
+           sink->touchFrames());
+    EXPECT(sink->touchFrames() >= kMoves + 1, "触摸帧 %d", sink->touchFrames());
+    EXPECT(after[RuntimeStatsField::ActiveSlots] == 0, "抬起后 ActiveSlots=%llu",
+           (unsigned long long)after[RuntimeStatsField::ActiveSlots]);
+    EXPECT(delta(before, after, RuntimeStatsField::RegionHits) == 1, "RegionHits=%llu",
+           (unsigned long long)delta(before, after, RuntimeStatsField::RegionHits));
+    const uint64_t flushes = delta(before, after, RuntimeStatsField::SinkFlushes);
+    EXPECT(flushes >= 1 && delta(before, after, RuntimeStatsField::SinkTimeNs) > 0, "SinkFlushes=%llu",
+           (unsigned long long)flushes);
+    EXPECT(delta(before, after, RuntimeStatsField::ReaderCpuNs) > 0, "读取线程退出后没有计入 CPU 时间");
+    EXPECT(delta(before, after, RuntimeStatsField::SyncDrops) == 0, "SyncDrops 非 0");
+}
+
+// ---------------------------------------------------------------------------
+// 发送线程
+// ---------------------------------------------------------------------------
+
+void testSender() {
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) != 0) {
+        EXPECT(false, "socketpair");
+        return;
+    }
+    const Snapshot before = Snapshot::take();
+
+    PacketSenderConfig config;
+    config.batchWindowUs = 200000; // 提交期间全部积压在队列中
+    config.maxBatchPackets = 64;
+    config.urgentTypeMask = 0;
+    config.latestWinsMinAgeUs = 0;
+    PacketSender sender;
+    EXPECT(sender.start(fds[0], config), "sender.start");
+
+    const uint8_t touch[9] = {};
+    const uint8_t device[8] = {};
+    constexpr int kTouches = 5;
+    for (int i = 0; i < kTouches; ++i) {
+        sender.submit(PACKET_TYPE_TOUCH, touch, sizeof(touch)); // 后一个取代前一个
+    }
+    sender.submit(PACKET_TYPE_DEVICE_INFO, device, sizeof(device));
+    EXPECT(g_runtimeStats.load(RuntimeStatsField::QueueDepth) - before[RuntimeStatsField::QueueDepth] == 2,
+           "排队深度 %llu", (unsigned long long)g_runtimeStats.load(RuntimeStatsField::QueueDepth));
+
+    sender.stop();
+    const Snapshot after = Snapshot::take();
+    std::vector<uint8_t> received(4096);
+    const ssize_t n = recv(fds[1], received.data(), received.size(), MSG_DONTWAIT);
+    close(fds[1]);
+
+    const uint64_t expectedBytes = 2 * V1_STANDARD_HEADER_SIZE + sizeof(touch) + sizeof(device);
+    EXPECT(delta(before, after, RuntimeStatsField::PacketsSent) == 2, "PacketsSent=%llu",
+           (unsigned long long)delta(before, after, RuntimeStatsField::PacketsSent));
+    EXPECT(delta(before, after, RuntimeStatsField::BytesSent) == expectedBytes && n == static_cast<ssize_t>(expectedBytes),
+           "BytesSent=%llu recv=%zd", (unsigned long long)delta(before, after, RuntimeStatsField::BytesSent), n);
+    EXPECT(delta(before, after, RuntimeStatsField::PacketsSuperseded) == kTouches - 1, "PacketsSuperseded=%llu",
+           (unsigned long long)delta(before, after, RuntimeStatsField::PacketsSuperseded));
+    EXPECT(after[RuntimeStatsField::QueueDepth] == before[RuntimeStatsField::QueueDepth], "停止后排队深度 %llu",
+           (unsigned long long)after[RuntimeStatsField::QueueDepth]);
+    EXPECT(delta(before, after, RuntimeStatsField::SendTimeNs) > 0, "SendTimeNs 为 0");
+    EXPECT(delta(before, after, RuntimeStatsField::SendErrors) == 0 && delta(before, after, RuntimeStatsField::PacketsDropped) == 0,
+           "错误 / 丢弃非 0");
+}
+
+void testTelemetryCodec() {
+    std::vector<uint8_t> payload(V1_TELEMETRY_HEADER_SIZE + RUNTIME_STATS_FIELD_COUNT * sizeof(uint64_t));
+    payload[0] = static_cast<uint8_t>(RUNTIME_STATS_FIELD_COUNT);
+    EXPECT(v2PayloadSize(PACKET_TYPE_TELEMETRY, payload.data(), payload.size()) == static_cast<long>(payload.size()),
+           "遥测 v2 长度");
+    EXPECT(v2PayloadSize(PACKET_TYPE_TELEMETRY, payload.data(), payload.size() - 8) == -1, "字段数与长度不符应拒绝");
+    EXPECT(v2PayloadSize(PACKET_TYPE_TELEMETRY, payload.data(), 4) == -1, "过短的遥测包应拒绝");
+}
+
+} // namespace
+
+int main() {
+    testLayout();
+    testReader();
+    testSender();
+    testTelemetryCodec();
+    if (g_failures != 0) {
+        std::fprintf(stderr, "%d failure(s)\n", g_failures);
+        return 1;
+    }
+    std::printf("runtime_stats_test: OK\n");
+    return 0;
+}
@@ -0,0 +1,264 @@
+#ifndef TOOLS_TEST_SUPPORT_H
+#define TOOLS_TEST_SUPPORT_H
+
+/**
+ * 主机测试与测量工具共用的辅助代码（仅头文件，每个测试是独立的可执行文件）。
+ *
+ *   - EXPECT / g_failures：失败时打印位置并计数，main 按 g_failures 决定返回值；
+ *   - makeEvent / writeEvents / waitFor：构造 input_event、整帧写入管道或 uinput、轮询等待读取线程；
+ *   - RecordingSink：记录引擎输出的触摸帧、区域事件、笔采样与外接设备帧；
+ *   - setAbs / createFakeTouchscreen / findEventNode：uinput 假触摸屏及其 evdev 节点；
+ *   - realtimeNowUs / sleepUntilMonotonicNs / writeAll：计时与阻塞写出。
+ */
+#include "input/input_engine.h"
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <dirent.h>
+#include <fcntl.h>
+#include <linux/uinput.h>
+#include <mutex>
+#include <string>
+#include <sys/ioctl.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+inline int g_failures = 0;
+
+#define EXPECT(cond, ...)                                    \
+    do {                                                     \
+        if (!(cond)) {                                       \
+            std::fprintf(stderr, "FAIL %s:%d: ", __FILE__, __LINE__); \
+            std::fprintf(stderr, __VA_ARGS__);               \
+            std::fprintf(stderr, "\n");                      \
+            ++g_failures;                                    \
+        }                                                    \
+    } while (0)
+
+// ---------------------------------------------------------------------------
+// evdev 事件
+// ---------------------------------------------------------------------------
+
+/**
+ * @brief 一个 input_event；timeUs 为 0 时时间戳为 0（引擎改用当前时间）
+ */
+inline struct input_event makeEvent(int type, int code, int value, long long timeUs = 0) {
+    struct input_event ev = {};
+    ev.time.tv_sec = timeUs / 1000000;
+    ev.time.tv_usec = timeUs % 1000000;
+    ev.type = static_cast<__u16>(type);
+    ev.code = static_cast<__u16>(code);
+    ev.value = value;
+    return ev;
+}
+
+/**
+ * @brief 一次 write 写出整组事件（管道或 uinput fd），保证读取线程在同一次 read 中看到整帧
+ */
+inline bool writeEvents(int fd, const std::vector<struct input_event>& events) {
+    const size_t bytes = events.size() * sizeof(struct input_event);
+    return write(fd, events.data(), bytes) == static_cast<ssize_t>(bytes);
+}
+
+/**
+ * @brief 每 5 ms 检查一次 pred，最多约 2 秒
+ */
+template <typename Pred>
+bool waitFor(Pred pred) {
+    for (int i = 0; i < 400; ++i) {
+        if (pred()) return true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    return pred();
+}
+
+// ---------------------------------------------------------------------------
+// 引擎输出
+// ---------------------------------------------------------------------------
+
+/**
+ * @brief 记录读取线程投递的所有输出；访问函数返回副本，可在测试线程上随时调用
+ */
+class RecordingSink : public InputEventSink {
+public:
+    void onTouchFrame(const TouchContact* contacts, int count, long long, bool) override {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            touches_.insert(touches_.end(), contacts, contacts + count);
+        }
+        touchFrames_.fetch_add(1, std::memory_order_release);
+    }
+    void onUiEvent(UiEventKind kind, const ClickableRegion& region, int, int, long long) override {
+        if (kind == UiEventKind::Tap) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            taps_.push_back(region.identifier);
+        }
+    }
+    void onPenSample(const PenSample& sample) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pens_.push_back(sample);
+    }
+    void onHidFrame(const HidFrame& frame) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        hidFrames_.push_back(frame);
+    }
+
+    int touchFrames() const { return touchFrames_.load(std::memory_order_acquire); }
+    std::vector<TouchContact> touches() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return touches_;
+    }
+    // 点击命中的区域 identifier，按投递顺序
+    std::vector<std::string> taps() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return taps_;
+    }
+    std::vector<PenSample> pens() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return pens_;
+    }
+    std::vector<HidFrame> hidFrames() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return hidFrames_;
+    }
+
+private:
+    std::atomic<int> touchFrames_{0};
+    std::mutex mutex_;
+    std::vector<TouchContact> touches_;
+    std::vector<std::string> taps_;
+    std::vector<PenSample> pens_;
+    std::vector<HidFrame> hidFrames_;
+};
+
+// ---------------------------------------------------------------------------
+// uinput 假触摸屏
+// ---------------------------------------------------------------------------
+
+inline void setAbs(int fd, int code, int maximum) {
+    struct uinput_abs_setup setup;
+    std::memset(&setup, 0, sizeof(setup));
+    setup.code = static_cast<__u16>(code);
+    setup.absinfo.maximum = maximum;
+    ioctl(fd, UI_SET_ABSBIT, code);
+    ioctl(fd, UI_ABS_SETUP, &setup);
+}
+
+/**
+ * @brief 假触摸屏的名称与轴范围；maxPressure / maxTouchMajor 为 0 时不声明该轴
+ */
+struct FakeTouchscreen {
+    const char* name;
+    uint16_t product;
+    int slots;
+    int maxX;
+    int maxY;
+    int maxPressure = 0;
+    int maxTouchMajor = 0;
+};
+
+/**
+ * @brief 创建假触摸屏，返回 uinput fd，sysName 为 sysfs 名称；/dev/uinput 不可用时返回 -1
+ */
+inline int createFakeTouchscreen(const FakeTouchscreen& spec, std::string& sysName) {
+    const int fd = open("/dev/uinput", O_WRONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return -1;
+    }
+    ioctl(fd, UI_SET_EVBIT, EV_SYN);
+    ioctl(fd, UI_SET_EVBIT, EV_KEY);
+    ioctl(fd, UI_SET_EVBIT, EV_ABS);
+    ioctl(fd, UI_SET_KEYBIT, BTN_TOUCH);
+    ioctl(fd, UI_SET_PROPBIT, INPUT_PROP_DIRECT);
+    setAbs(fd, ABS_MT_SLOT, spec.slots - 1);
+    setAbs(fd, ABS_MT_TRACKING_ID, 0xFFFF);
+    setAbs(fd, ABS_MT_POSITION_X, spec.maxX);
+    setAbs(fd, ABS_MT_POSITION_Y, spec.maxY);
+    if (spec.maxPressure > 0) {
+        setAbs(fd, ABS_MT_PRESSURE, spec.maxPressure);
+    }
+    if (spec.maxTouchMajor > 0) {
+        setAbs(fd, ABS_MT_TOUCH_MAJOR, spec.maxTouchMajor);
+    }
+
+    struct uinput_setup setup;
+    std::memset(&setup, 0, sizeof(setup));
+    std::snprintf(setup.name, sizeof(setup.name), "%s", spec.name);
+    setup.id.bustype = BUS_VIRTUAL;
+    setup.id.vendor = 0x1234;
+    setup.id.product = spec.product;
+    if (ioctl(fd, UI_DEV_SETUP, &setup) != 0 || ioctl(fd, UI_DEV_CREATE) != 0) {
+        close(fd);
+        return -1;
+    }
+    char name[64] = {};
+    ioctl(fd, UI_GET_SYSNAME(sizeof(name)), name);
+    sysName = name;
+    return fd;
+}
+
+/**
+ * @brief sysfs 名称对应的 /dev/input/eventN（等待 udev 创建节点且可读，最多 2 秒）；超时返回空串
+ */
+inline std::string findEventNode(const std::string& sysName) {
+    const std::string dir = "/sys/devices/virtual/input/" + sysName;
+    for (int attempt = 0; attempt < 200; ++attempt) {
+        if (DIR* d = opendir(dir.c_str())) {
+            std::string node;
+            while (dirent* entry = readdir(d)) {
+                if (std::strncmp(entry->d_name, "event", 5) == 0) {
+                    node = std::string("/dev/input/") + entry->d_name;
+                }
+            }
+            closedir(d);
+            if (!node.empty() && access(node.c_str(), R_OK) == 0) {
+                return node;
+            }
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return std::string();
+}
+
+// ---------------------------------------------------------------------------
+// 计时与写出
+// ---------------------------------------------------------------------------
+
+inline int64_t realtimeNowUs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+}
+
+inline void sleepUntilMonotonicNs(int64_t targetNs) {
+    struct timespec ts;
+    ts.tv_sec = static_cast<time_t>(targetNs / 1000000000LL);
+    ts.tv_nsec = static_cast<long>(targetNs % 1000000000LL);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR) {
+    }
+}
+
+/**
+ * @brief 写完 length 字节（处理短写与 EINTR）
+ */
+inline bool writeAll(int fd, const void* data, size_t length) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    size_t written = 0;
+    while (written < length) {
+        const ssize_t n = write(fd, bytes + written, length - written);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        written += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+#endif // TOOLS_TEST_SUPPORT_H
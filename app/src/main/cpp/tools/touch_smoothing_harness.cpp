@@ -0,0 +1,351 @@
+/**
+ * 触摸抖动过滤的离线评估。
+ *
+ *   touch_smoothing_harness [--min-cutoff Hz] [--beta B] [--dcutoff Hz] [capture.bin...]
+ *
+ * 输入为 nativeStartInputCapture 录下的原始 evdev 捕获文件：按协议 B 解码触摸设备的事件，
+ * 每个 SYN_REPORT 以内核时间戳驱动 OneEuroFilterBank（与设备上同一份实现），
+ * 然后对每个手指的轨迹报告：
+ *   - 残余抖动：静止段内原始 / 过滤后坐标相对参考轨迹的 RMS
+ *   - 附加延迟：移动段内过滤后轨迹与参考轨迹最吻合时的时间偏移
+ * 参考轨迹为原始坐标的居中滑动平均（对匀速移动无相位滞后）。坐标为面板原始单位，
+ * 设备上的过滤作用于屏幕像素，参数需按比例换算。
+ *
+ * 不带文件参数时运行一条合成轨迹（静止-匀速移动-静止，带均匀噪声），并校验过滤后
+ * 抖动至多为原始的一半、附加延迟不超过上限。
+ */
+#include "input/event_capture.h"
+#include "input/touch_smoothing.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr int MAX_SLOTS = OneEuroFilterBank::MAX_SLOTS;
+constexpr int64_t REFERENCE_HALF_WINDOW_US = 40000;  // 参考轨迹的滑动平均半宽
+constexpr double STATIONARY_SPEED = 30.0;             // 单位 / 秒
+constexpr double MOVING_SPEED = 300.0;
+constexpr int64_t MAX_SHIFT_US = 60000;
+constexpr int64_t SHIFT_STEP_US = 250;
+constexpr int SHIFT_STEPS = static_cast<int>(MAX_SHIFT_US / SHIFT_STEP_US) + 1;
+
+struct Sample {
+    int64_t tUs;
+    double rawX;
+    double rawY;
+    double filteredX;
+    double filteredY;
+};
+
+/**
+ * @brief 所有轨迹累计的统计量
+ */
+struct Metrics {
+    double rawSquared = 0;
+    double filteredSquared = 0;
+    long long stationarySamples = 0;
+    double shiftError[SHIFT_STEPS] = {};
+    long long movingSamples = 0;
+    long long tracks = 0;
+
+    double rawJitter() const { return stationarySamples ? std::sqrt(rawSquared / stationarySamples) : 0; }
+    double filteredJitter() const {
+        return stationarySamples ? std::sqrt(filteredSquared / stationarySamples) : 0;
+    }
+    double latencyMs() const {
+        if (movingSamples == 0) {
+            return 0;
+        }
+        int best = 0;
+        for (int k = 1; k < SHIFT_STEPS; ++k) {
+            if (shiftError[k] < shiftError[best]) {
+                best = k;
+            }
+        }
+        return best * SHIFT_STEP_US / 1000.0;
+    }
+};
+
+/**
+ * @brief 参考轨迹在时间 t 的线性插值
+ */
+bool interpolate(const std::vector<Sample>& track, const std::vector<double>& refX,
+                 const std::vector<double>& refY, int64_t t, double& x, double& y) {
+    if (track.empty() || t < track.front().tUs || t > track.back().tUs) {
+        return false;
+    }
+    size_t lo = 0;
+    size_t hi = track.size() - 1;
+    while (hi - lo > 1) {
+        const size_t mid = (lo + hi) / 2;
+        if (track[mid].tUs <= t) lo = mid; else hi = mid;
+    }
+    const int64_t span = track[hi].tUs - track[lo].tUs;
+    const double f = span > 0 ? static_cast<double>(t - track[lo].tUs) / span : 0.0;
+    x = refX[lo] + f * (refX[hi] - refX[lo]);
+    y = refY[lo] + f * (refY[hi] - refY[lo]);
+    return true;
+}
+
+void analyzeTrack(const std::vector<Sample>& track, Metrics& metrics) {
+    if (track.size() < 8) {
+        return;
+    }
+    ++metrics.tracks;
+    const size_t n = track.size();
+    std::vector<double> refX(n), refY(n);
+    size_t lo = 0;
+    size_t hi = 0;
+    double sumX = 0;
+    double sumY = 0;
+    for (size_t i = 0; i < n; ++i) {
+        while (hi < n && track[hi].tUs <= track[i].tUs + REFERENCE_HALF_WINDOW_US) {
+            sumX += track[hi].rawX;
+            sumY += track[hi].rawY;
+            ++hi;
+        }
+        while (track[lo].tUs < track[i].tUs - REFERENCE_HALF_WINDOW_US) {
+            sumX -= track[lo].rawX;
+            sumY -= track[lo].rawY;
+            ++lo;
+        }
+        refX[i] = sumX / (hi - lo);
+        refY[i] = sumY / (hi - lo);
+    }
+
+    for (size_t i = 1; i + 1 < n; ++i) {
+        // 离轨迹两端不足一个窗口的点参考值不可靠
+        if (track[i].tUs - track.front().tUs < REFERENCE_HALF_WINDOW_US
+            || track.back().tUs - track[i].tUs < REFERENCE_HALF_WINDOW_US) {
+            continue;
+        }
+        const double dt = (track[i + 1].tUs - track[i - 1].tUs) * 1e-6;
+        if (dt <= 0) {
+            continue;
+        }
+        const double speed = std::hypot(refX[i + 1] - refX[i - 1], refY[i + 1] - refY[i - 1]) / dt;
+        if (speed < STATIONARY_SPEED) {
+            const double rx = track[i].rawX - refX[i];
+            const double ry = track[i].rawY - refY[i];
+            const double fx = track[i].filteredX - refX[i];
+            const double fy = track[i].filteredY - refY[i];
+            metrics.rawSquared += rx * rx + ry * ry;
+            metrics.filteredSquared += fx * fx + fy * fy;
+            ++metrics.stationarySamples;
+        } else if (speed >= MOVING_SPEED && track[i].tUs - track.front().tUs >= MAX_SHIFT_US) {
+            for (int k = 0; k < SHIFT_STEPS; ++k) {
+                double x = 0;
+                double y = 0;
+                if (interpolate(track, refX, refY, track[i].tUs - k * SHIFT_STEP_US, x, y)) {
+                    const double ex = track[i].filteredX - x;
+                    const double ey = track[i].filteredY - y;
+                    metrics.shiftError[k] += ex * ex + ey * ey;
+                }
+            }
+            ++metrics.movingSamples;
+        }
+    }
+}
+
+/**
+ * @brief 协议 B 解码 + 过滤，按 tracking id 切分轨迹
+ */
+class TraceDecoder {
+public:
+    explicit TraceDecoder(const OneEuroParams& params) : params_(params) {}
+
+    void feed(const CaptureRecord& record) {
+        if (record.deviceTag != CAPTURE_DEVICE_TOUCH) {
+            return;
+        }
+        if (record.type == EV_ABS) {
+            if (record.code == ABS_MT_SLOT) {
+                slot_ = (record.value >= 0 && record.value < MAX_SLOTS) ? record.value : 0;
+            } else if (record.code == ABS_MT_TRACKING_ID) {
+                finishTrack(slot_);
+                slots_[slot_].id = record.value;
+                if (record.value >= 0) {
+                    filter_.reset(slot_);
+                }
+            } else if (record.code == ABS_MT_POSITION_X) {
+                slots_[slot_].x = record.value;
+            } else if (record.code == ABS_MT_POSITION_Y) {
+                slots_[slot_].y = record.value;
+            }
+        } else if (record.type == EV_SYN && record.code == SYN_REPORT) {
+            for (int i = 0; i < MAX_SLOTS; ++i) {
+                if (slots_[i].id >= 0) {
+                    filter_.stage(i, static_cast<float>(slots_[i].x), static_cast<float>(slots_[i].y), params_);
+                }
+            }
+            filter_.run(record.eventTimeUs);
+            for (int i = 0; i < MAX_SLOTS; ++i) {
+                if (slots_[i].id >= 0) {
+                    slots_[i].track.push_back(Sample{record.eventTimeUs, double(slots_[i].x), double(slots_[i].y),
+                                                     filter_.x(i), filter_.y(i)});
+                }
+            }
+            ++frames_;
+        }
+    }
+
+    void finish() {
+        for (int i = 0; i < MAX_SLOTS; ++i) {
+            finishTrack(i);
+        }
+    }
+
+    const Metrics& metrics() const { return metrics_; }
+    long long frames() const { return frames_; }
+
+private:
+    struct SlotState {
+        int id = -1;
+        int x = 0;
+        int y = 0;
+        std::vector<Sample> track;
+    };
+
+    void finishTrack(int slot) {
+        analyzeTrack(slots_[slot].track, metrics_);
+        slots_[slot].track.clear();
+    }
+
+    OneEuroParams params_;
+    OneEuroFilterBank filter_;
+    SlotState slots_[MAX_SLOTS];
+    int slot_ = 0;
+    long long frames_ = 0;
+    Metrics metrics_;
+};
+
+void report(const std::string& name, const TraceDecoder& decoder) {
+    const Metrics& m = decoder.metrics();
+    std::printf("%s: %lld 帧, %lld 条轨迹\n", name.c_str(), decoder.frames(), m.tracks);
+    std::printf("  残余抖动 (RMS, %lld 个静止样本): 原始 %.2f -> 过滤后 %.2f\n",
+        m.stationarySamples, m.rawJitter(), m.filteredJitter());
+    std::printf("  附加延迟 (%lld 个移动样本): %.2f ms\n", m.movingSamples, m.latencyMs());
+}
+
+bool runCaptureFile(const std::string& path, const OneEuroParams& params) {
+    std::ifstream in(path, std::ios::binary);
+    CaptureFileHeader header;
+    if (!in.read(reinterpret_cast<char*>(&header), sizeof(header))
+        || std::memcmp(header.magic, CAPTURE_FILE_MAGIC, sizeof(header.magic)) != 0
+        || header.recordSize != sizeof(CaptureRecord)) {
+        std::fprintf(stderr, "%s: 不是捕获文件\n", path.c_str());
+        return false;
+    }
+    in.seekg(header.headerSize);
+    TraceDecoder decoder(params);
+    CaptureRecord record;
+    for (uint64_t i = 0; i < header.recordCount && in.read(reinterpret_cast<char*>(&record), sizeof(record)); ++i) {
+        decoder.feed(record);
+    }
+    decoder.finish();
+    report(path, decoder);
+    return true;
+}
+
+/**
+ * @brief 合成轨迹：240Hz，两根手指。slot 0 静止 600ms → 以 (3000, 1000)/s 移动 500ms → 静止 600ms；
+ *        slot 1 全程静止。坐标带 ±4 的均匀噪声。
+ */
+bool runSynthetic(const OneEuroParams& params) {
+    TraceDecoder decoder(params);
+    uint32_t seed = 12345;
+    auto noise = [&]() {
+        seed = seed * 1664525u + 1013904223u;
+        return static_cast<int>((seed >> 16) % 9) - 4;
+    };
+    auto emit = [&](int64_t tUs, uint16_t type, uint16_t code, int32_t value) {
+        CaptureRecord record = {};
+        record.eventTimeUs = tUs;
+        record.deviceTag = CAPTURE_DEVICE_TOUCH;
+        record.type = type;
+        record.code = code;
+        record.value = value;
+        decoder.feed(record);
+    };
+
+    const int64_t frameUs = 1000000 / 240;
+    const int64_t startUs = 1000000;
+    const int64_t moveStartUs = 600000;
+    const int64_t moveEndUs = 1100000;
+    const int64_t endUs = 1700000;
+    for (int64_t t = 0; t <= endUs; t += frameUs) {
+        const double moveSeconds = (std::min(std::max(t, moveStartUs), moveEndUs) - moveStartUs) * 1e-6;
+        const int x0 = 5000 + static_cast<int>(3000 * moveSeconds);
+        const int y0 = 8000 + static_cast<int>(1000 * moveSeconds);
+        emit(startUs + t, EV_ABS, ABS_MT_SLOT, 0);
+        if (t == 0) emit(startUs + t, EV_ABS, ABS_MT_TRACKING_ID, 1);
+        emit(startUs + t, EV_ABS, ABS_MT_POSITION_X, x0 + noise());
+        emit(startUs + t, EV_ABS, ABS_MT_POSITION_Y, y0 + noise());
+        emit(startUs + t, EV_ABS, ABS_MT_SLOT, 1);
+        if (t == 0) emit(startUs + t, EV_ABS, ABS_MT_TRACKING_ID, 2);
+        emit(startUs + t, EV_ABS, ABS_MT_POSITION_X, 12000 + noise());
+        emit(startUs + t, EV_ABS, ABS_MT_POSITION_Y, 3000 + noise());
+        emit(startUs + t, EV_SYN, SYN_REPORT, 0);
+    }
+    emit(startUs + endUs + frameUs, EV_ABS, ABS_MT_SLOT, 0);
+    emit(startUs + endUs + frameUs, EV_ABS, ABS_MT_TRACKING_ID, -1);
+    emit(startUs + endUs + frameUs, EV_ABS, ABS_MT_SLOT, 1);
+    emit(startUs + endUs + frameUs, EV_ABS, ABS_MT_TRACKING_ID, -1);
+    emit(startUs + endUs + frameUs, EV_SYN, SYN_REPORT, 0);
+    decoder.finish();
+    report("synthetic", decoder);
+
+    const Metrics& m = decoder.metrics();
+    constexpr double MAX_LATENCY_MS = 30.0;
+    bool ok = true;
+    if (m.stationarySamples == 0 || m.movingSamples == 0) {
+        std::printf("  FAIL: 合成轨迹没有静止或移动样本\n");
+        ok = false;
+    }
+    if (m.filteredJitter() > m.rawJitter() * 0.5) {
+        std::printf("  FAIL: 过滤后抖动 %.2f 超过原始的一半 (%.2f)\n", m.filteredJitter(), m.rawJitter());
+        ok = false;
+    }
+    if (m.latencyMs() > MAX_LATENCY_MS) {
+        std::printf("  FAIL: 附加延迟 %.2f ms 超过 %.0f ms\n", m.latencyMs(), MAX_LATENCY_MS);
+        ok = false;
+    }
+    return ok;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    OneEuroParams params;
+    std::vector<std::string> files;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--min-cutoff" && i + 1 < argc) {
+            params.minCutoffHz = std::strtof(argv[++i], nullptr);
+        } else if (arg == "--beta" && i + 1 < argc) {
+            params.beta = std::strtof(argv[++i], nullptr);
+        } else if (arg == "--dcutoff" && i + 1 < argc) {
+            params.derivativeCutoffHz = std::strtof(argv[++i], nullptr);
+        } else {
+            files.push_back(arg);
+        }
+    }
+    std::printf("参数: minCutoff=%.3f Hz, beta=%.5f, dCutoff=%.3f Hz\n",
+        params.minCutoffHz, params.beta, params.derivativeCutoffHz);
+
+    bool ok = true;
+    if (files.empty()) {
+        ok = runSynthetic(params);
+    }
+    for (const auto& file : files) {
+        ok = runCaptureFile(file, params) && ok;
+    }
+    return ok ? 0 : 1;
+}
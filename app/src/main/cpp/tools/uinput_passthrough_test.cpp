@@ -0,0 +1,235 @@
+/**
+ * 独占模式 uinput 转发的 Linux 测试。
+ *
+ * 用 uinput 创建一块假触摸屏作为源设备，按读取线程的方式 EVIOCGRAB 后读取它的事件，
+ * 交给 UinputPassthrough 转发到虚拟触摸屏，再从虚拟触摸屏的 evdev 节点读回。
+ *
+ * 检查：虚拟设备的轴范围与源设备一致、独占后其他读者收不到源设备事件、
+ *       转发的坐标与 tracking 状态正确、被消费的手指在虚拟设备上抬起、close() 抬起所有手指。
+ * 报告：源设备事件时间 -> 虚拟设备事件时间（两者都是内核 CLOCK_MONOTONIC 时间戳），
+ *       即转发路径引入的额外延迟。
+ *
+ * 需要 /dev/uinput 与 /dev/input 读写权限；不可用时返回 77（ctest 记为跳过）。
+ */
+#include "input/uinput_passthrough.h"
+#include "test_support.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <linux/uinput.h>
+#include <poll.h>
+#include <string>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+constexpr int kSkip = 77;
+constexpr int kSlots = 10;
+constexpr int kMaxX = 1079;
+constexpr int kMaxY = 2399;
+
+/**
+ * @brief 打开 sysfs 名称对应的 /dev/input/eventN（等待 udev 创建节点，最多 2 秒）
+ */
+int openEventNode(const std::string& sysName) {
+    const std::string node = findEventNode(sysName);
+    if (node.empty()) {
+        return -1;
+    }
+    const int fd = open(node.c_str(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+    if (fd >= 0) {
+        int clock = CLOCK_MONOTONIC;
+        ioctl(fd, EVIOCSCLOCKID, &clock);
+    }
+    return fd;
+}
+
+/**
+ * @brief 读一帧（到 SYN_REPORT 为止），超时返回 false
+ */
+bool readFrame(int fd, std::vector<input_event>& frame, int timeoutMs) {
+    frame.clear();
+    for (;;) {
+        input_event ev;
+        const ssize_t n = read(fd, &ev, sizeof(ev));
+        if (n == static_cast<ssize_t>(sizeof(ev))) {
+            frame.push_back(ev);
+            if (ev.type == EV_SYN && ev.code == SYN_REPORT) {
+                return true;
+            }
+            continue;
+        }
+        struct pollfd pfd = {fd, POLLIN, 0};
+        if (poll(&pfd, 1, timeoutMs) <= 0) {
+            return false;
+        }
+    }
+}
+
+/**
+ * @brief 按读取线程的方式把一帧原始事件应用到 slot 状态
+ */
+void applyFrame(TouchSlots& slots, int& currentSlot, const std::vector<input_event>& frame) {
+    for (const auto& ev : frame) {
+        if (ev.type != EV_ABS) {
+            continue;
+        }
+        if (ev.code == ABS_MT_SLOT) {
+            currentSlot = ev.value;
+        } else if (ev.code == ABS_MT_TRACKING_ID) {
+            slots.id[currentSlot] = ev.value;
+            if (ev.value < 0) {
+                slots.active &= ~slotBit(currentSlot);
+            } else {
+                slots.active |= slotBit(currentSlot);
+            }
+        } else if (ev.code == ABS_MT_POSITION_X) {
+            slots.x[currentSlot] = ev.value;
+        } else if (ev.code == ABS_MT_POSITION_Y) {
+            slots.y[currentSlot] = ev.value;
+        } else if (ev.code == ABS_MT_PRESSURE) {
+            slots.pressure[currentSlot] = ev.value;
+        }
+    }
+}
+
+long long eventTimeUs(const input_event& ev) {
+    return (long long)ev.time.tv_sec * 1000000 + ev.time.tv_usec;
+}
+
+} // namespace
+
+int main() {
+    std::string fakeSysName;
+    const int fake = createFakeTouchscreen({"passthrough-test touchscreen", 0x5678, kSlots, kMaxX, kMaxY, 255}, fakeSysName);
+    if (fake < 0) {
+        std::printf("uinput passthrough: /dev/uinput 不可用 (%s)，跳过\n", std::strerror(errno));
+        return kSkip;
+    }
+    const int source = openEventNode(fakeSysName);
+    const int bystander = openEventNode(fakeSysName);
+    if (source < 0 || bystander < 0) {
+        std::printf("uinput passthrough: 无法打开 %s 的 evdev 节点，跳过\n", fakeSysName.c_str());
+        ioctl(fake, UI_DEV_DESTROY);
+        return kSkip;
+    }
+
+    UinputPassthrough passthrough;
+    EXPECT(passthrough.open(source, kSlots), "open: %s", std::strerror(errno));
+    EXPECT(ioctl(source, EVIOCGRAB, 1) == 0, "EVIOCGRAB: %s", std::strerror(errno));
+    const int mirror = openEventNode(passthrough.sysName());
+    EXPECT(mirror >= 0, "mirror node for %s", passthrough.sysName().c_str());
+    if (mirror < 0) {
+        return 1;
+    }
+
+    // 轴范围与源设备一致
+    const int axes[] = {ABS_MT_SLOT, ABS_MT_POSITION_X, ABS_MT_POSITION_Y, ABS_MT_PRESSURE};
+    for (int code : axes) {
+        struct input_absinfo a, b;
+        EXPECT(ioctl(source, EVIOCGABS(code), &a) == 0 && ioctl(mirror, EVIOCGABS(code), &b) == 0
+               && a.minimum == b.minimum && a.maximum == b.maximum, "axis 0x%x range", code);
+    }
+
+    TouchSlots slots;
+    slots.capacity = kSlots;
+    int currentSlot = 0;
+    std::vector<input_event> frame;
+    std::vector<input_event> mirrored;
+    std::vector<long long> latencies;
+
+    // 单指拖动：每帧经源设备 -> 转发 -> 虚拟设备，比较坐标与时间戳
+    constexpr int kFrames = 300;
+    for (int i = 0; i < kFrames; ++i) {
+        std::vector<input_event> events = {makeEvent(EV_ABS, ABS_MT_SLOT, 0)};
+        if (i == 0) {
+            events.push_back(makeEvent(EV_ABS, ABS_MT_TRACKING_ID, 7));
+            events.push_back(makeEvent(EV_KEY, BTN_TOUCH, 1));
+        }
+        events.push_back(makeEvent(EV_ABS, ABS_MT_POSITION_X, 100 + i));
+        events.push_back(makeEvent(EV_ABS, ABS_MT_POSITION_Y, 200 + 2 * i));
+        events.push_back(makeEvent(EV_ABS, ABS_MT_PRESSURE, 40 + i % 50));
+        events.push_back(makeEvent(EV_SYN, SYN_REPORT, 0));
+        writeEvents(fake, events);
+
+        if (!readFrame(source, frame, 1000)) {
+            EXPECT(false, "frame %d: 源设备超时", i);
+            break;
+        }
+        applyFrame(slots, currentSlot, frame);
+        EXPECT(passthrough.writeFrame(slots, slots.active) > 0, "frame %d: writeFrame", i);
+        if (!readFrame(mirror, mirrored, 1000)) {
+            EXPECT(false, "frame %d: 虚拟设备超时", i);
+            break;
+        }
+        int x = -1;
+        int y = -1;
+        for (const auto& ev : mirrored) {
+            if (ev.type == EV_ABS && ev.code == ABS_MT_POSITION_X) x = ev.value;
+            if (ev.type == EV_ABS && ev.code == ABS_MT_POSITION_Y) y = ev.value;
+        }
+        EXPECT(x == 100 + i && y == 200 + 2 * i, "frame %d: 转发坐标 (%d,%d)", i, x, y);
+        latencies.push_back(eventTimeUs(mirrored.back()) - eventTimeUs(frame.back()));
+    }
+
+    // 独占期间其他读者收不到源设备事件
+    EXPECT(!readFrame(bystander, frame, 50), "独占后旁观者仍收到事件");
+
+    // 第二根手指落在区域上（被消费）：不转发；随后第一根手指改为被消费，虚拟设备上抬起
+    slots.id[1] = 8;
+    slots.x[1] = 500;
+    slots.y[1] = 600;
+    slots.active |= slotBit(1);
+    EXPECT(passthrough.writeFrame(slots, slots.active & ~slotBit(1)) == 0, "被消费的手指不应产生事件");
+    EXPECT(passthrough.writeFrame(slots, slots.active & ~slotBit(0)) > 0, "交换转发集合");
+    EXPECT(readFrame(mirror, mirrored, 1000), "交换帧超时");
+    bool lifted0 = false;
+    bool landed1 = false;
+    int slot = -1;
+    for (const auto& ev : mirrored) {
+        if (ev.type == EV_ABS && ev.code == ABS_MT_SLOT) slot = ev.value;
+        if (ev.type == EV_ABS && ev.code == ABS_MT_TRACKING_ID) {
+            lifted0 |= slot == 0 && ev.value == -1;
+            landed1 |= slot == 1 && ev.value >= 0;
+        }
+    }
+    EXPECT(lifted0 && landed1, "交换帧: lifted0=%d landed1=%d", lifted0, landed1);
+
+    // close() 抬起剩余手指
+    passthrough.close();
+    EXPECT(readFrame(mirror, mirrored, 1000), "close 帧超时");
+    bool btnUp = false;
+    for (const auto& ev : mirrored) {
+        btnUp |= ev.type == EV_KEY && ev.code == BTN_TOUCH && ev.value == 0;
+    }
+    EXPECT(btnUp, "close 后未抬起 BTN_TOUCH");
+
+    if (!latencies.empty()) {
+        std::sort(latencies.begin(), latencies.end());
+        long long sum = 0;
+        for (long long v : latencies) sum += v;
+        std::printf("passthrough latency: n=%zu mean=%lldus p50=%lldus p99=%lldus max=%lldus\n",
+                    latencies.size(), sum / static_cast<long long>(latencies.size()),
+                    latencies[latencies.size() / 2], latencies[latencies.size() * 99 / 100],
+                    latencies.back());
+    }
+
+    close(mirror);
+    close(bystander);
+    close(source);
+    ioctl(fake, UI_DEV_DESTROY);
+    close(fake);
+
+    if (g_failures > 0) {
+        std::fprintf(stderr, "%d failure(s)\n", g_failures);
+        return 1;
+    }
+    std::printf("uinput passthrough: OK\n");
+    return 0;
+}
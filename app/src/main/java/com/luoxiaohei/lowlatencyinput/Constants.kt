@@ -22,6 +22,202 @@ object Constants {
      */
     const val CONNECTION_TIMEOUT_MS = 5000
 
+    /**
+     * Native 发送器的批处理窗口（微秒）：第一个包入队后最多等待这么久再统一写出。
+     */
+    const val TRANSPORT_BATCH_WINDOW_US = 250
+
+    /**
+     * Native 发送器单次系统调用最多合并的数据包数量。
+     */
+    const val TRANSPORT_MAX_BATCH_PACKETS = 16
+
+    /**
+     * 是否把发出的包头时间戳换算为接收端时钟（由时钟同步估计，PING 与时钟同步请求除外），
+     * 接收端可直接用 收到时间 - 包头时间戳 得到单向延迟。需要接收端支持 [PACKET_TYPE_CLOCK_SYNC]。
+     */
+    const val TRANSPORT_RECEIVER_TIMESTAMPS = false
+
+    /**
+     * 是否与接收端协商 v2 协议（统一小端包头 + 对齐记录，见 native 的 protocol_v2.h）。
+     * 接收端在连接后 [PROTOCOL_HELLO_TIMEOUT_MS] 内没有发送 [PACKET_TYPE_SERVER_HELLO] 时使用 v1。
+     */
+    const val PROTOCOL_V2_ENABLED = true
+    const val PROTOCOL_HELLO_TIMEOUT_MS = 300
+
+    /**
+     * v2 握手中的能力位，与 protocol_v2.h 中的 PROTOCOL_CAP_* 对应。
+     */
+    const val PROTOCOL_CAP_CLOCK_SYNC = 1 shl 0
+    const val PROTOCOL_CAP_RECEIVER_TIMESTAMPS = 1 shl 1
+    const val PROTOCOL_CAP_TOUCH_EXTENDED = 1 shl 2
+    const val PROTOCOL_CAP_PEN = 1 shl 3
+    const val PROTOCOL_CAP_HID = 1 shl 4
+    const val PROTOCOL_CAP_TELEMETRY = 1 shl 5
+
+    /**
+     * 连接建立后连续发送的时钟同步请求数量与间隔，之后随每次 PING 发送一次。
+     */
+    const val CLOCK_SYNC_BURST_COUNT = 8
+    const val CLOCK_SYNC_BURST_INTERVAL_MS = 20L
+
+    /**
+     * Native 线程调度策略：0 = SCHED_OTHER (nice)，1 = SCHED_FIFO，2 = SCHED_RR。
+     * 实时策略被系统拒绝时回退到 [NATIVE_THREAD_NICE]。
+     */
+    const val NATIVE_THREAD_SCHED_POLICY = 1
+
+    /**
+     * 实时调度优先级 (1-99)，仅 SCHED_FIFO/SCHED_RR 使用。
+     */
+    const val NATIVE_THREAD_RT_PRIORITY = 2
+
+    /**
+     * 普通调度下（或实时调度被拒绝时）使用的 nice 值。
+     */
+    const val NATIVE_THREAD_NICE = -10
+
+    /**
+     * 输入读取线程绑定的 CPU 位掩码，0 表示不绑定（各机型大小核编号不同，需按设备调整）。
+     */
+    const val INPUT_THREAD_CPU_MASK = 0L
+
+    /**
+     * 发送线程绑定的 CPU 位掩码，0 表示不绑定。
+     */
+    const val SENDER_THREAD_CPU_MASK = 0L
+
+    /**
+     * Native 线程启动时预先触碰并锁定的栈大小 (KB)。
+     */
+    const val NATIVE_THREAD_PREFAULT_STACK_KB = 64
+
+    /**
+     * 是否开启输入线程唤醒延迟（抖动）测量。
+     */
+    const val INPUT_JITTER_MEASUREMENT = false
+
+    /**
+     * 是否把原始触摸事件捕获到应用私有目录下的 [INPUT_CAPTURE_FILE_NAME]，用于离线回放与问题复现。
+     */
+    const val INPUT_CAPTURE_ENABLED = false
+
+    /**
+     * 捕获文件名（位于 filesDir）。
+     */
+    const val INPUT_CAPTURE_FILE_NAME = "input_capture.bin"
+
+    /**
+     * 捕获文件容量（事件数，每条 32 字节），启动捕获时一次性预分配。
+     */
+    const val INPUT_CAPTURE_MAX_EVENTS = 1_000_000
+
+    /**
+     * 是否把 Native 热路径跟踪日志在 logcat 之外追加写入 filesDir 下的 [TRACE_LOG_FILE_NAME]。
+     */
+    const val TRACE_LOG_FILE_ENABLED = false
+
+    /**
+     * Native 跟踪日志文件名（位于 filesDir）。
+     */
+    const val TRACE_LOG_FILE_NAME = "native_trace.log"
+
+    /**
+     * 是否经共享内存事件环（而非 JNI 批量回调）把 Native 输入事件交给 Kotlin 消费线程。
+     */
+    const val INPUT_RING_ENABLED = false
+
+    /**
+     * 事件环容量（记录数，每条 64 字节，向上取整为 2 的幂）。
+     */
+    const val INPUT_RING_CAPACITY = 4096
+
+    /**
+     * 是否开启 Native 触摸质量过滤（手掌 / 握持 / 边缘误触），被拒绝的手指不参与区域也不发送。
+     */
+    const val TOUCH_FILTER_ENABLED = false
+
+    /**
+     * 接触长轴或短轴超过设备轴范围的该千分比时视为手掌，0 表示不检查。
+     */
+    const val TOUCH_FILTER_MAX_SIZE_PERMILLE = 250
+
+    /**
+     * 按下时压力低于设备轴范围的该千分比时拒绝，0 表示不检查。
+     */
+    const val TOUCH_FILTER_MIN_PRESSURE_PERMILLE = 0
+
+    /**
+     * 屏幕四边的拒绝区宽度 (像素)：在其中按下的手指被视为握持误触。
+     */
+    const val TOUCH_FILTER_EDGE_LEFT_PX = 0
+    const val TOUCH_FILTER_EDGE_TOP_PX = 0
+    const val TOUCH_FILTER_EDGE_RIGHT_PX = 0
+    const val TOUCH_FILTER_EDGE_BOTTOM_PX = 0
+
+    /**
+     * 是否拒绝设备报告为手掌 (MT_TOOL_PALM) 的接触。
+     */
+    const val TOUCH_FILTER_REJECT_PALM_TOOL = true
+
+    /**
+     * 是否以 [PACKET_TYPE_TOUCH_EXTENDED] 发送附带压力与接触尺寸的触摸数据。
+     */
+    const val TOUCH_EXTENDED_CONTACTS = false
+
+    /**
+     * 是否对发送的触摸坐标做 One Euro 抖动过滤（区域命中测试仍使用原始坐标）。
+     */
+    const val TOUCH_SMOOTHING_ENABLED = false
+
+    /**
+     * One Euro 滤波器的全局参数（像素 / 秒），区域可在布局中用 smoothing 覆盖。
+     */
+    const val TOUCH_SMOOTHING_MIN_CUTOFF_HZ = 1.0f
+    const val TOUCH_SMOOTHING_BETA = 0.007f
+    const val TOUCH_SMOOTHING_DERIVATIVE_CUTOFF_HZ = 1.0f
+
+    /**
+     * 是否独占触摸屏 (EVIOCGRAB)：系统只经 uinput 虚拟触摸屏收到未被悬浮窗区域消费的手指，
+     * 区域的 "passThrough" 策略可让绑定的手指也转发。需要 /dev/uinput 写权限。
+     */
+    const val INPUT_EXCLUSIVE_GRAB = false
+
+    /**
+     * 是否解码主动笔 (BTN_TOOL_PEN) 并以 [PACKET_TYPE_PEN] 按数位板原生频率发送笔采样。
+     * 需要接收端理解 0x0D；v2 连接上同时声明 [PROTOCOL_CAP_PEN]。
+     */
+    const val PEN_INPUT_ENABLED = false
+
+    /**
+     * 独立的笔设备节点（如 /dev/input/eventN），空串表示笔事件与触摸在同一设备节点上。
+     */
+    const val PEN_DEVICE_PATH = ""
+
+    /**
+     * 是否把外接的手柄、键盘、鼠标经 Native 读取线程以 [PACKET_TYPE_HID] 状态增量转发。
+     * 需要接收端理解 0x0E；v2 连接上同时声明 [PROTOCOL_CAP_HID]。
+     */
+    const val HID_INPUT_ENABLED = false
+
+    /**
+     * 只转发这些设备节点（如 /dev/input/eventN）；为空时按能力位自动识别，并监视新接入的蓝牙 / USB 设备。
+     */
+    val HID_DEVICE_PATHS: Array<String> = emptyArray()
+
+    /**
+     * 是否每隔 [TELEMETRY_INTERVAL_MS] 把 Native 运行时统计块以 [PACKET_TYPE_TELEMETRY] 发给接收端。
+     * 需要接收端理解 0x0F；v2 连接上同时声明 [PROTOCOL_CAP_TELEMETRY]。
+     */
+    const val TELEMETRY_ENABLED = false
+    const val TELEMETRY_INTERVAL_MS = 1000L
+
+    /**
+     * 特权辅助进程的文件名（与 Native 库一起打包在 nativeLibraryDir 下）。
+     * 设备权限不足时经 su 启动一次，此后由它打开输入设备并通过 Unix socket 传回 fd。
+     */
+    const val PRIVILEGED_HELPER_LIB_NAME = "liblowlatencyinput_helper.so"
+
     /**
      * 标记数据包包含触摸事件数据。
      */
@@ -72,8 +268,67 @@ object Constants {
     const val PACKET_TYPE_UI_PRESS_DOWN: Byte = 0x08
 
     /**
-     * 网络传输中多字节数据（如 Long, Int, Float）使用的字节序。
-     * 这里使用 BIG_ENDIAN（高位字节在前）来示例。
+     * 标记数据包包含一个 Native 识别出的区域手势（双击、滑出、多指和弦、按住拖动）。
+     * Payload: Kind(1) + Fingers(1) + Direction(1) + 保留(1) + X(4) + Y(4) + DX(4) + DY(4)
+     *          + Timestamp(8) + Identifier(N)。
+     */
+    const val PACKET_TYPE_UI_GESTURE: Byte = 0x09
+
+    /**
+     * 标记数据包包含附带压力与接触尺寸的触摸数据。
+     * Payload: Timestamp(8) + Count(1) + 每个触摸 (ID(4) + X(4) + Y(4) + Pressure(2) + TouchMajor(2))，
+     *          Pressure 与 TouchMajor 为设备轴范围的千分比，设备不支持时为 0。
+     */
+    const val PACKET_TYPE_TOUCH_EXTENDED: Byte = 0x0A
+
+    /**
+     * 标记数据包是客户端发送的时钟同步请求，无 Payload，包头时间戳即请求发出时间 t1。
+     */
+    const val PACKET_TYPE_CLOCK_SYNC: Byte = 0x0B
+
+    /**
+     * 标记数据包包含一个笔采样（悬停或接触），笔在范围内时每个数位板帧一个，离开范围时补发一个 Flags 为 0 的采样。
+     * Payload (28 字节, LittleEndian): EventTimeUs(8) + X(4) + Y(4) + Pressure(2, 万分比) + Distance(2, 千分比)
+     *          + TiltX(2) + TiltY(2)（有符号，0.01°，屏幕坐标系）+ Flags(1) + 保留(3)。
+     * Flags: 0x01 在范围内 / 0x02 接触 / 0x04 笔杆键 1 / 0x08 笔杆键 2 / 0x10 橡皮擦端。
+     */
+    const val PACKET_TYPE_PEN: Byte = 0x0D
+
+    /**
+     * 标记数据包包含外接设备（手柄、键盘、鼠标）一帧的状态增量。
+     * Payload (LittleEndian): EventTimeUs(8) + DeviceId(1) + DeviceClass(1) + Flags(1) + Count(1)
+     *          + Count × (Type(1) + 保留(1) + Code(2) + Value(4))。
+     * DeviceClass: 0x01 手柄 / 0x02 键盘 / 0x04 鼠标；Flags: 0x01 设备接入 / 0x02 设备移除 / 0x04 丢事件后补齐。
+     * Type / Code 为 Linux 事件类型与事件码；按键 Value 为 1 / 0，绝对轴为归一化值（双向 ±32767，扳机 0..32767），
+     * 相对轴为本帧位移。
+     */
+    const val PACKET_TYPE_HID: Byte = 0x0E
+
+    /**
+     * 标记数据包包含 Native 运行时统计块的一次快照。
+     * Payload (LittleEndian): FieldCount(2) + 保留(6) + FieldCount × Value(8)。
+     * 字段顺序与 NativeRuntimeStats.FIELD_* 一致；除当前按下手指数与发送队列深度外均为累计值，接收端对相邻两包求差得到速率。
+     */
+    const val PACKET_TYPE_TELEMETRY: Byte = 0x0F
+
+    /**
+     * 标记数据包是服务器对时钟同步请求的回复，包头同 ACK。
+     * Payload (24 字节, LittleEndian): t1(8, 原样回显) + t2(8, 服务器收到请求) + t3(8, 服务器发出回复)。
+     */
+    const val PACKET_TYPE_CLOCK_SYNC_REPLY: Byte = 0xFD.toByte()
+
+    /**
+     * v2 握手：客户端确认协商结果（v2 包头，由 Native 发送器作为连接上的第一个包发出）。
+     */
+    const val PACKET_TYPE_CLIENT_HELLO: Byte = 0x0C
+
+    /**
+     * v2 握手：支持 v2 的服务器在连接建立后立即发送，包头同 v1 的 ACK，Payload 为 16 字节的 Hello。
+     */
+    const val PACKET_TYPE_SERVER_HELLO: Byte = 0xFC.toByte()
+
+    /**
+     * v1 协议包头时间戳（以及陀螺仪 / 加速度计 Payload）使用的字节序，v2 统一为小端。
      */
     val BYTE_ORDER: ByteOrder = ByteOrder.BIG_ENDIAN
 
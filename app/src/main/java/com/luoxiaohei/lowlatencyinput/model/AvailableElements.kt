@@ -12,6 +12,7 @@ import com.luoxiaohei.lowlatencyinput.R
  * @param defaultHeightDp 元素的默认高度（单位：dp）
  * @param isMandatory 是否为必需元素，如为 true 则在编辑器中不允许删除
  * @param iconResId 图标类型元素的 Drawable 资源 ID (可选)
+ * @param defaultShape 元素未指定 shape 时 Native 区域命中使用的形状 ("rect", "circle", "roundRect", "polygon")
  */
 data class AvailableElementInfo(
     val type: String,
@@ -19,7 +20,8 @@ data class AvailableElementInfo(
     val defaultWidthDp: Float,
     val defaultHeightDp: Float,
     val isMandatory: Boolean = false,
-    @DrawableRes val iconResId: Int? = null
+    @DrawableRes val iconResId: Int? = null,
+    val defaultShape: String = AvailableElements.SHAPE_RECT
 )
 
 /**
@@ -41,6 +43,12 @@ object AvailableElements {
     const val TYPE_ICON_TURRET = "icon_turret"
     const val TYPE_ICON_CROUCH = "icon_crouch"
 
+    // 区域命中形状，与 Native input_types.h 中的 RegionShape 对应
+    const val SHAPE_RECT = "rect"
+    const val SHAPE_CIRCLE = "circle"
+    const val SHAPE_ROUND_RECT = "roundRect"
+    const val SHAPE_POLYGON = "polygon"
+
     /**
      * all 列表：包含所有可选元素的默认配置。
      * 例如：关闭按钮、通用按钮、两个示例摇杆等。
@@ -58,42 +66,48 @@ object AvailableElements {
             defaultLabel = "跳跃",
             defaultWidthDp = 32f,
             defaultHeightDp = 32f,
-            iconResId = R.drawable.bg_icon_jump
+            iconResId = R.drawable.bg_icon_jump,
+            defaultShape = SHAPE_CIRCLE
         ),
         AvailableElementInfo(
             type = "joystick_ring",
             defaultLabel = "轮盘",
             defaultWidthDp = 100f,
             defaultHeightDp = 100f,
-            iconResId = R.drawable.bg_icon_joystick_ring
+            iconResId = R.drawable.bg_icon_joystick_ring,
+            defaultShape = SHAPE_CIRCLE
         ),
         AvailableElementInfo(
             type = TYPE_ICON_GRENADE,
             defaultLabel = "手雷",
             defaultWidthDp = 32f,
             defaultHeightDp = 32f,
-            iconResId = R.drawable.bg_icon_grenade
+            iconResId = R.drawable.bg_icon_grenade,
+            defaultShape = SHAPE_CIRCLE
         ),
         AvailableElementInfo(
             type = TYPE_ICON_CROSSHAIR,
             defaultLabel = "准星",
             defaultWidthDp = 32f,
             defaultHeightDp = 32f,
-            iconResId = R.drawable.bg_icon_crosshair
+            iconResId = R.drawable.bg_icon_crosshair,
+            defaultShape = SHAPE_CIRCLE
         ),
         AvailableElementInfo(
             type = TYPE_ICON_BULLET,
             defaultLabel = "子弹",
             defaultWidthDp = 32f,
             defaultHeightDp = 32f,
-            iconResId = R.drawable.bg_icon_bullet
+            iconResId = R.drawable.bg_icon_bullet,
+            defaultShape = SHAPE_CIRCLE
         ),
         AvailableElementInfo(
             type = TYPE_ICON_JUMPAD,
             defaultLabel = "跳板",
             defaultWidthDp = 32f,
             defaultHeightDp = 32f,
-            iconResId = R.drawable.bg_icon_jumpad
+            iconResId = R.drawable.bg_icon_jumpad,
+            defaultShape = SHAPE_CIRCLE
         ),
         AvailableElementInfo(
             type = TYPE_ICON_RIFLE,
@@ -107,21 +121,24 @@ object AvailableElements {
             defaultLabel = "烟雾弹",
             defaultWidthDp = 32f,
             defaultHeightDp = 32f,
-            iconResId = R.drawable.tfui_icon_smoke_grenade
+            iconResId = R.drawable.tfui_icon_smoke_grenade,
+            defaultShape = SHAPE_CIRCLE
         ),
         AvailableElementInfo(
             type = TYPE_ICON_TURRET,
             defaultLabel = "炮塔",
             defaultWidthDp = 32f,
             defaultHeightDp = 32f,
-            iconResId = R.drawable.bg_icon_turret
+            iconResId = R.drawable.bg_icon_turret,
+            defaultShape = SHAPE_CIRCLE
         ),
         AvailableElementInfo(
             type = TYPE_ICON_CROUCH,
             defaultLabel = "蹲伏",
             defaultWidthDp = 32f,
             defaultHeightDp = 32f,
-            iconResId = R.drawable.bg_icon_crouch
+            iconResId = R.drawable.bg_icon_crouch,
+            defaultShape = SHAPE_CIRCLE
         )
     )
 
@@ -13,6 +13,14 @@ import kotlinx.serialization.Serializable
  * @param height 高度 (像素)。
  * @param label 标签，可以为 null。
  * @param alpha 透明度，范围从 0.0 到 1.0，0.0 表示完全透明，1.0 表示完全不透明。
+ * @param gestures 该元素启用的 Native 手势识别 ("doubleTap", "swipe", "chord2", "chord3", "holdDrag")。
+ * @param policies 该元素的触摸策略 ("slideIn", "slideOut", "capture", "exclusive", "passThrough")，为空时按下绑定、抬起释放。
+ * @param smoothing 绑定到该元素的手指使用的抖动过滤参数，为 null 时使用全局参数。
+ * @param shape 区域命中形状 ("rect", "circle", "roundRect", "polygon")，为 null 时使用元素类型的默认形状。
+ * @param cornerRadius roundRect 的圆角半径（单位同 width / height）。
+ * @param hitPadding 命中范围沿形状轮廓外扩的距离（单位同 width / height），负值向内收缩。
+ * @param priority 与其他元素重叠时的命中优先级，数值大的优先，相同时先加入布局的优先。
+ * @param points polygon 的顶点，扁平存放 [x0, y0, x1, y1, ...]，相对于元素左上角，需为凸多边形。
  */
 @Serializable
 data class OverlayElement(
@@ -23,7 +31,29 @@ data class OverlayElement(
     val width: Float,
     val height: Float,
     val label: String? = null, // Added nullable label field
-    val alpha: Float = 1.0f // 添加 alpha 属性，默认 1.0 (不透明)
+    val alpha: Float = 1.0f, // 添加 alpha 属性，默认 1.0 (不透明)
+    val gestures: List<String> = emptyList(),
+    val policies: List<String> = emptyList(),
+    val smoothing: RegionSmoothing? = null,
+    val shape: String? = null,
+    val cornerRadius: Float = 0f,
+    val hitPadding: Float = 0f,
+    val priority: Int = 0,
+    val points: List<Float> = emptyList()
+)
+
+/**
+ * 区域的触摸坐标抖动过滤 (One Euro) 参数，单位为像素 / 秒。
+ *
+ * @param minCutoffHz 静止时的截止频率，越低越稳。
+ * @param beta 速度系数，越大移动时延迟越小。
+ * @param derivativeCutoffHz 速度估计的截止频率。
+ */
+@Serializable
+data class RegionSmoothing(
+    val minCutoffHz: Float = 1.0f,
+    val beta: Float = 0.007f,
+    val derivativeCutoffHz: Float = 1.0f
 )
 
 /**
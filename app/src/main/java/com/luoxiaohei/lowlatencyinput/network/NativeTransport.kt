@@ -0,0 +1,99 @@
+package com.luoxiaohei.lowlatencyinput.network
+
+import android.util.Log
+
+/**
+ * Native 批量发送器的 Kotlin 入口。
+ * 连接由 [TcpCommunicator] 建立和维护，写方向交给 Native 层：
+ * 同一微窗口内的多个数据包合并为一次系统调用写出，UI 事件等延迟敏感包立即冲刷。
+ *
+ * 除主连接外还可添加只订阅部分包类型的订阅者（例如运动数据单独发给 gyroxinput），
+ * 每个订阅者有独立的发送线程与有界队列，慢的订阅者不会拖慢其他订阅者。
+ */
+object NativeTransport {
+
+    private const val TAG = "NativeTransport"
+
+    init {
+        try {
+            System.loadLibrary("lowlatencyinput")
+        } catch (e: UnsatisfiedLinkError) {
+            Log.e(TAG, "加载 Native 库失败: ${e.message}")
+        }
+    }
+
+    /**
+     * 绑定已连接 socket 的 fd（所有权转移给 Native 层），并启动发送线程。
+     */
+    @JvmStatic external fun nativeAttachSocket(socketFd: Int, batchWindowUs: Int, maxBatchPackets: Int): Boolean
+
+    /**
+     * 冲刷剩余数据并停止主连接的发送线程，关闭绑定的 fd。
+     */
+    @JvmStatic external fun nativeDetachSocket()
+
+    /**
+     * 添加订阅者（fd 所有权转移给 Native 层）。
+     * @param typeMask 订阅的包类型，按 `1L shl type` 置位，-1 表示全部
+     * @param maxPendingPackets 队列上限，超出时丢弃过时的触摸 / 运动包，UI 事件不丢；0 表示不限
+     * @return 订阅者 ID，失败返回 -1
+     */
+    @JvmStatic external fun nativeAddSubscriber(
+        socketFd: Int, typeMask: Long, batchWindowUs: Int, maxBatchPackets: Int, maxPendingPackets: Int
+    ): Int
+
+    /**
+     * 冲刷并移除订阅者，关闭其 fd。
+     */
+    @JvmStatic external fun nativeRemoveSubscriber(subscriberId: Int): Boolean
+
+    /**
+     * 提交一个数据包，包头与时间戳由 Native 层按原有协议生成。
+     * @return false 表示发送器未绑定或 socket 已出错
+     */
+    @JvmStatic external fun nativeSubmitPacket(packetType: Byte, payload: ByteArray?, offset: Int, length: Int): Boolean
+
+    /**
+     * 所有订阅者的发送统计之和: [packets, syscalls, bytes, avgQueueDelayUs, maxQueueDelayUs, urgentFlushes, errors, dropped,
+     * superseded, avgStateQueueDelayUs, maxStateQueueDelayUs]；superseded 为写出前被同类型新包取代的触摸 / 运动包数
+     */
+    @JvmStatic external fun nativeGetStats(): LongArray
+
+    /**
+     * 单个订阅者的发送统计，格式同 [nativeGetStats]；订阅者不存在时为 null。
+     */
+    @JvmStatic external fun nativeGetSubscriberStats(subscriberId: Int): LongArray?
+
+    /**
+     * 之后绑定的主连接是否以接收端时钟打包头时间戳（PING 与时钟同步请求除外）。
+     */
+    @JvmStatic external fun nativeSetReceiverTimestamps(enabled: Boolean)
+
+    /**
+     * 加入一次时钟同步交换：t1/t4 为本机 System.nanoTime()，t2/t3 为接收端时间。
+     */
+    @JvmStatic external fun nativeAddClockSample(t1: Long, t2: Long, t3: Long, t4: Long): Boolean
+
+    /**
+     * 当前时钟同步估计: [offsetNs, driftPpb, errorBoundNs, minRoundTripNs, samples, accepted]，尚无样本时为 null。
+     */
+    @JvmStatic external fun nativeGetClockSync(): LongArray?
+
+    /**
+     * 把本机 System.nanoTime() 换算为接收端时间，尚无估计时原样返回。
+     */
+    @JvmStatic external fun nativeToReceiverTime(localNs: Long): Long
+
+    /**
+     * 根据接收端的 SERVER_HELLO Payload 协商协议，结果用于之后的 [nativeAttachSocket]。
+     * @param serverHello 为 null（v1 接收端）时回退到 v1
+     * @param localCapabilities 本机希望启用的能力 (Constants.PROTOCOL_CAP_*)
+     * @return 协商得到的版本 (1 或 2)
+     */
+    @JvmStatic external fun nativeNegotiateProtocol(serverHello: ByteArray?, localCapabilities: Int): Int
+
+    /**
+     * 最近一次协商得到的能力位，v1 时为 0。
+     */
+    @JvmStatic external fun nativeGetProtocolCapabilities(): Int
+}
@@ -0,0 +1,122 @@
+package com.luoxiaohei.lowlatencyinput.network
+
+import kotlinx.coroutines.channels.Channel
+import java.io.OutputStream
+import java.util.concurrent.TimeUnit
+import java.util.concurrent.atomic.AtomicLong
+
+/**
+ * Kotlin 发送路径（Native 发送器不可用时）的有界发送队列，由单个写协程排空。
+ * 策略与 Native 发送器一致：
+ * - [latestWinsTypes] 中的状态包（触摸帧、运动采样）按 latest-wins 槽位排队：新包入队时，同类型中已排队超过
+ *   [latestWinsMinAgeNanos] 的旧包被取代（新包排到队尾），写协程跟得上时一次提交的一串帧全部保留；
+ * - 其余包（UI 事件、PING 等）按序无损排队，超过 [maxOrderedPackets] 时拒绝入队，调用方按断线处理。
+ * 因此链路变慢时内存有界，恢复后写出的状态包最多过时 [latestWinsMinAgeNanos]。
+ */
+class PacketSendQueue(
+    private val latestWinsTypes: Set<Byte>,
+    private val maxOrderedPackets: Int,
+    private val latestWinsMinAgeNanos: Long = TimeUnit.MILLISECONDS.toNanos(1)
+) {
+    private class Entry(val type: Byte, val bytes: ByteArray, val enqueueNanos: Long)
+
+    private val lock = Any()
+    private val entries = ArrayList<Entry>()
+    private var orderedCount = 0
+    private val signal = Channel<Unit>(Channel.CONFLATED)
+
+    // --- 统计 ---
+    private val sent = AtomicLong(0)
+    private val superseded = AtomicLong(0)
+    private val stateSent = AtomicLong(0)
+    private val queueDelaySumNs = AtomicLong(0)
+    private val stateQueueDelaySumNs = AtomicLong(0)
+    private val maxQueueDelayNs = AtomicLong(0)
+
+    /**
+     * 入队一个已编码的完整数据包。
+     * @param enqueueNanos 入队时间 (System.nanoTime())，用于排队延迟统计
+     * @return false 表示有序队列已满（对端长时间不读），包未入队
+     */
+    fun offer(type: Byte, bytes: ByteArray, enqueueNanos: Long): Boolean {
+        synchronized(lock) {
+            if (type in latestWinsTypes) {
+                val staleBefore = enqueueNanos - latestWinsMinAgeNanos
+                val before = entries.size
+                entries.removeAll { it.type == type && it.enqueueNanos <= staleBefore }
+                superseded.addAndGet((before - entries.size).toLong())
+            } else {
+                if (orderedCount >= maxOrderedPackets) return false
+                orderedCount++
+            }
+            entries.add(Entry(type, bytes, enqueueNanos))
+        }
+        signal.trySend(Unit)
+        return true
+    }
+
+    /**
+     * 写协程主体：每次取走全部待写包，合并为一次 write 写出。
+     * 写失败时抛出 IOException，由调用方处理断线；协程取消时返回。
+     */
+    suspend fun drainTo(stream: OutputStream) {
+        var buffer = ByteArray(4096)
+        while (true) {
+            signal.receive()
+            val batch = synchronized(lock) {
+                val taken = ArrayList(entries)
+                entries.clear()
+                orderedCount = 0
+                taken
+            }
+            if (batch.isEmpty()) continue
+
+            val total = batch.sumOf { it.bytes.size }
+            if (buffer.size < total) buffer = ByteArray(maxOf(total, buffer.size * 2))
+            var offset = 0
+            for (entry in batch) {
+                System.arraycopy(entry.bytes, 0, buffer, offset, entry.bytes.size)
+                offset += entry.bytes.size
+            }
+            stream.write(buffer, 0, total)
+            stream.flush()
+
+            val flushNanos = System.nanoTime()
+            for (entry in batch) {
+                val delay = flushNanos - entry.enqueueNanos
+                queueDelaySumNs.addAndGet(delay)
+                maxQueueDelayNs.updateAndGet { if (delay > it) delay else it }
+                if (entry.type in latestWinsTypes) {
+                    stateSent.incrementAndGet()
+                    stateQueueDelaySumNs.addAndGet(delay)
+                }
+            }
+            sent.addAndGet(batch.size.toLong())
+        }
+    }
+
+    /**
+     * 丢弃所有待写包（断线时调用）。
+     */
+    fun clear() {
+        synchronized(lock) {
+            entries.clear()
+            orderedCount = 0
+        }
+    }
+
+    /**
+     * 统计快照: [packets, avgQueueDelayUs, maxQueueDelayUs, superseded, avgStateQueueDelayUs]
+     */
+    fun stats(): LongArray {
+        val packets = sent.get()
+        val states = stateSent.get()
+        return longArrayOf(
+            packets,
+            if (packets > 0) TimeUnit.NANOSECONDS.toMicros(queueDelaySumNs.get() / packets) else 0,
+            TimeUnit.NANOSECONDS.toMicros(maxQueueDelayNs.get()),
+            superseded.get(),
+            if (states > 0) TimeUnit.NANOSECONDS.toMicros(stateQueueDelaySumNs.get() / states) else 0
+        )
+    }
+}
@@ -1,5 +1,6 @@
 package com.luoxiaohei.lowlatencyinput.network
 
+import android.os.ParcelFileDescriptor
 import android.util.Log
 import com.luoxiaohei.lowlatencyinput.Constants
 import kotlinx.coroutines.*
@@ -39,6 +40,7 @@ class TcpCommunicator(
     // --- 配置常量 ---
     private val PING_INTERVAL_MS = 1000L                 // PING 发送间隔
     private val SOCKET_READ_TIMEOUT_MS = 5000            // 读取超时时间
+    private val MAX_QUEUED_ORDERED_PACKETS = 256         // Kotlin 发送队列中 UI 等有序包的上限
     private val BYTE_ORDER: ByteOrder = Constants.BYTE_ORDER
     private val PACKET_TYPE_ACK: Byte = Constants.PACKET_TYPE_ACK
     private val PACKET_TYPE_PING: Byte = Constants.PACKET_TYPE_PING
@@ -47,7 +49,22 @@ class TcpCommunicator(
     private var clientSocket: Socket? = null
     private var outputStream: OutputStream? = null
     private var inputStream: InputStream? = null
-    private val outputStreamLock = Any() // 通过锁同步写操作，防止多协程并发写造成混乱
+
+    // Kotlin 发送路径的有界队列：状态包 latest-wins，其余有序无损，由 senderJob 单独写出
+    private val sendQueue = PacketSendQueue(
+        latestWinsTypes = setOf(Constants.PACKET_TYPE_TOUCH, Constants.PACKET_TYPE_GYRO, Constants.PACKET_TYPE_ACCEL),
+        maxOrderedPackets = MAX_QUEUED_ORDERED_PACKETS
+    )
+
+    // 写方向是否已交给 Native 批量发送器
+    @Volatile
+    private var nativeSenderAttached = false
+
+    // 当前连接使用的协议版本与能力（v2 仅在 Native 发送器绑定成功时启用）
+    @Volatile
+    private var protocolVersion = 1
+    @Volatile
+    private var protocolCapabilities = 0
 
     // --- 连接状态 Flow ---
     private val _connectionStatusFlow = MutableStateFlow(ConnectionStatus.DISCONNECTED)
@@ -73,6 +90,7 @@ class TcpCommunicator(
     private var connectJob: Job? = null
     private var pingJob: Job? = null
     private var serverListenerJob: Job? = null
+    private var senderJob: Job? = null
 
     /**
      * 尝试连接到指定服务器。若已处于连接中或已连接则直接返回。
@@ -124,6 +142,15 @@ class TcpCommunicator(
                     clientSocket = socket
                     outputStream = socket.getOutputStream()
                     inputStream = socket.getInputStream()
+                    val serverHello = if (Constants.PROTOCOL_V2_ENABLED) {
+                        withContext(Dispatchers.IO) { readServerHello(socket) }
+                    } else {
+                        null
+                    }
+                    attachNativeSender(socket, serverHello)
+                    if (!nativeSenderAttached) {
+                        startSenderJob(socket.getOutputStream())
+                    }
                     _connectionStatusFlow.value = ConnectionStatus.CONNECTED
                     Log.i(TAG, "成功连接到服务器 (第 $attempt 次)。")
 
@@ -154,6 +181,85 @@ class TcpCommunicator(
         }
     }
 
+    /**
+     * 等待支持 v2 的服务器在连接后主动发送的 SERVER_HELLO（v1 ACK 式包头 + 16 字节 Payload）。
+     * @return Hello 的 Payload；超时（v1 服务器）或格式不符时为 null
+     * @throws IOException 连接关闭，或超时前只收到部分 Hello
+     */
+    private fun readServerHello(socket: Socket): ByteArray? {
+        val stream = socket.getInputStream()
+        val packet = ByteArray(V1_HEADER_SIZE + HELLO_PAYLOAD_SIZE)
+        socket.soTimeout = Constants.PROTOCOL_HELLO_TIMEOUT_MS
+        var total = 0
+        try {
+            while (total < packet.size) {
+                val n = stream.read(packet, total, packet.size - total)
+                if (n == -1) throw IOException("读取 SERVER_HELLO 时连接关闭")
+                total += n
+            }
+        } catch (e: SocketTimeoutException) {
+            // 只收到一部分 Hello 说明流已错位，不能再当作 v1 连接使用：关闭后由连接循环重连
+            if (total > 0) {
+                socket.close()
+                throw IOException("SERVER_HELLO 不完整 ($total/${packet.size} 字节)", e)
+            }
+            Log.i(TAG, "服务器未发送 SERVER_HELLO，使用 v1 协议。")
+            return null
+        } finally {
+            socket.soTimeout = SOCKET_READ_TIMEOUT_MS
+        }
+        val header = ByteBuffer.wrap(packet, 0, V1_HEADER_SIZE)
+        val type = header.get()
+        header.order(ByteOrder.LITTLE_ENDIAN).position(9)
+        val length = header.short.toInt() and 0xFFFF
+        if (type != Constants.PACKET_TYPE_SERVER_HELLO || length != HELLO_PAYLOAD_SIZE) {
+            Log.w(TAG, "连接后的第一个包不是 SERVER_HELLO (type=$type, length=$length)，使用 v1 协议。")
+            return null
+        }
+        return packet.copyOfRange(V1_HEADER_SIZE, packet.size)
+    }
+
+    /**
+     * 把 socket 的写方向交给 Native 批量发送器；失败时保留原有的逐包写出路径（仅 v1）。
+     * @param serverHello 服务器的 SERVER_HELLO Payload，null 表示 v1 服务器
+     */
+    private fun attachNativeSender(socket: Socket, serverHello: ByteArray?) {
+        var negotiatedVersion = 1
+        nativeSenderAttached = try {
+            NativeTransport.nativeSetReceiverTimestamps(Constants.TRANSPORT_RECEIVER_TIMESTAMPS)
+            var localCapabilities = Constants.PROTOCOL_CAP_CLOCK_SYNC
+            if (Constants.TRANSPORT_RECEIVER_TIMESTAMPS) {
+                localCapabilities = localCapabilities or Constants.PROTOCOL_CAP_RECEIVER_TIMESTAMPS
+            }
+            if (Constants.TOUCH_EXTENDED_CONTACTS) {
+                localCapabilities = localCapabilities or Constants.PROTOCOL_CAP_TOUCH_EXTENDED
+            }
+            if (Constants.PEN_INPUT_ENABLED) {
+                localCapabilities = localCapabilities or Constants.PROTOCOL_CAP_PEN
+            }
+            if (Constants.HID_INPUT_ENABLED) {
+                localCapabilities = localCapabilities or Constants.PROTOCOL_CAP_HID
+            }
+            if (Constants.TELEMETRY_ENABLED) {
+                localCapabilities = localCapabilities or Constants.PROTOCOL_CAP_TELEMETRY
+            }
+            negotiatedVersion = NativeTransport.nativeNegotiateProtocol(serverHello, localCapabilities)
+            val fd = ParcelFileDescriptor.fromSocket(socket).detachFd()
+            NativeTransport.nativeAttachSocket(
+                fd,
+                Constants.TRANSPORT_BATCH_WINDOW_US,
+                Constants.TRANSPORT_MAX_BATCH_PACKETS
+            )
+        } catch (e: Throwable) {
+            Log.w(TAG, "绑定 Native 发送器失败，使用 Kotlin 发送路径: ${e.message}")
+            false
+        }
+        // Kotlin 发送路径只会 v1：服务器看到第一个包不是 CLIENT_HELLO 时同样回退到 v1
+        protocolVersion = if (nativeSenderAttached) negotiatedVersion else 1
+        protocolCapabilities = if (protocolVersion >= 2) NativeTransport.nativeGetProtocolCapabilities() else 0
+        Log.i(TAG, "Native 批量发送器: ${if (nativeSenderAttached) "已启用" else "未启用"}, 协议 v$protocolVersion")
+    }
+
     /**
      * 主动断开与服务器的连接，并清理资源。
      */
@@ -173,6 +279,18 @@ class TcpCommunicator(
         connectJob?.cancel()
         pingJob?.cancel()
         serverListenerJob?.cancel()
+        senderJob?.cancel()
+        sendQueue.clear()
+
+        // 停止 Native 发送器（会冲刷已入队的数据并关闭其持有的 fd）
+        if (nativeSenderAttached) {
+            nativeSenderAttached = false
+            try {
+                NativeTransport.nativeDetachSocket()
+            } catch (e: UnsatisfiedLinkError) {
+                Log.w(TAG, "解绑 Native 发送器失败: ${e.message}")
+            }
+        }
 
         // 关闭流和 Socket
         try { outputStream?.close() } catch (e: IOException) { /* 忽略异常 */ }
@@ -193,6 +311,7 @@ class TcpCommunicator(
         connectJob = null
         pingJob = null
         serverListenerJob = null
+        senderJob = null
     }
 
     /**
@@ -231,59 +350,85 @@ class TcpCommunicator(
      * @param description 用于日志识别此发送操作的名称或描述
      */
     fun sendPacket(packetType: Byte, payload: ByteBuffer, description: String) {
-        val currentOutputStream = outputStream
-        if (_connectionStatusFlow.value == ConnectionStatus.CONNECTED && currentOutputStream != null) {
-            scope.launch {
-                val sendTimestampNanos = System.nanoTime() // RTT 起始时间戳
-                val payloadLength = payload.remaining()
-
-                // 根据包类型确定最终包大小和结构
-                val buffer: ByteBuffer
-                if (packetType == Constants.PACKET_TYPE_UI_EVENT ||
-                    packetType == Constants.PACKET_TYPE_UI_LONG_PRESS ||
-                    packetType == Constants.PACKET_TYPE_UI_PRESS_DOWN
-                ) {
-                    // 新结构: 类型(1) + 时间戳(8) + Payload长度(2, LittleEndian) + Payload(N)
-                    val packetSize = 1 + 8 + 2 + payloadLength
-                    buffer = ByteBuffer.allocate(packetSize)
-                    // 写入类型和时间戳 (使用默认的大端序)
-                    buffer.order(Constants.BYTE_ORDER)
-                    buffer.put(packetType)
-                    buffer.putLong(sendTimestampNanos)
-                    // 写入 Payload 长度 (使用小端序)
-                    buffer.order(ByteOrder.LITTLE_ENDIAN)
-                    buffer.putShort(payloadLength.toShort())
-                    // 写入 Payload
-                    buffer.put(payload)
-                } else {
-                    // 其他类型保持旧结构: 类型(1) + 时间戳(8) + Payload(N)
-                    val packetSize = 1 + 8 + payloadLength
-                    buffer = ByteBuffer.allocate(packetSize).order(Constants.BYTE_ORDER)
-                    buffer.put(packetType)
-                    buffer.putLong(sendTimestampNanos)
-                    buffer.put(payload)
-                }
+        if (nativeSenderAttached && _connectionStatusFlow.value == ConnectionStatus.CONNECTED) {
+            // Native 批量发送：同步入队，包头和时间戳由 Native 层生成
+            val ok = if (payload.hasArray()) {
+                NativeTransport.nativeSubmitPacket(
+                    packetType, payload.array(), payload.arrayOffset() + payload.position(), payload.remaining()
+                )
+            } else {
+                val bytes = ByteArray(payload.remaining())
+                payload.duplicate().get(bytes)
+                NativeTransport.nativeSubmitPacket(packetType, bytes, 0, bytes.size)
+            }
+            if (!ok) {
+                Log.w(TAG, "发送 $description 时 Native 发送器不可用")
+                handleConnectionError("sendPacket-native")
+            }
+            return
+        }
 
-                try {
-                    synchronized(outputStreamLock) {
-                        currentOutputStream.write(buffer.array())
-                        currentOutputStream.flush()
-                    }
-                } catch (e: SocketException) {
-                    Log.w(TAG, "发送 $description 时出错 (SocketException): ${e.message}")
-                    handleConnectionError("sendPacket")
-                } catch (e: IOException) {
-                    Log.w(TAG, "发送 $description 时出错 (IOException): ${e.message}")
-                    handleConnectionError("sendPacket")
-                } catch (e: Exception) {
-                    Log.e(TAG, "发送 $description 时未知异常: ${e.message}", e)
-                    handleConnectionError("sendPacket")
-                }
+        if (_connectionStatusFlow.value == ConnectionStatus.CONNECTED && senderJob != null) {
+            val sendTimestampNanos = System.nanoTime() // RTT 起始时间戳，同时作为入队时间
+            val payloadLength = payload.remaining()
+
+            // 根据包类型确定最终包大小和结构
+            val buffer: ByteBuffer
+            if (packetType == Constants.PACKET_TYPE_UI_EVENT ||
+                packetType == Constants.PACKET_TYPE_UI_LONG_PRESS ||
+                packetType == Constants.PACKET_TYPE_UI_PRESS_DOWN
+            ) {
+                // 新结构: 类型(1) + 时间戳(8) + Payload长度(2, LittleEndian) + Payload(N)
+                val packetSize = 1 + 8 + 2 + payloadLength
+                buffer = ByteBuffer.allocate(packetSize)
+                // 写入类型和时间戳 (使用默认的大端序)
+                buffer.order(Constants.BYTE_ORDER)
+                buffer.put(packetType)
+                buffer.putLong(sendTimestampNanos)
+                // 写入 Payload 长度 (使用小端序)
+                buffer.order(ByteOrder.LITTLE_ENDIAN)
+                buffer.putShort(payloadLength.toShort())
+                // 写入 Payload
+                buffer.put(payload.duplicate())
+            } else {
+                // 其他类型保持旧结构: 类型(1) + 时间戳(8) + Payload(N)
+                val packetSize = 1 + 8 + payloadLength
+                buffer = ByteBuffer.allocate(packetSize).order(Constants.BYTE_ORDER)
+                buffer.put(packetType)
+                buffer.putLong(sendTimestampNanos)
+                buffer.put(payload.duplicate())
+            }
+
+            // 入队后立即返回；对端长时间不读导致有序队列溢出时按断线处理
+            if (!sendQueue.offer(packetType, buffer.array(), sendTimestampNanos)) {
+                Log.w(TAG, "发送 $description 时发送队列已满")
+                handleConnectionError("sendPacket-queue")
             }
         }
         // 若当前未连接，则省略发送，不做额外处理
     }
 
+    /**
+     * 启动 Kotlin 发送路径的写协程：串行排空 [sendQueue]，写失败时触发重连。
+     */
+    private fun startSenderJob(stream: OutputStream) {
+        senderJob?.cancel()
+        sendQueue.clear()
+        senderJob = scope.launch {
+            try {
+                sendQueue.drainTo(stream)
+            } catch (e: CancellationException) {
+                throw e
+            } catch (e: IOException) {
+                Log.w(TAG, "发送队列写出失败 (${e.javaClass.simpleName}): ${e.message}")
+                handleConnectionError("senderJob")
+            } catch (e: Exception) {
+                Log.e(TAG, "发送队列未知异常: ${e.message}", e)
+                handleConnectionError("senderJob")
+            }
+        }
+    }
+
     /**
      * 启动周期性的 PING 协程，定时向服务器发送 PING 包，服务器端可以 RTT。
      */
@@ -292,8 +437,19 @@ class TcpCommunicator(
         pingJob = scope.launch {
             Log.i(TAG, "Ping 任务启动。")
             try {
+                // v2 服务器未声明支持时钟同步时不发送请求；v1 无从得知，照常发送
+                val clockSync = protocolVersion < 2 ||
+                    (protocolCapabilities and Constants.PROTOCOL_CAP_CLOCK_SYNC) != 0
+                // 连接后先连续交换几次，尽快得到时钟估计
+                if (clockSync) {
+                    repeat(Constants.CLOCK_SYNC_BURST_COUNT) {
+                        sendClockSync()
+                        delay(Constants.CLOCK_SYNC_BURST_INTERVAL_MS)
+                    }
+                }
                 while (isActive && _connectionStatusFlow.value == ConnectionStatus.CONNECTED) {
                     sendPing()
+                    if (clockSync) sendClockSync()
                     delay(PING_INTERVAL_MS)
                 }
             } catch (e: CancellationException) {
@@ -312,6 +468,33 @@ class TcpCommunicator(
         sendPacket(PACKET_TYPE_PING, emptyPayload, "Ping")
     }
 
+    /**
+     * 发送时钟同步请求，包头时间戳即 t1；服务器以 [Constants.PACKET_TYPE_CLOCK_SYNC_REPLY] 回复。
+     */
+    private fun sendClockSync() {
+        sendPacket(Constants.PACKET_TYPE_CLOCK_SYNC, ByteBuffer.allocate(0), "ClockSync")
+    }
+
+    /**
+     * 把一次时钟同步回复交给 Native 估计器。
+     * @param receivedAtNanos 读到回复包头的本机时间 (t4)
+     */
+    private fun handleClockSyncReply(payload: ByteArray?, receivedAtNanos: Long) {
+        if (payload == null || payload.size < 24) {
+            Log.w(TAG, "时钟同步回复长度错误: ${payload?.size ?: 0}")
+            return
+        }
+        val buffer = ByteBuffer.wrap(payload).order(ByteOrder.LITTLE_ENDIAN)
+        val t1 = buffer.long
+        val t2 = buffer.long
+        val t3 = buffer.long
+        try {
+            NativeTransport.nativeAddClockSample(t1, t2, t3, receivedAtNanos)
+        } catch (e: UnsatisfiedLinkError) {
+            Log.w(TAG, "nativeAddClockSample 不可用: ${e.message}")
+        }
+    }
+
     /**
      * 启动监听协程，从输入流中读取数据包并进行处理（ACK 计算 RTT、或广播其他类型数据包）。
      */
@@ -319,16 +502,19 @@ class TcpCommunicator(
         serverListenerJob?.cancel()
 
         serverListenerJob = scope.launch {
-            Log.i(TAG, "服务器 ACK 监听器启动。")
-            // 新协议头部: 类型(1) + 时间戳(8) + 长度(2) = 11 字节
-            val headerBuffer = ByteArray(11)
+            Log.i(TAG, "服务器 ACK 监听器启动 (协议 v$protocolVersion)。")
+            // v1 头部: 类型(1) + 时间戳(8, BigEndian) + 长度(2, LittleEndian) = 11 字节
+            // v2 头部: 类型(1) + 标志(1) + 长度(2) + 序号(4) + 时间戳(8)，均为 LittleEndian，共 16 字节
+            val v2 = protocolVersion >= 2
+            val headerSize = if (v2) V2_HEADER_SIZE else V1_HEADER_SIZE
+            val headerBuffer = ByteArray(headerSize)
             val headerByteBuffer = ByteBuffer.wrap(headerBuffer)
 
             try {
                 val stream = inputStream ?: return@launch
                 while (isActive && _connectionStatusFlow.value == ConnectionStatus.CONNECTED) {
                     val bytesRead = try {
-                        withContext(Dispatchers.IO) { stream.read(headerBuffer) }
+                        withContext(Dispatchers.IO) { stream.read(headerBuffer, 0, headerSize) }
                     } catch (e: SocketTimeoutException) {
                         // 超时后继续下一轮，若仍连接则保持监听
                         if (isActive && _connectionStatusFlow.value == ConnectionStatus.CONNECTED) {
@@ -346,15 +532,28 @@ class TcpCommunicator(
                         break
                     }
 
-                    if (bytesRead == 11) {
+                    if (bytesRead == headerSize) {
+                        val headerReceivedNanos = System.nanoTime() // 时钟同步回复的 t4
                         headerByteBuffer.rewind()
-                        // 读取类型和时间戳 (BigEndian)
-                        headerByteBuffer.order(BYTE_ORDER)
-                        val packetType = headerByteBuffer.get()
-                        val receivedTimestampNanos = headerByteBuffer.long
-                        // 读取 Payload 长度 (LittleEndian)
-                        headerByteBuffer.order(ByteOrder.LITTLE_ENDIAN)
-                        val payloadLength = headerByteBuffer.short.toInt() and 0xFFFF
+                        val packetType: Byte
+                        val receivedTimestampNanos: Long
+                        val payloadLength: Int
+                        if (v2) {
+                            headerByteBuffer.order(ByteOrder.LITTLE_ENDIAN)
+                            packetType = headerByteBuffer.get()
+                            headerByteBuffer.get() // 标志
+                            payloadLength = headerByteBuffer.short.toInt() and 0xFFFF
+                            headerByteBuffer.int // 序号
+                            receivedTimestampNanos = headerByteBuffer.long
+                        } else {
+                            // 读取类型和时间戳 (BigEndian)
+                            headerByteBuffer.order(BYTE_ORDER)
+                            packetType = headerByteBuffer.get()
+                            receivedTimestampNanos = headerByteBuffer.long
+                            // 读取 Payload 长度 (LittleEndian)
+                            headerByteBuffer.order(ByteOrder.LITTLE_ENDIAN)
+                            payloadLength = headerByteBuffer.short.toInt() and 0xFFFF
+                        }
 
                         when (packetType) {
                             PACKET_TYPE_ACK -> {
@@ -392,10 +591,14 @@ class TcpCommunicator(
                                         break
                                     }
                                 }
-                                // 发送到 SharedFlow
-                                val emitResult = _serverPacketFlow.tryEmit(ServerPacket(packetType, payloadBytes))
-                                if (!emitResult) {
-                                    Log.w(TAG, "发送服务器数据包到 Flow 失败 (缓冲区可能已满): Type=$packetType")
+                                if (packetType == Constants.PACKET_TYPE_CLOCK_SYNC_REPLY) {
+                                    handleClockSyncReply(payloadBytes, headerReceivedNanos)
+                                } else {
+                                    // 发送到 SharedFlow
+                                    val emitResult = _serverPacketFlow.tryEmit(ServerPacket(packetType, payloadBytes))
+                                    if (!emitResult) {
+                                        Log.w(TAG, "发送服务器数据包到 Flow 失败 (缓冲区可能已满): Type=$packetType")
+                                    }
                                 }
                             }
                         }
@@ -407,7 +610,7 @@ class TcpCommunicator(
                         }
                         break
                     } else {
-                        // 理论上应始终读到 11 字节，出现其他情况表明异常
+                        // 理论上应始终读到完整包头，出现其他情况表明异常
                         Log.w(TAG, "警告: 读取服务器数据时收到意外字节数 ($bytesRead)。")
                         if (isActive && _connectionStatusFlow.value == ConnectionStatus.CONNECTED) {
                             handleConnectionError("serverListener-readLen")
@@ -465,6 +668,27 @@ class TcpCommunicator(
         stats?.let {
             Log.i(TAG, "RTT: $it")
         }
+        if (nativeSenderAttached) {
+            val s = NativeTransport.nativeGetStats()
+            val packetsPerSyscall = if (s[1] > 0) s[0].toDouble() / s[1] else 0.0
+            Log.i(TAG, String.format(
+                "发送批处理: packets=%d, 每次系统调用 %.2f 包, 平均排队 %dus, 最大排队 %dus, 紧急冲刷=%d, 错误=%d, " +
+                    "队列满丢弃=%d, 被取代=%d, 状态包平均排队 %dus (最大 %dus)",
+                s[0], packetsPerSyscall, s[3], s[4], s[5], s[6], s[7], s[8], s[9], s[10]
+            ))
+        } else {
+            val s = sendQueue.stats()
+            Log.i(TAG, String.format(
+                "发送队列: packets=%d, 平均排队 %dus, 最大排队 %dus, 被取代=%d, 状态包平均排队 %dus",
+                s[0], s[1], s[2], s[3], s[4]
+            ))
+        }
+        NativeTransport.nativeGetClockSync()?.let { c ->
+            Log.i(TAG, String.format(
+                "时钟同步: 偏移=%dus, 漂移=%.2fppm, 误差上界=%dus, 最小往返=%dus, 样本=%d (接受 %d)",
+                c[0] / 1000, c[1] / 1000.0, c[2] / 1000, c[3] / 1000, c[4], c[5]
+            ))
+        }
     }
 
     /**
@@ -487,6 +711,12 @@ class TcpCommunicator(
         Log.i(TAG, "TcpCommunicator jobs cancelled.")
     }
 
+    private companion object {
+        const val V1_HEADER_SIZE = 11     // 服务器 -> 客户端 v1 包头
+        const val V2_HEADER_SIZE = 16
+        const val HELLO_PAYLOAD_SIZE = 16
+    }
+
     // 新增：辅助函数，将字节数组转为十六进制字符串（若有调试需求可使用）
     private fun ByteArray.toHexString(): String = joinToString(" ") { "%02X".format(it) }
 }
@@ -16,6 +16,7 @@ import android.hardware.SensorManager
 import android.os.Binder
 import android.os.Build
 import android.os.IBinder
+import android.os.SystemClock
 import android.util.Log
 import androidx.annotation.Keep
 import androidx.core.app.NotificationCompat
@@ -33,6 +34,7 @@ import kotlinx.coroutines.flow.StateFlow
 import kotlinx.coroutines.flow.asStateFlow
 import kotlinx.coroutines.flow.launchIn
 import kotlinx.coroutines.flow.onEach
+import java.io.File
 import java.nio.ByteBuffer
 import java.nio.ByteOrder
 import java.util.concurrent.TimeUnit
@@ -73,6 +75,13 @@ class GyroscopeService : Service(), SensorEventListener {
     // 标记是否已经发送过设备信息包
     private var deviceInfoSent = false
 
+    // 共享内存事件环的消费者（Constants.INPUT_RING_ENABLED 时使用）
+    private var inputRingConsumer: InputEventRingConsumer? = null
+
+    // 遥测发送协程（Constants.TELEMETRY_ENABLED 时使用）与服务启动时刻，后者用于销毁时输出累计统计
+    private var telemetryJob: Job? = null
+    private val serviceStartNs = SystemClock.elapsedRealtimeNanos()
+
     companion object {
         // 尝试加载 Native 库
         init {
@@ -90,6 +99,71 @@ class GyroscopeService : Service(), SensorEventListener {
         @JvmStatic external fun nativeSetScreenOffsets(topOffset: Int, leftOffset: Int)
         @JvmStatic external fun nativeRequestSendUiEventPacket(identifier: String, x: Int, y: Int)
         @JvmStatic external fun nativeRequestSendUiLongPressPacket(identifier: String, x: Int, y: Int)
+        @JvmStatic external fun nativeConfigureThread(
+            role: Int, policy: Int, rtPriority: Int, niceValue: Int, cpuMask: Long,
+            prefaultStackKb: Int, lockMemory: Boolean, lockAllMemory: Boolean
+        )
+        @JvmStatic external fun nativeSetJitterMeasurement(enabled: Boolean)
+        @JvmStatic external fun nativeSetTouchFilter(
+            enabled: Boolean, maxTouchSizePermille: Int, minPressurePermille: Int,
+            edgeLeftPx: Int, edgeTopPx: Int, edgeRightPx: Int, edgeBottomPx: Int,
+            rejectPalmTool: Boolean, extendedContacts: Boolean
+        )
+        @JvmStatic external fun nativeSetTouchSmoothing(
+            enabled: Boolean, minCutoffHz: Float, beta: Float, derivativeCutoffHz: Float
+        )
+        @JvmStatic external fun nativeSetExclusiveGrab(enabled: Boolean)
+        @JvmStatic external fun nativeSetPenInput(enabled: Boolean, penDevicePath: String)
+        @JvmStatic external fun nativeSetHidInput(enabled: Boolean, devicePaths: Array<String>)
+        @JvmStatic external fun nativeSetPrivilegedHelperPath(path: String)
+        @JvmStatic external fun nativeGetThreadReport(): String
+        @JvmStatic external fun nativeStartInputCapture(path: String, maxEvents: Int): Boolean
+        @JvmStatic external fun nativeStopInputCapture(): Long
+        @JvmStatic external fun nativeStartInputReplay(path: String, originalTiming: Boolean): Boolean
+        @JvmStatic external fun nativeStopInputReplay()
+        @JvmStatic external fun nativeSetTraceLogFile(path: String?): Boolean
+        @JvmStatic external fun nativeCreateInputRing(capacity: Int): ByteBuffer?
+        @JvmStatic external fun nativeAwaitInputRing(consumedIndex: Long, timeoutMs: Int): Long
+        @JvmStatic external fun nativeCloseInputRing()
+        @JvmStatic external fun nativeReleaseInputRing()
+        @JvmStatic external fun nativeGetRuntimeStats(): ByteBuffer?
+
+        /**
+         * Native 运行时统计块（进程内唯一，悬浮窗可直接读取）；库未加载时为 null。
+         */
+        val runtimeStats: NativeRuntimeStats? by lazy {
+            try {
+                nativeGetRuntimeStats()?.let { NativeRuntimeStats(it) }?.takeIf { it.isValid }
+            } catch (e: UnsatisfiedLinkError) {
+                null
+            }
+        }
+
+        // nativeConfigureThread 的线程角色
+        private const val THREAD_ROLE_INPUT_READER = 0
+        private const val THREAD_ROLE_PACKET_SENDER = 1
+
+        // onNativeInputBatch 的记录类型，与 input_reader_jni_utils.h 一致
+        private const val INPUT_BATCH_RECORD_TOUCH_FRAME = 1
+        private const val INPUT_BATCH_RECORD_UI_TAP = 2
+        private const val INPUT_BATCH_RECORD_UI_PRESS_DOWN = 3
+        private const val INPUT_BATCH_RECORD_UI_LONG_PRESS_END = 4
+        private const val INPUT_BATCH_RECORD_UI_GESTURE = 5
+        private const val INPUT_BATCH_RECORD_PEN = 6
+        private const val INPUT_BATCH_RECORD_HID = 7
+        private const val INPUT_BATCH_TOUCH_FLAG_EXTENDED = 0x0001
+
+        // sendNativeTouchFrame 中每个触摸点占用的 Int 数：id, x, y, pressure, touchMajor
+        internal const val NATIVE_CONTACT_STRIDE = 5
+
+        // 笔采样 Payload 长度，与 packet_codec.h 的 V1_PEN_PAYLOAD_SIZE 一致
+        private const val PEN_PAYLOAD_SIZE = 28
+
+        // sendNativeHidFrame 中每个变化占用的 Int 数：type, code, value
+        internal const val NATIVE_HID_CHANGE_STRIDE = 3
+        // 外接设备 Payload 的帧头与每个变化的长度，与 packet_codec.h 一致
+        private const val HID_HEADER_SIZE = 12
+        private const val HID_CHANGE_SIZE = 8
     }
 
     // 用于完整的 JNI 生命周期管理
@@ -141,10 +215,16 @@ class GyroscopeService : Service(), SensorEventListener {
         try {
             nativeInitJNIService()
             log("Native JNI 服务端已初始化。")
+            nativeSetPrivilegedHelperPath(
+                File(applicationInfo.nativeLibraryDir, Constants.PRIVILEGED_HELPER_LIB_NAME).absolutePath
+            )
         } catch (e: UnsatisfiedLinkError) {
             log("nativeInitJNIService 错误: ${e.message}")
         }
 
+        // 配置 Native 输入/发送线程的调度、绑核与内存锁定
+        configureNativeThreads()
+
         // 同步屏幕尺寸与偏移给 Native 层
         val dm = resources.displayMetrics
         val screenWidth = dm.widthPixels
@@ -180,8 +260,22 @@ class GyroscopeService : Service(), SensorEventListener {
 
                 // 启动 Native 层输入读取线程
                 try {
+                    if (Constants.TRACE_LOG_FILE_ENABLED) {
+                        nativeSetTraceLogFile(File(filesDir, Constants.TRACE_LOG_FILE_NAME).absolutePath)
+                    }
                     nativeStartInputReaderService()
                     log("已调用 nativeStartInputReaderService()，请求 Native 层启动输入读取器。")
+                    if (Constants.INPUT_CAPTURE_ENABLED) {
+                        val capturePath = File(filesDir, Constants.INPUT_CAPTURE_FILE_NAME).absolutePath
+                        val ok = nativeStartInputCapture(capturePath, Constants.INPUT_CAPTURE_MAX_EVENTS)
+                        log("原始触摸事件捕获 ${if (ok) "已开始" else "启动失败"}: $capturePath")
+                    }
+                    if (Constants.INPUT_RING_ENABLED) {
+                        startInputRingConsumer()
+                    }
+                    if (Constants.TELEMETRY_ENABLED) {
+                        startTelemetry()
+                    }
                 } catch (e: UnsatisfiedLinkError) {
                     log("nativeStartInputReaderService 错误: ${e.message}")
                 }
@@ -197,6 +291,16 @@ class GyroscopeService : Service(), SensorEventListener {
 
         // 停止 Native 层的输入读取服务
         try {
+            log("Native 线程报告:\n${nativeGetThreadReport()}")
+            runtimeStats?.let { stats ->
+                val current = LongArray(NativeRuntimeStats.FIELD_COUNT).also { stats.snapshot(it) }
+                log("Native 运行时统计（累计）: ${stats.describe(LongArray(NativeRuntimeStats.FIELD_COUNT), current, SystemClock.elapsedRealtimeNanos() - serviceStartNs)}")
+            }
+            nativeStopInputReplay()
+            if (Constants.INPUT_CAPTURE_ENABLED) {
+                log("原始触摸事件捕获已停止，共 ${nativeStopInputCapture()} 个事件。")
+            }
+            stopInputRingConsumer()
             nativeStopInputReaderService()
             log("已请求 Native 层停止输入读取器。")
         } catch (e: UnsatisfiedLinkError) {
@@ -271,6 +375,196 @@ class GyroscopeService : Service(), SensorEventListener {
     }
     //endregion
 
+    // onNativeInputBatch 解析触摸帧时复用的触摸点数组，只在读取线程上使用
+    private val batchContacts = IntArray(Constants.MAX_TOUCH_POINTS * NATIVE_CONTACT_STRIDE)
+    // 解析外接设备帧时复用的变化数组（count 为 u8），只在读取线程上使用
+    private val batchHidChanges = IntArray(255 * NATIVE_HID_CHANGE_STRIDE)
+
+    /**
+     * 发送一帧 Native 触摸点，[contacts] 中依次为 [count] 组 (id, x, y, pressure, touchMajor)，
+     * [extended] 为 true 时连同压力与接触尺寸一起发送。
+     */
+    internal fun sendNativeTouchFrame(eventTimestamp: Long, contacts: IntArray, count: Int, extended: Boolean) {
+        // 负载：8字节时间戳 + 1字节触摸数量 + 每个触摸 (12字节，扩展时16字节)
+        val contactBytes = if (extended) 16 else 12
+        val payload = ByteBuffer.allocate(8 + 1 + count * contactBytes).order(ByteOrder.LITTLE_ENDIAN)
+        payload.putLong(eventTimestamp)
+        payload.put(count.toByte())
+        for (i in 0 until count) {
+            val base = i * NATIVE_CONTACT_STRIDE
+            payload.putInt(contacts[base])
+            payload.putInt(contacts[base + 1])
+            payload.putInt(contacts[base + 2])
+            if (extended) {
+                payload.putShort(contacts[base + 3].toShort())
+                payload.putShort(contacts[base + 4].toShort())
+            }
+        }
+        payload.flip()
+        if (extended) {
+            tcpCommunicator.sendPacket(Constants.PACKET_TYPE_TOUCH_EXTENDED, payload, "扩展触摸数据(来自Native)")
+        } else {
+            tcpCommunicator.sendPacket(Constants.PACKET_TYPE_TOUCH, payload, "触摸数据(来自Native)")
+        }
+    }
+
+    /**
+     * 发送一个 Native 笔采样 (0x0D)，字段含义见 [Constants.PACKET_TYPE_PEN]。
+     */
+    internal fun sendNativePenSample(
+        eventTimestampUs: Long, x: Int, y: Int, pressure: Int, distance: Int, tiltX: Int, tiltY: Int, flags: Int
+    ) {
+        val payload = ByteBuffer.allocate(PEN_PAYLOAD_SIZE).order(ByteOrder.LITTLE_ENDIAN)
+        payload.putLong(eventTimestampUs)
+        payload.putInt(x)
+        payload.putInt(y)
+        payload.putShort(pressure.toShort())
+        payload.putShort(distance.toShort())
+        payload.putShort(tiltX.toShort())
+        payload.putShort(tiltY.toShort())
+        payload.put(flags.toByte())
+        payload.put(ByteArray(3))
+        payload.flip()
+        tcpCommunicator.sendPacket(Constants.PACKET_TYPE_PEN, payload, "笔采样(来自Native)")
+    }
+
+    /**
+     * 发送一帧 Native 外接设备状态增量 (0x0E)，[changes] 中前 [count] 组 (type, code, value) 有效，
+     * 字段含义见 [Constants.PACKET_TYPE_HID]。
+     */
+    internal fun sendNativeHidFrame(
+        eventTimestampUs: Long, deviceId: Int, deviceClass: Int, flags: Int, changes: IntArray, count: Int
+    ) {
+        val payload = ByteBuffer.allocate(HID_HEADER_SIZE + count * HID_CHANGE_SIZE).order(ByteOrder.LITTLE_ENDIAN)
+        payload.putLong(eventTimestampUs)
+        payload.put(deviceId.toByte())
+        payload.put(deviceClass.toByte())
+        payload.put(flags.toByte())
+        payload.put(count.toByte())
+        for (i in 0 until count) {
+            val base = i * NATIVE_HID_CHANGE_STRIDE
+            payload.put(changes[base].toByte())
+            payload.put(0)
+            payload.putShort(changes[base + 1].toShort())
+            payload.putInt(changes[base + 2])
+        }
+        payload.flip()
+        tcpCommunicator.sendPacket(Constants.PACKET_TYPE_HID, payload, "外接设备(来自Native)")
+    }
+
+    /**
+     * Native 输入读取线程每处理完一次 read() 调用一次，[buffer] 中前 [length] 字节为本批次记录，
+     * 格式见 input_reader_jni_utils.h。buffer 由 Native 复用，只能在本调用内读取。
+     */
+    @Keep
+    fun onNativeInputBatch(buffer: ByteBuffer, length: Int) {
+        val batch = buffer.duplicate().order(ByteOrder.nativeOrder())
+        batch.position(0)
+        batch.limit(length)
+        try {
+            while (batch.remaining() >= 4) {
+                val kind = batch.get().toInt() and 0xFF
+                val count = batch.get().toInt() and 0xFF
+                val identifierLength = batch.getShort().toInt() and 0xFFFF
+                when (kind) {
+                    INPUT_BATCH_RECORD_TOUCH_FRAME -> {
+                        // 触摸帧中该字段为 flags
+                        val extended = identifierLength and INPUT_BATCH_TOUCH_FLAG_EXTENDED != 0
+                        val eventTimestamp = batch.getLong()
+                        val sendCount = count.coerceAtMost(Constants.MAX_TOUCH_POINTS)
+                        for (i in 0 until count) {
+                            val id = batch.getInt()
+                            val sx = batch.getInt()
+                            val sy = batch.getInt()
+                            var pressure = 0
+                            var touchMajor = 0
+                            if (extended) {
+                                pressure = batch.getShort().toInt() and 0xFFFF
+                                touchMajor = batch.getShort().toInt() and 0xFFFF
+                            }
+                            if (i < sendCount) {
+                                val base = i * NATIVE_CONTACT_STRIDE
+                                batchContacts[base] = id
+                                batchContacts[base + 1] = sx
+                                batchContacts[base + 2] = sy
+                                batchContacts[base + 3] = pressure
+                                batchContacts[base + 4] = touchMajor
+                            }
+                        }
+                        sendNativeTouchFrame(eventTimestamp, batchContacts, sendCount, extended)
+                    }
+                    INPUT_BATCH_RECORD_UI_TAP,
+                    INPUT_BATCH_RECORD_UI_PRESS_DOWN,
+                    INPUT_BATCH_RECORD_UI_LONG_PRESS_END -> {
+                        val x = batch.getInt()
+                        val y = batch.getInt()
+                        val downTimestampMs = batch.getLong()
+                        val nameBytes = ByteArray(identifierLength)
+                        batch.get(nameBytes)
+                        batch.position(batch.position() + ((4 - identifierLength % 4) % 4))
+                        val uiName = String(nameBytes, Charsets.UTF_8)
+                        when (kind) {
+                            INPUT_BATCH_RECORD_UI_TAP -> sendUiEventPacket(uiName, x, y)
+                            INPUT_BATCH_RECORD_UI_PRESS_DOWN -> sendUiPressDownPacket(uiName, x, y, downTimestampMs)
+                            else -> sendUiLongPressPacket(uiName, x, y)
+                        }
+                    }
+                    INPUT_BATCH_RECORD_UI_GESTURE -> {
+                        // count 字段位置存放的是手势类型
+                        val fingers = batch.get().toInt() and 0xFF
+                        val direction = batch.get().toInt() and 0xFF
+                        batch.getShort()
+                        val x = batch.getInt()
+                        val y = batch.getInt()
+                        val dx = batch.getInt()
+                        val dy = batch.getInt()
+                        val timestampMs = batch.getLong()
+                        val nameBytes = ByteArray(identifierLength)
+                        batch.get(nameBytes)
+                        batch.position(batch.position() + ((4 - identifierLength % 4) % 4))
+                        sendUiGesturePacket(
+                            String(nameBytes, Charsets.UTF_8), count, fingers, direction, x, y, dx, dy, timestampMs
+                        )
+                    }
+                    INPUT_BATCH_RECORD_PEN -> {
+                        // count 字段位置存放 flags，identifierLength 字段位置存放压力
+                        val x = batch.getInt()
+                        val y = batch.getInt()
+                        val distance = batch.getShort().toInt() and 0xFFFF
+                        val tiltX = batch.getShort().toInt()
+                        val tiltY = batch.getShort().toInt()
+                        batch.getShort()
+                        val timestampUs = batch.getLong()
+                        sendNativePenSample(timestampUs, x, y, identifierLength, distance, tiltX, tiltY, count)
+                    }
+                    INPUT_BATCH_RECORD_HID -> {
+                        // identifierLength 字段位置存放设备编号（低 8 位）与类别（高 8 位）
+                        val flags = batch.get().toInt() and 0xFF
+                        batch.get()
+                        batch.getShort()
+                        val timestampUs = batch.getLong()
+                        for (i in 0 until count) {
+                            val base = i * NATIVE_HID_CHANGE_STRIDE
+                            batchHidChanges[base] = batch.get().toInt() and 0xFF
+                            batch.get()
+                            batchHidChanges[base + 1] = batch.getShort().toInt() and 0xFFFF
+                            batchHidChanges[base + 2] = batch.getInt()
+                        }
+                        sendNativeHidFrame(
+                            timestampUs, identifierLength and 0xFF, identifierLength shr 8, flags, batchHidChanges, count
+                        )
+                    }
+                    else -> {
+                        log("Native 批次中出现未知记录类型 $kind，丢弃剩余 ${batch.remaining()} 字节")
+                        return
+                    }
+                }
+            }
+        } catch (e: Exception) {
+            log("处理Native批次数据时出错: ${e.message}")
+        }
+    }
+
     //region --------- 供 Native 层调用的 UI 交互相关函数 ---------
     /**
      * 发送 UI 点击事件包 (0x03)。
@@ -306,6 +600,39 @@ class GyroscopeService : Service(), SensorEventListener {
         tcpCommunicator.sendPacket(Constants.PACKET_TYPE_UI_LONG_PRESS, buffer, "UI长按($uiName@$clickX,$clickY)")
     }
 
+    /**
+     * 发送 Native 识别出的区域手势包 (0x09)。
+     * @param gestureKind 1 双击 / 2 滑出 / 3 和弦 / 4 拖动开始 / 5 拖动中 / 6 拖动结束
+     * @param direction 滑出方向：1 左 / 2 右 / 3 上 / 4 下
+     * @param dx 相对按下位置的 X 位移
+     * @param dy 相对按下位置的 Y 位移
+     */
+    fun sendUiGesturePacket(
+        uiName: String, gestureKind: Int, fingers: Int, direction: Int,
+        x: Int, y: Int, dx: Int, dy: Int, timestampMs: Long
+    ) {
+        val nameBytes = uiName.toByteArray(Charsets.UTF_8)
+        // Payload: Kind(1) + Fingers(1) + Direction(1) + 保留(1) + X(4) + Y(4) + DX(4) + DY(4) + Timestamp(8) + Identifier(N)
+        val buffer = ByteBuffer.allocate(4 + 16 + 8 + nameBytes.size).order(ByteOrder.LITTLE_ENDIAN).apply {
+            put(gestureKind.toByte())
+            put(fingers.toByte())
+            put(direction.toByte())
+            put(0.toByte())
+            putInt(x)
+            putInt(y)
+            putInt(dx)
+            putInt(dy)
+            putLong(timestampMs)
+            put(nameBytes)
+            flip()
+        }
+        tcpCommunicator.sendPacket(
+            Constants.PACKET_TYPE_UI_GESTURE,
+            buffer,
+            "UI手势($uiName,kind=$gestureKind,fingers=$fingers,dir=$direction)"
+        )
+    }
+
     /**
      * 发送 UI 按下事件包 (0x08)。由 Native 层调用。
      * @param uiName UI 元素名称
@@ -453,6 +780,126 @@ class GyroscopeService : Service(), SensorEventListener {
             .launchIn(serviceScope)
     }
 
+    /**
+     * 把之前捕获的原始触摸事件经 Native 输入引擎回放（代替真实触摸屏，结束后自动恢复）。
+     *
+     * @param originalTiming true 按捕获时的节奏回放，false 尽快回放
+     */
+    fun replayInputCapture(originalTiming: Boolean = true): Boolean {
+        val capture = File(filesDir, Constants.INPUT_CAPTURE_FILE_NAME)
+        if (!capture.exists()) {
+            log("回放失败: 捕获文件不存在 ${capture.absolutePath}")
+            return false
+        }
+        if (Constants.INPUT_CAPTURE_ENABLED) {
+            // 回放写入同一文件会覆盖它，先停止捕获
+            nativeStopInputCapture()
+        }
+        val ok = nativeStartInputReplay(capture.absolutePath, originalTiming)
+        log("触摸事件回放 ${if (ok) "已开始" else "启动失败"}: ${capture.absolutePath}")
+        return ok
+    }
+
+    /**
+     * 每隔 TELEMETRY_INTERVAL_MS 读取一次统计块并发给接收端；只读 ByteBuffer，不经过 JNI。
+     */
+    private fun startTelemetry() {
+        val stats = runtimeStats ?: run {
+            log("Native 运行时统计块不可用，不发送遥测")
+            return
+        }
+        telemetryJob?.cancel()
+        telemetryJob = serviceScope.launch {
+            while (isActive) {
+                delay(Constants.TELEMETRY_INTERVAL_MS)
+                if (tcpCommunicator.connectionStatusFlow.value == ConnectionStatus.CONNECTED) {
+                    tcpCommunicator.sendPacket(Constants.PACKET_TYPE_TELEMETRY, stats.telemetryPayload(), "运行时统计")
+                }
+            }
+        }
+    }
+
+    /**
+     * 创建共享内存事件环并启动消费线程，此后 Native 读取线程不再回调 onNativeInputBatch。
+     */
+    private fun startInputRingConsumer() {
+        val ring = nativeCreateInputRing(Constants.INPUT_RING_CAPACITY)
+        if (ring == null) {
+            log("事件环创建失败，继续使用 JNI 批量回调")
+            return
+        }
+        inputRingConsumer = InputEventRingConsumer(this, ring).also { it.start() }
+        log("已切换到共享内存事件环，容量 ${Constants.INPUT_RING_CAPACITY}")
+    }
+
+    /**
+     * 关闭事件环（Native 输出切回 JNI 批量回调），等待消费线程读空退出后释放环内存。
+     */
+    private fun stopInputRingConsumer() {
+        val consumer = inputRingConsumer ?: return
+        inputRingConsumer = null
+        nativeCloseInputRing()
+        if (!consumer.join(1000)) {
+            // 消费线程仍可能在读 ByteBuffer，保留环内存（进程内仅泄漏一次）
+            log("事件环消费线程未按时退出，不释放环内存")
+            return
+        }
+        log("事件环已关闭: 溢出丢弃 ${consumer.overflowCount} 条, 唤醒 ${consumer.wakeupCount} 次")
+        nativeReleaseInputRing()
+    }
+
+    /**
+     * 按 Constants 中的配置设置 Native 输入读取线程与发送线程，
+     * 线程会在下一次循环时自行应用，实际生效情况见 nativeGetThreadReport()。
+     */
+    private fun configureNativeThreads() {
+        try {
+            nativeConfigureThread(
+                THREAD_ROLE_INPUT_READER,
+                Constants.NATIVE_THREAD_SCHED_POLICY,
+                Constants.NATIVE_THREAD_RT_PRIORITY,
+                Constants.NATIVE_THREAD_NICE,
+                Constants.INPUT_THREAD_CPU_MASK,
+                Constants.NATIVE_THREAD_PREFAULT_STACK_KB,
+                true,
+                false
+            )
+            nativeConfigureThread(
+                THREAD_ROLE_PACKET_SENDER,
+                Constants.NATIVE_THREAD_SCHED_POLICY,
+                Constants.NATIVE_THREAD_RT_PRIORITY,
+                Constants.NATIVE_THREAD_NICE,
+                Constants.SENDER_THREAD_CPU_MASK,
+                Constants.NATIVE_THREAD_PREFAULT_STACK_KB,
+                true,
+                false
+            )
+            nativeSetJitterMeasurement(Constants.INPUT_JITTER_MEASUREMENT)
+            nativeSetTouchFilter(
+                Constants.TOUCH_FILTER_ENABLED,
+                Constants.TOUCH_FILTER_MAX_SIZE_PERMILLE,
+                Constants.TOUCH_FILTER_MIN_PRESSURE_PERMILLE,
+                Constants.TOUCH_FILTER_EDGE_LEFT_PX,
+                Constants.TOUCH_FILTER_EDGE_TOP_PX,
+                Constants.TOUCH_FILTER_EDGE_RIGHT_PX,
+                Constants.TOUCH_FILTER_EDGE_BOTTOM_PX,
+                Constants.TOUCH_FILTER_REJECT_PALM_TOOL,
+                Constants.TOUCH_EXTENDED_CONTACTS
+            )
+            nativeSetTouchSmoothing(
+                Constants.TOUCH_SMOOTHING_ENABLED,
+                Constants.TOUCH_SMOOTHING_MIN_CUTOFF_HZ,
+                Constants.TOUCH_SMOOTHING_BETA,
+                Constants.TOUCH_SMOOTHING_DERIVATIVE_CUTOFF_HZ
+            )
+            nativeSetExclusiveGrab(Constants.INPUT_EXCLUSIVE_GRAB)
+            nativeSetPenInput(Constants.PEN_INPUT_ENABLED, Constants.PEN_DEVICE_PATH)
+            nativeSetHidInput(Constants.HID_INPUT_ENABLED, Constants.HID_DEVICE_PATHS)
+        } catch (e: UnsatisfiedLinkError) {
+            log("nativeConfigureThread 错误: ${e.message}")
+        }
+    }
+
     /**
      * 注册陀螺仪监听器，若注册失败则停止自身服务。
      */
@@ -0,0 +1,218 @@
+package com.luoxiaohei.lowlatencyinput.service
+
+import android.util.Log
+import com.luoxiaohei.lowlatencyinput.Constants
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
+
+/**
+ * 共享内存事件环的消费线程。
+ *
+ * Native 读取线程把触摸帧、笔采样、外接设备状态与区域事件写入 [ring]（布局见 common/event_ring.h），
+ * 只在环由空变非空时通过 eventfd 唤醒本线程；本线程一次取走所有已发布记录，
+ * 读完后经 [GyroscopeService.nativeAwaitInputRing] 发布读位置并在环空时阻塞。
+ * 整个过程中读取线程不会发起任何到 Java 的调用。
+ */
+class InputEventRingConsumer(
+    private val service: GyroscopeService,
+    ring: ByteBuffer
+) {
+    private val ring: ByteBuffer = ring.duplicate().order(ByteOrder.nativeOrder())
+    private val headerSize = this.ring.getInt(HEADER_SIZE_OFFSET)
+    private val recordSize = this.ring.getInt(RECORD_SIZE_OFFSET)
+    private val mask = this.ring.getInt(CAPACITY_OFFSET) - 1
+
+    // 当前帧的触摸点 (id, x, y, pressure, touchMajor)，遇到 FRAME_END 时一次发出
+    private val frameContacts = IntArray(Constants.MAX_TOUCH_POINTS * GyroscopeService.NATIVE_CONTACT_STRIDE)
+    private var frameCount = 0
+    // 当前外接设备帧的变化 (type, code, value)，遇到 FRAME_END 时一次发出
+    private val hidChanges = IntArray(HID_MAX_CHANGES * GyroscopeService.NATIVE_HID_CHANGE_STRIDE)
+    private var hidCount = 0
+    private val nameBytes = ByteArray(NAME_BYTES)
+
+    @Volatile
+    private var thread: Thread? = null
+
+    /**
+     * 因环满被 Native 层丢弃的记录数。
+     */
+    val overflowCount: Long
+        get() = ring.getLong(OVERFLOW_COUNT_OFFSET)
+
+    /**
+     * Native 层由空变非空唤醒本线程的次数。
+     */
+    val wakeupCount: Long
+        get() = ring.getLong(WAKEUP_COUNT_OFFSET)
+
+    fun start() {
+        if (ring.getInt(MAGIC_OFFSET) != RING_MAGIC || recordSize != RECORD_BYTES) {
+            Log.e(TAG, "事件环布局不匹配，未启动消费线程")
+            return
+        }
+        thread = Thread(::drainLoop, "InputRingConsumer").apply {
+            priority = Thread.MAX_PRIORITY
+            start()
+        }
+    }
+
+    /**
+     * 等待消费线程读空并退出。调用前应先 nativeCloseInputRing()。
+     * @return false 表示超时仍未退出，此时不能释放环内存
+     */
+    fun join(timeoutMs: Long): Boolean {
+        val t = thread ?: return true
+        t.join(timeoutMs)
+        return !t.isAlive
+    }
+
+    private fun drainLoop() {
+        var readIndex = 0L
+        while (true) {
+            val writeIndex = GyroscopeService.nativeAwaitInputRing(readIndex, AWAIT_TIMEOUT_MS)
+            if (writeIndex < 0) {
+                break
+            }
+            while (readIndex < writeIndex) {
+                dispatch(headerSize + (readIndex and mask.toLong()).toInt() * recordSize)
+                readIndex++
+            }
+        }
+        Log.i(TAG, "消费线程退出: 已读 $readIndex 条, 溢出丢弃 $overflowCount 条, 唤醒 $wakeupCount 次")
+    }
+
+    private fun dispatch(offset: Int) {
+        val kind = ring.get(offset).toInt() and 0xFF
+        val flags = ring.get(offset + 1).toInt() and 0xFF
+        val x = ring.getInt(offset + 8)
+        val y = ring.getInt(offset + 12)
+        val timestampMs = ring.getLong(offset + 16)
+        try {
+            when (kind) {
+                RECORD_TOUCH_CONTACT -> {
+                    val extended = flags and FLAG_EXTENDED != 0
+                    if (frameCount < Constants.MAX_TOUCH_POINTS) {
+                        val base = frameCount * GyroscopeService.NATIVE_CONTACT_STRIDE
+                        frameContacts[base] = ring.getInt(offset + 4)
+                        frameContacts[base + 1] = x
+                        frameContacts[base + 2] = y
+                        frameContacts[base + 3] = if (extended) ring.getShort(offset + TOUCH_PRESSURE_OFFSET).toInt() and 0xFFFF else 0
+                        frameContacts[base + 4] = if (extended) ring.getShort(offset + TOUCH_MAJOR_OFFSET).toInt() and 0xFFFF else 0
+                        frameCount++
+                    }
+                    if (flags and FLAG_FRAME_END != 0) {
+                        service.sendNativeTouchFrame(timestampMs, frameContacts, frameCount, extended)
+                        frameCount = 0
+                    }
+                }
+                RECORD_UI_TAP, RECORD_UI_PRESS_DOWN, RECORD_UI_LONG_PRESS_END -> {
+                    val nameLength = (ring.getShort(offset + 2).toInt() and 0xFFFF).coerceAtMost(NAME_BYTES)
+                    for (i in 0 until nameLength) {
+                        nameBytes[i] = ring.get(offset + NAME_OFFSET + i)
+                    }
+                    val uiName = String(nameBytes, 0, nameLength, Charsets.UTF_8)
+                    when (kind) {
+                        RECORD_UI_TAP -> service.sendUiEventPacket(uiName, x, y)
+                        RECORD_UI_PRESS_DOWN -> service.sendUiPressDownPacket(uiName, x, y, timestampMs)
+                        else -> service.sendUiLongPressPacket(uiName, x, y)
+                    }
+                }
+                RECORD_UI_GESTURE -> {
+                    val nameLength = (ring.getShort(offset + 2).toInt() and 0xFFFF).coerceAtMost(GESTURE_NAME_BYTES)
+                    for (i in 0 until nameLength) {
+                        nameBytes[i] = ring.get(offset + NAME_OFFSET + i)
+                    }
+                    val packed = ring.getInt(offset + 4)
+                    service.sendUiGesturePacket(
+                        String(nameBytes, 0, nameLength, Charsets.UTF_8),
+                        flags,
+                        packed and 0xFF,
+                        (packed shr 8) and 0xFF,
+                        x, y,
+                        ring.getInt(offset + GESTURE_DX_OFFSET),
+                        ring.getInt(offset + GESTURE_DX_OFFSET + 4),
+                        timestampMs
+                    )
+                }
+                RECORD_PEN -> service.sendNativePenSample(
+                    ring.getLong(offset + PEN_TIMESTAMP_US_OFFSET),
+                    x, y,
+                    ring.getShort(offset + PEN_PRESSURE_OFFSET).toInt() and 0xFFFF,
+                    ring.getShort(offset + PEN_DISTANCE_OFFSET).toInt() and 0xFFFF,
+                    ring.getShort(offset + PEN_TILT_X_OFFSET).toInt(),
+                    ring.getShort(offset + PEN_TILT_X_OFFSET + 2).toInt(),
+                    flags
+                )
+                RECORD_HID -> {
+                    val changes = ring.getShort(offset + 2).toInt() and 0xFFFF
+                    for (i in 0 until changes) {
+                        if (hidCount >= HID_MAX_CHANGES) break
+                        val change = offset + HID_CHANGES_OFFSET + i * HID_CHANGE_BYTES
+                        val base = hidCount * GyroscopeService.NATIVE_HID_CHANGE_STRIDE
+                        hidChanges[base] = ring.get(change).toInt() and 0xFF
+                        hidChanges[base + 1] = ring.getShort(change + 2).toInt() and 0xFFFF
+                        hidChanges[base + 2] = ring.getInt(change + 4)
+                        hidCount++
+                    }
+                    if (flags and FLAG_FRAME_END != 0) {
+                        val packed = ring.getInt(offset + 4)
+                        service.sendNativeHidFrame(
+                            ring.getLong(offset + HID_TIMESTAMP_US_OFFSET),
+                            packed and 0xFF,
+                            (packed shr 8) and 0xFF,
+                            (packed shr 16) and 0xFF,
+                            hidChanges,
+                            hidCount
+                        )
+                        hidCount = 0
+                    }
+                }
+                else -> Log.w(TAG, "事件环中出现未知记录类型 $kind")
+            }
+        } catch (e: Exception) {
+            Log.e(TAG, "处理事件环记录时出错: ${e.message}")
+        }
+    }
+
+    private companion object {
+        const val TAG = "InputEventRingConsumer"
+
+        // 与 common/event_ring.h 一致
+        const val RING_MAGIC = 0x474E5252
+        const val MAGIC_OFFSET = 0
+        const val HEADER_SIZE_OFFSET = 8
+        const val RECORD_SIZE_OFFSET = 12
+        const val CAPACITY_OFFSET = 16
+        const val OVERFLOW_COUNT_OFFSET = 72
+        const val WAKEUP_COUNT_OFFSET = 80
+        const val RECORD_BYTES = 64
+        const val NAME_OFFSET = 24
+        const val NAME_BYTES = 40
+        const val GESTURE_NAME_BYTES = 32
+        const val GESTURE_DX_OFFSET = 56
+        const val TOUCH_PRESSURE_OFFSET = 24
+        const val TOUCH_MAJOR_OFFSET = 26
+        const val PEN_PRESSURE_OFFSET = 24
+        const val PEN_DISTANCE_OFFSET = 26
+        const val PEN_TILT_X_OFFSET = 28
+        const val PEN_TIMESTAMP_US_OFFSET = 32
+        const val HID_TIMESTAMP_US_OFFSET = 24
+        const val HID_CHANGES_OFFSET = 32
+        const val HID_CHANGE_BYTES = 8
+        // 与 hid_decoder.h 的 HID_FRAME_MAX_CHANGES 一致
+        const val HID_MAX_CHANGES = 64
+
+        const val RECORD_TOUCH_CONTACT = 1
+        const val RECORD_UI_TAP = 2
+        const val RECORD_UI_PRESS_DOWN = 3
+        const val RECORD_UI_LONG_PRESS_END = 4
+        const val RECORD_UI_GESTURE = 5
+        const val RECORD_PEN = 6
+        const val RECORD_HID = 7
+        const val FLAG_FRAME_END = 0x01
+        const val FLAG_EXTENDED = 0x02
+
+        // 超时只用于兜底，正常情况下由 eventfd 唤醒
+        const val AWAIT_TIMEOUT_MS = 500
+    }
+}
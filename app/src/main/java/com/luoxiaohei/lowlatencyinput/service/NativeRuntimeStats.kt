@@ -0,0 +1,96 @@
+package com.luoxiaohei.lowlatencyinput.service
+
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
+
+/**
+ * Native 运行时统计块的只读视图（布局见 common/runtime_stats.h）。
+ *
+ * [stats] 直接包装 Native 的静态统计块，读取字段不经过 JNI；Native 各线程以 relaxed 原子更新，
+ * 每个字段单独读取都是完整的 64 位值，但字段之间不保证属于同一时刻。
+ * 除 [FIELD_ACTIVE_SLOTS] 与 [FIELD_QUEUE_DEPTH] 外均为累计值，速率由两次 [snapshot] 求差得到。
+ */
+class NativeRuntimeStats(stats: ByteBuffer) {
+    private val stats: ByteBuffer = stats.duplicate().order(ByteOrder.nativeOrder())
+
+    val isValid: Boolean
+        get() = stats.capacity() == FIELD_COUNT * FIELD_BYTES
+
+    operator fun get(field: Int): Long = stats.getLong(field * FIELD_BYTES)
+
+    /**
+     * 把所有字段复制到 [out]（长度至少 [FIELD_COUNT]）。
+     */
+    fun snapshot(out: LongArray) {
+        for (i in 0 until FIELD_COUNT) {
+            out[i] = stats.getLong(i * FIELD_BYTES)
+        }
+    }
+
+    /**
+     * 构造 TELEMETRY (0x0F) Payload，格式见 [com.luoxiaohei.lowlatencyinput.Constants.PACKET_TYPE_TELEMETRY]。
+     */
+    fun telemetryPayload(): ByteBuffer {
+        val payload = ByteBuffer.allocate(TELEMETRY_HEADER_SIZE + FIELD_COUNT * FIELD_BYTES).order(ByteOrder.LITTLE_ENDIAN)
+        payload.putShort(FIELD_COUNT.toShort())
+        payload.put(ByteArray(TELEMETRY_HEADER_SIZE - 2))
+        for (i in 0 until FIELD_COUNT) {
+            payload.putLong(stats.getLong(i * FIELD_BYTES))
+        }
+        payload.flip()
+        return payload
+    }
+
+    /**
+     * 两次快照之间的速率与平均耗时，供日志与悬浮窗显示。
+     */
+    fun describe(previous: LongArray, current: LongArray, elapsedNs: Long): String {
+        val seconds = elapsedNs.coerceAtLeast(1) / 1e9
+        fun rate(field: Int) = (current[field] - previous[field]) / seconds
+        fun perCall(sumField: Int, countField: Int): Long {
+            val calls = current[countField] - previous[countField]
+            return if (calls > 0) (current[sumField] - previous[sumField]) / calls / 1000 else 0
+        }
+        fun cpuPercent(field: Int) = (current[field] - previous[field]) / elapsedNs.coerceAtLeast(1).toDouble() * 100
+        val sentPackets = current[FIELD_PACKETS_SENT] - previous[FIELD_PACKETS_SENT]
+        val sendTimeNs = current[FIELD_SEND_TIME_NS] - previous[FIELD_SEND_TIME_NS]
+        return "events=%.0f/s frames=%.0f/s slots=%d hits=%d sink=%dus/batch synDropped=%d reader=%.1f%%cpu | ".format(
+            rate(FIELD_INPUT_EVENTS), rate(FIELD_TOUCH_FRAMES), current[FIELD_ACTIVE_SLOTS],
+            current[FIELD_REGION_HITS] - previous[FIELD_REGION_HITS],
+            perCall(FIELD_SINK_TIME_NS, FIELD_SINK_FLUSHES),
+            current[FIELD_SYNC_DROPS] - previous[FIELD_SYNC_DROPS], cpuPercent(FIELD_READER_CPU_NS)
+        ) + "packets=%.0f/s queue=%d dropped=%d superseded=%d errors=%d send=%dns/packet sender=%.1f%%cpu".format(
+            rate(FIELD_PACKETS_SENT), current[FIELD_QUEUE_DEPTH],
+            current[FIELD_PACKETS_DROPPED] - previous[FIELD_PACKETS_DROPPED],
+            current[FIELD_PACKETS_SUPERSEDED] - previous[FIELD_PACKETS_SUPERSEDED],
+            current[FIELD_SEND_ERRORS] - previous[FIELD_SEND_ERRORS],
+            if (sentPackets > 0) sendTimeNs / sentPackets else 0, cpuPercent(FIELD_SENDER_CPU_NS)
+        )
+    }
+
+    companion object {
+        // 字段下标，与 runtime_stats.h 的 RuntimeStatsField 一致
+        // 读取线程
+        const val FIELD_INPUT_EVENTS = 0
+        const val FIELD_TOUCH_FRAMES = 1
+        const val FIELD_ACTIVE_SLOTS = 2
+        const val FIELD_REGION_HITS = 3
+        const val FIELD_SINK_FLUSHES = 4
+        const val FIELD_SINK_TIME_NS = 5
+        const val FIELD_SYNC_DROPS = 6
+        const val FIELD_READER_CPU_NS = 7
+        // 发送线程（所有订阅者之和）
+        const val FIELD_PACKETS_SENT = 8
+        const val FIELD_BYTES_SENT = 9
+        const val FIELD_QUEUE_DEPTH = 10
+        const val FIELD_PACKETS_DROPPED = 11
+        const val FIELD_PACKETS_SUPERSEDED = 12
+        const val FIELD_SEND_ERRORS = 13
+        const val FIELD_SEND_TIME_NS = 14
+        const val FIELD_SENDER_CPU_NS = 15
+        const val FIELD_COUNT = 16
+
+        private const val FIELD_BYTES = 8
+        private const val TELEMETRY_HEADER_SIZE = 8
+    }
+}
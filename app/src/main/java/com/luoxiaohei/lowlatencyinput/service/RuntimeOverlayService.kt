@@ -23,6 +23,7 @@ import com.luoxiaohei.lowlatencyinput.R
 import com.luoxiaohei.lowlatencyinput.model.AvailableElements
 import com.luoxiaohei.lowlatencyinput.model.OverlayElement
 import com.luoxiaohei.lowlatencyinput.model.OverlayLayout
+import com.luoxiaohei.lowlatencyinput.model.RegionSmoothing
 import com.luoxiaohei.lowlatencyinput.utils.LayoutManager
 import com.luoxiaohei.lowlatencyinput.Constants
 import android.content.res.Resources
@@ -46,7 +47,17 @@ class RuntimeOverlayService : Service() {
     private val activeViews = mutableMapOf<String, View>()
 
     // 新增：用于存储可点击区域信息的数据类
-    data class ClickableRegionInfo(val identifier: String, val leftPx: Int, val topPx: Int, val widthPx: Int, val heightPx: Int)
+    data class ClickableRegionInfo(
+        val identifier: String, val leftPx: Int, val topPx: Int, val widthPx: Int, val heightPx: Int,
+        val gestures: List<String> = emptyList(),
+        val policies: List<String> = emptyList(),
+        val smoothing: RegionSmoothing? = null,
+        val shape: String = AvailableElements.SHAPE_RECT,
+        val cornerRadiusPx: Int = 0,
+        val paddingPx: Int = 0,
+        val priority: Int = 0,
+        val points: List<Int> = emptyList() // [x0, y0, x1, y1, ...]，相对于 leftPx / topPx
+    )
     // 新增：用于收集所有区域信息的列表
     private val clickableRegions = mutableListOf<ClickableRegionInfo>()
 
@@ -164,7 +175,7 @@ class RuntimeOverlayService : Service() {
                 val view: View? = when {
                     elementType == AvailableElements.TYPE_CLOSE_BUTTON -> {
                         // 对于可点击类型（包括关闭按钮），记录其区域信息
-                        clickableRegions.add(ClickableRegionInfo(elementType, leftPx, topPx, widthPx, heightPx))
+                        clickableRegions.add(clickableRegionInfo(element, leftPx, topPx, widthPx, heightPx))
                         val linearLayout = LinearLayout(this).apply {
                             orientation = LinearLayout.HORIZONTAL
                             gravity = Gravity.CENTER_VERTICAL
@@ -212,7 +223,7 @@ class RuntimeOverlayService : Service() {
                         linearLayout
                     }
                     elementType == "button" -> {
-                        clickableRegions.add(ClickableRegionInfo(elementType, leftPx, topPx, widthPx, heightPx))
+                        clickableRegions.add(clickableRegionInfo(element, leftPx, topPx, widthPx, heightPx))
                         val button = Button(this).apply {
                             text = element.label ?: element.id
                             layoutParams = createFrameLayoutLayoutParams(element)
@@ -225,7 +236,7 @@ class RuntimeOverlayService : Service() {
                     }
                     // 只要iconResId不为null就走图标分支
                     AvailableElements.findByType(elementType)?.iconResId != null -> {
-                        clickableRegions.add(ClickableRegionInfo(elementType, leftPx, topPx, widthPx, heightPx))
+                        clickableRegions.add(clickableRegionInfo(element, leftPx, topPx, widthPx, heightPx))
                         val elementInfo = AvailableElements.findByType(element.type)
                         val imageView = ImageView(this).apply {
                             setImageResource(elementInfo!!.iconResId!!)
@@ -279,6 +290,21 @@ class RuntimeOverlayService : Service() {
         // --- 新增结束 ---
     }
 
+    /**
+     * 元素的 Native 区域信息：形状参数与多边形顶点按屏幕密度换算为像素
+     */
+    private fun clickableRegionInfo(element: OverlayElement, leftPx: Int, topPx: Int, widthPx: Int, heightPx: Int): ClickableRegionInfo {
+        val density = resources.displayMetrics.density
+        return ClickableRegionInfo(
+            element.type, leftPx, topPx, widthPx, heightPx, element.gestures, element.policies, element.smoothing,
+            shape = element.shape ?: AvailableElements.findByType(element.type)?.defaultShape ?: AvailableElements.SHAPE_RECT,
+            cornerRadiusPx = (element.cornerRadius * density).toInt(),
+            paddingPx = (element.hitPadding * density).toInt(),
+            priority = element.priority,
+            points = element.points.map { (it * density).toInt() }
+        )
+    }
+
     /**
      * 为给定的 OverlayElement 生成在 FrameLayout 中使用的布局参数，
      * 包括宽、高、左边距和上边距